@@ -37,6 +37,8 @@ export enum TalexEvents {
   DIRECTORY_ADDED = 'file-system/directory-added',
   DIRECTORY_UNLINKED = 'file-system/directory-unlinked',
   FILE_WATCH_ROOT_RECOVERED = 'file-system/watch-root-recovered',
+  // The watcher dropped events under `filePath`; the subtree needs a rescan.
+  FILE_WATCH_OVERFLOWED = 'file-system/watch-overflowed',
 
   // System permission signal — emitted when permissions are (re)checked so the
   // file-system watcher can reconcile roots that just became accessible.
@@ -431,6 +433,15 @@ export class FileWatchRootRecoveredEvent implements ITouchEvent<TalexEvents> {
   }
 }
 
+export class FileWatchOverflowedEvent implements ITouchEvent<TalexEvents> {
+  name: TalexEvents = TalexEvents.FILE_WATCH_OVERFLOWED
+  filePath: string
+
+  constructor(filePath: string) {
+    this.filePath = filePath
+  }
+}
+
 export class PermissionsRefreshedEvent implements ITouchEvent<TalexEvents> {
   name: TalexEvents = TalexEvents.PERMISSIONS_REFRESHED
 }
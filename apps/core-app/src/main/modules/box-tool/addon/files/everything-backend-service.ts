@@ -10,6 +10,7 @@ import {
   parseEverythingVersion,
   type EverythingSearchResult
 } from './everything-parser'
+import { recordNativeTraceSpans, type NativeTraceSpan } from '../../../../utils/perf-context'
 
 const execFileAsync = promisify(execFile)
 
@@ -37,9 +38,24 @@ export function sanitizeEverythingCliQuery(query: string): string {
 export interface EverythingSdkAddon {
   search?: (query: string, options?: { maxResults?: number }) => unknown
   query?: (query: string, options?: { maxResults?: number }) => unknown
+  searchAsync?: (
+    query: string,
+    options?: { maxResults?: number; channel?: string },
+    signal?: AbortSignal
+  ) => Promise<unknown>
   getVersion?: () => string
+  /** Drops the addon's cached results; absent on builds without the result cache. */
+  invalidateCache?: () => void
+  /** Spans since the last call while native tracing is on (configureNativeMetrics). */
+  drainNativeTraceSpans?: () => { spans: NativeTraceSpan[]; dropped: number }
 }
 
+/**
+ * Latest-wins group for provider queries on the addon's search thread: a new keystroke
+ * drops the previous query instead of waiting behind it.
+ */
+const SDK_SEARCH_CHANNEL = 'everything-provider'
+
 export interface EverythingBackendRuntime {
   execFileAsync?: typeof execFileAsync
   access?: typeof fs.access
@@ -149,14 +165,30 @@ export class EverythingBackendService {
     maxResults: number,
     signal?: AbortSignal
   ): Promise<EverythingSearchResult[]> {
-    const search = addon.search ?? addon.query
-    if (typeof search !== 'function')
-      throw new TypeError('Everything SDK search method is not available')
-    const searchPromise = Promise.resolve(search.call(addon, query, { maxResults }))
-    const rawResults = signal
-      ? await Promise.race([searchPromise, createAbortPromise(signal)])
-      : await searchPromise
-    return parseEverythingSdkOutput(rawResults)
+    try {
+      // Prefer the off-main-thread path; older addon builds only have the blocking call.
+      if (typeof addon.searchAsync === 'function') {
+        const rawResults = await addon.searchAsync(
+          query,
+          { maxResults, channel: SDK_SEARCH_CHANNEL },
+          signal
+        )
+        return parseEverythingSdkOutput(rawResults)
+      }
+
+      const search = addon.search ?? addon.query
+      if (typeof search !== 'function')
+        throw new TypeError('Everything SDK search method is not available')
+      const searchPromise = Promise.resolve(search.call(addon, query, { maxResults }))
+      const rawResults = signal
+        ? await Promise.race([searchPromise, createAbortPromise(signal)])
+        : await searchPromise
+      return parseEverythingSdkOutput(rawResults)
+    } finally {
+      if (typeof addon.drainNativeTraceSpans === 'function') {
+        recordNativeTraceSpans('everything', addon.drainNativeTraceSpans())
+      }
+    }
   }
 
   async discoverCli(options: {
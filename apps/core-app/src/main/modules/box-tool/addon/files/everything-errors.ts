@@ -35,7 +35,13 @@ export function isAbortError(error: unknown): boolean {
   if (!isRecord(error)) {
     return false
   }
-  return error.name === 'AbortError' || error.code === 'ABORT_ERR' || error.code === 'ABORTED'
+  return (
+    error.name === 'AbortError' ||
+    error.code === 'ABORT_ERR' ||
+    error.code === 'ABORTED' ||
+    // Native searchAsync: a newer query on the same channel replaced this one.
+    error.code === 'ERR_EVERYTHING_SUPERSEDED'
+  )
 }
 
 export function isSearchFallbackError(error: unknown): error is EverythingSearchFallbackError {
@@ -141,6 +141,7 @@ import {
   everythingTestEvent,
   everythingToggleEvent
 } from '../../../../../shared/events/everything'
+import { FileAddedEvent, TalexEvents, touchEventBus } from '../../../../core/eventbus/touch-event'
 
 const initialManagedSdkDllPath = process.env.TALEX_EVERYTHING_DLL_PATH
 
@@ -404,6 +405,26 @@ describe('everything-provider fallback chain', () => {
     })
   })
 
+  it('drops the SDK result cache when the file-system watcher sees a change', async () => {
+    await withPlatform('win32', async () => {
+      const provider = everythingProvider as unknown as MutableEverythingProvider
+      vi.spyOn(provider, 'refreshBackendState').mockResolvedValue(false)
+      appTaskWaitForIdle.mockImplementation(() => new Promise(() => {}))
+      const invalidateCache = vi.fn()
+      provider.sdkAddon = { searchAsync: vi.fn(), invalidateCache }
+
+      await provider.onLoad({ touchApp: { channel: {} } })
+      // A reload subscribes again; the bus rejects a handler registered twice.
+      await provider.onLoad({ touchApp: { channel: {} } })
+      touchEventBus.emit(TalexEvents.FILE_ADDED, new FileAddedEvent('C:\\Users\\demo\\a.txt'))
+      expect(invalidateCache).toHaveBeenCalledTimes(1)
+
+      provider.onDestroy()
+      touchEventBus.emit(TalexEvents.FILE_ADDED, new FileAddedEvent('C:\\Users\\demo\\b.txt'))
+      expect(invalidateCache).toHaveBeenCalledTimes(1)
+    })
+  })
+
   it('loads settings and channels without blocking on startup backend detection', async () => {
     await withPlatform('win32', async () => {
       const provider = everythingProvider as unknown as MutableEverythingProvider
@@ -49,6 +49,7 @@ import {
   type EverythingPathFilteringStatus
 } from '../../../../../shared/events/everything'
 import compressing from 'compressing'
+import { TalexEvents, touchEventBus } from '../../../../core/eventbus/touch-event'
 import { normalizeTuffItemLocalAssets } from '../../../../utils/local-renderable-assets'
 import { formatDuration } from '../../../../utils/logger'
 import { getMainConfig, saveMainConfig } from '../../../storage'
@@ -140,6 +141,16 @@ function buildEverythingInstallAssets(): EverythingInstallAssetSpec[] {
 
 const EVERYTHING_TEST_QUERY = '*.txt'
 
+/** Watcher events after which the SDK addon's cached results may be stale. */
+const SDK_CACHE_INVALIDATING_EVENTS = [
+  TalexEvents.FILE_ADDED,
+  TalexEvents.FILE_CHANGED,
+  TalexEvents.FILE_UNLINKED,
+  TalexEvents.DIRECTORY_ADDED,
+  TalexEvents.DIRECTORY_UNLINKED,
+  TalexEvents.FILE_WATCH_OVERFLOWED
+] as const
+
 type EverythingFileSearchMeta = TuffMeta & {
   fileSearchContext?: FileSearchContextCandidate
 }
@@ -200,6 +211,12 @@ class EverythingProvider implements ISearchProvider<ProviderContext> {
   private readonly installService = new EverythingInstallService()
   readonly iconExtractions = { clear: () => this.iconCache.clear() }
 
+  // Everything reports no changes, so the addon's result cache is otherwise bounded only by its
+  // TTL; a change the file-system watcher saw drops it straight away.
+  private readonly invalidateSdkCache = (): void => {
+    this.sdkAddon?.invalidateCache?.()
+  }
+
   get diagnostics() {
     return this.diagnosticsTracker.snapshot()
   }
@@ -574,6 +591,7 @@ class EverythingProvider implements ISearchProvider<ProviderContext> {
 
     await this.loadSettings(context)
     this.registerChannels(context)
+    this.subscribeSdkCacheInvalidation()
     this.scheduleStartupBackendRefresh()
   }
 
@@ -1162,6 +1180,21 @@ class EverythingProvider implements ISearchProvider<ProviderContext> {
    */
   onDestroy(): void {
     this.disposeChannels()
+    this.unsubscribeSdkCacheInvalidation()
+  }
+
+  // touchEventBus.on throws on a repeated handler, and onLoad runs again on a provider reload.
+  private subscribeSdkCacheInvalidation(): void {
+    this.unsubscribeSdkCacheInvalidation()
+    for (const event of SDK_CACHE_INVALIDATING_EVENTS) {
+      touchEventBus.on(event, this.invalidateSdkCache)
+    }
+  }
+
+  private unsubscribeSdkCacheInvalidation(): void {
+    for (const event of SDK_CACHE_INVALIDATING_EVENTS) {
+      touchEventBus.off(event, this.invalidateSdkCache)
+    }
   }
 
   private registerChannels(context: ProviderContext): void {
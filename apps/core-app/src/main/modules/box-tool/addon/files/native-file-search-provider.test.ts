@@ -74,6 +74,20 @@ interface SearchableSpotlightProvider {
   ) => Promise<Array<{ path: string; name: string; extension: string; isDir: boolean }>>
 }
 
+interface SearchableLinuxProvider {
+  detect: () => Promise<boolean>
+  searchNative: (
+    text: string,
+    signal: AbortSignal
+  ) => Promise<Array<{ path: string; name: string; extension: string; isDir: boolean }>>
+}
+
+function createLinuxProvider(fileIndex: Record<string, unknown>): SearchableLinuxProvider {
+  return new __test__.LinuxNativeFileProvider(
+    () => fileIndex as never
+  ) as unknown as SearchableLinuxProvider
+}
+
 // The Spotlight path is macOS-only: the provider gates on
 // `process.platform !== this.capabilities.platform`, so on a Linux runner it
 // reports unavailable and warms no icons, and the failure reads as a broken
@@ -259,4 +273,137 @@ describe('native-file-search-provider', () => {
       __test__.isWithinMacSpotlightSearchRoots('/System/Library/PrivateFrameworks/a.svg', roots)
     ).toBe(false)
   })
+
+  it('answers from in-process locate while the Linux index is still building', async () => {
+    execFileMock.mockImplementation((_command, _args, _options, callback) => {
+      callback(null, { stdout: 'locate 0.0.1' })
+    })
+    statMock.mockResolvedValue({
+      size: 4,
+      mtime: new Date('2026-05-12T00:00:00.000Z'),
+      ctime: new Date('2026-05-12T00:00:00.000Z'),
+      isDirectory: () => false
+    })
+    const searchAsync = vi.fn(async () => [])
+    const locateStream = vi.fn(
+      async (
+        _query: string,
+        _options: unknown,
+        onBatch: (rows: Array<{ fullPath?: string }>) => void
+      ) => {
+        onBatch([{ fullPath: '/home/demo/notes/report.txt' }])
+        return 1
+      }
+    )
+    const provider = createLinuxProvider({
+      searchAsync,
+      getIndexStatus: () => ({ state: 'building' }),
+      getLocateStatus: () => ({ state: 'ready' }),
+      locateStream
+    })
+
+    await expect(provider.detect()).resolves.toBe(true)
+    execFileMock.mockClear()
+    const signal = new AbortController().signal
+    const results = await provider.searchNative('report', signal)
+
+    expect(results.map((result) => result.path)).toEqual(['/home/demo/notes/report.txt'])
+    expect(locateStream).toHaveBeenCalledWith(
+      'report',
+      { maxResults: 50, batchSize: 50, fields: ['fullPath'] },
+      expect.any(Function),
+      signal
+    )
+    expect(searchAsync).not.toHaveBeenCalled()
+    expect(execFileMock).not.toHaveBeenCalled()
+  })
+
+  it('prefers the Linux index over locate once its scan is ready', async () => {
+    execFileMock.mockImplementation((_command, _args, _options, callback) => {
+      callback(new Error('not installed'))
+    })
+    const searchAsync = vi.fn(async () => [
+      { path: '/home/demo/notes/report.txt', size: 4, mtime: 0, ctime: 0, isDir: false }
+    ])
+    const locateStream = vi.fn(async () => 0)
+    const provider = createLinuxProvider({
+      searchAsync,
+      getIndexStatus: () => ({ state: 'ready' }),
+      getLocateStatus: () => ({ state: 'ready' }),
+      locateStream
+    })
+
+    await expect(provider.detect()).resolves.toBe(true)
+    const results = await provider.searchNative('report', new AbortController().signal)
+
+    expect(results.map((result) => result.path)).toEqual(['/home/demo/notes/report.txt'])
+    expect(searchAsync).toHaveBeenCalledWith(
+      'report',
+      { maxResults: 200, channel: 'linux-native-file-provider' },
+      expect.any(AbortSignal)
+    )
+    expect(locateStream).not.toHaveBeenCalled()
+  })
+
+  it('drops a superseded index query instead of falling back', async () => {
+    execFileMock.mockImplementation((_command, _args, _options, callback) => {
+      callback(null, { stdout: 'locate 0.0.1' })
+    })
+    const superseded = Object.assign(new Error('Superseded by a newer search'), {
+      code: 'ERR_EVERYTHING_SUPERSEDED'
+    })
+    const searchAsync = vi.fn(async () => {
+      throw superseded
+    })
+    const locateStream = vi.fn(async () => 0)
+    const provider = createLinuxProvider({
+      searchAsync,
+      getIndexStatus: () => ({ state: 'ready' }),
+      getLocateStatus: () => ({ state: 'ready' }),
+      locateStream
+    })
+
+    await expect(provider.detect()).resolves.toBe(true)
+    execFileMock.mockClear()
+
+    await expect(provider.searchNative('report', new AbortController().signal)).rejects.toBe(
+      superseded
+    )
+    expect(locateStream).not.toHaveBeenCalled()
+    expect(execFileMock).not.toHaveBeenCalled()
+  })
+
+  it('spawns locate during a cold Linux index build with no readable database', async () => {
+    execFileMock.mockImplementation((_command, args, _options, callback) => {
+      if (Array.isArray(args) && args.includes('--version')) {
+        callback(null, { stdout: 'locate 0.0.1' })
+        return
+      }
+      callback(null, { stdout: '/home/demo/notes/report.txt\n' })
+    })
+    statMock.mockResolvedValue({
+      size: 4,
+      mtime: new Date('2026-05-12T00:00:00.000Z'),
+      ctime: new Date('2026-05-12T00:00:00.000Z'),
+      isDirectory: () => false
+    })
+    const searchAsync = vi.fn(async () => [])
+    const provider = createLinuxProvider({
+      searchAsync,
+      getIndexStatus: () => ({ state: 'building' }),
+      getLocateStatus: () => ({ state: 'unavailable' })
+    })
+
+    await expect(provider.detect()).resolves.toBe(true)
+    const results = await provider.searchNative('report', new AbortController().signal)
+
+    expect(results.map((result) => result.path)).toEqual(['/home/demo/notes/report.txt'])
+    expect(searchAsync).not.toHaveBeenCalled()
+    expect(execFileMock).toHaveBeenCalledWith(
+      'locate',
+      ['-i', '-l', '50', 'report'],
+      expect.objectContaining({ timeout: 1500 }),
+      expect.any(Function)
+    )
+  })
 })
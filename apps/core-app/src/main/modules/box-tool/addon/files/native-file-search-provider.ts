@@ -3,6 +3,7 @@ import type { ProviderContext } from '../../search-engine/types'
 import type { files as filesSchema } from '../../../../db/schema'
 import type { ISearchProvider } from '@talex-touch/utils'
 import fs from 'node:fs/promises'
+import { createRequire } from 'node:module'
 import path from 'node:path'
 import process from 'node:process'
 import { promisify } from 'node:util'
@@ -16,7 +17,9 @@ import { formatDuration } from '../../../../utils/logger'
 import { getMainConfig } from '../../../storage'
 import { searchLogger } from '../../search-engine/search-logger'
 import type { FileIndexSettings } from './types'
+import { isAbortError } from './everything-errors'
 import { EverythingIconCache } from './everything-icon-cache'
+import { parseEverythingSdkOutput } from './everything-parser'
 import { mapFileToTuffItem } from './utils'
 
 export interface NativeFileSearchCapabilities {
@@ -41,11 +44,52 @@ interface NativeFileSearchResult {
   isDir: boolean
 }
 
+/** Search commands the Linux provider spawns when nothing in-process can answer. */
 type LinuxNativeSearchBackend = 'locate' | 'tracker3' | 'tracker' | 'baloo'
 
+/** The slice of `@talex-touch/tuff-native/everything` the Linux provider uses. */
+interface TuffNativeFileIndex {
+  /** Runs the query on the addon's worker pool; rejects when `signal` aborts. */
+  searchAsync: (
+    query: string,
+    options?: { maxResults?: number; channel?: string },
+    signal?: AbortSignal
+  ) => Promise<unknown>
+  getIndexStatus: () => { state: string } | null
+  /** Reader for the system locate database; absent on older builds. */
+  getLocateStatus?: () => { state: string } | null
+  /** Scans the database on the addon's worker pool; rejects when `signal` aborts. */
+  locateStream?: (
+    query: string,
+    options: { maxResults?: number; batchSize?: number; fields?: string[] },
+    onBatch: (rows: Array<{ fullPath?: string }>) => void,
+    signal?: AbortSignal
+  ) => Promise<number>
+}
+
+/** Packed metadata from the addon's `statBatch`, one entry per requested path. */
+interface TuffNativeStatBatch {
+  size: Float64Array
+  mtimeMs: Float64Array
+  ctimeMs: Float64Array
+  flags: Uint8Array
+}
+
+type TuffNativeStatBatchFn = (paths: string[]) => Promise<TuffNativeStatBatch>
+
+// Bits of TuffNativeStatBatch.flags.
+const STAT_EXISTS = 1
+const STAT_DIRECTORY = 2
+
 const nativeFileSearchLog = getLogger('file-provider').child('Native')
 const execFileAsync = promisify(execFile)
 const NATIVE_SEARCH_MAX_RESULTS = 50
+// The in-process index returns metadata with each row, so a larger page costs
+// no follow-up stat calls.
+const NATIVE_INDEX_MAX_RESULTS = 200
+// Keystrokes replace each other on this channel only; a superseded query
+// rejects with ERR_EVERYTHING_SUPERSEDED, which counts as an abort.
+const NATIVE_INDEX_SEARCH_CHANNEL = 'linux-native-file-provider'
 const NATIVE_ICON_WARMUP_LIMIT = 12
 const MAC_SPOTLIGHT_DEFAULT_PATH_NAMES = [
   'documents',
@@ -133,20 +177,39 @@ function emptyResult(query: TuffQuery): TuffSearchResult {
   return new TuffSearchResultBuilder(query).build()
 }
 
-function isAbortError(error: unknown): boolean {
-  return (
-    typeof error === 'object' &&
-    error !== null &&
-    ('name' in error || 'code' in error) &&
-    ((error as { name?: string }).name === 'AbortError' ||
-      (error as { code?: string }).code === 'ABORT_ERR')
-  )
-}
-
 function normalizeExtension(filePath: string): string {
   return path.extname(filePath).toLowerCase().replace(/^\./, '')
 }
 
+function loadTuffNativeFileIndex(): TuffNativeFileIndex | null {
+  try {
+    const loaded = createRequire(import.meta.url)('@talex-touch/tuff-native/everything') as
+      | Partial<TuffNativeFileIndex>
+      | undefined
+    if (typeof loaded?.searchAsync !== 'function' || typeof loaded.getIndexStatus !== 'function') {
+      return null
+    }
+    return loaded as TuffNativeFileIndex
+  } catch {
+    return null
+  }
+}
+
+let nativeStatBatch: TuffNativeStatBatchFn | null | undefined
+
+function loadTuffNativeStatBatch(): TuffNativeStatBatchFn | null {
+  if (nativeStatBatch !== undefined) return nativeStatBatch
+  try {
+    const loaded = createRequire(import.meta.url)('@talex-touch/tuff-native/everything') as
+      | { statBatch?: TuffNativeStatBatchFn }
+      | undefined
+    nativeStatBatch = typeof loaded?.statBatch === 'function' ? loaded.statBatch : null
+  } catch {
+    nativeStatBatch = null
+  }
+  return nativeStatBatch
+}
+
 async function toNativeResult(filePath: string): Promise<NativeFileSearchResult | null> {
   try {
     const stats = await fs.stat(filePath)
@@ -164,6 +227,45 @@ async function toNativeResult(filePath: string): Promise<NativeFileSearchResult
   }
 }
 
+/**
+ * Stats a page of paths in one call to the addon's stat thread when it is
+ * available, instead of one libuv threadpool job per path. Paths that no
+ * longer exist are dropped either way.
+ */
+// Set once statBatch has rejected, e.g. a package whose addon was never built.
+let statBatchUnavailable = false
+
+async function toNativeResults(paths: string[]): Promise<NativeFileSearchResult[]> {
+  const statBatch = paths.length > 0 && !statBatchUnavailable ? loadTuffNativeStatBatch() : null
+  if (!statBatch) {
+    const results = await Promise.all(paths.map((filePath) => toNativeResult(filePath)))
+    return results.filter((result): result is NativeFileSearchResult => Boolean(result))
+  }
+
+  let stats: TuffNativeStatBatch
+  try {
+    stats = await statBatch(paths)
+  } catch {
+    statBatchUnavailable = true
+    return toNativeResults(paths)
+  }
+  const results: NativeFileSearchResult[] = []
+  paths.forEach((filePath, index) => {
+    const flags = stats.flags[index]
+    if (!(flags & STAT_EXISTS)) return
+    results.push({
+      path: filePath,
+      name: path.basename(filePath),
+      extension: normalizeExtension(filePath),
+      size: stats.size[index],
+      mtime: new Date(stats.mtimeMs[index]),
+      ctime: new Date(stats.ctimeMs[index]),
+      isDir: (flags & STAT_DIRECTORY) !== 0
+    })
+  })
+  return results
+}
+
 function buildNativeSearchItems(
   provider: Pick<NativeFileSearchProvider, 'id' | 'name'>,
   query: TuffQuery,
@@ -360,11 +462,33 @@ class MacSpotlightFileProvider extends BaseNativeFileSearchProvider {
           .filter((entry) => fileFilterService.getSearchExclusionReason({ path: entry }) === null)
       )
     ).slice(0, NATIVE_SEARCH_MAX_RESULTS)
-    const results = await Promise.all(paths.map((filePath) => toNativeResult(filePath)))
-    return results.filter((result): result is NativeFileSearchResult => Boolean(result))
+    return toNativeResults(paths)
   }
 }
 
+async function detectSpawnedBackend(): Promise<LinuxNativeSearchBackend | null> {
+  const candidates: Array<{
+    backend: LinuxNativeSearchBackend
+    command: string
+    args: string[]
+  }> = [
+    { backend: 'locate', command: 'locate', args: ['--version'] },
+    { backend: 'tracker3', command: 'tracker3', args: ['--version'] },
+    { backend: 'tracker', command: 'tracker', args: ['--version'] },
+    { backend: 'baloo', command: 'baloosearch', args: ['--version'] }
+  ]
+
+  for (const candidate of candidates) {
+    try {
+      await execFileAsync(candidate.command, candidate.args, { timeout: 1000 })
+      return candidate.backend
+    } catch {
+      // try next backend
+    }
+  }
+  return null
+}
+
 class LinuxNativeFileProvider extends BaseNativeFileSearchProvider {
   readonly id = 'linux-native-file-provider'
   readonly name = 'Linux Native File Search'
@@ -375,38 +499,38 @@ class LinuxNativeFileProvider extends BaseNativeFileSearchProvider {
     supportsContent: false
   }
   private backend: LinuxNativeSearchBackend | null = null
+  private fileIndex: TuffNativeFileIndex | null = null
+
+  constructor(private readonly loadFileIndex = loadTuffNativeFileIndex) {
+    super()
+  }
 
   protected async detect(): Promise<boolean> {
-    const candidates: Array<{
-      backend: LinuxNativeSearchBackend
-      command: string
-      args: string[]
-    }> = [
-      { backend: 'locate', command: 'locate', args: ['--version'] },
-      { backend: 'tracker3', command: 'tracker3', args: ['--version'] },
-      { backend: 'tracker', command: 'tracker', args: ['--version'] },
-      { backend: 'baloo', command: 'baloosearch', args: ['--version'] }
-    ]
-
-    for (const candidate of candidates) {
-      try {
-        await execFileAsync(candidate.command, candidate.args, { timeout: 1000 })
-        this.backend = candidate.backend
-        return true
-      } catch {
-        // try next backend
-      }
-    }
-    this.backend = null
-    return false
+    // Each query goes to the in-process index once its scan is ready, else to
+    // the in-process locate reader once its database is loaded, else to a
+    // spawned backend. The index is cold for the first scan and the locate
+    // database is often unreadable, so all three are detected up front.
+    // A null status means the addon was built without that reader; reading
+    // it otherwise starts the load.
+    const fileIndex = this.loadFileIndex()
+    const hasIndex = Boolean(fileIndex?.getIndexStatus())
+    const hasLocate = Boolean(fileIndex?.getLocateStatus?.())
+    this.fileIndex = hasIndex || hasLocate ? fileIndex : null
+    this.backend = await detectSpawnedBackend()
+    return this.fileIndex !== null || this.backend !== null
   }
 
   protected async searchNative(
     text: string,
     signal: AbortSignal
   ): Promise<NativeFileSearchResult[]> {
-    if (!this.backend) return []
+    const indexed = await this.searchIndex(text, signal)
+    if (indexed) return indexed
 
+    const located = await this.locateInProcess(text, signal)
+    if (located) return located
+
+    if (!this.backend) return []
     const { command, args } = this.buildSearchCommand(text)
     const { stdout } = await execFileAsync(command, args, {
       timeout: 1500,
@@ -416,8 +540,80 @@ class LinuxNativeFileProvider extends BaseNativeFileSearchProvider {
     const paths = this.parseOutput(stdout)
       .filter((entry) => fileFilterService.getSearchExclusionReason({ path: entry }) === null)
       .slice(0, NATIVE_SEARCH_MAX_RESULTS)
-    const results = await Promise.all(paths.map((filePath) => toNativeResult(filePath)))
-    return results.filter((result): result is NativeFileSearchResult => Boolean(result))
+    return toNativeResults(paths)
+  }
+
+  /**
+   * Answers from the in-process index off the main thread. Null until the
+   * first scan has finished: a building index answers with whatever it has
+   * reached so far, which is usually nothing. A refresh keeps serving the
+   * previous complete index, so it counts as ready.
+   */
+  private async searchIndex(
+    text: string,
+    signal: AbortSignal
+  ): Promise<NativeFileSearchResult[] | null> {
+    const fileIndex = this.fileIndex
+    const state = fileIndex?.getIndexStatus()?.state
+    if (!fileIndex || (state !== 'ready' && state !== 'refreshing')) return null
+    try {
+      const rows = await fileIndex.searchAsync(
+        text,
+        { maxResults: NATIVE_INDEX_MAX_RESULTS, channel: NATIVE_INDEX_SEARCH_CHANNEL },
+        signal
+      )
+      return parseEverythingSdkOutput(rows).filter(
+        (entry) => fileFilterService.getSearchExclusionReason({ path: entry.path }) === null
+      )
+    } catch (error) {
+      if (isAbortError(error)) throw error
+      nativeFileSearchLog.debug(`[${this.id}] index search failed, falling back`, {
+        error: error instanceof Error ? error.message : String(error)
+      })
+      return null
+    }
+  }
+
+  /**
+   * Answers from the locate database in-process, scanning it on the addon's
+   * worker pool rather than the main thread. Only paths are fetched, so the
+   * scan stats nothing; the hits are stat'ed together afterwards, as spawned
+   * results are. Null while the database is loading, when it is unreadable
+   * (system databases are often group-restricted) or for queries the reader
+   * does not support, so the caller spawns `locate`.
+   */
+  private async locateInProcess(
+    text: string,
+    signal: AbortSignal
+  ): Promise<NativeFileSearchResult[] | null> {
+    const fileIndex = this.fileIndex
+    if (!fileIndex?.locateStream || fileIndex.getLocateStatus?.()?.state !== 'ready') return null
+    const paths: string[] = []
+    try {
+      await fileIndex.locateStream(
+        text,
+        {
+          maxResults: NATIVE_SEARCH_MAX_RESULTS,
+          batchSize: NATIVE_SEARCH_MAX_RESULTS,
+          fields: ['fullPath']
+        },
+        (rows) => {
+          for (const row of rows) {
+            if (row.fullPath) paths.push(row.fullPath)
+          }
+        },
+        signal
+      )
+    } catch (error) {
+      if (isAbortError(error)) throw error
+      nativeFileSearchLog.debug(`[${this.id}] in-process locate failed, spawning locate`, {
+        error: error instanceof Error ? error.message : String(error)
+      })
+      return null
+    }
+    return toNativeResults(
+      paths.filter((entry) => fileFilterService.getSearchExclusionReason({ path: entry }) === null)
+    )
   }
 
   private buildSearchCommand(text: string): { command: string; args: string[] } {
@@ -450,6 +646,7 @@ export const macSpotlightFileProvider = new MacSpotlightFileProvider()
 export const linuxNativeFileProvider = new LinuxNativeFileProvider()
 
 export const __test__ = {
+  LinuxNativeFileProvider,
   createMacSpotlightSearchRoots,
   isWithinMacSpotlightSearchRoots
 }
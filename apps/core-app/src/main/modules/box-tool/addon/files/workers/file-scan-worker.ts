@@ -8,6 +8,7 @@ import { performance } from 'node:perf_hooks'
 import process from 'node:process'
 import { parentPort } from 'node:worker_threads'
 import { scanDirectoryBatches } from '@talex-touch/utils/common/file-scan-utils'
+import { NativeScanIncompleteError, scanDirectoryBatchesNative } from './native-file-scan'
 
 interface FileScanRequest {
   type: 'scan'
@@ -76,6 +77,24 @@ function buildMetricsPayload(): WorkerMetricsPayload {
   }
 }
 
+/**
+ * Walks with the tuff-native tree scanner when the addon is present (one
+ * parallel native walk instead of a readdir/stat round trip per directory
+ * and file), with the same filtering and batching as scanDirectoryBatches,
+ * which remains the fallback, also for a native walk that stopped early.
+ */
+async function scanPathBatches(
+  ...args: Parameters<typeof scanDirectoryBatches>
+): ReturnType<typeof scanDirectoryBatches> {
+  try {
+    const stats = await scanDirectoryBatchesNative(...args)
+    if (stats) return stats
+  } catch (error) {
+    if (!(error instanceof NativeScanIncompleteError)) throw error
+  }
+  return await scanDirectoryBatches(...args)
+}
+
 const queue: FileScanRequest[] = []
 const activeControllers = new Map<string, AbortController>()
 const cancelledTasks = new Set<string>()
@@ -107,7 +126,7 @@ async function processQueue(): Promise<void> {
 
   try {
     for (const scanPath of next.paths) {
-      const stats = await scanDirectoryBatches(
+      const stats = await scanPathBatches(
         scanPath,
         async (batch) => {
           controller.signal.throwIfAborted()
@@ -0,0 +1,131 @@
+import type { NativeScanTreeFn, NativeTreeScanBatch } from './native-file-scan'
+import fs from 'node:fs'
+import path from 'node:path'
+import process from 'node:process'
+import {
+  createScanOptions,
+  scanDirectoryBatches
+} from '@talex-touch/utils/common/file-scan-utils'
+import { afterAll, describe, expect, it } from 'vitest'
+import { NativeScanIncompleteError, scanDirectoryBatchesNative } from './native-file-scan'
+
+// Rooted under the cwd rather than os.tmpdir(), whose "/tmp/" and "/var/"
+// segments the path heuristics reject; those are turned off for the same
+// reason, as in file-scan-utils.test.ts.
+const root = fs.mkdtempSync(path.join(process.cwd(), 'native-file-scan-'))
+const scanOpts = createScanOptions({
+  enableSystemPathFilter: false,
+  enableDevPathFilter: false,
+  enableCachePathFilter: false,
+  enablePhotosLibraryFilter: false
+})
+
+function write(relative: string, content = 'x'): void {
+  const file = path.join(root, relative)
+  fs.mkdirSync(path.dirname(file), { recursive: true })
+  fs.writeFileSync(file, content)
+}
+
+write('report.pdf', 'twelve bytes')
+write('Documents/notes.md')
+write('Documents/Makefile')
+write('Documents/~lock.docx')
+write('Documents/archive.tmp')
+write('Documents/.DS_Store')
+write('projects/app/dist/bundle.js')
+write('projects/app/src/main.ts')
+write('projects/app/node_modules/pkg/index.js')
+write('.config/settings.json')
+write('Pictures/Trip.photoslibrary/originals/a.jpg')
+write('excluded/skip.txt')
+
+// Stands in for the addon: walks everything, prunes nothing, so the test
+// checks that the JS side alone reproduces the file filter.
+const walkEverything: NativeScanTreeFn = async (roots, _options, onBatch) => {
+  const batch: NativeTreeScanBatch = {
+    count: 0,
+    paths: [],
+    size: new Float64Array(64),
+    mtimeMs: new Float64Array(64),
+    ctimeMs: new Float64Array(64),
+    type: new Uint8Array(64)
+  }
+  const visit = (directory: string): void => {
+    for (const entry of fs.readdirSync(directory, { withFileTypes: true })) {
+      const fullPath = path.join(directory, entry.name)
+      const stats = fs.statSync(fullPath)
+      const index = batch.count++
+      batch.paths.push(fullPath)
+      batch.size[index] = stats.size
+      batch.mtimeMs[index] = stats.mtimeMs
+      batch.ctimeMs[index] = stats.birthtimeMs
+      batch.type[index] = entry.isDirectory() ? 2 : 1
+      if (entry.isDirectory()) visit(fullPath)
+    }
+  }
+  roots.forEach(visit)
+  await onBatch(batch)
+  return { entryCount: batch.count, directoryCount: 0, errorCount: 0, cancelled: false }
+}
+
+async function collect(
+  scan: (onBatch: (batch: { path: string; size: number }[]) => Promise<void>) => Promise<unknown>
+): Promise<Map<string, number>> {
+  const files = new Map<string, number>()
+  await scan(async (batch) => {
+    for (const file of batch) files.set(file.path, file.size)
+  })
+  return files
+}
+
+describe('scanDirectoryBatchesNative', () => {
+  afterAll(() => {
+    fs.rmSync(root, { recursive: true, force: true })
+  })
+
+  it('keeps exactly the files scanDirectoryBatches keeps', async () => {
+    const excludePaths = new Set([path.join(root, 'excluded')])
+    const expected = await collect((onBatch) =>
+      scanDirectoryBatches(root, onBatch, scanOpts, excludePaths)
+    )
+    const actual = await collect((onBatch) =>
+      scanDirectoryBatchesNative(root, onBatch, scanOpts, excludePaths, {}, walkEverything)
+    )
+
+    expect(actual).toEqual(expected)
+    expect(actual.get(path.join(root, 'report.pdf'))).toBe(12)
+    expect(actual.has(path.join(root, 'projects/app/src/main.ts'))).toBe(true)
+    expect(actual.has(path.join(root, 'projects/app/dist/bundle.js'))).toBe(false)
+  })
+
+  it('hands the native walker only exclusions the filter agrees with', async () => {
+    let options: Record<string, unknown> = {}
+    const capture: NativeScanTreeFn = async (roots, scanOptions, onBatch, signal) => {
+      options = scanOptions
+      return await walkEverything(roots, scanOptions, onBatch, signal)
+    }
+    await scanDirectoryBatchesNative(root, async () => {}, scanOpts, undefined, {}, capture)
+
+    expect(options.excludeNamesIgnoreCase).toContain('node_modules')
+    expect(options.excludeExtensions).toContain('.tmp')
+    // Capitalised entries never match the lower-cased lookup in the filter.
+    expect(options.excludeExtensions).not.toContain('.DS_Store')
+    expect(options.maxDepth).toBe(24)
+  })
+
+  it('rejects a walk the addon cut short instead of reporting it complete', async () => {
+    const cutShort: NativeScanTreeFn = async (roots, scanOptions, onBatch, signal) => {
+      const summary = await walkEverything(roots, scanOptions, onBatch, signal)
+      return { ...summary, cancelled: true }
+    }
+    await expect(
+      scanDirectoryBatchesNative(root, async () => {}, scanOpts, undefined, {}, cutShort)
+    ).rejects.toBeInstanceOf(NativeScanIncompleteError)
+  })
+
+  it('resolves to null without the addon', async () => {
+    await expect(
+      scanDirectoryBatchesNative(root, async () => {}, undefined, undefined, {}, null)
+    ).resolves.toBeNull()
+  })
+})
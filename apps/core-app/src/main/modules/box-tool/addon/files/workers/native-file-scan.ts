@@ -0,0 +1,202 @@
+import type { FileScanOptions } from '@talex-touch/utils/common/file-scan-constants'
+import type {
+  ScanDirectoryBatchOptions,
+  ScanDirectoryStats,
+  ScannedFileInfo
+} from '@talex-touch/utils/common/file-scan-utils'
+import { createRequire } from 'node:module'
+import path from 'node:path'
+import {
+  BLACKLISTED_BUNDLE_SUFFIXES,
+  BLACKLISTED_EXTENSIONS,
+  BLACKLISTED_FILE_PREFIXES,
+  DEFAULT_SCAN_OPTIONS,
+  DEV_BLACKLISTED_DIRS,
+  SYSTEM_BLACKLISTED_DIRS,
+  TEMP_BLACKLISTED_DIRS
+} from '@talex-touch/utils/common/file-scan-constants'
+import { fileFilterService } from '@talex-touch/utils/common/file-filter-service'
+import { isIndexableFile, normalizeFsPath } from '@talex-touch/utils/common/file-scan-utils'
+
+export interface NativeTreeScanBatch {
+  count: number
+  paths: string[]
+  size: Float64Array
+  mtimeMs: Float64Array
+  ctimeMs: Float64Array
+  type: Uint8Array
+}
+
+export interface NativeTreeScanSummary {
+  entryCount: number
+  directoryCount: number
+  errorCount: number
+  cancelled: boolean
+}
+
+export type NativeScanTreeFn = (
+  roots: string[],
+  options: Record<string, unknown>,
+  onBatch: (batch: NativeTreeScanBatch) => Promise<void>,
+  signal?: AbortSignal
+) => Promise<NativeTreeScanSummary>
+
+// SCAN_FILE in tuff-native's everything module.
+const NATIVE_SCAN_FILE = 1
+
+// Same bound as scanDirectoryBatches' MAX_SCAN_DEPTH.
+const MAX_SCAN_DEPTH = 24
+
+// Verdicts are recomputed after this many directories rather than kept for
+// the whole walk; a full-disk scan sees millions.
+const MAX_CACHED_DIRECTORY_VERDICTS = 100_000
+
+let nativeScanTree: NativeScanTreeFn | null | undefined
+
+export function loadNativeScanTree(): NativeScanTreeFn | null {
+  if (nativeScanTree !== undefined) return nativeScanTree
+  try {
+    const loaded = createRequire(import.meta.url)('@talex-touch/tuff-native/everything') as
+      | { scanTree?: NativeScanTreeFn }
+      | undefined
+    nativeScanTree = typeof loaded?.scanTree === 'function' ? loaded.scanTree : null
+  } catch {
+    nativeScanTree = null
+  }
+  return nativeScanTree
+}
+
+function lowerCaseOnly(values: Iterable<string>): string[] {
+  // The file filter lower-cases the name and looks it up as is, so an entry
+  // with capitals (".DS_Store") never matches there and must not here either.
+  return Array.from(values).filter((value) => value === value.toLowerCase())
+}
+
+/**
+ * The subset of the file filter that is plain names and suffixes, handed to
+ * the native walker so those subtrees are never read. Everything it prunes the
+ * filter would reject too; path patterns and the rest of the file rules are
+ * applied afterwards by `createNativeScanFilter`.
+ */
+export function buildNativeScanOptions(
+  options: FileScanOptions,
+  excludePaths: Set<string> | undefined,
+  batchSize: number
+): Record<string, unknown> {
+  return {
+    batchSize,
+    maxDepth: MAX_SCAN_DEPTH,
+    skipHidden: true,
+    excludePaths: [...(excludePaths ?? []), ...(options.customExcludePaths ?? [])],
+    excludeNames: [...(options.customBlacklistedDirs ?? [])],
+    excludeNamesIgnoreCase: [...DEV_BLACKLISTED_DIRS, ...TEMP_BLACKLISTED_DIRS],
+    rootExcludeNamesIgnoreCase: [...SYSTEM_BLACKLISTED_DIRS],
+    excludeSuffixesIgnoreCase: [...BLACKLISTED_BUNDLE_SUFFIXES],
+    requireExtension: true,
+    excludeExtensions: lowerCaseOnly([
+      ...BLACKLISTED_EXTENSIONS,
+      ...(options.customBlacklistedExtensions ?? [])
+    ]),
+    excludeFilePrefixes: [...BLACKLISTED_FILE_PREFIXES]
+  }
+}
+
+/**
+ * Turns native batches into what scanDirectoryBatches would have produced
+ * for `root`: a file is kept only when every directory from the root down to
+ * it passes the traversal rules and the file itself is indexable.
+ */
+export function createNativeScanFilter(
+  root: string,
+  options: FileScanOptions,
+  excludePaths: Set<string> | undefined
+): (batch: NativeTreeScanBatch) => ScannedFileInfo[] {
+  const verdicts = new Map<string, boolean>()
+
+  const isTraversable = (directory: string): boolean => {
+    const cached = verdicts.get(directory)
+    if (cached !== undefined) return cached
+
+    const parent = path.dirname(directory)
+    const allowed =
+      (directory.length <= root.length || parent === directory || isTraversable(parent)) &&
+      !excludePaths?.has(directory) &&
+      fileFilterService.getTraversalExclusionReason(directory, options) === null
+    if (verdicts.size >= MAX_CACHED_DIRECTORY_VERDICTS) verdicts.clear()
+    verdicts.set(directory, allowed)
+    return allowed
+  }
+
+  return (batch) => {
+    const files: ScannedFileInfo[] = []
+    for (let index = 0; index < batch.count; index += 1) {
+      const fullPath = batch.paths[index]
+      if (!fullPath || batch.type[index] !== NATIVE_SCAN_FILE) continue
+      if (excludePaths?.has(fullPath) || !isTraversable(path.dirname(fullPath))) continue
+
+      const fileName = path.basename(fullPath)
+      const extension = path.extname(fileName).toLowerCase()
+      if (!isIndexableFile(fullPath, extension, fileName, options)) continue
+
+      files.push({
+        path: normalizeFsPath(fullPath),
+        name: normalizeFsPath(fileName),
+        extension,
+        size: batch.size[index],
+        ctime: new Date(batch.ctimeMs[index]),
+        mtime: new Date(batch.mtimeMs[index])
+      })
+    }
+    return files
+  }
+}
+
+/**
+ * The native walk stopped before covering the tree without the caller having
+ * aborted. The batches already delivered are a partial tree, so the result
+ * must not be treated as a complete scan.
+ */
+export class NativeScanIncompleteError extends Error {
+  constructor(readonly root: string) {
+    super(`Native tree scan of ${root} was cancelled before it finished`)
+    this.name = 'NativeScanIncompleteError'
+  }
+}
+
+/**
+ * scanDirectoryBatches on the tuff-native tree scanner: the walk runs on
+ * native threads and only the filtering happens here. Resolves to null when
+ * the addon is not available and rejects with NativeScanIncompleteError when
+ * the walk was cut short natively, so the caller can fall back.
+ */
+export async function scanDirectoryBatchesNative(
+  dirPath: string,
+  onBatch: (batch: ScannedFileInfo[]) => Promise<void>,
+  options: FileScanOptions = DEFAULT_SCAN_OPTIONS,
+  excludePaths?: Set<string>,
+  batchOptions: ScanDirectoryBatchOptions = {},
+  scanTree: NativeScanTreeFn | null = loadNativeScanTree()
+): Promise<ScanDirectoryStats | null> {
+  if (!scanTree) return null
+
+  const opts = { ...DEFAULT_SCAN_OPTIONS, ...options }
+  const batchSize = Math.max(1, Math.floor(batchOptions.batchSize ?? 500))
+  const filter = createNativeScanFilter(dirPath, opts, excludePaths)
+  batchOptions.signal?.throwIfAborted()
+
+  let entryCount = 0
+  const summary = await scanTree(
+    [dirPath],
+    buildNativeScanOptions(opts, excludePaths, batchSize),
+    async (batch) => {
+      const files = filter(batch)
+      if (files.length === 0) return
+      entryCount += files.length
+      await onBatch(files)
+    },
+    batchOptions.signal
+  )
+  batchOptions.signal?.throwIfAborted()
+  if (summary.cancelled) throw new NativeScanIncompleteError(dirPath)
+  return { entryCount, errorCount: summary.errorCount }
+}
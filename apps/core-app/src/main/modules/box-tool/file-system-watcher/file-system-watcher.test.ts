@@ -133,4 +133,118 @@ describe('FileSystemWatcherModule', () => {
       expect.any(Function)
     )
   })
+
+  describe('native directory watcher', () => {
+    type NativeEvent = { action: string; rawPath: string; isDirectory: boolean }
+
+    function createNativeWatcherModule(add: (root: string, depth?: number) => void = vi.fn()) {
+      let deliver: (events: NativeEvent[]) => void = () => {}
+      const nativeWatcher = { add: vi.fn(add), remove: vi.fn(), close: vi.fn() }
+      const createDirectoryWatcher = vi.fn((onEvents: (events: NativeEvent[]) => void) => {
+        deliver = onEvents
+        return nativeWatcher
+      })
+      const watcher = new FileSystemWatcherModule({
+        platform: 'linux',
+        requireModule: () => ({ createDirectoryWatcher })
+      })
+      return {
+        watcher,
+        nativeWatcher,
+        createDirectoryWatcher,
+        deliver: (events: NativeEvent[]) => deliver(events)
+      }
+    }
+
+    it('watches through the native watcher instead of chokidar on Linux', async () => {
+      const { watcher, nativeWatcher, createDirectoryWatcher } = createNativeWatcherModule()
+
+      await watcher.addPath('/home/demo', 3)
+
+      expect(createDirectoryWatcher).toHaveBeenCalledWith(expect.any(Function), {
+        latencyMs: 200
+      })
+      expect(nativeWatcher.add).toHaveBeenCalledWith('/home/demo', 3)
+      expect(watcherAdd).not.toHaveBeenCalled()
+
+      watcher.onDestroy()
+      expect(nativeWatcher.close).toHaveBeenCalled()
+    })
+
+    it('maps native events onto the file-system bus events', async () => {
+      const { watcher, deliver } = createNativeWatcherModule()
+      await watcher.addPath('/home/demo', 3)
+
+      deliver([
+        { action: 'add', rawPath: '/home/demo/a.txt', isDirectory: false },
+        { action: 'add', rawPath: '/home/demo/dir', isDirectory: true },
+        { action: 'change', rawPath: '/home/demo/a.txt', isDirectory: false },
+        { action: 'delete', rawPath: '/home/demo/b.txt', isDirectory: false },
+        { action: 'delete', rawPath: '/home/demo/old', isDirectory: true },
+        // A rename arrives as the delete of the old name and the add of the new one.
+        { action: 'delete', rawPath: '/home/demo/draft.md', isDirectory: false },
+        { action: 'add', rawPath: '/home/demo/final.md', isDirectory: false },
+        { action: 'overflow', rawPath: '/home/demo', isDirectory: true }
+      ])
+
+      expect(
+        vi.mocked(touchEventBus.emit).mock.calls.map(([name, event]) => [
+          name,
+          (event as { filePath: string }).filePath
+        ])
+      ).toEqual([
+        [TalexEvents.FILE_ADDED, '/home/demo/a.txt'],
+        [TalexEvents.DIRECTORY_ADDED, '/home/demo/dir'],
+        [TalexEvents.FILE_CHANGED, '/home/demo/a.txt'],
+        [TalexEvents.FILE_UNLINKED, '/home/demo/b.txt'],
+        [TalexEvents.DIRECTORY_UNLINKED, '/home/demo/old'],
+        [TalexEvents.FILE_UNLINKED, '/home/demo/draft.md'],
+        [TalexEvents.FILE_ADDED, '/home/demo/final.md'],
+        [TalexEvents.FILE_WATCH_OVERFLOWED, '/home/demo']
+      ])
+    })
+
+    it('queues a root the native watcher is denied until access returns', async () => {
+      const add = vi
+        .fn()
+        .mockImplementationOnce(() => {
+          throw Object.assign(new Error('inotify_add_watch: permission denied'), {
+            code: 'EACCES'
+          })
+        })
+        .mockImplementation(() => undefined)
+      const { watcher, nativeWatcher } = createNativeWatcherModule(add)
+
+      await watcher.addPath('/home/demo/private', 3)
+      expect(watcher.getPendingPaths()).toEqual(['/home/demo/private'])
+
+      await expect(watcher.tryPendingPaths()).resolves.toEqual(['/home/demo/private'])
+      expect(nativeWatcher.add).toHaveBeenCalledTimes(2)
+      expect(watcher.hasPendingPaths()).toBe(false)
+    })
+
+    it('rethrows a native watch failure that is not a permission error', async () => {
+      const { watcher } = createNativeWatcherModule(() => {
+        throw Object.assign(new Error('inotify_add_watch: no space left'), { code: 'ENOSPC' })
+      })
+
+      await expect(watcher.addPath('/home/demo', 3)).rejects.toThrow('no space left')
+      expect(watcher.getPendingPaths()).toEqual([])
+    })
+
+    it('falls back to chokidar when the native watcher cannot be created', async () => {
+      const watcher = new FileSystemWatcherModule({
+        platform: 'linux',
+        requireModule: () => ({
+          createDirectoryWatcher: () => {
+            throw new Error('inotify_init1: too many instances')
+          }
+        })
+      })
+
+      await watcher.addPath('/home/demo', 3)
+
+      expect(watcherAdd).toHaveBeenCalledWith('/home/demo')
+    })
+  })
 })
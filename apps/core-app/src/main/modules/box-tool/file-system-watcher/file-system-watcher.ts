@@ -1,5 +1,6 @@
 import type { ModuleKey } from '@talex-touch/utils'
 import fs from 'node:fs/promises'
+import { createRequire } from 'node:module'
 import process from 'node:process'
 import { getLogger } from '@talex-touch/utils/common/logger'
 import { pollingService } from '@talex-touch/utils/common/utils/polling'
@@ -10,6 +11,7 @@ import {
   DirectoryUnlinkedEvent,
   FileAddedEvent,
   FileChangedEvent,
+  FileWatchOverflowedEvent,
   FileWatchRootRecoveredEvent,
   FileUnlinkedEvent,
   TalexEvents,
@@ -30,6 +32,49 @@ interface PendingPath {
   depth: number
 }
 
+interface NativeWatchEvent {
+  action: 'add' | 'change' | 'delete' | 'overflow'
+  rawPath: string
+  isDirectory: boolean
+}
+
+interface NativeDirectoryWatcher {
+  add: (root: string, depth?: number) => void
+  remove: (root: string) => void
+  close: () => void
+}
+
+type CreateNativeDirectoryWatcher = (
+  onEvents: (events: NativeWatchEvent[]) => void,
+  options?: { latencyMs?: number }
+) => NativeDirectoryWatcher
+
+export interface FileSystemWatcherRuntime {
+  requireModule?: (candidate: string) => unknown
+  platform?: NodeJS.Platform
+}
+
+/**
+ * Linux only: the tuff-native watcher (fanotify or inotify) replaces the
+ * chokidar instances when the addon is present. Null when it is not.
+ */
+function loadNativeDirectoryWatcherFactory(
+  requireModule: (candidate: string) => unknown,
+  platform: NodeJS.Platform
+): CreateNativeDirectoryWatcher | null {
+  if (platform !== 'linux') return null
+  try {
+    const loaded = requireModule('@talex-touch/tuff-native/everything') as
+      | { createDirectoryWatcher?: CreateNativeDirectoryWatcher }
+      | undefined
+    return typeof loaded?.createDirectoryWatcher === 'function'
+      ? loaded.createDirectoryWatcher
+      : null
+  } catch {
+    return null
+  }
+}
+
 /**
  * A module that watches the file system for application installations,
  * updates, and uninstalls, and emits events on the touchEventBus.
@@ -39,17 +84,23 @@ export class FileSystemWatcherModule extends BaseModule {
   static key: symbol = Symbol.for('FileSystemWatcher')
   name: ModuleKey = FileSystemWatcherModule.key
   private watchers: Map<number, chokidar.FSWatcher> = new Map()
+  // undefined until the first path is added; null when chokidar is used.
+  private nativeWatcher: NativeDirectoryWatcher | null | undefined
   private watchedPaths: Set<string> = new Set()
   private pendingPaths: Map<string, PendingPath> = new Map()
   private pendingAdditions: Set<string> = new Set()
+  private readonly requireModule: (candidate: string) => unknown
+  private readonly platform: NodeJS.Platform
 
   // Bound so the same reference is used for both on() and off().
   private readonly handlePermissionsRefreshed = (): Promise<string[]> => this.tryPendingPaths()
 
-  constructor() {
+  constructor(runtime: FileSystemWatcherRuntime = {}) {
     super(FileSystemWatcherModule.key, {
       create: false
     })
+    this.requireModule = runtime.requireModule ?? createRequire(import.meta.url)
+    this.platform = runtime.platform ?? process.platform
   }
 
   private async hasAccess(p: string): Promise<boolean> {
@@ -77,6 +128,63 @@ export class FileSystemWatcherModule extends BaseModule {
     return this.pendingPaths.size > 0
   }
 
+  private getNativeWatcher(): NativeDirectoryWatcher | null {
+    if (this.nativeWatcher !== undefined) {
+      return this.nativeWatcher
+    }
+
+    this.nativeWatcher = null
+    const createWatcher = loadNativeDirectoryWatcherFactory(this.requireModule, this.platform)
+    if (!createWatcher) {
+      return null
+    }
+    try {
+      // Native events are already coalesced and "change" only fires once a
+      // writer closes the file, which is what awaitWriteFinish polled for.
+      this.nativeWatcher = createWatcher((events) => this.emitNativeEvents(events), {
+        latencyMs: 200
+      })
+      fileSystemWatcherLog.info('Using native directory watcher')
+    } catch (error) {
+      fileSystemWatcherLog.warn('Native directory watcher unavailable, using chokidar', { error })
+    }
+    return this.nativeWatcher
+  }
+
+  private emitNativeEvents(events: NativeWatchEvent[]): void {
+    for (const event of events) {
+      const rawPath = event.rawPath
+      switch (event.action) {
+        case 'add':
+          if (event.isDirectory) {
+            touchEventBus.emit(TalexEvents.DIRECTORY_ADDED, new DirectoryAddedEvent(rawPath))
+          } else {
+            touchEventBus.emit(TalexEvents.FILE_ADDED, new FileAddedEvent(rawPath))
+          }
+          break
+        case 'change':
+          touchEventBus.emit(TalexEvents.FILE_CHANGED, new FileChangedEvent(rawPath))
+          break
+        case 'delete':
+          if (event.isDirectory) {
+            touchEventBus.emit(TalexEvents.DIRECTORY_UNLINKED, new DirectoryUnlinkedEvent(rawPath))
+          } else {
+            touchEventBus.emit(TalexEvents.FILE_UNLINKED, new FileUnlinkedEvent(rawPath))
+          }
+          break
+        case 'overflow':
+          // The kernel queue dropped events under rawPath; only a rescan can
+          // tell what changed there.
+          fileSystemWatcherLog.warn(`Native watcher queue overflowed, rescanning ${rawPath}`)
+          touchEventBus.emit(
+            TalexEvents.FILE_WATCH_OVERFLOWED,
+            new FileWatchOverflowedEvent(rawPath)
+          )
+          break
+      }
+    }
+  }
+
   private getOrCreateWatcher(depth: number): chokidar.FSWatcher {
     if (this.watchers.has(depth)) {
       return this.watchers.get(depth)!
@@ -188,8 +296,13 @@ export class FileSystemWatcherModule extends BaseModule {
    * Internal method to add path to watcher (assumes permission check passed)
    */
   private async addPathInternal(p: string, depth: number): Promise<void> {
-    const watcher = this.getOrCreateWatcher(depth)
-    watcher.add(p)
+    const nativeWatcher = this.getNativeWatcher()
+    if (nativeWatcher) {
+      // Throws with an errno `code` (EACCES, EPERM, ...) like chokidar's errors.
+      nativeWatcher.add(p, depth)
+    } else {
+      this.getOrCreateWatcher(depth).add(p)
+    }
     this.watchedPaths.add(p)
     fileSystemWatcherLog.info(`Now watching path: ${p} with depth: ${depth}`)
   }
@@ -284,6 +397,11 @@ export class FileSystemWatcherModule extends BaseModule {
       fileSystemWatcherLog.info(`Watcher with depth ${depth} stopped.`)
     })
     this.watchers.clear()
+    if (this.nativeWatcher) {
+      this.nativeWatcher.close()
+      fileSystemWatcherLog.info('Native directory watcher stopped.')
+    }
+    this.nativeWatcher = undefined
     this.watchedPaths.clear()
   }
 }
@@ -25,6 +25,7 @@ const { touchEventBusMock, TalexEventsMock } = vi.hoisted(() => ({
     FILE_CHANGED: 'FILE_CHANGED',
     FILE_UNLINKED: 'FILE_UNLINKED',
     FILE_WATCH_ROOT_RECOVERED: 'FILE_WATCH_ROOT_RECOVERED',
+    FILE_WATCH_OVERFLOWED: 'FILE_WATCH_OVERFLOWED',
     DIRECTORY_ADDED: 'DIRECTORY_ADDED',
     DIRECTORY_UNLINKED: 'DIRECTORY_UNLINKED'
   }
@@ -86,6 +87,7 @@ async function createRouter() {
     emit,
     routedTo,
     routeWatchEventWithResult,
+    runtime,
     appWindowMs: APP_WATCH_COALESCE_WINDOW_MS,
     fileWindowMs: FILE_WATCH_COALESCE_WINDOW_MS
   }
@@ -197,4 +199,17 @@ describe('IndexedSourceEventRouter watch coalescing', () => {
       expect.objectContaining({ path: '/Applications/Probe.app' })
     )
   })
+
+  it('rescans the subtree a watcher overflow lost events under', async () => {
+    const { emit, runtime, routeWatchEventWithResult, fileWindowMs } = await createRouter()
+
+    emit('FILE_WATCH_OVERFLOWED', '/home/demo/projects')
+    await settleWindows(fileWindowMs)
+
+    expect(runtime.reconcileSource).toHaveBeenCalledWith(FILE_SOURCE_ID, {
+      reason: 'watch-gap',
+      roots: [expect.objectContaining({ path: '/home/demo/projects', reason: 'watch-gap' })]
+    })
+    expect(routeWatchEventWithResult).not.toHaveBeenCalled()
+  })
 })
@@ -4,6 +4,7 @@ import type {
   IndexingWatchDeltaAction,
   IndexingWatchDeltaBasePayload
 } from '@talex-touch/utils/search'
+import type { IndexedSourceReconcileReason } from '@talex-touch/utils/search/indexing-source'
 import { IndexedSourceReconcileReasons } from '@talex-touch/utils/search/indexing-source'
 import { getLogger } from '@talex-touch/utils/common/logger'
 import { TalexEvents, touchEventBus } from '../../../core/eventbus/touch-event'
@@ -93,6 +94,7 @@ export class IndexedSourceEventRouter {
     touchEventBus.on(TalexEvents.FILE_CHANGED, this.handleFileAddedOrChanged)
     touchEventBus.on(TalexEvents.FILE_UNLINKED, this.handleFileUnlinked)
     touchEventBus.on(TalexEvents.FILE_WATCH_ROOT_RECOVERED, this.handleFileWatchRootRecovered)
+    touchEventBus.on(TalexEvents.FILE_WATCH_OVERFLOWED, this.handleFileWatchOverflowed)
     touchEventBus.on(TalexEvents.FILE_CHANGED, this.handleAppAddedOrChanged)
     touchEventBus.on(TalexEvents.FILE_ADDED, this.handleAppAddedOrChanged)
     touchEventBus.on(TalexEvents.FILE_UNLINKED, this.handleAppUnlinked)
@@ -109,6 +111,7 @@ export class IndexedSourceEventRouter {
     touchEventBus.off(TalexEvents.FILE_CHANGED, this.handleFileAddedOrChanged)
     touchEventBus.off(TalexEvents.FILE_UNLINKED, this.handleFileUnlinked)
     touchEventBus.off(TalexEvents.FILE_WATCH_ROOT_RECOVERED, this.handleFileWatchRootRecovered)
+    touchEventBus.off(TalexEvents.FILE_WATCH_OVERFLOWED, this.handleFileWatchOverflowed)
     touchEventBus.off(TalexEvents.FILE_CHANGED, this.handleAppAddedOrChanged)
     touchEventBus.off(TalexEvents.FILE_ADDED, this.handleAppAddedOrChanged)
     touchEventBus.off(TalexEvents.FILE_UNLINKED, this.handleAppUnlinked)
@@ -137,7 +140,16 @@ export class IndexedSourceEventRouter {
 
   private readonly handleFileWatchRootRecovered = (event: ITouchEvent): void => {
     const path = this.resolvePath(event)
-    if (path) void this.reconcileRecoveredRoot(path)
+    if (path) void this.reconcileRoot(path, IndexedSourceReconcileReasons.WatchRootRecovered)
+  }
+
+  /**
+   * The watcher lost events under this directory, so per-path deltas can no longer describe it;
+   * rescan the subtree instead.
+   */
+  private readonly handleFileWatchOverflowed = (event: ITouchEvent): void => {
+    const path = this.resolvePath(event)
+    if (path) void this.reconcileRoot(path, IndexedSourceReconcileReasons.WatchGap)
   }
 
   private readonly handleAppAddedOrChanged = (event: ITouchEvent): void => {
@@ -174,7 +186,7 @@ export class IndexedSourceEventRouter {
     }
   }
 
-  private async reconcileRecoveredRoot(path: string): Promise<void> {
+  private async reconcileRoot(path: string, reason: IndexedSourceReconcileReason): Promise<void> {
     const runtime = this.getRuntime()
     if (!runtime) return
     const event = {
@@ -187,18 +199,18 @@ export class IndexedSourceEventRouter {
     if (runtime.getSource(FILE_INDEXED_SOURCE_ID)?.shouldHandleWatchEvent?.(event) === false) return
     try {
       await runtime.reconcileSource(FILE_INDEXED_SOURCE_ID, {
-        reason: IndexedSourceReconcileReasons.WatchRootRecovered,
+        reason,
         roots: [
           {
             sourceId: FILE_INDEXED_SOURCE_ID,
             path,
             permissionState: 'granted',
-            reason: IndexedSourceReconcileReasons.WatchRootRecovered
+            reason
           }
         ]
       })
     } catch (error) {
-      log.warn('Recovered file watch root reconcile failed', { error, path })
+      log.warn('File watch root reconcile failed', { error, path, reason })
     }
   }
 }
@@ -6,13 +6,13 @@ import type {
 import type { LibSQLDatabase } from 'drizzle-orm/libsql'
 import type * as schema from '../../db/schema'
 import type { IClipboardItem } from '../clipboard'
+import type { OcrWorkerSource } from './ocr-worker'
 
 import { Buffer } from 'node:buffer'
 import { createHash } from 'node:crypto'
 import { existsSync } from 'node:fs'
 import { stat } from 'node:fs/promises'
 import path from 'node:path'
-import { Worker } from 'node:worker_threads'
 import { pollingService } from '@talex-touch/utils/common/utils/polling'
 import { getTuffTransportMain } from '@talex-touch/utils/transport/main'
 import { defineRawEvent } from '@talex-touch/utils/transport/event/builder'
@@ -37,6 +37,7 @@ import { tuffIntelligence } from '../ai/intelligence-sdk'
 import { windowManager } from '../box-tool/core-box/window'
 import { databaseModule } from '../database'
 import { notificationModule } from '../notification'
+import { ocrWorkerClient } from './ocr-worker-client'
 import {
   computeOcrConfigPersistSignature,
   getOcrConfigWriteLabel,
@@ -184,7 +185,6 @@ class OcrService {
 
   private channelRegistered = false
   private transportChannel: unknown = null
-  private resolvedWorkerPath: string | null = null
 
   private isWorkerOcrEnabled(): boolean {
     const raw = process.env.TUFF_OCR_WORKER_ENABLED
@@ -195,32 +195,6 @@ class OcrService {
     return process.env.NODE_ENV !== 'test'
   }
 
-  private resolveWorkerPath(): string {
-    if (this.resolvedWorkerPath && existsSync(this.resolvedWorkerPath)) {
-      return this.resolvedWorkerPath
-    }
-
-    const candidateSet = new Set<string>([path.join(__dirname, 'ocr-worker.js')])
-    const resourcesPath = process.resourcesPath
-    if (typeof resourcesPath === 'string' && resourcesPath.length > 0) {
-      candidateSet.add(
-        path.join(resourcesPath, 'app.asar.unpacked', 'out', 'main', 'ocr-worker.js')
-      )
-      candidateSet.add(path.join(resourcesPath, 'app.asar', 'out', 'main', 'ocr-worker.js'))
-      candidateSet.add(path.join(resourcesPath, 'out', 'main', 'ocr-worker.js'))
-    }
-    candidateSet.add(path.resolve(process.cwd(), 'out', 'main', 'ocr-worker.js'))
-
-    const candidates = Array.from(candidateSet)
-    const found = candidates.find((candidatePath) => existsSync(candidatePath))
-    if (!found) {
-      throw new Error(`[OCR Worker] Worker bundle missing. Tried: ${candidates.join(', ')}`)
-    }
-
-    this.resolvedWorkerPath = found
-    return found
-  }
-
   private shouldUseWorkerPath(
     source: IntelligenceVisionOcrPayload['source'],
     allowedProviderIds: string[]
@@ -248,9 +222,7 @@ class OcrService {
     parsed: { source: AgentJobPayload['source']; options: AgentJobPayload['options'] },
     source: IntelligenceVisionOcrPayload['source']
   ): Promise<IntelligenceInvokeResult<IntelligenceVisionOcrResult>> {
-    const workerPath = this.resolveWorkerPath()
-
-    const workerSource: AgentJobPayload['source'] =
+    const workerSource: OcrWorkerSource =
       source.type === 'file' && source.filePath
         ? { type: 'file', filePath: source.filePath }
         : source.type === 'data-url' && source.dataUrl
@@ -261,100 +233,39 @@ class OcrService {
 
     const startedAt = Date.now()
 
-    const workerResult = await new Promise<IntelligenceVisionOcrResult>((resolve, reject) => {
-      let settled = false
-      const worker = new Worker(workerPath, {
-        workerData: {
-          jobId,
-          clipboardId: job.clipboardId ?? null,
-          payloadHash: job.payloadHash ?? null,
-          source: workerSource,
-          options: {
-            language: parsed.options?.language || 'eng',
-            tesseditPagesegMode: parsed.options?.tesseditPagesegMode,
-            config: parsed.options?.config
-          }
-        }
-      })
-
-      const cleanup = () => {
-        clearTimeout(timeout)
-      }
-
-      const finishResolve = (result: IntelligenceVisionOcrResult) => {
-        if (settled) return
-        settled = true
-        cleanup()
-        resolve(result)
-      }
-
-      const finishReject = (error: unknown) => {
-        if (settled) return
-        settled = true
-        cleanup()
-        reject(error instanceof Error ? error : new Error(String(error)))
-      }
-
-      const timeout = setTimeout(() => {
-        void worker.terminate().catch(() => {})
-        finishReject(new Error(`[OCR Worker] Timeout after ${OCR_WORKER_TIMEOUT_MS}ms`))
-      }, OCR_WORKER_TIMEOUT_MS)
-
-      worker.once('message', (message: unknown) => {
-        const payload =
-          message && typeof message === 'object' ? (message as Record<string, unknown>) : null
-        if (!payload) {
-          void worker.terminate().catch(() => {})
-          finishReject(new Error('[OCR Worker] Invalid worker response payload'))
-          return
-        }
-
-        if (payload.status === 'success') {
-          const resultPayload =
-            payload.result && typeof payload.result === 'object'
-              ? (payload.result as Record<string, unknown>)
-              : {}
-          void worker.terminate().catch(() => {})
-          finishResolve({
-            text: typeof resultPayload.text === 'string' ? resultPayload.text : '',
-            confidence:
-              typeof resultPayload.confidence === 'number' ? resultPayload.confidence : undefined,
-            language:
-              typeof resultPayload.language === 'string' ? resultPayload.language : undefined,
-            blocks: Array.isArray(resultPayload.blocks)
-              ? (resultPayload.blocks as IntelligenceVisionOcrResult['blocks'])
-              : undefined,
-            engine:
-              resultPayload.engine === 'apple-vision' ||
-              resultPayload.engine === 'windows-ocr' ||
-              resultPayload.engine === 'cloud'
-                ? resultPayload.engine
-                : undefined,
-            durationMs:
-              typeof resultPayload.durationMs === 'number' ? resultPayload.durationMs : undefined,
-            raw: resultPayload.raw
-          })
-          return
-        }
-
-        const messageText =
-          typeof payload.error === 'string'
-            ? payload.error
-            : `[OCR Worker] Unknown worker error for job ${jobId}`
-        void worker.terminate().catch(() => {})
-        finishReject(new Error(messageText))
-      })
-
-      worker.once('error', (error) => {
-        finishReject(error)
-      })
-
-      worker.once('exit', (code) => {
-        if (code !== 0 && !settled) {
-          finishReject(new Error(`[OCR Worker] Exited with code ${code}`))
+    const resultPayload = await ocrWorkerClient.recognize(
+      {
+        jobId,
+        clipboardId: job.clipboardId ?? null,
+        payloadHash: job.payloadHash ?? null,
+        source: workerSource,
+        options: {
+          language: parsed.options?.language || 'eng',
+          tesseditPagesegMode: parsed.options?.tesseditPagesegMode,
+          config: parsed.options?.config
         }
-      })
-    })
+      },
+      OCR_WORKER_TIMEOUT_MS
+    )
+    const workerResult: IntelligenceVisionOcrResult = {
+      text: typeof resultPayload.text === 'string' ? resultPayload.text : '',
+      confidence:
+        typeof resultPayload.confidence === 'number' ? resultPayload.confidence : undefined,
+      language: typeof resultPayload.language === 'string' ? resultPayload.language : undefined,
+      blocks: Array.isArray(resultPayload.blocks)
+        ? (resultPayload.blocks as IntelligenceVisionOcrResult['blocks'])
+        : undefined,
+      engine:
+        resultPayload.engine === 'apple-vision' ||
+        resultPayload.engine === 'windows-ocr' ||
+        resultPayload.engine === 'tesseract' ||
+        resultPayload.engine === 'cloud'
+          ? resultPayload.engine
+          : undefined,
+      durationMs:
+        typeof resultPayload.durationMs === 'number' ? resultPayload.durationMs : undefined,
+      raw: resultPayload.raw
+    }
 
     return {
       result: workerResult,
@@ -0,0 +1,147 @@
+import { afterEach, beforeEach, describe, expect, it, vi } from 'vitest'
+
+const workerMock = vi.hoisted(() => {
+  type Handler = (payload: unknown) => void
+
+  const workers: MockWorker[] = []
+
+  class MockWorker {
+    readonly messages: unknown[] = []
+    terminateCalls = 0
+    private readonly handlers = new Map<string, Handler[]>()
+
+    constructor(readonly workerPath: string) {
+      workers.push(this)
+    }
+
+    on(event: string, handler: Handler): this {
+      const handlers = this.handlers.get(event) ?? []
+      handlers.push(handler)
+      this.handlers.set(event, handlers)
+      return this
+    }
+
+    unref(): void {}
+
+    postMessage(message: unknown): void {
+      this.messages.push(message)
+    }
+
+    emit(event: string, payload: unknown): void {
+      for (const handler of this.handlers.get(event) ?? []) {
+        handler(payload)
+      }
+    }
+
+    terminate(): Promise<number> {
+      this.terminateCalls += 1
+      return Promise.resolve(0)
+    }
+  }
+
+  return { MockWorker, workers }
+})
+
+vi.mock('node:worker_threads', () => ({
+  Worker: workerMock.MockWorker
+}))
+
+vi.mock('node:fs', () => ({
+  existsSync: () => true
+}))
+
+vi.mock('@talex-touch/utils/common/logger', () => ({
+  getLogger: () => ({
+    warn: vi.fn()
+  })
+}))
+
+import type { OcrWorkerJob } from './ocr-worker-client'
+import { OcrWorkerClient } from './ocr-worker-client'
+
+function job(jobId: number): OcrWorkerJob {
+  return {
+    jobId,
+    clipboardId: jobId,
+    payloadHash: null,
+    source: { type: 'file', filePath: `/tmp/ocr-${jobId}.png` },
+    options: { language: 'eng' }
+  }
+}
+
+function taskIdOf(message: unknown): string {
+  return String((message as { taskId: unknown }).taskId)
+}
+
+describe('OcrWorkerClient', () => {
+  beforeEach(() => {
+    workerMock.workers.length = 0
+  })
+
+  afterEach(() => {
+    vi.useRealTimers()
+  })
+
+  it('feeds every job to one long-lived worker', async () => {
+    const client = new OcrWorkerClient()
+    const first = client.recognize(job(1), 30_000)
+    const second = client.recognize(job(2), 30_000)
+
+    expect(workerMock.workers).toHaveLength(1)
+    const worker = workerMock.workers[0]
+    expect(worker.messages).toHaveLength(2)
+    expect(worker.messages[0]).toMatchObject({ type: 'recognize', jobId: 1 })
+
+    worker.emit('message', {
+      status: 'success',
+      taskId: taskIdOf(worker.messages[1]),
+      result: { text: 'second' }
+    })
+    worker.emit('message', {
+      status: 'error',
+      taskId: taskIdOf(worker.messages[0]),
+      error: 'no text'
+    })
+
+    await expect(second).resolves.toMatchObject({ text: 'second' })
+    await expect(first).rejects.toThrow('no text')
+
+    const third = client.recognize(job(3), 30_000)
+    expect(workerMock.workers).toHaveLength(1)
+    worker.emit('message', {
+      status: 'success',
+      taskId: taskIdOf(worker.messages[2]),
+      result: { text: 'third' }
+    })
+    await expect(third).resolves.toMatchObject({ text: 'third' })
+    expect(worker.terminateCalls).toBe(0)
+  })
+
+  it('cancels a timed-out job without tearing the worker down', async () => {
+    vi.useFakeTimers()
+    const client = new OcrWorkerClient()
+    const pending = client.recognize(job(1), 1_000)
+    const worker = workerMock.workers[0]
+    const assertion = expect(pending).rejects.toThrow('Timeout after 1000ms')
+
+    await vi.advanceTimersByTimeAsync(1_000)
+    await assertion
+
+    expect(worker.messages[1]).toEqual({ type: 'cancel', taskId: taskIdOf(worker.messages[0]) })
+    expect(worker.terminateCalls).toBe(0)
+  })
+
+  it('fails pending jobs when the worker dies and starts a new one on demand', async () => {
+    const client = new OcrWorkerClient()
+    const pending = client.recognize(job(1), 30_000)
+    const worker = workerMock.workers[0]
+
+    worker.emit('exit', 1)
+    await expect(pending).rejects.toThrow('Exited with code 1')
+    expect(worker.terminateCalls).toBe(1)
+
+    void client.recognize(job(2), 30_000).catch(() => {})
+    expect(workerMock.workers).toHaveLength(2)
+    client.shutdown()
+  })
+})
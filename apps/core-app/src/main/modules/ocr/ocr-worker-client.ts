@@ -0,0 +1,140 @@
+import type {
+  OcrWorkerRecognizeRequest,
+  OcrWorkerResponse,
+  OcrWorkerResult
+} from './ocr-worker'
+import { existsSync } from 'node:fs'
+import path from 'node:path'
+import { Worker } from 'node:worker_threads'
+import { getLogger } from '@talex-touch/utils/common/logger'
+
+interface PendingOcr {
+  resolve: (value: OcrWorkerResult) => void
+  reject: (error: Error) => void
+  timeout: ReturnType<typeof setTimeout>
+}
+
+export type OcrWorkerJob = Omit<OcrWorkerRecognizeRequest, 'type' | 'taskId'>
+
+const ocrLog = getLogger('ocr-service')
+
+/**
+ * One long-lived OCR worker fed jobs over postMessage. Loading the addon and probing OCR support
+ * happen once per worker rather than once per image, and the native engines stay warm between
+ * jobs. The worker is only replaced after it fails.
+ */
+export class OcrWorkerClient {
+  private worker: Worker | null = null
+  private pending = new Map<string, PendingOcr>()
+  private resolvedWorkerPath: string | null = null
+  private nextTaskId = 1
+
+  recognize(job: OcrWorkerJob, timeoutMs: number): Promise<OcrWorkerResult> {
+    const worker = this.ensureWorker()
+    const taskId = `ocr-${job.jobId}-${this.nextTaskId++}`
+
+    return new Promise<OcrWorkerResult>((resolve, reject) => {
+      // A timed-out job is cancelled rather than the worker torn down: recognition runs on native
+      // threads that terminating the worker would not stop anyway.
+      const timeout = setTimeout(() => {
+        this.pending.delete(taskId)
+        worker.postMessage({ type: 'cancel', taskId })
+        reject(new Error(`[OCR Worker] Timeout after ${timeoutMs}ms`))
+      }, timeoutMs)
+
+      this.pending.set(taskId, { resolve, reject, timeout })
+      const request: OcrWorkerRecognizeRequest = { type: 'recognize', taskId, ...job }
+      worker.postMessage(request)
+    })
+  }
+
+  shutdown(): void {
+    this.failPending(new Error('[OCR Worker] Shut down'))
+    this.terminateWorker()
+  }
+
+  private resolveWorkerPath(): string {
+    if (this.resolvedWorkerPath && existsSync(this.resolvedWorkerPath)) {
+      return this.resolvedWorkerPath
+    }
+
+    const candidateSet = new Set<string>([path.join(__dirname, 'ocr-worker.js')])
+    const resourcesPath = process.resourcesPath
+    if (typeof resourcesPath === 'string' && resourcesPath.length > 0) {
+      candidateSet.add(
+        path.join(resourcesPath, 'app.asar.unpacked', 'out', 'main', 'ocr-worker.js')
+      )
+      candidateSet.add(path.join(resourcesPath, 'app.asar', 'out', 'main', 'ocr-worker.js'))
+      candidateSet.add(path.join(resourcesPath, 'out', 'main', 'ocr-worker.js'))
+    }
+    candidateSet.add(path.resolve(process.cwd(), 'out', 'main', 'ocr-worker.js'))
+
+    const candidates = Array.from(candidateSet)
+    const found = candidates.find((candidatePath) => existsSync(candidatePath))
+    if (!found) {
+      throw new Error(`[OCR Worker] Worker bundle missing. Tried: ${candidates.join(', ')}`)
+    }
+
+    this.resolvedWorkerPath = found
+    return found
+  }
+
+  private ensureWorker(): Worker {
+    if (this.worker) {
+      return this.worker
+    }
+
+    const worker = new Worker(this.resolveWorkerPath())
+    worker.on('message', (message: OcrWorkerResponse) => this.handleMessage(message))
+    worker.on('error', (error) => this.handleWorkerError(worker, error))
+    worker.on('exit', (code) => {
+      if (code !== 0) {
+        this.handleWorkerError(worker, new Error(`[OCR Worker] Exited with code ${code}`))
+      }
+    })
+    // Idle between jobs; must not keep the app from quitting.
+    worker.unref()
+
+    this.worker = worker
+    return worker
+  }
+
+  private handleMessage(message: OcrWorkerResponse): void {
+    const pending = message && typeof message === 'object' ? this.pending.get(message.taskId) : null
+    if (!pending) {
+      return
+    }
+
+    this.pending.delete(message.taskId)
+    clearTimeout(pending.timeout)
+    if (message.status === 'success') {
+      pending.resolve(message.result)
+      return
+    }
+    pending.reject(new Error(message.error))
+  }
+
+  private handleWorkerError(worker: Worker, error: Error): void {
+    if (this.worker !== worker) {
+      return
+    }
+    this.failPending(error)
+    this.terminateWorker()
+    ocrLog.warn('[OCR Worker] Worker failed, will restart on demand', { error })
+  }
+
+  private failPending(error: Error): void {
+    for (const [, pending] of this.pending) {
+      clearTimeout(pending.timeout)
+      pending.reject(error)
+    }
+    this.pending.clear()
+  }
+
+  private terminateWorker(): void {
+    void this.worker?.terminate().catch(() => {})
+    this.worker = null
+  }
+}
+
+export const ocrWorkerClient = new OcrWorkerClient()
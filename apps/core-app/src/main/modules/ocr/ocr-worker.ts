@@ -1,16 +1,24 @@
-import { readFile } from 'node:fs/promises'
-import { parentPort, workerData } from 'node:worker_threads'
-import { getNativeOcrSupport, recognizeImageText } from '@talex-touch/tuff-native'
+import type {
+  NativeOcrImageSource,
+  NativeOcrResult,
+  NativeOcrService
+} from '@talex-touch/tuff-native'
+import { parentPort } from 'node:worker_threads'
+import { createOcrService, getNativeOcrSupport } from '@talex-touch/tuff-native'
 
-interface WorkerData {
+export interface OcrWorkerSource {
+  type: 'data-url' | 'file'
+  dataUrl?: string
+  filePath?: string
+}
+
+export interface OcrWorkerRecognizeRequest {
+  type: 'recognize'
+  taskId: string
   jobId: number
   clipboardId: number | null
   payloadHash: string | null
-  source: {
-    type: 'data-url' | 'file'
-    dataUrl?: string
-    filePath?: string
-  }
+  source: OcrWorkerSource
   options: {
     language: string
     tesseditPagesegMode?: number
@@ -18,75 +26,114 @@ interface WorkerData {
   }
 }
 
-interface WorkerSuccessMessage {
-  status: 'success'
-  jobId: number
-  result: {
-    text: string
-    confidence?: number
-    language?: string
-    blocks?: unknown[]
-    engine?: string
-    durationMs?: number
-    raw?: unknown
-  }
+export interface OcrWorkerCancelRequest {
+  type: 'cancel'
+  taskId: string
 }
 
-interface WorkerErrorMessage {
-  status: 'error'
-  jobId: number
-  error: string
-}
+export type OcrWorkerRequest = OcrWorkerRecognizeRequest | OcrWorkerCancelRequest
 
-function decodeDataUrl(dataUrl: string): Buffer {
-  const match = dataUrl.match(/^data:(.*?);base64,(.*)$/)
-  const base64 = match ? match[2] : dataUrl
-  return Buffer.from(base64, 'base64')
+export interface OcrWorkerResult {
+  text: string
+  confidence?: number
+  language?: string
+  blocks?: unknown[]
+  engine?: string
+  durationMs?: number
+  raw?: unknown
 }
 
-async function loadImageBuffer(source: WorkerData['source']): Promise<Buffer> {
+export type OcrWorkerResponse =
+  | { status: 'success'; taskId: string; result: OcrWorkerResult }
+  | { status: 'error'; taskId: string; error: string }
+
+/**
+ * Hands the source to the addon as is: files are memory-mapped and data URLs base64-decoded
+ * natively, off this thread and without a JS Buffer copy of the image.
+ */
+function toImageSource(source: OcrWorkerSource): NativeOcrImageSource {
   if (source.type === 'file') {
     if (!source.filePath) {
       throw new Error('Missing file path for OCR job')
     }
-    return readFile(source.filePath)
+    return { imagePath: source.filePath }
   }
 
   if (!source.dataUrl) {
     throw new Error('Missing image data for OCR job')
   }
 
-  return decodeDataUrl(source.dataUrl)
+  return { dataUrl: source.dataUrl }
 }
 
-async function run(): Promise<void> {
-  const payload = workerData as WorkerData
-  const language = payload.options.language || 'eng'
-  const buffer = await loadImageBuffer(payload.source)
+/**
+ * This worker lives as long as the client keeps it, so the addon is loaded and probed once and
+ * every job goes through the same native service.
+ */
+let service: NativeOcrService | null = null
+let unavailableReason: string | null = null
+const inFlight = new Map<string, AbortController>()
+
+function ensureService(): NativeOcrService | null {
+  if (service || unavailableReason) {
+    return service
+  }
 
   const support = getNativeOcrSupport()
   if (!support.supported) {
-    const message = `[OCR Worker] Native OCR unavailable on ${support.platform}: ${support.reason || 'unsupported'}`
-    const errorPayload: WorkerErrorMessage = {
-      status: 'error',
-      jobId: payload.jobId,
-      error: message
-    }
-    parentPort?.postMessage(errorPayload)
-    return
+    unavailableReason = `[OCR Worker] Native OCR unavailable on ${support.platform}: ${support.reason || 'unsupported'}`
+    return null
   }
 
+  service = createOcrService({ includeLayout: true, maxBlocks: 120 })
+  return service
+}
+
+function post(message: OcrWorkerResponse): void {
+  parentPort?.postMessage(message)
+}
+
+async function recognize(request: OcrWorkerRecognizeRequest): Promise<void> {
+  const controller = new AbortController()
+  inFlight.set(request.taskId, controller)
   try {
-    const recognized = await recognizeImageText({
-      image: buffer,
-      languageHint: language,
-      includeLayout: true,
-      maxBlocks: 120
-    })
+    const ocr = ensureService()
+    if (!ocr) {
+      post({ status: 'error', taskId: request.taskId, error: unavailableReason ?? 'unsupported' })
+      return
+    }
+
+    const language = request.options.language || 'eng'
+    const background = request.clipboardId !== null
+    let recognized: NativeOcrResult
+    try {
+      recognized = await ocr.recognize({
+        ...toImageSource(request.source),
+        languageHint: language,
+        // Clipboard OCR is catch-up work; keep it off the threads screenshots use.
+        priority: background ? 'background' : 'interactive',
+        // Most copied images are photos and artwork. Screenshots and explicit requests are
+        // recognized whatever the check would say.
+        textDetection: background,
+        signal: controller.signal
+      })
+    } catch (error) {
+      // Nothing to read is an answer, not a failure: recorded as empty text, it is neither
+      // retried nor handed to the provider fallback, which would OCR the image again.
+      if ((error as { code?: string } | null)?.code !== 'ERR_OCR_NO_TEXT') {
+        throw error
+      }
+      post({
+        status: 'success',
+        taskId: request.taskId,
+        result: { text: '', language, raw: { noText: true } }
+      })
+      return
+    }
 
-    const successPayload: WorkerSuccessMessage = {
+    post({
       status: 'success',
-      jobId: payload.jobId,
+      taskId: request.taskId,
       result: {
         text: recognized.text ?? '',
         confidence: recognized.confidence,
@@ -96,23 +143,24 @@ async function run(): Promise<void> {
         durationMs: recognized.durationMs,
         raw: recognized
       }
-    }
-    parentPort?.postMessage(successPayload)
+    })
   } catch (error) {
-    const errorPayload: WorkerErrorMessage = {
+    post({
       status: 'error',
-      jobId: payload.jobId,
+      taskId: request.taskId,
       error: error instanceof Error ? error.message : String(error)
-    }
-    parentPort?.postMessage(errorPayload)
+    })
+  } finally {
+    inFlight.delete(request.taskId)
   }
 }
 
-run().catch((error) => {
-  const payload: WorkerErrorMessage = {
-    status: 'error',
-    jobId: (workerData as WorkerData).jobId,
-    error: error instanceof Error ? error.message : String(error)
+parentPort?.on('message', (message: OcrWorkerRequest) => {
+  if (message.type === 'cancel') {
+    inFlight.get(message.taskId)?.abort()
+    return
+  }
+  if (message.type === 'recognize') {
+    void recognize(message)
   }
-  parentPort?.postMessage(payload)
 })
@@ -84,4 +84,28 @@ describe('perf context', () => {
       })
     })
   })
+
+  it('warns for native trace spans over the threshold only', async () => {
+    const { recordNativeTraceSpans } = await import('./perf-context')
+    recordNativeTraceSpans(
+      'everything',
+      {
+        spans: [
+          { stage: 'query', startedAt: 1000, durationMs: 250.4 },
+          { stage: 'marshal', startedAt: 1250, durationMs: 3 }
+        ],
+        dropped: 2
+      },
+      { warnMs: 100 }
+    )
+
+    expect(loggerMocks.warn).toHaveBeenCalledTimes(1)
+    expect(loggerMocks.warn).toHaveBeenCalledWith('Slow perf context', {
+      meta: expect.objectContaining({
+        label: 'Native.everything.query',
+        durationMs: 250,
+        droppedSpans: 2
+      })
+    })
+  })
 })
@@ -99,3 +99,36 @@ export function getPerfContextSnapshot(limit = 3): Array<{
     .sort((a, b) => b.durationMs - a.durationMs)
     .slice(0, Math.max(0, limit))
 }
+
+/** A span drained from a tuff-native addon's `drainNativeTraceSpans()`. */
+export interface NativeTraceSpan {
+  stage: string
+  /** Unix milliseconds. */
+  startedAt: number
+  durationMs: number
+}
+
+/**
+ * Reports native stages that ran slower than `warnMs` the way slow perf contexts are reported,
+ * labelled `Native.<source>.<stage>`. Native stages run off the event loop, so they are judged
+ * on duration alone.
+ */
+export function recordNativeTraceSpans(
+  source: string,
+  batch: { spans: NativeTraceSpan[]; dropped: number },
+  options: Pick<PerfContextOptions, 'warnMs'> = {}
+): void {
+  const warnMs = options.warnMs ?? CONTEXT_WARN_MS
+  for (const span of batch.spans) {
+    if (span.durationMs < warnMs) continue
+    perfContextLog.warn('Slow perf context', {
+      meta: {
+        label: `Native.${source}.${span.stage}`,
+        durationMs: Math.round(span.durationMs),
+        mode: 'native',
+        startedAt: Math.round(span.startedAt),
+        droppedSpans: batch.dropped || undefined
+      }
+    })
+  }
+}
@@ -2,6 +2,7 @@ import { Buffer } from 'node:buffer'
 import { existsSync, readFileSync } from 'node:fs'
 import process from 'node:process'
 import { fileURLToPath } from 'node:url'
+import { MessageChannel } from 'node:worker_threads'
 import * as nativeOcr from '@talex-touch/tuff-native'
 import { describe, expect, it } from 'vitest'
 
@@ -103,7 +104,7 @@ describe('tuff-native ocr smoke & contract', () => {
     })
 
     const normalizedText = result.text.toLowerCase()
-    expect(result.engine === 'apple-vision' || result.engine === 'windows-ocr').toBe(true)
+    expect(['apple-vision', 'windows-ocr', 'tesseract']).toContain(result.engine)
     expect(result.durationMs).toBeGreaterThanOrEqual(0)
     expect(normalizedText.length).toBeGreaterThan(0)
     expect(normalizedText).toContain('tuff')
@@ -111,6 +112,52 @@ describe('tuff-native ocr smoke & contract', () => {
     expect((result.blocks || []).length).toBeGreaterThan(0)
   })
 
+  it('returns the compact layout with word boxes in one transferable buffer', async () => {
+    const support = nativeOcr.getNativeOcrSupport()
+    if (!support.supported) {
+      expect(
+        REQUIRE_OCR,
+        `native OCR reported unsupported on ${process.platform} (${support.reason})`,
+      ).toBe(false)
+      return
+    }
+
+    const fixturePath = fileURLToPath(new URL('./fixtures/tuff-ocr-fixture.png', import.meta.url))
+    const result = await nativeOcr.recognizeImageText({
+      image: readFileSync(fixturePath),
+      includeWords: true,
+      compactLayout: true,
+    })
+
+    expect(result.blocks).toBeUndefined()
+    const layout = result.layout!
+    expect(layout.lines).toBeGreaterThan(0)
+    expect(layout.words).toBeGreaterThan(0)
+    for (const view of [layout.text, layout.lineText, layout.lineBoxes, layout.wordBoxes]) {
+      expect(view.buffer).toBe(layout.buffer)
+    }
+
+    const decoder = new TextDecoder()
+    const textOf = (ranges: Uint32Array, index: number): string => {
+      const offset = ranges[index * 2]
+      return decoder.decode(layout.text.subarray(offset, offset + ranges[index * 2 + 1]))
+    }
+    const lines = Array.from({ length: layout.lines }, (_, index) => textOf(layout.lineText, index))
+    expect(lines.join(' ').toLowerCase()).toContain('tuff')
+    expect(textOf(layout.wordText, 0).toLowerCase()).toContain('tuff')
+    expect(layout.wordBoxes[2]).toBeGreaterThan(0)
+    expect(layout.wordBoxes[3]).toBeGreaterThan(0)
+
+    const { port1, port2 } = new MessageChannel()
+    const received = new Promise<Float32Array>((resolve) => {
+      port2.once('message', resolve)
+    })
+    port1.postMessage(layout.wordBoxes, [layout.buffer])
+    expect(layout.buffer.byteLength).toBe(0)
+    expect((await received)[2]).toBeGreaterThan(0)
+    port1.close()
+  })
+
   it('survives repeated and concurrent calls on reused threads', async () => {
     const support = nativeOcr.getNativeOcrSupport()
     if (!support.supported) {
@@ -1,9 +1,25 @@
 {
+  "variables": {
+    "tuff_native_bench%": 0
+  },
   "targets": [
     {
       "target_name": "tuff_native_ocr",
       "sources": [
         "native/src/addon.cc",
+        "native/src/ocr_marshal.cc",
+        "native/src/common/base64.cc",
+        "native/src/common/image_preprocess.cc",
+        "native/src/common/js_string.cc",
+        "native/src/common/native_metrics.cc",
+        "native/src/common/ocr_engine_pool.cc",
+        "native/src/common/ocr_input.cc",
+        "native/src/common/ocr_layout.cc",
+        "native/src/common/ocr_result_cache.cc",
+        "native/src/common/ocr_session.cc",
+        "native/src/common/ocr_tiling.cc",
+        "native/src/common/text_detect.cc",
+        "native/src/common/utf_transcode.cc",
         "native/src/platform/stub/ocr_stub.cpp",
         "native/src/platform/stub/notification_stub.cpp",
         "native/src/platform/stub/app_icon_stub.cpp"
@@ -28,6 +44,20 @@
         "-std=c++17"
       ],
       "conditions": [
+        [
+          "OS==\"linux\"",
+          {
+            "sources!": [
+              "native/src/platform/stub/ocr_stub.cpp"
+            ],
+            "sources+": [
+              "native/src/platform/linux/tesseract_ocr.cpp"
+            ],
+            "libraries": [
+              "-ldl"
+            ]
+          }
+        ],
         [
           "OS==\"mac\"",
           {
@@ -102,7 +132,19 @@
     {
       "target_name": "tuff_native_everything",
       "sources": [
-        "native/src/everything/addon.cc"
+        "native/src/common/js_string.cc",
+        "native/src/common/native_metrics.cc",
+        "native/src/common/utf_transcode.cc",
+        "native/src/everything/addon.cc",
+        "native/src/everything/columnar_encoding.cc",
+        "native/src/everything/everything_sdk.cc",
+        "native/src/everything/result_cache.cc",
+        "native/src/everything/search_backend.cc",
+        "native/src/everything/search_executor.cc",
+        "native/src/everything/search_marshal.cc",
+        "native/src/everything/search_session.cc",
+        "native/src/everything/stat_batch.cc",
+        "native/src/everything/tree_scanner.cc"
       ],
       "include_dirs": [
         "<!@(node -p \"require('node-addon-api').include\")",
@@ -124,6 +166,20 @@
         "-std=c++17"
       ],
       "conditions": [
+        [
+          "OS==\"linux\"",
+          {
+            "sources+": [
+              "native/src/everything/fs_watcher.cc",
+              "native/src/everything/linux_index.cc",
+              "native/src/everything/locate_db.cc"
+            ],
+            "libraries": [
+              "-ldl",
+              "-lpthread"
+            ]
+          }
+        ],
         [
           "OS==\"mac\"",
           {
@@ -150,5 +206,91 @@
         ]
       ]
     }
+  ],
+  "conditions": [
+    [
+      "tuff_native_bench==1",
+      {
+        "targets": [
+          {
+            "target_name": "tuff_native_bench",
+            "sources": [
+              "native/src/bench/bench_addon.cc",
+              "native/src/ocr_marshal.cc",
+              "native/src/common/base64.cc",
+              "native/src/common/image_preprocess.cc",
+              "native/src/common/js_string.cc",
+              "native/src/common/native_metrics.cc",
+              "native/src/common/ocr_engine_pool.cc",
+              "native/src/common/ocr_input.cc",
+              "native/src/common/ocr_layout.cc",
+              "native/src/common/ocr_result_cache.cc",
+              "native/src/common/ocr_session.cc",
+              "native/src/common/ocr_tiling.cc",
+              "native/src/common/text_detect.cc",
+              "native/src/common/utf_transcode.cc",
+              "native/src/platform/stub/ocr_stub.cpp",
+              "native/src/everything/columnar_encoding.cc",
+              "native/src/everything/everything_sdk.cc",
+              "native/src/everything/search_marshal.cc"
+            ],
+            "include_dirs": [
+              "<!@(node -p \"require('node-addon-api').include\")",
+              "native/src"
+            ],
+            "dependencies": [
+              "<!(node -p \"require('node-addon-api').gyp\")"
+            ],
+            "defines": [
+              "NAPI_CPP_EXCEPTIONS"
+            ],
+            "cflags!": [
+              "-fno-exceptions"
+            ],
+            "cflags_cc!": [
+              "-fno-exceptions"
+            ],
+            "cflags_cc": [
+              "-std=c++17"
+            ],
+            "conditions": [
+              [
+                "OS==\"linux\"",
+                {
+                  "libraries": [
+                    "-ldl",
+                    "-lpthread"
+                  ]
+                }
+              ],
+              [
+                "OS==\"mac\"",
+                {
+                  "xcode_settings": {
+                    "CLANG_CXX_LANGUAGE_STANDARD": "c++17",
+                    "GCC_ENABLE_CPP_EXCEPTIONS": "YES"
+                  }
+                }
+              ],
+              [
+                "OS==\"win\"",
+                {
+                  "msvs_settings": {
+                    "VCCLCompilerTool": {
+                      "ExceptionHandling": 1,
+                      "AdditionalOptions": [
+                        "/std:c++20",
+                        "/EHsc",
+                        "/permissive-"
+                      ]
+                    }
+                  }
+                }
+              ]
+            ]
+          }
+        ]
+      }
+    ]
   ]
 }
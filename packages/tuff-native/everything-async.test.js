@@ -0,0 +1,221 @@
+'use strict'
+
+const assert = require('node:assert/strict')
+const fs = require('node:fs')
+const os = require('node:os')
+const path = require('node:path')
+const process = require('node:process')
+const test = require('node:test')
+
+// Drives searchAsync end to end against the stand-in SDK library built by
+// scripts/build-everything-stub.js. The stub logs every query that reaches it
+// and fails any query that overlaps another inside the SDK.
+const stubLibrary = path.join(
+  __dirname,
+  'build',
+  'fixtures',
+  process.platform === 'win32'
+    ? 'everything_sdk_stub.dll'
+    : process.platform === 'darwin'
+      ? 'libeverything_sdk_stub.dylib'
+      : 'libeverything_sdk_stub.so',
+)
+const stubLog = path.join(
+  fs.mkdtempSync(path.join(os.tmpdir(), 'tuff-everything-')),
+  'queries.log',
+)
+
+process.env.TALEX_EVERYTHING_DLL_PATH = stubLibrary
+process.env.TALEX_EVERYTHING_STUB_DELAY_MS = '60'
+process.env.TALEX_EVERYTHING_STUB_RESULTS = '5'
+process.env.TALEX_EVERYTHING_STUB_LOG = stubLog
+
+const everything = require('./everything.js')
+
+// These tests count the queries that reach the backend; repeated queries are
+// covered by everything-cache.test.js.
+everything.configureCache({ maxBytes: 0 })
+
+function readQueryLog() {
+  return fs.existsSync(stubLog)
+    ? fs.readFileSync(stubLog, 'utf8').split('\n').filter(Boolean)
+    : []
+}
+
+function resetQueryLog() {
+  fs.rmSync(stubLog, { force: true })
+}
+
+test('resolves rows from the SDK path with the shape of the synchronous search', async () => {
+  resetQueryLog()
+  const rows = await everything.searchAsync('report', { maxResults: 10 })
+
+  assert.equal(rows.length, 5)
+  assert.deepEqual(rows[0], {
+    fullPath: '/stub/report-0.txt',
+    path: '/stub',
+    name: 'report-0.txt',
+    filename: 'report-0.txt',
+    extension: 'txt',
+    size: 0,
+    dateModified: Date.UTC(2024, 0, 1),
+    dateCreated: Date.UTC(2024, 0, 1),
+    isFolder: false,
+  })
+  assert.equal(rows[4].isFolder, true)
+  assert.equal(rows[4].size, undefined)
+  assert.deepEqual(everything.search('report', { maxResults: 10 }), rows)
+  assert.equal(everything.getVersion(), '1.4.1.0')
+})
+
+test('a burst of queries on one channel runs only the first and the last', async () => {
+  resetQueryLog()
+  const pending = ['r', 're', 'rep', 'repo'].map(query =>
+    everything.searchAsync(query, { channel: 'typeahead' }).then(
+      rows => ({ rows }),
+      error => ({ error }),
+    ),
+  )
+  const settled = await Promise.all(pending)
+
+  for (const outcome of settled.slice(0, 3)) {
+    assert.equal(outcome.error?.code, 'ERR_EVERYTHING_SUPERSEDED')
+  }
+  assert.equal(settled[3].rows[0].name, 'repo-0.txt')
+  // 'r' may or may not have left the queue before 're' arrived; the middle two
+  // never reach the backend either way.
+  const log = readQueryLog()
+  assert.equal(log.at(-1), 'repo')
+  assert.equal(log.includes('re'), false)
+  assert.equal(log.includes('rep'), false)
+})
+
+test('channels do not supersede each other', async () => {
+  const [left, right] = await Promise.all([
+    everything.searchAsync('left', { channel: 'a' }),
+    everything.searchAsync('right', { channel: 'b' }),
+  ])
+
+  assert.equal(left[0].name, 'left-0.txt')
+  assert.equal(right[0].name, 'right-0.txt')
+})
+
+test('abort rejects immediately and keeps a queued query off the backend', async () => {
+  resetQueryLog()
+  const running = everything.searchAsync('first', { channel: 'x' })
+  const controller = new AbortController()
+  const aborted = everything.searchAsync('second', { channel: 'y' }, controller.signal)
+  controller.abort()
+
+  await assert.rejects(aborted, { name: 'AbortError' })
+  await running
+  assert.deepEqual(readQueryLog(), ['first'])
+
+  const reason = new Error('closed')
+  await assert.rejects(
+    everything.searchAsync('third', {}, AbortSignal.abort(reason)),
+    reason,
+  )
+})
+
+test('synchronous search shares the SDK lock with the executor', async () => {
+  const pending = everything.searchAsync('async', { channel: 'lock' })
+  const syncRows = everything.search('sync')
+  const asyncRows = await pending
+
+  assert.equal(syncRows[0].name, 'sync-0.txt')
+  assert.equal(asyncRows[0].name, 'async-0.txt')
+})
+
+test('columnar results decode to the same rows as the object format', async () => {
+  const objects = everything.search('col', { maxResults: 10 })
+  const syncView = everything.search('col', { maxResults: 10, format: 'columnar' })
+  const asyncView = await everything.searchAsync('col', { maxResults: 10, format: 'columnar' })
+
+  assert.ok(syncView instanceof everything.EverythingColumnarResults)
+  assert.deepEqual(syncView.toArray(), objects)
+  assert.deepEqual(asyncView.toArray(), objects)
+})
+
+test('fields narrows every row to the requested columns', async () => {
+  const fields = ['name', 'fullPath']
+  const rows = everything.search('proj', { fields })
+  const asyncRows = await everything.searchAsync('proj', { fields })
+  const view = everything.search('proj', { fields, format: 'columnar' })
+
+  assert.deepEqual(rows[0], {
+    fullPath: '/stub/proj-0.txt',
+    name: 'proj-0.txt',
+    filename: 'proj-0.txt',
+  })
+  assert.deepEqual(asyncRows, rows)
+  assert.deepEqual(view.toArray(), rows)
+  assert.equal(view.extension(0), undefined)
+})
+
+test('a search session answers narrowing keystrokes without the backend', async () => {
+  resetQueryLog()
+  const session = everything.createSearchSession()
+  const options = { maxResults: 10 }
+
+  const base = await session.searchAsync('memo', options)
+  const narrowed = await session.searchAsync('memo-3', options)
+  const sync = session.search('memo-1', { ...options, format: 'columnar' })
+
+  assert.equal(base.length, 5)
+  assert.deepEqual(narrowed.map(row => row.name), ['memo-3.txt'])
+  assert.deepEqual(sync.toArray(), [base[1]])
+  assert.deepEqual(readQueryLog(), ['memo'])
+  assert.deepEqual(session.getStats(), { backendQueries: 1, narrowedQueries: 2, cachedRows: 5 })
+
+  // Not an extension of 'memo': back to the backend, which becomes the base.
+  await session.searchAsync('mem', options)
+  assert.deepEqual(readQueryLog(), ['memo', 'mem'])
+
+  session.reset()
+  await session.searchAsync('memo', options)
+  assert.equal(readQueryLog().at(-1), 'memo')
+  assert.equal(session.getStats().backendQueries, 3)
+})
+
+test('a search session re-queries truncated or non-plain results', async () => {
+  resetQueryLog()
+  const session = everything.createSearchSession()
+
+  // Five rows fill maxResults, so the base may be missing matches.
+  await session.searchAsync('full', { maxResults: 5 })
+  await session.searchAsync('full-1', { maxResults: 5 })
+  await session.searchAsync('full-1*', { maxResults: 5 })
+
+  assert.deepEqual(readQueryLog(), ['full', 'full-1', 'full-1*'])
+  assert.equal(session.getStats().narrowedQueries, 0)
+})
+
+test('a search session leaves accented text to the backend whether or not it matches case', async () => {
+  resetQueryLog()
+  const session = everything.createSearchSession()
+
+  // Everything ignores diacritics separately from matchCase, so 'café-1' may
+  // match rows the 'café' base would filter out. The stub logs it as 'caf?'.
+  await session.searchAsync('café', { matchCase: true })
+  await session.searchAsync('café-1', { matchCase: true })
+  await session.searchAsync('café', {})
+  await session.searchAsync('café-1', {})
+  assert.deepEqual(readQueryLog(), ['caf?', 'caf?-1', 'caf?', 'caf?-1'])
+  assert.equal(session.getStats().narrowedQueries, 0)
+
+  // CJK has neither case nor diacritics and still narrows.
+  const base = await session.searchAsync('报告', {})
+  const narrowed = await session.searchAsync('报告-1', {})
+  assert.deepEqual(narrowed, [base[1]])
+  assert.equal(session.getStats().narrowedQueries, 1)
+})
+
+test('a search session is a latest-wins channel of its own', async () => {
+  const session = everything.createSearchSession()
+  const first = session.searchAsync('alpha', {}).catch(error => error)
+  const second = session.searchAsync('beta', {})
+
+  assert.equal((await first).code, 'ERR_EVERYTHING_SUPERSEDED')
+  assert.equal((await second)[0].name, 'beta-0.txt')
+})
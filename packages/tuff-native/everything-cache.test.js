@@ -0,0 +1,120 @@
+'use strict'
+
+const assert = require('node:assert/strict')
+const fs = require('node:fs')
+const os = require('node:os')
+const path = require('node:path')
+const process = require('node:process')
+const test = require('node:test')
+
+// Drives the native result cache against the stand-in SDK library built by
+// scripts/build-everything-stub.js, whose query log shows what reached the
+// backend.
+const stubLibrary = path.join(
+  __dirname,
+  'build',
+  'fixtures',
+  process.platform === 'win32'
+    ? 'everything_sdk_stub.dll'
+    : process.platform === 'darwin'
+      ? 'libeverything_sdk_stub.dylib'
+      : 'libeverything_sdk_stub.so',
+)
+const stubLog = path.join(
+  fs.mkdtempSync(path.join(os.tmpdir(), 'tuff-everything-cache-')),
+  'queries.log',
+)
+
+process.env.TALEX_EVERYTHING_DLL_PATH = stubLibrary
+process.env.TALEX_EVERYTHING_STUB_RESULTS = '5'
+process.env.TALEX_EVERYTHING_STUB_LOG = stubLog
+
+const everything = require('./everything.js')
+
+function readQueryLog() {
+  return fs.existsSync(stubLog)
+    ? fs.readFileSync(stubLog, 'utf8').split('\n').filter(Boolean)
+    : []
+}
+
+function resetCache(options = {}) {
+  everything.configureCache({ maxBytes: 16 * 1024 * 1024, ttlMs: 60000, ...options })
+  everything.invalidateCache()
+  fs.rmSync(stubLog, { force: true })
+}
+
+// Runs before resetCache() reconfigures anything. The Everything SDK reports
+// no changes, so the TTL is the only bound on how stale a hit can be.
+test('the cache is on by default with a TTL of at most a second', () => {
+  const stats = everything.getCacheStats()
+  assert.ok(stats.maxBytes > 0)
+  assert.ok(stats.ttlMs > 0 && stats.ttlMs <= 1000, `ttlMs ${stats.ttlMs}`)
+})
+
+test('a repeated query is answered from the cache in either format', async () => {
+  resetCache()
+  const before = everything.getCacheStats()
+
+  const rows = everything.search('notes', { maxResults: 10 })
+  const again = await everything.searchAsync('notes', { maxResults: 10 })
+  const view = everything.search('notes', { maxResults: 10, format: 'columnar' })
+
+  assert.deepEqual(again, rows)
+  assert.deepEqual(view.toArray(), rows)
+  assert.deepEqual(readQueryLog(), ['notes'])
+
+  const stats = everything.getCacheStats()
+  assert.equal(stats.hits - before.hits, 2)
+  assert.equal(stats.misses - before.misses, 1)
+  assert.equal(stats.entries, 1)
+  assert.ok(stats.bytes > 0)
+})
+
+test('the cache key covers every search option', () => {
+  resetCache()
+  everything.search('key', { maxResults: 10 })
+  everything.search('key', { maxResults: 10, sort: 4 })
+  everything.search('key', { maxResults: 10, fields: ['name'] })
+  everything.search('key', { maxResults: 10, matchCase: true })
+
+  assert.deepEqual(readQueryLog(), ['key', 'key', 'key', 'key'])
+})
+
+test('invalidateCache and the TTL send the next query to the backend', async () => {
+  resetCache()
+  everything.search('fresh')
+  everything.invalidateCache()
+  everything.search('fresh')
+  assert.equal(readQueryLog().length, 2)
+  assert.ok(everything.getCacheStats().invalidations >= 1)
+
+  everything.configureCache({ ttlMs: 20 })
+  await new Promise(resolve => setTimeout(resolve, 40))
+  everything.search('fresh')
+  assert.equal(readQueryLog().length, 3)
+  assert.ok(everything.getCacheStats().expirations >= 1)
+})
+
+test('a small budget evicts the least recently used results', () => {
+  resetCache({ maxBytes: 8 * 1024 })
+  for (let index = 0; index < 20; index += 1)
+    everything.search(`lru-${index}`)
+
+  const stats = everything.getCacheStats()
+  assert.ok(stats.evictions > 0)
+  assert.ok(stats.bytes <= stats.maxBytes)
+
+  fs.rmSync(stubLog, { force: true })
+  everything.search('lru-19')
+  everything.search('lru-0')
+  assert.deepEqual(readQueryLog(), ['lru-0'])
+})
+
+test('maxBytes 0 turns the cache off', () => {
+  resetCache({ maxBytes: 0 })
+  everything.search('off')
+  everything.search('off')
+
+  assert.deepEqual(readQueryLog(), ['off', 'off'])
+  assert.equal(everything.getCacheStats().entries, 0)
+})
@@ -0,0 +1,189 @@
+'use strict'
+
+// Reader for the `format: 'columnar'` encoding produced by
+// native/src/everything/columnar_encoding.cc. Keep the layout constants in
+// step with that file.
+
+const COLUMNAR_MAGIC = 0x43465554
+const COLUMNAR_VERSION = 1
+const HEADER_WORDS = 8
+
+const FULL_PATH = 0
+const PATH = 1
+const NAME = 2
+const EXTENSION = 3
+
+// kField* bits of the query's `fields` (header word 7); 0 in older encodings.
+const STRING_FIELD_BITS = [1 << 0, 1 << 1, 1 << 2, 1 << 3]
+const ALL_FIELDS = 0xFF
+
+const SIZE = 0
+const DATE_MODIFIED = 1
+const DATE_CREATED = 2
+
+const decoder = new TextDecoder()
+
+function createFormatError(message) {
+  const error = new Error(`Invalid columnar Everything result: ${message}`)
+  error.code = 'ERR_EVERYTHING_COLUMNAR_FORMAT'
+  return error
+}
+
+/**
+ * Lazy view over one columnar result set. Strings are decoded on first access
+ * and rows are materialized only when asked for, so rendering the first ten of
+ * five thousand results costs ten rows. Columns left out of `fields` read as
+ * undefined.
+ */
+class EverythingColumnarResults {
+  constructor(buffer) {
+    if (!(buffer instanceof ArrayBuffer) || buffer.byteLength < HEADER_WORDS * 4)
+      throw createFormatError('buffer too small')
+
+    const header = new Uint32Array(buffer, 0, HEADER_WORDS)
+    if (header[0] !== COLUMNAR_MAGIC)
+      throw createFormatError('bad magic')
+    if (header[1] !== COLUMNAR_VERSION)
+      throw createFormatError(`unsupported version ${header[1]}`)
+
+    const rowCount = header[2]
+    const heapByteLength = header[3]
+    const floatsOffset = header[4]
+    const folderBitsOffset = header[5]
+    const heapOffset = header[6]
+    if (heapOffset + heapByteLength > buffer.byteLength)
+      throw createFormatError('truncated buffer')
+
+    const bitsetBytes = Math.ceil(rowCount / 8)
+
+    this.buffer = buffer
+    this.length = rowCount
+    this._fields = header[7] || ALL_FIELDS
+    this._columns = new Uint32Array(buffer, HEADER_WORDS * 4, 8 * rowCount)
+    this._floats = new Float64Array(buffer, floatsOffset, 3 * rowCount)
+    this._folderBits = new Uint8Array(buffer, folderBitsOffset, bitsetBytes)
+    this._hasFolderBits = new Uint8Array(buffer, folderBitsOffset + bitsetBytes, bitsetBytes)
+    this._heap = new Uint8Array(buffer, heapOffset, heapByteLength)
+    this._rows = new Array(rowCount)
+  }
+
+  _string(column, index) {
+    if ((this._fields & STRING_FIELD_BITS[column]) === 0)
+      return undefined
+    const offset = this._columns[column * 2 * this.length + index]
+    const length = this._columns[(column * 2 + 1) * this.length + index]
+    return length === 0 ? '' : decoder.decode(this._heap.subarray(offset, offset + length))
+  }
+
+  _number(column, index) {
+    const value = this._floats[column * this.length + index]
+    return Number.isNaN(value) ? undefined : value
+  }
+
+  _checkIndex(index) {
+    if (!Number.isInteger(index) || index < 0 || index >= this.length)
+      throw new RangeError(`Row index ${index} is out of range`)
+  }
+
+  fullPath(index) {
+    this._checkIndex(index)
+    return this._string(FULL_PATH, index)
+  }
+
+  path(index) {
+    this._checkIndex(index)
+    return this._string(PATH, index)
+  }
+
+  name(index) {
+    this._checkIndex(index)
+    return this._string(NAME, index)
+  }
+
+  extension(index) {
+    this._checkIndex(index)
+    return this._string(EXTENSION, index)
+  }
+
+  size(index) {
+    this._checkIndex(index)
+    return this._number(SIZE, index)
+  }
+
+  dateModified(index) {
+    this._checkIndex(index)
+    return this._number(DATE_MODIFIED, index)
+  }
+
+  dateCreated(index) {
+    this._checkIndex(index)
+    return this._number(DATE_CREATED, index)
+  }
+
+  isFolder(index) {
+    this._checkIndex(index)
+    const mask = 1 << (index % 8)
+    if ((this._hasFolderBits[index >> 3] & mask) === 0)
+      return undefined
+    return (this._folderBits[index >> 3] & mask) !== 0
+  }
+
+  /** The row as `search()` would have returned it, built once and cached. */
+  get(index) {
+    this._checkIndex(index)
+    const cached = this._rows[index]
+    if (cached)
+      return cached
+
+    const row = {}
+    const fullPath = this._string(FULL_PATH, index)
+    if (fullPath !== undefined)
+      row.fullPath = fullPath
+    const path = this._string(PATH, index)
+    if (path !== undefined)
+      row.path = path
+    const name = this._string(NAME, index)
+    if (name !== undefined) {
+      row.name = name
+      row.filename = name
+    }
+    const extension = this._string(EXTENSION, index)
+    if (extension !== undefined)
+      row.extension = extension
+    const size = this._number(SIZE, index)
+    if (size !== undefined)
+      row.size = size
+    const dateModified = this._number(DATE_MODIFIED, index)
+    if (dateModified !== undefined)
+      row.dateModified = dateModified
+    const dateCreated = this._number(DATE_CREATED, index)
+    if (dateCreated !== undefined)
+      row.dateCreated = dateCreated
+    const isFolder = this.isFolder(index)
+    if (isFolder !== undefined)
+      row.isFolder = isFolder
+
+    this._rows[index] = row
+    return row
+  }
+
+  toArray() {
+    return Array.from({ length: this.length }, (_, index) => this.get(index))
+  }
+
+  * [Symbol.iterator]() {
+    for (let index = 0; index < this.length; index += 1)
+      yield this.get(index)
+  }
+}
+
+function decodeColumnarResults(buffer) {
+  return new EverythingColumnarResults(buffer)
+}
+
+module.exports = {
+  COLUMNAR_MAGIC,
+  COLUMNAR_VERSION,
+  EverythingColumnarResults,
+  decodeColumnarResults,
+}
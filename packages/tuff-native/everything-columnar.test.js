@@ -0,0 +1,144 @@
+'use strict'
+
+const assert = require('node:assert/strict')
+const test = require('node:test')
+
+const {
+  COLUMNAR_MAGIC,
+  COLUMNAR_VERSION,
+  EverythingColumnarResults,
+  decodeColumnarResults,
+} = require('./everything-columnar.js')
+
+// Mirrors native/src/everything/columnar_encoding.cc, minus the prefix/suffix
+// sharing: every string gets its own heap bytes, which the format allows.
+function encode(rows, fields = 0) {
+  const encoder = new TextEncoder()
+  const n = rows.length
+  const bitsetBytes = Math.ceil(n / 8)
+  const floatsOffset = (8 + 8 * n) * 4
+  const folderBitsOffset = floatsOffset + 3 * n * 8
+  const heapOffset = folderBitsOffset + 2 * bitsetBytes
+  const strings = rows.flatMap(row =>
+    [row.fullPath, row.path, row.name, row.extension].map(value => encoder.encode(value ?? '')))
+  const heapByteLength = strings.reduce((total, bytes) => total + bytes.length, 0)
+
+  const buffer = new ArrayBuffer(heapOffset + heapByteLength)
+  new Uint32Array(buffer, 0, 8).set([
+    COLUMNAR_MAGIC,
+    COLUMNAR_VERSION,
+    n,
+    heapByteLength,
+    floatsOffset,
+    folderBitsOffset,
+    heapOffset,
+    fields,
+  ])
+  const columns = new Uint32Array(buffer, 32, 8 * n)
+  const floats = new Float64Array(buffer, floatsOffset, 3 * n)
+  const bits = new Uint8Array(buffer, folderBitsOffset, 2 * bitsetBytes)
+  const heap = new Uint8Array(buffer, heapOffset, heapByteLength)
+
+  let cursor = 0
+  rows.forEach((row, index) => {
+    for (let column = 0; column < 4; column += 1) {
+      const bytes = strings[index * 4 + column]
+      heap.set(bytes, cursor)
+      columns[column * 2 * n + index] = cursor
+      columns[(column * 2 + 1) * n + index] = bytes.length
+      cursor += bytes.length
+    }
+    floats[index] = row.size ?? Number.NaN
+    floats[n + index] = row.dateModified ?? Number.NaN
+    floats[2 * n + index] = row.dateCreated ?? Number.NaN
+    if (row.isFolder !== undefined) {
+      bits[bitsetBytes + (index >> 3)] |= 1 << (index % 8)
+      if (row.isFolder)
+        bits[index >> 3] |= 1 << (index % 8)
+    }
+  })
+  return buffer
+}
+
+const rows = [
+  {
+    fullPath: '/home/me/报告.pdf',
+    path: '/home/me',
+    name: '报告.pdf',
+    extension: 'pdf',
+    size: 2048,
+    dateModified: 1700000000000,
+    dateCreated: 1690000000000,
+    isFolder: false,
+  },
+  {
+    fullPath: '/home/me/projects',
+    path: '/home/me',
+    name: 'projects',
+    extension: '',
+    isFolder: true,
+  },
+  {
+    fullPath: 'C:\\Data\\notes.txt',
+    path: 'C:\\Data',
+    name: 'notes.txt',
+    extension: 'txt',
+    size: 0,
+  },
+]
+
+test('reads every column back as the row search() would return', () => {
+  const view = decodeColumnarResults(encode(rows))
+
+  assert.ok(view instanceof EverythingColumnarResults)
+  assert.equal(view.length, 3)
+  assert.deepEqual(view.get(0), { ...rows[0], filename: rows[0].name })
+  assert.deepEqual(view.get(1), { ...rows[1], filename: rows[1].name })
+  assert.deepEqual(view.get(2), { ...rows[2], filename: rows[2].name })
+  assert.equal(view.size(1), undefined)
+  assert.equal(view.isFolder(2), undefined)
+  assert.equal(view.name(0), '报告.pdf')
+})
+
+test('caches materialized rows and iterates in order', () => {
+  const view = decodeColumnarResults(encode(rows))
+
+  assert.equal(view.get(1), view.get(1))
+  assert.deepEqual([...view].map(row => row.name), ['报告.pdf', 'projects', 'notes.txt'])
+  assert.deepEqual(view.toArray(), [...view])
+})
+
+test('omits string columns outside the query fields', () => {
+  const projected = [{ fullPath: '/a/b.txt', name: 'b.txt', isFolder: false }]
+  // fullPath | name | isFolder
+  const view = decodeColumnarResults(encode(projected, 0x01 | 0x04 | 0x80))
+
+  assert.deepEqual(view.get(0), {
+    fullPath: '/a/b.txt',
+    name: 'b.txt',
+    filename: 'b.txt',
+    isFolder: false,
+  })
+  assert.equal(view.path(0), undefined)
+  assert.equal(view.extension(0), undefined)
+})
+
+test('decodes an empty result set', () => {
+  const view = decodeColumnarResults(encode([]))
+
+  assert.equal(view.length, 0)
+  assert.deepEqual(view.toArray(), [])
+})
+
+test('rejects foreign buffers and out-of-range rows', () => {
+  assert.throws(() => decodeColumnarResults(new ArrayBuffer(4)), {
+    code: 'ERR_EVERYTHING_COLUMNAR_FORMAT',
+  })
+  assert.throws(() => decodeColumnarResults(new ArrayBuffer(64)), {
+    code: 'ERR_EVERYTHING_COLUMNAR_FORMAT',
+  })
+
+  const view = decodeColumnarResults(encode(rows))
+  assert.throws(() => view.get(3), RangeError)
+  assert.throws(() => view.name(-1), RangeError)
+})
@@ -0,0 +1,150 @@
+'use strict'
+
+const assert = require('node:assert/strict')
+const { spawnSync } = require('node:child_process')
+const fs = require('node:fs')
+const os = require('node:os')
+const path = require('node:path')
+const process = require('node:process')
+const test = require('node:test')
+
+// The Linux index is a process-wide singleton that reads its snapshot once,
+// on first use, so every load below runs in a fresh child process.
+const root = fs.mkdtempSync(path.join(os.tmpdir(), 'tuff-everything-index-'))
+const tree = path.join(root, 'tree')
+const snapshot = path.join(root, 'index.bin')
+fs.mkdirSync(path.join(tree, 'docs'), { recursive: true })
+for (const name of ['alpha.txt', 'alpha-notes.md', 'beta.txt'])
+  fs.writeFileSync(path.join(tree, 'docs', name), name)
+
+const childScript = `
+const everything = require(${JSON.stringify(path.join(__dirname, 'everything.js'))})
+const sleep = ms => new Promise(resolve => setTimeout(resolve, ms))
+;(async () => {
+  let status = everything.getIndexStatus()
+  for (let attempt = 0; status && status.state !== 'ready' && attempt < 500; attempt += 1) {
+    await sleep(10)
+    status = everything.getIndexStatus()
+  }
+  const rows = status && status.state === 'ready'
+    ? everything.search('alpha', { fields: ['fullPath', 'name', 'extension', 'dateCreated'] })
+    : []
+  process.stdout.write(JSON.stringify({ status, rows }))
+})()
+`
+
+function loadIndex(indexPath = snapshot, roots = tree) {
+  const child = spawnSync(process.execPath, ['-e', childScript], {
+    encoding: 'utf8',
+    env: {
+      ...process.env,
+      TALEX_EVERYTHING_INDEX_PATH: indexPath,
+      TALEX_EVERYTHING_INDEX_ROOTS: roots,
+    },
+  })
+  assert.equal(child.status, 0, child.stderr)
+  return JSON.parse(child.stdout)
+}
+
+// Offsets into the snapshot file; see SnapshotHeader and IndexEntry in
+// native/src/everything/linux_index.cc.
+const kEntriesOffset = 24
+const kHeapOffset = 32
+const kEntryCount = 16
+const kEntrySize = 40
+const kParentOffset = 8
+const kFlagsOffset = 30
+const kExtensionOffset = 32
+const kEntryRoot = 0x0002
+const kMaxWalkDepth = 256
+
+function corrupt(mutate) {
+  fs.writeFileSync(snapshot, mutate(fs.readFileSync(snapshot)))
+}
+
+const first = process.platform === 'linux' ? loadIndex() : { status: null }
+const skip = first.status === null
+
+function assertFindsAlpha(rows) {
+  assert.deepEqual(rows.map(row => row.name).sort(), ['alpha-notes.md', 'alpha.txt'])
+  const row = rows.find(entry => entry.name === 'alpha.txt')
+  assert.equal(row.fullPath, path.join(tree, 'docs', 'alpha.txt'))
+  assert.equal(row.extension, 'txt')
+}
+
+test('builds a snapshot and answers from it on the next load', { skip }, () => {
+  assert.equal(first.status.fromSnapshot, false)
+  assertFindsAlpha(first.rows)
+
+  const reloaded = loadIndex()
+  assert.equal(reloaded.status.fromSnapshot, true)
+  assertFindsAlpha(reloaded.rows)
+})
+
+test('reports the birth time as the created time where the filesystem has one', { skip }, () => {
+  const { rows } = loadIndex()
+  const file = path.join(tree, 'docs', 'alpha.txt')
+  const stats = fs.statSync(file)
+  const expected = stats.birthtimeMs > 0 ? stats.birthtimeMs : stats.ctimeMs
+  const row = rows.find(entry => entry.fullPath === file)
+  assert.equal(row.dateCreated, Math.floor(expected / 1000) * 1000)
+})
+
+const corruptions = {
+  'an extension offset past the end of its name': (image) => {
+    const entries = Number(image.readBigUInt64LE(kEntriesOffset))
+    image.writeUInt16LE(0xFFFF, entries + kEntrySize + kExtensionOffset)
+    return image
+  },
+  'a heap offset that wraps around': (image) => {
+    image.writeBigUInt64LE(0xFFFFFFFFFFFFFFF0n, kHeapOffset)
+    return image
+  },
+  'a truncated file': image => image.subarray(0, image.length - 16),
+}
+
+for (const [name, mutate] of Object.entries(corruptions)) {
+  test(`rejects a snapshot with ${name} and rebuilds it`, { skip }, () => {
+    loadIndex()
+    corrupt(mutate)
+
+    const rebuilt = loadIndex()
+    assert.equal(rebuilt.status.fromSnapshot, false)
+    assertFindsAlpha(rebuilt.rows)
+
+    // The rebuild replaced the damaged file.
+    const reloaded = loadIndex()
+    assert.equal(reloaded.status.fromSnapshot, true)
+    assertFindsAlpha(reloaded.rows)
+  })
+}
+
+test('rejects a snapshot whose parent chain is deeper than a walk can go', { skip }, () => {
+  // The walk stops kMaxWalkDepth entries below a root, so this tree yields
+  // the longest chain a snapshot may hold; `z.txt` comes after it.
+  const deepRoot = path.join(root, 'deep')
+  fs.mkdirSync(path.join(deepRoot, ...Array.from({ length: kMaxWalkDepth }, () => 'd')), { recursive: true })
+  fs.writeFileSync(path.join(deepRoot, 'z.txt'), 'z')
+  const deepSnapshot = path.join(root, 'deep.bin')
+  assert.equal(loadIndex(deepSnapshot, deepRoot).status.fromSnapshot, false)
+  assert.equal(loadIndex(deepSnapshot, deepRoot).status.fromSnapshot, true)
+
+  const image = fs.readFileSync(deepSnapshot)
+  const entries = Number(image.readBigUInt64LE(kEntriesOffset))
+  const count = Number(image.readBigUInt64LE(kEntryCount))
+  const depths = []
+  let deepest = 0
+  for (let i = 0; i < count; i += 1) {
+    const entry = entries + i * kEntrySize
+    const isRoot = (image.readUInt16LE(entry + kFlagsOffset) & kEntryRoot) !== 0
+    depths.push(isRoot ? 0 : depths[image.readUInt32LE(entry + kParentOffset)] + 1)
+    if (depths[i] > depths[deepest])
+      deepest = i
+  }
+  assert.equal(depths[deepest], kMaxWalkDepth)
+  assert.ok(deepest < count - 1)
+  image.writeUInt32LE(deepest, entries + (count - 1) * kEntrySize + kParentOffset)
+  fs.writeFileSync(deepSnapshot, image)
+
+  assert.equal(loadIndex(deepSnapshot, deepRoot).status.fromSnapshot, false)
+})
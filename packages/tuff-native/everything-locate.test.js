@@ -0,0 +1,210 @@
+'use strict'
+
+const assert = require('node:assert/strict')
+const { spawnSync } = require('node:child_process')
+const fs = require('node:fs')
+const os = require('node:os')
+const path = require('node:path')
+const process = require('node:process')
+const test = require('node:test')
+
+// Points the in-process locate reader at an mlocate database written here,
+// whose entries are real files so the rows survive the existence check.
+const root = fs.mkdtempSync(path.join(os.tmpdir(), 'tuff-everything-locate-'))
+const tree = {
+  [root]: [['Documents', 1], ['report.PDF', 0], ['notes.txt', 0]],
+  [path.join(root, 'Documents')]: [['Report-2024.docx', 0], ['budget.xlsx', 0]],
+}
+for (let index = 0; index < 600; index += 1)
+  tree[path.join(root, 'Documents')].push([`bulk-${index}.log`, 0])
+
+for (const [directory, entries] of Object.entries(tree)) {
+  fs.mkdirSync(directory, { recursive: true })
+  for (const [name, type] of entries) {
+    if (type === 0)
+      fs.writeFileSync(path.join(directory, name), name)
+  }
+}
+
+// mlocate format: big-endian header, then per directory a 12-byte header,
+// its path and one type byte + name per entry, closed by type 2.
+function writeMlocateDatabase(file) {
+  const parts = [Buffer.from('\0mlocate'), Buffer.alloc(8), Buffer.from('/\0')]
+  for (const [directory, entries] of Object.entries(tree)) {
+    parts.push(Buffer.alloc(16), Buffer.from(`${directory}\0`))
+    for (const [name, type] of entries)
+      parts.push(Buffer.from([type]), Buffer.from(`${name}\0`))
+    parts.push(Buffer.from([2]))
+  }
+  fs.writeFileSync(file, Buffer.concat(parts))
+}
+
+// plocate format (v1 header, max_version 2): the header at the top, a
+// config block, then the filename index of numDocids + 1 u64 offsets, each
+// docid a zstd frame of NUL-terminated paths. The frames are stored raw,
+// which needs no compressor here but is still read through libzstd.
+function zstdRawFrame(content) {
+  // Single segment with a 4-byte content size, then one last raw block.
+  const header = Buffer.from([0x28, 0xB5, 0x2F, 0xFD, 0xA0, 0, 0, 0, 0])
+  header.writeUInt32LE(content.length, 5)
+  const block = Buffer.alloc(3)
+  block.writeUIntLE(1 | (content.length << 3), 0, 3)
+  return Buffer.concat([header, block, content])
+}
+
+function writePlocateDatabase(file, { checkVisibility }) {
+  const headerSize = 112
+  const config = Buffer.from('prune_bind_mounts=1\0')
+  const frames = Object.entries(tree).map(([directory, entries]) =>
+    zstdRawFrame(Buffer.from(entries.map(([name]) => `${path.join(directory, name)}\0`).join(''))))
+  const indexOffset = headerSize + config.length
+  const index = Buffer.alloc((frames.length + 1) * 8)
+  let offset = indexOffset + index.length
+  frames.forEach((frame, docid) => {
+    index.writeBigUInt64LE(BigInt(offset), docid * 8)
+    offset += frame.length
+  })
+  index.writeBigUInt64LE(BigInt(offset), frames.length * 8)
+
+  const header = Buffer.alloc(headerSize)
+  header.write('\0plocate', 0, 'latin1')
+  header.writeUInt32LE(1, 8)
+  header.writeUInt32LE(frames.length, 20)
+  header.writeBigUInt64LE(BigInt(indexOffset), 32)
+  header.writeUInt32LE(2, 40)
+  header.writeBigUInt64LE(BigInt(config.length), 88)
+  header.writeBigUInt64LE(BigInt(headerSize), 96)
+  header.writeUInt8(checkVisibility ? 1 : 0, 104)
+  fs.writeFileSync(file, Buffer.concat([header, config, index, ...frames]))
+}
+
+const database = path.join(root, 'mlocate.db')
+writeMlocateDatabase(database)
+process.env.LOCATE_PATH = database
+
+const everything = require('./everything.js')
+
+const skip = process.platform !== 'linux' || everything.getLocateStatus() === null
+
+async function waitUntilReady() {
+  for (let attempt = 0; attempt < 200; attempt += 1) {
+    const status = everything.getLocateStatus()
+    if (status.state === 'ready' || status.state === 'error')
+      return status
+    await new Promise(resolve => setTimeout(resolve, 10))
+  }
+  return everything.getLocateStatus()
+}
+
+test('loads the database named by LOCATE_PATH', { skip }, async () => {
+  const status = await waitUntilReady()
+  assert.equal(status.state, 'ready')
+  assert.equal(status.format, 'mlocate')
+  assert.equal(status.databasePath, database)
+  assert.equal(status.directoryCount, 2)
+  assert.equal(status.entryCount, 605)
+})
+
+test('matches names by substring or prefix, paths with matchPath', { skip }, async () => {
+  await waitUntilReady()
+  const names = rows => rows.map(row => row.name).sort()
+
+  assert.deepEqual(names(everything.locate('report')), ['Report-2024.docx', 'report.PDF'])
+  assert.deepEqual(names(everything.locate('report', { matchCase: true })), ['report.PDF'])
+  assert.deepEqual(names(everything.locate('port', { prefix: true })), [])
+  assert.deepEqual(names(everything.locate('rep', { prefix: true })), ['Report-2024.docx', 'report.PDF'])
+  assert.deepEqual(
+    names(everything.locate('documents budget', { matchPath: true })),
+    ['budget.xlsx'],
+  )
+
+  const [row] = everything.locate('notes.txt')
+  assert.equal(row.fullPath, path.join(root, 'notes.txt'))
+  assert.equal(row.size, 'notes.txt'.length)
+  assert.equal(row.isFolder, false)
+})
+
+test('locateStream delivers batches and resolves with the row count', { skip }, async () => {
+  await waitUntilReady()
+  const batches = []
+  const count = await everything.locateStream('bulk-', { batchSize: 100 }, rows => batches.push(rows))
+
+  assert.equal(count, 600)
+  assert.equal(batches.length, 6)
+  assert.ok(batches.every(rows => rows.length === 100))
+})
+
+test('locateStream stops at maxResults when given one', { skip }, async () => {
+  await waitUntilReady()
+  const sizes = []
+  const count = await everything.locateStream(
+    'bulk-',
+    { batchSize: 100, maxResults: 150 },
+    rows => sizes.push(rows.length),
+  )
+
+  assert.equal(count, 150)
+  assert.deepEqual(sizes, [100, 50])
+})
+
+test('locateStream stops delivering once aborted', { skip }, async () => {
+  await waitUntilReady()
+  const controller = new AbortController()
+  let delivered = 0
+  const pending = everything.locateStream('bulk-', { batchSize: 1 }, (rows) => {
+    delivered += rows.length
+    controller.abort()
+  }, controller.signal)
+
+  await assert.rejects(pending, { name: 'AbortError' })
+  assert.ok(delivered <= 1)
+})
+
+// The reader is a process-wide singleton bound to LOCATE_PATH on first use,
+// so other databases are read in a child process.
+function locateStatusOf(file) {
+  const child = spawnSync(process.execPath, ['-e', `
+const everything = require(${JSON.stringify(require.resolve('./everything.js'))})
+;(async () => {
+  let status = everything.getLocateStatus()
+  for (let attempt = 0; status.state === 'loading' && attempt < 200; attempt += 1) {
+    await new Promise(resolve => setTimeout(resolve, 10))
+    status = everything.getLocateStatus()
+  }
+  const rows = status.state === 'ready' ? everything.locate('report', { fields: ['fullPath'] }) : []
+  process.stdout.write(JSON.stringify({ status, rows }))
+})()
+`], { encoding: 'utf8', env: { ...process.env, LOCATE_PATH: file } })
+  assert.equal(child.status, 0, child.stderr)
+  return JSON.parse(child.stdout)
+}
+
+test('reads check_visibility from byte 104 of a plocate header with a config block', { skip }, (t) => {
+  const visible = path.join(root, 'visible.plocate.db')
+  writePlocateDatabase(visible, { checkVisibility: false })
+  const { status, rows } = locateStatusOf(visible)
+  if (status.errorCode === 'ERR_LOCATE_ZSTD_UNAVAILABLE') {
+    t.skip('libzstd is not installed')
+    return
+  }
+
+  assert.equal(status.state, 'ready', status.lastError)
+  assert.equal(status.format, 'plocate')
+  assert.equal(status.checkVisibility, false)
+  assert.deepEqual(
+    rows.map(row => row.fullPath).sort(),
+    [path.join(root, 'Documents', 'Report-2024.docx'), path.join(root, 'report.PDF')],
+  )
+
+  const restricted = path.join(root, 'restricted.plocate.db')
+  writePlocateDatabase(restricted, { checkVisibility: true })
+  assert.equal(locateStatusOf(restricted).status.checkVisibility, true)
+})
+
+test('rejects queries the reader cannot answer', { skip }, async () => {
+  await waitUntilReady()
+  assert.throws(() => everything.locate('*.pdf'), { code: 'ERR_LOCATE_UNSUPPORTED_QUERY' })
+  assert.throws(() => everything.locate('report', { regex: true }), {
+    code: 'ERR_LOCATE_UNSUPPORTED_QUERY',
+  })
+})
@@ -0,0 +1,87 @@
+'use strict'
+
+const assert = require('node:assert/strict')
+const path = require('node:path')
+const process = require('node:process')
+const test = require('node:test')
+
+// Searches the stand-in SDK library built by scripts/build-everything-stub.js,
+// so the SDK stages run on every platform.
+process.env.TALEX_EVERYTHING_DLL_PATH = path.join(
+  __dirname,
+  'build',
+  'fixtures',
+  process.platform === 'win32'
+    ? 'everything_sdk_stub.dll'
+    : process.platform === 'darwin'
+      ? 'libeverything_sdk_stub.dylib'
+      : 'libeverything_sdk_stub.so',
+)
+process.env.TALEX_EVERYTHING_STUB_RESULTS = '5'
+
+const everything = require('./everything.js')
+
+test('stages are only timed while enabled; counters always count', () => {
+  everything.configureNativeMetrics({ enabled: false, traceCapacity: 0, reset: true })
+  everything.invalidateCache()
+  everything.search('untimed')
+
+  const metrics = everything.getNativeMetrics()
+  assert.equal(metrics.enabled, false)
+  assert.equal(metrics.counters.searches, 1)
+  assert.equal(metrics.stages.query.count, 0)
+  assert.deepEqual(everything.drainNativeTraceSpans(), { spans: [], dropped: 0 })
+})
+
+test('a search is split into query, row building and marshalling', async () => {
+  everything.configureNativeMetrics({ traceCapacity: 64, reset: true })
+  everything.configureCache({ maxBytes: 0 })
+  try {
+    everything.search('timed', { maxResults: 5 })
+    await everything.searchAsync('timed async', { maxResults: 5 })
+
+    const metrics = everything.getNativeMetrics()
+    assert.equal(metrics.enabled, true)
+    assert.equal(metrics.counters.searches, 2)
+    for (const stage of ['query', 'rowBuild', 'search', 'marshal']) {
+      assert.equal(metrics.stages[stage].count, 2, stage)
+    }
+    assert.equal(metrics.stages.queueWait.count, 1)
+    assert.equal(metrics.stages.cacheLookup.count, 0)
+    assert.equal(typeof metrics.queues.search, 'number')
+
+    const { spans } = everything.drainNativeTraceSpans()
+    assert.deepEqual(spans.map(span => span.stage).slice(0, 4), ['query', 'rowBuild', 'search', 'marshal'])
+    for (const span of spans) {
+      assert.ok(span.durationMs >= 0)
+      assert.ok(Math.abs(span.startedAt - Date.now()) < 60_000)
+    }
+  }
+  finally {
+    everything.configureCache({ maxBytes: 16 * 1024 * 1024 })
+    everything.configureNativeMetrics({ enabled: false, traceCapacity: 0 })
+  }
+})
+
+test('toggling and resizing the trace ring keeps tracing into the current one', () => {
+  everything.configureCache({ maxBytes: 0 })
+  try {
+    for (let round = 0; round < 200; round += 1) {
+      everything.configureNativeMetrics({ traceCapacity: round % 2 === 0 ? 64 : 128 })
+      everything.configureNativeMetrics({ traceCapacity: 0 })
+    }
+    everything.configureNativeMetrics({ traceCapacity: 64 })
+    everything.search('stale', { maxResults: 5 })
+    everything.configureNativeMetrics({ traceCapacity: 128 })
+    assert.equal(everything.getNativeMetrics().traceCapacity, 128)
+
+    // Spans left in the replaced ring are gone; the new one starts empty.
+    assert.deepEqual(everything.drainNativeTraceSpans(), { spans: [], dropped: 0 })
+    everything.search('fresh', { maxResults: 5 })
+    assert.ok(everything.drainNativeTraceSpans().spans.some(span => span.stage === 'query'))
+  }
+  finally {
+    everything.configureCache({ maxBytes: 16 * 1024 * 1024 })
+    everything.configureNativeMetrics({ enabled: false, traceCapacity: 0 })
+  }
+})
@@ -0,0 +1,126 @@
+'use strict'
+
+const assert = require('node:assert/strict')
+const fs = require('node:fs')
+const os = require('node:os')
+const path = require('node:path')
+const test = require('node:test')
+const { Worker } = require('node:worker_threads')
+
+const everything = require('./everything.js')
+
+const root = fs.mkdtempSync(path.join(os.tmpdir(), 'tuff-everything-scan-'))
+const expected = new Map()
+function writeFile(relative, size) {
+  const file = path.join(root, relative)
+  fs.mkdirSync(path.dirname(file), { recursive: true })
+  fs.writeFileSync(file, Buffer.alloc(size))
+  expected.set(file, size)
+}
+for (let directory = 0; directory < 20; directory += 1) {
+  for (let index = 0; index < 30; index += 1)
+    writeFile(path.join(`folder-${directory}`, `nested-${index % 3}`, `file-${index}.txt`), index)
+}
+writeFile('notes.md', 7)
+fs.mkdirSync(path.join(root, 'node_modules', 'pkg'), { recursive: true })
+fs.writeFileSync(path.join(root, 'node_modules', 'pkg', 'index.js'), '')
+fs.mkdirSync(path.join(root, '.hidden'))
+fs.writeFileSync(path.join(root, '.hidden', 'secret.txt'), '')
+fs.writeFileSync(path.join(root, 'Makefile'), '')
+fs.writeFileSync(path.join(root, 'draft.tmp'), '')
+
+async function collect(options) {
+  const entries = new Map()
+  const summary = await everything.scanTree([root], options, (batch) => {
+    assert.equal(batch.paths.length, batch.count)
+    for (let index = 0; index < batch.count; index += 1)
+      entries.set(batch.paths[index], { size: batch.size[index], type: batch.type[index] })
+  })
+  return { entries, summary }
+}
+
+test('finds every file with its size, pruning excluded directories', async () => {
+  const { entries, summary } = await collect({
+    batchSize: 64,
+    excludeNamesIgnoreCase: ['NODE_MODULES'],
+    requireExtension: true,
+    excludeExtensions: ['.TMP'],
+  })
+  assert.equal(summary.cancelled, false)
+  assert.equal(summary.errorCount, 0)
+  assert.equal(entries.size, expected.size)
+  for (const [file, size] of expected) {
+    assert.equal(entries.get(file)?.size, size, file)
+    assert.equal(entries.get(file)?.type, everything.SCAN_FILE)
+  }
+  assert.equal(summary.entryCount, expected.size)
+})
+
+test('includeDirectories reports the walked directories', async () => {
+  const { entries } = await collect({ includeDirectories: true, skipHidden: false })
+  assert.equal(entries.get(path.join(root, 'folder-3'))?.type, everything.SCAN_DIRECTORY)
+  assert.ok(entries.has(path.join(root, '.hidden', 'secret.txt')))
+  assert.ok(entries.has(path.join(root, 'node_modules', 'pkg', 'index.js')))
+})
+
+test('a slow consumer still sees every batch', async () => {
+  let seen = 0
+  const summary = await everything.scanTree([root], { batchSize: 16, maxPendingBatches: 1 }, async (batch) => {
+    await new Promise(resolve => setTimeout(resolve, 1))
+    seen += batch.count
+  })
+  assert.equal(seen, summary.entryCount)
+})
+
+test('an error thrown by onBatch stops the scan and rejects with it', async () => {
+  const failure = new Error('consumer failed')
+  let calls = 0
+  await assert.rejects(
+    everything.scanTree([root], { batchSize: 8 }, () => {
+      calls += 1
+      throw failure
+    }),
+    error => error === failure,
+  )
+  assert.equal(calls, 1)
+})
+
+test('aborting a search on the main thread leaves a worker thread\'s scan running', async () => {
+  // Both realms load the addon; request ids must not collide across them.
+  const worker = new Worker(
+    `const { parentPort, workerData } = require('node:worker_threads')
+const everything = require(workerData.modulePath)
+let started = false
+everything.scanTree([workerData.root], { batchSize: 16, maxPendingBatches: 1 }, async () => {
+  if (!started) {
+    started = true
+    parentPort.postMessage({ started: true })
+  }
+  await new Promise(resolve => setTimeout(resolve, 2))
+}).then(summary => parentPort.postMessage({ summary }), error => parentPort.postMessage({ error: String(error) }))
+`,
+    { eval: true, workerData: { modulePath: require.resolve('./everything.js'), root } },
+  )
+  const finished = new Promise((resolve, reject) => {
+    worker.on('message', (message) => {
+      if (message.summary || message.error)
+        resolve(message)
+    })
+    worker.on('error', reject)
+  })
+  await new Promise(resolve => worker.once('message', resolve))
+
+  for (let index = 0; index < 10; index += 1) {
+    const controller = new AbortController()
+    const pending = everything.searchAsync('tuff', {}, controller.signal)
+    controller.abort()
+    await pending.catch(() => {})
+  }
+
+  const { summary, error } = await finished
+  await worker.terminate()
+  assert.equal(error, undefined)
+  assert.equal(summary.cancelled, false)
+  const { summary: reference } = await collect({ batchSize: 16 })
+  assert.equal(summary.entryCount, reference.entryCount)
+})
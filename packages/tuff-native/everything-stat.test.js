@@ -0,0 +1,64 @@
+'use strict'
+
+const assert = require('node:assert/strict')
+const fs = require('node:fs')
+const os = require('node:os')
+const path = require('node:path')
+const test = require('node:test')
+
+const everything = require('./everything.js')
+
+const root = fs.mkdtempSync(path.join(os.tmpdir(), 'tuff-everything-stat-'))
+const file = path.join(root, 'notes.txt')
+fs.writeFileSync(file, 'twelve bytes')
+const directory = path.join(root, 'folder')
+fs.mkdirSync(directory)
+const missing = path.join(root, 'missing.txt')
+
+test('statBatch matches fs.stat column by column', async () => {
+  const result = await everything.statBatch([file, directory, missing])
+  assert.equal(result.count, 3)
+  assert.ok(result.size instanceof Float64Array)
+  assert.ok(result.flags instanceof Uint8Array)
+
+  const expected = fs.statSync(file)
+  assert.equal(result.size[0], 12)
+  assert.equal(result.errno[0], 0)
+  assert.equal(result.flags[0], everything.STAT_EXISTS | everything.STAT_FILE)
+  assert.ok(Math.abs(result.mtimeMs[0] - expected.mtimeMs) < 1)
+  assert.ok(Math.abs(result.ctimeMs[0] - expected.ctimeMs) < 1)
+
+  assert.equal(result.flags[1], everything.STAT_EXISTS | everything.STAT_DIRECTORY)
+
+  assert.equal(result.flags[2], 0)
+  assert.equal(result.errno[2], os.constants.errno.ENOENT)
+})
+
+test('a large batch keeps input order', async () => {
+  const paths = []
+  for (let index = 0; index < 300; index += 1) {
+    const entry = path.join(root, `bulk-${index}.bin`)
+    fs.writeFileSync(entry, Buffer.alloc(index))
+    paths.push(entry)
+  }
+
+  const result = await everything.statBatch(paths)
+  assert.equal(result.count, 300)
+  for (let index = 0; index < 300; index += 1)
+    assert.equal(result.size[index], index)
+})
+
+test('noFollow reports the link itself', { skip: process.platform === 'win32' }, async () => {
+  const link = path.join(root, 'link')
+  fs.symlinkSync(file, link)
+
+  const followed = await everything.statBatch([link])
+  const own = await everything.statBatch([link], { noFollow: true })
+  assert.equal(followed.flags[0], everything.STAT_EXISTS | everything.STAT_FILE)
+  assert.equal(own.flags[0], everything.STAT_EXISTS | everything.STAT_SYMLINK)
+})
+
+test('rejects anything but an array of strings', async () => {
+  assert.throws(() => everything.statBatch('nope'), { code: 'ERR_INVALID_ARGUMENT' })
+  assert.throws(() => everything.statBatch([file, 42]), { code: 'ERR_INVALID_ARGUMENT' })
+})
@@ -0,0 +1,140 @@
+'use strict'
+
+const assert = require('node:assert/strict')
+const fs = require('node:fs')
+const os = require('node:os')
+const path = require('node:path')
+const process = require('node:process')
+const test = require('node:test')
+
+const everything = require('./everything.js')
+
+function nativeWatcherAvailable() {
+  try {
+    everything.createDirectoryWatcher(() => {}).close()
+    return true
+  }
+  catch {
+    return false
+  }
+}
+
+const skip = process.platform !== 'linux' || !nativeWatcherAvailable()
+
+// Collects batches until `predicate` holds for everything seen so far.
+function watchTree(root, options) {
+  const events = []
+  const waiters = []
+  const watcher = everything.createDirectoryWatcher((batch) => {
+    events.push(...batch)
+    for (const waiter of waiters.splice(0))
+      waiter()
+  }, { latencyMs: 20, ...options })
+  watcher.add(root, 4)
+
+  const until = predicate => new Promise((resolve, reject) => {
+    const deadline = setTimeout(() => reject(new Error(`timed out with ${JSON.stringify(events)}`)), 5000)
+    const check = () => {
+      if (predicate(events)) {
+        clearTimeout(deadline)
+        resolve(events)
+      }
+      else {
+        waiters.push(check)
+      }
+    }
+    check()
+  })
+  return { watcher, events, until }
+}
+
+const has = (events, action, rawPath) =>
+  events.some(event => event.action === action && event.rawPath === rawPath)
+
+test('reports added, changed and deleted files', { skip }, async (t) => {
+  const root = fs.mkdtempSync(path.join(os.tmpdir(), 'tuff-everything-watch-'))
+  const session = watchTree(root, { backend: 'inotify' })
+  t.after(() => session.watcher.close())
+
+  const file = path.join(root, 'notes.txt')
+  fs.writeFileSync(file, 'first')
+  await session.until(events => has(events, 'add', file))
+
+  session.events.length = 0
+  fs.appendFileSync(file, 'second')
+  await session.until(events => has(events, 'change', file))
+
+  session.events.length = 0
+  fs.rmSync(file)
+  await session.until(events => has(events, 'delete', file))
+  assert.equal(session.watcher.getStats().backend, 'inotify')
+})
+
+test('a file created and removed within one batch is dropped', { skip }, async (t) => {
+  const root = fs.mkdtempSync(path.join(os.tmpdir(), 'tuff-everything-watch-'))
+  const session = watchTree(root, { backend: 'inotify', latencyMs: 200 })
+  t.after(() => session.watcher.close())
+
+  const transient = path.join(root, 'transient.tmp')
+  const marker = path.join(root, 'marker.txt')
+  fs.writeFileSync(transient, 'x')
+  fs.rmSync(transient)
+  fs.writeFileSync(marker, 'x')
+
+  const events = await session.until(seen => has(seen, 'add', marker))
+  assert.ok(!events.some(event => event.rawPath === transient))
+})
+
+test('a directory moved in reports its contents', { skip }, async (t) => {
+  const root = fs.mkdtempSync(path.join(os.tmpdir(), 'tuff-everything-watch-'))
+  const outside = fs.mkdtempSync(path.join(os.tmpdir(), 'tuff-everything-watch-src-'))
+  fs.mkdirSync(path.join(outside, 'nested'))
+  fs.writeFileSync(path.join(outside, 'nested', 'deep.txt'), 'x')
+  const session = watchTree(root, { backend: 'inotify' })
+  t.after(() => session.watcher.close())
+
+  const moved = path.join(root, 'moved')
+  fs.renameSync(outside, moved)
+  const deep = path.join(moved, 'nested', 'deep.txt')
+  const events = await session.until(seen => has(seen, 'add', deep))
+  assert.ok(events.some(event => event.rawPath === moved && event.isDirectory))
+
+  // The moved-in tree is watched too.
+  const later = path.join(moved, 'nested', 'later.txt')
+  fs.writeFileSync(later, 'x')
+  await session.until(seen => has(seen, 'add', later))
+})
+
+test('removing an enclosing root keeps a nested root watched', { skip }, async (t) => {
+  const root = fs.mkdtempSync(path.join(os.tmpdir(), 'tuff-everything-watch-'))
+  const inner = path.join(root, 'inner')
+  fs.mkdirSync(path.join(inner, 'deep'), { recursive: true })
+  const session = watchTree(root, { backend: 'inotify' })
+  t.after(() => session.watcher.close())
+  session.watcher.add(inner, 4)
+
+  session.watcher.remove(root)
+  // Removal is applied on the watcher thread; inner and inner/deep remain.
+  const deadline = Date.now() + 5000
+  while (session.watcher.getStats().watches !== 2) {
+    assert.ok(Date.now() < deadline, JSON.stringify(session.watcher.getStats()))
+    await new Promise(resolve => setTimeout(resolve, 10))
+  }
+
+  const outside = path.join(root, 'outside.txt')
+  const deep = path.join(inner, 'deep', 'kept.txt')
+  fs.writeFileSync(outside, 'x')
+  fs.writeFileSync(deep, 'x')
+  const events = await session.until(seen => has(seen, 'add', deep))
+  assert.ok(!events.some(event => event.rawPath === outside))
+})
+
+test('add reports the errno name of an unwatchable root', { skip }, (t) => {
+  const watcher = everything.createDirectoryWatcher(() => {})
+  t.after(() => watcher.close())
+
+  const missing = path.join(os.tmpdir(), `tuff-everything-watch-missing-${process.pid}`)
+  assert.throws(() => watcher.add(missing), { code: 'ENOENT' })
+  watcher.close()
+  assert.throws(() => watcher.add(os.tmpdir()), { code: 'ERR_EVERYTHING_WATCHER_CLOSED' })
+})
@@ -1,3 +1,15 @@
+import type { NativeMetrics, NativeMetricsOptions, NativeTraceSpanBatch } from './index'
+
+export type EverythingSearchField =
+  | 'fullPath'
+  | 'path'
+  | 'name'
+  | 'extension'
+  | 'size'
+  | 'dateModified'
+  | 'dateCreated'
+  | 'isFolder'
+
 export interface EverythingSearchOptions {
   maxResults?: number
   offset?: number
@@ -6,8 +18,20 @@ export interface EverythingSearchOptions {
   matchCase?: boolean
   matchPath?: boolean
   matchWholeWord?: boolean
+  /**
+   * Columns to fetch; the rest are never requested from the backend and are
+   * left unset on the result. Defaults to all of them.
+   */
+  fields?: EverythingSearchField[]
+  /**
+   * `'columnar'` returns one packed buffer behind a lazy
+   * `EverythingColumnarResults` view instead of an array of objects.
+   */
+  format?: 'objects' | 'columnar'
 }
 
+export type EverythingColumnarSearchOptions = EverythingSearchOptions & { format: 'columnar' }
+
 export interface EverythingSearchResult {
   fullPath?: string
   path?: string
@@ -23,14 +47,403 @@ export interface EverythingSearchResult {
   createdAt?: number | string | Date
 }
 
+export interface EverythingColumnarRow {
+  fullPath?: string
+  path?: string
+  name?: string
+  filename?: string
+  extension?: string
+  size?: number
+  dateModified?: number
+  dateCreated?: number
+  isFolder?: boolean
+}
+
+/**
+ * Lazy view over a columnar result set. Per-column accessors decode a single
+ * value; `get` builds (and caches) the row `search` would have returned.
+ */
+export declare class EverythingColumnarResults implements Iterable<EverythingColumnarRow> {
+  private constructor(buffer: ArrayBuffer)
+  readonly buffer: ArrayBuffer
+  readonly length: number
+  fullPath(index: number): string | undefined
+  path(index: number): string | undefined
+  name(index: number): string | undefined
+  extension(index: number): string | undefined
+  size(index: number): number | undefined
+  dateModified(index: number): number | undefined
+  dateCreated(index: number): number | undefined
+  isFolder(index: number): boolean | undefined
+  get(index: number): EverythingColumnarRow
+  toArray(): EverythingColumnarRow[]
+  [Symbol.iterator](): Iterator<EverythingColumnarRow>
+}
+
+export declare function search(
+  query: string,
+  options: EverythingColumnarSearchOptions,
+): EverythingColumnarResults
 export declare function search(
   query: string,
   options?: EverythingSearchOptions,
 ): EverythingSearchResult[]
 
+export declare function query(
+  query: string,
+  options: EverythingColumnarSearchOptions,
+): EverythingColumnarResults
 export declare function query(
   query: string,
   options?: EverythingSearchOptions,
 ): EverythingSearchResult[]
 
+export interface EverythingAsyncSearchOptions extends EverythingSearchOptions {
+  /**
+   * Latest-wins group. A call supersedes every unsettled call on the same
+   * channel, which then rejects with code `ERR_EVERYTHING_SUPERSEDED`.
+   * Defaults to one shared channel.
+   */
+  channel?: string
+}
+
+/**
+ * Runs the query off the main thread. Rejects with `ERR_EVERYTHING_SUPERSEDED`
+ * when a newer call on the same channel replaced it, and with the signal's
+ * reason (or an `AbortError`) when `signal` aborts.
+ */
+export declare function searchAsync(
+  query: string,
+  options: EverythingAsyncSearchOptions & { format: 'columnar' },
+  signal?: AbortSignal,
+): Promise<EverythingColumnarResults>
+export declare function searchAsync(
+  query: string,
+  options?: EverythingAsyncSearchOptions,
+  signal?: AbortSignal,
+): Promise<EverythingSearchResult[]>
+
+export interface EverythingSearchSessionStats {
+  backendQueries: number
+  narrowedQueries: number
+  /** Rows in the base result that later keystrokes are filtered from. */
+  cachedRows: number
+}
+
+export interface EverythingSearchSession {
+  search(query: string, options: EverythingColumnarSearchOptions): EverythingColumnarResults
+  search(query: string, options?: EverythingSearchOptions): EverythingSearchResult[]
+  searchAsync(
+    query: string,
+    options: EverythingColumnarSearchOptions,
+    signal?: AbortSignal,
+  ): Promise<EverythingColumnarResults>
+  searchAsync(
+    query: string,
+    options?: EverythingSearchOptions,
+    signal?: AbortSignal,
+  ): Promise<EverythingSearchResult[]>
+  /** Drops the cached base result and supersedes this session's pending queries. */
+  reset(): void
+  getStats(): EverythingSearchSessionStats
+}
+
+/**
+ * Typeahead session. A query that extends the previous complete answer
+ * ("repo" -> "report", same options) is answered by filtering that answer in
+ * native memory; anything else goes to the backend. Queries within one session
+ * are latest-wins. Queries with accented, non-ASCII cased or fullwidth text are
+ * never narrowed, with or without `matchCase`, since the backend may fold them
+ * (Everything ignores diacritics regardless of case); CJK text is.
+ */
+export declare function createSearchSession(): EverythingSearchSession
+
+export interface EverythingCacheStats {
+  hits: number
+  misses: number
+  insertions: number
+  /** Dropped to stay under maxBytes, least recently used first. */
+  evictions: number
+  /** Dropped because they outlived ttlMs. */
+  expirations: number
+  /** Dropped by invalidateCache() or because the backend's data changed. */
+  invalidations: number
+  entries: number
+  bytes: number
+  maxBytes: number
+  ttlMs: number
+  generation: number
+  sourceGeneration: number
+}
+
+export interface EverythingCacheOptions {
+  /** Budget for cached results in bytes; 0 disables the cache. */
+  maxBytes?: number
+  /**
+   * How long a cached result is reused; 0 disables the cache. Defaults to
+   * 1000, since nothing else bounds staleness on the Everything SDK.
+   */
+  ttlMs?: number
+}
+
+/** Null when the addon predates the result cache. */
+export declare function getCacheStats(): EverythingCacheStats | null
+export declare function configureCache(options?: EverythingCacheOptions): EverythingCacheStats
+/** Drops every cached result, e.g. after the app saw files change. */
+export declare function invalidateCache(): void
+
+export type EverythingSearchStage =
+  | 'queueWait'
+  | 'cacheLookup'
+  | 'query'
+  | 'rowBuild'
+  | 'encodeColumnar'
+  | 'search'
+  | 'marshal'
+
+export type EverythingNativeMetrics = NativeMetrics<
+  EverythingSearchStage,
+  'searches' | 'failed' | 'superseded' | 'cancelled',
+  { search: number, running: boolean }
+>
+
+/** Process-wide search stage timings, counters and queue depth. Null without the native module. */
+export declare function getNativeMetrics(): EverythingNativeMetrics | null
+export declare function configureNativeMetrics(options?: NativeMetricsOptions): EverythingNativeMetrics
+/** Empty when not tracing or without the native module. */
+export declare function drainNativeTraceSpans(): NativeTraceSpanBatch<EverythingSearchStage>
+
 export declare function getVersion(): string | null
+
+export type EverythingIndexState = 'idle' | 'building' | 'ready' | 'refreshing'
+
+export interface EverythingIndexStatus {
+  state: EverythingIndexState
+  entryCount: number
+  scannedEntries: number
+  /** Unix millis of the build the live index came from; 0 before the first. */
+  builtAt: number
+  loadMs: number
+  buildMs: number
+  fromSnapshot: boolean
+  snapshotPath: string
+  roots: string[]
+  lastError?: string
+}
+
+export interface EverythingIndexOptions {
+  /** Absolute directories to index. Defaults to TALEX_EVERYTHING_INDEX_ROOTS, then $HOME. */
+  roots?: string[]
+  /** Absolute directories to skip, in addition to /proc, /sys, /dev and /run. */
+  excludes?: string[]
+  snapshotPath?: string
+}
+
+/** Linux only; null where `search` is not backed by the in-process index. */
+export declare function getIndexStatus(): EverythingIndexStatus | null
+
+/** Linux only. Starts a background rebuild and returns the status at the time of the call. */
+export declare function rebuildIndex(options?: EverythingIndexOptions): EverythingIndexStatus
+
+export type EverythingLocateState = 'unavailable' | 'loading' | 'ready' | 'error'
+
+export interface EverythingLocateStatus {
+  state: EverythingLocateState
+  databasePath: string
+  format: 'plocate' | 'mlocate' | ''
+  entryCount: number
+  directoryCount: number
+  /** Rows under directories this process cannot read are left out. */
+  checkVisibility: boolean
+  /** Unix millis of the database file the live copy was read from. */
+  databaseModified: number
+  loadMs: number
+  lastError?: string
+  /** `ERR_LOCATE_DB_UNREADABLE`, `ERR_LOCATE_DB_NOT_FOUND` or `ERR_LOCATE_DB_FORMAT`. */
+  errorCode?: string
+}
+
+export interface EverythingLocateOptions extends EverythingSearchOptions {
+  /** Every term must start the name (or the full path with `matchPath`). */
+  prefix?: boolean
+  /** Rows per `onBatch` call of `locateStream`. Defaults to 256. */
+  batchSize?: number
+}
+
+/** Linux only; null where the addon was built without the locate reader. */
+export declare function getLocateStatus(): EverythingLocateStatus | null
+
+/**
+ * Linux only. Answers from the system's plocate/mlocate database without
+ * spawning `locate`. Rejects regex, whole-word and wildcard queries with
+ * `ERR_LOCATE_UNSUPPORTED_QUERY`.
+ */
+export declare function locate(
+  query: string,
+  options: EverythingLocateOptions & { format: 'columnar' },
+): EverythingColumnarResults
+export declare function locate(
+  query: string,
+  options?: EverythingLocateOptions,
+): EverythingSearchResult[]
+
+/**
+ * Linux only. Streams rows to `onBatch` as they are found and resolves with
+ * the number delivered. Without `maxResults` every match is streamed, rather
+ * than the 50 a search stops at. Aborting stops the scan.
+ */
+export declare function locateStream(
+  query: string,
+  options: EverythingLocateOptions | undefined,
+  onBatch: (rows: EverythingSearchResult[]) => void,
+  signal?: AbortSignal,
+): Promise<number>
+
+export declare const STAT_EXISTS: 1
+export declare const STAT_DIRECTORY: 2
+export declare const STAT_FILE: 4
+export declare const STAT_SYMLINK: 8
+
+export interface EverythingStatBatch {
+  count: number
+  /** `'io_uring'`, `'statx'`, `'stat'` or `'win32'`: how this batch was resolved. */
+  engine: string
+  size: Float64Array
+  mtimeMs: Float64Array
+  /** Status change time; the last write on Windows. */
+  ctimeMs: Float64Array
+  /** 0 where the filesystem does not record it. */
+  birthtimeMs: Float64Array
+  /** 0 on success, otherwise the errno of the failed stat. */
+  errno: Int32Array
+  /** `STAT_*` bits. */
+  flags: Uint8Array
+}
+
+export interface EverythingStatBatchOptions {
+  /** Stat symlinks themselves, as `fs.lstat`. */
+  noFollow?: boolean
+}
+
+/**
+ * Stats every path on the addon's own thread in one call. All columns are
+ * views over one buffer and are indexed like `paths`.
+ */
+export declare function statBatch(
+  paths: string[],
+  options?: EverythingStatBatchOptions,
+): Promise<EverythingStatBatch>
+
+export declare const SCAN_FILE: 1
+export declare const SCAN_DIRECTORY: 2
+
+export interface EverythingTreeScanBatch {
+  count: number
+  paths: string[]
+  size: Float64Array
+  mtimeMs: Float64Array
+  /** Birth time where the filesystem records it, the status change time otherwise. */
+  ctimeMs: Float64Array
+  /** `SCAN_FILE` or `SCAN_DIRECTORY`. */
+  type: Uint8Array
+}
+
+export interface EverythingTreeScanOptions {
+  /** Scanner threads; 0 (default) is one per core, at most 8. */
+  threads?: number
+  /** Entries per batch. Defaults to 500. */
+  batchSize?: number
+  /** Batches handed to `onBatch` and not yet settled before the walk pauses. Defaults to 4. */
+  maxPendingBatches?: number
+  /** Report directories as entries too. */
+  includeDirectories?: boolean
+  /** Directories deeper than this below their root are not read. Defaults to 24. */
+  maxDepth?: number
+  /** Skip directories whose name starts with `.`. Defaults to true. */
+  skipHidden?: boolean
+  /** Absolute paths skipped with everything below them. */
+  excludePaths?: string[]
+  /** Directory names, compared exactly. */
+  excludeNames?: string[]
+  /** Directory names, compared ASCII case-insensitively. */
+  excludeNamesIgnoreCase?: string[]
+  /** Directory names only excluded directly below a filesystem root (`/usr`, `C:\Windows`). */
+  rootExcludeNamesIgnoreCase?: string[]
+  /** Directory name suffixes (`.app`), compared ASCII case-insensitively. */
+  excludeSuffixesIgnoreCase?: string[]
+  /** Skip files without an extension, as `path.extname` defines it. */
+  requireExtension?: boolean
+  /** File extensions, with the dot, compared ASCII case-insensitively. */
+  excludeExtensions?: string[]
+  /** Single characters; files whose name starts with one are skipped. */
+  excludeFilePrefixes?: string[]
+}
+
+export interface EverythingTreeScanSummary {
+  entryCount: number
+  directoryCount: number
+  /** Unreadable directories plus entries that could not be stat'ed. */
+  errorCount: number
+  threads: number
+  cancelled: boolean
+  durationMs: number
+}
+
+/**
+ * Walks `roots` natively on a work-stealing thread pool and delivers entries
+ * in batches, one `onBatch` call at a time. Aborting stops the walk.
+ */
+export declare function scanTree(
+  roots: string[],
+  options: EverythingTreeScanOptions | undefined,
+  onBatch: (batch: EverythingTreeScanBatch) => void | Promise<void>,
+  signal?: AbortSignal,
+): Promise<EverythingTreeScanSummary>
+
+export interface EverythingWatchEvent {
+  /** `overflow`: the kernel dropped events under `rawPath` (a root); rescan it. */
+  action: 'add' | 'change' | 'delete' | 'overflow'
+  rawPath: string
+  isDirectory: boolean
+}
+
+export interface EverythingWatcherOptions {
+  /** `auto` (default) picks fanotify when permitted, inotify otherwise. */
+  backend?: 'auto' | 'fanotify' | 'inotify'
+  /** How long a burst is coalesced before delivery. Defaults to 100. */
+  latencyMs?: number
+  /** Deliver early once a batch holds this many paths. Defaults to 1024. */
+  maxBatch?: number
+}
+
+export interface EverythingWatcherStats {
+  /** `'fanotify'`, `'inotify'`, or empty before the first `add`. */
+  backend: string
+  roots: number
+  /** Kernel watches held: one per directory (inotify) or per filesystem (fanotify). */
+  watches: number
+  rawEvents: number
+  deliveredEvents: number
+  batches: number
+  overflows: number
+  closed: boolean
+  lastError?: string
+}
+
+export interface EverythingDirectoryWatcher {
+  /**
+   * Watches `root` and `depth` levels below it (4 by default). Throws with
+   * `code` set to the errno name (`ENOENT`, `EACCES`, ...) when it cannot.
+   */
+  add(root: string, depth?: number): void
+  remove(root: string): void
+  /** Stops the watcher thread; no batch is delivered afterwards. */
+  close(): void
+  getStats(): EverythingWatcherStats
+}
+
+/** Linux only; throws `ERR_EVERYTHING_NATIVE_UNAVAILABLE` elsewhere. */
+export declare function createDirectoryWatcher(
+  onEvents: (events: EverythingWatchEvent[]) => void,
+  options?: EverythingWatcherOptions,
+): EverythingDirectoryWatcher
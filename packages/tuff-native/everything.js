@@ -1,5 +1,9 @@
 'use strict'
 
+const {
+  EverythingColumnarResults,
+  decodeColumnarResults,
+} = require('./everything-columnar')
 const { loadNativeBinding } = require('./native-loader')
 
 const { nativeBinding, loadError } = loadNativeBinding({
@@ -18,17 +22,194 @@ function createUnavailableError() {
   return error
 }
 
+// `format: 'columnar'` comes back from the addon as one ArrayBuffer.
+function wrapResults(results) {
+  return results instanceof ArrayBuffer ? decodeColumnarResults(results) : results
+}
+
 function search(query, options) {
   if (!nativeBinding || typeof nativeBinding.search !== 'function') {
     throw createUnavailableError()
   }
-  return nativeBinding.search(query, options || {})
+  return wrapResults(nativeBinding.search(query, options || {}))
 }
 
 function query(keyword, options) {
   return search(keyword, options)
 }
 
+// Only for addons built before nextRequestId(); ids counted here collide
+// with those of other realms (worker threads) in the same process.
+let fallbackRequestId = 1
+
+function allocateRequestId() {
+  if (typeof nativeBinding.nextRequestId === 'function')
+    return nativeBinding.nextRequestId()
+  const requestId = fallbackRequestId
+  fallbackRequestId = fallbackRequestId >= Number.MAX_SAFE_INTEGER ? 1 : fallbackRequestId + 1
+  return requestId
+}
+
+function createAbortError(signal) {
+  const reason = signal && signal.reason
+  if (reason instanceof Error)
+    return reason
+  const error = new Error('Everything search was aborted')
+  error.name = 'AbortError'
+  error.code = 'ERR_EVERYTHING_SEARCH_ABORTED'
+  return error
+}
+
+/**
+ * Runs the query on the addon's search thread. Queries sharing
+ * `options.channel` are latest-wins: a newer call rejects every older one that
+ * has not settled with code ERR_EVERYTHING_SUPERSEDED, and queued ones never
+ * reach the backend. Aborting `signal` rejects at once with the signal's
+ * reason (or an AbortError) and drops the query natively.
+ */
+function searchAsync(query, options, signal) {
+  if (!nativeBinding || typeof nativeBinding.searchAsync !== 'function') {
+    return Promise.reject(createUnavailableError())
+  }
+  return runAsync(
+    requestId => nativeBinding.searchAsync(query, options || {}, requestId),
+    signal,
+  )
+}
+
+function runAsync(start, signal) {
+  if (signal && signal.aborted) {
+    return Promise.reject(createAbortError(signal))
+  }
+
+  const requestId = allocateRequestId()
+
+  let pending
+  try {
+    pending = start(requestId).then(wrapResults)
+  }
+  catch (error) {
+    return Promise.reject(error)
+  }
+  if (!signal) {
+    return pending
+  }
+
+  return new Promise((resolve, reject) => {
+    const onAbort = () => {
+      nativeBinding.cancelSearch(requestId)
+      reject(createAbortError(signal))
+    }
+    signal.addEventListener('abort', onAbort, { once: true })
+    pending.then(
+      (rows) => {
+        signal.removeEventListener('abort', onAbort)
+        resolve(rows)
+      },
+      (error) => {
+        signal.removeEventListener('abort', onAbort)
+        reject(error)
+      },
+    )
+  })
+}
+
+/**
+ * Typeahead session: keeps the last complete backend answer natively and
+ * answers queries that only extend it ("repo" -> "report") by filtering that
+ * answer instead of querying again. Each session is its own latest-wins
+ * channel.
+ */
+function createSearchSession() {
+  if (!nativeBinding || typeof nativeBinding.SearchSession !== 'function') {
+    throw createUnavailableError()
+  }
+  const session = new nativeBinding.SearchSession()
+  return {
+    search(query, options) {
+      return wrapResults(session.search(query, options || {}))
+    },
+    searchAsync(query, options, signal) {
+      return runAsync(
+        requestId => session.searchAsync(query, options || {}, requestId),
+        signal,
+      )
+    },
+    reset() {
+      session.reset()
+    },
+    getStats() {
+      return session.getStats()
+    },
+  }
+}
+
+/**
+ * Counters of the native result cache that answers repeated queries (same
+ * query and options) without the backend. `generation` moves on with every
+ * invalidateCache(); `sourceGeneration` with every change the backend reports
+ * itself (a rebuilt Linux index).
+ */
+function getCacheStats() {
+  if (!nativeBinding || typeof nativeBinding.getCacheStats !== 'function') {
+    return null
+  }
+  return nativeBinding.getCacheStats()
+}
+
+/**
+ * Resizes the result cache; omitted keys keep their value and 0 for either
+ * disables it. Returns the stats after the change.
+ */
+function configureCache(options) {
+  if (!nativeBinding || typeof nativeBinding.configureCache !== 'function') {
+    throw createUnavailableError()
+  }
+  return nativeBinding.configureCache(options || {})
+}
+
+/**
+ * Drops every cached result. Call when files are known to have changed: the
+ * Everything SDK does not report changes, so otherwise a cached result can be
+ * up to `ttlMs` old.
+ */
+function invalidateCache() {
+  if (nativeBinding && typeof nativeBinding.invalidateCache === 'function') {
+    nativeBinding.invalidateCache()
+  }
+}
+
+/**
+ * Stage timings (queue wait, backend query, row building, marshalling, ...)
+ * and counters of every search in the process, with the executor's queue
+ * depth. Stages are only timed once configureNativeMetrics() enables them.
+ */
+function getNativeMetrics() {
+  if (!nativeBinding || typeof nativeBinding.getNativeMetrics !== 'function') {
+    return null
+  }
+  return nativeBinding.getNativeMetrics()
+}
+
+/**
+ * Turns stage timing on or off, and keeps the last `traceCapacity` spans for
+ * drainNativeTraceSpans(). Omitted keys keep their value.
+ */
+function configureNativeMetrics(options) {
+  if (!nativeBinding || typeof nativeBinding.configureNativeMetrics !== 'function') {
+    throw createUnavailableError()
+  }
+  return nativeBinding.configureNativeMetrics(options || {})
+}
+
+/** Takes the spans recorded since the last drain, oldest first. */
+function drainNativeTraceSpans() {
+  if (!nativeBinding || typeof nativeBinding.drainNativeTraceSpans !== 'function') {
+    return { spans: [], dropped: 0 }
+  }
+  return nativeBinding.drainNativeTraceSpans()
+}
+
 function getVersion() {
   if (!nativeBinding || typeof nativeBinding.getVersion !== 'function') {
     return null
@@ -37,8 +218,201 @@ function getVersion() {
   return typeof version === 'string' ? version : null
 }
 
+/**
+ * Status of the in-process file-name index that answers `search` on Linux.
+ * Returns null where there is no such index (Windows asks the Everything
+ * service; macOS has no backend here).
+ */
+function getIndexStatus() {
+  if (!nativeBinding || typeof nativeBinding.getIndexStatus !== 'function') {
+    return null
+  }
+  return nativeBinding.getIndexStatus()
+}
+
+/**
+ * Status of the in-process reader for the system's plocate/mlocate database.
+ * The first call starts loading it in the background. Null where the addon
+ * has no reader (anything but Linux).
+ */
+function getLocateStatus() {
+  if (!nativeBinding || typeof nativeBinding.getLocateStatus !== 'function') {
+    return null
+  }
+  return nativeBinding.getLocateStatus()
+}
+
+/**
+ * Answers a query from the locate database without spawning `locate`. Rows
+ * come in database order; `size` and the dates cost a stat per row and
+ * drop paths that no longer exist.
+ */
+function locate(query, options) {
+  if (!nativeBinding || typeof nativeBinding.locate !== 'function') {
+    throw createUnavailableError()
+  }
+  return wrapResults(nativeBinding.locate(query, options || {}))
+}
+
+/**
+ * Streams a locate query off the main thread: `onBatch` receives row arrays
+ * as they fill (`options.batchSize`, 256 by default) and the promise resolves
+ * with the number of rows delivered. Aborting stops the scan.
+ */
+function locateStream(query, options, onBatch, signal) {
+  if (!nativeBinding || typeof nativeBinding.locateAsync !== 'function') {
+    return Promise.reject(createUnavailableError())
+  }
+  let open = true
+  const deliver = (rows) => {
+    if (open)
+      onBatch(rows)
+  }
+  const pending = runAsync(
+    requestId => nativeBinding.locateAsync(query, options || {}, requestId, deliver),
+    signal,
+  )
+  // Batches already queued when the caller aborted are not delivered.
+  pending.catch(() => {}).finally(() => {
+    open = false
+  })
+  return pending
+}
+
+/**
+ * Rebuilds the Linux index in the background. The current index keeps
+ * answering until the new one has been written and mapped.
+ */
+function rebuildIndex(options) {
+  if (!nativeBinding || typeof nativeBinding.rebuildIndex !== 'function') {
+    throw createUnavailableError()
+  }
+  return nativeBinding.rebuildIndex(options || {})
+}
+
+/** Bits of `statBatch(...).flags`; a path that could not be stat'ed has none. */
+const STAT_EXISTS = 1
+const STAT_DIRECTORY = 2
+const STAT_FILE = 4
+const STAT_SYMLINK = 8
+
+/**
+ * Stats every path in one hop to the addon's stat thread instead of one libuv
+ * threadpool round trip per path. Resolves with one typed array per column,
+ * indexed like `paths`: `size`, `mtimeMs`, `ctimeMs`, `birthtimeMs`, `errno`
+ * (0 on success) and `flags` (STAT_*). `options.noFollow` stats symlinks
+ * themselves, as fs.lstat.
+ */
+function statBatch(paths, options) {
+  if (!nativeBinding || typeof nativeBinding.statBatch !== 'function') {
+    return Promise.reject(createUnavailableError())
+  }
+  return nativeBinding.statBatch(paths, options || {})
+}
+
+/** Values of a `scanTree` batch's `type` column. */
+const SCAN_FILE = 1
+const SCAN_DIRECTORY = 2
+
+/**
+ * Walks `roots` on the addon's scanner threads and hands what it finds to
+ * `onBatch` as `{ count, paths, size, mtimeMs, ctimeMs, type }`, one typed
+ * array per column. `ctimeMs` is the birth time where the filesystem records
+ * it. Batches are delivered one at a time: when `onBatch` returns a promise,
+ * the next waits for it, and the walk pauses once `maxPendingBatches` (4)
+ * are waiting. Exclusions (`excludePaths`, `excludeNames`,
+ * `excludeNamesIgnoreCase`, `excludeSuffixesIgnoreCase`, `skipHidden`,
+ * `maxDepth`, ...) prune whole subtrees natively. Resolves with
+ * `{ entryCount, directoryCount, errorCount, threads, cancelled, durationMs }`;
+ * aborting stops the walk, and an error thrown by `onBatch` stops it and
+ * rejects with that error.
+ */
+function scanTree(roots, options, onBatch, signal) {
+  if (!nativeBinding || typeof nativeBinding.scanTreeAsync !== 'function') {
+    return Promise.reject(createUnavailableError())
+  }
+  let open = true
+  let failure = null
+  let chain = Promise.resolve()
+  const pending = runAsync(
+    (requestId) => {
+      const fail = (error) => {
+        if (!failure)
+          failure = error
+        open = false
+        nativeBinding.cancelSearch(requestId)
+      }
+      const deliver = (batch) => {
+        chain = chain.then(async () => {
+          if (!open)
+            return
+          try {
+            await onBatch(batch)
+            nativeBinding.acknowledgeTreeScanBatch(requestId)
+          }
+          catch (error) {
+            fail(error)
+          }
+        })
+      }
+      return nativeBinding.scanTreeAsync(roots, options || {}, requestId, deliver)
+    },
+    signal,
+  )
+  // Batches already queued when the caller aborted are not delivered.
+  pending.catch(() => {
+    open = false
+  })
+  return pending.then(async (summary) => {
+    await chain
+    if (failure)
+      throw failure
+    return summary
+  })
+}
+
+/**
+ * Linux only. Watches directory trees natively (fanotify when the process may
+ * use it, inotify otherwise) and calls `onEvents` with coalesced batches of
+ * `{ action, rawPath, isDirectory }`, where `action` is `add`, `change`,
+ * `delete` or `overflow` (events under `rawPath` were lost; rescan it).
+ * Keeps the process alive until `close()`.
+ */
+function createDirectoryWatcher(onEvents, options) {
+  if (!nativeBinding || typeof nativeBinding.FsWatcher !== 'function') {
+    throw createUnavailableError()
+  }
+  if (typeof onEvents !== 'function') {
+    throw new TypeError('createDirectoryWatcher expects an event callback')
+  }
+  return new nativeBinding.FsWatcher(onEvents, options || {})
+}
+
 module.exports = {
+  EverythingColumnarResults,
   search,
   query,
+  searchAsync,
+  createSearchSession,
+  getCacheStats,
+  configureCache,
+  invalidateCache,
+  getNativeMetrics,
+  configureNativeMetrics,
+  drainNativeTraceSpans,
   getVersion,
+  getIndexStatus,
+  rebuildIndex,
+  getLocateStatus,
+  locate,
+  locateStream,
+  statBatch,
+  STAT_EXISTS,
+  STAT_DIRECTORY,
+  STAT_FILE,
+  STAT_SYMLINK,
+  scanTree,
+  SCAN_FILE,
+  SCAN_DIRECTORY,
+  createDirectoryWatcher,
 }
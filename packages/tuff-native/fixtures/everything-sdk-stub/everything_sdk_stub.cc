@@ -0,0 +1,218 @@
+// Stand-in for the Everything SDK DLL. It exports the entry points the addon
+// resolves (see native/src/everything/everything_sdk.h) and answers every query
+// with a deterministic, synthetic result list, so the SDK path of the
+// Everything addon can run under tests on machines without Everything.
+//
+// Knobs, all read per query:
+//   TALEX_EVERYTHING_STUB_DELAY_MS  sleep inside Everything_QueryW
+//   TALEX_EVERYTHING_STUB_RESULTS   rows per query before max/offset (default 3)
+//   TALEX_EVERYTHING_STUB_LOG       append every query that reaches the backend
+//
+// The stub also checks the addon's locking: a second query entering while one
+// is in flight fails with kErrorOverlap instead of returning results.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#define STUB_EXPORT extern "C" __declspec(dllexport)
+#define STUB_CALL __stdcall
+#else
+#define STUB_EXPORT extern "C" __attribute__((visibility("default")))
+#define STUB_CALL
+#endif
+
+namespace {
+
+using Dword = uint32_t;
+using Bool = int32_t;
+
+struct LargeInteger {
+  int64_t QuadPart;
+};
+
+struct FileTime {
+  uint32_t dwLowDateTime;
+  uint32_t dwHighDateTime;
+};
+
+struct Row {
+  std::wstring fullPath;
+  std::wstring name;
+  int64_t size;
+  uint64_t modified100Ns;
+  bool folder;
+};
+
+constexpr Dword kErrorOk = 0;
+constexpr Dword kErrorOverlap = 0xE0;
+// 2024-01-01T00:00:00Z as a FILETIME.
+constexpr uint64_t kBaseFileTime = 133485408000000000ULL;
+
+std::wstring g_search;
+Dword g_max = 0xFFFFFFFF;
+Dword g_offset = 0;
+Dword g_lastError = kErrorOk;
+std::vector<Row> g_rows;
+std::atomic<bool> g_busy{false};
+
+long ReadEnvNumber(const char* key, long fallback) {
+  const char* value = std::getenv(key);
+  if (value == nullptr || *value == '\0') {
+    return fallback;
+  }
+  return std::strtol(value, nullptr, 10);
+}
+
+std::string Narrow(const std::wstring& value) {
+  std::string out;
+  for (wchar_t ch : value) {
+    out.push_back(ch < 0x80 ? static_cast<char>(ch) : '?');
+  }
+  return out;
+}
+
+void AppendLog(const std::wstring& query) {
+  const char* path = std::getenv("TALEX_EVERYTHING_STUB_LOG");
+  if (path == nullptr || *path == '\0') {
+    return;
+  }
+  if (FILE* file = std::fopen(path, "a")) {
+    std::fprintf(file, "%s\n", Narrow(query).c_str());
+    std::fclose(file);
+  }
+}
+
+const Row* RowAt(Dword index) {
+  return index < g_rows.size() ? &g_rows[index] : nullptr;
+}
+
+}  // namespace
+
+STUB_EXPORT void STUB_CALL Everything_SetSearchW(const wchar_t* search) {
+  g_search = search != nullptr ? search : L"";
+}
+
+STUB_EXPORT void STUB_CALL Everything_SetRequestFlags(Dword) {}
+STUB_EXPORT void STUB_CALL Everything_SetSort(Dword) {}
+STUB_EXPORT void STUB_CALL Everything_SetMatchPath(Bool) {}
+STUB_EXPORT void STUB_CALL Everything_SetMatchCase(Bool) {}
+STUB_EXPORT void STUB_CALL Everything_SetMatchWholeWord(Bool) {}
+STUB_EXPORT void STUB_CALL Everything_SetRegex(Bool) {}
+
+STUB_EXPORT void STUB_CALL Everything_SetMax(Dword max) {
+  g_max = max;
+}
+
+STUB_EXPORT void STUB_CALL Everything_SetOffset(Dword offset) {
+  g_offset = offset;
+}
+
+STUB_EXPORT Bool STUB_CALL Everything_QueryW(Bool) {
+  if (g_busy.exchange(true)) {
+    g_lastError = kErrorOverlap;
+    return 0;
+  }
+
+  const std::wstring search = g_search;
+  AppendLog(search);
+
+  const long delayMs = ReadEnvNumber("TALEX_EVERYTHING_STUB_DELAY_MS", 0);
+  if (delayMs > 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+  }
+
+  const long total = ReadEnvNumber("TALEX_EVERYTHING_STUB_RESULTS", 3);
+  std::vector<Row> rows;
+  for (long i = static_cast<long>(g_offset); i < total && rows.size() < g_max; ++i) {
+    Row row;
+    row.name = search + L"-" + std::to_wstring(i) + (i % 5 == 4 ? L"" : L".txt");
+    row.fullPath = L"/stub/" + row.name;
+    row.size = static_cast<int64_t>(i) * 1024;
+    row.modified100Ns = kBaseFileTime + static_cast<uint64_t>(i) * 10000000ULL;
+    row.folder = i % 5 == 4;
+    rows.push_back(std::move(row));
+  }
+
+  // A search string changed mid-query means two callers shared the SDK state.
+  const bool overlapped = search != g_search;
+  g_rows = std::move(rows);
+  g_lastError = overlapped ? kErrorOverlap : kErrorOk;
+  g_busy.store(false);
+  return overlapped ? 0 : 1;
+}
+
+STUB_EXPORT Dword STUB_CALL Everything_GetLastError() {
+  return g_lastError;
+}
+
+STUB_EXPORT Dword STUB_CALL Everything_GetNumResults() {
+  return static_cast<Dword>(g_rows.size());
+}
+
+STUB_EXPORT const wchar_t* STUB_CALL Everything_GetResultFileNameW(Dword index) {
+  const Row* row = RowAt(index);
+  return row != nullptr ? row->name.c_str() : nullptr;
+}
+
+STUB_EXPORT Dword STUB_CALL Everything_GetResultFullPathNameW(Dword index, wchar_t* buffer, Dword capacity) {
+  const Row* row = RowAt(index);
+  if (row == nullptr || buffer == nullptr || capacity == 0) {
+    return 0;
+  }
+  const Dword length = static_cast<Dword>(row->fullPath.size());
+  const Dword copied = length < capacity ? length : capacity - 1;
+  row->fullPath.copy(buffer, copied);
+  buffer[copied] = L'\0';
+  return copied;
+}
+
+STUB_EXPORT Bool STUB_CALL Everything_GetResultSize(Dword index, LargeInteger* size) {
+  const Row* row = RowAt(index);
+  if (row == nullptr || size == nullptr || row->folder) {
+    return 0;
+  }
+  size->QuadPart = row->size;
+  return 1;
+}
+
+STUB_EXPORT Bool STUB_CALL Everything_GetResultDateModified(Dword index, FileTime* time) {
+  const Row* row = RowAt(index);
+  if (row == nullptr || time == nullptr) {
+    return 0;
+  }
+  time->dwLowDateTime = static_cast<uint32_t>(row->modified100Ns & 0xFFFFFFFFULL);
+  time->dwHighDateTime = static_cast<uint32_t>(row->modified100Ns >> 32);
+  return 1;
+}
+
+STUB_EXPORT Bool STUB_CALL Everything_GetResultDateCreated(Dword index, FileTime* time) {
+  return Everything_GetResultDateModified(index, time);
+}
+
+STUB_EXPORT Bool STUB_CALL Everything_IsFolderResult(Dword index) {
+  const Row* row = RowAt(index);
+  return row != nullptr && row->folder ? 1 : 0;
+}
+
+STUB_EXPORT Dword STUB_CALL Everything_GetMajorVersion() {
+  return 1;
+}
+
+STUB_EXPORT Dword STUB_CALL Everything_GetMinorVersion() {
+  return 4;
+}
+
+STUB_EXPORT Dword STUB_CALL Everything_GetRevision() {
+  return 1;
+}
+
+STUB_EXPORT Dword STUB_CALL Everything_GetBuildNumber() {
+  return 0;
+}
@@ -2,26 +2,181 @@
 
 import type { Buffer } from 'node:buffer'
 
+export interface NativeOcrWord {
+  text: string
+  confidence?: number
+  boundingBox: [number, number, number, number]
+}
+
 export interface NativeOcrBlock {
   text: string
   confidence?: number
   boundingBox?: [number, number, number, number]
+  /** With `includeWords`: the words of the line, left to right. */
+  words?: NativeOcrWord[]
+}
+
+/**
+ * The lines and words of a result as typed arrays over one ArrayBuffer, `buffer`, so the whole
+ * layout crosses to another thread by transfer rather than by copy. Boxes are x, y, width,
+ * height; NaN marks a box or confidence the engine did not give.
+ */
+export interface NativeOcrCompactLayout {
+  buffer: ArrayBuffer
+  lines: number
+  words: number
+  /** UTF-8 of every line, then of every word. */
+  text: Uint8Array
+  /** Byte offset and length in `text`, two per line. */
+  lineText: Uint32Array
+  lineBoxes: Float32Array
+  lineConfidences: Float32Array
+  /** Index of the first word and the number of words, two per line. */
+  lineWords: Uint32Array
+  wordText: Uint32Array
+  wordBoxes: Float32Array
+  wordConfidences: Float32Array
+}
+
+export type NativeOcrPriority = 'interactive' | 'background'
+
+/**
+ * Image clean-up before recognition, each step opt-in. Steps run in this order: decode, crop,
+ * grayscale, downscale, binarize, deskew. Block bounding boxes are mapped back to the source
+ * image.
+ */
+export interface NativeOcrPreprocessOptions {
+  /** Region of interest in source pixels, clipped to the image. */
+  crop?: { x: number, y: number, width: number, height: number }
+  grayscale?: boolean
+  /** Downscales (never upscales) so text is about this many pixels tall. */
+  targetTextHeight?: number
+  /** Text height in source pixels; estimated from the image when omitted. */
+  textHeightHint?: number
+  /** Adaptive (Bradley) thresholding; implies grayscale. */
+  binarize?: boolean
+  /** Window side in pixels; chosen from the image size when omitted. */
+  binarizeWindow?: number
+  /** How much darker than its surroundings a pixel must be to count as ink. Default 0.15. */
+  binarizeThreshold?: number
+  /** Straightens text skewed by up to `maxSkewDegrees` (default 5); implies grayscale. */
+  deskew?: boolean
+  maxSkewDegrees?: number
+}
+
+export interface NativeOcrPreprocessReport {
+  durationsMs: {
+    decode: number
+    crop: number
+    grayscale: number
+    scale: number
+    binarize: number
+    deskew: number
+    total: number
+  }
+  scale: number
+  /** Skew that was corrected, in degrees. */
+  skewAngle: number
+  width: number
+  height: number
+}
+
+/**
+ * Splits large images into overlapping tiles recognized in parallel; lines are merged back into
+ * one result in image coordinates.
+ */
+export interface NativeOcrTilingOptions {
+  /** Longest tile side in pixels after preprocessing; 0 (default) tiles only what the engine cannot take whole. */
+  tileSize?: number
+  /** Pixels neighbouring tiles share; should exceed the text height. Default 128. */
+  overlap?: number
+}
+
+/**
+ * A check of a few milliseconds run before the engine: images unlikely to hold text fail with
+ * ERR_OCR_NO_TEXT instead of being recognized. Not run for OcrSession frames.
+ */
+export interface NativeOcrTextDetectionOptions {
+  /** Default true once an object is given. */
+  enabled?: boolean
+  /** Likelihood, 0..1, below which the engine is skipped. Default 0.2. */
+  threshold?: number
+  /** Recognizes regardless, e.g. to override service defaults that enable the check. */
+  force?: boolean
 }
 
-export interface NativeOcrOptions {
-  image: Buffer
+export interface NativeOcrTextDetectionReport {
+  /** How likely the image is to hold text, 0..1. */
+  score: number
+  /** Glyph-like shapes found lined up, and the lines they form. */
+  glyphs: number
+  lines: number
+  durationMs: number
+}
+
+export interface NativeOcrRecognitionOptions {
   languageHint?: string
   includeLayout?: boolean
+  /** Also reports the words of each line with their boxes; implies `includeLayout`. */
+  includeWords?: boolean
+  /** Returns `layout` in place of `blocks`; implies `includeLayout`. */
+  compactLayout?: boolean
   maxBlocks?: number
+  /** Background work runs on reduced-priority threads and never delays interactive work. */
+  priority?: NativeOcrPriority
+  /** Fails with ERR_OCR_DEADLINE_EXCEEDED if recognition has not started within this many ms. */
+  deadlineMs?: number
+  preprocess?: NativeOcrPreprocessOptions
+  tiling?: NativeOcrTilingOptions
+  /** Off by default; `true` enables it with the default threshold. */
+  textDetection?: boolean | NativeOcrTextDetectionOptions
 }
 
+/**
+ * Exactly one image source. `image` and `pixels` are read in place, not copied, so they must not
+ * be modified until the promise settles. `imagePath` is memory-mapped and `dataUrl` base64-decoded
+ * on the worker thread.
+ */
+export type NativeOcrImageSource
+  = | { image: Buffer }
+    | { imagePath: string }
+    | { dataUrl: string }
+    | {
+      /** Raw pixels, e.g. a screenshot that was never encoded. */
+      pixels: Uint8Array
+      pixelFormat?: 'bgra' | 'gray'
+      width: number
+      height: number
+      /** Bytes between rows; defaults to `width` times the pixel size. */
+      stride?: number
+    }
+
+export type NativeOcrOptions = NativeOcrRecognitionOptions & NativeOcrImageSource
+
 export interface NativeOcrResult {
   text: string
   confidence?: number
   language?: string
   blocks?: NativeOcrBlock[]
-  engine: 'apple-vision' | 'windows-ocr'
+  /** `blocks` as typed arrays, with `compactLayout`. */
+  layout?: NativeOcrCompactLayout
+  engine: 'apple-vision' | 'windows-ocr' | 'tesseract'
   durationMs: number
+  /** Present when `preprocess` enabled any step. */
+  preprocess?: NativeOcrPreprocessReport
+  /** True when the result came from the OCR result cache. */
+  cached?: boolean
+  /** Present on OcrSession results: how much of the frame was recognized again. */
+  incremental?: {
+    /** Recognized whole: the first frame, or too much changed. */
+    full: boolean
+    regions: number
+    changedFraction: number
+    /** Lines carried over from the previous frame. */
+    reusedBlocks: number
+  }
+  /** Present when `textDetection` ran and let the image through. */
+  textDetection?: NativeOcrTextDetectionReport
 }
 
 export interface NativeOcrSupport {
@@ -30,9 +185,223 @@ export interface NativeOcrSupport {
   reason?: string
 }
 
+export type NativeOcrBatchEntry
+  = | { status: 'fulfilled', value: NativeOcrResult }
+    | { status: 'rejected', reason: Error & { code?: string } }
+
+export interface NativeOcrConfig {
+  threads?: number
+  backgroundThreads?: number
+}
+
 export declare function recognizeImageText(
-  options: NativeOcrOptions,
+  options: NativeOcrOptions & { signal?: AbortSignal },
 ): Promise<NativeOcrResult>
+export declare function recognizeImageTextBatch(
+  images: NativeOcrOptions[],
+  options?: NativeOcrRecognitionOptions & { signal?: AbortSignal },
+  onResult?: (index: number, entry: NativeOcrBatchEntry) => void,
+): Promise<NativeOcrBatchEntry[]>
+export declare function configureNativeOcr(options: NativeOcrConfig): void
+
+export interface NativeOcrCacheStats {
+  hits: number
+  misses: number
+  /** Hits on an image with other bytes but the same pixels. */
+  perceptualHits: number
+  /** Hits read back from `directory`. */
+  diskHits: number
+  insertions: number
+  /** Dropped to stay under maxBytes, least recently used first. */
+  evictions: number
+  entries: number
+  bytes: number
+  diskBytes: number
+  maxBytes: number
+  maxDiskBytes: number
+  perceptual: boolean
+  perceptualMaxDistance: number
+  directory?: string
+}
+
+export interface NativeOcrCacheOptions {
+  /** Budget for cached results in memory; 0 disables the cache. Default 8 MiB. */
+  maxBytes?: number
+  /**
+   * Also match images with other bytes but the same pixels (default false). Encoded images are
+   * then decoded before recognition.
+   */
+  perceptual?: boolean
+  /** Perceptual hash bits (of 1024) that may differ; default 0. */
+  perceptualMaxDistance?: number
+  /** Keeps exact matches in this directory across restarts; null keeps them in memory only. */
+  directory?: string | null
+  /** Budget for `directory`, oldest files dropped first. Default 64 MiB. */
+  maxDiskBytes?: number
+}
+
+/** Null without the native module. */
+export declare function getOcrCacheStats(): NativeOcrCacheStats | null
+export declare function configureOcrCache(options?: NativeOcrCacheOptions): NativeOcrCacheStats
+/** Drops every cached OCR result, in memory and on disk. */
+export declare function clearOcrCache(): void
+
+/** Latencies of one stage; quantiles are bucket upper bounds, accurate to about 25%. */
+export interface NativeStageMetrics {
+  count: number
+  totalMs: number
+  maxMs: number
+  p50Ms: number
+  p95Ms: number
+  p99Ms: number
+}
+
+export interface NativeMetrics<
+  Stage extends string = string,
+  Counter extends string = string,
+  Queues = Record<string, number | boolean>,
+> {
+  enabled: boolean
+  tracing: boolean
+  traceCapacity: number
+  stages: Record<Stage, NativeStageMetrics>
+  counters: Record<Counter, number>
+  /** Depths at the time of the call rather than since enabling. */
+  queues: Queues
+}
+
+export interface NativeMetricsOptions {
+  /** Times stages. Off by default; counters and queue depths are kept regardless. */
+  enabled?: boolean
+  /** Keeps the most recent spans for drainNativeTraceSpans(); 0 stops tracing. Implies enabled. */
+  traceCapacity?: number
+  /** Zeroes stage timings and counters. */
+  reset?: boolean
+}
+
+export interface NativeTraceSpan<Stage extends string = string> {
+  stage: Stage
+  /** Unix milliseconds, comparable with performance.timeOrigin + performance.now(). */
+  startedAt: number
+  durationMs: number
+}
+
+export interface NativeTraceSpanBatch<Stage extends string = string> {
+  spans: NativeTraceSpan<Stage>[]
+  /** Spans overwritten since the last drain because the ring was full. */
+  dropped: number
+}
+
+export type NativeOcrStage =
+  | 'queueWait'
+  | 'prepare'
+  | 'cacheLookup'
+  | 'preprocess'
+  | 'textDetection'
+  | 'engineCreate'
+  | 'recognize'
+  | 'tileMerge'
+  | 'marshal'
+  | 'total'
+
+export type NativeOcrMetrics = NativeMetrics<
+  NativeOcrStage,
+  'succeeded' | 'failed' | 'cancelled' | 'cached',
+  { interactive: number, background: number, busyThreads: number, threads: number }
+>
+
+/** Process-wide OCR stage timings, counters and queue depths. Null without the native module. */
+export declare function getNativeMetrics(): NativeOcrMetrics | null
+export declare function configureNativeMetrics(options?: NativeMetricsOptions): NativeOcrMetrics
+/** Empty when not tracing or without the native module. */
+export declare function drainNativeTraceSpans(): NativeTraceSpanBatch<NativeOcrStage>
+
+export interface NativeOcrPreprocessedImage {
+  pixels: Buffer
+  pixelFormat: 'bgra' | 'gray'
+  width: number
+  height: number
+  stride: number
+  report: NativeOcrPreprocessReport
+}
+
+/** Runs `preprocess` on raw pixels on the calling thread; for tuning and tests. */
+export declare function preprocessOcrImage(options: {
+  pixels: Uint8Array
+  pixelFormat?: 'bgra' | 'gray'
+  width: number
+  height: number
+  stride?: number
+  preprocess: NativeOcrPreprocessOptions
+}): NativeOcrPreprocessedImage
+
+/** Rates raw pixels for text as `textDetection` does, on the calling thread; for tuning and tests. */
+export declare function detectImageText(options: {
+  pixels: Uint8Array
+  pixelFormat?: 'bgra' | 'gray'
+  width: number
+  height: number
+  stride?: number
+  preprocess?: NativeOcrPreprocessOptions
+}): NativeOcrTextDetectionReport
+
+export interface NativeOcrServiceStats {
+  submitted: number
+  succeeded: number
+  failed: number
+  pending: number
+  closed: boolean
+}
+
+export interface NativeOcrService {
+  recognize: (options: NativeOcrOptions & { signal?: AbortSignal }) => Promise<NativeOcrResult>
+  recognizeBatch: (
+    images: NativeOcrOptions[],
+    options?: NativeOcrRecognitionOptions & { signal?: AbortSignal },
+    onResult?: (index: number, entry: NativeOcrBatchEntry) => void,
+  ) => Promise<NativeOcrBatchEntry[]>
+  getStats: () => NativeOcrServiceStats
+  close: () => void
+}
+
+export declare function createOcrService(
+  defaults?: NativeOcrRecognitionOptions,
+): NativeOcrService
+export interface NativeOcrSessionDiffOptions {
+  /** Side of the squares frames are compared in, 4 to 256 pixels. Default 16. */
+  blockSize?: number
+  /** Luma difference ignored as noise, 0 to 255. Default 8. */
+  tolerance?: number
+  /** Share of changed squares past which a frame is recognized whole. Default 0.5. */
+  maxChangedFraction?: number
+}
+
+export interface NativeOcrSessionStats {
+  submitted: number
+  succeeded: number
+  failed: number
+  frames: number
+  fullFrames: number
+  unchangedFrames: number
+  incrementalFrames: number
+  regions: number
+  reusedBlocks: number
+  closed: boolean
+}
+
+export interface NativeOcrSession {
+  /** Recognizes the next frame; calls run in order. */
+  recognize: (options: NativeOcrOptions & { signal?: AbortSignal }) => Promise<NativeOcrResult>
+  /** Forgets the previous frame, so the next is recognized whole. */
+  reset: () => void
+  getStats: () => NativeOcrSessionStats
+  close: () => void
+}
+
+export declare function createOcrSession(
+  defaults?: NativeOcrRecognitionOptions,
+  diff?: NativeOcrSessionDiffOptions,
+): NativeOcrSession
 export declare function getNativeOcrSupport(): NativeOcrSupport
 
 export interface DarwinAppIconWriteOptions {
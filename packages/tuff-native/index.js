@@ -41,29 +41,365 @@ function getNativeOcrSupport() {
   return nativeBinding.getNativeOcrSupport()
 }
 
+function createUnavailableError() {
+  const error = new Error(
+    loadError instanceof Error
+      ? `Native OCR module is unavailable: ${loadError.message}`
+      : 'Native OCR module is unavailable',
+  )
+  error.code = 'ERR_OCR_ENGINE_UNAVAILABLE'
+  return error
+}
+
+function createDisabledError() {
+  const error = new Error(
+    'Native OCR is disabled by TUFF_DISABLE_NATIVE_OCR=1',
+  )
+  error.code = 'ERR_OCR_DISABLED'
+  return error
+}
+
+function createAbortError(signal) {
+  const reason = signal && signal.reason
+  if (reason instanceof Error)
+    return reason
+  const error = new Error('Native OCR was aborted')
+  error.name = 'AbortError'
+  error.code = 'ERR_OCR_ABORTED'
+  return error
+}
+
+let nextRequestId = 1
+
+/**
+ * Starts a native OCR call under a fresh request id. Aborting `signal` rejects
+ * at once and drops the call's tasks that have not started yet.
+ */
+function runOcr(start, signal) {
+  if (signal && signal.aborted) {
+    return Promise.reject(createAbortError(signal))
+  }
+
+  const requestId = nextRequestId
+  nextRequestId = nextRequestId >= Number.MAX_SAFE_INTEGER ? 1 : nextRequestId + 1
+
+  let pending
+  try {
+    pending = start(requestId)
+  }
+  catch (error) {
+    return Promise.reject(error)
+  }
+  if (!signal) {
+    return pending
+  }
+
+  return new Promise((resolve, reject) => {
+    const onAbort = () => {
+      nativeBinding.cancelNativeOcr(requestId)
+      reject(createAbortError(signal))
+    }
+    signal.addEventListener('abort', onAbort, { once: true })
+    pending.then(
+      (value) => {
+        signal.removeEventListener('abort', onAbort)
+        resolve(value)
+      },
+      (error) => {
+        signal.removeEventListener('abort', onAbort)
+        reject(error)
+      },
+    )
+  })
+}
+
+/**
+ * Recognizes one image on the addon's own OCR threads. `priority: 'background'`
+ * queues it behind interactive work on reduced-priority threads; a call still
+ * queued after `deadlineMs` fails with ERR_OCR_DEADLINE_EXCEEDED.
+ */
 async function recognizeImageText(options) {
   if (isDisabledByEnv()) {
-    const error = new Error(
-      'Native OCR is disabled by TUFF_DISABLE_NATIVE_OCR=1',
-    )
-    error.code = 'ERR_OCR_DISABLED'
-    throw error
+    throw createDisabledError()
   }
 
   if (
     !nativeBinding
     || typeof nativeBinding.recognizeImageText !== 'function'
   ) {
-    const error = new Error(
-      loadError instanceof Error
-        ? `Native OCR module is unavailable: ${loadError.message}`
-        : 'Native OCR module is unavailable',
-    )
-    error.code = 'ERR_OCR_ENGINE_UNAVAILABLE'
-    throw error
+    throw createUnavailableError()
+  }
+
+  const { signal, ...nativeOptions } = options || {}
+  if (!signal || typeof nativeBinding.cancelNativeOcr !== 'function') {
+    return nativeBinding.recognizeImageText(nativeOptions)
   }
+  return runOcr(
+    requestId => nativeBinding.recognizeImageText(nativeOptions, requestId),
+    signal,
+  )
+}
+
+/**
+ * Runs one native batch call and collects its results; `start(requestId,
+ * onItem)` makes the call.
+ */
+async function collectBatch(start, count, signal, onResult) {
+  const results = Array.from({ length: count })
+  let failure = null
+  await runOcr(
+    requestId => start(requestId, (index, value, reason) => {
+      const entry = reason
+        ? { status: 'rejected', reason }
+        : { status: 'fulfilled', value }
+      results[index] = entry
+      if (!onResult || failure)
+        return
+      try {
+        onResult(index, entry)
+      }
+      catch (error) {
+        failure = error
+      }
+    }),
+    signal,
+  )
+  if (failure)
+    throw failure
+  return results
+}
 
-  return nativeBinding.recognizeImageText(options)
+/**
+ * Recognizes `images` concurrently on the OCR threads. Each image takes the
+ * same sources and settings as recognizeImageText; `options` supplies the
+ * settings an image leaves out. Resolves with one
+ * `{ status: 'fulfilled', value } | { status: 'rejected', reason }` entry per
+ * image, in input order, and calls `onResult(index, entry)` for each as soon
+ * as it completes. An error thrown by `onResult` rejects the batch once the
+ * rest have settled.
+ */
+async function recognizeImageTextBatch(images, options, onResult) {
+  if (isDisabledByEnv()) {
+    throw createDisabledError()
+  }
+
+  if (
+    !nativeBinding
+    || typeof nativeBinding.recognizeImageTextBatch !== 'function'
+  ) {
+    throw createUnavailableError()
+  }
+
+  const { signal, ...batchOptions } = options || {}
+  return collectBatch(
+    (requestId, onItem) => nativeBinding.recognizeImageTextBatch(
+      images,
+      batchOptions,
+      requestId,
+      onItem,
+    ),
+    images.length,
+    signal,
+    onResult,
+  )
+}
+
+/**
+ * Creates a long-lived OCR service, meant to be created once per process or
+ * worker and fed jobs for its whole life rather than loading the addon per
+ * image. `recognize` and `recognizeBatch` behave like recognizeImageText and
+ * recognizeImageTextBatch, with `defaults` (languageHint, priority, ...)
+ * filling in what a call leaves out. `getStats()` counts the service's jobs;
+ * `close()` drops the ones still queued, which reject with ERR_OCR_ABORTED.
+ */
+function createOcrService(defaults) {
+  if (isDisabledByEnv()) {
+    throw createDisabledError()
+  }
+
+  if (!nativeBinding || typeof nativeBinding.OcrService !== 'function') {
+    throw createUnavailableError()
+  }
+
+  const service = new nativeBinding.OcrService(defaults || {})
+  return {
+    async recognize(options) {
+      const { signal, ...nativeOptions } = options || {}
+      return runOcr(
+        requestId => service.recognize(nativeOptions, requestId),
+        signal,
+      )
+    },
+    async recognizeBatch(images, options, onResult) {
+      const { signal, ...batchOptions } = options || {}
+      return collectBatch(
+        (requestId, onItem) => service.recognizeBatch(
+          images,
+          batchOptions,
+          requestId,
+          onItem,
+        ),
+        images.length,
+        signal,
+        onResult,
+      )
+    },
+    getStats() {
+      return service.getStats()
+    },
+    close() {
+      service.close()
+    },
+  }
+}
+
+/**
+ * Creates an OCR session for a stream of near-identical frames (repeated
+ * screenshots of one window). Each frame is compared with the previous one:
+ * an unchanged frame is answered from the previous result and otherwise only
+ * the changed regions are recognized, the rest of the lines carried over.
+ * `recognize` calls run one after another in call order. `diff` tunes the
+ * comparison: `blockSize` (default 16), `tolerance` (luma levels ignored,
+ * default 8) and `maxChangedFraction` (past which a frame is recognized whole,
+ * default 0.5). `reset()` forgets the previous frame.
+ */
+function createOcrSession(defaults, diff) {
+  if (isDisabledByEnv()) {
+    throw createDisabledError()
+  }
+
+  if (!nativeBinding || typeof nativeBinding.OcrSession !== 'function') {
+    throw createUnavailableError()
+  }
+
+  const session = new nativeBinding.OcrSession(defaults || {}, diff || {})
+  let previous = Promise.resolve()
+  return {
+    recognize(options) {
+      const { signal, ...nativeOptions } = options || {}
+      const run = () => runOcr(
+        requestId => session.recognize(nativeOptions, requestId),
+        signal,
+      )
+      const current = previous.then(run, run)
+      previous = current.catch(() => {})
+      return current
+    },
+    reset() {
+      session.reset()
+    },
+    getStats() {
+      return session.getStats()
+    },
+    close() {
+      session.close()
+    },
+  }
+}
+
+/**
+ * Sets how many threads native OCR may use: `threads` for interactive work
+ * (default 2) and `backgroundThreads` for background work (default 1; 0 runs
+ * it on the interactive threads instead). A no-op without the native module.
+ */
+function configureNativeOcr(options) {
+  if (
+    nativeBinding
+    && typeof nativeBinding.configureNativeOcr === 'function'
+  ) {
+    nativeBinding.configureNativeOcr(options || {})
+  }
+}
+
+/**
+ * Counters of the native OCR result cache, which answers images already recognized (same bytes,
+ * or the same pixels when `perceptual` is on) with the same options without running an engine.
+ * Null without the native module.
+ */
+function getOcrCacheStats() {
+  if (!nativeBinding || typeof nativeBinding.getOcrCacheStats !== 'function') {
+    return null
+  }
+  return nativeBinding.getOcrCacheStats()
+}
+
+/**
+ * Resizes or redirects the OCR result cache; omitted keys keep their value and `maxBytes: 0`
+ * disables it. A `directory` also keeps exact matches on disk across restarts. Returns the stats
+ * after the change.
+ */
+function configureOcrCache(options) {
+  if (!nativeBinding || typeof nativeBinding.configureOcrCache !== 'function') {
+    throw createUnavailableError()
+  }
+  return nativeBinding.configureOcrCache(options || {})
+}
+
+/** Drops every cached OCR result, in memory and on disk. */
+function clearOcrCache() {
+  if (nativeBinding && typeof nativeBinding.clearOcrCache === 'function') {
+    nativeBinding.clearOcrCache()
+  }
+}
+
+/**
+ * Stage timings (queue wait, engine creation, recognition, marshalling, ...) and counters of every
+ * OCR call in the process, with the pool's queue depths. Stages are only timed once
+ * configureNativeMetrics() enables them. Null without the native module.
+ */
+function getNativeMetrics() {
+  if (!nativeBinding || typeof nativeBinding.getNativeMetrics !== 'function') {
+    return null
+  }
+  return nativeBinding.getNativeMetrics()
+}
+
+/**
+ * Turns stage timing on or off, and keeps the last `traceCapacity` spans for
+ * drainNativeTraceSpans(). Omitted keys keep their value. Returns the metrics after the change.
+ */
+function configureNativeMetrics(options) {
+  if (!nativeBinding || typeof nativeBinding.configureNativeMetrics !== 'function') {
+    throw createUnavailableError()
+  }
+  return nativeBinding.configureNativeMetrics(options || {})
+}
+
+/** Takes the spans recorded since the last drain, oldest first. */
+function drainNativeTraceSpans() {
+  if (!nativeBinding || typeof nativeBinding.drainNativeTraceSpans !== 'function') {
+    return { spans: [], dropped: 0 }
+  }
+  return nativeBinding.drainNativeTraceSpans()
+}
+
+/**
+ * Runs the OCR preprocessing steps on raw pixels, synchronously, and returns the pixels the
+ * engine would be given with a per-step report. For tuning `preprocess` options and for tests;
+ * recognition runs the same steps itself on its worker threads.
+ */
+function preprocessOcrImage(options) {
+  if (
+    !nativeBinding
+    || typeof nativeBinding.preprocessOcrImage !== 'function'
+  ) {
+    throw createUnavailableError()
+  }
+  return nativeBinding.preprocessOcrImage(options)
+}
+
+/**
+ * Rates how likely raw pixels are to hold text, synchronously, as the `textDetection` check does
+ * before recognition. For tuning its threshold and for tests.
+ */
+function detectImageText(options) {
+  if (
+    !nativeBinding
+    || typeof nativeBinding.detectImageText !== 'function'
+  ) {
+    throw createUnavailableError()
+  }
+  return nativeBinding.detectImageText(options)
 }
 
 /**
@@ -137,6 +473,18 @@ async function getNotificationAuthorizationStatus() {
 module.exports = {
   getNativeOcrSupport,
   recognizeImageText,
+  recognizeImageTextBatch,
+  createOcrService,
+  createOcrSession,
+  configureNativeOcr,
+  getOcrCacheStats,
+  configureOcrCache,
+  clearOcrCache,
+  getNativeMetrics,
+  configureNativeMetrics,
+  drainNativeTraceSpans,
+  preprocessOcrImage,
+  detectImageText,
   writeDarwinAppIcon,
   getNotificationAuthorizationStatus,
 }
@@ -1,160 +1,865 @@
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cmath>
+#include <condition_variable>
+#include <cstring>
 #include <filesystem>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 #include <napi.h>
 
 #include "common/app_icon_types.h"
+#include "common/image_preprocess.h"
+#include "common/native_metrics_js.h"
 #include "common/notification_types.h"
+#include "common/ocr_metrics.h"
+#include "common/ocr_result_cache.h"
+#include "common/ocr_session.h"
 #include "common/ocr_types.h"
+#include "common/text_detect.h"
+#include "ocr_marshal.h"
 
 namespace tuff::native {
 
 namespace {
 
-Napi::Object ToJsResult(Napi::Env env, const OcrResult &result) {
-  auto output = Napi::Object::New(env);
-  output.Set("text", Napi::String::New(env, result.text));
+uint64_t ParseRequestId(const Napi::CallbackInfo &info, size_t index) {
+  if (info.Length() <= index || !info[index].IsNumber()) {
+    return 0;
+  }
+  return static_cast<uint64_t>(
+      std::max(info[index].As<Napi::Number>().Int64Value(), int64_t{0}));
+}
+
+// Cancellation flags of the calls in flight, by the request id index.js
+// picked for them, for cancelNativeOcr.
+class OcrRequestRegistry {
+public:
+  void Add(uint64_t requestId, std::shared_ptr<std::atomic<bool>> cancelled) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    requests_[requestId] = std::move(cancelled);
+  }
+
+  void Remove(uint64_t requestId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    requests_.erase(requestId);
+  }
+
+  bool Cancel(uint64_t requestId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto found = requests_.find(requestId);
+    if (found == requests_.end()) {
+      return false;
+    }
+    found->second->store(true);
+    return true;
+  }
+
+  void CancelAll() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &request : requests_) {
+      request.second->store(true);
+    }
+  }
+
+private:
+  std::mutex mutex_;
+  std::unordered_map<uint64_t, std::shared_ptr<std::atomic<bool>>> requests_;
+};
+
+// Per-environment instance data. The addon may be loaded by the main thread
+// and by any number of workers at once; each keeps its own calls in flight,
+// while the OCR threads and their engines are shared by the whole process.
+struct OcrAddonData {
+  // An environment going away can no longer settle its promises, so its
+  // tasks that have not started are dropped.
+  ~OcrAddonData() { requests->CancelAll(); }
+
+  // Shared with the calls in flight, whose contexts may outlive this.
+  std::shared_ptr<OcrRequestRegistry> requests =
+      std::make_shared<OcrRequestRegistry>();
+};
+
+OcrAddonData &AddonData(Napi::Env env) {
+  return *env.GetInstanceData<OcrAddonData>();
+}
+
+// What an OcrService keeps between calls. Counters are only touched on the
+// JS thread; `closed` is also read by the OCR threads.
+struct OcrServiceState {
+  std::atomic<bool> closed{false};
+  uint64_t submitted = 0;
+  uint64_t succeeded = 0;
+  uint64_t failed = 0;
+};
 
-  if (result.hasConfidence) {
-    output.Set("confidence", Napi::Number::New(env, result.confidence));
+// The tasks of one call that read a JS Buffer or pixel array in place.
+// Normally the references in OcrRequestContext keep that memory alive until
+// every task is done, but an environment torn down mid-call (a worker
+// terminated, the process exiting) finalizes the thread-safe function, and
+// with it those references, while an OCR thread may still be reading. An
+// environment cleanup hook registered after the thread-safe function's own
+// runs before it. From then on a task taken off its queue fails without
+// reading, however long it waited behind other environments' jobs, and the
+// hook waits only for the tasks already running: at most one recognition
+// each, or one tile of a tiled image.
+class OcrBorrowedInputs {
+public:
+  bool closing() const { return closing_.load(); }
+
+  // Called by a task before it reads its image; false once the environment
+  // is going away.
+  bool Start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closing_.load()) {
+      return false;
+    }
+    ++running_;
+    return true;
+  }
+
+  // Called by a task Start() let through once it no longer reads its image.
+  void Finish() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--running_ == 0) {
+      idle_.notify_all();
+    }
   }
 
-  if (!result.language.empty()) {
-    output.Set("language", Napi::String::New(env, result.language));
+  static void OnEnvCleanup(void *data) {
+    auto *inputs = static_cast<OcrBorrowedInputs *>(data);
+    std::unique_lock<std::mutex> lock(inputs->mutex_);
+    inputs->closing_.store(true);
+    inputs->idle_.wait(lock, [inputs] { return inputs->running_ == 0; });
+  }
+
+private:
+  std::atomic<bool> closing_{false};
+  std::mutex mutex_;
+  std::condition_variable idle_;
+  size_t running_ = 0;
+};
+
+// JS-thread state of one recognize call, owned by the thread-safe function
+// its tasks report through.
+struct OcrRequestContext {
+  OcrRequestContext(Napi::Env env, uint64_t id, bool isBatch, size_t count)
+      : deferred(Napi::Promise::Deferred::New(env)),
+        registry(AddonData(env).requests), requestId(id), batch(isBatch),
+        pending(count) {}
+
+  Napi::Promise::Deferred deferred;
+  // The Buffers and pixel arrays the tasks read in place; released on the JS
+  // thread once every task is done.
+  std::vector<Napi::ObjectReference> keepAlive;
+  std::shared_ptr<OcrRequestRegistry> registry;
+  // Set when `keepAlive` holds anything, while the cleanup hook is registered.
+  std::shared_ptr<OcrBorrowedInputs> borrowed;
+  // Set when the call came through an OcrService.
+  std::shared_ptr<OcrServiceState> service;
+  uint64_t requestId;
+  bool batch;
+  size_t pending;
+};
+
+struct OcrItemMessage {
+  uint32_t index = 0;
+  bool ok = false;
+  bool compactLayout = false;
+  OcrResult result;
+  OcrError error;
+};
+
+Napi::Error ToJsError(Napi::Env env, const OcrError &error) {
+  auto jsError = Napi::Error::New(env, error.message.empty()
+                                           ? "Native OCR recognition failed"
+                                           : error.message);
+  if (!error.code.empty()) {
+    jsError.Value().Set("code", Napi::String::New(env, error.code));
   }
+  return jsError;
+}
 
-  if (!result.blocks.empty()) {
-    auto blocks = Napi::Array::New(env, result.blocks.size());
-    for (size_t i = 0; i < result.blocks.size(); ++i) {
-      const auto &block = result.blocks[i];
-      auto jsBlock = Napi::Object::New(env);
-      jsBlock.Set("text", Napi::String::New(env, block.text));
-      if (block.hasConfidence) {
-        jsBlock.Set("confidence", Napi::Number::New(env, block.confidence));
+// A single call settles its promise with the result; a batch hands each
+// result to onItem(index, result, error) as it completes and resolves once
+// all have been handed over.
+void DeliverOcrItem(Napi::Env env, Napi::Function onItem,
+                    OcrRequestContext *context, OcrItemMessage *message) {
+  if (env != nullptr && context != nullptr && message != nullptr) {
+    ScopedStage marshal(OcrMetrics(), kOcrStageMarshal);
+    if (context->service) {
+      ++(message->ok ? context->service->succeeded : context->service->failed);
+    }
+    if (!context->batch) {
+      if (message->ok) {
+        context->deferred.Resolve(
+            ToJsResult(env, message->result, message->compactLayout));
+      } else {
+        context->deferred.Reject(ToJsError(env, message->error).Value());
       }
-      if (block.hasBoundingBox) {
-        auto box = Napi::Array::New(env, 4);
-        box.Set(uint32_t{0}, Napi::Number::New(env, block.boundingBox[0]));
-        box.Set(uint32_t{1}, Napi::Number::New(env, block.boundingBox[1]));
-        box.Set(uint32_t{2}, Napi::Number::New(env, block.boundingBox[2]));
-        box.Set(uint32_t{3}, Napi::Number::New(env, block.boundingBox[3]));
-        jsBlock.Set("boundingBox", box);
+    } else {
+      onItem.Call({Napi::Number::New(env, message->index),
+                   message->ok ? ToJsResult(env, message->result,
+                                            message->compactLayout)
+                                     .As<Napi::Value>()
+                               : env.Null(),
+                   message->ok ? env.Null()
+                               : ToJsError(env, message->error).Value().As<Napi::Value>()});
+      if (--context->pending == 0) {
+        context->deferred.Resolve(env.Undefined());
       }
-      blocks.Set(static_cast<uint32_t>(i), jsBlock);
     }
-    output.Set("blocks", blocks);
   }
+  delete message;
+}
 
-  output.Set("engine", Napi::String::New(env, result.engine));
-  output.Set("durationMs",
-             Napi::Number::New(env, static_cast<double>(result.durationMs)));
+using OcrRequestTsfn =
+    Napi::TypedThreadSafeFunction<OcrRequestContext, OcrItemMessage,
+                                  DeliverOcrItem>;
 
-  return output;
+// Queues `tasks` on the platform's OCR threads, which never touch the libuv
+// pool. Every task reports through one thread-safe function that owns
+// `context`.
+Napi::Promise SubmitOcrTasks(Napi::Env env, Napi::Function onItem,
+                             std::vector<OcrTask> tasks,
+                             OcrRequestContext *context) {
+  const auto promise = context->deferred.Promise();
+  if (tasks.empty()) {
+    context->deferred.Resolve(env.Undefined());
+    delete context;
+    return promise;
+  }
+
+  auto cancelled = std::make_shared<std::atomic<bool>>(false);
+  if (context->requestId != 0) {
+    context->registry->Add(context->requestId, cancelled);
+  }
+  auto service = context->service;
+  if (service) {
+    service->submitted += tasks.size();
+  }
+
+  auto tsfn = OcrRequestTsfn::New(
+      env, onItem, "tuffNativeOcr", 0, tasks.size(), context,
+      [](Napi::Env finalizeEnv, void *, OcrRequestContext *finalizeContext) {
+        if (finalizeContext->borrowed) {
+          napi_remove_env_cleanup_hook(finalizeEnv,
+                                       OcrBorrowedInputs::OnEnvCleanup,
+                                       finalizeContext->borrowed.get());
+        }
+        if (finalizeContext->requestId != 0) {
+          finalizeContext->registry->Remove(finalizeContext->requestId);
+        }
+        delete finalizeContext;
+      },
+      static_cast<void *>(nullptr));
+
+  const bool borrows = std::any_of(
+      context->keepAlive.begin(), context->keepAlive.end(),
+      [](const Napi::ObjectReference &reference) { return !reference.IsEmpty(); });
+  std::shared_ptr<OcrBorrowedInputs> borrowed;
+  if (borrows) {
+    borrowed = std::make_shared<OcrBorrowedInputs>();
+    context->borrowed = borrowed;
+    napi_add_env_cleanup_hook(env, OcrBorrowedInputs::OnEnvCleanup,
+                              borrowed.get());
+  }
+
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    auto &task = tasks[i];
+    task.isCancelled = [cancelled, service, borrowed] {
+      return cancelled->load() || (service && service->closed.load()) ||
+             (borrowed && borrowed->closing());
+    };
+    // start and done run on the same pool thread; done also runs for a
+    // task dropped without starting.
+    auto started = std::make_shared<bool>(false);
+    if (borrowed) {
+      task.start = [borrowed, started] {
+        *started = borrowed->Start();
+        return *started;
+      };
+    }
+    task.done = [tsfn, borrowed, started, index = static_cast<uint32_t>(i),
+                 compactLayout = task.options.compactLayout](
+                    bool ok, OcrResult &result, OcrError &error) mutable {
+      if (*started) {
+        borrowed->Finish();
+      }
+      auto *message = new OcrItemMessage();
+      message->index = index;
+      message->ok = ok;
+      message->compactLayout = compactLayout;
+      message->result = std::move(result);
+      message->error = std::move(error);
+      if (tsfn.BlockingCall(message) != napi_ok) {
+        delete message;
+      }
+      tsfn.Release();
+    };
+    SubmitPlatformOcr(std::move(task));
+  }
+  return promise;
 }
 
-bool ParseOptions(Napi::Env env, const Napi::Object &input, OcrOptions &options,
-                  Napi::Error &error) {
-  if (!input.Has("image") || !input.Get("image").IsBuffer()) {
-    error = Napi::TypeError::New(
-        env, "recognizeImageText options.image must be a Buffer");
-    return false;
+// Settings come from `defaults` (an OcrService's), then the call's own.
+Napi::Value StartRecognize(const Napi::CallbackInfo &info, const char *name,
+                           const Napi::Object *defaults,
+                           std::shared_ptr<OcrServiceState> service,
+                           std::shared_ptr<OcrSession> session = nullptr) {
+  auto env = info.Env();
+
+  if (info.Length() < 1 || !info[0].IsObject()) {
+    Napi::TypeError::New(env, std::string(name) + " expects an options object")
+        .ThrowAsJavaScriptException();
+    return env.Null();
   }
 
-  const auto imageBuffer = input.Get("image").As<Napi::Buffer<uint8_t>>();
-  if (imageBuffer.Length() == 0) {
-    error = Napi::TypeError::New(
-        env, "recognizeImageText options.image cannot be empty");
-    return false;
+  std::vector<OcrTask> tasks(1);
+  Napi::ObjectReference keepAlive;
+  Napi::Error parseError = Napi::Error::New(env, "");
+  if ((defaults != nullptr &&
+       !ParseTaskOptions(env, *defaults, "OcrService options", tasks[0],
+                         parseError)) ||
+      !ParseTask(env, info[0].As<Napi::Object>(), std::string(name) + " options",
+                 tasks[0], keepAlive, parseError)) {
+    parseError.ThrowAsJavaScriptException();
+    return env.Null();
   }
+  tasks[0].session = std::move(session);
 
-  options.image.assign(imageBuffer.Data(),
-                       imageBuffer.Data() + imageBuffer.Length());
+  auto *context =
+      new OcrRequestContext(env, ParseRequestId(info, 1), false, 1);
+  context->keepAlive.push_back(std::move(keepAlive));
+  context->service = std::move(service);
+  return SubmitOcrTasks(env, Napi::Function(), std::move(tasks), context);
+}
+
+Napi::Value StartRecognizeBatch(const Napi::CallbackInfo &info,
+                                const char *name, const Napi::Object *defaults,
+                                std::shared_ptr<OcrServiceState> service) {
+  auto env = info.Env();
 
-  if (input.Has("languageHint") && input.Get("languageHint").IsString()) {
-    options.languageHint =
-        input.Get("languageHint").As<Napi::String>().Utf8Value();
+  if (info.Length() < 4 || !info[0].IsArray() || !info[3].IsFunction()) {
+    Napi::TypeError::New(env, std::string(name) +
+                                  " expects an image array and a result "
+                                  "callback")
+        .ThrowAsJavaScriptException();
+    return env.Null();
   }
 
-  if (input.Has("includeLayout") && input.Get("includeLayout").IsBoolean()) {
-    options.includeLayout =
-        input.Get("includeLayout").As<Napi::Boolean>().Value();
+  OcrTask batchDefaults;
+  Napi::Error parseError = Napi::Error::New(env, "");
+  if ((defaults != nullptr &&
+       !ParseTaskOptions(env, *defaults, "OcrService options", batchDefaults,
+                         parseError)) ||
+      (info[1].IsObject() &&
+       !ParseTaskOptions(env, info[1].As<Napi::Object>(),
+                         std::string(name) + " options", batchDefaults,
+                         parseError))) {
+    parseError.ThrowAsJavaScriptException();
+    return env.Null();
   }
 
-  if (input.Has("maxBlocks") && input.Get("maxBlocks").IsNumber()) {
-    const auto maxBlocks =
-        input.Get("maxBlocks").As<Napi::Number>().Int32Value();
-    options.maxBlocks = std::max(0, maxBlocks);
+  const auto images = info[0].As<Napi::Array>();
+  std::vector<OcrTask> tasks;
+  std::vector<Napi::ObjectReference> keepAlive;
+  tasks.reserve(images.Length());
+  keepAlive.reserve(images.Length());
+  for (uint32_t i = 0; i < images.Length(); ++i) {
+    const std::string subject =
+        std::string(name) + " images[" + std::to_string(i) + "]";
+    const auto image = images.Get(i);
+    if (!image.IsObject()) {
+      Napi::TypeError::New(env, subject + " must be an object")
+          .ThrowAsJavaScriptException();
+      return env.Null();
+    }
+    tasks.push_back(batchDefaults);
+    keepAlive.emplace_back();
+    if (!ParseTask(env, image.As<Napi::Object>(), subject, tasks.back(),
+                   keepAlive.back(), parseError)) {
+      parseError.ThrowAsJavaScriptException();
+      return env.Null();
+    }
   }
 
-  return true;
+  auto *context = new OcrRequestContext(env, ParseRequestId(info, 2), true,
+                                        tasks.size());
+  context->keepAlive = std::move(keepAlive);
+  context->service = std::move(service);
+  return SubmitOcrTasks(env, info[3].As<Napi::Function>(), std::move(tasks),
+                        context);
 }
 
-class RecognizeWorker : public Napi::AsyncWorker {
-public:
-  RecognizeWorker(Napi::Env env, OcrOptions options,
-                  Napi::Promise::Deferred deferred)
-      : Napi::AsyncWorker(env), options_(std::move(options)),
-        deferred_(deferred) {}
+// recognizeImageText(options, requestId?) -> Promise<result>
+//
+// A non-zero `requestId` lets cancelNativeOcr drop the call before it starts.
+Napi::Value RecognizeImageText(const Napi::CallbackInfo &info) {
+  return StartRecognize(info, "recognizeImageText", nullptr, nullptr);
+}
 
-  void Execute() override {
-    const auto startedAt = std::chrono::steady_clock::now();
+// recognizeImageTextBatch(images, options, requestId, onItem) -> Promise<void>
+//
+// `options` holds defaults each image may override. Results arrive through
+// onItem(index, result, error) in completion order, not input order.
+Napi::Value RecognizeImageTextBatch(const Napi::CallbackInfo &info) {
+  return StartRecognizeBatch(info, "recognizeImageTextBatch", nullptr,
+                             nullptr);
+}
 
-    if (!PerformPlatformOcr(options_, result_, error_)) {
-      if (error_.message.empty()) {
-        error_.message = "Native OCR recognition failed";
-      }
-      SetError(error_.message);
+// cancelNativeOcr(requestId) -> boolean
+//
+// Tasks of the call that have not started fail with ERR_OCR_ABORTED; one
+// already recognizing runs to completion.
+Napi::Value CancelNativeOcr(const Napi::CallbackInfo &info) {
+  return Napi::Boolean::New(
+      info.Env(),
+      AddonData(info.Env()).requests->Cancel(ParseRequestId(info, 0)));
+}
+
+// new OcrService(defaults?)
+//
+// A handle to create once and feed jobs for the life of the process (or
+// worker): recognize and recognizeBatch take the same arguments as the module
+// functions, with `defaults` filling in settings a call leaves out. close()
+// drops every job the service has queued; jobs already recognizing finish.
+class OcrServiceWrap : public Napi::ObjectWrap<OcrServiceWrap> {
+public:
+  static Napi::Function DefineClass(Napi::Env env) {
+    return ObjectWrap<OcrServiceWrap>::DefineClass(
+        env, "OcrService",
+        {
+            InstanceMethod("recognize", &OcrServiceWrap::Recognize),
+            InstanceMethod("recognizeBatch", &OcrServiceWrap::RecognizeBatch),
+            InstanceMethod("getStats", &OcrServiceWrap::GetStats),
+            InstanceMethod("close", &OcrServiceWrap::Close),
+        });
+  }
+
+  explicit OcrServiceWrap(const Napi::CallbackInfo &info)
+      : Napi::ObjectWrap<OcrServiceWrap>(info),
+        state_(std::make_shared<OcrServiceState>()) {
+    auto env = info.Env();
+    if (info.Length() < 1 || !info[0].IsObject()) {
+      return;
+    }
+    // Checked now so that bad defaults fail here rather than on every call.
+    OcrTask probe;
+    Napi::Error parseError = Napi::Error::New(env, "");
+    if (!ParseTaskOptions(env, info[0].As<Napi::Object>(), "OcrService options",
+                          probe, parseError)) {
+      parseError.ThrowAsJavaScriptException();
       return;
     }
+    defaults_ = Napi::Persistent(info[0].As<Napi::Object>());
+  }
 
-    if (result_.durationMs == 0) {
-      const auto elapsed =
-          std::chrono::duration_cast<std::chrono::milliseconds>(
-              std::chrono::steady_clock::now() - startedAt);
-      result_.durationMs =
-          static_cast<uint64_t>(std::max<int64_t>(0, elapsed.count()));
+private:
+  bool EnsureOpen(Napi::Env env) {
+    if (!state_->closed.load()) {
+      return true;
     }
+    auto error = Napi::Error::New(env, "OcrService is closed");
+    error.Value().Set("code", Napi::String::New(env, "ERR_OCR_SERVICE_CLOSED"));
+    error.ThrowAsJavaScriptException();
+    return false;
   }
 
-  void OnOK() override { deferred_.Resolve(ToJsResult(Env(), result_)); }
+  Napi::Value Recognize(const Napi::CallbackInfo &info) {
+    if (!EnsureOpen(info.Env())) {
+      return info.Env().Null();
+    }
+    const auto defaults = defaults_.IsEmpty() ? Napi::Object() : defaults_.Value();
+    return StartRecognize(info, "OcrService.recognize",
+                          defaults_.IsEmpty() ? nullptr : &defaults, state_);
+  }
 
-  void OnError(const Napi::Error &error) override {
-    auto errorObject = error.Value();
-    if (!error_.code.empty()) {
-      errorObject.Set("code", Napi::String::New(Env(), error_.code));
+  Napi::Value RecognizeBatch(const Napi::CallbackInfo &info) {
+    if (!EnsureOpen(info.Env())) {
+      return info.Env().Null();
+    }
+    const auto defaults = defaults_.IsEmpty() ? Napi::Object() : defaults_.Value();
+    return StartRecognizeBatch(info, "OcrService.recognizeBatch",
+                               defaults_.IsEmpty() ? nullptr : &defaults,
+                               state_);
+  }
+
+  Napi::Value GetStats(const Napi::CallbackInfo &info) {
+    auto env = info.Env();
+    const auto &state = *state_;
+    auto stats = Napi::Object::New(env);
+    stats.Set("submitted",
+              Napi::Number::New(env, static_cast<double>(state.submitted)));
+    stats.Set("succeeded",
+              Napi::Number::New(env, static_cast<double>(state.succeeded)));
+    stats.Set("failed",
+              Napi::Number::New(env, static_cast<double>(state.failed)));
+    stats.Set("pending",
+              Napi::Number::New(env, static_cast<double>(
+                                         state.submitted - state.succeeded -
+                                         state.failed)));
+    stats.Set("closed", Napi::Boolean::New(env, state.closed.load()));
+    return stats;
+  }
+
+  Napi::Value Close(const Napi::CallbackInfo &info) {
+    state_->closed.store(true);
+    return info.Env().Undefined();
+  }
+
+  std::shared_ptr<OcrServiceState> state_;
+  Napi::ObjectReference defaults_;
+};
+
+// new OcrSession(defaults?, { blockSize, tolerance, maxChangedFraction }?)
+//
+// Recognizes a stream of frames (screenshots of one window, say), each
+// compared with the one before: unchanged frames are answered from the
+// previous result and changed regions alone are recognized again. Frames are
+// meant to be sent one at a time; index.js queues them. reset() forgets the
+// previous frame and close() drops frames not yet started.
+class OcrSessionWrap : public Napi::ObjectWrap<OcrSessionWrap> {
+public:
+  static Napi::Function DefineClass(Napi::Env env) {
+    return ObjectWrap<OcrSessionWrap>::DefineClass(
+        env, "OcrSession",
+        {
+            InstanceMethod("recognize", &OcrSessionWrap::Recognize),
+            InstanceMethod("reset", &OcrSessionWrap::Reset),
+            InstanceMethod("getStats", &OcrSessionWrap::GetStats),
+            InstanceMethod("close", &OcrSessionWrap::Close),
+        });
+  }
+
+  explicit OcrSessionWrap(const Napi::CallbackInfo &info)
+      : Napi::ObjectWrap<OcrSessionWrap>(info),
+        state_(std::make_shared<OcrServiceState>()) {
+    auto env = info.Env();
+    OcrSessionOptions options;
+    if (info.Length() > 1 && info[1].IsObject() &&
+        !ParseSessionOptions(env, info[1].As<Napi::Object>(), options)) {
+      return;
+    }
+    session_ = std::make_shared<OcrSession>(options);
+    if (info.Length() < 1 || !info[0].IsObject()) {
+      return;
+    }
+    OcrTask probe;
+    Napi::Error parseError = Napi::Error::New(env, "");
+    if (!ParseTaskOptions(env, info[0].As<Napi::Object>(), "OcrSession options",
+                          probe, parseError)) {
+      parseError.ThrowAsJavaScriptException();
+      return;
     }
-    deferred_.Reject(errorObject);
+    defaults_ = Napi::Persistent(info[0].As<Napi::Object>());
   }
 
 private:
-  OcrOptions options_;
-  OcrResult result_;
-  OcrError error_;
-  Napi::Promise::Deferred deferred_;
+  static bool ParseSessionOptions(Napi::Env env, const Napi::Object &input,
+                                  OcrSessionOptions &options) {
+    const auto read = [&](const char *key, double min, double max,
+                          double &value) {
+      if (!input.Has(key) || input.Get(key).IsUndefined()) {
+        return true;
+      }
+      const double number = input.Get(key).IsNumber()
+                                ? input.Get(key).As<Napi::Number>().DoubleValue()
+                                : std::nan("");
+      if (!std::isfinite(number) || number < min || number > max) {
+        Napi::TypeError::New(env, std::string("OcrSession ") + key +
+                                      " must be a number between " +
+                                      std::to_string(static_cast<int>(min)) +
+                                      " and " +
+                                      std::to_string(static_cast<int>(max)))
+            .ThrowAsJavaScriptException();
+        return false;
+      }
+      value = number;
+      return true;
+    };
+    double blockSize = options.blockSize;
+    double tolerance = options.tolerance;
+    double maxChangedFraction = options.maxChangedFraction;
+    if (!read("blockSize", 4, 256, blockSize) ||
+        !read("tolerance", 0, 255, tolerance) ||
+        !read("maxChangedFraction", 0, 1, maxChangedFraction)) {
+      return false;
+    }
+    options.blockSize = static_cast<uint32_t>(blockSize);
+    options.tolerance = static_cast<uint8_t>(tolerance);
+    options.maxChangedFraction = maxChangedFraction;
+    return true;
+  }
+
+  Napi::Value Recognize(const Napi::CallbackInfo &info) {
+    auto env = info.Env();
+    if (state_->closed.load()) {
+      auto error = Napi::Error::New(env, "OcrSession is closed");
+      error.Value().Set("code",
+                        Napi::String::New(env, "ERR_OCR_SESSION_CLOSED"));
+      error.ThrowAsJavaScriptException();
+      return env.Null();
+    }
+    const auto defaults = defaults_.IsEmpty() ? Napi::Object() : defaults_.Value();
+    return StartRecognize(info, "OcrSession.recognize",
+                          defaults_.IsEmpty() ? nullptr : &defaults, state_,
+                          session_);
+  }
+
+  Napi::Value Reset(const Napi::CallbackInfo &info) {
+    session_->Reset();
+    return info.Env().Undefined();
+  }
+
+  Napi::Value GetStats(const Napi::CallbackInfo &info) {
+    auto env = info.Env();
+    const OcrSessionStats sessionStats = session_->Stats();
+    const auto &state = *state_;
+    auto stats = Napi::Object::New(env);
+    const auto set = [&](const char *key, uint64_t value) {
+      stats.Set(key, Napi::Number::New(env, static_cast<double>(value)));
+    };
+    set("submitted", state.submitted);
+    set("succeeded", state.succeeded);
+    set("failed", state.failed);
+    set("frames", sessionStats.frames);
+    set("fullFrames", sessionStats.fullFrames);
+    set("unchangedFrames", sessionStats.unchangedFrames);
+    set("incrementalFrames", sessionStats.incrementalFrames);
+    set("regions", sessionStats.regions);
+    set("reusedBlocks", sessionStats.reusedBlocks);
+    stats.Set("closed", Napi::Boolean::New(env, state.closed.load()));
+    return stats;
+  }
+
+  Napi::Value Close(const Napi::CallbackInfo &info) {
+    state_->closed.store(true);
+    session_->Reset();
+    return info.Env().Undefined();
+  }
+
+  std::shared_ptr<OcrServiceState> state_;
+  std::shared_ptr<OcrSession> session_;
+  Napi::ObjectReference defaults_;
 };
 
-Napi::Value RecognizeImageText(const Napi::CallbackInfo &info) {
+// configureNativeOcr({ threads, backgroundThreads })
+//
+// Omitted values fall back to the defaults (2 and 1).
+Napi::Value ConfigureNativeOcr(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  if (info.Length() < 1 || !info[0].IsObject()) {
+    Napi::TypeError::New(env, "configureNativeOcr expects an options object")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  const auto input = info[0].As<Napi::Object>();
+  const auto readCount = [&input](const char *key, int64_t fallback,
+                                  int64_t min) {
+    if (!input.Has(key) || !input.Get(key).IsNumber()) {
+      return static_cast<uint32_t>(fallback);
+    }
+    return static_cast<uint32_t>(std::clamp(
+        input.Get(key).As<Napi::Number>().Int64Value(), min, int64_t{16}));
+  };
+  ConfigurePlatformOcr(readCount("threads", 2, 1),
+                       readCount("backgroundThreads", 1, 0));
+  return env.Undefined();
+}
+
+// getNativeMetrics(): stage timings and counters of every call in the
+// process, plus the pool's queue depths right now.
+Napi::Value GetNativeMetrics(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  const OcrEnginePoolStats pool = PlatformOcrStats();
+  auto queues = Napi::Object::New(env);
+  queues.Set("interactive", Napi::Number::New(env, pool.queuedInteractive));
+  queues.Set("background", Napi::Number::New(env, pool.queuedBackground));
+  queues.Set("busyThreads", Napi::Number::New(env, pool.busyThreads));
+  queues.Set("threads", Napi::Number::New(env, pool.threads));
+
+  auto metrics = ToJsNativeMetrics(env, OcrMetrics());
+  metrics.Set("queues", queues);
+  return metrics;
+}
+
+// configureNativeMetrics({ enabled?, traceCapacity?, reset? })
+Napi::Value ConfigureNativeMetricsSync(const Napi::CallbackInfo &info) {
+  if (!ConfigureNativeMetrics(info, OcrMetrics())) {
+    return info.Env().Null();
+  }
+  return GetNativeMetrics(info);
+}
+
+Napi::Value DrainNativeTraceSpans(const Napi::CallbackInfo &info) {
+  return DrainJsTraceSpans(info.Env(), OcrMetrics());
+}
+
+// preprocessOcrImage({ pixels, width, height, stride?, pixelFormat?,
+//                      preprocess })
+//
+// Runs the preprocessing steps recognition would run, on the calling thread,
+// and returns the pixels the engine would see. Raw pixels only: decoding
+// belongs to the platform codec, which not every JS thread can use.
+Napi::Value PreprocessOcrImageSync(const Napi::CallbackInfo &info) {
   auto env = info.Env();
+  if (info.Length() < 1 || !info[0].IsObject()) {
+    Napi::TypeError::New(env, "preprocessOcrImage expects an options object")
+        .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  const auto input = info[0].As<Napi::Object>();
+  OcrOptions options;
+  Napi::Error parseError;
+  if (!ParsePixels(env, input, "preprocessOcrImage options", options.image,
+                   parseError) ||
+      !ParsePreprocessOptions(env, input, "preprocessOcrImage options",
+                              options.preprocess, parseError)) {
+    parseError.ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  OcrPreprocessReport report;
+  OcrError error;
+  if (!PreprocessOcrImage(options, report, error)) {
+    ToJsError(env, error).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  const OcrImage &image = options.image;
+  const uint32_t rowBytes =
+      image.width * (image.format == OcrPixelFormat::kGray8 ? 1 : 4);
+  auto pixels = Napi::Buffer<uint8_t>::New(
+      env, static_cast<size_t>(rowBytes) * image.height);
+  for (uint32_t y = 0; y < image.height; ++y) {
+    std::memcpy(pixels.Data() + static_cast<size_t>(y) * rowBytes,
+                image.data + static_cast<size_t>(y) * image.stride, rowBytes);
+  }
+
+  auto output = Napi::Object::New(env);
+  output.Set("pixels", pixels);
+  output.Set("pixelFormat",
+             Napi::String::New(env, image.format == OcrPixelFormat::kGray8
+                                        ? "gray"
+                                        : "bgra"));
+  output.Set("width", Napi::Number::New(env, image.width));
+  output.Set("height", Napi::Number::New(env, image.height));
+  output.Set("stride", Napi::Number::New(env, rowBytes));
+  output.Set("report", ToJsPreprocessReport(env, report));
+  return output;
+}
 
+// detectImageText({ pixels, width, height, stride?, pixelFormat?,
+//                   preprocess? })
+//
+// Rates how likely raw pixels are to hold text, on the calling thread, as
+// the check of `textDetection` does before recognition: { score, glyphs,
+// lines, durationMs }. Preprocessing runs first when given.
+Napi::Value DetectImageTextSync(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
   if (info.Length() < 1 || !info[0].IsObject()) {
-    Napi::TypeError::New(env, "recognizeImageText expects an options object")
+    Napi::TypeError::New(env, "detectImageText expects an options object")
         .ThrowAsJavaScriptException();
     return env.Null();
   }
 
+  const auto input = info[0].As<Napi::Object>();
   OcrOptions options;
-  Napi::Error parseError = Napi::Error::New(env, "");
-  if (!ParseOptions(env, info[0].As<Napi::Object>(), options, parseError)) {
+  Napi::Error parseError;
+  if (!ParsePixels(env, input, "detectImageText options", options.image,
+                   parseError) ||
+      !ParsePreprocessOptions(env, input, "detectImageText options",
+                              options.preprocess, parseError)) {
     parseError.ThrowAsJavaScriptException();
     return env.Null();
   }
 
-  auto deferred = Napi::Promise::Deferred::New(env);
-  auto *worker = new RecognizeWorker(env, std::move(options), deferred);
-  worker->Queue();
-  return deferred.Promise();
+  OcrPreprocessReport preprocess;
+  OcrTextDetectionReport report;
+  OcrError error;
+  if (!PreprocessOcrImage(options, preprocess, error)) {
+    ToJsError(env, error).ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  DetectText(options.image, report);
+  return ToJsTextDetectionReport(env, report);
+}
+
+Napi::Value GetOcrCacheStats(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  const auto stats = OcrResultCache::Instance().Stats();
+  const auto number = [&env](auto value) {
+    return Napi::Number::New(env, static_cast<double>(value));
+  };
+  auto result = Napi::Object::New(env);
+  result.Set("hits", number(stats.hits));
+  result.Set("misses", number(stats.misses));
+  result.Set("perceptualHits", number(stats.perceptualHits));
+  result.Set("diskHits", number(stats.diskHits));
+  result.Set("insertions", number(stats.insertions));
+  result.Set("evictions", number(stats.evictions));
+  result.Set("entries", number(stats.entries));
+  result.Set("bytes", number(stats.bytes));
+  result.Set("diskBytes", number(stats.diskBytes));
+  result.Set("maxBytes", number(stats.config.maxBytes));
+  result.Set("maxDiskBytes", number(stats.config.maxDiskBytes));
+  result.Set("perceptual", Napi::Boolean::New(env, stats.config.perceptual));
+  result.Set("perceptualMaxDistance",
+             number(stats.config.perceptualMaxDistance));
+  if (!stats.config.directory.empty()) {
+    result.Set("directory", Napi::String::New(env, stats.config.directory));
+  }
+  return result;
+}
+
+// configureOcrCache({ maxBytes?, perceptual?, perceptualMaxDistance?,
+//                     directory?, maxDiskBytes? }): omitted keys keep their
+// value, maxBytes 0 disables the cache and directory null or '' keeps it in
+// memory only.
+Napi::Value ConfigureOcrCache(const Napi::CallbackInfo &info) {
+  auto &cache = OcrResultCache::Instance();
+  auto config = cache.Stats().config;
+  if (info.Length() >= 1 && info[0].IsObject()) {
+    const auto input = info[0].As<Napi::Object>();
+    const auto readSize = [&input](const char *key, size_t &value) {
+      if (input.Has(key) && input.Get(key).IsNumber()) {
+        value = static_cast<size_t>(std::max<int64_t>(
+            0, input.Get(key).As<Napi::Number>().Int64Value()));
+      }
+    };
+    readSize("maxBytes", config.maxBytes);
+    readSize("maxDiskBytes", config.maxDiskBytes);
+    if (input.Has("perceptual") && input.Get("perceptual").IsBoolean()) {
+      config.perceptual = input.Get("perceptual").As<Napi::Boolean>().Value();
+    }
+    if (input.Has("perceptualMaxDistance") &&
+        input.Get("perceptualMaxDistance").IsNumber()) {
+      config.perceptualMaxDistance = static_cast<uint32_t>(std::clamp<int64_t>(
+          input.Get("perceptualMaxDistance").As<Napi::Number>().Int64Value(),
+          0, 1024));
+    }
+    if (input.Has("directory")) {
+      const auto directory = input.Get("directory");
+      if (directory.IsString()) {
+        config.directory = directory.As<Napi::String>().Utf8Value();
+      } else if (directory.IsNull()) {
+        config.directory.clear();
+      }
+    }
+  }
+  cache.Configure(config);
+  return GetOcrCacheStats(info);
+}
+
+Napi::Value ClearOcrCache(const Napi::CallbackInfo &info) {
+  OcrResultCache::Instance().Clear();
+  return info.Env().Undefined();
 }
 
 Napi::Value GetNativeOcrSupport(const Napi::CallbackInfo &info) {
@@ -167,6 +872,13 @@ Napi::Value GetNativeOcrSupport(const Napi::CallbackInfo &info) {
 #elif defined(_WIN32)
   support.Set("supported", Napi::Boolean::New(env, true));
   support.Set("platform", Napi::String::New(env, "win32"));
+#elif defined(__linux__)
+  const std::string reason = ProbePlatformOcrEngine();
+  support.Set("supported", Napi::Boolean::New(env, reason.empty()));
+  support.Set("platform", Napi::String::New(env, "linux"));
+  if (!reason.empty()) {
+    support.Set("reason", Napi::String::New(env, reason));
+  }
 #else
   support.Set("supported", Napi::Boolean::New(env, false));
   support.Set("platform", Napi::String::New(env, "unsupported"));
@@ -326,8 +1038,39 @@ Napi::Value GetNotificationAuthorizationStatus(const Napi::CallbackInfo &info) {
 } // namespace
 
 Napi::Object Init(Napi::Env env, Napi::Object exports) {
+  env.SetInstanceData(new OcrAddonData());
+
   exports.Set("recognizeImageText", Napi::Function::New(env, RecognizeImageText,
                                                         "recognizeImageText"));
+  exports.Set("recognizeImageTextBatch",
+              Napi::Function::New(env, RecognizeImageTextBatch,
+                                  "recognizeImageTextBatch"));
+  exports.Set("cancelNativeOcr",
+              Napi::Function::New(env, CancelNativeOcr, "cancelNativeOcr"));
+  exports.Set("configureNativeOcr",
+              Napi::Function::New(env, ConfigureNativeOcr, "configureNativeOcr"));
+  exports.Set("OcrService", OcrServiceWrap::DefineClass(env));
+  exports.Set("OcrSession", OcrSessionWrap::DefineClass(env));
+  exports.Set("getOcrCacheStats",
+              Napi::Function::New(env, GetOcrCacheStats, "getOcrCacheStats"));
+  exports.Set("configureOcrCache",
+              Napi::Function::New(env, ConfigureOcrCache, "configureOcrCache"));
+  exports.Set("clearOcrCache",
+              Napi::Function::New(env, ClearOcrCache, "clearOcrCache"));
+  exports.Set("getNativeMetrics",
+              Napi::Function::New(env, GetNativeMetrics, "getNativeMetrics"));
+  exports.Set("configureNativeMetrics",
+              Napi::Function::New(env, ConfigureNativeMetricsSync,
+                                  "configureNativeMetrics"));
+  exports.Set("drainNativeTraceSpans",
+              Napi::Function::New(env, DrainNativeTraceSpans,
+                                  "drainNativeTraceSpans"));
+  exports.Set("preprocessOcrImage",
+              Napi::Function::New(env, PreprocessOcrImageSync,
+                                  "preprocessOcrImage"));
+  exports.Set("detectImageText",
+              Napi::Function::New(env, DetectImageTextSync,
+                                  "detectImageText"));
   exports.Set(
       "getNativeOcrSupport",
       Napi::Function::New(env, GetNativeOcrSupport, "getNativeOcrSupport"));
@@ -0,0 +1,625 @@
+#include <napi.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "common/image_preprocess.h"
+#include "common/js_string.h"
+#include "common/native_metrics.h"
+#include "common/ocr_layout.h"
+#include "common/ocr_metrics.h"
+#include "common/ocr_result_cache.h"
+#include "common/ocr_tiling.h"
+#include "common/ocr_types.h"
+#include "common/text_detect.h"
+#include "common/utf_transcode.h"
+#include "everything/columnar_encoding.h"
+#include "everything/everything_sdk.h"
+#include "everything/search_marshal.h"
+#include "everything/search_metrics.h"
+#include "everything/search_types.h"
+#include "ocr_marshal.h"
+
+// Microbenchmarks of the per-row and per-block work of both addons, built
+// only with `node-gyp rebuild -- -Dtuff_native_bench=1` and driven by
+// scripts/bench-native.js. Marshalling needs a live JS heap, so this is an
+// addon rather than a plain executable; everything else links the same
+// sources the addons do. The Everything SDK is whatever
+// TALEX_EVERYTHING_DLL_PATH names, which the script points at the stand-in in
+// fixtures/everything-sdk-stub.
+
+namespace tuff::native {
+
+namespace {
+
+using everything::SearchRow;
+
+// Written by every benchmark so the optimizer cannot drop the work.
+volatile size_t g_sink = 0;
+
+void Sink(size_t value) {
+  g_sink = g_sink + value;
+}
+
+struct BenchOptions {
+  std::string filter;
+  double minTimeMs = 200;
+};
+
+// Times each benchmark in batches grown until one takes a millisecond, then
+// repeats batches until `minTimeMs` have passed. Every call gets its own
+// HandleScope, so JS values a body creates are collectable between calls.
+class BenchRunner {
+ public:
+  BenchRunner(Napi::Env env, BenchOptions options)
+      : env_(env), options_(std::move(options)), results_(Napi::Array::New(env)) {}
+
+  bool Selected(const char* name) const {
+    return options_.filter.empty() || std::string(name).find(options_.filter) != std::string::npos;
+  }
+
+  // `items` is what one call of `body` handles (rows, blocks, pixels), in
+  // `unit`s. With `metrics`, its stages are timed too and reported with the
+  // result, which costs a few atomic adds per stage.
+  template <typename Body>
+  void Run(const char* name, const char* unit, size_t items, Body&& body, NativeMetrics* metrics = nullptr) {
+    if (!Selected(name)) {
+      return;
+    }
+    if (metrics != nullptr) {
+      metrics->Configure(true, 0);
+    }
+    // Warms caches, engines and the first allocations.
+    TimeBatch(body, 1);
+    if (metrics != nullptr) {
+      metrics->Reset();
+    }
+
+    uint64_t batch = 1;
+    while (batch < (1U << 20) && TimeBatch(body, batch) < 1e6) {
+      batch *= 2;
+    }
+
+    std::vector<double> samples;
+    double totalNanos = 0;
+    uint64_t iterations = 0;
+    while (totalNanos < options_.minTimeMs * 1e6 || samples.size() < 5) {
+      const double nanos = TimeBatch(body, batch);
+      samples.push_back(nanos / static_cast<double>(batch));
+      totalNanos += nanos;
+      iterations += batch;
+    }
+    std::sort(samples.begin(), samples.end());
+    const double median = samples[samples.size() / 2];
+
+    auto result = Napi::Object::New(env_);
+    result.Set("name", Napi::String::New(env_, name));
+    result.Set("unit", Napi::String::New(env_, unit));
+    result.Set("items", Napi::Number::New(env_, static_cast<double>(items)));
+    result.Set("iterations", Napi::Number::New(env_, static_cast<double>(iterations)));
+    result.Set("nsPerOp", Napi::Number::New(env_, median));
+    result.Set("minNsPerOp", Napi::Number::New(env_, samples.front()));
+    result.Set("nsPerItem", Napi::Number::New(env_, items > 0 ? median / static_cast<double>(items) : median));
+    if (metrics != nullptr) {
+      result.Set("stages", ToJsStages(*metrics));
+      metrics->Configure(false, 0);
+    }
+    results_.Set(results_.Length(), result);
+  }
+
+  // For a benchmark whose setup failed, such as the SDK stand-in not loading.
+  void Skip(const char* name, const std::string& reason) {
+    if (!Selected(name)) {
+      return;
+    }
+    auto result = Napi::Object::New(env_);
+    result.Set("name", Napi::String::New(env_, name));
+    result.Set("skipped", Napi::String::New(env_, reason));
+    results_.Set(results_.Length(), result);
+  }
+
+  Napi::Array results() const { return results_; }
+
+ private:
+  template <typename Body>
+  double TimeBatch(Body& body, uint64_t batch) {
+    const uint64_t start = NativeMetrics::Now();
+    for (uint64_t i = 0; i < batch; ++i) {
+      Napi::HandleScope scope(env_);
+      body();
+    }
+    return static_cast<double>(NativeMetrics::Now() - start);
+  }
+
+  // { [stage]: { count, meanNs, p95Ns } } for the stages that ran.
+  Napi::Object ToJsStages(const NativeMetrics& metrics) {
+    auto stages = Napi::Object::New(env_);
+    for (uint32_t i = 0; i < metrics.stageCount(); ++i) {
+      const LatencyHistogram::Snapshot snapshot = metrics.ReadStage(i);
+      if (snapshot.count == 0) {
+        continue;
+      }
+      auto stage = Napi::Object::New(env_);
+      stage.Set("count", Napi::Number::New(env_, static_cast<double>(snapshot.count)));
+      stage.Set("meanNs", Napi::Number::New(env_, static_cast<double>(snapshot.totalNanos) /
+                                                      static_cast<double>(snapshot.count)));
+      stage.Set("p95Ns", Napi::Number::New(env_, static_cast<double>(snapshot.Quantile(0.95))));
+      stages.Set(metrics.stageName(i), stage);
+    }
+    return stages;
+  }
+
+  Napi::Env env_;
+  BenchOptions options_;
+  Napi::Array results_;
+};
+
+// ---- Fixtures ----
+
+// A page of `lines` recognized lines of `words` words each, laid out like a
+// screenshot of text.
+OcrResult MakeOcrResult(uint32_t lines, uint32_t words) {
+  OcrResult result;
+  result.language = "en";
+  result.engine = "bench";
+  result.hasConfidence = true;
+  result.confidence = 0.91;
+  for (uint32_t line = 0; line < lines; ++line) {
+    OcrBlock block;
+    double x = 24;
+    const double y = 16 + line * 28.0;
+    for (uint32_t word = 0; word < words; ++word) {
+      OcrWord item;
+      item.text = "word" + std::to_string(line * words + word);
+      item.hasConfidence = true;
+      item.confidence = 0.8 + (word % 5) * 0.04;
+      const double width = 9.0 * static_cast<double>(item.text.size());
+      item.boundingBox = {x, y, width, 18};
+      x += width + 8;
+      block.text += (word == 0 ? "" : " ") + item.text;
+      block.words.push_back(std::move(item));
+    }
+    block.hasConfidence = true;
+    block.confidence = 0.9;
+    block.hasBoundingBox = true;
+    block.boundingBox = {24, y, x - 32, 18};
+    result.text += (line == 0 ? "" : "\n") + block.text;
+    result.blocks.push_back(std::move(block));
+  }
+  return result;
+}
+
+// Light gray with lines of dark "n"-shaped glyphs, so text detection and
+// binarization have something to find.
+std::vector<uint8_t> MakeTextPage(uint32_t width, uint32_t height) {
+  std::vector<uint8_t> pixels(static_cast<size_t>(width) * height, 236);
+  const auto ink = [&](uint32_t x, uint32_t y, uint32_t length) {
+    std::fill_n(pixels.begin() + static_cast<size_t>(y) * width + x, length, uint8_t{32});
+  };
+  for (uint32_t top = 20; top + 14 < height; top += 28) {
+    for (uint32_t left = 24; left + 10 < width - 24; left += 14) {
+      if ((left / 14 + top / 28) % 7 == 6) {
+        continue;  // A word gap.
+      }
+      for (uint32_t y = top; y < top + 14; ++y) {
+        ink(left, y, y < top + 2 ? 10 : 2);
+        ink(left + 8, y, 2);
+      }
+    }
+  }
+  return pixels;
+}
+
+OcrImage GrayImage(const std::vector<uint8_t>& pixels, uint32_t width, uint32_t height) {
+  OcrImage image;
+  image.data = pixels.data();
+  image.size = pixels.size();
+  image.format = OcrPixelFormat::kGray8;
+  image.width = width;
+  image.height = height;
+  image.stride = width;
+  return image;
+}
+
+// What recognizing each tile of a 4K capture in 1024 px tiles could give: one
+// line every 36 px across the tile's width, so neighbours see the lines of
+// their overlap twice.
+void MakeTileResults(std::vector<OcrTile>& tiles, std::vector<OcrResult>& results) {
+  tiles = PlanOcrTiles(3840, 2160, 1024, 128);
+  results.assign(tiles.size(), OcrResult{});
+  for (size_t i = 0; i < tiles.size(); ++i) {
+    const OcrTile& tile = tiles[i];
+    for (uint32_t y = 40; y + 20 < 2160; y += 36) {
+      if (y < tile.y || y + 20 > tile.y + tile.height) {
+        continue;
+      }
+      OcrBlock block;
+      block.text = "line " + std::to_string(y / 36) + " of column " + std::to_string(tile.x / 512);
+      block.hasBoundingBox = true;
+      block.boundingBox = {8, static_cast<double>(y - tile.y), static_cast<double>(tile.width) - 16, 20};
+      results[i].text += (results[i].text.empty() ? "" : "\n") + block.text;
+      results[i].blocks.push_back(std::move(block));
+    }
+  }
+}
+
+// File paths shaped like an Everything result set: a few hundred deep
+// directories, one in seven with non-ASCII names.
+std::vector<std::string> MakePaths(size_t count) {
+  static const char* const kDirectories[] = {
+      "/home/bench/projects/tuff/packages/tuff-native/native/src/everything",
+      "/home/bench/Documents/报告/2024/季度",
+      "/home/bench/.cache/node-gyp/20.11.0/include/node",
+      "/mnt/data/photos/Café del Mar/raw",
+      "/usr/share/icons/hicolor/256x256/apps",
+  };
+  std::vector<std::string> paths;
+  paths.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    std::string path = kDirectories[i % 5];
+    path += "/module-" + std::to_string(i % 311);
+    path += i % 7 == 3 ? "/ノート-" : "/file-";
+    path += std::to_string(i);
+    path += i % 4 == 0 ? ".ts" : ".json";
+    paths.push_back(std::move(path));
+  }
+  return paths;
+}
+
+std::vector<SearchRow> MakeRows(const std::vector<std::string>& paths) {
+  std::vector<SearchRow> rows;
+  rows.reserve(paths.size());
+  for (size_t i = 0; i < paths.size(); ++i) {
+    SearchRow row;
+    row.fullPath = paths[i];
+    const size_t slash = row.fullPath.rfind('/');
+    row.path = row.fullPath.substr(0, slash);
+    row.name = row.fullPath.substr(slash + 1);
+    row.extension = row.name.substr(row.name.rfind('.') + 1);
+    row.hasSize = true;
+    row.size = static_cast<double>(i * 1024);
+    row.hasDateModified = true;
+    row.dateModified = 1704067200000.0 + static_cast<double>(i) * 1000;
+    row.hasDateCreated = true;
+    row.dateCreated = row.dateModified;
+    row.hasIsFolder = true;
+    row.isFolder = i % 5 == 4;
+    rows.push_back(std::move(row));
+  }
+  return rows;
+}
+
+// An engine that answers at once with a fixed page, so the pool benchmarks
+// time everything around recognition.
+class StubEngine : public OcrEngine {
+ public:
+  explicit StubEngine(const OcrResult& page) : page_(page) {}
+
+  bool Recognize(const OcrOptions&, OcrResult& result, OcrError&) override {
+    result = page_;
+    return true;
+  }
+
+ private:
+  const OcrResult& page_;
+};
+
+class StubEngineFactory : public OcrEngineFactory {
+ public:
+  explicit StubEngineFactory(const OcrResult& page) : page_(page) {}
+
+  std::unique_ptr<OcrEngine> Create(const std::string&, OcrError&) override {
+    return std::make_unique<StubEngine>(page_);
+  }
+
+ private:
+  const OcrResult& page_;
+};
+
+// ---- Benchmarks ----
+
+void BenchOcrMarshal(BenchRunner& bench, Napi::Env env) {
+  const OcrResult page = MakeOcrResult(200, 8);
+  bench.Run("ocr.toJsResult.objects", "block", page.blocks.size(),
+            [&] { Sink(ToJsResult(env, page).IsEmpty() ? 0 : 1); });
+  bench.Run("ocr.toJsResult.compact", "block", page.blocks.size(),
+            [&] { Sink(ToJsResult(env, page, true).IsEmpty() ? 0 : 1); });
+
+  auto preprocess = Napi::Object::New(env);
+  preprocess.Set("grayscale", Napi::Boolean::New(env, true));
+  preprocess.Set("targetTextHeight", Napi::Number::New(env, 24));
+  preprocess.Set("binarize", Napi::Boolean::New(env, true));
+  auto tiling = Napi::Object::New(env);
+  tiling.Set("tileSize", Napi::Number::New(env, 1024));
+  auto textDetection = Napi::Object::New(env);
+  textDetection.Set("enabled", Napi::Boolean::New(env, true));
+  auto options = Napi::Object::New(env);
+  options.Set("languageHint", Napi::String::New(env, "en-US"));
+  options.Set("includeLayout", Napi::Boolean::New(env, true));
+  options.Set("includeWords", Napi::Boolean::New(env, true));
+  options.Set("maxBlocks", Napi::Number::New(env, 100));
+  options.Set("preprocess", preprocess);
+  options.Set("tiling", tiling);
+  options.Set("textDetection", textDetection);
+  bench.Run("ocr.parseTaskOptions", "call", 1, [&] {
+    OcrTask task;
+    Napi::Error error;
+    Sink(ParseTaskOptions(env, options, "options", task, error) ? 1 : 0);
+  });
+
+  const std::vector<uint8_t> pixels = MakeTextPage(640, 360);
+  options.Set("pixels", Napi::Buffer<uint8_t>::Copy(env, pixels.data(), pixels.size()));
+  options.Set("pixelFormat", Napi::String::New(env, "gray"));
+  options.Set("width", Napi::Number::New(env, 640));
+  options.Set("height", Napi::Number::New(env, 360));
+  bench.Run("ocr.parseTask.pixels", "call", 1, [&] {
+    OcrTask task;
+    Napi::ObjectReference keepAlive;
+    Napi::Error error;
+    Sink(ParseTask(env, options, "options", task, keepAlive, error) ? 1 : 0);
+  });
+}
+
+void BenchOcrStages(BenchRunner& bench) {
+  const uint32_t width = 1920;
+  const uint32_t height = 1080;
+  const std::vector<uint8_t> pixels = MakeTextPage(width, height);
+  const size_t pixelCount = static_cast<size_t>(width) * height;
+
+  bench.Run("ocr.preprocess.binarize", "pixel", pixelCount, [&] {
+    OcrOptions options;
+    options.image = GrayImage(pixels, width, height);
+    options.preprocess.binarize = true;
+    OcrPreprocessReport report;
+    OcrError error;
+    Sink(PreprocessOcrImage(options, report, error) ? options.image.size : 0);
+  });
+  bench.Run("ocr.preprocess.downscale", "pixel", pixelCount, [&] {
+    OcrOptions options;
+    options.image = GrayImage(pixels, width, height);
+    options.preprocess.targetTextHeight = 7;
+    OcrPreprocessReport report;
+    OcrError error;
+    Sink(PreprocessOcrImage(options, report, error) ? options.image.size : 0);
+  });
+  bench.Run("ocr.textDetection", "pixel", pixelCount, [&] {
+    OcrTextDetectionReport report;
+    Sink(DetectText(GrayImage(pixels, width, height), report) ? report.glyphs : 0);
+  });
+
+  std::vector<OcrTile> tiles;
+  std::vector<OcrResult> tileResults;
+  MakeTileResults(tiles, tileResults);
+  size_t tileBlocks = 0;
+  for (const auto& result : tileResults) {
+    tileBlocks += result.blocks.size();
+  }
+  const std::vector<OcrError> tileErrors(tiles.size());
+  const std::vector<char> succeeded(tiles.size(), 1);
+  // MergeOcrTiles consumes its input, so the copy is part of the timing.
+  bench.Run("ocr.tileMerge", "block", tileBlocks, [&] {
+    std::vector<OcrResult> results = tileResults;
+    OcrResult merged;
+    OcrError error;
+    Sink(MergeOcrTiles(tiles, results, tileErrors, succeeded, merged, error) ? merged.blocks.size() : 0);
+  });
+
+  const OcrResult page = MakeOcrResult(200, 8);
+  std::vector<uint8_t> layoutBuffer;
+  bench.Run("ocr.compactLayout.write", "block", page.blocks.size(), [&] {
+    const OcrCompactLayout layout = PlanOcrCompactLayout(page.blocks);
+    // Floats need the alignment a vector of uint8_t does not promise; its
+    // allocator gives it in practice, as ArrayBuffer stores do.
+    layoutBuffer.resize(layout.byteLength);
+    WriteOcrCompactLayout(page.blocks, layout, layoutBuffer.data());
+    Sink(layout.byteLength);
+  });
+
+  OcrResultCache& cache = OcrResultCache::Instance();
+  const OcrResultCacheConfig cacheDefaults;
+  cache.Configure(cacheDefaults);
+  cache.Clear();
+  OcrOptions keyed;
+  keyed.image = GrayImage(pixels, width, height);
+  bench.Run("ocr.cache.key", "pixel", pixelCount, [&] {
+    OcrResultCacheKey key;
+    OcrResultCache::MakeKey(keyed, "en", key);
+    OcrResultCache::AddPerceptualHash(keyed.image, key);
+    Sink(key.exact.size());
+  });
+
+  // The whole pool path against an engine that costs nothing: queueing and
+  // the hand-off to a lane, the cache, preprocessing and the lane bookkeeping.
+  const OcrResult answer = MakeOcrResult(40, 6);
+  OcrEnginePoolOptions poolOptions;
+  poolOptions.threads = 1;
+  poolOptions.backgroundThreads = 0;
+  OcrEnginePool pool(std::make_unique<StubEngineFactory>(answer), poolOptions);
+  const std::vector<uint8_t> frame = MakeTextPage(640, 360);
+  OcrOptions recognize;
+  recognize.image = GrayImage(frame, 640, 360);
+  recognize.includeLayout = true;
+  recognize.preprocess.binarize = true;
+
+  OcrResultCacheConfig disabled;
+  disabled.maxBytes = 0;
+  cache.Configure(disabled);
+  bench.Run("ocr.pipeline.stubEngine", "call", 1, [&] {
+    OcrResult result;
+    OcrError error;
+    Sink(pool.Recognize(recognize, result, error) ? result.blocks.size() : 0);
+  }, &OcrMetrics());
+
+  cache.Configure(cacheDefaults);
+  bench.Run("ocr.pipeline.cacheHit", "call", 1, [&] {
+    OcrResult result;
+    OcrError error;
+    Sink(pool.Recognize(recognize, result, error) ? result.blocks.size() : 0);
+  }, &OcrMetrics());
+  cache.Clear();
+}
+
+// The shared string layer against what it replaced: napi_create_string_utf8
+// for every string.
+void BenchStrings(BenchRunner& bench, Napi::Env env) {
+  const std::vector<std::string> paths = MakePaths(everything::kMaxResultsLimit);
+  std::vector<std::string_view> parents;
+  parents.reserve(paths.size());
+  for (const auto& path : paths) {
+    parents.emplace_back(path.data(), path.rfind('/'));
+  }
+
+  std::u16string utf16;
+  std::string utf8;
+  bench.Run("string.utf8ToUtf16", "string", paths.size(), [&] {
+    size_t total = 0;
+    for (const auto& path : paths) {
+      Utf8ToUtf16(path, utf16);
+      total += utf16.size();
+    }
+    Sink(total);
+  });
+  std::vector<std::u16string> utf16Paths(paths.size());
+  for (size_t i = 0; i < paths.size(); ++i) {
+    Utf8ToUtf16(paths[i], utf16Paths[i]);
+  }
+  bench.Run("string.utf16ToUtf8", "string", utf16Paths.size(), [&] {
+    size_t total = 0;
+    for (const auto& path : utf16Paths) {
+      Utf16ToUtf8(path.data(), path.size(), utf8);
+      total += utf8.size();
+    }
+    Sink(total);
+  });
+
+  bench.Run("string.toJs.napiUtf8", "string", paths.size(), [&] {
+    for (const auto& path : paths) {
+      Sink(Napi::String::New(env, path.data(), path.size()).IsEmpty() ? 0 : 1);
+    }
+  });
+  bench.Run("string.toJs.jsStrings", "string", paths.size(), [&] {
+    JsStrings strings(env);
+    for (const auto& path : paths) {
+      Sink(strings.New(path).IsEmpty() ? 0 : 1);
+    }
+  });
+  bench.Run("string.toJs.parentsInterned", "string", parents.size(), [&] {
+    JsStrings strings(env);
+    for (const auto parent : parents) {
+      Sink(strings.Intern(parent).IsEmpty() ? 0 : 1);
+    }
+  });
+}
+
+void BenchEverything(BenchRunner& bench, Napi::Env env) {
+  const std::vector<std::string> paths = MakePaths(everything::kMaxResultsLimit);
+  std::vector<std::wstring> widePaths;
+  widePaths.reserve(paths.size());
+  for (const auto& path : paths) {
+    widePaths.push_back(Utf8ToWide(path));
+  }
+  bench.Run("everything.utf8ToWide", "string", paths.size(), [&] {
+    size_t total = 0;
+    for (const auto& path : paths) {
+      total += Utf8ToWide(path).size();
+    }
+    Sink(total);
+  });
+  bench.Run("everything.wideToUtf8", "string", widePaths.size(), [&] {
+    size_t total = 0;
+    for (const auto& path : widePaths) {
+      total += WideToUtf8(path).size();
+    }
+    Sink(total);
+  });
+
+  everything::SearchOptions options;
+  options.maxResults = everything::kMaxResultsLimit;
+  std::vector<SearchRow> rows;
+  everything::SearchError error;
+  if (!everything::EverythingApi::IsConfigured()) {
+    bench.Skip("everything.query", "TALEX_EVERYTHING_DLL_PATH is not set");
+  } else if (!everything::QueryEverything("bench", options, rows, error)) {
+    bench.Skip("everything.query", error.message);
+  } else {
+    // The stand-in builds its rows inside Everything_QueryW, which the query
+    // stage covers; rowBuild is the addon's copy of them.
+    bench.Run("everything.query", "row", rows.size(), [&] {
+      std::vector<SearchRow> queried;
+      everything::SearchError queryError;
+      Sink(everything::QueryEverything("bench", options, queried, queryError) ? queried.size() : 0);
+    }, &everything::SearchMetrics());
+  }
+
+  const std::vector<SearchRow> synthetic = MakeRows(paths);
+  bench.Run("everything.toJsRows.all", "row", synthetic.size(),
+            [&] { Sink(everything::ToJsRows(env, synthetic, everything::kAllFields).Length()); });
+  bench.Run("everything.toJsRows.nameAndPath", "row", synthetic.size(), [&] {
+    Sink(everything::ToJsRows(env, synthetic, everything::kFieldName | everything::kFieldFullPath).Length());
+  });
+  std::vector<uint8_t> columnar;
+  bench.Run("everything.encodeColumnar", "row", synthetic.size(), [&] {
+    columnar.resize(everything::ColumnarByteLength(synthetic));
+    everything::EncodeColumnar(synthetic, everything::kAllFields, columnar.data());
+    Sink(columnar.size());
+  });
+
+  auto fields = Napi::Array::New(env, 3);
+  fields.Set(0u, Napi::String::New(env, "name"));
+  fields.Set(1u, Napi::String::New(env, "fullPath"));
+  fields.Set(2u, Napi::String::New(env, "dateModified"));
+  auto rawOptions = Napi::Object::New(env);
+  rawOptions.Set("maxResults", Napi::Number::New(env, 200));
+  rawOptions.Set("offset", Napi::Number::New(env, 0));
+  rawOptions.Set("sort", Napi::Number::New(env, everything::kSortDateModifiedDescending));
+  rawOptions.Set("matchPath", Napi::Boolean::New(env, true));
+  rawOptions.Set("fields", fields);
+  bench.Run("everything.parseSearchOptions", "call", 1, [&] {
+    everything::SearchOptions parsed;
+    everything::ParseSearchOptions(rawOptions, parsed);
+    Sink(parsed.fields);
+  });
+}
+
+// run({ filter?, minTimeMs? }) -> { results: [{ name, unit, items,
+// iterations, nsPerOp, minNsPerOp, nsPerItem, stages? } | { name, skipped }] }
+Napi::Value Run(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  BenchOptions options;
+  if (info.Length() >= 1 && info[0].IsObject()) {
+    const auto input = info[0].As<Napi::Object>();
+    if (input.Has("filter") && input.Get("filter").IsString()) {
+      options.filter = input.Get("filter").As<Napi::String>().Utf8Value();
+    }
+    if (input.Has("minTimeMs") && input.Get("minTimeMs").IsNumber()) {
+      options.minTimeMs = std::clamp(input.Get("minTimeMs").As<Napi::Number>().DoubleValue(), 1.0, 60000.0);
+    }
+  }
+
+  BenchRunner bench(env, options);
+  BenchOcrMarshal(bench, env);
+  BenchOcrStages(bench);
+  BenchStrings(bench, env);
+  BenchEverything(bench, env);
+
+  auto output = Napi::Object::New(env);
+  output.Set("minTimeMs", Napi::Number::New(env, options.minTimeMs));
+  output.Set("results", bench.results());
+  return output;
+}
+
+} // namespace
+
+} // namespace tuff::native
+
+Napi::Object InitTuffNativeBench(Napi::Env env, Napi::Object exports) {
+  exports.Set("run", Napi::Function::New(env, tuff::native::Run, "run"));
+  return exports;
+}
+
+NODE_API_MODULE(tuff_native_bench, InitTuffNativeBench)
@@ -0,0 +1,222 @@
+#include "common/base64.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define TUFF_BASE64_SSSE3 1
+#include <tmmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define TUFF_BASE64_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace tuff::native {
+
+namespace {
+
+constexpr uint8_t kInvalid = 0xff;
+constexpr uint8_t kSkip = 0xfe;
+
+struct DecodeTable {
+  uint8_t values[256];
+
+  constexpr DecodeTable() : values() {
+    for (int i = 0; i < 256; ++i) {
+      values[i] = kInvalid;
+    }
+    for (int i = 0; i < 26; ++i) {
+      values['A' + i] = static_cast<uint8_t>(i);
+      values['a' + i] = static_cast<uint8_t>(26 + i);
+    }
+    for (int i = 0; i < 10; ++i) {
+      values['0' + i] = static_cast<uint8_t>(52 + i);
+    }
+    values['+'] = values['-'] = 62;
+    values['/'] = values['_'] = 63;
+    values[' '] = values['\t'] = values['\r'] = values['\n'] = values['\f'] = kSkip;
+  }
+};
+
+constexpr DecodeTable kDecode;
+
+// The vector paths classify 16 characters at a time by their nibbles
+// (W. Mula's bitmask lookup): lo[low nibble] & hi[high nibble] is non-zero
+// exactly when a byte is outside A-Z a-z 0-9 + /, and roll[high nibble, or 1
+// for '/'] is what turns a valid character into its 6-bit value. Anything
+// else, including padding and whitespace, ends the vector run and the scalar
+// loop takes over from there.
+constexpr uint8_t kLutLo[16] = {0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a};
+constexpr uint8_t kLutHi[16] = {0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10};
+constexpr uint8_t kLutRoll[16] = {0, 16, 19, 4, 0xbf, 0xbf, 0xb9, 0xb9, 0, 0, 0, 0, 0, 0, 0, 0};
+
+#if defined(TUFF_BASE64_SSSE3)
+
+bool CpuHasSsse3() {
+#if defined(_MSC_VER)
+  int info[4] = {0, 0, 0, 0};
+  __cpuid(info, 1);
+  return (info[2] & (1 << 9)) != 0;
+#else
+  return __builtin_cpu_supports("ssse3");
+#endif
+}
+
+// Decodes whole 16-character blocks while they are valid; returns how many
+// characters were consumed. `out` needs 4 bytes of slack past what the
+// blocks decode to, as each store writes 16 bytes for 12.
+#if !defined(_MSC_VER)
+__attribute__((target("ssse3")))
+#endif
+size_t DecodeBlocksSsse3(const char* text, size_t length, uint8_t* out) {
+  const __m128i lutLo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(kLutLo));
+  const __m128i lutHi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(kLutHi));
+  const __m128i lutRoll = _mm_loadu_si128(reinterpret_cast<const __m128i*>(kLutRoll));
+  const __m128i nibble = _mm_set1_epi8(0x0f);
+  const __m128i slash = _mm_set1_epi8(0x2f);
+  const __m128i mergePairs = _mm_set1_epi32(0x01400140);
+  const __m128i mergeQuads = _mm_set1_epi32(0x00011000);
+  const __m128i order = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+  size_t consumed = 0;
+  while (length - consumed >= 16) {
+    const __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + consumed));
+    const __m128i hi = _mm_and_si128(_mm_srli_epi32(input, 4), nibble);
+    const __m128i lo = _mm_and_si128(input, nibble);
+    const __m128i invalid = _mm_and_si128(_mm_shuffle_epi8(lutLo, lo), _mm_shuffle_epi8(lutHi, hi));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(invalid, _mm_setzero_si128())) != 0xffff) {
+      break;
+    }
+    const __m128i roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(_mm_cmpeq_epi8(input, slash), hi));
+    const __m128i values = _mm_add_epi8(input, roll);
+    // [a b c d] per 32-bit lane -> a<<18 | b<<12 | c<<6 | d, then the low
+    // three bytes of each lane in big-endian order.
+    const __m128i pairs = _mm_maddubs_epi16(values, mergePairs);
+    const __m128i quads = _mm_madd_epi16(pairs, mergeQuads);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_shuffle_epi8(quads, order));
+    consumed += 16;
+    out += 12;
+  }
+  return consumed;
+}
+
+#elif defined(TUFF_BASE64_NEON)
+
+inline uint8x16_t TranslateNeon(uint8x16_t input, uint8x16_t lutLo, uint8x16_t lutHi, uint8x16_t lutRoll,
+                                uint8x16_t& invalid) {
+  const uint8x16_t hi = vshrq_n_u8(input, 4);
+  const uint8x16_t lo = vandq_u8(input, vdupq_n_u8(0x0f));
+  invalid = vorrq_u8(invalid, vandq_u8(vqtbl1q_u8(lutLo, lo), vqtbl1q_u8(lutHi, hi)));
+  const uint8x16_t roll = vqtbl1q_u8(lutRoll, vaddq_u8(vceqq_u8(input, vdupq_n_u8(0x2f)), hi));
+  return vaddq_u8(input, roll);
+}
+
+// Decodes whole 64-character blocks while they are valid; returns how many
+// characters were consumed. Loads de-interleave the four characters of each
+// quantum into separate registers, so packing is plain shifts.
+size_t DecodeBlocksNeon(const char* text, size_t length, uint8_t* out) {
+  const uint8x16_t lutLo = vld1q_u8(kLutLo);
+  const uint8x16_t lutHi = vld1q_u8(kLutHi);
+  const uint8x16_t lutRoll = vld1q_u8(kLutRoll);
+
+  size_t consumed = 0;
+  while (length - consumed >= 64) {
+    const uint8x16x4_t input = vld4q_u8(reinterpret_cast<const uint8_t*>(text + consumed));
+    uint8x16_t invalid = vdupq_n_u8(0);
+    const uint8x16_t a = TranslateNeon(input.val[0], lutLo, lutHi, lutRoll, invalid);
+    const uint8x16_t b = TranslateNeon(input.val[1], lutLo, lutHi, lutRoll, invalid);
+    const uint8x16_t c = TranslateNeon(input.val[2], lutLo, lutHi, lutRoll, invalid);
+    const uint8x16_t d = TranslateNeon(input.val[3], lutLo, lutHi, lutRoll, invalid);
+    if (vmaxvq_u8(invalid) != 0) {
+      break;
+    }
+    uint8x16x3_t output;
+    output.val[0] = vorrq_u8(vshlq_n_u8(a, 2), vshrq_n_u8(b, 4));
+    output.val[1] = vorrq_u8(vshlq_n_u8(b, 4), vshrq_n_u8(c, 2));
+    output.val[2] = vorrq_u8(vshlq_n_u8(c, 6), d);
+    vst3q_u8(out, output);
+    consumed += 64;
+    out += 48;
+  }
+  return consumed;
+}
+
+#endif
+
+size_t DecodeBlocks(const char* text, size_t length, uint8_t* out) {
+#if defined(TUFF_BASE64_SSSE3)
+  static const bool hasSsse3 = CpuHasSsse3();
+  return hasSsse3 ? DecodeBlocksSsse3(text, length, out) : 0;
+#elif defined(TUFF_BASE64_NEON)
+  return DecodeBlocksNeon(text, length, out);
+#else
+  (void)text;
+  (void)length;
+  (void)out;
+  return 0;
+#endif
+}
+
+} // namespace
+
+bool DecodeBase64(const char* text, size_t length, std::vector<uint8_t>& out) {
+  out.resize(length / 4 * 3 + 16);
+  uint8_t* write = out.data();
+
+  size_t position = 0;
+  uint32_t quantum = 0;
+  int pending = 0;
+  int padding = 0;
+  while (position < length) {
+    if (pending == 0 && padding == 0) {
+      const size_t consumed = DecodeBlocks(text + position, length - position, write);
+      write += consumed / 4 * 3;
+      position += consumed;
+      if (position == length) {
+        break;
+      }
+    }
+
+    const uint8_t c = static_cast<uint8_t>(text[position++]);
+    if (c == '=') {
+      // Only after two or three characters of a quantum, and nothing but
+      // more padding or whitespace after it.
+      if (pending < 2 || pending + padding >= 4) {
+        return false;
+      }
+      ++padding;
+      continue;
+    }
+    const uint8_t value = kDecode.values[c];
+    if (value == kSkip) {
+      continue;
+    }
+    if (value == kInvalid || padding != 0) {
+      return false;
+    }
+    quantum = (quantum << 6) | value;
+    if (++pending == 4) {
+      *write++ = static_cast<uint8_t>(quantum >> 16);
+      *write++ = static_cast<uint8_t>(quantum >> 8);
+      *write++ = static_cast<uint8_t>(quantum);
+      quantum = 0;
+      pending = 0;
+    }
+  }
+
+  if (pending == 1) {
+    return false;
+  }
+  if (pending == 2) {
+    *write++ = static_cast<uint8_t>(quantum >> 4);
+  } else if (pending == 3) {
+    *write++ = static_cast<uint8_t>(quantum >> 10);
+    *write++ = static_cast<uint8_t>(quantum >> 2);
+  }
+  out.resize(static_cast<size_t>(write - out.data()));
+  return true;
+}
+
+} // namespace tuff::native
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tuff::native {
+
+// Decodes standard or URL-safe base64, with or without padding, skipping
+// ASCII whitespace as Buffer.from(text, 'base64') does. Runs of plain
+// alphabet characters, which is all of a typical data URL, are decoded with
+// SSSE3 or NEON where the CPU has it. Returns false on any other character.
+bool DecodeBase64(const char* text, size_t length, std::vector<uint8_t>& out);
+
+} // namespace tuff::native
@@ -0,0 +1,579 @@
+#include "common/image_preprocess.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TUFF_PREPROCESS_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define TUFF_PREPROCESS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace tuff::native {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+// Deskew looks at no more ink pixels than this; a sample is plenty to find
+// the angle of whole lines.
+constexpr size_t kMaxSkewSamples = 200000;
+
+uint32_t BytesPerPixel(const OcrImage& image) {
+  return image.format == OcrPixelFormat::kGray8 ? 1 : 4;
+}
+
+uint8_t Luma(const uint8_t* pixel, uint32_t bytesPerPixel) {
+  return bytesPerPixel == 1 ? pixel[0]
+                            : static_cast<uint8_t>((pixel[0] * 29 + pixel[1] * 150 + pixel[2] * 77) >> 8);
+}
+
+// A pixel buffer the resulting OcrImage owns.
+OcrImage NewImage(OcrPixelFormat format, uint32_t width, uint32_t height, uint8_t*& pixels) {
+  const uint32_t stride = width * (format == OcrPixelFormat::kGray8 ? 1 : 4);
+  auto buffer = std::make_shared<std::vector<uint8_t>>(static_cast<size_t>(stride) * height);
+  OcrImage image;
+  image.data = pixels = buffer->data();
+  image.size = buffer->size();
+  image.format = format;
+  image.width = width;
+  image.height = height;
+  image.stride = stride;
+  image.owner = std::move(buffer);
+  return image;
+}
+
+// Where the ink is: luma on one side of `threshold`. Text is taken to be the
+// minority class, so light text on a dark background is found as well.
+struct InkModel {
+  uint8_t threshold = 128;
+  bool darkInk = true;
+
+  bool IsInk(uint8_t value) const { return darkInk ? value < threshold : value > threshold; }
+};
+
+InkModel FindInk(const OcrImage& image) {
+  const uint32_t bytesPerPixel = BytesPerPixel(image);
+  std::array<uint64_t, 256> histogram{};
+  for (uint32_t y = 0; y < image.height; ++y) {
+    const uint8_t* row = image.data + static_cast<size_t>(y) * image.stride;
+    for (uint32_t x = 0; x < image.width; ++x) {
+      ++histogram[Luma(row + static_cast<size_t>(x) * bytesPerPixel, bytesPerPixel)];
+    }
+  }
+
+  // Otsu: the threshold that maximizes the variance between the classes.
+  const double total = static_cast<double>(image.width) * image.height;
+  double sum = 0.0;
+  for (int i = 0; i < 256; ++i) {
+    sum += static_cast<double>(i) * histogram[i];
+  }
+  double sumBelow = 0.0;
+  double countBelow = 0.0;
+  double bestVariance = -1.0;
+  InkModel model;
+  for (int t = 0; t < 256; ++t) {
+    countBelow += histogram[t];
+    sumBelow += static_cast<double>(t) * histogram[t];
+    const double countAbove = total - countBelow;
+    if (countBelow == 0.0 || countAbove == 0.0) {
+      continue;
+    }
+    const double meanBelow = sumBelow / countBelow;
+    const double meanAbove = (sum - sumBelow) / countAbove;
+    const double variance = countBelow * countAbove * (meanBelow - meanAbove) * (meanBelow - meanAbove);
+    if (variance > bestVariance) {
+      bestVariance = variance;
+      model.threshold = static_cast<uint8_t>(t + 1);
+      model.darkInk = countBelow <= countAbove;
+    }
+  }
+  if (!model.darkInk) {
+    model.threshold = static_cast<uint8_t>(model.threshold - 1);
+  }
+  return model;
+}
+
+// Columns per strip when measuring text height. Bands are measured within
+// narrow strips so a skewed line is not measured as tall as its slant.
+constexpr uint32_t kTextStripWidth = 64;
+
+// Height of a text line in pixels: the median height of the bands of rows
+// that carry ink, per strip of columns. 0 when there are none.
+uint32_t EstimateTextHeight(const OcrImage& image) {
+  const InkModel ink = FindInk(image);
+  const uint32_t bytesPerPixel = BytesPerPixel(image);
+
+  std::vector<uint32_t> bands;
+  for (uint32_t left = 0; left < image.width; left += kTextStripWidth) {
+    const uint32_t right = std::min(image.width, left + kTextStripWidth);
+    const uint32_t minInk = std::max<uint32_t>(1, (right - left) / 32);
+    uint32_t band = 0;
+    for (uint32_t y = 0; y <= image.height; ++y) {
+      uint32_t count = 0;
+      if (y < image.height) {
+        const uint8_t* row = image.data + static_cast<size_t>(y) * image.stride;
+        for (uint32_t x = left; x < right && count < minInk; ++x) {
+          count += ink.IsInk(Luma(row + static_cast<size_t>(x) * bytesPerPixel, bytesPerPixel)) ? 1 : 0;
+        }
+      }
+      if (count >= minInk) {
+        ++band;
+      } else {
+        if (band >= 2) {
+          bands.push_back(band);
+        }
+        band = 0;
+      }
+    }
+  }
+  if (bands.empty()) {
+    return 0;
+  }
+  std::nth_element(bands.begin(), bands.begin() + bands.size() / 2, bands.end());
+  return bands[bands.size() / 2];
+}
+
+// Source pixels and weights for each output pixel along one axis of an area
+// average: output pixel i covers source [i * ratio, (i + 1) * ratio).
+struct AreaTaps {
+  std::vector<uint32_t> begin;
+  std::vector<uint32_t> first;
+  std::vector<float> weights;
+};
+
+AreaTaps ComputeAreaTaps(uint32_t source, uint32_t target) {
+  AreaTaps taps;
+  taps.begin.reserve(target + 1);
+  taps.first.reserve(target);
+  const double ratio = static_cast<double>(source) / target;
+  for (uint32_t i = 0; i < target; ++i) {
+    const double from = i * ratio;
+    const double to = std::min<double>(source, (i + 1) * ratio);
+    const uint32_t first = static_cast<uint32_t>(from);
+    const uint32_t last = std::min<uint32_t>(source, static_cast<uint32_t>(std::ceil(to)));
+    taps.begin.push_back(static_cast<uint32_t>(taps.weights.size()));
+    taps.first.push_back(first);
+    for (uint32_t s = first; s < last; ++s) {
+      const double covered = std::min<double>(s + 1, to) - std::max<double>(s, from);
+      taps.weights.push_back(static_cast<float>(covered / (to - from)));
+    }
+  }
+  taps.begin.push_back(static_cast<uint32_t>(taps.weights.size()));
+  return taps;
+}
+
+// Box-filters `image` down to `width` x `height`, so every source pixel
+// contributes; thin strokes fade rather than drop out as they would with
+// point sampling.
+OcrImage DownscaleArea(const OcrImage& image, uint32_t width, uint32_t height) {
+  const uint32_t channels = BytesPerPixel(image);
+  const AreaTaps columns = ComputeAreaTaps(image.width, width);
+  const AreaTaps rows = ComputeAreaTaps(image.height, height);
+
+  // Horizontal pass into floats, then a vertical pass per output row.
+  const size_t rowValues = static_cast<size_t>(width) * channels;
+  std::vector<float> horizontal(rowValues * image.height);
+  for (uint32_t y = 0; y < image.height; ++y) {
+    const uint8_t* source = image.data + static_cast<size_t>(y) * image.stride;
+    float* out = horizontal.data() + rowValues * y;
+    for (uint32_t x = 0; x < width; ++x) {
+      const uint8_t* pixel = source + static_cast<size_t>(columns.first[x]) * channels;
+      for (uint32_t c = 0; c < channels; ++c) {
+        float value = 0.0f;
+        for (uint32_t t = columns.begin[x]; t < columns.begin[x + 1]; ++t) {
+          value += columns.weights[t] * pixel[(t - columns.begin[x]) * channels + c];
+        }
+        out[static_cast<size_t>(x) * channels + c] = value;
+      }
+    }
+  }
+
+  uint8_t* pixels = nullptr;
+  OcrImage scaled = NewImage(image.format, width, height, pixels);
+  std::vector<float> accumulator(rowValues);
+  for (uint32_t y = 0; y < height; ++y) {
+    std::fill(accumulator.begin(), accumulator.end(), 0.0f);
+    for (uint32_t t = rows.begin[y]; t < rows.begin[y + 1]; ++t) {
+      const float weight = rows.weights[t];
+      const float* source = horizontal.data() + rowValues * (rows.first[y] + (t - rows.begin[y]));
+      for (size_t i = 0; i < rowValues; ++i) {
+        accumulator[i] += weight * source[i];
+      }
+    }
+    uint8_t* out = pixels + static_cast<size_t>(y) * scaled.stride;
+    for (size_t i = 0; i < rowValues; ++i) {
+      out[i] = static_cast<uint8_t>(std::min(255.0f, accumulator[i] + 0.5f));
+    }
+  }
+  return scaled;
+}
+
+OcrImage ToGray(const OcrImage& image) {
+  uint8_t* pixels = nullptr;
+  OcrImage gray = NewImage(OcrPixelFormat::kGray8, image.width, image.height, pixels);
+  for (uint32_t y = 0; y < image.height; ++y) {
+    ConvertBgraRowToGray(image.data + static_cast<size_t>(y) * image.stride,
+                         pixels + static_cast<size_t>(y) * gray.stride, image.width);
+  }
+  return gray;
+}
+
+// Bradley's adaptive threshold over an integral image. Ink comes out 0 and
+// paper 255 whichever way round the source was.
+OcrImage Binarize(const OcrImage& image, uint32_t window, double threshold) {
+  const uint32_t width = image.width;
+  const uint32_t height = image.height;
+  if (window == 0) {
+    window = std::clamp<uint32_t>(std::max(width, height) / 16, 15, 127);
+  }
+  const uint32_t half = window / 2;
+  const bool darkInk = FindInk(image).darkInk;
+
+  // Sums wrap at 2^32; window sums come out right anyway as long as one
+  // window holds less than 2^32 / 255 pixels.
+  const size_t integralStride = static_cast<size_t>(width) + 1;
+  std::vector<uint32_t> integral(integralStride * (height + 1), 0);
+  for (uint32_t y = 0; y < height; ++y) {
+    const uint8_t* row = image.data + static_cast<size_t>(y) * image.stride;
+    uint32_t rowSum = 0;
+    uint32_t* above = integral.data() + integralStride * y;
+    uint32_t* current = above + integralStride;
+    for (uint32_t x = 0; x < width; ++x) {
+      rowSum += row[x];
+      current[x + 1] = above[x + 1] + rowSum;
+    }
+  }
+
+  uint8_t* pixels = nullptr;
+  OcrImage binary = NewImage(OcrPixelFormat::kGray8, width, height, pixels);
+  const double below = 1.0 - threshold;
+  const double above = 1.0 + threshold;
+  for (uint32_t y = 0; y < height; ++y) {
+    const uint32_t top = y > half ? y - half : 0;
+    const uint32_t bottom = std::min(height, y + half + 1);
+    const uint32_t* topRow = integral.data() + integralStride * top;
+    const uint32_t* bottomRow = integral.data() + integralStride * bottom;
+    const uint8_t* row = image.data + static_cast<size_t>(y) * image.stride;
+    uint8_t* out = pixels + static_cast<size_t>(y) * binary.stride;
+    for (uint32_t x = 0; x < width; ++x) {
+      const uint32_t left = x > half ? x - half : 0;
+      const uint32_t right = std::min(width, x + half + 1);
+      const uint32_t sum = bottomRow[right] - bottomRow[left] - topRow[right] + topRow[left];
+      const double area = static_cast<double>(right - left) * (bottom - top);
+      const double value = static_cast<double>(row[x]) * area;
+      const bool ink = darkInk ? value < sum * below : value > sum * above;
+      out[x] = ink ? 0 : 255;
+    }
+  }
+  return binary;
+}
+
+// Projection-profile skew search: ink projected along the right angle piles
+// up in a few rows, which maximizes the sum of squared row counts.
+double FindSkewDegrees(const OcrImage& image, bool binary, double maxDegrees) {
+  const InkModel ink = binary ? InkModel{128, true} : FindInk(image);
+  size_t inkCount = 0;
+  for (uint32_t y = 0; y < image.height; ++y) {
+    const uint8_t* row = image.data + static_cast<size_t>(y) * image.stride;
+    for (uint32_t x = 0; x < image.width; ++x) {
+      inkCount += ink.IsInk(row[x]) ? 1 : 0;
+    }
+  }
+  if (inkCount < 64) {
+    return 0.0;
+  }
+
+  const size_t every = inkCount / kMaxSkewSamples + 1;
+  std::vector<float> xs;
+  std::vector<float> ys;
+  xs.reserve(inkCount / every + 1);
+  ys.reserve(inkCount / every + 1);
+  const float cx = image.width / 2.0f;
+  const float cy = image.height / 2.0f;
+  size_t seen = 0;
+  for (uint32_t y = 0; y < image.height; ++y) {
+    const uint8_t* row = image.data + static_cast<size_t>(y) * image.stride;
+    for (uint32_t x = 0; x < image.width; ++x) {
+      if (ink.IsInk(row[x]) && seen++ % every == 0) {
+        xs.push_back(x + 0.5f - cx);
+        ys.push_back(y + 0.5f - cy);
+      }
+    }
+  }
+
+  const double maxTan = std::tan(maxDegrees * kPi / 180.0);
+  const size_t offset = static_cast<size_t>(std::ceil(cy + cx * maxTan)) + 1;
+  std::vector<uint32_t> bins(offset * 2 + 1);
+  const auto score = [&](double degrees) {
+    std::fill(bins.begin(), bins.end(), 0);
+    const float slope = static_cast<float>(std::tan(degrees * kPi / 180.0));
+    for (size_t i = 0; i < xs.size(); ++i) {
+      const float projected = ys[i] - xs[i] * slope;
+      ++bins[static_cast<size_t>(static_cast<ptrdiff_t>(std::floor(projected)) + static_cast<ptrdiff_t>(offset))];
+    }
+    double total = 0.0;
+    for (uint32_t count : bins) {
+      total += static_cast<double>(count) * count;
+    }
+    return total;
+  };
+
+  // Coarse half-degree steps, then tenths around the best.
+  double best = 0.0;
+  double bestScore = score(0.0);
+  const auto consider = [&](double degrees) {
+    if (std::fabs(degrees) > maxDegrees) {
+      return;
+    }
+    const double value = score(degrees);
+    if (value > bestScore) {
+      best = degrees;
+      bestScore = value;
+    }
+  };
+  const int coarseSteps = static_cast<int>(std::floor(maxDegrees / 0.5));
+  for (int step = -coarseSteps; step <= coarseSteps; ++step) {
+    if (step != 0) {
+      consider(step * 0.5);
+    }
+  }
+  const double coarse = best;
+  for (int step = -4; step <= 4; ++step) {
+    if (step != 0) {
+      consider(coarse + step * 0.1);
+    }
+  }
+  return best;
+}
+
+// Rotates by -degrees about the centre, so lines at `degrees` come out
+// level. Binary images use the nearest pixel to stay binary.
+OcrImage Rotate(const OcrImage& image, double degrees, bool binary, uint8_t fill) {
+  uint8_t* pixels = nullptr;
+  OcrImage rotated = NewImage(OcrPixelFormat::kGray8, image.width, image.height, pixels);
+  const double radians = degrees * kPi / 180.0;
+  const double cosA = std::cos(radians);
+  const double sinA = std::sin(radians);
+  const double cx = image.width / 2.0;
+  const double cy = image.height / 2.0;
+  const auto at = [&image, fill](int64_t x, int64_t y) -> int {
+    if (x < 0 || y < 0 || x >= image.width || y >= image.height) {
+      return fill;
+    }
+    return image.data[static_cast<size_t>(y) * image.stride + static_cast<size_t>(x)];
+  };
+
+  for (uint32_t y = 0; y < image.height; ++y) {
+    uint8_t* out = pixels + static_cast<size_t>(y) * rotated.stride;
+    const double dy = y + 0.5 - cy;
+    for (uint32_t x = 0; x < image.width; ++x) {
+      const double dx = x + 0.5 - cx;
+      const double sx = cosA * dx - sinA * dy + cx - 0.5;
+      const double sy = sinA * dx + cosA * dy + cy - 0.5;
+      if (binary) {
+        out[x] = static_cast<uint8_t>(at(std::llround(sx), std::llround(sy)));
+        continue;
+      }
+      const double fx = std::floor(sx);
+      const double fy = std::floor(sy);
+      const double wx = sx - fx;
+      const double wy = sy - fy;
+      const int64_t x0 = static_cast<int64_t>(fx);
+      const int64_t y0 = static_cast<int64_t>(fy);
+      const double top = at(x0, y0) * (1.0 - wx) + at(x0 + 1, y0) * wx;
+      const double bottom = at(x0, y0 + 1) * (1.0 - wx) + at(x0 + 1, y0 + 1) * wx;
+      out[x] = static_cast<uint8_t>(top * (1.0 - wy) + bottom * wy + 0.5);
+    }
+  }
+  return rotated;
+}
+
+double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+void ConvertBgraRowToGray(const uint8_t* bgra, uint8_t* gray, uint32_t width) {
+  uint32_t x = 0;
+#if defined(TUFF_PREPROCESS_SSE2)
+  // Four pixels per 32-bit lane group; the weighted sum fits 16 bits
+  // unsigned, so it is computed in 16-bit lanes and shifted down.
+  const __m128i byteMask = _mm_set1_epi32(0xff);
+  const __m128i weightB = _mm_set1_epi32(29);
+  const __m128i weightG = _mm_set1_epi32(150);
+  const __m128i weightR = _mm_set1_epi32(77);
+  const auto lumaOf = [&](const uint8_t* pixels) {
+    const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels));
+    const __m128i b = _mm_and_si128(value, byteMask);
+    const __m128i g = _mm_and_si128(_mm_srli_epi32(value, 8), byteMask);
+    const __m128i r = _mm_and_si128(_mm_srli_epi32(value, 16), byteMask);
+    const __m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(b, weightB), _mm_mullo_epi16(g, weightG)),
+                                      _mm_mullo_epi16(r, weightR));
+    return _mm_srli_epi32(sum, 8);
+  };
+  for (; x + 16 <= width; x += 16) {
+    const uint8_t* pixels = bgra + static_cast<size_t>(x) * 4;
+    const __m128i low = _mm_packs_epi32(lumaOf(pixels), lumaOf(pixels + 16));
+    const __m128i high = _mm_packs_epi32(lumaOf(pixels + 32), lumaOf(pixels + 48));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(gray + x), _mm_packus_epi16(low, high));
+  }
+#elif defined(TUFF_PREPROCESS_NEON)
+  for (; x + 8 <= width; x += 8) {
+    const uint8x8x4_t pixels = vld4_u8(bgra + static_cast<size_t>(x) * 4);
+    uint16x8_t sum = vmull_u8(pixels.val[0], vdup_n_u8(29));
+    sum = vmlal_u8(sum, pixels.val[1], vdup_n_u8(150));
+    sum = vmlal_u8(sum, pixels.val[2], vdup_n_u8(77));
+    vst1_u8(gray + x, vshrn_n_u16(sum, 8));
+  }
+#endif
+  for (; x < width; ++x) {
+    gray[x] = Luma(bgra + static_cast<size_t>(x) * 4, 4);
+  }
+}
+
+OcrImage CropImageView(const OcrImage& image, uint32_t x, uint32_t y, uint32_t width, uint32_t height) {
+  const uint32_t bytesPerPixel = BytesPerPixel(image);
+  OcrImage view = image;
+  view.data += static_cast<size_t>(y) * image.stride + static_cast<size_t>(x) * bytesPerPixel;
+  view.size = static_cast<size_t>(image.stride) * (height - 1) + static_cast<size_t>(width) * bytesPerPixel;
+  view.width = width;
+  view.height = height;
+  return view;
+}
+
+bool PreprocessOcrImage(OcrOptions& options, OcrPreprocessReport& report, OcrError& error) {
+  const OcrPreprocessOptions& steps = options.preprocess;
+  report = OcrPreprocessReport{};
+  if (!steps.enabled()) {
+    return true;
+  }
+  const auto startedAt = std::chrono::steady_clock::now();
+  report.applied = true;
+
+  OcrImage image = options.image;
+  if (image.empty()) {
+    error.code = "ERR_OCR_DECODE_FAILED";
+    error.message = "Image payload is empty";
+    return false;
+  }
+  if (image.format == OcrPixelFormat::kEncoded) {
+    const auto stepStart = std::chrono::steady_clock::now();
+    OcrImage decoded;
+    if (!DecodePlatformImage(image, decoded, error)) {
+      return false;
+    }
+    image = std::move(decoded);
+    report.decodeMs = MillisecondsSince(stepStart);
+  }
+
+  if (steps.HasCrop()) {
+    const auto stepStart = std::chrono::steady_clock::now();
+    if (steps.cropX >= image.width || steps.cropY >= image.height) {
+      error.code = "ERR_OCR_INVALID_CROP";
+      error.message = "Crop region lies outside the image";
+      return false;
+    }
+    image = CropImageView(image, steps.cropX, steps.cropY, std::min(steps.cropWidth, image.width - steps.cropX),
+                          std::min(steps.cropHeight, image.height - steps.cropY));
+    report.cropX = steps.cropX;
+    report.cropY = steps.cropY;
+    report.cropMs = MillisecondsSince(stepStart);
+  }
+
+  const bool gray = steps.grayscale || steps.binarize || steps.deskew;
+  if (gray && image.format == OcrPixelFormat::kBgra8) {
+    const auto stepStart = std::chrono::steady_clock::now();
+    image = ToGray(image);
+    report.grayscaleMs = MillisecondsSince(stepStart);
+  }
+
+  if (steps.targetTextHeight > 0) {
+    const auto stepStart = std::chrono::steady_clock::now();
+    const uint32_t textHeight = steps.textHeightHint > 0 ? steps.textHeightHint : EstimateTextHeight(image);
+    if (textHeight > steps.targetTextHeight) {
+      const double scale = static_cast<double>(steps.targetTextHeight) / textHeight;
+      const uint32_t width = std::max<uint32_t>(1, static_cast<uint32_t>(std::lround(image.width * scale)));
+      const uint32_t height = std::max<uint32_t>(1, static_cast<uint32_t>(std::lround(image.height * scale)));
+      if (width < image.width || height < image.height) {
+        image = DownscaleArea(image, width, height);
+        report.scale = scale;
+      }
+    }
+    report.scaleMs = MillisecondsSince(stepStart);
+  }
+
+  if (steps.binarize) {
+    const auto stepStart = std::chrono::steady_clock::now();
+    image = Binarize(image, steps.binarizeWindow, std::clamp(steps.binarizeThreshold, 0.0, 0.9));
+    report.binarizeMs = MillisecondsSince(stepStart);
+  }
+
+  if (steps.deskew) {
+    const auto stepStart = std::chrono::steady_clock::now();
+    const double maxDegrees = std::clamp(steps.maxSkewDegrees, 0.0, 45.0);
+    const double skew = FindSkewDegrees(image, steps.binarize, maxDegrees);
+    if (std::fabs(skew) >= 0.05) {
+      const uint8_t fill = steps.binarize || FindInk(image).darkInk ? 255 : 0;
+      image = Rotate(image, skew, steps.binarize, fill);
+      report.skewDegrees = skew;
+    }
+    report.deskewMs = MillisecondsSince(stepStart);
+  }
+
+  report.width = image.width;
+  report.height = image.height;
+  options.image = std::move(image);
+  report.totalMs = MillisecondsSince(startedAt);
+  return true;
+}
+
+void MapBlocksToSource(const OcrPreprocessReport& report, std::vector<OcrBlock>& blocks) {
+  if (!report.applied) {
+    return;
+  }
+  const double radians = report.skewDegrees * kPi / 180.0;
+  const double cosA = std::cos(radians);
+  const double sinA = std::sin(radians);
+  const double cx = report.width / 2.0;
+  const double cy = report.height / 2.0;
+
+  const auto map = [&](std::array<double, 4>& box) {
+    const std::array<std::pair<double, double>, 4> corners = {
+        std::make_pair(box[0], box[1]), std::make_pair(box[0] + box[2], box[1]),
+        std::make_pair(box[0], box[1] + box[3]), std::make_pair(box[0] + box[2], box[1] + box[3])};
+    double minX = 0.0;
+    double minY = 0.0;
+    double maxX = 0.0;
+    double maxY = 0.0;
+    for (size_t i = 0; i < corners.size(); ++i) {
+      // Undo the rotation, then the scale, then the crop.
+      const double dx = corners[i].first - cx;
+      const double dy = corners[i].second - cy;
+      const double x = (cosA * dx - sinA * dy + cx) / report.scale + report.cropX;
+      const double y = (sinA * dx + cosA * dy + cy) / report.scale + report.cropY;
+      minX = i == 0 ? x : std::min(minX, x);
+      minY = i == 0 ? y : std::min(minY, y);
+      maxX = i == 0 ? x : std::max(maxX, x);
+      maxY = i == 0 ? y : std::max(maxY, y);
+    }
+    box = {minX, minY, maxX - minX, maxY - minY};
+  };
+  for (OcrBlock& block : blocks) {
+    if (block.hasBoundingBox) {
+      map(block.boundingBox);
+    }
+    for (OcrWord& word : block.words) {
+      map(word.boundingBox);
+    }
+  }
+}
+
+} // namespace tuff::native
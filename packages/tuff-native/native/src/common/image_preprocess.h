@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "common/ocr_types.h"
+
+namespace tuff::native {
+
+// Runs `options.preprocess` on `options.image` and replaces the image with
+// the result, which the new image owns. Encoded images are decoded first
+// with DecodePlatformImage. Leaves the options alone when no step is
+// enabled.
+bool PreprocessOcrImage(OcrOptions& options, OcrPreprocessReport& report, OcrError& error);
+
+// Maps block and word bounding boxes from the preprocessed image back to
+// source image coordinates.
+void MapBlocksToSource(const OcrPreprocessReport& report, std::vector<OcrBlock>& blocks);
+
+// A view of the given region of raw pixels, sharing their owner; nothing is
+// copied. The region must lie inside the image.
+OcrImage CropImageView(const OcrImage& image, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+
+// Converts one row of BGRA pixels to 8-bit luma, (29 B + 150 G + 77 R) >> 8.
+void ConvertBgraRowToGray(const uint8_t* bgra, uint8_t* gray, uint32_t width);
+
+} // namespace tuff::native
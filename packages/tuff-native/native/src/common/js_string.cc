@@ -0,0 +1,56 @@
+#include "common/js_string.h"
+
+#include "common/utf_transcode.h"
+
+namespace tuff::native {
+
+namespace {
+
+// A result set has at most a few thousand distinct parents; past this many the
+// table costs more to probe than it saves.
+constexpr size_t kMaxInterned = 1 << 14;
+
+} // namespace
+
+Napi::String JsStrings::New(std::string_view utf8) {
+  if (utf8.empty()) {
+    return Napi::String::New(env_, "", 0);
+  }
+
+  napi_value value = nullptr;
+  napi_status status;
+  if (IsAscii(utf8.data(), utf8.size())) {
+    status = napi_create_string_latin1(env_, utf8.data(), utf8.size(), &value);
+  } else if (Utf8ToUtf16(utf8, scratch_)) {
+    status = napi_create_string_utf16(env_, scratch_.data(), scratch_.size(), &value);
+  } else {
+    // V8 substitutes U+FFFD for invalid UTF-8; keep that.
+    status = napi_create_string_utf8(env_, utf8.data(), utf8.size(), &value);
+  }
+  NAPI_THROW_IF_FAILED(env_, status, Napi::String());
+  return Napi::String(env_, value);
+}
+
+Napi::String JsStrings::Intern(std::string_view utf8) {
+  // Rows sorted by path come in runs under the same parent.
+  if (lastValue_ != nullptr && utf8 == lastKey_) {
+    return Napi::String(env_, lastValue_);
+  }
+
+  const auto found = interned_.find(utf8);
+  if (found != interned_.end()) {
+    lastKey_ = found->first;
+    lastValue_ = found->second;
+    return Napi::String(env_, lastValue_);
+  }
+
+  auto string = New(utf8);
+  if (interned_.size() < kMaxInterned) {
+    interned_.emplace(utf8, string);
+  }
+  lastKey_ = utf8;
+  lastValue_ = string;
+  return string;
+}
+
+} // namespace tuff::native
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <napi.h>
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace tuff::native {
+
+// Makes the JS strings of one marshalling pass: a result set, an OCR result.
+// ASCII goes through napi_create_string_latin1, which V8 copies straight into
+// a one-byte string. Anything else is transcoded once into a UTF-16 scratch
+// buffer the pass reuses, then handed to napi_create_string_utf16, so V8 does
+// not have to measure and then decode the UTF-8 itself. Only valid inside the
+// HandleScope its strings are made in.
+class JsStrings {
+ public:
+  explicit JsStrings(Napi::Env env) : env_(env) {}
+
+  Napi::String New(std::string_view utf8);
+
+  // New(), except that equal values share one JS string for the life of this
+  // object: for the parent directories rows of one result set have in common.
+  // Only the view is kept, so `utf8` must outlive this object.
+  Napi::String Intern(std::string_view utf8);
+
+ private:
+  Napi::Env env_;
+  std::u16string scratch_;
+  std::unordered_map<std::string_view, napi_value> interned_;
+  std::string_view lastKey_;
+  napi_value lastValue_ = nullptr;
+};
+
+} // namespace tuff::native
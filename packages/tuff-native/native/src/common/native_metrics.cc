@@ -0,0 +1,211 @@
+#include "common/native_metrics.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace tuff::native {
+
+namespace {
+
+// Bucket of a duration: 0-3 for under 4 us, then four per power of two.
+size_t BucketOf(uint64_t nanos) {
+  const uint64_t micros = nanos / 1000;
+  if (micros < 4) {
+    return static_cast<size_t>(micros);
+  }
+  uint32_t exponent = 2;
+  while (exponent < 63 && (micros >> (exponent + 1)) != 0) {
+    ++exponent;
+  }
+  const size_t index = 4 + (exponent - 2) * 4 + ((micros >> (exponent - 2)) & 3);
+  return std::min(index, LatencyHistogram::kBuckets - 1);
+}
+
+} // namespace
+
+uint64_t LatencyHistogram::UpperBound(size_t index) {
+  if (index < 4) {
+    return (index + 1) * 1000;
+  }
+  if (index >= kBuckets - 1) {
+    return UINT64_MAX;
+  }
+  const uint64_t exponent = (index - 4) / 4 + 2;
+  const uint64_t step = (index - 4) % 4;
+  return ((5 + step) << (exponent - 2)) * 1000;
+}
+
+void LatencyHistogram::Record(uint64_t nanos) {
+  buckets_[BucketOf(nanos)].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  totalNanos_.fetch_add(nanos, std::memory_order_relaxed);
+  uint64_t max = maxNanos_.load(std::memory_order_relaxed);
+  while (nanos > max && !maxNanos_.compare_exchange_weak(max, nanos, std::memory_order_relaxed)) {
+  }
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::Read() const {
+  // Not one atomic read; a span recorded meanwhile may be in some fields
+  // and not others, which only matters to the last digit.
+  Snapshot snapshot;
+  for (size_t i = 0; i < kBuckets; ++i) {
+    snapshot.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+    snapshot.count += snapshot.buckets[i];
+  }
+  snapshot.totalNanos = totalNanos_.load(std::memory_order_relaxed);
+  snapshot.maxNanos = maxNanos_.load(std::memory_order_relaxed);
+  return snapshot;
+}
+
+void LatencyHistogram::Reset() {
+  for (auto& bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  count_.store(0, std::memory_order_relaxed);
+  totalNanos_.store(0, std::memory_order_relaxed);
+  maxNanos_.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::Snapshot::Quantile(double q) const {
+  if (count == 0) {
+    return 0;
+  }
+  const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * static_cast<double>(count))));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kBuckets; ++i) {
+    seen += buckets[i];
+    if (seen >= rank) {
+      return std::min(UpperBound(i), maxNanos);
+    }
+  }
+  return maxNanos;
+}
+
+NativeMetrics::NativeMetrics(const char* const* stageNames, size_t stageCount, const char* const* counterNames,
+                             size_t counterCount)
+    : stageNames_(stageNames),
+      stageCount_(stageCount),
+      stages_(new LatencyHistogram[stageCount]),
+      counterNames_(counterNames),
+      counterCount_(counterCount),
+      counters_(new std::atomic<uint64_t>[counterCount]) {
+  for (size_t i = 0; i < counterCount; ++i) {
+    counters_[i].store(0, std::memory_order_relaxed);
+  }
+  const auto wall = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch());
+  wallOffsetNanos_ = static_cast<int64_t>(wall.count()) - static_cast<int64_t>(Now());
+}
+
+void NativeMetrics::Configure(bool enabled, size_t traceCapacity) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Ring* current = ring_.load(std::memory_order_relaxed);
+  if (current == nullptr ? traceCapacity != 0 : current->capacity != traceCapacity) {
+    if (owned_ != nullptr) {
+      retired_.push_back(std::move(owned_));
+    }
+    if (traceCapacity > 0) {
+      // Toggling tracing under load reuses a ring still waiting on a writer
+      // instead of piling up another; its stale spans are skipped below.
+      const auto reusable = std::find_if(retired_.begin(), retired_.end(), [&](const std::unique_ptr<Ring>& ring) {
+        return ring->capacity == traceCapacity;
+      });
+      if (reusable != retired_.end()) {
+        owned_ = std::move(*reusable);
+        retired_.erase(reusable);
+      } else {
+        owned_ = std::make_unique<Ring>(traceCapacity);
+      }
+    }
+    // seq_cst, against the writers_ increment and ring_ load in Record: a
+    // writer ReclaimRetired does not count has to load the new ring.
+    ring_.store(owned_.get(), std::memory_order_seq_cst);
+    tail_ = owned_ != nullptr ? owned_->head.load(std::memory_order_acquire) : 0;
+  }
+  ReclaimRetired();
+  enabled_.store(enabled || traceCapacity > 0, std::memory_order_relaxed);
+}
+
+void NativeMetrics::ReclaimRetired() {
+  // Pairs with the release decrement in Record, so its slot writes are done.
+  if (!retired_.empty() && writers_.load(std::memory_order_seq_cst) == 0) {
+    retired_.clear();
+  }
+}
+
+size_t NativeMetrics::traceCapacity() const {
+  const Ring* ring = ring_.load(std::memory_order_relaxed);
+  return ring != nullptr ? ring->capacity : 0;
+}
+
+void NativeMetrics::Record(uint32_t stage, uint64_t start, uint64_t end) {
+  const uint64_t duration = end > start ? end - start : 0;
+  stages_[stage].Record(duration);
+
+  if (ring_.load(std::memory_order_relaxed) == nullptr) {
+    return;
+  }
+  writers_.fetch_add(1, std::memory_order_seq_cst);
+  Ring* ring = ring_.load(std::memory_order_seq_cst);
+  if (ring == nullptr) {
+    writers_.fetch_sub(1, std::memory_order_release);
+    return;
+  }
+  const uint64_t sequence = ring->head.fetch_add(1, std::memory_order_relaxed);
+  Slot& slot = ring->slots[sequence % ring->capacity];
+  slot.sequence.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.stage.store(stage, std::memory_order_relaxed);
+  slot.startNanos.store(static_cast<uint64_t>(static_cast<int64_t>(start) + wallOffsetNanos_),
+                        std::memory_order_relaxed);
+  slot.durationNanos.store(duration, std::memory_order_relaxed);
+  slot.sequence.store(sequence + 1, std::memory_order_release);
+  writers_.fetch_sub(1, std::memory_order_release);
+}
+
+uint64_t NativeMetrics::Drain(std::vector<TraceSpan>& spans) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Ring* ring = ring_.load(std::memory_order_acquire);
+  if (ring != nullptr) {
+    const uint64_t head = ring->head.load(std::memory_order_acquire);
+    if (head - tail_ > ring->capacity) {
+      dropped_ += head - tail_ - ring->capacity;
+      tail_ = head - ring->capacity;
+    }
+    for (; tail_ < head; ++tail_) {
+      const Slot& slot = ring->slots[tail_ % ring->capacity];
+      const uint64_t before = slot.sequence.load(std::memory_order_acquire);
+      if (before < tail_ + 1) {
+        // Claimed but not yet written; picked up by the next drain.
+        break;
+      }
+      TraceSpan span;
+      span.stage = slot.stage.load(std::memory_order_relaxed);
+      span.startNanos = slot.startNanos.load(std::memory_order_relaxed);
+      span.durationNanos = slot.durationNanos.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (before != tail_ + 1 || slot.sequence.load(std::memory_order_relaxed) != before) {
+        // Overwritten by a later span, before or while it was read.
+        ++dropped_;
+        continue;
+      }
+      spans.push_back(span);
+    }
+  }
+  // A Configure that found a writer in a retired ring left it for later.
+  ReclaimRetired();
+  const uint64_t dropped = dropped_;
+  dropped_ = 0;
+  return dropped;
+}
+
+void NativeMetrics::Reset() {
+  for (size_t i = 0; i < stageCount_; ++i) {
+    stages_[i].Reset();
+  }
+  for (size_t i = 0; i < counterCount_; ++i) {
+    counters_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+} // namespace tuff::native
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace tuff::native {
+
+// Durations in a log-linear histogram: four buckets per power of two of
+// microseconds, from 1 us to about a minute, plus one for anything longer.
+// Record is a handful of relaxed atomic adds, safe from any thread.
+class LatencyHistogram {
+ public:
+  static constexpr size_t kBuckets = 100;
+
+  struct Snapshot {
+    uint64_t count = 0;
+    uint64_t totalNanos = 0;
+    uint64_t maxNanos = 0;
+    std::array<uint64_t, kBuckets> buckets{};
+
+    // Upper bound of the bucket holding the q-th quantile, in nanoseconds;
+    // 0 when empty.
+    uint64_t Quantile(double q) const;
+  };
+
+  void Record(uint64_t nanos);
+  Snapshot Read() const;
+  void Reset();
+
+  // Largest duration bucket `index` holds, in nanoseconds.
+  static uint64_t UpperBound(size_t index);
+
+ private:
+  std::array<std::atomic<uint64_t>, kBuckets> buckets_{};
+  std::atomic<uint64_t> count_{0};
+  std::atomic<uint64_t> totalNanos_{0};
+  std::atomic<uint64_t> maxNanos_{0};
+};
+
+// A finished span of one stage, for the trace ring.
+struct TraceSpan {
+  uint32_t stage = 0;
+  // Unix time in nanoseconds.
+  uint64_t startNanos = 0;
+  uint64_t durationNanos = 0;
+};
+
+// Stage timings, counters and, while tracing, the most recent spans of one
+// addon. Nothing is timed unless enabled, and the disabled check is a single
+// relaxed load, so instrumented paths cost next to nothing by default.
+//
+// Spans go into a fixed ring whose slots writers claim with one atomic
+// increment and publish with a sequence number, so neither side locks; the
+// oldest are overwritten when JS does not drain often enough, and counted as
+// dropped. A ring replaced by Configure is freed once no writer is inside it.
+class NativeMetrics {
+ public:
+  NativeMetrics(const char* const* stageNames, size_t stageCount, const char* const* counterNames,
+                size_t counterCount);
+
+  bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+  bool tracing() const { return ring_.load(std::memory_order_relaxed) != nullptr; }
+
+  // Turns timing on or off. A trace capacity of 0 stops tracing and drops
+  // the spans not yet drained; tracing implies enabled.
+  void Configure(bool enabled, size_t traceCapacity);
+
+  static uint64_t Now() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+  }
+
+  // `start` is a Now() reading.
+  void Record(uint32_t stage, uint64_t start, uint64_t end);
+  void Add(uint32_t counter, uint64_t amount = 1) { counters_[counter].fetch_add(amount, std::memory_order_relaxed); }
+
+  size_t stageCount() const { return stageCount_; }
+  const char* stageName(uint32_t stage) const { return stageNames_[stage]; }
+  LatencyHistogram::Snapshot ReadStage(uint32_t stage) const { return stages_[stage].Read(); }
+  size_t counterCount() const { return counterCount_; }
+  const char* counterName(uint32_t counter) const { return counterNames_[counter]; }
+  uint64_t ReadCounter(uint32_t counter) const { return counters_[counter].load(std::memory_order_relaxed); }
+  size_t traceCapacity() const;
+
+  // Moves the spans recorded since the last drain into `spans`, oldest
+  // first, and returns how many were overwritten before they could be.
+  uint64_t Drain(std::vector<TraceSpan>& spans);
+
+  // Zeroes the histograms and counters.
+  void Reset();
+
+ private:
+  struct Slot {
+    // Sequence number + 1 of the span in the slot once written, 0 while a
+    // writer is filling it.
+    std::atomic<uint64_t> sequence{0};
+    std::atomic<uint32_t> stage{0};
+    std::atomic<uint64_t> startNanos{0};
+    std::atomic<uint64_t> durationNanos{0};
+  };
+  struct Ring {
+    explicit Ring(size_t size) : capacity(size), slots(new Slot[size]) {}
+
+    size_t capacity;
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<uint64_t> head{0};
+  };
+
+  const char* const* stageNames_;
+  size_t stageCount_;
+  std::unique_ptr<LatencyHistogram[]> stages_;
+  const char* const* counterNames_;
+  size_t counterCount_;
+  std::unique_ptr<std::atomic<uint64_t>[]> counters_;
+
+  // Frees the retired rings once no Record is inside one. Needs mutex_.
+  void ReclaimRetired();
+
+  std::atomic<bool> enabled_{false};
+  std::atomic<Ring*> ring_{nullptr};
+  // Records between loading ring_ and their last slot write. A ring replaced
+  // while this is nonzero may still be written to, so it is only retired.
+  std::atomic<uint32_t> writers_{0};
+  // Guards the rest, which only Configure and Drain touch.
+  std::mutex mutex_;
+  std::unique_ptr<Ring> owned_;
+  std::vector<std::unique_ptr<Ring>> retired_;
+  uint64_t tail_ = 0;
+  uint64_t dropped_ = 0;
+  // system_clock minus steady_clock, to report spans in Unix time.
+  int64_t wallOffsetNanos_ = 0;
+};
+
+// Times the enclosing scope as `stage` when `metrics` is enabled.
+class ScopedStage {
+ public:
+  ScopedStage(NativeMetrics& metrics, uint32_t stage)
+      : metrics_(metrics), stage_(stage), start_(metrics.enabled() ? NativeMetrics::Now() : 0) {}
+  ~ScopedStage() {
+    if (start_ != 0) {
+      metrics_.Record(stage_, start_, NativeMetrics::Now());
+    }
+  }
+
+  ScopedStage(const ScopedStage&) = delete;
+  ScopedStage& operator=(const ScopedStage&) = delete;
+
+ private:
+  NativeMetrics& metrics_;
+  uint32_t stage_;
+  uint64_t start_;
+};
+
+} // namespace tuff::native
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <napi.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "common/native_metrics.h"
+
+namespace tuff::native {
+
+// The getNativeMetrics(), configureNativeMetrics() and drainNativeTraceSpans()
+// halves both addons share; each adds its own queue depths.
+
+// { enabled, tracing, traceCapacity, stages: { [name]: { count, totalMs,
+// maxMs, p50Ms, p95Ms, p99Ms } }, counters: { [name]: count } }
+inline Napi::Object ToJsNativeMetrics(Napi::Env env, const NativeMetrics& metrics) {
+  const auto ms = [&env](uint64_t nanos) { return Napi::Number::New(env, static_cast<double>(nanos) / 1e6); };
+
+  auto stages = Napi::Object::New(env);
+  for (uint32_t i = 0; i < metrics.stageCount(); ++i) {
+    const LatencyHistogram::Snapshot snapshot = metrics.ReadStage(i);
+    auto stage = Napi::Object::New(env);
+    stage.Set("count", Napi::Number::New(env, static_cast<double>(snapshot.count)));
+    stage.Set("totalMs", ms(snapshot.totalNanos));
+    stage.Set("maxMs", ms(snapshot.maxNanos));
+    stage.Set("p50Ms", ms(snapshot.Quantile(0.5)));
+    stage.Set("p95Ms", ms(snapshot.Quantile(0.95)));
+    stage.Set("p99Ms", ms(snapshot.Quantile(0.99)));
+    stages.Set(metrics.stageName(i), stage);
+  }
+
+  auto counters = Napi::Object::New(env);
+  for (uint32_t i = 0; i < metrics.counterCount(); ++i) {
+    counters.Set(metrics.counterName(i), Napi::Number::New(env, static_cast<double>(metrics.ReadCounter(i))));
+  }
+
+  auto output = Napi::Object::New(env);
+  output.Set("enabled", Napi::Boolean::New(env, metrics.enabled()));
+  output.Set("tracing", Napi::Boolean::New(env, metrics.tracing()));
+  output.Set("traceCapacity", Napi::Number::New(env, static_cast<double>(metrics.traceCapacity())));
+  output.Set("stages", stages);
+  output.Set("counters", counters);
+  return output;
+}
+
+// { enabled?, traceCapacity?, reset? }: omitted keys keep their value.
+// Returns false with a TypeError thrown for anything else.
+inline bool ConfigureNativeMetrics(const Napi::CallbackInfo& info, NativeMetrics& metrics) {
+  auto env = info.Env();
+  bool enabled = metrics.enabled();
+  size_t traceCapacity = metrics.traceCapacity();
+  if (info.Length() >= 1 && !info[0].IsUndefined()) {
+    if (!info[0].IsObject()) {
+      Napi::TypeError::New(env, "configureNativeMetrics expects an options object").ThrowAsJavaScriptException();
+      return false;
+    }
+    const auto input = info[0].As<Napi::Object>();
+    if (input.Has("enabled") && input.Get("enabled").IsBoolean()) {
+      enabled = input.Get("enabled").As<Napi::Boolean>().Value();
+    }
+    if (input.Has("traceCapacity") && input.Get("traceCapacity").IsNumber()) {
+      // A slot is 32 bytes; a million of them is plenty.
+      const int64_t capacity = input.Get("traceCapacity").As<Napi::Number>().Int64Value();
+      traceCapacity = static_cast<size_t>(std::clamp<int64_t>(capacity, 0, 1 << 20));
+    }
+    if (input.Has("reset") && input.Get("reset").ToBoolean().Value()) {
+      metrics.Reset();
+    }
+  }
+  metrics.Configure(enabled, traceCapacity);
+  return true;
+}
+
+// { spans: [{ stage, startedAt, durationMs }], dropped }, with startedAt in
+// Unix milliseconds like performance.timeOrigin + performance.now().
+inline Napi::Object DrainJsTraceSpans(Napi::Env env, NativeMetrics& metrics) {
+  std::vector<TraceSpan> spans;
+  const uint64_t dropped = metrics.Drain(spans);
+
+  auto array = Napi::Array::New(env, spans.size());
+  for (size_t i = 0; i < spans.size(); ++i) {
+    auto span = Napi::Object::New(env);
+    span.Set("stage", Napi::String::New(env, metrics.stageName(spans[i].stage)));
+    span.Set("startedAt", Napi::Number::New(env, static_cast<double>(spans[i].startNanos) / 1e6));
+    span.Set("durationMs", Napi::Number::New(env, static_cast<double>(spans[i].durationNanos) / 1e6));
+    array.Set(static_cast<uint32_t>(i), span);
+  }
+
+  auto output = Napi::Object::New(env);
+  output.Set("spans", array);
+  output.Set("dropped", Napi::Number::New(env, static_cast<double>(dropped)));
+  return output;
+}
+
+} // namespace tuff::native
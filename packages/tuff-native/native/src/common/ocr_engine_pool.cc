@@ -0,0 +1,742 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <list>
+#include <utility>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <pthread.h>
+#include <sys/qos.h>
+#include <sys/sysctl.h>
+#include <sys/types.h>
+#elif defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <sstream>
+#endif
+
+#include "common/image_preprocess.h"
+#include "common/ocr_metrics.h"
+#include "common/ocr_result_cache.h"
+#include "common/ocr_session.h"
+#include "common/ocr_tiling.h"
+#include "common/ocr_types.h"
+#include "common/text_detect.h"
+
+namespace tuff::native {
+
+namespace {
+
+// How often an idle thread looks for engines to evict.
+constexpr auto kReapInterval = std::chrono::seconds(30);
+
+// Raw pixels for the perceptual hash. An encoded image is decoded here, once,
+// and the engine is then given the pixels.
+bool EnsurePixels(OcrImage& image) {
+  if (image.format != OcrPixelFormat::kEncoded) {
+    return true;
+  }
+  OcrImage decoded;
+  OcrError ignored;
+  if (!DecodePlatformImage(image, decoded, ignored)) {
+    return false;
+  }
+  image = std::move(decoded);
+  return true;
+}
+
+} // namespace
+
+// The tiles of one job, shared by the lane that owns the job and the helper
+// jobs it queues on other lanes. Each tile is claimed by whichever lane gets
+// to it first; the owner claims tiles too, so a job never waits on a helper
+// that has not started.
+struct OcrEnginePool::TileWork {
+  // Layout is always on for tiles; the merge needs every line's position.
+  OcrOptions options;
+  std::function<bool()> isCancelled;
+  std::vector<OcrTile> tiles;
+  std::vector<OcrResult> results;
+  std::vector<OcrError> errors;
+  std::vector<char> succeeded;
+
+  std::mutex mutex;
+  std::condition_variable finished;
+  size_t next = 0;
+  size_t remaining = 0;
+};
+
+struct OcrEnginePool::Job {
+  std::string language;
+  OcrTask task;
+  // Set on helper jobs, which recognize tiles of another job and have no
+  // task of their own.
+  std::shared_ptr<TileWork> tiles;
+  // NativeMetrics::Now() at Submit, or 0 while metrics are off.
+  uint64_t submittedAt = 0;
+};
+
+struct OcrEnginePool::Lane {
+  explicit Lane(OcrPriority lanePriority) : priority(lanePriority) {}
+
+  OcrPriority priority;
+  std::thread thread;
+  std::deque<std::unique_ptr<Job>> queue;
+  std::condition_variable wake;
+  bool busy = false;
+  bool trim = false;
+  // Languages this lane holds an engine for; mirrors the thread-local list
+  // so jobs can be routed without asking the thread.
+  std::vector<std::string> languages;
+
+  bool Holds(const std::string& language) const {
+    return std::find(languages.begin(), languages.end(), language) != languages.end();
+  }
+  size_t Load() const { return queue.size() + (busy ? 1 : 0); }
+};
+
+OcrEnginePool::OcrEnginePool(std::unique_ptr<OcrEngineFactory> factory, OcrEnginePoolOptions options)
+    : factory_(std::move(factory)), options_(options) {
+  options_.threads = std::max<uint32_t>(1, options_.threads);
+  options_.maxEnginesPerThread = std::max<uint32_t>(1, options_.maxEnginesPerThread);
+}
+
+OcrEnginePool::~OcrEnginePool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+    for (auto& lane : lanes_) {
+      lane->wake.notify_all();
+    }
+  }
+  for (auto& lane : lanes_) {
+    if (lane->thread.joinable()) {
+      lane->thread.join();
+    }
+  }
+}
+
+void OcrEnginePool::Submit(OcrTask task) {
+  auto job = std::make_unique<Job>();
+  job->language = factory_->ResolveLanguage(task.options.languageHint);
+  job->task = std::move(task);
+  job->submittedAt = OcrMetrics().enabled() ? NativeMetrics::Now() : 0;
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (stopping_) {
+    lock.unlock();
+    OcrResult result;
+    OcrError error{"ERR_OCR_ENGINE_UNAVAILABLE", "OCR engine pool is shutting down"};
+    job->task.done(false, result, error);
+    return;
+  }
+  Lane& lane = PickLaneLocked(job->task.priority, job->language);
+  lane.queue.push_back(std::move(job));
+  lane.wake.notify_one();
+  ++stats_.jobs;
+}
+
+bool OcrEnginePool::Recognize(const OcrOptions& options, OcrResult& result, OcrError& error) {
+  std::mutex mutex;
+  std::condition_variable finished;
+  bool done = false;
+  bool ok = false;
+
+  OcrTask task;
+  task.options = options;
+  task.done = [&](bool success, OcrResult& taskResult, OcrError& taskError) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ok = success;
+    result = std::move(taskResult);
+    error = std::move(taskError);
+    done = true;
+    finished.notify_one();
+  };
+  Submit(std::move(task));
+
+  std::unique_lock<std::mutex> lock(mutex);
+  finished.wait(lock, [&done] { return done; });
+  return ok;
+}
+
+void OcrEnginePool::Configure(uint32_t threads, uint32_t backgroundThreads) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  options_.threads = std::max<uint32_t>(1, threads);
+  options_.backgroundThreads = backgroundThreads;
+
+  uint32_t interactive = 0;
+  uint32_t background = 0;
+  for (auto& lane : lanes_) {
+    const bool isBackground = lane->priority == OcrPriority::kBackground;
+    uint32_t& position = isBackground ? background : interactive;
+    if (position++ >= (isBackground ? options_.backgroundThreads : options_.threads)) {
+      lane->trim = true;
+      lane->wake.notify_one();
+    }
+  }
+}
+
+void OcrEnginePool::Trim() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& lane : lanes_) {
+    lane->trim = true;
+    lane->wake.notify_one();
+  }
+}
+
+OcrEnginePoolStats OcrEnginePool::Stats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  OcrEnginePoolStats stats = stats_;
+  stats.threads = static_cast<uint32_t>(lanes_.size());
+  stats.engines = 0;
+  for (const auto& lane : lanes_) {
+    stats.engines += lane->languages.size();
+    uint32_t& queued = lane->priority == OcrPriority::kBackground ? stats.queuedBackground : stats.queuedInteractive;
+    queued += static_cast<uint32_t>(lane->queue.size());
+    stats.busyThreads += lane->busy ? 1 : 0;
+  }
+  return stats;
+}
+
+OcrPriority OcrEnginePool::LanePriorityLocked(OcrPriority priority) const {
+  // Background work has lanes of its own unless there are none; interactive
+  // work never lands on a background lane.
+  if (priority == OcrPriority::kBackground && options_.backgroundThreads == 0) {
+    return OcrPriority::kInteractive;
+  }
+  return priority;
+}
+
+uint32_t OcrEnginePool::LaneLimitLocked(OcrPriority priority) const {
+  return LanePriorityLocked(priority) == OcrPriority::kBackground ? options_.backgroundThreads : options_.threads;
+}
+
+OcrEnginePool::Lane& OcrEnginePool::PickLaneLocked(OcrPriority priority, const std::string& language) {
+  priority = LanePriorityLocked(priority);
+  const uint32_t limit = LaneLimitLocked(priority);
+
+  // Lanes past the limit, left over from a Configure() that lowered it, are
+  // not offered work.
+  std::vector<Lane*> candidates;
+  for (auto& lane : lanes_) {
+    if (lane->priority == priority && candidates.size() < limit) {
+      candidates.push_back(lane.get());
+    }
+  }
+
+  // Another lane is started while none is free and the limit allows it.
+  // Otherwise the lane with the least work ahead of the job wins, counting a
+  // missing engine as one more job since constructing it costs about as much
+  // as a recognition; on a tie, the lane that holds the engine, so engines
+  // are not duplicated across lanes for nothing.
+  const bool anyFree =
+      std::any_of(candidates.begin(), candidates.end(), [](const Lane* lane) { return lane->Load() == 0; });
+  if (!anyFree && candidates.size() < limit) {
+    lanes_.push_back(std::make_unique<Lane>(priority));
+    Lane* lane = lanes_.back().get();
+    lane->thread = std::thread([this, lane] { RunLane(*lane); });
+    return *lane;
+  }
+
+  Lane* best = nullptr;
+  size_t bestCost = 0;
+  bool bestHolds = false;
+  for (Lane* lane : candidates) {
+    const bool holds = lane->Holds(language);
+    const size_t cost = lane->Load() + (holds ? 0 : 1);
+    if (best == nullptr || cost < bestCost || (cost == bestCost && holds && !bestHolds)) {
+      best = lane;
+      bestCost = cost;
+      bestHolds = holds;
+    }
+  }
+  return *best;
+}
+
+void OcrEnginePool::RunLane(Lane& lane) {
+  struct Entry {
+    std::string language;
+    std::unique_ptr<OcrEngine> engine;
+    std::chrono::steady_clock::time_point lastUsed;
+  };
+
+  if (lane.priority == OcrPriority::kBackground) {
+    LowerCurrentThreadPriority();
+  }
+
+  // A thread that could not be set up still serves jobs; whatever the engine
+  // needed from it fails there and is reported per call.
+  std::shared_ptr<void> threadState;
+  try {
+    threadState = factory_->AttachThread();
+  } catch (...) {
+  }
+  // Most recently used first. Declared after threadState so the engines are
+  // destroyed before it.
+  std::list<Entry> engines;
+
+  // Destroys the engines `evict` selects, outside the lock; expects it held
+  // on entry and holds it again on return.
+  auto evictIf = [&](std::unique_lock<std::mutex>& lock, auto evict) {
+    std::list<Entry> evicted;
+    for (auto it = engines.begin(); it != engines.end();) {
+      if (evict(*it)) {
+        lane.languages.erase(std::remove(lane.languages.begin(), lane.languages.end(), it->language),
+                             lane.languages.end());
+        evicted.splice(evicted.end(), engines, it++);
+      } else {
+        ++it;
+      }
+    }
+    stats_.enginesEvicted += evicted.size();
+    lock.unlock();
+    evicted.clear();
+    lock.lock();
+  };
+
+  // This lane's engine for `language`, created if needed.
+  auto acquire = [&](const std::string& language, OcrError& error, bool& created,
+                     std::list<Entry>& overflow) -> OcrEngine* {
+    auto found = std::find_if(engines.begin(), engines.end(),
+                              [&language](const Entry& entry) { return entry.language == language; });
+    if (found != engines.end()) {
+      engines.splice(engines.begin(), engines, found);
+    } else {
+      std::unique_ptr<OcrEngine> engine;
+      {
+        ScopedStage timed(OcrMetrics(), kOcrStageEngineCreate);
+        engine = factory_->Create(language, error);
+      }
+      if (!engine) {
+        return nullptr;
+      }
+      engines.push_front(Entry{language, std::move(engine), {}});
+      created = true;
+      while (engines.size() > options_.maxEnginesPerThread) {
+        overflow.splice(overflow.end(), engines, std::prev(engines.end()));
+      }
+    }
+    engines.front().lastUsed = std::chrono::steady_clock::now();
+    return engines.front().engine.get();
+  };
+
+  auto hasUnclaimedTiles = [](TileWork& work) {
+    std::lock_guard<std::mutex> lock(work.mutex);
+    return work.next < work.tiles.size();
+  };
+
+  // Recognizes unclaimed tiles of `work` until there are none left.
+  auto drainTiles = [](TileWork& work, OcrEngine& engine) {
+    for (;;) {
+      size_t index = 0;
+      {
+        std::lock_guard<std::mutex> lock(work.mutex);
+        if (work.next == work.tiles.size()) {
+          return;
+        }
+        index = work.next++;
+      }
+      OcrError& tileError = work.errors[index];
+      bool ok = false;
+      if (work.isCancelled && work.isCancelled()) {
+        tileError.code = "ERR_OCR_ABORTED";
+        tileError.message = "OCR task was cancelled";
+      } else {
+        const OcrTile& tile = work.tiles[index];
+        OcrOptions options = work.options;
+        options.image = CropImageView(work.options.image, tile.x, tile.y, tile.width, tile.height);
+        ScopedStage timed(OcrMetrics(), kOcrStageRecognize);
+        try {
+          ok = engine.Recognize(options, work.results[index], tileError);
+        } catch (const std::exception& ex) {
+          tileError.code = "ERR_OCR_RECOGNIZE_FAILED";
+          tileError.message = ex.what();
+        } catch (...) {
+          tileError.code = "ERR_OCR_RECOGNIZE_FAILED";
+          tileError.message = "OCR recognition failed";
+        }
+      }
+      std::lock_guard<std::mutex> lock(work.mutex);
+      work.succeeded[index] = ok ? 1 : 0;
+      if (--work.remaining == 0) {
+        work.finished.notify_all();
+      }
+    }
+  };
+
+  // Recognizes `tiles` of the job's image, queueing helpers for as many
+  // other lanes as the limit allows and working through the tiles alongside
+  // them. Fails only when the job was cancelled; tiles that failed otherwise
+  // are left for the caller to weigh.
+  auto recognizeTiles = [&](Job& job, OcrEngine& engine, std::vector<OcrTile> tiles,
+                            std::shared_ptr<TileWork>& work, OcrError& error) {
+    work = std::make_shared<TileWork>();
+    work->options = job.task.options;
+    work->options.includeLayout = true;
+    work->options.maxBlocks = 0;
+    work->isCancelled = job.task.isCancelled;
+    work->tiles = std::move(tiles);
+    work->results.resize(work->tiles.size());
+    work->errors.resize(work->tiles.size());
+    work->succeeded.assign(work->tiles.size(), 0);
+    work->remaining = work->tiles.size();
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      const uint32_t limit = LaneLimitLocked(job.task.priority);
+      const size_t helpers = std::min<size_t>(work->tiles.size() - 1, limit > 0 ? limit - 1 : 0);
+      for (size_t i = 0; i < helpers && !stopping_; ++i) {
+        auto helper = std::make_unique<Job>();
+        helper->language = job.language;
+        helper->task.priority = job.task.priority;
+        helper->tiles = work;
+        Lane& target = PickLaneLocked(job.task.priority, job.language);
+        target.queue.push_back(std::move(helper));
+        target.wake.notify_one();
+      }
+      stats_.tiles += work->tiles.size();
+    }
+
+    drainTiles(*work, engine);
+    {
+      std::unique_lock<std::mutex> lock(work->mutex);
+      work->finished.wait(lock, [&work] { return work->remaining == 0; });
+    }
+
+    // A job cancelled part way fails as a whole rather than with the tiles
+    // that happened to finish first.
+    for (const OcrError& tileError : work->errors) {
+      if (tileError.code == "ERR_OCR_ABORTED") {
+        error = tileError;
+        return false;
+      }
+    }
+    return true;
+  };
+
+  // Recognizes the job's image whole, or split into tiles when it is larger
+  // than `tileSize`.
+  auto recognizeImage = [&](Job& job, OcrEngine& engine, uint32_t tileSize, OcrResult& result, OcrError& error) {
+    // Only pixels say how large the image is, so an encoded image is decoded
+    // here rather than by the engine whenever tiling could apply.
+    OcrImage& image = job.task.options.image;
+    const bool tiled = tileSize > 0 && !image.empty() && EnsurePixels(image) &&
+                       (image.width > tileSize || image.height > tileSize);
+    if (!tiled) {
+      ScopedStage timed(OcrMetrics(), kOcrStageRecognize);
+      return engine.Recognize(job.task.options, result, error);
+    }
+    std::shared_ptr<TileWork> work;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++stats_.tiledJobs;
+    }
+    if (!recognizeTiles(job, engine, PlanOcrTiles(image.width, image.height, tileSize, job.task.options.tiling.overlap),
+                        work, error)) {
+      return false;
+    }
+    ScopedStage timed(OcrMetrics(), kOcrStageTileMerge);
+    return MergeOcrTiles(work->tiles, work->results, work->errors, work->succeeded, result, error);
+  };
+
+  // Recognizes the job's image as the next frame of its session: nothing
+  // when it matches the previous frame, the changed regions when little
+  // changed, otherwise the whole frame.
+  auto recognizeFrame = [&](Job& job, OcrEngine& engine, uint32_t tileSize, OcrResult& result, OcrError& error) {
+    OcrSession& session = *job.task.session;
+    OcrOptions& options = job.task.options;
+    const auto lock = session.Lock();
+    OcrSessionPlan plan;
+    EnsurePixels(options.image);
+    session.Plan(options.image, job.language, plan);
+
+    bool ok = false;
+    const OcrPreprocessReport preprocess = result.preprocess;
+    if (plan.full) {
+      // The session needs every line's position for the next frame.
+      OcrOptions requested = options;
+      options.includeLayout = true;
+      options.maxBlocks = 0;
+      ok = recognizeImage(job, engine, tileSize, result, error);
+      options = std::move(requested);
+    } else if (plan.regions.empty()) {
+      result = session.previous();
+      result.preprocess = preprocess;
+      result.incremental.reusedBlocks = static_cast<uint32_t>(result.blocks.size());
+      ok = !result.text.empty();
+    } else {
+      std::shared_ptr<TileWork> work;
+      if (recognizeTiles(job, engine, plan.regions, work, error)) {
+        ScopedStage timed(OcrMetrics(), kOcrStageTileMerge);
+        ok = session.Splice(plan, work->results, work->errors, work->succeeded, result, error);
+      }
+    }
+
+    if (ok) {
+      session.Commit(options.image, job.language, result);
+    } else {
+      session.Reset();
+    }
+    result.incremental.applied = true;
+    result.incremental.full = plan.full;
+    result.incremental.regions = static_cast<uint32_t>(plan.regions.size());
+    result.incremental.changedFraction = plan.changedFraction;
+    return ok;
+  };
+
+  // Loads the image and answers from the result cache, or preprocesses it
+  // and recognizes it on this lane's engine for the job's language, creating
+  // the engine if needed. `durationMs` covers all of that but not the time
+  // spent queued.
+  auto run = [&](Job& job, OcrResult& result, OcrError& error, bool& created, std::list<Entry>& overflow) {
+    const auto startedAt = std::chrono::steady_clock::now();
+    OcrTask& task = job.task;
+    if ((task.start && !task.start()) || (task.isCancelled && task.isCancelled())) {
+      error.code = "ERR_OCR_ABORTED";
+      error.message = "OCR task was cancelled";
+      return false;
+    }
+    if (std::chrono::steady_clock::now() >= task.deadline) {
+      error.code = "ERR_OCR_DEADLINE_EXCEEDED";
+      error.message = "OCR task did not start before its deadline";
+      return false;
+    }
+    NativeMetrics& metrics = OcrMetrics();
+    if (task.prepare) {
+      ScopedStage timed(metrics, kOcrStagePrepare);
+      if (!task.prepare(task.options, error)) {
+        return false;
+      }
+    }
+    const auto finish = [&] {
+      const auto elapsed =
+          std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startedAt);
+      result.durationMs = static_cast<uint64_t>(std::max<int64_t>(0, elapsed.count()));
+      return true;
+    };
+
+    OcrResultCache& cache = OcrResultCache::Instance();
+    OcrResultCacheKey cacheKey;
+    const bool cacheable = !task.session && !task.options.image.empty() && cache.enabled();
+    if (cacheable) {
+      ScopedStage timed(metrics, kOcrStageCacheLookup);
+      OcrResultCache::MakeKey(task.options, job.language, cacheKey);
+      OcrResultCache::Result hit = cache.Lookup(cacheKey);
+      if (!hit && cache.perceptual() && EnsurePixels(task.options.image)) {
+        OcrResultCache::AddPerceptualHash(task.options.image, cacheKey);
+        hit = cache.LookupPerceptual(cacheKey);
+      }
+      if (hit) {
+        result = *hit;
+        result.cached = true;
+        return finish();
+      }
+      cache.CountMiss();
+    }
+
+    {
+      ScopedStage timed(metrics, kOcrStagePreprocess);
+      if (!PreprocessOcrImage(task.options, result.preprocess, error)) {
+        return false;
+      }
+    }
+
+    // Checked before an engine is woken, let alone created. Images that
+    // cannot be decoded here go to the engine unchecked.
+    const OcrTextDetectionOptions& textDetection = task.options.textDetection;
+    bool textless = false;
+    if (textDetection.active() && !task.session) {
+      ScopedStage timed(metrics, kOcrStageTextDetection);
+      textless = EnsurePixels(task.options.image) && DetectText(task.options.image, result.textDetection) &&
+                 result.textDetection.score < textDetection.threshold;
+    }
+    if (textless) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.textlessJobs;
+      }
+      char score[64];
+      std::snprintf(score, sizeof(score), "%.2f, below %.2f", result.textDetection.score, textDetection.threshold);
+      error.code = "ERR_OCR_NO_TEXT";
+      error.message = std::string("Image is unlikely to contain text (likelihood ") + score + ")";
+      return false;
+    }
+
+    OcrEngine* engine = acquire(job.language, error, created, overflow);
+    if (engine == nullptr) {
+      return false;
+    }
+
+    uint32_t tileSize = task.options.tiling.tileSize;
+    const uint32_t engineLimit = factory_->MaxImageDimension();
+    if (engineLimit > 0 && (tileSize == 0 || tileSize > engineLimit)) {
+      tileSize = engineLimit;
+    }
+    if (task.session ? !recognizeFrame(job, *engine, tileSize, result, error)
+                     : !recognizeImage(job, *engine, tileSize, result, error)) {
+      return false;
+    }
+    // Tiles and sessions recognize with layout on; the caller may not want it.
+    if (!task.options.includeLayout) {
+      result.blocks.clear();
+    } else if (task.options.maxBlocks > 0 && result.blocks.size() > static_cast<size_t>(task.options.maxBlocks)) {
+      result.blocks.resize(static_cast<size_t>(task.options.maxBlocks));
+    }
+    MapBlocksToSource(result.preprocess, result.blocks);
+    if (cacheable) {
+      cache.Insert(cacheKey, result);
+    }
+    return finish();
+  };
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stopping_) {
+    if (lane.trim) {
+      lane.trim = false;
+      evictIf(lock, [](const Entry&) { return true; });
+      continue;
+    }
+
+    if (lane.queue.empty()) {
+      const bool woken = lane.wake.wait_for(lock, kReapInterval, [&lane, this] {
+        return stopping_ || lane.trim || !lane.queue.empty();
+      });
+      if (!woken && !engines.empty()) {
+        const auto now = std::chrono::steady_clock::now();
+        const auto timeout = std::chrono::milliseconds(options_.idleTimeoutMs);
+        lock.unlock();
+        const bool memoryLow = IsSystemMemoryLow();
+        lock.lock();
+        evictIf(lock, [&](const Entry& entry) { return memoryLow || now - entry.lastUsed >= timeout; });
+      }
+      continue;
+    }
+
+    std::unique_ptr<Job> job = std::move(lane.queue.front());
+    lane.queue.pop_front();
+    lane.busy = true;
+    lock.unlock();
+
+    NativeMetrics& metrics = OcrMetrics();
+    if (job->submittedAt != 0 && !job->tiles) {
+      metrics.Record(kOcrStageQueueWait, job->submittedAt, NativeMetrics::Now());
+    }
+
+    OcrResult result;
+    OcrError error;
+    bool created = false;
+    std::list<Entry> overflow;
+    bool ok = false;
+    try {
+      if (job->tiles) {
+        // A helper that finds every tile claimed finishes without touching
+        // the engines, so it never creates or evicts one for nothing. One
+        // that cannot get an engine leaves its tiles to the owner.
+        if (hasUnclaimedTiles(*job->tiles)) {
+          if (OcrEngine* engine = acquire(job->language, error, created, overflow)) {
+            drainTiles(*job->tiles, *engine);
+          }
+        }
+      } else {
+        ok = run(*job, result, error, created, overflow);
+      }
+    } catch (const std::exception& ex) {
+      error.code = "ERR_OCR_RECOGNIZE_FAILED";
+      error.message = ex.what();
+    } catch (...) {
+      error.code = "ERR_OCR_RECOGNIZE_FAILED";
+      error.message = "OCR recognition failed";
+    }
+    const size_t overflowCount = overflow.size();
+    overflow.clear();
+    if (!job->tiles) {
+      if (ok) {
+        metrics.Add(result.cached ? kOcrCounterCached : kOcrCounterSucceeded);
+      } else {
+        metrics.Add(error.code == "ERR_OCR_ABORTED" ? kOcrCounterCancelled : kOcrCounterFailed);
+      }
+      if (job->submittedAt != 0) {
+        metrics.Record(kOcrStageTotal, job->submittedAt, NativeMetrics::Now());
+      }
+    }
+    if (job->task.done) {
+      job->task.done(ok, result, error);
+    }
+    job.reset();
+
+    lock.lock();
+    if (created) {
+      ++stats_.enginesCreated;
+      lane.languages.clear();
+      for (const auto& entry : engines) {
+        lane.languages.push_back(entry.language);
+      }
+    }
+    stats_.enginesEvicted += overflowCount;
+    lane.busy = false;
+  }
+
+  std::deque<std::unique_ptr<Job>> dropped;
+  dropped.swap(lane.queue);
+  lock.unlock();
+  for (auto& job : dropped) {
+    if (!job->task.done) {
+      continue;
+    }
+    OcrResult result;
+    OcrError error{"ERR_OCR_ENGINE_UNAVAILABLE", "OCR engine pool is shutting down"};
+    job->task.done(false, result, error);
+  }
+  engines.clear();
+}
+
+bool IsSystemMemoryLow() {
+#if defined(_WIN32)
+  MEMORYSTATUSEX status{};
+  status.dwLength = sizeof(status);
+  return GlobalMemoryStatusEx(&status) != 0 && status.dwMemoryLoad >= 90;
+#elif defined(__APPLE__)
+  // Percentage of memory the kernel considers available.
+  int level = 100;
+  size_t length = sizeof(level);
+  return sysctlbyname("kern.memorystatus_level", &level, &length, nullptr, 0) == 0 && level <= 10;
+#elif defined(__linux__)
+  std::ifstream meminfo("/proc/meminfo");
+  uint64_t total = 0;
+  uint64_t available = 0;
+  std::string line;
+  while ((total == 0 || available == 0) && std::getline(meminfo, line)) {
+    std::istringstream fields(line);
+    std::string key;
+    uint64_t kib = 0;
+    fields >> key >> kib;
+    if (key == "MemTotal:") {
+      total = kib;
+    } else if (key == "MemAvailable:") {
+      available = kib;
+    }
+  }
+  return total != 0 && available != 0 && available * 10 <= total;
+#else
+  return false;
+#endif
+}
+
+void LowerCurrentThreadPriority() {
+#if defined(_WIN32)
+  SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+#elif defined(__APPLE__)
+  pthread_set_qos_class_self_np(QOS_CLASS_UTILITY, 0);
+#elif defined(__linux__)
+  // Linux applies nice values per thread when given a thread id.
+  setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 10);
+#endif
+}
+
+} // namespace tuff::native
@@ -0,0 +1,142 @@
+#include "common/ocr_input.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "common/base64.h"
+#include "common/utf_transcode.h"
+
+namespace tuff::native {
+
+namespace {
+
+class FileMapping {
+ public:
+  FileMapping(const FileMapping&) = delete;
+  FileMapping& operator=(const FileMapping&) = delete;
+  FileMapping() = default;
+
+  ~FileMapping() {
+#if defined(_WIN32)
+    if (data_ != nullptr) {
+      UnmapViewOfFile(data_);
+    }
+#else
+    if (data_ != nullptr) {
+      ::munmap(const_cast<uint8_t*>(data_), size_);
+    }
+#endif
+  }
+
+  // Returns an empty string on success, otherwise why the file could not be
+  // mapped.
+  std::string Open(const std::string& path) {
+#if defined(_WIN32)
+    const std::wstring widePath = Utf8ToWide(path);
+    HANDLE file = CreateFileW(widePath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+      return "Failed to open image file";
+    }
+    LARGE_INTEGER length{};
+    if (!GetFileSizeEx(file, &length) || length.QuadPart <= 0) {
+      CloseHandle(file);
+      return "Image file is empty";
+    }
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr) {
+      return "Failed to map image file";
+    }
+    data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    CloseHandle(mapping);
+    if (data_ == nullptr) {
+      return "Failed to map image file";
+    }
+    size_ = static_cast<size_t>(length.QuadPart);
+    return std::string();
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      return "Failed to open image file";
+    }
+    struct stat info {};
+    if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size <= 0) {
+      ::close(fd);
+      return "Image file is empty or not a regular file";
+    }
+    void* mapped = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+      return "Failed to map image file";
+    }
+    // Decoders read the file front to back, once.
+    ::madvise(mapped, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+    data_ = static_cast<const uint8_t*>(mapped);
+    size_ = static_cast<size_t>(info.st_size);
+    return std::string();
+#endif
+  }
+
+  const uint8_t* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+} // namespace
+
+bool MapImageFile(const std::string& path, OcrImage& image, OcrError& error) {
+  auto mapping = std::make_shared<FileMapping>();
+  const std::string failure = mapping->Open(path);
+  if (!failure.empty()) {
+    error.code = "ERR_OCR_DECODE_FAILED";
+    error.message = failure + ": " + path;
+    return false;
+  }
+  image.data = mapping->data();
+  image.size = mapping->size();
+  image.format = OcrPixelFormat::kEncoded;
+  image.owner = std::move(mapping);
+  return true;
+}
+
+bool DecodeImageDataUrl(const std::string& dataUrl, OcrImage& image, OcrError& error) {
+  size_t payload = 0;
+  if (dataUrl.compare(0, 5, "data:") == 0) {
+    const size_t comma = dataUrl.find(',');
+    const size_t marker = dataUrl.rfind(";base64", comma);
+    if (comma == std::string::npos || marker == std::string::npos || marker + 7 != comma) {
+      error.code = "ERR_OCR_DECODE_FAILED";
+      error.message = "Image data URL is not base64-encoded";
+      return false;
+    }
+    payload = comma + 1;
+  }
+
+  auto bytes = std::make_shared<std::vector<uint8_t>>();
+  if (!DecodeBase64(dataUrl.data() + payload, dataUrl.size() - payload, *bytes) || bytes->empty()) {
+    error.code = "ERR_OCR_DECODE_FAILED";
+    error.message = "Image data URL payload is not valid base64";
+    return false;
+  }
+  image.data = bytes->data();
+  image.size = bytes->size();
+  image.format = OcrPixelFormat::kEncoded;
+  image.owner = std::move(bytes);
+  return true;
+}
+
+} // namespace tuff::native
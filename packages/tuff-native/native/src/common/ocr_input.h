@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+
+#include "common/ocr_types.h"
+
+namespace tuff::native {
+
+// Maps the file at `path` read-only; `image` then borrows the mapping and
+// keeps it alive.
+bool MapImageFile(const std::string& path, OcrImage& image, OcrError& error);
+
+// Decodes "data:<type>;base64,<payload>", or bare base64 as the JS worker used
+// to accept, into memory `image` owns.
+bool DecodeImageDataUrl(const std::string& dataUrl, OcrImage& image, OcrError& error);
+
+} // namespace tuff::native
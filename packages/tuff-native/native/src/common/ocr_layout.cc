@@ -0,0 +1,92 @@
+#include "common/ocr_layout.h"
+
+#include <cstring>
+#include <limits>
+
+namespace tuff::native {
+
+namespace {
+
+constexpr float kMissing = std::numeric_limits<float>::quiet_NaN();
+
+// Stores through memcpy: `out` is a byte buffer.
+template <typename T>
+void Store(uint8_t* out, size_t offset, size_t index, T value) {
+  std::memcpy(out + offset + index * sizeof(T), &value, sizeof(T));
+}
+
+void StoreBox(uint8_t* out, size_t offset, size_t index, const std::array<double, 4>& box) {
+  for (size_t i = 0; i < 4; ++i) {
+    Store(out, offset, index * 4 + i, static_cast<float>(box[i]));
+  }
+}
+
+} // namespace
+
+OcrCompactLayout PlanOcrCompactLayout(const std::vector<OcrBlock>& blocks) {
+  OcrCompactLayout layout;
+  size_t words = 0;
+  for (const OcrBlock& block : blocks) {
+    words += block.words.size();
+    layout.textBytes += block.text.size();
+    for (const OcrWord& word : block.words) {
+      layout.textBytes += word.text.size();
+    }
+  }
+  layout.lines = static_cast<uint32_t>(blocks.size());
+  layout.words = static_cast<uint32_t>(words);
+
+  size_t offset = 0;
+  const auto take = [&offset](size_t bytes) {
+    const size_t start = offset;
+    offset += bytes;
+    return start;
+  };
+  layout.lineBoxes = take(blocks.size() * 4 * sizeof(float));
+  layout.lineConfidences = take(blocks.size() * sizeof(float));
+  layout.wordBoxes = take(words * 4 * sizeof(float));
+  layout.wordConfidences = take(words * sizeof(float));
+  layout.lineText = take(blocks.size() * 2 * sizeof(uint32_t));
+  layout.lineWords = take(blocks.size() * 2 * sizeof(uint32_t));
+  layout.wordText = take(words * 2 * sizeof(uint32_t));
+  layout.text = take(layout.textBytes);
+  layout.byteLength = offset;
+  return layout;
+}
+
+void WriteOcrCompactLayout(const std::vector<OcrBlock>& blocks, const OcrCompactLayout& layout, uint8_t* out) {
+  uint32_t text = 0;
+  const auto appendText = [&](const std::string& value, size_t offset, size_t index) {
+    Store(out, offset, index * 2, text);
+    Store(out, offset, index * 2 + 1, static_cast<uint32_t>(value.size()));
+    std::memcpy(out + layout.text + text, value.data(), value.size());
+    text += static_cast<uint32_t>(value.size());
+  };
+
+  uint32_t firstWord = 0;
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    const OcrBlock& block = blocks[i];
+    if (block.hasBoundingBox) {
+      StoreBox(out, layout.lineBoxes, i, block.boundingBox);
+    } else {
+      StoreBox(out, layout.lineBoxes, i, {kMissing, kMissing, kMissing, kMissing});
+    }
+    Store(out, layout.lineConfidences, i, block.hasConfidence ? static_cast<float>(block.confidence) : kMissing);
+    appendText(block.text, layout.lineText, i);
+    Store(out, layout.lineWords, i * 2, firstWord);
+    Store(out, layout.lineWords, i * 2 + 1, static_cast<uint32_t>(block.words.size()));
+    firstWord += static_cast<uint32_t>(block.words.size());
+  }
+
+  size_t index = 0;
+  for (const OcrBlock& block : blocks) {
+    for (const OcrWord& word : block.words) {
+      StoreBox(out, layout.wordBoxes, index, word.boundingBox);
+      Store(out, layout.wordConfidences, index, word.hasConfidence ? static_cast<float>(word.confidence) : kMissing);
+      appendText(word.text, layout.wordText, index);
+      ++index;
+    }
+  }
+}
+
+} // namespace tuff::native
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "common/ocr_types.h"
+
+namespace tuff::native {
+
+// Where each array of a compact layout lies in its one buffer, as byte
+// offsets. Per line: a box (x, y, width, height) and a confidence as
+// float32, NaN where the engine gave none; the [offset, length] of its text
+// and the [first, count] of its words as uint32. Per word: the same, less
+// the word range. All text is UTF-8 at the end, lines first, then words.
+// Offsets are 4-byte aligned, so every array can be viewed in place.
+struct OcrCompactLayout {
+  uint32_t lines = 0;
+  uint32_t words = 0;
+  size_t lineBoxes = 0;
+  size_t lineConfidences = 0;
+  size_t wordBoxes = 0;
+  size_t wordConfidences = 0;
+  size_t lineText = 0;
+  size_t lineWords = 0;
+  size_t wordText = 0;
+  size_t text = 0;
+  size_t textBytes = 0;
+  size_t byteLength = 0;
+};
+
+OcrCompactLayout PlanOcrCompactLayout(const std::vector<OcrBlock>& blocks);
+
+// Writes `blocks` into `out`, which holds layout.byteLength bytes and is
+// aligned for float.
+void WriteOcrCompactLayout(const std::vector<OcrBlock>& blocks, const OcrCompactLayout& layout, uint8_t* out);
+
+} // namespace tuff::native
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "common/native_metrics.h"
+
+namespace tuff::native {
+
+// Stages of an OCR call timed by getNativeMetrics(), in the order they run.
+enum OcrStage : uint32_t {
+  // Submit to a pool thread picking the job up.
+  kOcrStageQueueWait,
+  // OcrTask::prepare: mapping the file, decoding a data URL.
+  kOcrStagePrepare,
+  kOcrStageCacheLookup,
+  kOcrStagePreprocess,
+  kOcrStageTextDetection,
+  kOcrStageEngineCreate,
+  // One engine call: the whole image, or one tile or changed region.
+  kOcrStageRecognize,
+  // Joining tiles, or splicing changed regions into the previous frame.
+  kOcrStageTileMerge,
+  // Building the JS result on the JS thread.
+  kOcrStageMarshal,
+  // Submit to the result being handed to the JS thread.
+  kOcrStageTotal,
+  kOcrStageCount,
+};
+
+// Finished jobs by outcome; a job answered from the result cache counts as
+// cached rather than succeeded.
+enum OcrCounter : uint32_t {
+  kOcrCounterSucceeded,
+  kOcrCounterFailed,
+  kOcrCounterCancelled,
+  kOcrCounterCached,
+  kOcrCounterCount,
+};
+
+// The process-wide metrics of the OCR addon, shared by every environment
+// that loads it.
+inline NativeMetrics& OcrMetrics() {
+  static const char* const kStages[kOcrStageCount] = {
+      "queueWait", "prepare", "cacheLookup", "preprocess", "textDetection",
+      "engineCreate", "recognize", "tileMerge", "marshal", "total"};
+  static const char* const kCounters[kOcrCounterCount] = {"succeeded", "failed", "cancelled", "cached"};
+  static NativeMetrics metrics(kStages, kOcrStageCount, kCounters, kOcrCounterCount);
+  return metrics;
+}
+
+} // namespace tuff::native
@@ -0,0 +1,692 @@
+#include "common/ocr_result_cache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+#include "common/image_preprocess.h"
+#include "common/utf_transcode.h"
+
+namespace tuff::native {
+
+namespace {
+
+// List node, map node and the result's own allocations, roughly.
+constexpr size_t kEntryOverheadBytes = 256;
+constexpr size_t kBlockOverheadBytes = 64;
+
+constexpr uint32_t kPerceptualColumns = 33;
+constexpr uint32_t kPerceptualRows = 32;
+
+constexpr char kDiskMagic[4] = {'T', 'O', 'C', 'R'};
+// 2 added word boxes.
+constexpr uint32_t kDiskVersion = 2;
+constexpr const char* kDiskExtension = ".ocr";
+
+// The XXH64 algorithm, streamed, so raw pixels can be hashed row by row
+// without their stride padding.
+class ContentHasher {
+ public:
+  explicit ContentHasher(uint64_t seed = 0)
+      : lanes_{seed + kPrime1 + kPrime2, seed + kPrime2, seed, seed - kPrime1}, seed_(seed) {}
+
+  void Update(const uint8_t* data, size_t size) {
+    total_ += size;
+    if (buffered_ > 0) {
+      const size_t take = std::min(size, sizeof(buffer_) - buffered_);
+      std::memcpy(buffer_ + buffered_, data, take);
+      buffered_ += take;
+      data += take;
+      size -= take;
+      if (buffered_ < sizeof(buffer_)) {
+        return;
+      }
+      Consume(buffer_);
+      buffered_ = 0;
+    }
+    for (; size >= sizeof(buffer_); data += sizeof(buffer_), size -= sizeof(buffer_)) {
+      Consume(data);
+    }
+    std::memcpy(buffer_, data, size);
+    buffered_ = size;
+  }
+
+  uint64_t Digest() const {
+    uint64_t hash;
+    if (total_ >= sizeof(buffer_)) {
+      hash = Rotate(lanes_[0], 1) + Rotate(lanes_[1], 7) + Rotate(lanes_[2], 12) + Rotate(lanes_[3], 18);
+      for (uint64_t lane : lanes_) {
+        hash = (hash ^ Round(0, lane)) * kPrime1 + kPrime4;
+      }
+    } else {
+      hash = seed_ + kPrime5;
+    }
+    hash += total_;
+
+    size_t offset = 0;
+    for (; offset + 8 <= buffered_; offset += 8) {
+      hash ^= Round(0, Read64(buffer_ + offset));
+      hash = Rotate(hash, 27) * kPrime1 + kPrime4;
+    }
+    if (offset + 4 <= buffered_) {
+      uint32_t word;
+      std::memcpy(&word, buffer_ + offset, sizeof(word));
+      hash ^= word * kPrime1;
+      hash = Rotate(hash, 23) * kPrime2 + kPrime3;
+      offset += 4;
+    }
+    for (; offset < buffered_; ++offset) {
+      hash ^= buffer_[offset] * kPrime5;
+      hash = Rotate(hash, 11) * kPrime1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= kPrime2;
+    hash ^= hash >> 29;
+    hash *= kPrime3;
+    hash ^= hash >> 32;
+    return hash;
+  }
+
+ private:
+  static constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+  static constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+  static constexpr uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+  static constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+  static constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+
+  static uint64_t Rotate(uint64_t value, int bits) { return (value << bits) | (value >> (64 - bits)); }
+  static uint64_t Round(uint64_t lane, uint64_t input) {
+    return Rotate(lane + input * kPrime2, 31) * kPrime1;
+  }
+  static uint64_t Read64(const uint8_t* data) {
+    uint64_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+  }
+
+  void Consume(const uint8_t* block) {
+    for (size_t i = 0; i < 4; ++i) {
+      lanes_[i] = Round(lanes_[i], Read64(block + i * 8));
+    }
+  }
+
+  uint64_t lanes_[4];
+  uint64_t seed_;
+  uint64_t total_ = 0;
+  uint8_t buffer_[32];
+  size_t buffered_ = 0;
+};
+
+uint64_t Hash64(const std::string& value) {
+  ContentHasher hasher;
+  hasher.Update(reinterpret_cast<const uint8_t*>(value.data()), value.size());
+  return hasher.Digest();
+}
+
+template <typename T>
+void AppendPod(std::string& out, const T& value) {
+  char bytes[sizeof(T)];
+  std::memcpy(bytes, &value, sizeof(T));
+  out.append(bytes, sizeof(bytes));
+}
+
+void AppendString(std::string& out, const std::string& value) {
+  AppendPod(out, static_cast<uint32_t>(value.size()));
+  out.append(value);
+}
+
+class Reader {
+ public:
+  explicit Reader(const std::string& data) : data_(data) {}
+
+  template <typename T>
+  bool Pod(T& value) {
+    if (data_.size() - offset_ < sizeof(T)) {
+      return false;
+    }
+    std::memcpy(&value, data_.data() + offset_, sizeof(T));
+    offset_ += sizeof(T);
+    return true;
+  }
+
+  bool String(std::string& value) {
+    uint32_t size = 0;
+    if (!Pod(size) || data_.size() - offset_ < size) {
+      return false;
+    }
+    value.assign(data_, offset_, size);
+    offset_ += size;
+    return true;
+  }
+
+  bool done() const { return offset_ == data_.size(); }
+
+ private:
+  const std::string& data_;
+  size_t offset_ = 0;
+};
+
+std::string Serialize(const std::string& exact, const OcrResult& result) {
+  std::string out(kDiskMagic, sizeof(kDiskMagic));
+  AppendPod(out, kDiskVersion);
+  AppendString(out, exact);
+  AppendString(out, result.text);
+  AppendPod(out, static_cast<uint8_t>(result.hasConfidence));
+  AppendPod(out, result.confidence);
+  AppendString(out, result.language);
+  AppendString(out, result.engine);
+  AppendPod(out, static_cast<uint32_t>(result.blocks.size()));
+  for (const OcrBlock& block : result.blocks) {
+    AppendString(out, block.text);
+    AppendPod(out, static_cast<uint8_t>(block.hasConfidence));
+    AppendPod(out, block.confidence);
+    AppendPod(out, static_cast<uint8_t>(block.hasBoundingBox));
+    for (double value : block.boundingBox) {
+      AppendPod(out, value);
+    }
+    AppendPod(out, static_cast<uint32_t>(block.words.size()));
+    for (const OcrWord& word : block.words) {
+      AppendString(out, word.text);
+      AppendPod(out, static_cast<uint8_t>(word.hasConfidence));
+      AppendPod(out, word.confidence);
+      for (double value : word.boundingBox) {
+        AppendPod(out, value);
+      }
+    }
+  }
+  AppendPod(out, result.preprocess);
+  return out;
+}
+
+// Null unless `data` is a well-formed entry for `exact`.
+OcrResultCache::Result Deserialize(const std::string& data, const std::string& exact) {
+  if (data.size() < sizeof(kDiskMagic) || std::memcmp(data.data(), kDiskMagic, sizeof(kDiskMagic)) != 0) {
+    return nullptr;
+  }
+  const std::string body = data.substr(sizeof(kDiskMagic));
+  Reader reader(body);
+  uint32_t version = 0;
+  std::string key;
+  if (!reader.Pod(version) || version != kDiskVersion || !reader.String(key) || key != exact) {
+    return nullptr;
+  }
+
+  auto result = std::make_shared<OcrResult>();
+  uint8_t flag = 0;
+  uint32_t blocks = 0;
+  if (!reader.String(result->text) || !reader.Pod(flag) || !reader.Pod(result->confidence) ||
+      !reader.String(result->language) || !reader.String(result->engine) || !reader.Pod(blocks) ||
+      blocks > body.size()) {
+    return nullptr;
+  }
+  result->hasConfidence = flag != 0;
+  result->blocks.resize(blocks);
+  for (OcrBlock& block : result->blocks) {
+    uint8_t hasConfidence = 0;
+    uint8_t hasBoundingBox = 0;
+    if (!reader.String(block.text) || !reader.Pod(hasConfidence) || !reader.Pod(block.confidence) ||
+        !reader.Pod(hasBoundingBox)) {
+      return nullptr;
+    }
+    for (double& value : block.boundingBox) {
+      if (!reader.Pod(value)) {
+        return nullptr;
+      }
+    }
+    block.hasConfidence = hasConfidence != 0;
+    block.hasBoundingBox = hasBoundingBox != 0;
+    uint32_t words = 0;
+    if (!reader.Pod(words) || words > body.size()) {
+      return nullptr;
+    }
+    block.words.resize(words);
+    for (OcrWord& word : block.words) {
+      uint8_t wordHasConfidence = 0;
+      if (!reader.String(word.text) || !reader.Pod(wordHasConfidence) || !reader.Pod(word.confidence)) {
+        return nullptr;
+      }
+      for (double& value : word.boundingBox) {
+        if (!reader.Pod(value)) {
+          return nullptr;
+        }
+      }
+      word.hasConfidence = wordHasConfidence != 0;
+    }
+  }
+  if (!reader.Pod(result->preprocess) || !reader.done()) {
+    return nullptr;
+  }
+  return result;
+}
+
+size_t EstimateBytes(const OcrResultCacheKey& key, const OcrResult& result) {
+  size_t bytes = kEntryOverheadBytes + key.exact.size() + key.context.size() + result.text.size() +
+                 result.language.size() + result.engine.size();
+  for (const OcrBlock& block : result.blocks) {
+    bytes += sizeof(OcrBlock) + kBlockOverheadBytes + block.text.size();
+    for (const OcrWord& word : block.words) {
+      bytes += sizeof(OcrWord) + word.text.size();
+    }
+  }
+  return bytes;
+}
+
+uint32_t PerceptualDistance(const std::array<uint64_t, 16>& a, const std::array<uint64_t, 16>& b) {
+  uint32_t distance = 0;
+  for (size_t i = 0; i < a.size(); ++i) {
+    uint64_t bits = a[i] ^ b[i];
+    for (; bits != 0; bits &= bits - 1) {
+      ++distance;
+    }
+  }
+  return distance;
+}
+
+std::filesystem::path ToPath(const std::string& utf8) {
+#if defined(_WIN32)
+  return std::filesystem::path(Utf8ToWide(utf8));
+#else
+  return std::filesystem::path(utf8);
+#endif
+}
+
+std::filesystem::path DiskPath(const std::string& directory, const std::string& exact) {
+  static const char kHex[] = "0123456789abcdef";
+  const uint64_t hash = Hash64(exact);
+  std::string name(16, '0');
+  for (int i = 0; i < 16; ++i) {
+    name[15 - i] = kHex[(hash >> (i * 4)) & 0xf];
+  }
+  return ToPath(directory) / (name + kDiskExtension);
+}
+
+struct DiskFile {
+  std::filesystem::path path;
+  std::filesystem::file_time_type written;
+  uintmax_t size = 0;
+};
+
+std::vector<DiskFile> ListDiskFiles(const std::string& directory) {
+  std::vector<DiskFile> files;
+  std::error_code error;
+  for (std::filesystem::directory_iterator it(ToPath(directory), error), end; !error && it != end;
+       it.increment(error)) {
+    if (it->path().extension() != kDiskExtension) {
+      continue;
+    }
+    std::error_code fileError;
+    DiskFile file{it->path(), it->last_write_time(fileError), it->file_size(fileError)};
+    if (!fileError) {
+      files.push_back(std::move(file));
+    }
+  }
+  return files;
+}
+
+size_t TotalSize(const std::vector<DiskFile>& files) {
+  size_t total = 0;
+  for (const DiskFile& file : files) {
+    total += static_cast<size_t>(file.size);
+  }
+  return total;
+}
+
+} // namespace
+
+OcrResultCache& OcrResultCache::Instance() {
+  // Leaked like the engine pools, whose threads use it until process exit.
+  static auto* cache = new OcrResultCache();
+  return *cache;
+}
+
+void OcrResultCache::MakeKey(const OcrOptions& options, const std::string& language, OcrResultCacheKey& key) {
+  const OcrPreprocessOptions& steps = options.preprocess;
+  key.context.clear();
+  AppendString(key.context, language);
+  AppendPod(key.context, static_cast<uint8_t>(options.includeLayout));
+  AppendPod(key.context, static_cast<uint8_t>(options.includeWords));
+  AppendPod(key.context, static_cast<int32_t>(options.maxBlocks));
+  AppendPod(key.context, steps.cropX);
+  AppendPod(key.context, steps.cropY);
+  AppendPod(key.context, steps.cropWidth);
+  AppendPod(key.context, steps.cropHeight);
+  AppendPod(key.context, steps.targetTextHeight);
+  AppendPod(key.context, steps.textHeightHint);
+  AppendPod(key.context, steps.binarizeWindow);
+  AppendPod(key.context, steps.binarizeThreshold);
+  AppendPod(key.context, steps.maxSkewDegrees);
+  AppendPod(key.context, static_cast<uint8_t>((steps.grayscale ? 1 : 0) | (steps.binarize ? 2 : 0) |
+                                              (steps.deskew ? 4 : 0)));
+  AppendPod(key.context, options.tiling.tileSize);
+  AppendPod(key.context, options.tiling.overlap);
+
+  const OcrImage& image = options.image;
+  ContentHasher hasher;
+  if (image.format == OcrPixelFormat::kEncoded) {
+    hasher.Update(image.data, image.size);
+  } else {
+    const size_t rowBytes = static_cast<size_t>(image.width) * (image.format == OcrPixelFormat::kGray8 ? 1 : 4);
+    for (uint32_t y = 0; y < image.height; ++y) {
+      hasher.Update(image.data + static_cast<size_t>(y) * image.stride, rowBytes);
+    }
+  }
+
+  key.width = image.width;
+  key.height = image.height;
+  key.exact = key.context;
+  AppendPod(key.exact, static_cast<uint8_t>(image.format));
+  AppendPod(key.exact, image.width);
+  AppendPod(key.exact, image.height);
+  // Stride padding is not part of the image; raw pixels are hashed without it.
+  AppendPod(key.exact, static_cast<uint64_t>(image.format == OcrPixelFormat::kEncoded ? image.size : 0));
+  AppendPod(key.exact, hasher.Digest());
+}
+
+void OcrResultCache::AddPerceptualHash(const OcrImage& pixels, OcrResultCacheKey& key) {
+  std::array<uint64_t, kPerceptualColumns * kPerceptualRows> sums{};
+  std::array<uint32_t, kPerceptualColumns * kPerceptualRows> counts{};
+  std::vector<uint32_t> cellOfColumn(pixels.width);
+  for (uint32_t x = 0; x < pixels.width; ++x) {
+    cellOfColumn[x] = static_cast<uint32_t>(static_cast<uint64_t>(x) * kPerceptualColumns / pixels.width);
+  }
+
+  const bool gray = pixels.format == OcrPixelFormat::kGray8;
+  std::vector<uint8_t> luma(gray ? 0 : pixels.width);
+  for (uint32_t y = 0; y < pixels.height; ++y) {
+    const uint8_t* row = pixels.data + static_cast<size_t>(y) * pixels.stride;
+    if (!gray) {
+      ConvertBgraRowToGray(row, luma.data(), pixels.width);
+      row = luma.data();
+    }
+    const size_t cellRow =
+        static_cast<size_t>(static_cast<uint64_t>(y) * kPerceptualRows / pixels.height) * kPerceptualColumns;
+    for (uint32_t x = 0; x < pixels.width; ++x) {
+      sums[cellRow + cellOfColumn[x]] += row[x];
+      ++counts[cellRow + cellOfColumn[x]];
+    }
+  }
+
+  key.perceptual.fill(0);
+  size_t bit = 0;
+  for (uint32_t r = 0; r < kPerceptualRows; ++r) {
+    for (uint32_t c = 0; c + 1 < kPerceptualColumns; ++c, ++bit) {
+      const size_t cell = r * kPerceptualColumns + c;
+      // Compared as cross products so empty cells of tiny images are not
+      // divided by zero.
+      if (sums[cell] * std::max<uint32_t>(1, counts[cell + 1]) >
+          sums[cell + 1] * std::max<uint32_t>(1, counts[cell])) {
+        key.perceptual[bit / 64] |= uint64_t{1} << (bit % 64);
+      }
+    }
+  }
+  key.width = pixels.width;
+  key.height = pixels.height;
+  key.hasPerceptual = true;
+}
+
+OcrResultCache::Result OcrResultCache::Lookup(const OcrResultCacheKey& key) {
+  std::string directory;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!EnabledLocked()) {
+      return nullptr;
+    }
+    const auto found = index_.find(key.exact);
+    if (found != index_.end()) {
+      entries_.splice(entries_.begin(), entries_, found->second);
+      ++counters_.hits;
+      return found->second->result;
+    }
+    directory = config_.directory;
+  }
+
+  if (!directory.empty()) {
+    if (Result result = ReadDisk(directory, key.exact)) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++counters_.hits;
+      ++counters_.diskHits;
+      if (EnabledLocked()) {
+        InsertLocked(key, result);
+      }
+      return result;
+    }
+  }
+  return nullptr;
+}
+
+OcrResultCache::Result OcrResultCache::LookupPerceptual(const OcrResultCacheKey& key) {
+  if (!key.hasPerceptual) {
+    return nullptr;
+  }
+  // A scan rather than an index: matches within a distance have no key to
+  // look up, and the budget keeps the list to a few thousand entries.
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!EnabledLocked() || !config_.perceptual) {
+    return nullptr;
+  }
+  for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+    if (it->hasPerceptual && it->width == key.width && it->height == key.height && it->context == key.context &&
+        PerceptualDistance(it->perceptual, key.perceptual) <= config_.perceptualMaxDistance) {
+      entries_.splice(entries_.begin(), entries_, it);
+      ++counters_.hits;
+      ++counters_.perceptualHits;
+      return entries_.front().result;
+    }
+  }
+  return nullptr;
+}
+
+void OcrResultCache::CountMiss() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (EnabledLocked()) {
+    ++counters_.misses;
+  }
+}
+
+void OcrResultCache::Insert(const OcrResultCacheKey& key, const OcrResult& result) {
+  auto stored = std::make_shared<OcrResult>(result);
+  stored->durationMs = 0;
+  std::string directory;
+  size_t maxDiskBytes = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!EnabledLocked()) {
+      return;
+    }
+    InsertLocked(key, stored);
+    directory = config_.directory;
+    maxDiskBytes = config_.maxDiskBytes;
+  }
+  if (!directory.empty() && maxDiskBytes > 0) {
+    WriteDisk(directory, maxDiskBytes, key.exact, *stored);
+  }
+}
+
+void OcrResultCache::Clear() {
+  std::string directory;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    index_.clear();
+    bytes_ = 0;
+    directory = config_.directory;
+  }
+  if (directory.empty()) {
+    return;
+  }
+  for (const DiskFile& file : ListDiskFiles(directory)) {
+    std::error_code error;
+    std::filesystem::remove(file.path, error);
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  diskBytes_ = TotalSize(ListDiskFiles(directory));
+}
+
+void OcrResultCache::Configure(const OcrResultCacheConfig& config) {
+  // The directory is read outside the lock; lookups carry on meanwhile.
+  size_t diskBytes = 0;
+  if (!config.directory.empty()) {
+    std::error_code error;
+    std::filesystem::create_directories(ToPath(config.directory), error);
+    diskBytes = TotalSize(ListDiskFiles(config.directory));
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  config_ = config;
+  diskBytes_ = diskBytes;
+  if (!EnabledLocked()) {
+    entries_.clear();
+    index_.clear();
+    bytes_ = 0;
+    return;
+  }
+  TrimLocked(config_.maxBytes);
+}
+
+bool OcrResultCache::enabled() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return EnabledLocked();
+}
+
+bool OcrResultCache::perceptual() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return EnabledLocked() && config_.perceptual;
+}
+
+OcrResultCacheStats OcrResultCache::Stats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  OcrResultCacheStats stats = counters_;
+  stats.entries = entries_.size();
+  stats.bytes = bytes_;
+  stats.diskBytes = diskBytes_;
+  stats.config = config_;
+  return stats;
+}
+
+bool OcrResultCache::EnabledLocked() const {
+  return config_.maxBytes > 0;
+}
+
+void OcrResultCache::InsertLocked(const OcrResultCacheKey& key, Result result) {
+  const size_t bytes = EstimateBytes(key, *result);
+  // One huge result must not flush everything else out.
+  if (bytes > config_.maxBytes / 4) {
+    return;
+  }
+
+  const auto found = index_.find(key.exact);
+  if (found != index_.end()) {
+    EraseLocked(found->second);
+  }
+  TrimLocked(config_.maxBytes - bytes);
+
+  Entry entry;
+  entry.exact = key.exact;
+  entry.context = key.context;
+  entry.width = key.width;
+  entry.height = key.height;
+  entry.hasPerceptual = key.hasPerceptual;
+  entry.perceptual = key.perceptual;
+  entry.result = std::move(result);
+  entry.bytes = bytes;
+  entries_.push_front(std::move(entry));
+  index_.emplace(key.exact, entries_.begin());
+  bytes_ += bytes;
+  ++counters_.insertions;
+}
+
+void OcrResultCache::EraseLocked(EntryList::iterator it) {
+  bytes_ -= it->bytes;
+  index_.erase(it->exact);
+  entries_.erase(it);
+}
+
+void OcrResultCache::TrimLocked(size_t maxBytes) {
+  while (bytes_ > maxBytes && !entries_.empty()) {
+    EraseLocked(std::prev(entries_.end()));
+    ++counters_.evictions;
+  }
+}
+
+OcrResultCache::Result OcrResultCache::ReadDisk(const std::string& directory, const std::string& exact) {
+  const auto path = DiskPath(directory, exact);
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return nullptr;
+  }
+  const std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  file.close();
+  Result result = Deserialize(data, exact);
+  std::error_code error;
+  if (result) {
+    // Disk eviction goes by write time; a hit counts as a use.
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+  }
+  return result;
+}
+
+void OcrResultCache::WriteDisk(const std::string& directory, size_t maxDiskBytes, const std::string& exact,
+                               const OcrResult& result) {
+  static std::atomic<uint64_t> nextTemporary{0};
+  const std::string data = Serialize(exact, result);
+  const auto path = DiskPath(directory, exact);
+  auto temporary = path;
+  temporary += "." + std::to_string(nextTemporary.fetch_add(1)) + ".tmp";
+
+  std::error_code error;
+  const uintmax_t replaced = std::filesystem::exists(path, error) ? std::filesystem::file_size(path, error) : 0;
+  {
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    if (!file || !file.write(data.data(), static_cast<std::streamsize>(data.size()))) {
+      file.close();
+      std::filesystem::remove(temporary, error);
+      return;
+    }
+  }
+  // Readers see the old file or the new one, never half of one.
+  std::filesystem::rename(temporary, path, error);
+  if (error) {
+    std::filesystem::remove(temporary, error);
+    return;
+  }
+
+  bool trim = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    diskBytes_ = diskBytes_ + data.size() - std::min<size_t>(diskBytes_, static_cast<size_t>(replaced));
+    trim = diskBytes_ > maxDiskBytes;
+  }
+  if (!trim) {
+    return;
+  }
+
+  // Down to three quarters, oldest first, so the next few writes do not
+  // each list the directory again.
+  std::vector<DiskFile> files = ListDiskFiles(directory);
+  std::sort(files.begin(), files.end(),
+            [](const DiskFile& a, const DiskFile& b) { return a.written < b.written; });
+  size_t total = TotalSize(files);
+  for (const DiskFile& file : files) {
+    if (total <= maxDiskBytes / 4 * 3) {
+      break;
+    }
+    if (std::filesystem::remove(file.path, error)) {
+      total -= static_cast<size_t>(file.size);
+    }
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  diskBytes_ = total;
+}
+
+} // namespace tuff::native
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "common/ocr_types.h"
+
+namespace tuff::native {
+
+struct OcrResultCacheConfig {
+  // Budget for cached results in memory. 0 disables the cache.
+  size_t maxBytes = 8 * 1024 * 1024;
+  // Also match images whose pixels look the same (a screenshot copied
+  // twice, a PNG re-encoded) when the bytes differ. Encoded images are then
+  // decoded before recognition rather than by the engine. Off unless asked
+  // for: a hash match can hand back text the image does not contain, and
+  // decoding up front costs every miss.
+  bool perceptual = false;
+  // Differing bits allowed between perceptual hashes, out of 1024. 0 asks
+  // for the same hash, which re-encoding leaves alone but a changed word
+  // usually does not.
+  uint32_t perceptualMaxDistance = 0;
+  // Results are also written here and read back after a restart. Empty
+  // keeps the cache in memory only.
+  std::string directory;
+  size_t maxDiskBytes = 64 * 1024 * 1024;
+};
+
+struct OcrResultCacheStats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  // Of the hits, those found by perceptual hash and those read from disk.
+  uint64_t perceptualHits = 0;
+  uint64_t diskHits = 0;
+  uint64_t insertions = 0;
+  uint64_t evictions = 0;
+  size_t entries = 0;
+  size_t bytes = 0;
+  size_t diskBytes = 0;
+  OcrResultCacheConfig config;
+};
+
+// What a recognition is cached under. `exact` covers the image bytes and
+// every option that changes the result; `context` is the options part alone,
+// which perceptual matches must share.
+struct OcrResultCacheKey {
+  std::string exact;
+  std::string context;
+  uint32_t width = 0;
+  uint32_t height = 0;
+  bool hasPerceptual = false;
+  // Difference hash: whether each cell of a 33 x 32 grid of mean luma is
+  // brighter than its right-hand neighbour.
+  std::array<uint64_t, 16> perceptual{};
+};
+
+// Process-wide cache of recognition results, so clipboard history and
+// repeated screenshots do not pay for the same recognition twice. Memory is
+// an LRU bounded by the size of the results; the optional disk store keeps
+// exact matches across restarts, oldest files dropped first.
+class OcrResultCache {
+ public:
+  using Result = std::shared_ptr<const OcrResult>;
+
+  static OcrResultCache& Instance();
+
+  // Fills key.exact and key.context. `language` is the pool's resolved
+  // language, so hints that share an engine share entries. Needs the image
+  // loaded.
+  static void MakeKey(const OcrOptions& options, const std::string& language, OcrResultCacheKey& key);
+
+  // Adds the perceptual hash of `pixels`, which must be raw pixels.
+  static void AddPerceptualHash(const OcrImage& pixels, OcrResultCacheKey& key);
+
+  // Null on a miss. Looks for the exact key in memory, then on disk. Counts
+  // hits only; the caller counts a miss once it has tried everything.
+  Result Lookup(const OcrResultCacheKey& key);
+  // Looks for an entry whose perceptual hash is close enough to the key's.
+  Result LookupPerceptual(const OcrResultCacheKey& key);
+  void CountMiss();
+
+  void Insert(const OcrResultCacheKey& key, const OcrResult& result);
+
+  // Drops every entry, in memory and on disk.
+  void Clear();
+
+  // Applies the new budgets immediately, evicting as needed.
+  void Configure(const OcrResultCacheConfig& config);
+
+  bool enabled() const;
+  bool perceptual() const;
+
+  OcrResultCacheStats Stats();
+
+ private:
+  struct Entry {
+    std::string exact;
+    std::string context;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    bool hasPerceptual = false;
+    std::array<uint64_t, 16> perceptual{};
+    Result result;
+    size_t bytes = 0;
+  };
+  using EntryList = std::list<Entry>;
+
+  OcrResultCache() = default;
+
+  bool EnabledLocked() const;
+  void InsertLocked(const OcrResultCacheKey& key, Result result);
+  void EraseLocked(EntryList::iterator it);
+  void TrimLocked(size_t maxBytes);
+
+  Result ReadDisk(const std::string& directory, const std::string& exact);
+  void WriteDisk(const std::string& directory, size_t maxDiskBytes, const std::string& exact,
+                 const OcrResult& result);
+
+  mutable std::mutex mutex_;
+  OcrResultCacheConfig config_;
+  // Most recently used first.
+  EntryList entries_;
+  std::unordered_map<std::string, EntryList::iterator> index_;
+  size_t bytes_ = 0;
+  size_t diskBytes_ = 0;
+  OcrResultCacheStats counters_;
+};
+
+} // namespace tuff::native
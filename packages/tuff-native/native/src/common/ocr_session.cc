@@ -0,0 +1,335 @@
+#include "common/ocr_session.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+#include "common/image_preprocess.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TUFF_SESSION_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define TUFF_SESSION_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace tuff::native {
+
+namespace {
+
+// A region in pixels, right and bottom exclusive.
+struct Rect {
+  uint32_t left;
+  uint32_t top;
+  uint32_t right;
+  uint32_t bottom;
+
+  bool Overlaps(const Rect& other) const {
+    return left < other.right && other.left < right && top < other.bottom && other.top < bottom;
+  }
+  bool Contains(const Rect& other) const {
+    return left <= other.left && top <= other.top && right >= other.right && bottom >= other.bottom;
+  }
+  void Add(const Rect& other) {
+    left = std::min(left, other.left);
+    top = std::min(top, other.top);
+    right = std::max(right, other.right);
+    bottom = std::max(bottom, other.bottom);
+  }
+  uint64_t Area() const { return static_cast<uint64_t>(right - left) * (bottom - top); }
+};
+
+// The block's box grown by `pad` on every side and clipped to the frame.
+Rect BoxOf(const OcrBlock& block, double pad, uint32_t width, uint32_t height) {
+  const auto& box = block.boundingBox;
+  const auto clip = [](double value, uint32_t limit) {
+    return static_cast<uint32_t>(std::clamp(value, 0.0, static_cast<double>(limit)));
+  };
+  return {clip(std::floor(box[0] - pad), width), clip(std::floor(box[1] - pad), height),
+          clip(std::ceil(box[0] + box[2] + pad), width), clip(std::ceil(box[1] + box[3] + pad), height)};
+}
+
+bool Intersects(const OcrBlock& block, const OcrTile& region) {
+  const auto& box = block.boundingBox;
+  return box[0] < region.x + region.width && box[0] + box[2] > region.x && box[1] < region.y + region.height &&
+         box[1] + box[3] > region.y;
+}
+
+} // namespace
+
+bool BytesDifferBeyond(const uint8_t* a, const uint8_t* b, size_t length, uint8_t tolerance) {
+  size_t i = 0;
+#if defined(TUFF_SESSION_SSE2)
+  // |a - b| from two saturating subtractions; what is left after taking off
+  // the tolerance is non-zero only where the difference exceeds it.
+  const __m128i allowed = _mm_set1_epi8(static_cast<char>(tolerance));
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 16 <= length; i += 16) {
+    const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    const __m128i difference = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+    const __m128i excess = _mm_subs_epu8(difference, allowed);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(excess, zero)) != 0xFFFF) {
+      return true;
+    }
+  }
+#elif defined(TUFF_SESSION_NEON)
+  for (; i + 16 <= length; i += 16) {
+    if (vmaxvq_u8(vabdq_u8(vld1q_u8(a + i), vld1q_u8(b + i))) > tolerance) {
+      return true;
+    }
+  }
+#endif
+  for (; i < length; ++i) {
+    if ((a[i] > b[i] ? a[i] - b[i] : b[i] - a[i]) > tolerance) {
+      return true;
+    }
+  }
+  return false;
+}
+
+OcrSession::OcrSession(OcrSessionOptions options) : options_(options) {
+  options_.blockSize = std::clamp<uint32_t>(options_.blockSize, 4, 256);
+}
+
+std::unique_lock<std::mutex> OcrSession::Lock() {
+  return std::unique_lock<std::mutex>(mutex_);
+}
+
+void OcrSession::Plan(const OcrImage& frame, const std::string& context, OcrSessionPlan& plan) {
+  plan = OcrSessionPlan();
+  if (reset_.exchange(false)) {
+    hasPrevious_ = false;
+  }
+  {
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    ++stats_.frames;
+  }
+  if (!hasPrevious_ || frame.format == OcrPixelFormat::kEncoded || frame.width != width_ ||
+      frame.height != height_ || context != context_) {
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    ++stats_.fullFrames;
+    return;
+  }
+
+  // Marks each square of the grid where the frame differs from the last one,
+  // a row at a time; squares already marked are not compared again.
+  const uint32_t size = options_.blockSize;
+  const uint32_t columns = (width_ + size - 1) / size;
+  const uint32_t rows = (height_ + size - 1) / size;
+  std::vector<char> dirty(static_cast<size_t>(columns) * rows, 0);
+  std::vector<uint8_t> converted(frame.format == OcrPixelFormat::kBgra8 ? width_ : 0);
+  size_t changed = 0;
+  for (uint32_t y = 0; y < height_; ++y) {
+    char* marks = dirty.data() + static_cast<size_t>(y / size) * columns;
+    if (std::count(marks, marks + columns, 1) == static_cast<std::ptrdiff_t>(columns)) {
+      continue;
+    }
+    const uint8_t* row = frame.data + static_cast<size_t>(y) * frame.stride;
+    if (frame.format == OcrPixelFormat::kBgra8) {
+      ConvertBgraRowToGray(row, converted.data(), width_);
+      row = converted.data();
+    }
+    const uint8_t* before = luma_.data() + static_cast<size_t>(y) * width_;
+    for (uint32_t column = 0; column < columns; ++column) {
+      const uint32_t x = column * size;
+      if (!marks[column] && BytesDifferBeyond(row + x, before + x, std::min(size, width_ - x), options_.tolerance)) {
+        marks[column] = 1;
+        ++changed;
+      }
+    }
+  }
+
+  plan.changedFraction = static_cast<double>(changed) / static_cast<double>(dirty.size());
+  if (changed == 0) {
+    plan.full = false;
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    ++stats_.unchangedFrames;
+    return;
+  }
+  if (plan.changedFraction > options_.maxChangedFraction) {
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    ++stats_.fullFrames;
+    return;
+  }
+
+  // Each group of touching squares becomes a rectangle, grown by half a
+  // square on every side for the engine to see some background.
+  std::vector<Rect> rects;
+  std::vector<uint32_t> stack;
+  for (uint32_t start = 0; start < dirty.size(); ++start) {
+    if (dirty[start] != 1) {
+      continue;
+    }
+    Rect cells{start % columns, start / columns, start % columns, start / columns};
+    dirty[start] = 2;
+    stack.push_back(start);
+    while (!stack.empty()) {
+      const uint32_t cell = stack.back();
+      stack.pop_back();
+      const uint32_t cx = cell % columns;
+      const uint32_t cy = cell / columns;
+      cells.Add({cx, cy, cx, cy});
+      for (uint32_t ny = cy > 0 ? cy - 1 : 0; ny <= std::min(cy + 1, rows - 1); ++ny) {
+        for (uint32_t nx = cx > 0 ? cx - 1 : 0; nx <= std::min(cx + 1, columns - 1); ++nx) {
+          const uint32_t next = ny * columns + nx;
+          if (dirty[next] == 1) {
+            dirty[next] = 2;
+            stack.push_back(next);
+          }
+        }
+      }
+    }
+    const uint32_t pad = size / 2;
+    rects.push_back({cells.left * size > pad ? cells.left * size - pad : 0,
+                     cells.top * size > pad ? cells.top * size - pad : 0,
+                     std::min(width_, (cells.right + 1) * size + pad), std::min(height_, (cells.bottom + 1) * size + pad)});
+  }
+
+  // A line a change touches is recognized again as a whole, so rectangles
+  // grow to cover the previous lines they cut into, with a quarter of the
+  // line height around them, and rectangles that then overlap are merged,
+  // until nothing moves.
+  bool grew = true;
+  while (grew) {
+    grew = false;
+    for (Rect& rect : rects) {
+      for (const OcrBlock& block : previous_.blocks) {
+        if (!block.hasBoundingBox || !BoxOf(block, 0.0, width_, height_).Overlaps(rect)) {
+          continue;
+        }
+        const Rect padded = BoxOf(block, block.boundingBox[3] / 4.0 + 2.0, width_, height_);
+        if (!rect.Contains(padded)) {
+          rect.Add(padded);
+          grew = true;
+        }
+      }
+    }
+    for (size_t i = 0; i < rects.size(); ++i) {
+      for (size_t j = i + 1; j < rects.size();) {
+        if (rects[i].Overlaps(rects[j])) {
+          rects[i].Add(rects[j]);
+          rects.erase(rects.begin() + static_cast<std::ptrdiff_t>(j));
+          grew = true;
+        } else {
+          ++j;
+        }
+      }
+    }
+  }
+
+  uint64_t area = 0;
+  for (const Rect& rect : rects) {
+    area += rect.Area();
+  }
+  if (static_cast<double>(area) > options_.maxChangedFraction * static_cast<double>(width_) * height_) {
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    ++stats_.fullFrames;
+    return;
+  }
+
+  plan.full = false;
+  for (const Rect& rect : rects) {
+    plan.regions.push_back({rect.left, rect.top, rect.right - rect.left, rect.bottom - rect.top});
+  }
+  std::lock_guard<std::mutex> lock(statsMutex_);
+  ++stats_.incrementalFrames;
+  stats_.regions += plan.regions.size();
+}
+
+bool OcrSession::Splice(const OcrSessionPlan& plan,
+                        std::vector<OcrResult>& results,
+                        const std::vector<OcrError>& errors,
+                        const std::vector<char>& succeeded,
+                        OcrResult& result,
+                        OcrError& error) {
+  result.engine = previous_.engine;
+  result.language = previous_.language;
+  result.blocks.clear();
+  for (const OcrBlock& block : previous_.blocks) {
+    const bool touched = block.hasBoundingBox &&
+                         std::any_of(plan.regions.begin(), plan.regions.end(),
+                                     [&block](const OcrTile& region) { return Intersects(block, region); });
+    if (!touched) {
+      result.blocks.push_back(block);
+    }
+  }
+  const size_t reused = result.blocks.size();
+
+  OcrResult recognized;
+  OcrError ignored;
+  if (MergeOcrTiles(plan.regions, results, errors, succeeded, recognized, ignored)) {
+    for (OcrBlock& block : recognized.blocks) {
+      result.blocks.push_back(std::move(block));
+    }
+    if (!recognized.engine.empty()) {
+      result.engine = recognized.engine;
+    }
+  }
+  SortOcrBlocksInReadingOrder(result.blocks);
+
+  result.text.clear();
+  double confidence = 0.0;
+  double weight = 0.0;
+  for (const OcrBlock& block : result.blocks) {
+    if (!result.text.empty()) {
+      result.text += '\n';
+    }
+    result.text += block.text;
+    if (block.hasConfidence) {
+      confidence += block.confidence * static_cast<double>(block.text.size());
+      weight += static_cast<double>(block.text.size());
+    }
+  }
+  result.hasConfidence = weight > 0.0 || previous_.hasConfidence;
+  result.confidence = weight > 0.0 ? confidence / weight : previous_.confidence;
+
+  result.incremental.reusedBlocks = static_cast<uint32_t>(reused);
+  {
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    stats_.reusedBlocks += reused;
+  }
+  if (result.text.empty()) {
+    error.code = "ERR_OCR_RECOGNIZE_FAILED";
+    error.message = "OCR recognized no text in the image";
+    return false;
+  }
+  return true;
+}
+
+void OcrSession::Commit(const OcrImage& frame, const std::string& context, const OcrResult& result) {
+  hasPrevious_ = false;
+  if (frame.format == OcrPixelFormat::kEncoded || frame.empty()) {
+    return;
+  }
+  width_ = frame.width;
+  height_ = frame.height;
+  context_ = context;
+  luma_.resize(static_cast<size_t>(width_) * height_);
+  for (uint32_t y = 0; y < height_; ++y) {
+    const uint8_t* row = frame.data + static_cast<size_t>(y) * frame.stride;
+    uint8_t* out = luma_.data() + static_cast<size_t>(y) * width_;
+    if (frame.format == OcrPixelFormat::kBgra8) {
+      ConvertBgraRowToGray(row, out, width_);
+    } else {
+      std::memcpy(out, row, width_);
+    }
+  }
+  previous_ = result;
+  previous_.incremental = OcrIncrementalReport();
+  previous_.preprocess = OcrPreprocessReport();
+  hasPrevious_ = true;
+}
+
+void OcrSession::Reset() {
+  reset_.store(true);
+}
+
+OcrSessionStats OcrSession::Stats() {
+  std::lock_guard<std::mutex> lock(statsMutex_);
+  return stats_;
+}
+
+} // namespace tuff::native
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "common/ocr_tiling.h"
+#include "common/ocr_types.h"
+
+namespace tuff::native {
+
+struct OcrSessionOptions {
+  // Frames are compared in squares of this many pixels; a square is changed
+  // when any pixel in it moved by more than `tolerance` levels of luma.
+  uint32_t blockSize = 16;
+  uint8_t tolerance = 8;
+  // Past this share of the frame changed, the whole frame is recognized
+  // again, which is then cheaper than the regions one by one.
+  double maxChangedFraction = 0.5;
+};
+
+struct OcrSessionStats {
+  uint64_t frames = 0;
+  // Frames recognized whole, identical to the previous one, or recognized
+  // region by region.
+  uint64_t fullFrames = 0;
+  uint64_t unchangedFrames = 0;
+  uint64_t incrementalFrames = 0;
+  uint64_t regions = 0;
+  // Lines carried over from the previous frame rather than recognized.
+  uint64_t reusedBlocks = 0;
+};
+
+// What to recognize of a frame: everything, or only `regions`.
+struct OcrSessionPlan {
+  bool full = true;
+  std::vector<OcrTile> regions;
+  // Share of the frame's diff blocks that changed.
+  double changedFraction = 1.0;
+};
+
+// Remembers the last frame a caller recognized, in luma, and its result, so
+// that the next frame only has its changed regions recognized. Lines of the
+// previous result away from every change are kept as they were; those a
+// change touches are recognized again with it. Frames are expected one at a
+// time: the pool holds Lock() for a whole frame.
+class OcrSession {
+ public:
+  explicit OcrSession(OcrSessionOptions options = {});
+
+  std::unique_lock<std::mutex> Lock();
+
+  // Compares `frame` (raw pixels) with the previous frame. A frame of
+  // another size or `context` (the engine language) is recognized whole.
+  void Plan(const OcrImage& frame, const std::string& context, OcrSessionPlan& plan);
+
+  // The previous result with the lines `plan.regions` cover replaced by
+  // those recognized there, given per region as for MergeOcrTiles. Regions
+  // that failed count as empty: the text there went away.
+  bool Splice(const OcrSessionPlan& plan,
+              std::vector<OcrResult>& results,
+              const std::vector<OcrError>& errors,
+              const std::vector<char>& succeeded,
+              OcrResult& result,
+              OcrError& error);
+
+  // The previous result, for a frame that did not change.
+  const OcrResult& previous() const { return previous_; }
+
+  // Keeps `frame` and its result, with blocks in frame coordinates, for the
+  // next frame to be compared with.
+  void Commit(const OcrImage& frame, const std::string& context, const OcrResult& result);
+
+  // Forgets the previous frame; the next one is recognized whole. Does not
+  // wait for a frame in progress.
+  void Reset();
+
+  OcrSessionStats Stats();
+
+ private:
+  OcrSessionOptions options_;
+  std::mutex mutex_;
+  std::atomic<bool> reset_{false};
+  std::string context_;
+  uint32_t width_ = 0;
+  uint32_t height_ = 0;
+  std::vector<uint8_t> luma_;
+  bool hasPrevious_ = false;
+  OcrResult previous_;
+  // Guarded by statsMutex_ so Stats() does not wait for a frame.
+  std::mutex statsMutex_;
+  OcrSessionStats stats_;
+};
+
+// True when the first `length` bytes of `a` and `b` differ anywhere by more
+// than `tolerance`.
+bool BytesDifferBeyond(const uint8_t* a, const uint8_t* b, size_t length, uint8_t tolerance);
+
+} // namespace tuff::native
@@ -0,0 +1,398 @@
+#include "common/ocr_tiling.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <string>
+#include <utility>
+
+namespace tuff::native {
+
+namespace {
+
+struct Span {
+  uint32_t start;
+  uint32_t length;
+};
+
+// Fewest spans of at most `tileSize` that cover `size` with `overlap` shared
+// between neighbours, all the same length and evenly spaced.
+std::vector<Span> PlanAxis(uint32_t size, uint32_t tileSize, uint32_t overlap) {
+  if (size <= tileSize) {
+    return {{0, size}};
+  }
+  const uint32_t step = tileSize - overlap;
+  const uint32_t count = (size - overlap + step - 1) / step;
+  const uint32_t length = static_cast<uint32_t>(
+      std::min<uint64_t>(tileSize, (static_cast<uint64_t>(size) + static_cast<uint64_t>(count - 1) * overlap + count - 1) / count));
+  std::vector<Span> spans;
+  spans.reserve(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    const uint64_t start = static_cast<uint64_t>(size - length) * i / (count - 1);
+    spans.push_back({static_cast<uint32_t>(start), length});
+  }
+  return spans;
+}
+
+// Byte offset of each code point in `text`, plus one for the end.
+std::vector<size_t> CodePoints(const std::string& text) {
+  std::vector<size_t> offsets;
+  offsets.reserve(text.size() + 1);
+  for (size_t i = 0; i < text.size(); ++i) {
+    if ((static_cast<unsigned char>(text[i]) & 0xC0) != 0x80) {
+      offsets.push_back(i);
+    }
+  }
+  offsets.push_back(text.size());
+  return offsets;
+}
+
+bool IsSpace(char c) {
+  return c == ' ' || c == '\t';
+}
+
+// One recognized line in image coordinates.
+struct Piece {
+  OcrBlock block;
+  double left = 0.0;
+  double top = 0.0;
+  double right = 0.0;
+  double bottom = 0.0;
+  // Tiles the line was read from; a line is only joined with lines from
+  // other tiles.
+  std::vector<size_t> tiles;
+  // Whether the line runs into the inner left or right edge of its tile,
+  // where it may have been cut.
+  bool cutLeft = false;
+  bool cutRight = false;
+  bool alive = true;
+
+  double width() const { return right - left; }
+  double height() const { return bottom - top; }
+  double area() const { return width() * height(); }
+};
+
+bool ShareTile(const Piece& a, const Piece& b) {
+  for (size_t tile : a.tiles) {
+    if (std::find(b.tiles.begin(), b.tiles.end(), tile) != b.tiles.end()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool SameLine(const Piece& a, const Piece& b) {
+  const double shared = std::min(a.bottom, b.bottom) - std::max(a.top, b.top);
+  return shared >= 0.5 * std::min(a.height(), b.height());
+}
+
+// One of the two lies within the other on the same line, give or take half
+// a character: both tiles read the same text. The larger read wins, since
+// the smaller is usually the line clipped by its tile.
+bool Duplicates(const Piece& a, const Piece& b) {
+  if (!SameLine(a, b)) {
+    return false;
+  }
+  const double slack = 0.5 * std::min(a.height(), b.height());
+  const auto within = [slack](const Piece& inner, const Piece& outer) {
+    return inner.left >= outer.left - slack && inner.right <= outer.right + slack;
+  };
+  return within(a, b) || within(b, a);
+}
+
+bool Prefer(const Piece& a, const Piece& b) {
+  if (a.area() != b.area()) {
+    return a.area() > b.area();
+  }
+  if (a.block.text.size() != b.block.text.size()) {
+    return a.block.text.size() > b.block.text.size();
+  }
+  return a.block.confidence >= b.block.confidence;
+}
+
+// Joins the text of a line or word cut in two at a tile edge, `a` read from
+// one tile over [leftA, rightA) and `b` from the next over [leftB, rightB).
+// Both usually hold the characters in the overlap; the longest run that ends
+// one and starts the other is kept once. Failing that, the overlap is split
+// down the middle, placing characters by their share of each box.
+std::string JoinText(const std::string& a, double leftA, double rightA,
+                     const std::string& b, double leftB, double rightB) {
+  const double overlap = rightA - leftB;
+  if (overlap <= 0.0) {
+    return a + " " + b;
+  }
+
+  const std::vector<size_t> ca = CodePoints(a);
+  const std::vector<size_t> cb = CodePoints(b);
+  const size_t lengthA = ca.size() - 1;
+  const size_t lengthB = cb.size() - 1;
+  for (size_t k = std::min(lengthA, lengthB); k >= 2; --k) {
+    const size_t fromA = ca[lengthA - k];
+    const size_t bytes = cb[k];
+    if (a.size() - fromA == bytes && a.compare(fromA, bytes, b, 0, bytes) == 0) {
+      return a + b.substr(bytes);
+    }
+  }
+
+  const double seam = leftB + overlap / 2.0;
+  const auto at = [](double position, size_t length) {
+    return static_cast<size_t>(std::clamp(std::lround(position * static_cast<double>(length)), 0L,
+                                          static_cast<long>(length)));
+  };
+  std::string head = a.substr(0, ca[at((seam - leftA) / std::max(1.0, rightA - leftA), lengthA)]);
+  std::string tail = b.substr(cb[at((seam - leftB) / std::max(1.0, rightB - leftB), lengthB)]);
+  const bool space = (!head.empty() && IsSpace(head.back())) || (!tail.empty() && IsSpace(tail.front()));
+  while (!head.empty() && IsSpace(head.back())) {
+    head.pop_back();
+  }
+  const size_t begin = tail.find_first_not_of(" \t");
+  tail.erase(0, begin == std::string::npos ? tail.size() : begin);
+  if (head.empty() || tail.empty()) {
+    return head + tail;
+  }
+  return head + (space ? " " : "") + tail;
+}
+
+void Join(Piece& left, Piece& right) {
+  const double weightLeft = static_cast<double>(left.block.text.size());
+  const double weightRight = static_cast<double>(right.block.text.size());
+  if (left.block.hasConfidence && right.block.hasConfidence && weightLeft + weightRight > 0.0) {
+    left.block.confidence =
+        (left.block.confidence * weightLeft + right.block.confidence * weightRight) / (weightLeft + weightRight);
+  } else if (right.block.hasConfidence) {
+    left.block.confidence = right.block.confidence;
+    left.block.hasConfidence = true;
+  }
+  left.block.text = JoinText(left.block.text, left.left, left.right, right.block.text, right.left, right.right);
+  // Words in the overlap were read by both tiles, whole or in part. Of a
+  // pair that meets, a read that lies within the other gives way to it, and
+  // otherwise the two are joined like the line, so a word cut at the seam
+  // comes back once and whole.
+  const auto end = [](const OcrWord& word) { return word.boundingBox[0] + word.boundingBox[2]; };
+  auto& words = left.block.words;
+  const size_t leftWords = words.size();
+  for (OcrWord& word : right.block.words) {
+    OcrWord* seen = nullptr;
+    for (size_t i = leftWords; i-- > 0;) {
+      if (words[i].boundingBox[0] < end(word) && end(words[i]) > word.boundingBox[0]) {
+        seen = &words[i];
+        break;
+      }
+    }
+    if (seen == nullptr) {
+      words.push_back(std::move(word));
+      continue;
+    }
+    const double slack = 0.25 * std::min(seen->boundingBox[3], word.boundingBox[3]);
+    if (word.boundingBox[0] >= seen->boundingBox[0] - slack && end(word) <= end(*seen) + slack) {
+      continue;
+    }
+    if (seen->boundingBox[0] >= word.boundingBox[0] - slack && end(*seen) <= end(word) + slack) {
+      *seen = std::move(word);
+      continue;
+    }
+    seen->text = JoinText(seen->text, seen->boundingBox[0], end(*seen), word.text, word.boundingBox[0], end(word));
+    const double top = std::min(seen->boundingBox[1], word.boundingBox[1]);
+    const double bottom = std::max(seen->boundingBox[1] + seen->boundingBox[3], word.boundingBox[1] + word.boundingBox[3]);
+    const double x = std::min(seen->boundingBox[0], word.boundingBox[0]);
+    seen->boundingBox = {x, top, std::max(end(*seen), end(word)) - x, bottom - top};
+    if (seen->hasConfidence && word.hasConfidence) {
+      seen->confidence = std::min(seen->confidence, word.confidence);
+    }
+  }
+  std::stable_sort(words.begin(), words.end(),
+                   [](const OcrWord& a, const OcrWord& b) { return a.boundingBox[0] < b.boundingBox[0]; });
+  left.top = std::min(left.top, right.top);
+  left.bottom = std::max(left.bottom, right.bottom);
+  left.right = std::max(left.right, right.right);
+  left.cutRight = right.cutRight;
+  left.tiles.insert(left.tiles.end(), right.tiles.begin(), right.tiles.end());
+  right.alive = false;
+}
+
+// Drops duplicates, then joins cut lines until nothing changes; a line cut
+// by several tiles comes back one piece at a time.
+void MergePieces(std::vector<Piece>& pieces) {
+  for (size_t i = 0; i < pieces.size(); ++i) {
+    for (size_t j = i + 1; j < pieces.size() && pieces[i].alive; ++j) {
+      Piece& a = pieces[i];
+      Piece& b = pieces[j];
+      if (b.alive && !ShareTile(a, b) && Duplicates(a, b)) {
+        (Prefer(a, b) ? b : a).alive = false;
+      }
+    }
+  }
+
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (size_t i = 0; i < pieces.size(); ++i) {
+      for (size_t j = 0; j < pieces.size(); ++j) {
+        Piece& a = pieces[i];
+        Piece& b = pieces[j];
+        if (i == j || !a.alive || !b.alive || a.left > b.left || ShareTile(a, b) || !SameLine(a, b)) {
+          continue;
+        }
+        const double gap = b.left - a.right;
+        if ((a.cutRight || b.cutLeft) && gap <= 0.5 * std::max(a.height(), b.height())) {
+          Join(a, b);
+          changed = true;
+        }
+      }
+    }
+  }
+}
+
+} // namespace
+
+std::vector<OcrTile> PlanOcrTiles(uint32_t width, uint32_t height, uint32_t tileSize, uint32_t overlap) {
+  std::vector<OcrTile> tiles;
+  if (width == 0 || height == 0 || tileSize == 0) {
+    return tiles;
+  }
+  overlap = std::min(overlap, (tileSize - 1) / 2);
+  const std::vector<Span> columns = PlanAxis(width, tileSize, overlap);
+  const std::vector<Span> rows = PlanAxis(height, tileSize, overlap);
+  tiles.reserve(columns.size() * rows.size());
+  for (const Span& row : rows) {
+    for (const Span& column : columns) {
+      tiles.push_back({column.start, row.start, column.length, row.length});
+    }
+  }
+  return tiles;
+}
+
+void SortOcrBlocksInReadingOrder(std::vector<OcrBlock>& blocks) {
+  const auto top = [](const OcrBlock& block) { return block.boundingBox[1]; };
+  const auto bottom = [](const OcrBlock& block) { return block.boundingBox[1] + block.boundingBox[3]; };
+  const auto byLeft = [](const OcrBlock& a, const OcrBlock& b) { return a.boundingBox[0] < b.boundingBox[0]; };
+  const auto placed = std::stable_partition(blocks.begin(), blocks.end(),
+                                            [](const OcrBlock& block) { return block.hasBoundingBox; });
+
+  // Lines top to bottom, grouping blocks whose middles fall within the band
+  // of the line above, then left to right.
+  std::stable_sort(blocks.begin(), placed, [&top](const OcrBlock& a, const OcrBlock& b) { return top(a) < top(b); });
+  auto lineStart = blocks.begin();
+  double lineBottom = 0.0;
+  for (auto it = blocks.begin(); it != placed; ++it) {
+    const double middle = (top(*it) + bottom(*it)) / 2.0;
+    if (it != lineStart && middle > lineBottom) {
+      std::stable_sort(lineStart, it, byLeft);
+      lineStart = it;
+    }
+    lineBottom = it == lineStart ? bottom(*it) : std::max(lineBottom, bottom(*it));
+  }
+  std::stable_sort(lineStart, placed, byLeft);
+}
+
+bool MergeOcrTiles(const std::vector<OcrTile>& tiles,
+                   std::vector<OcrResult>& results,
+                   const std::vector<OcrError>& errors,
+                   const std::vector<char>& succeeded,
+                   OcrResult& merged,
+                   OcrError& error) {
+  uint32_t imageWidth = 0;
+  for (const OcrTile& tile : tiles) {
+    imageWidth = std::max(imageWidth, tile.x + tile.width);
+  }
+
+  std::vector<Piece> pieces;
+  // Lines without a position cannot be matched up and follow the rest.
+  std::vector<OcrBlock> unplaced;
+  std::string unplacedText;
+  double confidence = 0.0;
+  double confidenceWeight = 0.0;
+  bool any = false;
+  for (size_t i = 0; i < tiles.size(); ++i) {
+    if (!succeeded[i]) {
+      continue;
+    }
+    OcrResult& result = results[i];
+    const OcrTile& tile = tiles[i];
+    if (!any) {
+      merged.engine = result.engine;
+      merged.language = result.language;
+      any = true;
+    }
+    if (result.hasConfidence && !result.text.empty()) {
+      confidence += result.confidence * static_cast<double>(result.text.size());
+      confidenceWeight += static_cast<double>(result.text.size());
+    }
+    if (result.blocks.empty() && !result.text.empty()) {
+      unplacedText += unplacedText.empty() ? result.text : "\n" + result.text;
+    }
+    for (OcrBlock& block : result.blocks) {
+      if (!block.hasBoundingBox) {
+        unplaced.push_back(std::move(block));
+        continue;
+      }
+      Piece piece;
+      piece.left = tile.x + block.boundingBox[0];
+      piece.top = tile.y + block.boundingBox[1];
+      piece.right = piece.left + block.boundingBox[2];
+      piece.bottom = piece.top + block.boundingBox[3];
+      // A line that ends within a character and a space of an edge shared
+      // with another tile may continue past it: engines drop the character
+      // the edge cuts rather than read half of it.
+      const double margin = piece.height() + 2.0;
+      piece.cutLeft = tile.x > 0 && block.boundingBox[0] <= margin;
+      piece.cutRight = tile.x + tile.width < imageWidth && block.boundingBox[0] + block.boundingBox[2] >= tile.width - margin;
+      piece.tiles.push_back(i);
+      for (OcrWord& word : block.words) {
+        word.boundingBox[0] += tile.x;
+        word.boundingBox[1] += tile.y;
+      }
+      piece.block = std::move(block);
+      pieces.push_back(std::move(piece));
+    }
+  }
+
+  if (!any) {
+    for (size_t i = 0; i < tiles.size(); ++i) {
+      if (!errors[i].code.empty()) {
+        error = errors[i];
+        return false;
+      }
+    }
+    error.code = "ERR_OCR_RECOGNIZE_FAILED";
+    error.message = "OCR recognized no text in the image";
+    return false;
+  }
+
+  MergePieces(pieces);
+  pieces.erase(std::remove_if(pieces.begin(), pieces.end(), [](const Piece& piece) { return !piece.alive; }),
+               pieces.end());
+
+  merged.blocks.clear();
+  merged.blocks.reserve(pieces.size() + unplaced.size());
+  for (Piece& piece : pieces) {
+    piece.block.boundingBox = {piece.left, piece.top, piece.width(), piece.height()};
+    merged.blocks.push_back(std::move(piece.block));
+  }
+  SortOcrBlocksInReadingOrder(merged.blocks);
+  for (OcrBlock& block : unplaced) {
+    merged.blocks.push_back(std::move(block));
+  }
+
+  merged.text.clear();
+  for (const OcrBlock& block : merged.blocks) {
+    if (!merged.text.empty()) {
+      merged.text += '\n';
+    }
+    merged.text += block.text;
+  }
+  if (!unplacedText.empty()) {
+    merged.text += merged.text.empty() ? unplacedText : "\n" + unplacedText;
+  }
+  merged.hasConfidence = confidenceWeight > 0.0;
+  merged.confidence = merged.hasConfidence ? confidence / confidenceWeight : 0.0;
+
+  if (merged.text.empty()) {
+    error.code = "ERR_OCR_RECOGNIZE_FAILED";
+    error.message = "OCR recognized no text in the image";
+    return false;
+  }
+  return true;
+}
+
+} // namespace tuff::native
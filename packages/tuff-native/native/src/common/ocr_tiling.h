@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "common/ocr_types.h"
+
+namespace tuff::native {
+
+struct OcrTile {
+  uint32_t x = 0;
+  uint32_t y = 0;
+  uint32_t width = 0;
+  uint32_t height = 0;
+};
+
+// Covers a width x height image with a grid of tiles no larger than
+// `tileSize` a side, spread evenly so that neighbours share at least
+// `overlap` pixels. A single tile when the image already fits.
+std::vector<OcrTile> PlanOcrTiles(uint32_t width, uint32_t height, uint32_t tileSize, uint32_t overlap);
+
+// Merges the results of recognizing each tile, whose block bounding boxes
+// are relative to their tile, into `merged`. Boxes are moved to image
+// coordinates; a line seen by two tiles is kept once, and a line cut at a
+// tile edge is joined back together. Blocks come out in reading order and
+// `merged.text` is their lines. Tiles that failed count as empty; when every
+// tile failed, the first error is returned.
+bool MergeOcrTiles(const std::vector<OcrTile>& tiles,
+                   std::vector<OcrResult>& results,
+                   const std::vector<OcrError>& errors,
+                   const std::vector<char>& succeeded,
+                   OcrResult& merged,
+                   OcrError& error);
+
+// Orders blocks as they are read: lines top to bottom, each left to right.
+// Blocks without a bounding box keep their order and go last.
+void SortOcrBlocksInReadingOrder(std::vector<OcrBlock>& blocks);
+
+} // namespace tuff::native
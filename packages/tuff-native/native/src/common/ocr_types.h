@@ -1,18 +1,82 @@
 #pragma once
 
 #include <array>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace tuff::native {
 
+// One word of a line, as the engine split it. Words always have a box.
+struct OcrWord {
+  std::string text;
+  double confidence = 0.0;
+  bool hasConfidence = false;
+  std::array<double, 4> boundingBox{0.0, 0.0, 0.0, 0.0};
+};
+
 struct OcrBlock {
   std::string text;
   double confidence = 0.0;
   bool hasConfidence = false;
   std::array<double, 4> boundingBox{0.0, 0.0, 0.0, 0.0};
   bool hasBoundingBox = false;
+  // The words of the line, left to right, with OcrOptions::includeWords.
+  std::vector<OcrWord> words;
+};
+
+// What OcrOptions::preprocess did to the image before it was recognized.
+// Block bounding boxes are already mapped back to the source image; these
+// describe the image the engine saw.
+struct OcrPreprocessReport {
+  bool applied = false;
+  // Per step, in milliseconds; 0 for steps that did not run.
+  double decodeMs = 0.0;
+  double cropMs = 0.0;
+  double grayscaleMs = 0.0;
+  double scaleMs = 0.0;
+  double binarizeMs = 0.0;
+  double deskewMs = 0.0;
+  double totalMs = 0.0;
+  // Source pixels per engine pixel is 1 / scale.
+  double scale = 1.0;
+  // The skew that was corrected, in degrees, positive for lines that fall
+  // to the right.
+  double skewDegrees = 0.0;
+  uint32_t cropX = 0;
+  uint32_t cropY = 0;
+  uint32_t width = 0;
+  uint32_t height = 0;
+};
+
+// How an OcrSession recognized a frame.
+struct OcrIncrementalReport {
+  bool applied = false;
+  // Recognized whole rather than region by region.
+  bool full = true;
+  uint32_t regions = 0;
+  // Share of the frame that changed since the previous one.
+  double changedFraction = 1.0;
+  // Lines carried over from the previous frame.
+  uint32_t reusedBlocks = 0;
+};
+
+// What the text check of OcrOptions::textDetection found.
+struct OcrTextDetectionReport {
+  bool applied = false;
+  // How likely the image is to hold text, 0..1.
+  double score = 0.0;
+  // Glyph-like shapes found lined up, and the lines they form.
+  uint32_t glyphs = 0;
+  uint32_t lines = 0;
+  double ms = 0.0;
 };
 
 struct OcrResult {
@@ -23,13 +87,107 @@ struct OcrResult {
   std::vector<OcrBlock> blocks;
   std::string engine;
   uint64_t durationMs = 0;
+  OcrPreprocessReport preprocess;
+  // Served by OcrResultCache rather than recognized.
+  bool cached = false;
+  OcrIncrementalReport incremental;
+  OcrTextDetectionReport textDetection;
+};
+
+enum class OcrPixelFormat : uint8_t {
+  kEncoded,  // PNG, JPEG, ... for the platform decoder
+  kBgra8,
+  kGray8,
+};
+
+// The image to recognize, borrowed rather than copied: `data` stays valid as
+// long as `owner` does (a file mapping, a decoded data URL) or, with no owner,
+// as long as the caller keeps it alive (a referenced JS Buffer).
+struct OcrImage {
+  const uint8_t* data = nullptr;
+  size_t size = 0;
+  OcrPixelFormat format = OcrPixelFormat::kEncoded;
+  // Raw formats only; `stride` is the distance between rows in bytes.
+  uint32_t width = 0;
+  uint32_t height = 0;
+  uint32_t stride = 0;
+  std::shared_ptr<const void> owner;
+
+  bool empty() const { return data == nullptr || size == 0; }
+};
+
+// Image clean-up run before recognition, each step opt-in. Steps run in
+// this order, on the pool thread: decode, crop, grayscale, downscale,
+// binarize, deskew. Binarize and deskew imply grayscale.
+struct OcrPreprocessOptions {
+  // Region of interest in source pixels; clipped to the image. Ignored when
+  // width or height is 0.
+  uint32_t cropX = 0;
+  uint32_t cropY = 0;
+  uint32_t cropWidth = 0;
+  uint32_t cropHeight = 0;
+  bool grayscale = false;
+  // Downscales, never upscales, by area averaging so text comes out about
+  // this many pixels tall. 0 leaves the size alone.
+  uint32_t targetTextHeight = 0;
+  // Text height in source pixels when the caller knows it; otherwise it is
+  // estimated from the rows that carry ink.
+  uint32_t textHeightHint = 0;
+  // Bradley adaptive threshold: a pixel is ink when it is `binarizeThreshold`
+  // darker than the mean of the window around it. A window of 0 picks one
+  // from the image size.
+  bool binarize = false;
+  uint32_t binarizeWindow = 0;
+  double binarizeThreshold = 0.15;
+  // Searches +-maxSkewDegrees for the angle that lines text up best and
+  // rotates it level.
+  bool deskew = false;
+  double maxSkewDegrees = 5.0;
+
+  bool HasCrop() const { return cropWidth > 0 && cropHeight > 0; }
+  bool enabled() const { return HasCrop() || grayscale || targetTextHeight > 0 || binarize || deskew; }
+};
+
+// Splits images too large to recognize in one go into overlapping tiles that
+// run in parallel across the pool's threads. The lines found in each tile are
+// merged back into one result in image coordinates.
+struct OcrTilingOptions {
+  // Longest side of a tile in pixels, after preprocessing. 0 tiles only what
+  // the engine cannot take whole (Windows OCR's MaxImageDimension).
+  uint32_t tileSize = 0;
+  // Pixels neighbouring tiles share, so a line cut at a tile edge is whole in
+  // at least one of them. Should exceed the text height; clamped to under
+  // half a tile.
+  uint32_t overlap = 128;
+};
+
+// A check run ahead of the engine that fails images unlikely to hold text
+// with ERR_OCR_NO_TEXT in a few milliseconds, rather than after a full
+// recognition (see DetectText). Off unless enabled; `force` turns it off
+// again for one call, say a batch item under service defaults that enable
+// it. Session frames are not checked.
+struct OcrTextDetectionOptions {
+  bool enabled = false;
+  // Text likelihood, 0..1, below which the engine is skipped.
+  double threshold = 0.2;
+  bool force = false;
+
+  bool active() const { return enabled && !force; }
 };
 
 struct OcrOptions {
-  std::vector<uint8_t> image;
+  OcrImage image;
   std::string languageHint;
   bool includeLayout = false;
+  // Also reports the words of each line; implies includeLayout.
+  bool includeWords = false;
+  // Only read by the addon: hands the layout to JS as typed arrays in one
+  // buffer rather than as an object per line. Implies includeLayout.
+  bool compactLayout = false;
   int maxBlocks = 0;
+  OcrPreprocessOptions preprocess;
+  OcrTilingOptions tiling;
+  OcrTextDetectionOptions textDetection;
 };
 
 struct OcrError {
@@ -37,6 +195,173 @@ struct OcrError {
   std::string message;
 };
 
+enum class OcrPriority : uint8_t {
+  // Someone is waiting on the result (a screenshot, an explicit request).
+  kInteractive,
+  // Catch-up work such as clipboard history; runs on its own threads at
+  // reduced OS priority and never delays interactive work.
+  kBackground,
+};
+
+class OcrSession;
+
+// One recognition queued on an OcrEnginePool.
+struct OcrTask {
+  OcrOptions options;
+  OcrPriority priority = OcrPriority::kInteractive;
+  // Checked when the task reaches the front of its queue; a task that is
+  // cancelled or past its deadline by then fails without running.
+  std::function<bool()> isCancelled;
+  std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+  // Runs on the pool thread when the task is taken off its queue, before
+  // anything reads the image; false fails it as cancelled without reading.
+  std::function<bool()> start;
+  // Runs on the pool thread before recognition, to load the image (map a
+  // file, decode a data URL) off the caller's thread.
+  std::function<bool(OcrOptions& options, OcrError& error)> prepare;
+  // Runs on the pool thread exactly once, whatever the outcome.
+  std::function<void(bool ok, OcrResult& result, OcrError& error)> done;
+  // Recognizes the image as the next frame of this session: only what
+  // changed since the session's previous frame. Bypasses the result cache.
+  std::shared_ptr<OcrSession> session;
+};
+
 bool PerformPlatformOcr(const OcrOptions& options, OcrResult& result, OcrError& error);
 
+// Decodes PNG, JPEG, ... with the platform codec into BGRA pixels that
+// `decoded` owns. Only preprocessing needs this; without it the engines
+// decode for themselves.
+bool DecodePlatformImage(const OcrImage& encoded, OcrImage& decoded, OcrError& error);
+
+// Queues `task` on the platform backend; `task.done` may run before this
+// returns where there is no backend.
+void SubmitPlatformOcr(OcrTask task);
+
+// Threads the platform backend may use for each priority.
+void ConfigurePlatformOcr(uint32_t threads, uint32_t backgroundThreads);
+
+// A recognizer for one language. It is created, used and destroyed on the
+// pool thread that owns it, so implementations need no locking and may hold
+// thread-affine state.
+class OcrEngine {
+ public:
+  virtual ~OcrEngine() = default;
+  virtual bool Recognize(const OcrOptions& options, OcrResult& result, OcrError& error) = 0;
+};
+
+// The platform half of OcrEnginePool.
+class OcrEngineFactory {
+ public:
+  virtual ~OcrEngineFactory() = default;
+
+  // Pool key for a language hint. Hints that end up on the same engine
+  // ("en", "en-US") should map to the same key.
+  virtual std::string ResolveLanguage(const std::string& hint) const { return hint; }
+
+  // Runs first on every pool thread; the returned state (a COM apartment,
+  // say) is released when the thread exits, after its engines.
+  virtual std::shared_ptr<void> AttachThread() { return nullptr; }
+
+  // Returns nullptr with `error` set when no engine can be made.
+  virtual std::unique_ptr<OcrEngine> Create(const std::string& language, OcrError& error) = 0;
+
+  // Longest side, in pixels, the engines accept; larger images are tiled.
+  // 0 for no limit.
+  virtual uint32_t MaxImageDimension() const { return 0; }
+};
+
+struct OcrEnginePoolOptions {
+  // Threads for interactive tasks.
+  uint32_t threads = 2;
+  // Threads for background tasks, which run at reduced OS priority. With 0,
+  // background tasks queue behind interactive ones instead.
+  uint32_t backgroundThreads = 1;
+  // Engines one thread keeps; the least recently used beyond this are
+  // destroyed.
+  uint32_t maxEnginesPerThread = 3;
+  // Engines unused for this long are destroyed. All idle engines go when the
+  // system reports low memory.
+  uint32_t idleTimeoutMs = 5 * 60 * 1000;
+};
+
+struct OcrEnginePoolStats {
+  uint32_t threads = 0;
+  uint64_t engines = 0;
+  uint64_t jobs = 0;
+  // Jobs that were split into tiles, and the tiles recognized for them.
+  uint64_t tiledJobs = 0;
+  uint64_t tiles = 0;
+  // Jobs failed with ERR_OCR_NO_TEXT by OcrOptions::textDetection.
+  uint64_t textlessJobs = 0;
+  uint64_t enginesCreated = 0;
+  uint64_t enginesEvicted = 0;
+  // Jobs waiting for a thread, and threads running one, right now.
+  uint32_t queuedInteractive = 0;
+  uint32_t queuedBackground = 0;
+  uint32_t busyThreads = 0;
+};
+
+// Keeps OCR engines alive between calls. Engines are keyed by language,
+// created on first use and pinned to a small set of long-lived threads, each
+// of which owns its engines and whatever per-thread state the factory sets
+// up. A call is sent to a thread that already holds an engine for its
+// language when one is free, so steady traffic in one language never
+// constructs an engine twice.
+class OcrEnginePool {
+ public:
+  explicit OcrEnginePool(std::unique_ptr<OcrEngineFactory> factory, OcrEnginePoolOptions options = {});
+  ~OcrEnginePool();
+
+  OcrEnginePool(const OcrEnginePool&) = delete;
+  OcrEnginePool& operator=(const OcrEnginePool&) = delete;
+
+  void Submit(OcrTask task);
+
+  // Submits an interactive task and blocks until it is done.
+  bool Recognize(const OcrOptions& options, OcrResult& result, OcrError& error);
+
+  // Changes the thread limits. Threads past a lowered limit take no more
+  // tasks and drop their engines.
+  void Configure(uint32_t threads, uint32_t backgroundThreads);
+
+  // Destroys every engine not in use.
+  void Trim();
+
+  OcrEnginePoolStats Stats();
+
+ private:
+  struct Job;
+  struct Lane;
+  struct TileWork;
+
+  OcrPriority LanePriorityLocked(OcrPriority priority) const;
+  uint32_t LaneLimitLocked(OcrPriority priority) const;
+  Lane& PickLaneLocked(OcrPriority priority, const std::string& language);
+  void RunLane(Lane& lane);
+
+  std::unique_ptr<OcrEngineFactory> factory_;
+  OcrEnginePoolOptions options_;
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<Lane>> lanes_;
+  bool stopping_ = false;
+  OcrEnginePoolStats stats_;
+};
+
+// The platform backend's pool; all zero where there is none.
+OcrEnginePoolStats PlatformOcrStats();
+
+// Best-effort reading of whether the system is short of memory.
+bool IsSystemMemoryLow();
+
+// Moves the calling thread to background scheduling (nice 10, QoS utility,
+// THREAD_MODE_BACKGROUND_BEGIN). One way: unprivileged Linux threads cannot
+// raise their priority again.
+void LowerCurrentThreadPriority();
+
+#if defined(__linux__)
+// The Linux backend loads its engine at run time. Empty when it is usable,
+// otherwise the reason getNativeOcrSupport() reports.
+std::string ProbePlatformOcrEngine();
+#endif
+
 } // namespace tuff::native
@@ -0,0 +1,373 @@
+#include "common/text_detect.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include "common/image_preprocess.h"
+
+namespace tuff::native {
+
+namespace {
+
+// Longest side the image is reduced to; text stays a few pixels tall while
+// the work stays at a few milliseconds.
+constexpr uint32_t kMaxSide = 1024;
+// Ink is a pixel this many levels darker (or lighter) than the mean of the
+// window of this radius around it.
+constexpr uint32_t kWindowRadius = 8;
+constexpr uint32_t kInkContrast = 20;
+// Glyph heights considered, in reduced pixels.
+constexpr uint32_t kMinGlyphHeight = 5;
+constexpr uint32_t kMaxGlyphHeight = 128;
+// Glyphs in a row it takes to count as a line.
+constexpr size_t kMinLineGlyphs = 3;
+// Glyphs on lines at which the score reaches 1 - 1/e.
+constexpr double kGlyphScale = 16.0;
+// Ink broken into more runs than one per this many pixels is noise or a
+// fine texture; text stays under a third of that.
+constexpr size_t kPixelsPerRun = 8;
+// Pairing looks for neighbours in a grid of cells this large.
+constexpr uint32_t kCellSize = 16;
+
+struct Run {
+  uint32_t y = 0;
+  uint32_t x0 = 0;
+  // Inclusive.
+  uint32_t x1 = 0;
+};
+
+struct Glyph {
+  uint32_t left = 0;
+  uint32_t top = 0;
+  uint32_t right = 0;
+  uint32_t bottom = 0;
+  // Mean length of the glyph's runs, which for the strokes of a glyph is
+  // about their width.
+  double stroke = 0.0;
+  // A solid or very thin upright bar: "l", "1", or a stripe.
+  bool bar = false;
+
+  uint32_t Height() const { return bottom - top + 1; }
+  uint32_t CenterX() const { return (left + right) / 2; }
+  uint32_t CenterY() const { return (top + bottom) / 2; }
+};
+
+uint32_t FindRoot(std::vector<uint32_t>& parent, uint32_t index) {
+  while (parent[index] != index) {
+    parent[index] = parent[parent[index]];
+    index = parent[index];
+  }
+  return index;
+}
+
+void Unite(std::vector<uint32_t>& parent, uint32_t a, uint32_t b) {
+  a = FindRoot(parent, a);
+  b = FindRoot(parent, b);
+  if (a != b) {
+    parent[std::max(a, b)] = std::min(a, b);
+  }
+}
+
+// Luma averaged over factor x factor boxes.
+std::vector<uint8_t> ReduceToLuma(const OcrImage& image, uint32_t factor, uint32_t& width, uint32_t& height) {
+  width = std::max<uint32_t>(1, image.width / factor);
+  height = std::max<uint32_t>(1, image.height / factor);
+  const uint32_t columns = std::min(image.width, width * factor);
+  const uint32_t rows = std::min(image.height, height * factor);
+  const uint32_t samples = (columns / width) * (rows / height);
+
+  std::vector<uint8_t> luma(static_cast<size_t>(width) * height);
+  std::vector<uint8_t> gray(image.width);
+  std::vector<uint32_t> sums(width);
+  for (uint32_t y = 0; y < height; ++y) {
+    std::fill(sums.begin(), sums.end(), 0);
+    for (uint32_t k = 0; k < rows / height; ++k) {
+      const uint8_t* source = image.data + static_cast<size_t>(y * (rows / height) + k) * image.stride;
+      if (image.format == OcrPixelFormat::kBgra8) {
+        ConvertBgraRowToGray(source, gray.data(), columns);
+        source = gray.data();
+      }
+      for (uint32_t x = 0; x < columns; ++x) {
+        sums[x / factor] += source[x];
+      }
+    }
+    uint8_t* target = luma.data() + static_cast<size_t>(y) * width;
+    for (uint32_t x = 0; x < width; ++x) {
+      target[x] = static_cast<uint8_t>(sums[x] / samples);
+    }
+  }
+  return luma;
+}
+
+// Runs of ink, row by row: pixels kInkContrast darker (`dark`) or lighter
+// than their window's mean, read off the integral image `integral`. None
+// when there are too many to be text.
+std::vector<Run> FindInkRuns(const std::vector<uint8_t>& luma,
+                             const std::vector<uint32_t>& integral,
+                             uint32_t width,
+                             uint32_t height,
+                             bool dark) {
+  std::vector<Run> runs;
+  const size_t maxRuns = static_cast<size_t>(width) * height / kPixelsPerRun + 1;
+  const size_t integralStride = static_cast<size_t>(width) + 1;
+  for (uint32_t y = 0; y < height; ++y) {
+    const uint32_t y0 = y > kWindowRadius ? y - kWindowRadius : 0;
+    const uint32_t y1 = std::min(height, y + kWindowRadius + 1);
+    const uint32_t* top = integral.data() + y0 * integralStride;
+    const uint32_t* bottom = integral.data() + y1 * integralStride;
+    const uint8_t* row = luma.data() + static_cast<size_t>(y) * width;
+    bool inRun = false;
+    for (uint32_t x = 0; x < width; ++x) {
+      const uint32_t x0 = x > kWindowRadius ? x - kWindowRadius : 0;
+      const uint32_t x1 = std::min(width, x + kWindowRadius + 1);
+      const uint32_t count = (x1 - x0) * (y1 - y0);
+      const uint32_t sum = bottom[x1] - bottom[x0] - top[x1] + top[x0];
+      const uint32_t value = row[x] * count;
+      const bool ink = dark ? value + kInkContrast * count < sum : value > sum + kInkContrast * count;
+      if (ink && !inRun) {
+        if (runs.size() == maxRuns) {
+          return {};
+        }
+        runs.push_back({y, x, x});
+        inRun = true;
+      } else if (ink) {
+        runs.back().x1 = x;
+      } else {
+        inRun = false;
+      }
+    }
+  }
+  return runs;
+}
+
+// Joins 8-connected runs into components and keeps those shaped like glyphs.
+std::vector<Glyph> FindGlyphs(const std::vector<Run>& runs, uint32_t imageHeight) {
+  std::vector<uint32_t> parent(runs.size());
+  for (uint32_t i = 0; i < parent.size(); ++i) {
+    parent[i] = i;
+  }
+  // Runs are in row order; `previous` walks the row above alongside.
+  size_t previousStart = 0;
+  size_t rowStart = 0;
+  for (size_t i = 0; i < runs.size(); ++i) {
+    if (i == 0 || runs[i].y != runs[i - 1].y) {
+      previousStart = i > 0 && runs[i - 1].y + 1 == runs[i].y ? rowStart : i;
+      rowStart = i;
+    }
+    for (size_t j = previousStart; j < rowStart; ++j) {
+      if (runs[j].x1 + 1 < runs[i].x0) {
+        previousStart = j + 1;
+        continue;
+      }
+      if (runs[j].x0 > runs[i].x1 + 1) {
+        break;
+      }
+      Unite(parent, static_cast<uint32_t>(i), static_cast<uint32_t>(j));
+    }
+  }
+
+  struct Component {
+    uint32_t left = UINT32_MAX;
+    uint32_t top = UINT32_MAX;
+    uint32_t right = 0;
+    uint32_t bottom = 0;
+    uint32_t area = 0;
+    uint32_t runs = 0;
+  };
+  std::vector<Component> components(runs.size());
+  for (uint32_t i = 0; i < runs.size(); ++i) {
+    Component& component = components[FindRoot(parent, i)];
+    component.left = std::min(component.left, runs[i].x0);
+    component.right = std::max(component.right, runs[i].x1);
+    component.top = std::min(component.top, runs[i].y);
+    component.bottom = std::max(component.bottom, runs[i].y);
+    component.area += runs[i].x1 - runs[i].x0 + 1;
+    ++component.runs;
+  }
+
+  const uint32_t maxHeight = std::min(kMaxGlyphHeight, imageHeight);
+  std::vector<Glyph> glyphs;
+  for (const Component& component : components) {
+    if (component.runs == 0) {
+      continue;
+    }
+    const uint32_t width = component.right - component.left + 1;
+    const uint32_t height = component.bottom - component.top + 1;
+    const double fill = static_cast<double>(component.area) / (static_cast<double>(width) * height);
+    const double stroke = static_cast<double>(component.area) / component.runs;
+    // Glyphs are no wider than a few of themselves, partly empty unless
+    // they are a bar ("l", "I", "1"), and drawn with strokes much thinner
+    // than they are tall; solid blobs and long edges are not.
+    if (height < kMinGlyphHeight || height > maxHeight || width * 2 > height * 5 || component.area < 8 ||
+        (fill > 0.85 && width * 3 > height) || fill < 0.1 || stroke > std::max(2.0, 0.4 * height)) {
+      continue;
+    }
+    glyphs.push_back({component.left, component.top, component.right, component.bottom, stroke,
+                      fill > 0.85 || width * 4 < height});
+  }
+  return glyphs;
+}
+
+// Whether `b`, right of `a`, continues the same line of text.
+bool Neighbours(const Glyph& a, const Glyph& b) {
+  const uint32_t low = std::min(a.Height(), b.Height());
+  const uint32_t high = std::max(a.Height(), b.Height());
+  if (b.CenterX() <= a.CenterX() || high * 5 > low * 11) {
+    return false;
+  }
+  const double gap = static_cast<double>(b.left) - static_cast<double>(a.right);
+  if (gap > high || gap < -0.2 * high) {
+    return false;
+  }
+  // Letters share a baseline or a cap line; CJK characters a centre line.
+  const auto near = [high](uint32_t p, uint32_t q) { return (p > q ? p - q : q - p) * 5 <= high; };
+  if (!near(a.bottom, b.bottom) && !near(a.top, b.top) && !near(a.top + a.bottom, b.top + b.bottom)) {
+    return false;
+  }
+  return std::max(a.stroke, b.stroke) <= 2.5 * std::min(a.stroke, b.stroke);
+}
+
+// Chains neighbouring glyphs and counts those on chains long enough to be a
+// line.
+void CountLines(const std::vector<Glyph>& glyphs, uint32_t width, uint32_t height, uint32_t& onLines, uint32_t& lines) {
+  onLines = 0;
+  lines = 0;
+  if (glyphs.size() < kMinLineGlyphs) {
+    return;
+  }
+
+  // Glyphs bucketed by the cell their centre falls in.
+  const uint32_t columns = width / kCellSize + 1;
+  const uint32_t rows = height / kCellSize + 1;
+  std::vector<uint32_t> cellStart(static_cast<size_t>(columns) * rows + 1, 0);
+  const auto cellOf = [&](const Glyph& glyph) {
+    return static_cast<size_t>(glyph.CenterY() / kCellSize) * columns + glyph.CenterX() / kCellSize;
+  };
+  for (const Glyph& glyph : glyphs) {
+    ++cellStart[cellOf(glyph) + 1];
+  }
+  for (size_t i = 1; i < cellStart.size(); ++i) {
+    cellStart[i] += cellStart[i - 1];
+  }
+  std::vector<uint32_t> cellGlyphs(glyphs.size());
+  std::vector<uint32_t> fill(cellStart.begin(), cellStart.end() - 1);
+  for (uint32_t i = 0; i < glyphs.size(); ++i) {
+    cellGlyphs[fill[cellOf(glyphs[i])]++] = i;
+  }
+
+  std::vector<uint32_t> parent(glyphs.size());
+  for (uint32_t i = 0; i < parent.size(); ++i) {
+    parent[i] = i;
+  }
+  for (uint32_t i = 0; i < glyphs.size(); ++i) {
+    const Glyph& glyph = glyphs[i];
+    // A neighbour is at most 2.2 times as tall and a height away, so its
+    // centre lies within about these bounds.
+    const uint32_t reach = glyph.Height() * 11 / 5 + 1;
+    const uint32_t firstColumn = glyph.CenterX() / kCellSize;
+    const uint32_t lastColumn = std::min(columns - 1, (glyph.right + 2 * reach) / kCellSize);
+    const uint32_t firstRow = (glyph.top > reach ? glyph.top - reach : 0) / kCellSize;
+    const uint32_t lastRow = std::min(rows - 1, (glyph.bottom + reach) / kCellSize);
+    for (uint32_t row = firstRow; row <= lastRow; ++row) {
+      for (uint32_t column = firstColumn; column <= lastColumn; ++column) {
+        const size_t cell = static_cast<size_t>(row) * columns + column;
+        for (uint32_t k = cellStart[cell]; k < cellStart[cell + 1]; ++k) {
+          if (Neighbours(glyph, glyphs[cellGlyphs[k]])) {
+            Unite(parent, i, cellGlyphs[k]);
+          }
+        }
+      }
+    }
+  }
+
+  struct Chain {
+    uint32_t size = 0;
+    uint32_t bars = 0;
+    uint32_t left = UINT32_MAX;
+    uint32_t top = UINT32_MAX;
+    uint32_t right = 0;
+    uint32_t bottom = 0;
+    uint32_t maxHeight = 0;
+    // Glyphs over 0.6 of the tallest.
+    uint32_t tall = 0;
+  };
+  std::vector<Chain> chains(glyphs.size());
+  for (uint32_t i = 0; i < glyphs.size(); ++i) {
+    const Glyph& glyph = glyphs[i];
+    Chain& chain = chains[FindRoot(parent, i)];
+    ++chain.size;
+    chain.bars += glyph.bar ? 1 : 0;
+    chain.left = std::min(chain.left, glyph.left);
+    chain.top = std::min(chain.top, glyph.top);
+    chain.right = std::max(chain.right, glyph.right);
+    chain.bottom = std::max(chain.bottom, glyph.bottom);
+    chain.maxHeight = std::max(chain.maxHeight, glyph.Height());
+  }
+  for (uint32_t i = 0; i < glyphs.size(); ++i) {
+    Chain& chain = chains[FindRoot(parent, i)];
+    chain.tall += glyphs[i].Height() * 5 > chain.maxHeight * 3 ? 1 : 0;
+  }
+  // Each pair along a chain is alike, but so are neighbouring strokes of a
+  // texture. A line is also level (within about 10 degrees), has most of
+  // its glyphs near full height (x-height letters, CJK radicals side by
+  // side), and is more than a row of bars, which is a fence or a stripe
+  // pattern.
+  for (const Chain& chain : chains) {
+    if (chain.size < kMinLineGlyphs || chain.bars * 2 > chain.size || chain.tall * 2 < chain.size ||
+        (chain.bottom - chain.top + 1 - chain.maxHeight) * 5 > chain.right - chain.left + 1) {
+      continue;
+    }
+    onLines += chain.size;
+    ++lines;
+  }
+}
+
+} // namespace
+
+bool DetectText(const OcrImage& image, OcrTextDetectionReport& report) {
+  report = {};
+  if (image.format == OcrPixelFormat::kEncoded || image.empty() || image.width == 0 || image.height == 0) {
+    return false;
+  }
+  const auto startedAt = std::chrono::steady_clock::now();
+  report.applied = true;
+
+  const uint32_t factor = (std::max(image.width, image.height) + kMaxSide - 1) / kMaxSide;
+  uint32_t width = 0;
+  uint32_t height = 0;
+  const std::vector<uint8_t> luma = ReduceToLuma(image, std::max<uint32_t>(1, factor), width, height);
+
+  std::vector<uint32_t> integral((static_cast<size_t>(width) + 1) * (height + 1), 0);
+  for (uint32_t y = 0; y < height; ++y) {
+    const uint8_t* row = luma.data() + static_cast<size_t>(y) * width;
+    const uint32_t* above = integral.data() + static_cast<size_t>(y) * (width + 1);
+    uint32_t* current = integral.data() + static_cast<size_t>(y + 1) * (width + 1);
+    uint32_t rowSum = 0;
+    for (uint32_t x = 0; x < width; ++x) {
+      rowSum += row[x];
+      current[x + 1] = above[x + 1] + rowSum;
+    }
+  }
+
+  // Dark text on light and light on dark are counted apart; the stronger
+  // reading wins, since the holes of one polarity's glyphs are small
+  // components of the other.
+  for (const bool dark : {true, false}) {
+    const std::vector<Glyph> glyphs = FindGlyphs(FindInkRuns(luma, integral, width, height, dark), height);
+    uint32_t onLines = 0;
+    uint32_t lines = 0;
+    CountLines(glyphs, width, height, onLines, lines);
+    if (onLines > report.glyphs) {
+      report.glyphs = onLines;
+      report.lines = lines;
+    }
+  }
+
+  report.score = 1.0 - std::exp(-static_cast<double>(report.glyphs) / kGlyphScale);
+  report.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startedAt).count();
+  return true;
+}
+
+} // namespace tuff::native
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+#include "common/ocr_types.h"
+
+namespace tuff::native {
+
+// Rates how likely raw pixels are to hold text, without recognizing it, in a
+// few milliseconds: the image is reduced to luma no larger than about 1024
+// pixels a side, split into dark and light ink against the local mean, and
+// the connected components are kept that are shaped like glyphs (size,
+// aspect, fill, stroke width thin for their height). Text is where such
+// components line up: similar heights and strokes, side by side on a shared
+// band. Photos, gradients and textures rarely produce more than a stray
+// pair. Fills `report` (score, glyphs, lines) and returns false only for
+// encoded images.
+bool DetectText(const OcrImage& image, OcrTextDetectionReport& report);
+
+} // namespace tuff::native
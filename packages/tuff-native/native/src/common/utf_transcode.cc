@@ -0,0 +1,342 @@
+#include "common/utf_transcode.h"
+
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TUFF_UTF_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define TUFF_UTF_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace tuff::native {
+
+namespace {
+
+constexpr char32_t kReplacement = 0xFFFD;
+
+// Copies whole 16-byte blocks of ASCII from `src`, widening each byte to a
+// Unit, and stops at the first block holding anything else. Returns how many
+// bytes it copied; the caller finishes the rest a code point at a time.
+template <typename Unit>
+size_t WidenAscii(const uint8_t* src, size_t length, Unit* dst) {
+  static_assert(sizeof(Unit) == 2 || sizeof(Unit) == 4, "UTF-16 or UTF-32 code units");
+  size_t i = 0;
+#if defined(TUFF_UTF_SSE2)
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 16 <= length; i += 16) {
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    if (_mm_movemask_epi8(bytes) != 0) {
+      break;
+    }
+    const __m128i low = _mm_unpacklo_epi8(bytes, zero);
+    const __m128i high = _mm_unpackhi_epi8(bytes, zero);
+    auto* out = reinterpret_cast<__m128i*>(dst + i);
+    if constexpr (sizeof(Unit) == 2) {
+      _mm_storeu_si128(out, low);
+      _mm_storeu_si128(out + 1, high);
+    } else {
+      _mm_storeu_si128(out, _mm_unpacklo_epi16(low, zero));
+      _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(low, zero));
+      _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(high, zero));
+      _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(high, zero));
+    }
+  }
+#elif defined(TUFF_UTF_NEON)
+  for (; i + 16 <= length; i += 16) {
+    const uint8x16_t bytes = vld1q_u8(src + i);
+    if (vmaxvq_u8(bytes) >= 0x80) {
+      break;
+    }
+    const uint16x8_t low = vmovl_u8(vget_low_u8(bytes));
+    const uint16x8_t high = vmovl_u8(vget_high_u8(bytes));
+    if constexpr (sizeof(Unit) == 2) {
+      auto* out = reinterpret_cast<uint16_t*>(dst + i);
+      vst1q_u16(out, low);
+      vst1q_u16(out + 8, high);
+    } else {
+      auto* out = reinterpret_cast<uint32_t*>(dst + i);
+      vst1q_u32(out, vmovl_u16(vget_low_u16(low)));
+      vst1q_u32(out + 4, vmovl_u16(vget_high_u16(low)));
+      vst1q_u32(out + 8, vmovl_u16(vget_low_u16(high)));
+      vst1q_u32(out + 12, vmovl_u16(vget_high_u16(high)));
+    }
+  }
+#else
+  (void)src;
+  (void)length;
+  (void)dst;
+#endif
+  return i;
+}
+
+// The reverse: narrows whole blocks of 16 code units below 0x80 to bytes.
+template <typename Unit>
+size_t NarrowAscii(const Unit* src, size_t length, uint8_t* dst) {
+  static_assert(sizeof(Unit) == 2 || sizeof(Unit) == 4, "UTF-16 or UTF-32 code units");
+  size_t i = 0;
+#if defined(TUFF_UTF_SSE2)
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 16 <= length; i += 16) {
+    const auto* in = reinterpret_cast<const __m128i*>(src + i);
+    __m128i low;
+    __m128i high;
+    if constexpr (sizeof(Unit) == 2) {
+      low = _mm_loadu_si128(in);
+      high = _mm_loadu_si128(in + 1);
+      const __m128i above = _mm_and_si128(_mm_or_si128(low, high), _mm_set1_epi16(static_cast<short>(0xFF80)));
+      if (_mm_movemask_epi8(_mm_cmpeq_epi16(above, zero)) != 0xFFFF) {
+        break;
+      }
+    } else {
+      const __m128i a = _mm_loadu_si128(in);
+      const __m128i b = _mm_loadu_si128(in + 1);
+      const __m128i c = _mm_loadu_si128(in + 2);
+      const __m128i d = _mm_loadu_si128(in + 3);
+      const __m128i any = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+      const __m128i above = _mm_and_si128(any, _mm_set1_epi32(static_cast<int>(0xFFFFFF80u)));
+      if (_mm_movemask_epi8(_mm_cmpeq_epi32(above, zero)) != 0xFFFF) {
+        break;
+      }
+      low = _mm_packs_epi32(a, b);
+      high = _mm_packs_epi32(c, d);
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(low, high));
+  }
+#elif defined(TUFF_UTF_NEON)
+  for (; i + 16 <= length; i += 16) {
+    uint16x8_t low;
+    uint16x8_t high;
+    if constexpr (sizeof(Unit) == 2) {
+      const auto* in = reinterpret_cast<const uint16_t*>(src + i);
+      low = vld1q_u16(in);
+      high = vld1q_u16(in + 8);
+      if (vmaxvq_u16(vorrq_u16(low, high)) >= 0x80) {
+        break;
+      }
+    } else {
+      const auto* in = reinterpret_cast<const uint32_t*>(src + i);
+      const uint32x4_t a = vld1q_u32(in);
+      const uint32x4_t b = vld1q_u32(in + 4);
+      const uint32x4_t c = vld1q_u32(in + 8);
+      const uint32x4_t d = vld1q_u32(in + 12);
+      if (vmaxvq_u32(vorrq_u32(vorrq_u32(a, b), vorrq_u32(c, d))) >= 0x80) {
+        break;
+      }
+      low = vcombine_u16(vmovn_u32(a), vmovn_u32(b));
+      high = vcombine_u16(vmovn_u32(c), vmovn_u32(d));
+    }
+    vst1q_u8(dst + i, vcombine_u8(vmovn_u16(low), vmovn_u16(high)));
+  }
+#else
+  (void)src;
+  (void)length;
+  (void)dst;
+#endif
+  return i;
+}
+
+// One pass over `utf8` into `out`, which is first sized for the worst case
+// of one code unit per byte and then trimmed.
+template <typename Unit>
+bool DecodeUtf8(std::string_view utf8, std::basic_string<Unit>& out) {
+  out.resize(utf8.size());
+  const auto* src = reinterpret_cast<const uint8_t*>(utf8.data());
+  const size_t length = utf8.size();
+  Unit* dst = out.data();
+  size_t written = 0;
+
+  size_t i = 0;
+  while (i < length) {
+    const size_t run = WidenAscii(src + i, length - i, dst + written);
+    i += run;
+    written += run;
+    // Finish the block that stopped the run, and any short tail.
+    const size_t stop = i + 16 < length ? i + 16 : length;
+    while (i < stop) {
+      const uint8_t lead = src[i];
+      if (lead < 0x80) {
+        dst[written++] = static_cast<Unit>(lead);
+        ++i;
+        continue;
+      }
+
+      char32_t codePoint = 0;
+      size_t size = 0;
+      char32_t minimum = 0;
+      if (lead >= 0xC2 && lead <= 0xDF) {
+        codePoint = lead & 0x1F;
+        size = 2;
+        minimum = 0x80;
+      } else if (lead >= 0xE0 && lead <= 0xEF) {
+        codePoint = lead & 0x0F;
+        size = 3;
+        minimum = 0x800;
+      } else if (lead >= 0xF0 && lead <= 0xF4) {
+        codePoint = lead & 0x07;
+        size = 4;
+        minimum = 0x10000;
+      } else {
+        out.clear();
+        return false;
+      }
+      if (size > length - i) {
+        out.clear();
+        return false;
+      }
+      for (size_t k = 1; k < size; ++k) {
+        const uint8_t next = src[i + k];
+        if ((next & 0xC0) != 0x80) {
+          out.clear();
+          return false;
+        }
+        codePoint = (codePoint << 6) | (next & 0x3F);
+      }
+      if (codePoint < minimum || codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF)) {
+        out.clear();
+        return false;
+      }
+      i += size;
+
+      if constexpr (sizeof(Unit) == 2) {
+        if (codePoint >= 0x10000) {
+          codePoint -= 0x10000;
+          dst[written++] = static_cast<Unit>(0xD800 + (codePoint >> 10));
+          dst[written++] = static_cast<Unit>(0xDC00 + (codePoint & 0x3FF));
+          continue;
+        }
+      }
+      dst[written++] = static_cast<Unit>(codePoint);
+    }
+  }
+
+  out.resize(written);
+  return true;
+}
+
+inline size_t AppendUtf8(char32_t codePoint, uint8_t* dst) {
+  if (codePoint < 0x80) {
+    dst[0] = static_cast<uint8_t>(codePoint);
+    return 1;
+  }
+  if (codePoint < 0x800) {
+    dst[0] = static_cast<uint8_t>(0xC0 | (codePoint >> 6));
+    dst[1] = static_cast<uint8_t>(0x80 | (codePoint & 0x3F));
+    return 2;
+  }
+  if (codePoint < 0x10000) {
+    dst[0] = static_cast<uint8_t>(0xE0 | (codePoint >> 12));
+    dst[1] = static_cast<uint8_t>(0x80 | ((codePoint >> 6) & 0x3F));
+    dst[2] = static_cast<uint8_t>(0x80 | (codePoint & 0x3F));
+    return 3;
+  }
+  dst[0] = static_cast<uint8_t>(0xF0 | (codePoint >> 18));
+  dst[1] = static_cast<uint8_t>(0x80 | ((codePoint >> 12) & 0x3F));
+  dst[2] = static_cast<uint8_t>(0x80 | ((codePoint >> 6) & 0x3F));
+  dst[3] = static_cast<uint8_t>(0x80 | (codePoint & 0x3F));
+  return 4;
+}
+
+// A UTF-16 unit is at most 3 bytes (a pair is 4 for 2 units) and a UTF-32
+// one at most 4, which bounds the first resize.
+template <typename Unit>
+void EncodeUtf8(const Unit* src, size_t length, std::string& out) {
+  out.resize(length * (sizeof(Unit) == 2 ? 3 : 4));
+  if (src == nullptr || length == 0) {
+    out.clear();
+    return;
+  }
+  auto* dst = reinterpret_cast<uint8_t*>(out.data());
+  size_t written = 0;
+
+  size_t i = 0;
+  while (i < length) {
+    const size_t run = NarrowAscii(src + i, length - i, dst + written);
+    i += run;
+    written += run;
+    const size_t stop = i + 16 < length ? i + 16 : length;
+    while (i < stop) {
+      char32_t codePoint = static_cast<char32_t>(src[i]);
+      ++i;
+      if (codePoint < 0x80) {
+        dst[written++] = static_cast<uint8_t>(codePoint);
+        continue;
+      }
+      if constexpr (sizeof(Unit) == 2) {
+        if (codePoint >= 0xD800 && codePoint <= 0xDBFF && i < length) {
+          const auto low = static_cast<char32_t>(src[i]);
+          if (low >= 0xDC00 && low <= 0xDFFF) {
+            codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+            ++i;
+          }
+        }
+      }
+      if ((codePoint >= 0xD800 && codePoint <= 0xDFFF) || codePoint > 0x10FFFF) {
+        codePoint = kReplacement;
+      }
+      written += AppendUtf8(codePoint, dst + written);
+    }
+  }
+
+  out.resize(written);
+}
+
+} // namespace
+
+bool IsAscii(const char* data, size_t length) {
+  const auto* bytes = reinterpret_cast<const uint8_t*>(data);
+  size_t i = 0;
+#if defined(TUFF_UTF_SSE2)
+  for (; i + 16 <= length; i += 16) {
+    if (_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i))) != 0) {
+      return false;
+    }
+  }
+#elif defined(TUFF_UTF_NEON)
+  for (; i + 16 <= length; i += 16) {
+    if (vmaxvq_u8(vld1q_u8(bytes + i)) >= 0x80) {
+      return false;
+    }
+  }
+#endif
+  uint8_t any = 0;
+  for (; i < length; ++i) {
+    any |= bytes[i];
+  }
+  return any < 0x80;
+}
+
+bool Utf8ToUtf16(std::string_view utf8, std::u16string& out) {
+  return DecodeUtf8(utf8, out);
+}
+
+void Utf16ToUtf8(const char16_t* utf16, size_t length, std::string& out) {
+  EncodeUtf8(utf16, length, out);
+}
+
+bool Utf8ToWide(std::string_view utf8, std::wstring& out) {
+  return DecodeUtf8(utf8, out);
+}
+
+std::wstring Utf8ToWide(std::string_view utf8) {
+  std::wstring wide;
+  DecodeUtf8(utf8, wide);
+  return wide;
+}
+
+void WideToUtf8(const wchar_t* wide, size_t length, std::string& out) {
+  EncodeUtf8(wide, length, out);
+}
+
+std::string WideToUtf8(const wchar_t* wide, size_t length) {
+  std::string utf8;
+  EncodeUtf8(wide, length, utf8);
+  return utf8;
+}
+
+std::string WideToUtf8(std::wstring_view wide) {
+  return WideToUtf8(wide.data(), wide.size());
+}
+
+} // namespace tuff::native
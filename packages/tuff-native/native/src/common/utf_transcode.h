@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace tuff::native {
+
+// UTF-8 <-> UTF-16 and wchar_t conversions shared by every addon. Each is a
+// single pass into an output sized for the worst case, so reusing `out`
+// across calls costs no allocation at all; runs of ASCII, which is most of
+// any path or OCR text, move 16 bytes at a time with SSE2 or NEON.
+
+// True when every byte is below 0x80.
+bool IsAscii(const char* data, size_t length);
+
+// Replaces `out` with `utf8` as UTF-16. Invalid UTF-8 (bad or truncated
+// sequences, overlongs, surrogates, code points past U+10FFFF) clears `out`
+// and returns false, as MultiByteToWideChar does with MB_ERR_INVALID_CHARS.
+bool Utf8ToUtf16(std::string_view utf8, std::u16string& out);
+
+// Replaces `out` with `utf16` as UTF-8; unpaired surrogates become U+FFFD,
+// as WideCharToMultiByte does.
+void Utf16ToUtf8(const char16_t* utf16, size_t length, std::string& out);
+
+// wchar_t is UTF-16 on Windows and UTF-32 elsewhere; these take either.
+// Invalid UTF-8 gives an empty string; unpaired surrogates and code points
+// past U+10FFFF come back as U+FFFD.
+bool Utf8ToWide(std::string_view utf8, std::wstring& out);
+std::wstring Utf8ToWide(std::string_view utf8);
+void WideToUtf8(const wchar_t* wide, size_t length, std::string& out);
+std::string WideToUtf8(const wchar_t* wide, size_t length);
+std::string WideToUtf8(std::wstring_view wide);
+
+} // namespace tuff::native
@@ -1,580 +1,1236 @@
 #include <napi.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
-#if defined(_WIN32)
-#ifndef NOMINMAX
-#define NOMINMAX
-#endif
-#include <windows.h>
+#include "common/native_metrics_js.h"
+#include "everything/columnar_encoding.h"
+#include "everything/everything_sdk.h"
+#include "everything/result_cache.h"
+#include "everything/search_backend.h"
+#include "everything/search_executor.h"
+#include "everything/search_marshal.h"
+#include "everything/search_metrics.h"
+#include "everything/search_session.h"
+#include "everything/search_types.h"
+#include "everything/stat_batch.h"
+#include "everything/tree_scanner.h"
+
+#if defined(__linux__)
+#include "everything/fs_watcher.h"
+#include "everything/linux_index.h"
+#include "everything/locate_db.h"
 #endif
 
 namespace tuff::native::everything {
 
 namespace {
 
-constexpr uint32_t kDefaultMaxResults = 50;
-constexpr uint32_t kMaxResultsLimit = 5000;
-
-struct [[maybe_unused]] SearchOptions {
-  uint32_t maxResults = kDefaultMaxResults;
-  uint32_t offset = 0;
-  uint32_t sort = 3;
-  bool regex = false;
-  bool matchCase = false;
-  bool matchPath = false;
-  bool matchWholeWord = false;
-};
-
-[[maybe_unused]] void ThrowJsError(Napi::Env env, const std::string& message, const char* code) {
+Napi::Error MakeJsError(Napi::Env env, const std::string& message, const char* code) {
   auto error = Napi::Error::New(env, message);
   error.Value().Set("code", Napi::String::New(env, code));
-  error.ThrowAsJavaScriptException();
+  return error;
 }
 
-[[maybe_unused]] bool ParseSearchOptions(const Napi::CallbackInfo& info, SearchOptions& options) {
-  if (info.Length() < 2 || !info[1].IsObject()) {
-    return true;
+void ThrowJsError(Napi::Env env, const std::string& message, const char* code) {
+  MakeJsError(env, message, code).ThrowAsJavaScriptException();
+}
+
+// Options are the second argument of every search entry point.
+bool ParseSearchOptions(const Napi::CallbackInfo& info, SearchOptions& options) {
+  if (info.Length() >= 2 && info[1].IsObject()) {
+    ParseSearchOptions(info[1].As<Napi::Object>(), options);
   }
+  return true;
+}
 
-  auto rawOptions = info[1].As<Napi::Object>();
+#if defined(__linux__)
 
-  if (rawOptions.Has("maxResults") && rawOptions.Get("maxResults").IsNumber()) {
-    const int32_t maxResults = rawOptions.Get("maxResults").As<Napi::Number>().Int32Value();
-    options.maxResults = static_cast<uint32_t>(
-        std::clamp(maxResults, 1, static_cast<int32_t>(kMaxResultsLimit)));
+// Loads the snapshot, or starts the first build, if no search has done so yet:
+// callers probe the index before their first query and want it warm by then.
+Napi::Value GetIndexStatus(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  auto& index = LinuxFileIndex::Instance();
+  index.EnsureStarted();
+  const auto status = index.Status();
+
+  auto result = Napi::Object::New(env);
+  result.Set("state", Napi::String::New(env, status.state));
+  result.Set("entryCount", Napi::Number::New(env, static_cast<double>(status.entryCount)));
+  result.Set("scannedEntries", Napi::Number::New(env, static_cast<double>(status.scannedEntries)));
+  result.Set("builtAt", Napi::Number::New(env, static_cast<double>(status.builtAtMs)));
+  result.Set("loadMs", Napi::Number::New(env, status.loadMs));
+  result.Set("buildMs", Napi::Number::New(env, status.buildMs));
+  result.Set("fromSnapshot", Napi::Boolean::New(env, status.fromSnapshot));
+  result.Set("snapshotPath", Napi::String::New(env, status.snapshotPath));
+
+  auto roots = Napi::Array::New(env, status.roots.size());
+  for (size_t i = 0; i < status.roots.size(); ++i) {
+    roots.Set(static_cast<uint32_t>(i), Napi::String::New(env, status.roots[i]));
   }
+  result.Set("roots", roots);
 
-  if (rawOptions.Has("offset") && rawOptions.Get("offset").IsNumber()) {
-    const int32_t offset = rawOptions.Get("offset").As<Napi::Number>().Int32Value();
-    options.offset = static_cast<uint32_t>(std::max(offset, 0));
+  if (!status.lastError.empty()) {
+    result.Set("lastError", Napi::String::New(env, status.lastError));
   }
+  return result;
+}
 
-  if (rawOptions.Has("sort") && rawOptions.Get("sort").IsNumber()) {
-    const int32_t sort = rawOptions.Get("sort").As<Napi::Number>().Int32Value();
-    options.sort = static_cast<uint32_t>(std::max(sort, 0));
+std::vector<std::string> ReadStringArray(const Napi::Object& object, const char* key) {
+  std::vector<std::string> values;
+  if (!object.Has(key) || !object.Get(key).IsArray()) {
+    return values;
   }
 
-  if (rawOptions.Has("regex") && rawOptions.Get("regex").IsBoolean()) {
-    options.regex = rawOptions.Get("regex").As<Napi::Boolean>().Value();
+  const auto array = object.Get(key).As<Napi::Array>();
+  for (uint32_t i = 0; i < array.Length(); ++i) {
+    const auto value = array.Get(i);
+    if (value.IsString()) {
+      values.push_back(value.As<Napi::String>().Utf8Value());
+    }
   }
+  return values;
+}
 
-  if (rawOptions.Has("matchCase") && rawOptions.Get("matchCase").IsBoolean()) {
-    options.matchCase = rawOptions.Get("matchCase").As<Napi::Boolean>().Value();
+Napi::Value RebuildIndex(const Napi::CallbackInfo& info) {
+  IndexBuildOptions options;
+  if (info.Length() >= 1 && info[0].IsObject()) {
+    const auto rawOptions = info[0].As<Napi::Object>();
+    options.roots = ReadStringArray(rawOptions, "roots");
+    options.excludes = ReadStringArray(rawOptions, "excludes");
+    if (rawOptions.Has("snapshotPath") && rawOptions.Get("snapshotPath").IsString()) {
+      options.snapshotPath = rawOptions.Get("snapshotPath").As<Napi::String>().Utf8Value();
+    }
   }
 
-  if (rawOptions.Has("matchPath") && rawOptions.Get("matchPath").IsBoolean()) {
-    options.matchPath = rawOptions.Get("matchPath").As<Napi::Boolean>().Value();
+  LinuxFileIndex::Instance().Rebuild(std::move(options));
+  return GetIndexStatus(info);
+}
+
+#endif
+
+ResultFormat ParseResultFormat(const Napi::CallbackInfo& info) {
+  if (info.Length() < 2 || !info[1].IsObject()) {
+    return ResultFormat::kObjects;
   }
 
-  if (rawOptions.Has("matchWholeWord") && rawOptions.Get("matchWholeWord").IsBoolean()) {
-    options.matchWholeWord = rawOptions.Get("matchWholeWord").As<Napi::Boolean>().Value();
+  const auto rawOptions = info[1].As<Napi::Object>();
+  if (rawOptions.Has("format") && rawOptions.Get("format").IsString() &&
+      rawOptions.Get("format").As<Napi::String>().Utf8Value() == "columnar") {
+    return ResultFormat::kColumnar;
   }
+  return ResultFormat::kObjects;
+}
 
-  return true;
+Napi::ArrayBuffer ToColumnarBuffer(Napi::Env env, const std::vector<SearchRow>& rows,
+                                   uint32_t fields) {
+  auto buffer = Napi::ArrayBuffer::New(env, ColumnarByteLength(rows));
+  EncodeColumnar(rows, fields, static_cast<uint8_t*>(buffer.Data()));
+  return buffer;
 }
 
-#if defined(_WIN32)
+// Copies an encoding made off-thread into a JS-owned buffer. An external
+// ArrayBuffer would skip the memcpy, but Electron's V8 sandbox rejects
+// external backing stores, and one memcpy of the packed result is small next
+// to the per-row objects this format replaces.
+Napi::ArrayBuffer ToColumnarBuffer(Napi::Env env, const std::vector<uint8_t>& encoded) {
+  auto buffer = Napi::ArrayBuffer::New(env, encoded.size());
+  if (!encoded.empty()) {
+    std::memcpy(buffer.Data(), encoded.data(), encoded.size());
+  }
+  return buffer;
+}
 
-constexpr DWORD kEverythingRequestFileName = 0x00000001;
-constexpr DWORD kEverythingRequestPath = 0x00000002;
-constexpr DWORD kEverythingRequestFullPathAndFileName = 0x00000004;
-constexpr DWORD kEverythingRequestSize = 0x00000010;
-constexpr DWORD kEverythingRequestDateCreated = 0x00000020;
-constexpr DWORD kEverythingRequestDateModified = 0x00000040;
+Napi::Value Search(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
 
-constexpr uint64_t kWindowsEpochOffset100Ns = 116444736000000000ULL;
+  if (info.Length() < 1 || !info[0].IsString()) {
+    ThrowJsError(env, "Everything search expects a query string", "ERR_INVALID_ARGUMENT");
+    return env.Null();
+  }
 
-typedef void(WINAPI* Everything_SetSearchW_Fn)(LPCWSTR lpString);
-typedef void(WINAPI* Everything_SetRequestFlags_Fn)(DWORD dwRequestFlags);
-typedef void(WINAPI* Everything_SetSort_Fn)(DWORD dwSortType);
-typedef void(WINAPI* Everything_SetMax_Fn)(DWORD dwMax);
-typedef void(WINAPI* Everything_SetOffset_Fn)(DWORD dwOffset);
-typedef BOOL(WINAPI* Everything_QueryW_Fn)(BOOL bWait);
-typedef DWORD(WINAPI* Everything_GetLastError_Fn)();
-typedef DWORD(WINAPI* Everything_GetNumResults_Fn)();
-typedef LPCWSTR(WINAPI* Everything_GetResultFileNameW_Fn)(DWORD nIndex);
-typedef DWORD(WINAPI* Everything_GetResultFullPathNameW_Fn)(DWORD nIndex, LPWSTR lpString, DWORD nMaxCount);
-typedef BOOL(WINAPI* Everything_GetResultSize_Fn)(DWORD nIndex, PLARGE_INTEGER lpFileSize);
-typedef BOOL(WINAPI* Everything_GetResultDateModified_Fn)(DWORD nIndex, LPFILETIME lpFileTime);
-typedef BOOL(WINAPI* Everything_GetResultDateCreated_Fn)(DWORD nIndex, LPFILETIME lpFileTime);
-typedef BOOL(WINAPI* Everything_IsFolderResult_Fn)(DWORD nIndex);
-typedef void(WINAPI* Everything_SetMatchPath_Fn)(BOOL bEnable);
-typedef void(WINAPI* Everything_SetMatchCase_Fn)(BOOL bEnable);
-typedef void(WINAPI* Everything_SetMatchWholeWord_Fn)(BOOL bEnable);
-typedef void(WINAPI* Everything_SetRegex_Fn)(BOOL bEnable);
-typedef DWORD(WINAPI* Everything_GetMajorVersion_Fn)();
-typedef DWORD(WINAPI* Everything_GetMinorVersion_Fn)();
-typedef DWORD(WINAPI* Everything_GetRevision_Fn)();
-typedef DWORD(WINAPI* Everything_GetBuildNumber_Fn)();
+  SearchOptions options;
+  ParseSearchOptions(info, options);
 
-std::wstring ReadEnvVar(const wchar_t* key) {
-  const DWORD required = ::GetEnvironmentVariableW(key, nullptr, 0);
-  if (required == 0) {
-    return L"";
+  const auto query = info[0].As<Napi::String>().Utf8Value();
+  const auto format = ParseResultFormat(info);
+  std::vector<SearchRow> rows;
+  std::vector<uint8_t> columnar;
+  SearchError error;
+  if (!RunCachedSearch(query, options, format, rows, columnar, error)) {
+    ThrowJsError(env, error.message, error.code.c_str());
+    return env.Null();
   }
-
-  std::wstring value(required, L'\0');
-  const DWORD written = ::GetEnvironmentVariableW(key, value.data(), required);
-  if (written == 0) {
-    return L"";
+  ScopedStage marshal(SearchMetrics(), kSearchStageMarshal);
+  if (format == ResultFormat::kColumnar) {
+    return ToColumnarBuffer(env, columnar);
   }
+  return ToJsRows(env, rows, options.fields);
+}
 
-  value.resize(written);
-  return value;
+Napi::Value Query(const Napi::CallbackInfo& info) {
+  return Search(info);
 }
 
-std::wstring JoinPath(const std::wstring& base, const std::wstring& file) {
-  if (base.empty()) {
-    return file;
-  }
+// Settles the promise of one `searchAsync` call. Rows are built into JS objects
+// here, on the main thread, only for a job that actually delivered; superseded
+// and aborted jobs cost a rejection and nothing else.
+struct AsyncSearchContext {
+  explicit AsyncSearchContext(Napi::Env env) : deferred(Napi::Promise::Deferred::New(env)) {}
+
+  Napi::Promise::Deferred deferred;
+  ResultFormat format = ResultFormat::kObjects;
+  uint32_t fields = kAllFields;
+
+  // Set for search-session queries: a delivered answer becomes the session's
+  // base. The reference keeps the session object alive until then.
+  Napi::ObjectReference sessionRef;
+  SearchSessionCache* sessionCache = nullptr;
+  std::string query;
+  SearchOptions options;
+};
 
-  if (base.back() == L'\\' || base.back() == L'/') {
-    return base + file;
-  }
+void DeliverSearchResult(Napi::Env env, Napi::Function, AsyncSearchContext* context,
+                         SearchJobResult* result) {
+  if (env != nullptr && context != nullptr && result != nullptr) {
+    ScopedStage marshal(SearchMetrics(), kSearchStageMarshal);
+    if (result->ok && context->sessionCache != nullptr) {
+      context->sessionCache->Store(context->query, context->options, result->rows);
+    }
 
-  return base + L"\\" + file;
+    if (result->ok && context->format == ResultFormat::kColumnar) {
+      context->deferred.Resolve(result->columnar.empty()
+                                    ? ToColumnarBuffer(env, result->rows, context->fields)
+                                    : ToColumnarBuffer(env, result->columnar));
+    } else if (result->ok) {
+      context->deferred.Resolve(ToJsRows(env, result->rows, context->fields));
+    } else {
+      context->deferred.Reject(
+          MakeJsError(env, result->error.message, result->error.code.c_str()).Value());
+    }
+  }
+  if (env != nullptr && context != nullptr && !context->sessionRef.IsEmpty()) {
+    context->sessionRef.Reset();
+  }
+  delete result;
 }
 
-std::wstring Utf8ToWide(const std::string& value) {
-  if (value.empty()) {
-    return L"";
+using AsyncSearchTsfn =
+    Napi::TypedThreadSafeFunction<AsyncSearchContext, SearchJobResult, DeliverSearchResult>;
+
+uint64_t ParseRequestId(const Napi::CallbackInfo& info, size_t index) {
+  if (info.Length() <= index || !info[index].IsNumber()) {
+    return 0;
   }
+  return static_cast<uint64_t>(std::max(info[index].As<Napi::Number>().Int64Value(), int64_t{0}));
+}
 
-  const int needed = ::MultiByteToWideChar(
-      CP_UTF8,
-      MB_ERR_INVALID_CHARS,
-      value.c_str(),
-      static_cast<int>(value.size()),
+// Hands `job` to the executor; `context` is owned by the thread-safe function
+// from here on and settles the returned promise.
+Napi::Promise SubmitAsyncJob(Napi::Env env, SearchJob job, AsyncSearchContext* context) {
+  const auto promise = context->deferred.Promise();
+  auto tsfn = AsyncSearchTsfn::New(
+      env,
       nullptr,
-      0);
-  if (needed <= 0) {
-    return L"";
+      "tuffEverythingSearchAsync",
+      0,
+      1,
+      context,
+      [](Napi::Env, void*, AsyncSearchContext* finalizeContext) { delete finalizeContext; },
+      static_cast<void*>(nullptr));
+
+  job.complete = [tsfn](SearchJobResult&& result) mutable {
+    tsfn.BlockingCall(new SearchJobResult(std::move(result)));
+    tsfn.Release();
+  };
+
+  SearchExecutor::Instance().Submit(std::move(job));
+  return promise;
+}
+
+// searchAsync(query, options, requestId) -> Promise<row[]>
+//
+// `requestId` is chosen by everything.js so that an AbortSignal can name the
+// job in `cancelSearch` before the promise settles. `options.channel` groups
+// latest-wins jobs; callers that share the default channel supersede each
+// other.
+Napi::Value SearchAsync(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+
+  if (info.Length() < 1 || !info[0].IsString()) {
+    ThrowJsError(env, "Everything search expects a query string", "ERR_INVALID_ARGUMENT");
+    return env.Null();
   }
 
-  std::wstring wide(static_cast<size_t>(needed), L'\0');
-  const int converted = ::MultiByteToWideChar(
-      CP_UTF8,
-      MB_ERR_INVALID_CHARS,
-      value.c_str(),
-      static_cast<int>(value.size()),
-      wide.data(),
-      needed);
-  if (converted <= 0) {
-    return L"";
+  SearchJob job;
+  job.query = info[0].As<Napi::String>().Utf8Value();
+  ParseSearchOptions(info, job.options);
+  job.format = ParseResultFormat(info);
+  if (info.Length() >= 2 && info[1].IsObject()) {
+    const auto rawOptions = info[1].As<Napi::Object>();
+    if (rawOptions.Has("channel") && rawOptions.Get("channel").IsString()) {
+      job.channel = rawOptions.Get("channel").As<Napi::String>().Utf8Value();
+    }
+  }
+  job.requestId = ParseRequestId(info, 2);
+  if (job.requestId == 0) {
+    ThrowJsError(env, "Everything searchAsync expects a positive request id", "ERR_INVALID_ARGUMENT");
+    return env.Null();
   }
 
-  return wide;
+  auto* context = new AsyncSearchContext(env);
+  context->format = job.format;
+  context->fields = job.options.fields;
+  return SubmitAsyncJob(env, std::move(job), context);
 }
 
-std::string WideToUtf8(const std::wstring& value) {
-  if (value.empty()) {
-    return "";
+// Settles one `statBatch` call. The packed block is copied once into a JS
+// buffer and every column becomes a typed-array view over it.
+struct StatBatchContext {
+  explicit StatBatchContext(Napi::Env env) : deferred(Napi::Promise::Deferred::New(env)) {}
+
+  Napi::Promise::Deferred deferred;
+};
+
+Napi::Object ToStatBatchObject(Napi::Env env, const StatBatchResult& result) {
+  const size_t count = result.count;
+  auto buffer = ToColumnarBuffer(env, result.packed);
+  auto object = Napi::Object::New(env);
+  object.Set("count", Napi::Number::New(env, static_cast<double>(count)));
+  object.Set("engine", Napi::String::New(env, result.engine));
+  object.Set("size", Napi::Float64Array::New(env, count, buffer, StatBatchLayout::SizeOffset(count)));
+  object.Set("mtimeMs",
+             Napi::Float64Array::New(env, count, buffer, StatBatchLayout::MtimeOffset(count)));
+  object.Set("ctimeMs",
+             Napi::Float64Array::New(env, count, buffer, StatBatchLayout::CtimeOffset(count)));
+  object.Set("birthtimeMs",
+             Napi::Float64Array::New(env, count, buffer, StatBatchLayout::BirthtimeOffset(count)));
+  object.Set("errno", Napi::Int32Array::New(env, count, buffer, StatBatchLayout::ErrnoOffset(count)));
+  object.Set("flags", Napi::Uint8Array::New(env, count, buffer, StatBatchLayout::FlagsOffset(count)));
+  return object;
+}
+
+void DeliverStatBatch(Napi::Env env, Napi::Function, StatBatchContext* context,
+                      StatBatchResult* result) {
+  if (env != nullptr && context != nullptr && result != nullptr) {
+    context->deferred.Resolve(ToStatBatchObject(env, *result));
   }
+  delete result;
+}
 
-  const int needed = ::WideCharToMultiByte(
-      CP_UTF8,
-      0,
-      value.c_str(),
-      static_cast<int>(value.size()),
-      nullptr,
-      0,
-      nullptr,
-      nullptr);
-  if (needed <= 0) {
-    return "";
+using StatBatchTsfn = Napi::TypedThreadSafeFunction<StatBatchContext, StatBatchResult, DeliverStatBatch>;
+
+// statBatch(paths, { noFollow }) -> Promise<{ count, engine, size, mtimeMs, ... }>
+//
+// Resolves every path on the stat thread in one hop; see StatBatchExecutor.
+Napi::Value StatBatch(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+
+  if (info.Length() < 1 || !info[0].IsArray()) {
+    ThrowJsError(env, "statBatch expects an array of paths", "ERR_INVALID_ARGUMENT");
+    return env.Null();
   }
 
-  std::string utf8(static_cast<size_t>(needed), '\0');
-  const int converted = ::WideCharToMultiByte(
-      CP_UTF8,
-      0,
-      value.c_str(),
-      static_cast<int>(value.size()),
-      utf8.data(),
-      needed,
-      nullptr,
-      nullptr);
-  if (converted <= 0) {
-    return "";
+  StatBatchJob job;
+  const auto rawPaths = info[0].As<Napi::Array>();
+  job.paths.reserve(rawPaths.Length());
+  for (uint32_t i = 0; i < rawPaths.Length(); ++i) {
+    const auto value = rawPaths.Get(i);
+    if (!value.IsString()) {
+      ThrowJsError(env, "statBatch expects every path to be a string", "ERR_INVALID_ARGUMENT");
+      return env.Null();
+    }
+    job.paths.push_back(value.As<Napi::String>().Utf8Value());
+  }
+  if (info.Length() >= 2 && info[1].IsObject()) {
+    const auto options = info[1].As<Napi::Object>();
+    job.noFollow = options.Has("noFollow") && options.Get("noFollow").ToBoolean().Value();
   }
 
-  return utf8;
+  auto* context = new StatBatchContext(env);
+  const auto promise = context->deferred.Promise();
+  auto tsfn = StatBatchTsfn::New(
+      env,
+      nullptr,
+      "tuffEverythingStatBatch",
+      0,
+      1,
+      context,
+      [](Napi::Env, void*, StatBatchContext* finalizeContext) { delete finalizeContext; },
+      static_cast<void*>(nullptr));
+
+  job.complete = [tsfn](StatBatchResult&& result) mutable {
+    tsfn.BlockingCall(new StatBatchResult(std::move(result)));
+    tsfn.Release();
+  };
+
+  StatBatchExecutor::Instance().Submit(std::move(job));
+  return promise;
 }
 
-double FileTimeToUnixMillis(const FILETIME& fileTime) {
-  ULARGE_INTEGER value{};
-  value.LowPart = fileTime.dwLowDateTime;
-  value.HighPart = fileTime.dwHighDateTime;
+struct TreeScanMessage {
+  bool done = false;
+  TreeScanBatch batch;
+  TreeScanSummary summary;
+};
 
-  if (value.QuadPart <= kWindowsEpochOffset100Ns) {
-    return 0;
-  }
+struct TreeScanContext {
+  TreeScanContext(Napi::Env env, uint64_t requestId)
+      : deferred(Napi::Promise::Deferred::New(env)), requestId(requestId) {}
 
-  return static_cast<double>((value.QuadPart - kWindowsEpochOffset100Ns) / 10000ULL);
-}
+  Napi::Promise::Deferred deferred;
+  uint64_t requestId;
+};
 
-class EverythingApi {
+// Scans in flight by request id, for acknowledgeTreeScanBatch and
+// cancelSearch.
+class TreeScanRegistry {
  public:
-  static EverythingApi& Instance() {
-    static EverythingApi api;
-    return api;
+  static TreeScanRegistry& Instance() {
+    static auto* registry = new TreeScanRegistry();
+    return *registry;
   }
 
-  bool EnsureLoaded(std::string& errorMessage) {
-    if (loaded_) {
-      return true;
-    }
+  void Add(uint64_t requestId, std::shared_ptr<TreeScan> scan) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    scans_[requestId] = std::move(scan);
+  }
 
-    std::string lastError = "Everything SDK DLL not found";
-    for (const auto& candidate : BuildCandidatePaths()) {
-      if (candidate.empty()) {
-        continue;
-      }
+  void Remove(uint64_t requestId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    scans_.erase(requestId);
+  }
 
-      if (LoadFromPath(candidate, errorMessage)) {
-        return true;
-      }
+  std::shared_ptr<TreeScan> Find(uint64_t requestId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto found = scans_.find(requestId);
+    return found == scans_.end() ? nullptr : found->second;
+  }
 
-      if (!errorMessage.empty()) {
-        lastError = errorMessage;
-      }
-    }
+ private:
+  std::mutex mutex_;
+  std::unordered_map<uint64_t, std::shared_ptr<TreeScan>> scans_;
+};
 
-    errorMessage = lastError;
-    return false;
+Napi::Object ToTreeScanBatchObject(Napi::Env env, const TreeScanBatch& batch) {
+  const size_t count = batch.paths.size();
+  JsStrings strings(env);
+  auto paths = Napi::Array::New(env, count);
+  for (size_t i = 0; i < count; ++i) {
+    paths.Set(static_cast<uint32_t>(i), strings.New(batch.paths[i]));
   }
+  auto buffer = ToColumnarBuffer(env, batch.packed);
+  auto object = Napi::Object::New(env);
+  object.Set("count", Napi::Number::New(env, static_cast<double>(count)));
+  object.Set("paths", paths);
+  object.Set("size", Napi::Float64Array::New(env, count, buffer, TreeScanLayout::SizeOffset(count)));
+  object.Set("mtimeMs",
+             Napi::Float64Array::New(env, count, buffer, TreeScanLayout::MtimeOffset(count)));
+  object.Set("ctimeMs",
+             Napi::Float64Array::New(env, count, buffer, TreeScanLayout::CtimeOffset(count)));
+  object.Set("type", Napi::Uint8Array::New(env, count, buffer, TreeScanLayout::TypeOffset(count)));
+  return object;
+}
 
-  std::string GetVersion() const {
-    if (!loaded_) {
-      return "";
+void DeliverTreeScan(Napi::Env env, Napi::Function onBatch, TreeScanContext* context,
+                     TreeScanMessage* message) {
+  if (env != nullptr && context != nullptr && message != nullptr) {
+    if (!message->done) {
+      onBatch.Call({ToTreeScanBatchObject(env, message->batch)});
+    } else {
+      TreeScanRegistry::Instance().Remove(context->requestId);
+      const auto& summary = message->summary;
+      auto result = Napi::Object::New(env);
+      result.Set("entryCount", Napi::Number::New(env, static_cast<double>(summary.entryCount)));
+      result.Set("directoryCount",
+                 Napi::Number::New(env, static_cast<double>(summary.directoryCount)));
+      result.Set("errorCount", Napi::Number::New(env, static_cast<double>(summary.errorCount)));
+      result.Set("threads", Napi::Number::New(env, summary.threads));
+      result.Set("cancelled", Napi::Boolean::New(env, summary.cancelled));
+      result.Set("durationMs", Napi::Number::New(env, summary.durationMs));
+      context->deferred.Resolve(result);
     }
+  }
+  delete message;
+}
+
+using TreeScanTsfn = Napi::TypedThreadSafeFunction<TreeScanContext, TreeScanMessage, DeliverTreeScan>;
 
-    if (!version_.empty()) {
-      return version_;
+std::vector<std::string> ReadStringList(const Napi::Object& options, const char* key) {
+  std::vector<std::string> values;
+  if (!options.Has(key) || !options.Get(key).IsArray()) {
+    return values;
+  }
+  const auto array = options.Get(key).As<Napi::Array>();
+  values.reserve(array.Length());
+  for (uint32_t i = 0; i < array.Length(); ++i) {
+    const auto value = array.Get(i);
+    if (value.IsString()) {
+      values.push_back(value.As<Napi::String>().Utf8Value());
     }
+  }
+  return values;
+}
 
-    return "unknown";
+uint32_t ReadBoundedUint(const Napi::Object& options, const char* key, uint32_t fallback,
+                         int64_t min, int64_t max) {
+  if (!options.Has(key) || !options.Get(key).IsNumber()) {
+    return fallback;
   }
+  return static_cast<uint32_t>(
+      std::clamp(options.Get(key).As<Napi::Number>().Int64Value(), min, max));
+}
 
-  Everything_SetSearchW_Fn setSearch = nullptr;
-  Everything_SetRequestFlags_Fn setRequestFlags = nullptr;
-  Everything_SetSort_Fn setSort = nullptr;
-  Everything_SetMax_Fn setMax = nullptr;
-  Everything_SetOffset_Fn setOffset = nullptr;
-  Everything_QueryW_Fn query = nullptr;
-  Everything_GetLastError_Fn getLastError = nullptr;
-  Everything_GetNumResults_Fn getNumResults = nullptr;
-  Everything_GetResultFileNameW_Fn getResultFileName = nullptr;
-  Everything_GetResultFullPathNameW_Fn getResultFullPathName = nullptr;
-  Everything_GetResultSize_Fn getResultSize = nullptr;
-  Everything_GetResultDateModified_Fn getResultDateModified = nullptr;
-  Everything_GetResultDateCreated_Fn getResultDateCreated = nullptr;
-  Everything_IsFolderResult_Fn isFolderResult = nullptr;
-  Everything_SetMatchPath_Fn setMatchPath = nullptr;
-  Everything_SetMatchCase_Fn setMatchCase = nullptr;
-  Everything_SetMatchWholeWord_Fn setMatchWholeWord = nullptr;
-  Everything_SetRegex_Fn setRegex = nullptr;
+void ParseTreeScanOptions(const Napi::Object& raw, TreeScanOptions& options) {
+  options.threads = ReadBoundedUint(raw, "threads", 0, 0, TreeScan::kMaxScanThreads);
+  options.batchSize = ReadBoundedUint(raw, "batchSize", options.batchSize, 1, 65536);
+  options.maxPendingBatches =
+      ReadBoundedUint(raw, "maxPendingBatches", options.maxPendingBatches, 1, 1024);
+  options.includeDirectories =
+      raw.Has("includeDirectories") && raw.Get("includeDirectories").ToBoolean().Value();
+
+  auto& filter = options.filter;
+  filter.maxDepth = ReadBoundedUint(raw, "maxDepth", filter.maxDepth, 0, 4096);
+  if (raw.Has("skipHidden")) {
+    filter.skipHidden = raw.Get("skipHidden").ToBoolean().Value();
+  }
+  filter.requireExtension =
+      raw.Has("requireExtension") && raw.Get("requireExtension").ToBoolean().Value();
+  for (auto& value : ReadStringList(raw, "excludePaths")) {
+    filter.excludePaths.insert(std::move(value));
+  }
+  for (auto& value : ReadStringList(raw, "excludeNames")) {
+    filter.excludeNames.insert(std::move(value));
+  }
+  for (auto& value : ReadStringList(raw, "excludeNamesIgnoreCase")) {
+    filter.excludeFoldedNames.insert(std::move(value));
+  }
+  for (auto& value : ReadStringList(raw, "rootExcludeNamesIgnoreCase")) {
+    filter.rootExcludeFoldedNames.insert(std::move(value));
+  }
+  filter.excludeFoldedSuffixes = ReadStringList(raw, "excludeSuffixesIgnoreCase");
+  for (auto& value : ReadStringList(raw, "excludeExtensions")) {
+    filter.excludeExtensions.insert(std::move(value));
+  }
+  for (const auto& value : ReadStringList(raw, "excludeFilePrefixes")) {
+    if (!value.empty()) {
+      filter.excludeFilePrefixes.push_back(value.front());
+    }
+  }
+}
 
- private:
-  EverythingApi() = default;
+// scanTreeAsync(roots, options, requestId, onBatch) -> Promise<summary>
+//
+// Walks `roots` on TreeScan's threads and calls onBatch with
+// { count, paths, size, mtimeMs, ctimeMs, type } as batches fill. Each batch
+// must be acknowledged with acknowledgeTreeScanBatch(requestId) once it has
+// been consumed; cancelSearch(requestId) stops the walk.
+Napi::Value ScanTreeAsync(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  if (info.Length() < 1 || !info[0].IsArray()) {
+    ThrowJsError(env, "scanTreeAsync expects an array of root directories", "ERR_INVALID_ARGUMENT");
+    return env.Null();
+  }
+  const auto requestId = ParseRequestId(info, 2);
+  if (requestId == 0 || info.Length() < 4 || !info[3].IsFunction()) {
+    ThrowJsError(env, "scanTreeAsync expects a positive request id and a batch callback",
+                 "ERR_INVALID_ARGUMENT");
+    return env.Null();
+  }
 
-  template <typename T>
-  bool LoadRequired(const char* symbol, T& target, std::string& errorMessage) {
-    target = reinterpret_cast<T>(::GetProcAddress(module_, symbol));
-    if (target != nullptr) {
-      return true;
+  TreeScanOptions options;
+  const auto rawRoots = info[0].As<Napi::Array>();
+  for (uint32_t i = 0; i < rawRoots.Length(); ++i) {
+    const auto value = rawRoots.Get(i);
+    if (!value.IsString()) {
+      ThrowJsError(env, "scanTreeAsync expects every root to be a string", "ERR_INVALID_ARGUMENT");
+      return env.Null();
     }
+    options.roots.push_back(value.As<Napi::String>().Utf8Value());
+  }
+  if (info[1].IsObject()) {
+    ParseTreeScanOptions(info[1].As<Napi::Object>(), options);
+  }
+
+  auto* context = new TreeScanContext(env, requestId);
+  const auto promise = context->deferred.Promise();
+  auto tsfn = TreeScanTsfn::New(
+      env,
+      info[3].As<Napi::Function>(),
+      "tuffEverythingTreeScan",
+      0,
+      1,
+      context,
+      [](Napi::Env, void*, TreeScanContext* finalizeContext) { delete finalizeContext; },
+      static_cast<void*>(nullptr));
+
+  auto scan = TreeScan::Start(
+      std::move(options),
+      [tsfn](TreeScanBatch&& batch) mutable {
+        auto* message = new TreeScanMessage();
+        message->batch = std::move(batch);
+        if (tsfn.BlockingCall(message) != napi_ok) {
+          delete message;
+        }
+      },
+      [tsfn](const TreeScanSummary& summary) mutable {
+        auto* message = new TreeScanMessage();
+        message->done = true;
+        message->summary = summary;
+        if (tsfn.BlockingCall(message) != napi_ok) {
+          delete message;
+        }
+        tsfn.Release();
+      });
+  TreeScanRegistry::Instance().Add(requestId, std::move(scan));
+  return promise;
+}
+
+Napi::Value AcknowledgeTreeScanBatch(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  const auto scan = TreeScanRegistry::Instance().Find(ParseRequestId(info, 0));
+  if (scan) {
+    scan->Acknowledge();
+  }
+  return Napi::Boolean::New(env, scan != nullptr);
+}
 
-    errorMessage = std::string("Everything SDK missing symbol: ") + symbol;
+#if defined(__linux__)
+
+constexpr size_t kDefaultLocateBatchSize = 256;
+
+bool ParseLocateQuery(const Napi::CallbackInfo& info, LocateQuery& query) {
+  if (info.Length() < 1 || !info[0].IsString()) {
+    ThrowJsError(info.Env(), "locate expects a query string", "ERR_INVALID_ARGUMENT");
     return false;
   }
+  query.text = info[0].As<Napi::String>().Utf8Value();
+  ParseSearchOptions(info, query.options);
+  if (info.Length() >= 2 && info[1].IsObject()) {
+    const auto rawOptions = info[1].As<Napi::Object>();
+    if (rawOptions.Has("prefix") && rawOptions.Get("prefix").IsBoolean()) {
+      query.prefix = rawOptions.Get("prefix").As<Napi::Boolean>().Value();
+    }
+  }
+  return true;
+}
 
-  template <typename T>
-  void LoadOptional(const char* symbol, T& target) {
-    target = reinterpret_cast<T>(::GetProcAddress(module_, symbol));
+Napi::Value Locate(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  LocateQuery query;
+  if (!ParseLocateQuery(info, query)) {
+    return env.Null();
   }
 
-  bool ResolveRequiredSymbols(std::string& errorMessage) {
-    return LoadRequired("Everything_SetSearchW", setSearch, errorMessage) &&
-        LoadRequired("Everything_SetRequestFlags", setRequestFlags, errorMessage) &&
-        LoadRequired("Everything_SetMax", setMax, errorMessage) &&
-        LoadRequired("Everything_SetOffset", setOffset, errorMessage) &&
-        LoadRequired("Everything_QueryW", query, errorMessage) &&
-        LoadRequired("Everything_GetLastError", getLastError, errorMessage) &&
-        LoadRequired("Everything_GetNumResults", getNumResults, errorMessage) &&
-        LoadRequired("Everything_GetResultFileNameW", getResultFileName, errorMessage) &&
-        LoadRequired("Everything_GetResultFullPathNameW", getResultFullPathName, errorMessage);
+  std::vector<SearchRow> rows;
+  SearchError error;
+  const bool ok = LocateDatabase::Instance().Search(
+      query, SIZE_MAX,
+      [&rows](std::vector<SearchRow>& batch) {
+        rows = std::move(batch);
+        return true;
+      },
+      error);
+  if (!ok) {
+    ThrowJsError(env, error.message, error.code.c_str());
+    return env.Null();
   }
+  if (ParseResultFormat(info) == ResultFormat::kColumnar) {
+    return ToColumnarBuffer(env, rows, query.options.fields);
+  }
+  return ToJsRows(env, rows, query.options.fields);
+}
 
-  bool LoadFromPath(const std::wstring& candidate, std::string& errorMessage) {
-    module_ = ::LoadLibraryW(candidate.c_str());
-    if (module_ == nullptr) {
-      const DWORD winErr = ::GetLastError();
-      errorMessage = "Unable to load Everything SDK DLL from candidate (winerr=" +
-          std::to_string(winErr) + ")";
-      return false;
-    }
+// Streams one locate query from the libuv pool: every batch is handed to
+// `onBatch` on the JS thread as it fills, and the promise resolves with the
+// number of rows delivered. Cancelling stops the scan at the next batch.
+class LocateStreamWorker : public Napi::AsyncProgressQueueWorker<SearchRow> {
+ public:
+  LocateStreamWorker(Napi::Env env, LocateQuery query, size_t batchSize, uint64_t requestId,
+                     Napi::Function onBatch)
+      : Napi::AsyncProgressQueueWorker<SearchRow>(env),
+        deferred_(Napi::Promise::Deferred::New(env)),
+        query_(std::move(query)),
+        batchSize_(batchSize),
+        requestId_(requestId),
+        onBatch_(Napi::Persistent(onBatch)) {
+    std::lock_guard<std::mutex> lock(StreamsMutex());
+    Streams()[requestId_] = &cancelled_;
+  }
 
-    if (!ResolveRequiredSymbols(errorMessage)) {
-      ::FreeLibrary(module_);
-      module_ = nullptr;
+  ~LocateStreamWorker() override { Unregister(); }
+
+  Napi::Promise Promise() const { return deferred_.Promise(); }
+
+  static bool Cancel(uint64_t requestId) {
+    std::lock_guard<std::mutex> lock(StreamsMutex());
+    const auto found = Streams().find(requestId);
+    if (found == Streams().end()) {
       return false;
     }
+    found->second->store(true, std::memory_order_relaxed);
+    return true;
+  }
 
-    LoadOptional("Everything_SetSort", setSort);
-    LoadOptional("Everything_GetResultSize", getResultSize);
-    LoadOptional("Everything_GetResultDateModified", getResultDateModified);
-    LoadOptional("Everything_GetResultDateCreated", getResultDateCreated);
-    LoadOptional("Everything_IsFolderResult", isFolderResult);
-    LoadOptional("Everything_SetMatchPath", setMatchPath);
-    LoadOptional("Everything_SetMatchCase", setMatchCase);
-    LoadOptional("Everything_SetMatchWholeWord", setMatchWholeWord);
-    LoadOptional("Everything_SetRegex", setRegex);
+  void Execute(const ExecutionProgress& progress) override {
+    const bool ok = LocateDatabase::Instance().Search(
+        query_, batchSize_,
+        [&](std::vector<SearchRow>& batch) {
+          if (cancelled_.load(std::memory_order_relaxed)) {
+            return false;
+          }
+          progress.Send(batch.data(), batch.size());
+          delivered_ += batch.size();
+          return true;
+        },
+        error_);
+    if (!ok) {
+      SetError(error_.message);
+    }
+  }
 
-    Everything_GetMajorVersion_Fn getMajorVersion = nullptr;
-    Everything_GetMinorVersion_Fn getMinorVersion = nullptr;
-    Everything_GetRevision_Fn getRevision = nullptr;
-    Everything_GetBuildNumber_Fn getBuildNumber = nullptr;
+  void OnProgress(const SearchRow* rows, size_t count) override {
+    auto env = Env();
+    Napi::HandleScope scope(env);
+    JsStrings strings(env);
+    auto batch = Napi::Array::New(env, count);
+    for (size_t i = 0; i < count; ++i) {
+      batch.Set(static_cast<uint32_t>(i), ToJsRow(env, rows[i], query_.options.fields, strings));
+    }
+    onBatch_.Call({batch});
+  }
 
-    LoadOptional("Everything_GetMajorVersion", getMajorVersion);
-    LoadOptional("Everything_GetMinorVersion", getMinorVersion);
-    LoadOptional("Everything_GetRevision", getRevision);
-    LoadOptional("Everything_GetBuildNumber", getBuildNumber);
+  void OnOK() override {
+    Unregister();
+    deferred_.Resolve(Napi::Number::New(Env(), static_cast<double>(delivered_)));
+  }
 
-    if (getMajorVersion && getMinorVersion && getRevision && getBuildNumber) {
-      version_ = std::to_string(getMajorVersion()) + "." +
-          std::to_string(getMinorVersion()) + "." +
-          std::to_string(getRevision()) + "." +
-          std::to_string(getBuildNumber());
-    }
+  void OnError(const Napi::Error&) override {
+    Unregister();
+    deferred_.Reject(MakeJsError(Env(), error_.message, error_.code.c_str()).Value());
+  }
 
-    loaded_ = true;
-    return true;
+ private:
+  static std::mutex& StreamsMutex() {
+    static auto* mutex = new std::mutex();
+    return *mutex;
   }
 
-  std::vector<std::wstring> BuildCandidatePaths() const {
-    std::vector<std::wstring> candidates;
+  static std::unordered_map<uint64_t, std::atomic<bool>*>& Streams() {
+    static auto* streams = new std::unordered_map<uint64_t, std::atomic<bool>*>();
+    return *streams;
+  }
 
-    const auto customDllPath = ReadEnvVar(L"TALEX_EVERYTHING_DLL_PATH");
-    if (!customDllPath.empty()) {
-      candidates.push_back(customDllPath);
+  void Unregister() {
+    std::lock_guard<std::mutex> lock(StreamsMutex());
+    const auto found = Streams().find(requestId_);
+    if (found != Streams().end() && found->second == &cancelled_) {
+      Streams().erase(found);
     }
+  }
 
-#if defined(_WIN64)
-    candidates.push_back(L"Everything64.dll");
-#else
-    candidates.push_back(L"Everything32.dll");
-#endif
-    candidates.push_back(L"Everything.dll");
+  Napi::Promise::Deferred deferred_;
+  LocateQuery query_;
+  size_t batchSize_;
+  uint64_t requestId_;
+  Napi::FunctionReference onBatch_;
+  std::atomic<bool> cancelled_{false};
+  size_t delivered_ = 0;
+  SearchError error_;
+};
 
-    const auto programFiles = ReadEnvVar(L"PROGRAMFILES");
-    const auto programFilesX86 = ReadEnvVar(L"PROGRAMFILES(X86)");
-    if (!programFiles.empty()) {
-      candidates.push_back(JoinPath(programFiles, L"Everything\\Everything64.dll"));
-      candidates.push_back(JoinPath(programFiles, L"Everything\\Everything.dll"));
-      candidates.push_back(JoinPath(programFiles, L"Everything\\Everything32.dll"));
-    }
-    if (!programFilesX86.empty()) {
-      candidates.push_back(JoinPath(programFilesX86, L"Everything\\Everything32.dll"));
-      candidates.push_back(JoinPath(programFilesX86, L"Everything\\Everything.dll"));
+// locateAsync(query, options, requestId, onBatch) -> Promise<number>
+Napi::Value LocateAsync(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  LocateQuery query;
+  if (!ParseLocateQuery(info, query)) {
+    return env.Null();
+  }
+  const auto requestId = ParseRequestId(info, 2);
+  if (requestId == 0 || info.Length() < 4 || !info[3].IsFunction()) {
+    ThrowJsError(env, "locateAsync expects a positive request id and a batch callback",
+                 "ERR_INVALID_ARGUMENT");
+    return env.Null();
+  }
+
+  // maxResults' default of 50 is for one-shot searches; a stream runs to the
+  // end of the database unless the caller caps it.
+  bool capped = false;
+  size_t batchSize = kDefaultLocateBatchSize;
+  if (info[1].IsObject()) {
+    const auto rawOptions = info[1].As<Napi::Object>();
+    capped = rawOptions.Has("maxResults") && rawOptions.Get("maxResults").IsNumber();
+    if (rawOptions.Has("batchSize") && rawOptions.Get("batchSize").IsNumber()) {
+      batchSize = static_cast<size_t>(std::clamp<int64_t>(
+          rawOptions.Get("batchSize").As<Napi::Number>().Int64Value(), 1, kMaxResultsLimit));
     }
+  }
+  if (!capped) {
+    query.options.maxResults = UINT32_MAX;
+  }
+
+  auto* worker = new LocateStreamWorker(env, std::move(query), batchSize, requestId,
+                                        info[3].As<Napi::Function>());
+  const auto promise = worker->Promise();
+  worker->Queue();
+  return promise;
+}
 
-    return candidates;
+// Loads the database in the background on first call, so probing it at
+// startup leaves it warm for the first query.
+Napi::Value GetLocateStatus(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  const auto status = LocateDatabase::Instance().Status();
+
+  auto result = Napi::Object::New(env);
+  result.Set("state", Napi::String::New(env, status.state));
+  result.Set("databasePath", Napi::String::New(env, status.databasePath));
+  result.Set("format", Napi::String::New(env, status.format));
+  result.Set("entryCount", Napi::Number::New(env, static_cast<double>(status.entryCount)));
+  result.Set("directoryCount", Napi::Number::New(env, static_cast<double>(status.directoryCount)));
+  result.Set("checkVisibility", Napi::Boolean::New(env, status.checkVisibility));
+  result.Set("databaseModified", Napi::Number::New(env, static_cast<double>(status.databaseModifiedMs)));
+  result.Set("loadMs", Napi::Number::New(env, status.loadMs));
+  if (!status.lastError.empty()) {
+    result.Set("lastError", Napi::String::New(env, status.lastError));
+    result.Set("errorCode", Napi::String::New(env, status.errorCode));
   }
+  return result;
+}
 
-  HMODULE module_ = nullptr;
-  bool loaded_ = false;
-  std::string version_;
-};
+const char* WatchActionName(WatchAction action) {
+  switch (action) {
+    case WatchAction::kAdd:
+      return "add";
+    case WatchAction::kChange:
+      return "change";
+    case WatchAction::kDelete:
+      return "delete";
+    case WatchAction::kOverflow:
+      return "overflow";
+  }
+  return "change";
+}
 
-std::wstring GetResultFullPath(EverythingApi& api, DWORD index) {
-  std::vector<wchar_t> buffer(4096, L'\0');
+void DeliverWatchBatch(Napi::Env env, Napi::Function callback, std::nullptr_t*,
+                       std::vector<WatchEvent>* batch) {
+  if (env != nullptr && callback && batch != nullptr) {
+    auto events = Napi::Array::New(env, batch->size());
+    for (size_t i = 0; i < batch->size(); ++i) {
+      const auto& event = (*batch)[i];
+      auto item = Napi::Object::New(env);
+      item.Set("action", Napi::String::New(env, WatchActionName(event.action)));
+      item.Set("rawPath", Napi::String::New(env, event.path));
+      item.Set("isDirectory", Napi::Boolean::New(env, event.isDirectory));
+      events.Set(static_cast<uint32_t>(i), item);
+    }
+    callback.Call({events});
+  }
+  delete batch;
+}
+
+using WatchTsfn = Napi::TypedThreadSafeFunction<std::nullptr_t, std::vector<WatchEvent>, DeliverWatchBatch>;
+
+// new FsWatcher(onEvents, { backend, latencyMs, maxBatch })
+//
+// onEvents receives arrays of { action, rawPath, isDirectory } on the JS
+// thread; see FsWatcher for how they are produced. The watcher keeps the
+// event loop alive until close().
+class FsWatcherWrap : public Napi::ObjectWrap<FsWatcherWrap> {
+ public:
+  static Napi::Function DefineClass(Napi::Env env) {
+    return ObjectWrap<FsWatcherWrap>::DefineClass(
+        env,
+        "FsWatcher",
+        {
+            InstanceMethod("add", &FsWatcherWrap::Add),
+            InstanceMethod("remove", &FsWatcherWrap::Remove),
+            InstanceMethod("close", &FsWatcherWrap::Close),
+            InstanceMethod("getStats", &FsWatcherWrap::GetStats),
+        });
+  }
 
-  while (true) {
-    const DWORD copied = api.getResultFullPathName(index, buffer.data(), static_cast<DWORD>(buffer.size()));
-    if (copied == 0) {
-      return L"";
+  explicit FsWatcherWrap(const Napi::CallbackInfo& info) : Napi::ObjectWrap<FsWatcherWrap>(info) {
+    auto env = info.Env();
+    if (info.Length() < 1 || !info[0].IsFunction()) {
+      ThrowJsError(env, "FsWatcher expects an event callback", "ERR_INVALID_ARGUMENT");
+      return;
     }
 
-    if (copied < buffer.size()) {
-      return std::wstring(buffer.data(), copied);
+    FsWatcherOptions options;
+    if (info.Length() >= 2 && info[1].IsObject()) {
+      const auto raw = info[1].As<Napi::Object>();
+      if (raw.Has("backend") && raw.Get("backend").IsString()) {
+        const auto backend = raw.Get("backend").As<Napi::String>().Utf8Value();
+        if (backend == "fanotify") {
+          options.backend = WatchBackend::kFanotify;
+        } else if (backend == "inotify") {
+          options.backend = WatchBackend::kInotify;
+        } else if (backend != "auto") {
+          ThrowJsError(env, "FsWatcher backend must be auto, fanotify or inotify", "ERR_INVALID_ARGUMENT");
+          return;
+        }
+      }
+      if (raw.Has("latencyMs") && raw.Get("latencyMs").IsNumber()) {
+        options.latencyMs = static_cast<uint32_t>(
+            std::clamp(raw.Get("latencyMs").As<Napi::Number>().Int64Value(), int64_t{0}, int64_t{60000}));
+      }
+      if (raw.Has("maxBatch") && raw.Get("maxBatch").IsNumber()) {
+        options.maxBatch = static_cast<uint32_t>(
+            std::clamp(raw.Get("maxBatch").As<Napi::Number>().Int64Value(), int64_t{1}, int64_t{1} << 20));
+      }
     }
 
-    buffer.resize(static_cast<size_t>(copied) + 1U, L'\0');
+    tsfn_ = WatchTsfn::New(env, info[0].As<Napi::Function>(), "tuffEverythingWatch", 0, 1);
+    auto tsfn = tsfn_;
+    watcher_ = std::make_unique<FsWatcher>(options, [tsfn](std::vector<WatchEvent>&& batch) mutable {
+      auto* data = new std::vector<WatchEvent>(std::move(batch));
+      if (tsfn.NonBlockingCall(data) != napi_ok) {
+        delete data;
+      }
+    });
   }
-}
 
-Napi::Value SearchWindows(const Napi::CallbackInfo& info) {
-  auto env = info.Env();
+  ~FsWatcherWrap() override { Shutdown(); }
 
-  if (info.Length() < 1 || !info[0].IsString()) {
-    ThrowJsError(env, "Everything search expects a query string", "ERR_INVALID_ARGUMENT");
-    return env.Null();
+ private:
+  bool EnsureOpen(Napi::Env env) {
+    if (!watcher_ || closed_) {
+      ThrowJsError(env, "FsWatcher is closed", "ERR_EVERYTHING_WATCHER_CLOSED");
+      return false;
+    }
+    return true;
   }
 
-  SearchOptions options;
-  ParseSearchOptions(info, options);
+  // add(root, depth) -> undefined; throws with `code` set to the errno name
+  // when the root cannot be watched.
+  Napi::Value Add(const Napi::CallbackInfo& info) {
+    auto env = info.Env();
+    if (!EnsureOpen(env)) {
+      return env.Undefined();
+    }
+    if (info.Length() < 1 || !info[0].IsString()) {
+      ThrowJsError(env, "FsWatcher.add expects a directory path", "ERR_INVALID_ARGUMENT");
+      return env.Undefined();
+    }
+    const auto root = info[0].As<Napi::String>().Utf8Value();
+    uint32_t depth = 4;
+    if (info.Length() >= 2 && info[1].IsNumber()) {
+      depth = static_cast<uint32_t>(
+          std::clamp(info[1].As<Napi::Number>().Int64Value(), int64_t{0}, int64_t{64}));
+    }
 
-  const auto query = info[0].As<Napi::String>().Utf8Value();
-  if (query.empty()) {
-    return Napi::Array::New(env, 0);
+    std::string error;
+    if (!watcher_->AddRoot(root, depth, error)) {
+      ThrowJsError(env, "Cannot watch " + root + ": " + error, error.c_str());
+    }
+    return env.Undefined();
   }
 
-  std::string loadError;
-  auto& api = EverythingApi::Instance();
-  if (!api.EnsureLoaded(loadError)) {
-    ThrowJsError(
-        env,
-        "Everything SDK is unavailable: " + loadError,
-        "ERR_EVERYTHING_SDK_UNAVAILABLE");
-    return env.Null();
+  Napi::Value Remove(const Napi::CallbackInfo& info) {
+    auto env = info.Env();
+    if (!EnsureOpen(env)) {
+      return env.Undefined();
+    }
+    if (info.Length() < 1 || !info[0].IsString()) {
+      ThrowJsError(env, "FsWatcher.remove expects a directory path", "ERR_INVALID_ARGUMENT");
+      return env.Undefined();
+    }
+    watcher_->RemoveRoot(info[0].As<Napi::String>().Utf8Value());
+    return env.Undefined();
   }
 
-  const auto wideQuery = Utf8ToWide(query);
-  if (wideQuery.empty()) {
-    ThrowJsError(env, "Failed to convert query string to UTF-16", "ERR_EVERYTHING_QUERY_ENCODING");
-    return env.Null();
+  Napi::Value Close(const Napi::CallbackInfo& info) {
+    Shutdown();
+    return info.Env().Undefined();
   }
 
-  api.setSearch(wideQuery.c_str());
-
-  DWORD requestFlags =
-      kEverythingRequestFileName |
-      kEverythingRequestPath |
-      kEverythingRequestFullPathAndFileName |
-      kEverythingRequestSize |
-      kEverythingRequestDateModified |
-      kEverythingRequestDateCreated;
-  api.setRequestFlags(requestFlags);
+  Napi::Value GetStats(const Napi::CallbackInfo& info) {
+    auto env = info.Env();
+    const auto stats = watcher_ ? watcher_->Stats() : FsWatcherStats{};
+    auto result = Napi::Object::New(env);
+    result.Set("backend", Napi::String::New(env, stats.backend));
+    result.Set("roots", Napi::Number::New(env, static_cast<double>(stats.roots)));
+    result.Set("watches", Napi::Number::New(env, static_cast<double>(stats.watches)));
+    result.Set("rawEvents", Napi::Number::New(env, static_cast<double>(stats.rawEvents)));
+    result.Set("deliveredEvents", Napi::Number::New(env, static_cast<double>(stats.deliveredEvents)));
+    result.Set("batches", Napi::Number::New(env, static_cast<double>(stats.batches)));
+    result.Set("overflows", Napi::Number::New(env, static_cast<double>(stats.overflows)));
+    result.Set("closed", Napi::Boolean::New(env, closed_));
+    if (!stats.lastError.empty()) {
+      result.Set("lastError", Napi::String::New(env, stats.lastError));
+    }
+    return result;
+  }
 
-  if (api.setSort != nullptr) {
-    api.setSort(options.sort);
+  // Joins the watcher thread before releasing the callback, so no batch can
+  // be queued against a released function.
+  void Shutdown() {
+    if (closed_ || !watcher_) {
+      return;
+    }
+    closed_ = true;
+    watcher_->Close();
+    tsfn_.Release();
   }
 
-  api.setMax(options.maxResults);
-  api.setOffset(options.offset);
+  WatchTsfn tsfn_;
+  std::unique_ptr<FsWatcher> watcher_;
+  bool closed_ = false;
+};
+
+#endif
+
+// nextRequestId() -> number
+//
+// Ids for searchAsync, locateAsync and scanTreeAsync. The registries
+// cancelSearch looks them up in are process-wide, so they are handed out here
+// rather than counted per JS realm, where a worker thread and the main thread
+// would both start at 1 and cancel each other's requests.
+Napi::Value NextRequestId(const Napi::CallbackInfo& info) {
+  static std::atomic<uint64_t> nextRequestId{1};
+  // Stays a safe integer for JS; 2^53 requests will not happen.
+  return Napi::Number::New(info.Env(), static_cast<double>(nextRequestId.fetch_add(1, std::memory_order_relaxed)));
+}
 
-  if (api.setMatchCase != nullptr) {
-    api.setMatchCase(options.matchCase ? TRUE : FALSE);
+Napi::Value CancelSearch(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  if (info.Length() < 1 || !info[0].IsNumber()) {
+    return Napi::Boolean::New(env, false);
   }
-  if (api.setMatchPath != nullptr) {
-    api.setMatchPath(options.matchPath ? TRUE : FALSE);
+
+  const auto requestId = info[0].As<Napi::Number>().Int64Value();
+  if (requestId <= 0) {
+    return Napi::Boolean::New(env, false);
   }
-  if (api.setMatchWholeWord != nullptr) {
-    api.setMatchWholeWord(options.matchWholeWord ? TRUE : FALSE);
+  if (const auto scan = TreeScanRegistry::Instance().Find(static_cast<uint64_t>(requestId))) {
+    scan->Cancel();
+    return Napi::Boolean::New(env, true);
   }
-  if (api.setRegex != nullptr) {
-    api.setRegex(options.regex ? TRUE : FALSE);
+#if defined(__linux__)
+  if (LocateStreamWorker::Cancel(static_cast<uint64_t>(requestId))) {
+    return Napi::Boolean::New(env, true);
   }
+#endif
+  return Napi::Boolean::New(env, SearchExecutor::Instance().Cancel(static_cast<uint64_t>(requestId)));
+}
 
-  if (!api.query(TRUE)) {
-    const DWORD errCode = api.getLastError ? api.getLastError() : 0;
-    ThrowJsError(
+// Stateful typeahead search, see SearchSessionCache. Each session has its own
+// latest-wins channel, so a keystroke only supersedes its own session's
+// queries, and an answer served from the cache supersedes them too: a late
+// backend answer for an older prefix must not land after a newer one.
+class SearchSession : public Napi::ObjectWrap<SearchSession> {
+ public:
+  static Napi::Function DefineClass(Napi::Env env) {
+    return ObjectWrap<SearchSession>::DefineClass(
         env,
-        "Everything query failed, error code: " + std::to_string(errCode),
-        "ERR_EVERYTHING_QUERY_FAILED");
-    return env.Null();
+        "SearchSession",
+        {
+            InstanceMethod("search", &SearchSession::Search),
+            InstanceMethod("searchAsync", &SearchSession::SearchAsync),
+            InstanceMethod("reset", &SearchSession::Reset),
+            InstanceMethod("getStats", &SearchSession::GetStats),
+        });
   }
 
-  const DWORD total = api.getNumResults();
-  auto resultArray = Napi::Array::New(env, total);
+  explicit SearchSession(const Napi::CallbackInfo& info) : Napi::ObjectWrap<SearchSession>(info) {
+    static std::atomic<uint64_t> nextSession{1};
+    channel_ = "session:" + std::to_string(nextSession.fetch_add(1));
+  }
 
-  uint32_t jsIndex = 0;
-  for (DWORD i = 0; i < total; ++i) {
-    std::wstring fullPathWide = GetResultFullPath(api, i);
+ private:
+  bool ParseCall(const Napi::CallbackInfo& info, std::string& query, SearchOptions& fetch,
+                 uint32_t& fields) {
+    if (info.Length() < 1 || !info[0].IsString()) {
+      ThrowJsError(info.Env(), "Everything search expects a query string", "ERR_INVALID_ARGUMENT");
+      return false;
+    }
+    query = info[0].As<Napi::String>().Utf8Value();
+    ParseSearchOptions(info, fetch);
+    fields = fetch.fields;
+    fetch.fields |= SearchSessionCache::kRequiredFields;
+    return true;
+  }
 
-    const wchar_t* rawName = api.getResultFileName(i);
-    std::wstring nameWide = rawName != nullptr ? std::wstring(rawName) : std::wstring();
+  Napi::Value ToResult(Napi::Env env, const std::vector<SearchRow>& rows, ResultFormat format,
+                       uint32_t fields) {
+    ScopedStage marshal(SearchMetrics(), kSearchStageMarshal);
+    if (format == ResultFormat::kColumnar) {
+      return ToColumnarBuffer(env, rows, fields);
+    }
+    return ToJsRows(env, rows, fields);
+  }
 
-    if (fullPathWide.empty() && nameWide.empty()) {
-      continue;
+  Napi::Value Search(const Napi::CallbackInfo& info) {
+    auto env = info.Env();
+    std::string query;
+    SearchOptions fetch;
+    uint32_t fields = kAllFields;
+    if (!ParseCall(info, query, fetch, fields)) {
+      return env.Null();
     }
 
-    if (nameWide.empty()) {
-      const auto sep = fullPathWide.find_last_of(L"\\/");
-      if (sep != std::wstring::npos && sep + 1 < fullPathWide.size()) {
-        nameWide = fullPathWide.substr(sep + 1);
-      } else {
-        nameWide = fullPathWide;
+    SearchExecutor::Instance().SupersedeChannel(channel_);
+    std::vector<SearchRow> rows;
+    if (!cache_.TryNarrow(query, fetch, rows)) {
+      std::vector<uint8_t> unused;
+      SearchError error;
+      if (!RunCachedSearch(query, fetch, ResultFormat::kObjects, rows, unused, error)) {
+        ThrowJsError(env, error.message, error.code.c_str());
+        return env.Null();
       }
+      cache_.Store(query, fetch, rows);
     }
+    return ToResult(env, rows, ParseResultFormat(info), fields);
+  }
 
-    std::wstring pathWide;
-    if (!fullPathWide.empty()) {
-      const auto sep = fullPathWide.find_last_of(L"\\/");
-      if (sep != std::wstring::npos) {
-        pathWide = fullPathWide.substr(0, sep);
-      }
+  // searchAsync(query, options, requestId) -> Promise, like the module-level
+  // searchAsync but answered synchronously whenever the cache narrows.
+  Napi::Value SearchAsync(const Napi::CallbackInfo& info) {
+    auto env = info.Env();
+    std::string query;
+    SearchOptions fetch;
+    uint32_t fields = kAllFields;
+    if (!ParseCall(info, query, fetch, fields)) {
+      return env.Null();
+    }
+    const auto format = ParseResultFormat(info);
+
+    std::vector<SearchRow> rows;
+    if (cache_.TryNarrow(query, fetch, rows)) {
+      SearchExecutor::Instance().SupersedeChannel(channel_);
+      auto deferred = Napi::Promise::Deferred::New(env);
+      deferred.Resolve(ToResult(env, rows, format, fields));
+      return deferred.Promise();
     }
 
-    std::wstring extensionWide;
-    const auto dotPos = nameWide.find_last_of(L'.');
-    if (dotPos != std::wstring::npos && dotPos + 1 < nameWide.size()) {
-      extensionWide = nameWide.substr(dotPos + 1);
+    SearchJob job;
+    job.requestId = ParseRequestId(info, 2);
+    if (job.requestId == 0) {
+      ThrowJsError(env, "Everything searchAsync expects a positive request id", "ERR_INVALID_ARGUMENT");
+      return env.Null();
     }
+    job.channel = channel_;
+    job.query = query;
+    job.options = fetch;
+
+    auto* context = new AsyncSearchContext(env);
+    context->format = format;
+    context->fields = fields;
+    context->sessionRef = Napi::Persistent(Value());
+    context->sessionCache = &cache_;
+    context->query = std::move(query);
+    context->options = fetch;
+    return SubmitAsyncJob(env, std::move(job), context);
+  }
 
+  Napi::Value Reset(const Napi::CallbackInfo& info) {
+    SearchExecutor::Instance().SupersedeChannel(channel_);
+    cache_.Clear();
+    return info.Env().Undefined();
+  }
+
+  Napi::Value GetStats(const Napi::CallbackInfo& info) {
+    auto env = info.Env();
+    const auto stats = cache_.GetStats();
     auto result = Napi::Object::New(env);
-    result.Set("fullPath", Napi::String::New(env, WideToUtf8(fullPathWide)));
-    result.Set("path", Napi::String::New(env, WideToUtf8(pathWide)));
-
-    const auto nameUtf8 = WideToUtf8(nameWide);
-    result.Set("name", Napi::String::New(env, nameUtf8));
-    result.Set("filename", Napi::String::New(env, nameUtf8));
-    result.Set("extension", Napi::String::New(env, WideToUtf8(extensionWide)));
-
-    if (api.getResultSize != nullptr) {
-      LARGE_INTEGER fileSize{};
-      if (api.getResultSize(i, &fileSize)) {
-        result.Set("size", Napi::Number::New(env, static_cast<double>(fileSize.QuadPart)));
-      }
-    }
+    result.Set("backendQueries", Napi::Number::New(env, static_cast<double>(stats.backendQueries)));
+    result.Set("narrowedQueries", Napi::Number::New(env, static_cast<double>(stats.narrowedQueries)));
+    result.Set("cachedRows", Napi::Number::New(env, static_cast<double>(stats.cachedRows)));
+    return result;
+  }
 
-    if (api.getResultDateModified != nullptr) {
-      FILETIME modified{};
-      if (api.getResultDateModified(i, &modified)) {
-        result.Set("dateModified", Napi::Number::New(env, FileTimeToUnixMillis(modified)));
-      }
-    }
+  std::string channel_;
+  SearchSessionCache cache_;
+};
 
-    if (api.getResultDateCreated != nullptr) {
-      FILETIME created{};
-      if (api.getResultDateCreated(i, &created)) {
-        result.Set("dateCreated", Napi::Number::New(env, FileTimeToUnixMillis(created)));
-      }
-    }
+Napi::Value GetCacheStats(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  const auto stats = ResultCache::Instance().Stats();
+  auto result = Napi::Object::New(env);
+  result.Set("hits", Napi::Number::New(env, static_cast<double>(stats.hits)));
+  result.Set("misses", Napi::Number::New(env, static_cast<double>(stats.misses)));
+  result.Set("insertions", Napi::Number::New(env, static_cast<double>(stats.insertions)));
+  result.Set("evictions", Napi::Number::New(env, static_cast<double>(stats.evictions)));
+  result.Set("expirations", Napi::Number::New(env, static_cast<double>(stats.expirations)));
+  result.Set("invalidations", Napi::Number::New(env, static_cast<double>(stats.invalidations)));
+  result.Set("entries", Napi::Number::New(env, static_cast<double>(stats.entries)));
+  result.Set("bytes", Napi::Number::New(env, static_cast<double>(stats.bytes)));
+  result.Set("maxBytes", Napi::Number::New(env, static_cast<double>(stats.config.maxBytes)));
+  result.Set("ttlMs", Napi::Number::New(env, static_cast<double>(stats.config.ttlMs)));
+  result.Set("generation", Napi::Number::New(env, static_cast<double>(stats.generation)));
+  result.Set("sourceGeneration", Napi::Number::New(env, static_cast<double>(BackendGeneration())));
+  return result;
+}
 
-    if (api.isFolderResult != nullptr) {
-      result.Set("isFolder", Napi::Boolean::New(env, api.isFolderResult(i) == TRUE));
+// configureCache({ maxBytes?, ttlMs? }): omitted keys keep their value, 0
+// disables the cache.
+Napi::Value ConfigureCache(const Napi::CallbackInfo& info) {
+  auto& cache = ResultCache::Instance();
+  auto config = cache.Stats().config;
+  if (info.Length() >= 1 && info[0].IsObject()) {
+    const auto rawOptions = info[0].As<Napi::Object>();
+    if (rawOptions.Has("maxBytes") && rawOptions.Get("maxBytes").IsNumber()) {
+      config.maxBytes = static_cast<size_t>(
+          std::max<int64_t>(0, rawOptions.Get("maxBytes").As<Napi::Number>().Int64Value()));
+    }
+    if (rawOptions.Has("ttlMs") && rawOptions.Get("ttlMs").IsNumber()) {
+      config.ttlMs = static_cast<uint32_t>(std::clamp<int64_t>(
+          rawOptions.Get("ttlMs").As<Napi::Number>().Int64Value(), 0, UINT32_MAX));
     }
-
-    resultArray.Set(jsIndex++, result);
   }
+  cache.Configure(config);
+  return GetCacheStats(info);
+}
 
-  return resultArray;
+Napi::Value InvalidateCache(const Napi::CallbackInfo& info) {
+  ResultCache::Instance().Invalidate();
+  return info.Env().Undefined();
 }
 
-#endif
+// getNativeMetrics(): stage timings and counters of every search in the
+// process, plus the executor's queue right now.
+Napi::Value GetNativeMetrics(const Napi::CallbackInfo& info) {
+  auto env = info.Env();
+  const auto executor = SearchExecutor::Instance().Stats();
+  auto queues = Napi::Object::New(env);
+  queues.Set("search", Napi::Number::New(env, executor.queued));
+  queues.Set("running", Napi::Boolean::New(env, executor.running));
+
+  auto metrics = ToJsNativeMetrics(env, SearchMetrics());
+  metrics.Set("queues", queues);
+  return metrics;
+}
 
-Napi::Value Search(const Napi::CallbackInfo& info) {
-#if defined(_WIN32)
-  return SearchWindows(info);
-#else
-  return Napi::Array::New(info.Env(), 0);
-#endif
+// configureNativeMetrics({ enabled?, traceCapacity?, reset? })
+Napi::Value ConfigureMetrics(const Napi::CallbackInfo& info) {
+  if (!ConfigureNativeMetrics(info, SearchMetrics())) {
+    return info.Env().Null();
+  }
+  return GetNativeMetrics(info);
 }
 
-Napi::Value Query(const Napi::CallbackInfo& info) {
-  return Search(info);
+Napi::Value DrainTraceSpans(const Napi::CallbackInfo& info) {
+  return DrainJsTraceSpans(info.Env(), SearchMetrics());
 }
 
 Napi::Value GetVersion(const Napi::CallbackInfo& info) {
   auto env = info.Env();
 
-#if defined(_WIN32)
+#if !defined(_WIN32)
+  if (!EverythingApi::IsConfigured()) {
+    return env.Null();
+  }
+#endif
+
   std::string loadError;
   auto& api = EverythingApi::Instance();
   if (!api.EnsureLoaded(loadError)) {
@@ -586,9 +1242,6 @@ Napi::Value GetVersion(const Napi::CallbackInfo& info) {
     return env.Null();
   }
   return Napi::String::New(env, version);
-#else
-  return env.Null();
-#endif
 }
 
 }  // namespace
@@ -597,6 +1250,30 @@ Napi::Object Init(Napi::Env env, Napi::Object exports) {
   exports.Set("search", Napi::Function::New(env, Search, "search"));
   exports.Set("query", Napi::Function::New(env, Query, "query"));
   exports.Set("getVersion", Napi::Function::New(env, GetVersion, "getVersion"));
+  exports.Set("searchAsync", Napi::Function::New(env, SearchAsync, "searchAsync"));
+  exports.Set("nextRequestId", Napi::Function::New(env, NextRequestId, "nextRequestId"));
+  exports.Set("cancelSearch", Napi::Function::New(env, CancelSearch, "cancelSearch"));
+  exports.Set("SearchSession", SearchSession::DefineClass(env));
+  exports.Set("getCacheStats", Napi::Function::New(env, GetCacheStats, "getCacheStats"));
+  exports.Set("configureCache", Napi::Function::New(env, ConfigureCache, "configureCache"));
+  exports.Set("invalidateCache", Napi::Function::New(env, InvalidateCache, "invalidateCache"));
+  exports.Set("getNativeMetrics", Napi::Function::New(env, GetNativeMetrics, "getNativeMetrics"));
+  exports.Set("configureNativeMetrics",
+              Napi::Function::New(env, ConfigureMetrics, "configureNativeMetrics"));
+  exports.Set("drainNativeTraceSpans",
+              Napi::Function::New(env, DrainTraceSpans, "drainNativeTraceSpans"));
+  exports.Set("statBatch", Napi::Function::New(env, StatBatch, "statBatch"));
+  exports.Set("scanTreeAsync", Napi::Function::New(env, ScanTreeAsync, "scanTreeAsync"));
+  exports.Set("acknowledgeTreeScanBatch",
+              Napi::Function::New(env, AcknowledgeTreeScanBatch, "acknowledgeTreeScanBatch"));
+#if defined(__linux__)
+  exports.Set("getIndexStatus", Napi::Function::New(env, GetIndexStatus, "getIndexStatus"));
+  exports.Set("rebuildIndex", Napi::Function::New(env, RebuildIndex, "rebuildIndex"));
+  exports.Set("locate", Napi::Function::New(env, Locate, "locate"));
+  exports.Set("locateAsync", Napi::Function::New(env, LocateAsync, "locateAsync"));
+  exports.Set("getLocateStatus", Napi::Function::New(env, GetLocateStatus, "getLocateStatus"));
+  exports.Set("FsWatcher", FsWatcherWrap::DefineClass(env));
+#endif
   return exports;
 }
 
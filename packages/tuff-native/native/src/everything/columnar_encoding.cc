@@ -0,0 +1,233 @@
+#include "everything/columnar_encoding.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string>
+
+namespace tuff::native::everything {
+
+namespace {
+
+struct StringSlice {
+  uint32_t offset = 0;
+  uint32_t length = 0;
+};
+
+bool StartsWith(const std::string& value, const std::string& prefix) {
+  return value.size() >= prefix.size() && value.compare(0, prefix.size(), prefix) == 0;
+}
+
+bool EndsWith(const std::string& value, const std::string& suffix) {
+  return value.size() >= suffix.size() &&
+      value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Walks the rows once, deciding where each string lives in the heap. With
+// `heap` null it only counts, which is how ColumnarByteLength and
+// EncodeColumnar stay in agreement about the layout.
+class HeapLayout {
+ public:
+  explicit HeapLayout(uint8_t* heap) : heap_(heap) {}
+
+  StringSlice Append(const std::string& value) {
+    StringSlice slice{static_cast<uint32_t>(size_), static_cast<uint32_t>(value.size())};
+    if (heap_ != nullptr && !value.empty()) {
+      std::memcpy(heap_ + size_, value.data(), value.size());
+    }
+    size_ += value.size();
+    return slice;
+  }
+
+  template <typename Sink>
+  void Place(const SearchRow& row, Sink&& sink) {
+    const StringSlice fullPath = Append(row.fullPath);
+
+    StringSlice path;
+    if (StartsWith(row.fullPath, row.path)) {
+      path = {fullPath.offset, static_cast<uint32_t>(row.path.size())};
+    } else {
+      path = Append(row.path);
+    }
+
+    StringSlice name;
+    if (EndsWith(row.fullPath, row.name)) {
+      name = {fullPath.offset + fullPath.length - static_cast<uint32_t>(row.name.size()),
+              static_cast<uint32_t>(row.name.size())};
+    } else {
+      name = Append(row.name);
+    }
+
+    StringSlice extension;
+    if (EndsWith(row.name, row.extension)) {
+      extension = {name.offset + name.length - static_cast<uint32_t>(row.extension.size()),
+                   static_cast<uint32_t>(row.extension.size())};
+    } else {
+      extension = Append(row.extension);
+    }
+
+    sink(fullPath, path, name, extension);
+  }
+
+  size_t size() const { return size_; }
+
+ private:
+  uint8_t* heap_;
+  size_t size_ = 0;
+};
+
+size_t BitsetBytes(size_t rowCount) {
+  return (rowCount + 7) / 8;
+}
+
+size_t FloatsOffset(size_t rowCount) {
+  return (kColumnarHeaderWords + kColumnarStringColumns * rowCount) * sizeof(uint32_t);
+}
+
+size_t FolderBitsOffset(size_t rowCount) {
+  return FloatsOffset(rowCount) + 3 * rowCount * sizeof(double);
+}
+
+size_t HeapOffset(size_t rowCount) {
+  return FolderBitsOffset(rowCount) + 2 * BitsetBytes(rowCount);
+}
+
+size_t CountHeapBytes(const std::vector<SearchRow>& rows) {
+  HeapLayout layout(nullptr);
+  for (const auto& row : rows) {
+    layout.Place(row, [](StringSlice, StringSlice, StringSlice, StringSlice) {});
+  }
+  return layout.size();
+}
+
+void StoreU32(uint8_t* base, size_t index, uint32_t value) {
+  std::memcpy(base + index * sizeof(uint32_t), &value, sizeof(value));
+}
+
+void StoreF64(uint8_t* base, size_t index, double value) {
+  std::memcpy(base + index * sizeof(double), &value, sizeof(value));
+}
+
+uint32_t LoadU32(const uint8_t* base, size_t index) {
+  uint32_t value = 0;
+  std::memcpy(&value, base + index * sizeof(uint32_t), sizeof(value));
+  return value;
+}
+
+double LoadF64(const uint8_t* base, size_t index) {
+  double value = 0;
+  std::memcpy(&value, base + index * sizeof(double), sizeof(value));
+  return value;
+}
+
+}  // namespace
+
+size_t ColumnarByteLength(const std::vector<SearchRow>& rows) {
+  return HeapOffset(rows.size()) + CountHeapBytes(rows);
+}
+
+void EncodeColumnar(const std::vector<SearchRow>& rows, uint32_t fields, uint8_t* out) {
+  const size_t rowCount = rows.size();
+  const size_t floatsOffset = FloatsOffset(rowCount);
+  const size_t folderBitsOffset = FolderBitsOffset(rowCount);
+  const size_t heapOffset = HeapOffset(rowCount);
+
+  std::memset(out, 0, heapOffset);
+
+  uint8_t* columns = out + kColumnarHeaderWords * sizeof(uint32_t);
+  uint8_t* floats = out + floatsOffset;
+  uint8_t* folderBits = out + folderBitsOffset;
+  uint8_t* hasFolderBits = folderBits + BitsetBytes(rowCount);
+  constexpr double kAbsent = std::numeric_limits<double>::quiet_NaN();
+
+  HeapLayout layout(out + heapOffset);
+  for (size_t i = 0; i < rowCount; ++i) {
+    const auto& row = rows[i];
+    layout.Place(row, [&](StringSlice fullPath, StringSlice path, StringSlice name,
+                          StringSlice extension) {
+      const StringSlice slices[] = {fullPath, path, name, extension};
+      for (size_t column = 0; column < 4; ++column) {
+        StoreU32(columns, (column * 2) * rowCount + i, slices[column].offset);
+        StoreU32(columns, (column * 2 + 1) * rowCount + i, slices[column].length);
+      }
+    });
+
+    const bool hasSize = (fields & kFieldSize) && row.hasSize;
+    const bool hasDateModified = (fields & kFieldDateModified) && row.hasDateModified;
+    const bool hasDateCreated = (fields & kFieldDateCreated) && row.hasDateCreated;
+    StoreF64(floats, i, hasSize ? row.size : kAbsent);
+    StoreF64(floats, rowCount + i, hasDateModified ? row.dateModified : kAbsent);
+    StoreF64(floats, 2 * rowCount + i, hasDateCreated ? row.dateCreated : kAbsent);
+
+    if ((fields & kFieldIsFolder) && row.hasIsFolder) {
+      hasFolderBits[i / 8] |= static_cast<uint8_t>(1U << (i % 8));
+      if (row.isFolder) {
+        folderBits[i / 8] |= static_cast<uint8_t>(1U << (i % 8));
+      }
+    }
+  }
+
+  const uint32_t header[kColumnarHeaderWords] = {
+      kColumnarMagic,
+      kColumnarVersion,
+      static_cast<uint32_t>(rowCount),
+      static_cast<uint32_t>(layout.size()),
+      static_cast<uint32_t>(floatsOffset),
+      static_cast<uint32_t>(folderBitsOffset),
+      static_cast<uint32_t>(heapOffset),
+      fields,
+  };
+  std::memcpy(out, header, sizeof(header));
+}
+
+bool DecodeColumnar(const uint8_t* data, size_t size, std::vector<SearchRow>& rows) {
+  rows.clear();
+  if (size < kColumnarHeaderWords * sizeof(uint32_t) || LoadU32(data, 0) != kColumnarMagic ||
+      LoadU32(data, 1) != kColumnarVersion) {
+    return false;
+  }
+  const size_t rowCount = LoadU32(data, 2);
+  const size_t heapByteLength = LoadU32(data, 3);
+  const uint32_t fields = LoadU32(data, 7);
+  if (HeapOffset(rowCount) + heapByteLength != size) {
+    return false;
+  }
+
+  const uint8_t* columns = data + kColumnarHeaderWords * sizeof(uint32_t);
+  const uint8_t* floats = data + FloatsOffset(rowCount);
+  const uint8_t* folderBits = data + FolderBitsOffset(rowCount);
+  const uint8_t* hasFolderBits = folderBits + BitsetBytes(rowCount);
+  const char* heap = reinterpret_cast<const char*>(data + HeapOffset(rowCount));
+
+  rows.resize(rowCount);
+  for (size_t i = 0; i < rowCount; ++i) {
+    auto& row = rows[i];
+    std::string* const strings[] = {&row.fullPath, &row.path, &row.name, &row.extension};
+    for (size_t column = 0; column < 4; ++column) {
+      const size_t offset = LoadU32(columns, (column * 2) * rowCount + i);
+      const size_t length = LoadU32(columns, (column * 2 + 1) * rowCount + i);
+      if (offset + length > heapByteLength) {
+        rows.clear();
+        return false;
+      }
+      strings[column]->assign(heap + offset, length);
+    }
+
+    row.size = LoadF64(floats, i);
+    row.dateModified = LoadF64(floats, rowCount + i);
+    row.dateCreated = LoadF64(floats, 2 * rowCount + i);
+    row.hasSize = !std::isnan(row.size);
+    row.hasDateModified = !std::isnan(row.dateModified);
+    row.hasDateCreated = !std::isnan(row.dateCreated);
+    row.size = row.hasSize ? row.size : 0;
+    row.dateModified = row.hasDateModified ? row.dateModified : 0;
+    row.dateCreated = row.hasDateCreated ? row.dateCreated : 0;
+
+    const uint8_t mask = static_cast<uint8_t>(1U << (i % 8));
+    row.hasIsFolder = (fields & kFieldIsFolder) && (hasFolderBits[i / 8] & mask) != 0;
+    row.isFolder = row.hasIsFolder && (folderBits[i / 8] & mask) != 0;
+  }
+  return true;
+}
+
+}  // namespace tuff::native::everything
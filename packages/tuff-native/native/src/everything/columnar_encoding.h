@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "everything/search_types.h"
+
+namespace tuff::native::everything {
+
+// `format: 'columnar'` packs a whole result set into one ArrayBuffer so the
+// addon creates a single JS value per query instead of one object and ten
+// properties per row. everything-columnar.js reads it lazily; keep the two in
+// step. All integers are little-endian.
+//
+//   u32[8]  header: magic, version, rowCount, heapByteLength,
+//           floatsOffset, folderBitsOffset, heapOffset, fields
+//   u32[n]  fullPathOffset, fullPathLength, pathOffset, pathLength,
+//           nameOffset, nameLength, extensionOffset, extensionLength
+//           (eight columns of n entries each, in that order)
+//   f64[n]  size, dateModified, dateCreated at floatsOffset (NaN = absent)
+//   u8[]    isFolder bitset, then hasIsFolder bitset, ceil(n / 8) bytes each
+//   u8[]    UTF-8 heap at heapOffset; string offsets are relative to it
+//
+// path, name and extension are almost always a prefix or suffix of fullPath,
+// so they point into fullPath's bytes rather than being stored again. `fields`
+// is the kField* mask of the query; columns outside it are present but empty
+// and the reader reports them as absent.
+constexpr uint32_t kColumnarMagic = 0x43465554;  // "TUFC"
+constexpr uint32_t kColumnarVersion = 1;
+constexpr size_t kColumnarHeaderWords = 8;
+constexpr size_t kColumnarStringColumns = 8;
+
+enum class ResultFormat {
+  kObjects,
+  kColumnar,
+};
+
+// Exact size of the encoding of `rows`, so the caller can allocate the target
+// (a JS ArrayBuffer on the main thread) once and encode straight into it.
+size_t ColumnarByteLength(const std::vector<SearchRow>& rows);
+
+// `out` must hold ColumnarByteLength(rows) bytes.
+void EncodeColumnar(const std::vector<SearchRow>& rows, uint32_t fields, uint8_t* out);
+
+// Inverse of EncodeColumnar, for encodings this process made (the result
+// cache keeps only the encoded form). Returns false on a malformed buffer.
+bool DecodeColumnar(const uint8_t* data, size_t size, std::vector<SearchRow>& rows);
+
+}  // namespace tuff::native::everything
@@ -0,0 +1,464 @@
+#include "everything/everything_sdk.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#if !defined(_WIN32)
+#include <dlfcn.h>
+#endif
+
+#include "common/utf_transcode.h"
+#include "everything/search_metrics.h"
+
+namespace tuff::native::everything {
+
+namespace {
+
+constexpr SdkDword kEverythingRequestFileName = 0x00000001;
+constexpr SdkDword kEverythingRequestPath = 0x00000002;
+constexpr SdkDword kEverythingRequestFullPathAndFileName = 0x00000004;
+constexpr SdkDword kEverythingRequestSize = 0x00000010;
+constexpr SdkDword kEverythingRequestDateCreated = 0x00000020;
+constexpr SdkDword kEverythingRequestDateModified = 0x00000040;
+
+constexpr uint64_t kWindowsEpochOffset100Ns = 116444736000000000ULL;
+
+#if defined(_WIN32)
+
+std::string ReadEnvVar(const wchar_t* key) {
+  const DWORD required = ::GetEnvironmentVariableW(key, nullptr, 0);
+  if (required == 0) {
+    return "";
+  }
+
+  std::wstring value(required, L'\0');
+  const DWORD written = ::GetEnvironmentVariableW(key, value.data(), required);
+  if (written == 0) {
+    return "";
+  }
+
+  value.resize(written);
+  return WideToUtf8(value);
+}
+
+std::string JoinPath(const std::string& base, const std::string& file) {
+  if (base.empty()) {
+    return file;
+  }
+
+  if (base.back() == '\\' || base.back() == '/') {
+    return base + file;
+  }
+
+  return base + "\\" + file;
+}
+
+#else
+
+std::string ReadEnvVar(const char* key) {
+  const char* value = std::getenv(key);
+  return value != nullptr ? std::string(value) : std::string();
+}
+
+#endif
+
+double FileTimeToUnixMillis(const SdkFileTime& fileTime) {
+  const uint64_t value =
+      (static_cast<uint64_t>(fileTime.dwHighDateTime) << 32) | fileTime.dwLowDateTime;
+
+  if (value <= kWindowsEpochOffset100Ns) {
+    return 0;
+  }
+
+  return static_cast<double>((value - kWindowsEpochOffset100Ns) / 10000ULL);
+}
+
+// Reads one result's full path into `scratch`, which the caller keeps for the
+// whole query: the buffer grows to the longest path once instead of being
+// allocated per row. Returns the length in wchar_t, 0 when there is none.
+size_t ReadResultFullPath(EverythingApi& api, SdkDword index, std::vector<wchar_t>& scratch) {
+  while (true) {
+    const SdkDword copied =
+        api.getResultFullPathName(index, scratch.data(), static_cast<SdkDword>(scratch.size()));
+    if (copied == 0) {
+      return 0;
+    }
+
+    if (copied < scratch.size()) {
+      return copied;
+    }
+
+    scratch.resize(static_cast<size_t>(copied) + 1U, L'\0');
+  }
+}
+
+size_t WideLength(const wchar_t* value) {
+  size_t length = 0;
+  while (value[length] != L'\0') {
+    ++length;
+  }
+  return length;
+}
+
+SdkDword RequestFlagsFor(uint32_t fields) {
+  SdkDword flags = 0;
+  if (fields & (kFieldName | kFieldExtension)) {
+    flags |= kEverythingRequestFileName;
+  }
+  if (fields & (kFieldFullPath | kFieldPath)) {
+    flags |= kEverythingRequestPath | kEverythingRequestFullPathAndFileName;
+  }
+  if (fields & kFieldSize) {
+    flags |= kEverythingRequestSize;
+  }
+  if (fields & kFieldDateModified) {
+    flags |= kEverythingRequestDateModified;
+  }
+  if (fields & kFieldDateCreated) {
+    flags |= kEverythingRequestDateCreated;
+  }
+  // The SDK rejects an empty request; the file name is the cheapest column.
+  return flags != 0 ? flags : kEverythingRequestFileName;
+}
+
+}  // namespace
+
+EverythingApi& EverythingApi::Instance() {
+  static EverythingApi api;
+  return api;
+}
+
+bool EverythingApi::IsConfigured() {
+#if defined(_WIN32)
+  return !ReadEnvVar(L"TALEX_EVERYTHING_DLL_PATH").empty();
+#else
+  return !ReadEnvVar("TALEX_EVERYTHING_DLL_PATH").empty();
+#endif
+}
+
+bool EverythingApi::EnsureLoaded(std::string& errorMessage) {
+  std::lock_guard<std::mutex> lock(loadMutex_);
+  if (loaded_.load(std::memory_order_acquire)) {
+    return true;
+  }
+
+  std::string lastError = "Everything SDK DLL not found";
+  for (const auto& candidate : BuildCandidatePaths()) {
+    if (candidate.empty()) {
+      continue;
+    }
+
+    if (LoadFromPath(candidate, errorMessage)) {
+      return true;
+    }
+
+    if (!errorMessage.empty()) {
+      lastError = errorMessage;
+    }
+  }
+
+  errorMessage = lastError;
+  return false;
+}
+
+std::string EverythingApi::GetVersion() const {
+  if (!loaded_.load(std::memory_order_acquire)) {
+    return "";
+  }
+
+  if (!version_.empty()) {
+    return version_;
+  }
+
+  return "unknown";
+}
+
+template <typename T>
+bool EverythingApi::LoadRequired(const char* symbol, T& target, std::string& errorMessage) {
+#if defined(_WIN32)
+  target = reinterpret_cast<T>(::GetProcAddress(module_, symbol));
+#else
+  target = reinterpret_cast<T>(::dlsym(module_, symbol));
+#endif
+  if (target != nullptr) {
+    return true;
+  }
+
+  errorMessage = std::string("Everything SDK missing symbol: ") + symbol;
+  return false;
+}
+
+template <typename T>
+void EverythingApi::LoadOptional(const char* symbol, T& target) {
+#if defined(_WIN32)
+  target = reinterpret_cast<T>(::GetProcAddress(module_, symbol));
+#else
+  target = reinterpret_cast<T>(::dlsym(module_, symbol));
+#endif
+}
+
+bool EverythingApi::ResolveRequiredSymbols(std::string& errorMessage) {
+  return LoadRequired("Everything_SetSearchW", setSearch, errorMessage) &&
+      LoadRequired("Everything_SetRequestFlags", setRequestFlags, errorMessage) &&
+      LoadRequired("Everything_SetMax", setMax, errorMessage) &&
+      LoadRequired("Everything_SetOffset", setOffset, errorMessage) &&
+      LoadRequired("Everything_QueryW", query, errorMessage) &&
+      LoadRequired("Everything_GetLastError", getLastError, errorMessage) &&
+      LoadRequired("Everything_GetNumResults", getNumResults, errorMessage) &&
+      LoadRequired("Everything_GetResultFileNameW", getResultFileName, errorMessage) &&
+      LoadRequired("Everything_GetResultFullPathNameW", getResultFullPathName, errorMessage);
+}
+
+bool EverythingApi::LoadFromPath(const std::string& candidate, std::string& errorMessage) {
+#if defined(_WIN32)
+  module_ = ::LoadLibraryW(Utf8ToWide(candidate).c_str());
+  if (module_ == nullptr) {
+    const DWORD winErr = ::GetLastError();
+    errorMessage = "Unable to load Everything SDK DLL from candidate (winerr=" +
+        std::to_string(winErr) + ")";
+    return false;
+  }
+#else
+  module_ = ::dlopen(candidate.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (module_ == nullptr) {
+    const char* dlError = ::dlerror();
+    errorMessage = std::string("Unable to load Everything SDK library from candidate: ") +
+        (dlError != nullptr ? dlError : "unknown error");
+    return false;
+  }
+#endif
+
+  if (!ResolveRequiredSymbols(errorMessage)) {
+#if defined(_WIN32)
+    ::FreeLibrary(module_);
+#else
+    ::dlclose(module_);
+#endif
+    module_ = nullptr;
+    return false;
+  }
+
+  LoadOptional("Everything_SetSort", setSort);
+  LoadOptional("Everything_GetResultSize", getResultSize);
+  LoadOptional("Everything_GetResultDateModified", getResultDateModified);
+  LoadOptional("Everything_GetResultDateCreated", getResultDateCreated);
+  LoadOptional("Everything_IsFolderResult", isFolderResult);
+  LoadOptional("Everything_SetMatchPath", setMatchPath);
+  LoadOptional("Everything_SetMatchCase", setMatchCase);
+  LoadOptional("Everything_SetMatchWholeWord", setMatchWholeWord);
+  LoadOptional("Everything_SetRegex", setRegex);
+
+  Everything_GetMajorVersion_Fn getMajorVersion = nullptr;
+  Everything_GetMinorVersion_Fn getMinorVersion = nullptr;
+  Everything_GetRevision_Fn getRevision = nullptr;
+  Everything_GetBuildNumber_Fn getBuildNumber = nullptr;
+
+  LoadOptional("Everything_GetMajorVersion", getMajorVersion);
+  LoadOptional("Everything_GetMinorVersion", getMinorVersion);
+  LoadOptional("Everything_GetRevision", getRevision);
+  LoadOptional("Everything_GetBuildNumber", getBuildNumber);
+
+  if (getMajorVersion && getMinorVersion && getRevision && getBuildNumber) {
+    version_ = std::to_string(getMajorVersion()) + "." +
+        std::to_string(getMinorVersion()) + "." +
+        std::to_string(getRevision()) + "." +
+        std::to_string(getBuildNumber());
+  }
+
+  loaded_.store(true, std::memory_order_release);
+  return true;
+}
+
+std::vector<std::string> EverythingApi::BuildCandidatePaths() const {
+  std::vector<std::string> candidates;
+
+#if defined(_WIN32)
+  const auto customDllPath = ReadEnvVar(L"TALEX_EVERYTHING_DLL_PATH");
+  if (!customDllPath.empty()) {
+    candidates.push_back(customDllPath);
+  }
+
+#if defined(_WIN64)
+  candidates.push_back("Everything64.dll");
+#else
+  candidates.push_back("Everything32.dll");
+#endif
+  candidates.push_back("Everything.dll");
+
+  const auto programFiles = ReadEnvVar(L"PROGRAMFILES");
+  const auto programFilesX86 = ReadEnvVar(L"PROGRAMFILES(X86)");
+  if (!programFiles.empty()) {
+    candidates.push_back(JoinPath(programFiles, "Everything\\Everything64.dll"));
+    candidates.push_back(JoinPath(programFiles, "Everything\\Everything.dll"));
+    candidates.push_back(JoinPath(programFiles, "Everything\\Everything32.dll"));
+  }
+  if (!programFilesX86.empty()) {
+    candidates.push_back(JoinPath(programFilesX86, "Everything\\Everything32.dll"));
+    candidates.push_back(JoinPath(programFilesX86, "Everything\\Everything.dll"));
+  }
+#else
+  // No well-known install locations off Windows: only an explicit stand-in.
+  const auto customDllPath = ReadEnvVar("TALEX_EVERYTHING_DLL_PATH");
+  if (!customDllPath.empty()) {
+    candidates.push_back(customDllPath);
+  }
+#endif
+
+  return candidates;
+}
+
+bool QueryEverything(const std::string& query, const SearchOptions& options,
+                     std::vector<SearchRow>& rows, SearchError& error) {
+  rows.clear();
+
+  std::string loadError;
+  auto& api = EverythingApi::Instance();
+  if (!api.EnsureLoaded(loadError)) {
+    error.code = "ERR_EVERYTHING_SDK_UNAVAILABLE";
+    error.message = "Everything SDK is unavailable: " + loadError;
+    return false;
+  }
+
+  const auto wideQuery = Utf8ToWide(query);
+  if (wideQuery.empty()) {
+    error.code = "ERR_EVERYTHING_QUERY_ENCODING";
+    error.message = "Failed to convert query string to UTF-16";
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(api.Lock());
+
+  api.setSearch(wideQuery.c_str());
+
+  const uint32_t fields = options.fields;
+  const SdkDword requestFlags = RequestFlagsFor(fields);
+  api.setRequestFlags(requestFlags);
+
+  if (api.setSort != nullptr) {
+    api.setSort(options.sort);
+  }
+
+  api.setMax(options.maxResults);
+  api.setOffset(options.offset);
+
+  if (api.setMatchCase != nullptr) {
+    api.setMatchCase(options.matchCase ? kSdkTrue : kSdkFalse);
+  }
+  if (api.setMatchPath != nullptr) {
+    api.setMatchPath(options.matchPath ? kSdkTrue : kSdkFalse);
+  }
+  if (api.setMatchWholeWord != nullptr) {
+    api.setMatchWholeWord(options.matchWholeWord ? kSdkTrue : kSdkFalse);
+  }
+  if (api.setRegex != nullptr) {
+    api.setRegex(options.regex ? kSdkTrue : kSdkFalse);
+  }
+
+  NativeMetrics& metrics = SearchMetrics();
+  bool queried = false;
+  {
+    ScopedStage timed(metrics, kSearchStageQuery);
+    queried = api.query(kSdkTrue) != 0;
+  }
+  if (!queried) {
+    const SdkDword errCode = api.getLastError ? api.getLastError() : 0;
+    error.code = "ERR_EVERYTHING_QUERY_FAILED";
+    error.message = "Everything query failed, error code: " + std::to_string(errCode);
+    return false;
+  }
+
+  ScopedStage rowBuild(metrics, kSearchStageRowBuild);
+  const SdkDword total = api.getNumResults();
+  rows.reserve(total);
+
+  const bool wantsFullPath = (fields & (kFieldFullPath | kFieldPath)) != 0;
+  const bool wantsName = (fields & (kFieldName | kFieldExtension)) != 0;
+  std::vector<wchar_t> scratch(wantsFullPath ? 4096 : 0, L'\0');
+
+  for (SdkDword i = 0; i < total; ++i) {
+    const size_t fullPathLength = wantsFullPath ? ReadResultFullPath(api, i, scratch) : 0;
+    const wchar_t* fullPath = scratch.data();
+
+    const wchar_t* name = wantsName ? api.getResultFileName(i) : nullptr;
+    size_t nameLength = name != nullptr ? WideLength(name) : 0;
+
+    if (fullPathLength == 0 && nameLength == 0 && (wantsFullPath || wantsName)) {
+      continue;
+    }
+
+    // Separator position in the full path, or npos when it has none.
+    size_t separator = std::wstring::npos;
+    for (size_t k = fullPathLength; k > 0; --k) {
+      if (fullPath[k - 1] == L'\\' || fullPath[k - 1] == L'/') {
+        separator = k - 1;
+        break;
+      }
+    }
+
+    if (nameLength == 0 && fullPathLength > 0 && wantsName) {
+      if (separator != std::wstring::npos && separator + 1 < fullPathLength) {
+        name = fullPath + separator + 1;
+        nameLength = fullPathLength - separator - 1;
+      } else {
+        name = fullPath;
+        nameLength = fullPathLength;
+      }
+    }
+
+    SearchRow row;
+    if (fields & kFieldFullPath) {
+      row.fullPath = WideToUtf8(fullPath, fullPathLength);
+    }
+    if ((fields & kFieldPath) && separator != std::wstring::npos) {
+      row.path = WideToUtf8(fullPath, separator);
+    }
+    if (fields & kFieldName) {
+      row.name = WideToUtf8(name, nameLength);
+    }
+    if ((fields & kFieldExtension) && nameLength > 0) {
+      for (size_t k = nameLength; k > 0; --k) {
+        if (name[k - 1] == L'.') {
+          if (k < nameLength) {
+            row.extension = WideToUtf8(name + k, nameLength - k);
+          }
+          break;
+        }
+      }
+    }
+
+    if ((fields & kFieldSize) && api.getResultSize != nullptr) {
+      SdkLargeInteger fileSize{};
+      if (api.getResultSize(i, &fileSize)) {
+        row.size = static_cast<double>(fileSize.QuadPart);
+        row.hasSize = true;
+      }
+    }
+
+    if ((fields & kFieldDateModified) && api.getResultDateModified != nullptr) {
+      SdkFileTime modified{};
+      if (api.getResultDateModified(i, &modified)) {
+        row.dateModified = FileTimeToUnixMillis(modified);
+        row.hasDateModified = true;
+      }
+    }
+
+    if ((fields & kFieldDateCreated) && api.getResultDateCreated != nullptr) {
+      SdkFileTime created{};
+      if (api.getResultDateCreated(i, &created)) {
+        row.dateCreated = FileTimeToUnixMillis(created);
+        row.hasDateCreated = true;
+      }
+    }
+
+    if ((fields & kFieldIsFolder) && api.isFolderResult != nullptr) {
+      row.isFolder = api.isFolderResult(i) == kSdkTrue;
+      row.hasIsFolder = true;
+    }
+
+    rows.push_back(std::move(row));
+  }
+
+  return true;
+}
+
+}  // namespace tuff::native::everything
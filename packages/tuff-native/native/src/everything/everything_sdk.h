@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+#include "everything/search_types.h"
+
+namespace tuff::native::everything {
+
+// The Everything SDK is a Windows DLL, but nothing about the call sequence is
+// Windows-specific. On other platforms the same entry points are resolved from
+// a shared library named by TALEX_EVERYTHING_DLL_PATH, which is how the stand-in
+// in fixtures/everything-sdk-stub drives the whole query path under tests on
+// Linux. These aliases keep the function-pointer types identical to the SDK
+// header on Windows and ABI-compatible with the stand-in elsewhere.
+#if defined(_WIN32)
+#define TUFF_EVERYTHING_CALL WINAPI
+using SdkDword = DWORD;
+using SdkBool = BOOL;
+using SdkLargeInteger = LARGE_INTEGER;
+using SdkFileTime = FILETIME;
+using SdkModule = HMODULE;
+#else
+#define TUFF_EVERYTHING_CALL
+using SdkDword = uint32_t;
+using SdkBool = int32_t;
+struct SdkLargeInteger {
+  int64_t QuadPart;
+};
+struct SdkFileTime {
+  uint32_t dwLowDateTime;
+  uint32_t dwHighDateTime;
+};
+using SdkModule = void*;
+#endif
+
+constexpr SdkBool kSdkTrue = 1;
+constexpr SdkBool kSdkFalse = 0;
+
+typedef void(TUFF_EVERYTHING_CALL* Everything_SetSearchW_Fn)(const wchar_t* lpString);
+typedef void(TUFF_EVERYTHING_CALL* Everything_SetRequestFlags_Fn)(SdkDword dwRequestFlags);
+typedef void(TUFF_EVERYTHING_CALL* Everything_SetSort_Fn)(SdkDword dwSortType);
+typedef void(TUFF_EVERYTHING_CALL* Everything_SetMax_Fn)(SdkDword dwMax);
+typedef void(TUFF_EVERYTHING_CALL* Everything_SetOffset_Fn)(SdkDword dwOffset);
+typedef SdkBool(TUFF_EVERYTHING_CALL* Everything_QueryW_Fn)(SdkBool bWait);
+typedef SdkDword(TUFF_EVERYTHING_CALL* Everything_GetLastError_Fn)();
+typedef SdkDword(TUFF_EVERYTHING_CALL* Everything_GetNumResults_Fn)();
+typedef const wchar_t*(TUFF_EVERYTHING_CALL* Everything_GetResultFileNameW_Fn)(SdkDword nIndex);
+typedef SdkDword(TUFF_EVERYTHING_CALL* Everything_GetResultFullPathNameW_Fn)(
+    SdkDword nIndex, wchar_t* lpString, SdkDword nMaxCount);
+typedef SdkBool(TUFF_EVERYTHING_CALL* Everything_GetResultSize_Fn)(SdkDword nIndex, SdkLargeInteger* lpFileSize);
+typedef SdkBool(TUFF_EVERYTHING_CALL* Everything_GetResultDateModified_Fn)(SdkDword nIndex, SdkFileTime* lpFileTime);
+typedef SdkBool(TUFF_EVERYTHING_CALL* Everything_GetResultDateCreated_Fn)(SdkDword nIndex, SdkFileTime* lpFileTime);
+typedef SdkBool(TUFF_EVERYTHING_CALL* Everything_IsFolderResult_Fn)(SdkDword nIndex);
+typedef void(TUFF_EVERYTHING_CALL* Everything_SetMatchPath_Fn)(SdkBool bEnable);
+typedef void(TUFF_EVERYTHING_CALL* Everything_SetMatchCase_Fn)(SdkBool bEnable);
+typedef void(TUFF_EVERYTHING_CALL* Everything_SetMatchWholeWord_Fn)(SdkBool bEnable);
+typedef void(TUFF_EVERYTHING_CALL* Everything_SetRegex_Fn)(SdkBool bEnable);
+typedef SdkDword(TUFF_EVERYTHING_CALL* Everything_GetMajorVersion_Fn)();
+typedef SdkDword(TUFF_EVERYTHING_CALL* Everything_GetMinorVersion_Fn)();
+typedef SdkDword(TUFF_EVERYTHING_CALL* Everything_GetRevision_Fn)();
+typedef SdkDword(TUFF_EVERYTHING_CALL* Everything_GetBuildNumber_Fn)();
+
+// The SDK keeps its query state in process globals (search string, flags,
+// result list), so every use has to hold Lock() from the first setter to the
+// last getter. The async executor and the synchronous `search` both go through
+// QueryEverything, which does.
+class EverythingApi {
+ public:
+  static EverythingApi& Instance();
+
+  bool EnsureLoaded(std::string& errorMessage);
+  std::string GetVersion() const;
+
+  // Whether a stand-in library was named explicitly. Off Windows that is the
+  // only way the SDK path is taken at all.
+  static bool IsConfigured();
+
+  std::mutex& Lock() { return mutex_; }
+
+  Everything_SetSearchW_Fn setSearch = nullptr;
+  Everything_SetRequestFlags_Fn setRequestFlags = nullptr;
+  Everything_SetSort_Fn setSort = nullptr;
+  Everything_SetMax_Fn setMax = nullptr;
+  Everything_SetOffset_Fn setOffset = nullptr;
+  Everything_QueryW_Fn query = nullptr;
+  Everything_GetLastError_Fn getLastError = nullptr;
+  Everything_GetNumResults_Fn getNumResults = nullptr;
+  Everything_GetResultFileNameW_Fn getResultFileName = nullptr;
+  Everything_GetResultFullPathNameW_Fn getResultFullPathName = nullptr;
+  Everything_GetResultSize_Fn getResultSize = nullptr;
+  Everything_GetResultDateModified_Fn getResultDateModified = nullptr;
+  Everything_GetResultDateCreated_Fn getResultDateCreated = nullptr;
+  Everything_IsFolderResult_Fn isFolderResult = nullptr;
+  Everything_SetMatchPath_Fn setMatchPath = nullptr;
+  Everything_SetMatchCase_Fn setMatchCase = nullptr;
+  Everything_SetMatchWholeWord_Fn setMatchWholeWord = nullptr;
+  Everything_SetRegex_Fn setRegex = nullptr;
+
+ private:
+  EverythingApi() = default;
+
+  template <typename T>
+  bool LoadRequired(const char* symbol, T& target, std::string& errorMessage);
+
+  template <typename T>
+  void LoadOptional(const char* symbol, T& target);
+
+  bool ResolveRequiredSymbols(std::string& errorMessage);
+  bool LoadFromPath(const std::string& candidate, std::string& errorMessage);
+  std::vector<std::string> BuildCandidatePaths() const;
+
+  std::mutex mutex_;
+  std::mutex loadMutex_;
+  SdkModule module_ = nullptr;
+  // Set once, under loadMutex_, after the symbols and version_ are in place;
+  // GetVersion() reads it without the lock, so version_ is published by the
+  // release store and never written again.
+  std::atomic<bool> loaded_{false};
+  std::string version_;
+};
+
+// Runs one query against the SDK and copies the result rows out while holding
+// the SDK lock. Safe to call from any thread.
+bool QueryEverything(const std::string& query, const SearchOptions& options,
+                     std::vector<SearchRow>& rows, SearchError& error);
+
+}  // namespace tuff::native::everything
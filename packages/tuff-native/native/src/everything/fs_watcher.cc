@@ -0,0 +1,1116 @@
+#include "everything/fs_watcher.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/fanotify.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <sys/statfs.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+#include <utility>
+
+namespace tuff::native::everything {
+
+namespace {
+
+constexpr size_t kReadBufferBytes = 64 * 1024;
+// Directory handle -> path lookups kept by the fanotify backend. Cleared when
+// full or when any directory is renamed or removed, which is what makes a
+// cached path stale.
+constexpr size_t kHandleCacheLimit = 4096;
+
+constexpr uint32_t kInotifyMask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+    IN_CLOSE_WRITE | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK;
+
+constexpr uint64_t kFanotifyMask =
+    FAN_CREATE | FAN_DELETE | FAN_MOVED_FROM | FAN_MOVED_TO | FAN_CLOSE_WRITE | FAN_ONDIR;
+
+const char* ErrnoName(int error) {
+  switch (error) {
+    case ENOENT:
+      return "ENOENT";
+    case EACCES:
+      return "EACCES";
+    case EPERM:
+      return "EPERM";
+    case ENOTDIR:
+      return "ENOTDIR";
+    case ENOSPC:
+      return "ENOSPC";
+    case EMFILE:
+      return "EMFILE";
+    case ENOMEM:
+      return "ENOMEM";
+    default:
+      return "EIO";
+  }
+}
+
+std::string NormalizeRoot(std::string root) {
+  while (root.size() > 1 && root.back() == '/') {
+    root.pop_back();
+  }
+  return root;
+}
+
+std::string JoinPath(const std::string& directory, const char* name) {
+  std::string path = directory;
+  if (path.empty() || path.back() != '/') {
+    path.push_back('/');
+  }
+  path.append(name);
+  return path;
+}
+
+bool IsDotEntry(const char* name) {
+  return name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+}
+
+bool IsDirectoryEntry(const std::string& directory, const dirent* item) {
+  if (item->d_type != DT_UNKNOWN) {
+    return item->d_type == DT_DIR;
+  }
+  struct stat info {};
+  return ::lstat(JoinPath(directory, item->d_name).c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+// Calls `visit(path, isDirectory)` for every entry of `directory` and, while
+// `remaining` allows, of its subdirectories. Symlinks are reported but never
+// followed.
+template <typename Visit>
+void WalkEntries(const std::string& directory, uint32_t remaining, const Visit& visit) {
+  DIR* dir = ::opendir(directory.c_str());
+  if (dir == nullptr) {
+    return;
+  }
+  std::vector<std::string> subdirectories;
+  while (const dirent* item = ::readdir(dir)) {
+    if (IsDotEntry(item->d_name)) {
+      continue;
+    }
+    const bool isDirectory = IsDirectoryEntry(directory, item);
+    auto path = JoinPath(directory, item->d_name);
+    visit(path, isDirectory);
+    if (isDirectory && remaining > 0) {
+      subdirectories.push_back(std::move(path));
+    }
+  }
+  ::closedir(dir);
+
+  for (const auto& subdirectory : subdirectories) {
+    WalkEntries(subdirectory, remaining - 1, visit);
+  }
+}
+
+// Folds the raw events of one latency window into at most one event per path,
+// judged by whether the path existed before the window and whether it exists
+// at the end: created and removed again is dropped, removed and created again
+// (an editor's atomic save) is a change.
+class PendingBatch {
+ public:
+  void Record(WatchAction action, bool isDirectory, const std::string& path) {
+    auto found = states_.find(path);
+    if (found == states_.end()) {
+      order_.push_back(path);
+      states_.emplace(path, State{action != WatchAction::kAdd, action != WatchAction::kDelete,
+                                  isDirectory});
+      return;
+    }
+    found->second.existsNow = action != WatchAction::kDelete;
+    found->second.isDirectory = isDirectory;
+  }
+
+  void RecordOverflow(const std::string& root) {
+    overflows_.push_back(root);
+  }
+
+  bool empty() const {
+    return order_.empty() && overflows_.empty();
+  }
+
+  size_t size() const {
+    return order_.size() + overflows_.size();
+  }
+
+  std::vector<WatchEvent> Take() {
+    std::vector<WatchEvent> batch;
+    batch.reserve(size());
+    for (auto& root : overflows_) {
+      batch.push_back(WatchEvent{WatchAction::kOverflow, true, std::move(root)});
+    }
+    for (auto& path : order_) {
+      const auto& state = states_[path];
+      WatchAction action;
+      if (!state.existedBefore && !state.existsNow) {
+        continue;
+      } else if (!state.existedBefore) {
+        action = WatchAction::kAdd;
+      } else if (!state.existsNow) {
+        action = WatchAction::kDelete;
+      } else {
+        // A directory has no content to change; one that was replaced is new.
+        action = state.isDirectory ? WatchAction::kAdd : WatchAction::kChange;
+      }
+      batch.push_back(WatchEvent{action, state.isDirectory, std::move(path)});
+    }
+    overflows_.clear();
+    order_.clear();
+    states_.clear();
+    return batch;
+  }
+
+ private:
+  struct State {
+    bool existedBefore;
+    bool existsNow;
+    bool isDirectory;
+  };
+
+  std::vector<std::string> order_;
+  std::unordered_map<std::string, State> states_;
+  std::vector<std::string> overflows_;
+};
+
+}  // namespace
+
+class WatchBackendImpl {
+ public:
+  virtual ~WatchBackendImpl() = default;
+
+  virtual const char* name() const = 0;
+  virtual int fd() const = 0;
+  virtual uint64_t watches() const = 0;
+  virtual uint64_t roots() const = 0;
+
+  virtual bool AddRoot(const std::string& root, uint32_t depth, std::string& error) = 0;
+  virtual void RemoveRoot(const std::string& root) = 0;
+
+  // Reads everything queued without blocking.
+  virtual void Drain(PendingBatch& pending, FsWatcherStats& stats) = 0;
+};
+
+namespace {
+
+class InotifyBackend final : public WatchBackendImpl {
+ public:
+  static std::unique_ptr<InotifyBackend> Create(std::string& error) {
+    const int fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+      error = ErrnoName(errno);
+      return nullptr;
+    }
+    return std::unique_ptr<InotifyBackend>(new InotifyBackend(fd));
+  }
+
+  ~InotifyBackend() override {
+    ::close(fd_);
+  }
+
+  const char* name() const override {
+    return "inotify";
+  }
+
+  int fd() const override {
+    return fd_;
+  }
+
+  uint64_t watches() const override {
+    return directories_.size();
+  }
+
+  uint64_t roots() const override {
+    return roots_.size();
+  }
+
+  bool AddRoot(const std::string& root, uint32_t depth, std::string& error) override {
+    if (roots_.count(root) != 0) {
+      return true;
+    }
+    const int wd = Watch(root, -1, root, depth, nullptr);
+    if (wd < 0) {
+      error = lastError_.empty() ? "EIO" : lastError_;
+      return false;
+    }
+    roots_[root] = {wd, depth};
+    return true;
+  }
+
+  // Roots may nest and share watches. A root inside another stays in the
+  // outer tree and is cut back to the depth the outer root gives it; one
+  // that holds other roots is unwatched around them.
+  void RemoveRoot(const std::string& root) override {
+    const auto found = roots_.find(root);
+    if (found == roots_.end()) {
+      return;
+    }
+    const int wd = found->second.wd;
+    roots_.erase(found);
+    const auto directory = directories_.find(wd);
+    if (directory == directories_.end()) {
+      return;
+    }
+    if (directory->second.parent >= 0 || RootAt(wd) != roots_.end()) {
+      Trim(wd);
+    } else {
+      Unwatch(wd);
+    }
+  }
+
+  void Drain(PendingBatch& pending, FsWatcherStats& stats) override {
+    alignas(inotify_event) char buffer[kReadBufferBytes];
+    while (true) {
+      const ssize_t length = ::read(fd_, buffer, sizeof(buffer));
+      if (length <= 0) {
+        break;
+      }
+      for (char* cursor = buffer; cursor < buffer + length;) {
+        const auto* event = reinterpret_cast<const inotify_event*>(cursor);
+        cursor += sizeof(inotify_event) + event->len;
+        ++stats.rawEvents;
+        Handle(*event, pending, stats);
+      }
+    }
+    if (!lastError_.empty()) {
+      stats.lastError = lastError_;
+    }
+  }
+
+ private:
+  // A watched directory, stored by name under its parent so the table costs
+  // one name per directory; full paths are rebuilt when an event needs one.
+  struct Directory {
+    int parent = -1;
+    std::string name;  // full path for a root no other root reaches
+    uint32_t remaining = 0;
+    std::vector<int> children;
+  };
+
+  struct RootWatch {
+    int wd;
+    uint32_t depth;
+  };
+
+  explicit InotifyBackend(int fd) : fd_(fd) {}
+
+  std::string PathOf(int wd) const {
+    std::vector<const std::string*> parts;
+    for (auto it = directories_.find(wd); it != directories_.end();
+         it = directories_.find(it->second.parent)) {
+      parts.push_back(&it->second.name);
+      if (it->second.parent < 0) {
+        break;
+      }
+    }
+    std::string path;
+    for (auto part = parts.rbegin(); part != parts.rend(); ++part) {
+      if (!path.empty() && path.back() != '/') {
+        path.push_back('/');
+      }
+      path.append(**part);
+    }
+    return path;
+  }
+
+  // Watches `path` and, while `remaining` allows, its subdirectories. With
+  // `added` set, every entry found is reported as added: the directory just
+  // appeared, so anything in it was created before the watch could see it.
+  int Watch(const std::string& path, int parent, const std::string& name, uint32_t remaining,
+            PendingBatch* added) {
+    const int wd = ::inotify_add_watch(fd_, path.c_str(), kInotifyMask);
+    if (wd < 0) {
+      // ENOSPC is fs.inotify.max_user_watches running out; worth surfacing.
+      lastError_ = ErrnoName(errno);
+      return -1;
+    }
+
+    auto existing = directories_.find(wd);
+    if (existing != directories_.end()) {
+      // A root reached from an enclosing root joins its tree, so that
+      // removing either leaves what the other still needs. A bind mount can
+      // lead back into the root's own tree, which must not become a loop.
+      if (existing->second.parent < 0 && parent >= 0 && !Within(parent, wd)) {
+        existing->second.parent = parent;
+        existing->second.name = name;
+        directories_[parent].children.push_back(wd);
+      }
+      // Reached again through an overlapping root: keep the deeper budget.
+      if (remaining <= existing->second.remaining) {
+        return wd;
+      }
+      existing->second.remaining = remaining;
+    } else {
+      auto& directory = directories_[wd];
+      directory.parent = parent;
+      directory.name = name;
+      directory.remaining = remaining;
+      if (parent >= 0) {
+        directories_[parent].children.push_back(wd);
+      }
+    }
+
+    if (remaining == 0 && added == nullptr) {
+      return wd;
+    }
+
+    DIR* dir = ::opendir(path.c_str());
+    if (dir == nullptr) {
+      return wd;
+    }
+    std::vector<std::string> subdirectories;
+    while (const dirent* item = ::readdir(dir)) {
+      if (IsDotEntry(item->d_name)) {
+        continue;
+      }
+      const bool isDirectory = IsDirectoryEntry(path, item);
+      if (added != nullptr) {
+        added->Record(WatchAction::kAdd, isDirectory, JoinPath(path, item->d_name));
+      }
+      if (isDirectory && remaining > 0) {
+        subdirectories.emplace_back(item->d_name);
+      }
+    }
+    ::closedir(dir);
+
+    for (const auto& child : subdirectories) {
+      Watch(JoinPath(path, child.c_str()), wd, child, remaining - 1, added);
+    }
+    return wd;
+  }
+
+  std::unordered_map<std::string, RootWatch>::const_iterator RootAt(int wd) const {
+    return std::find_if(roots_.begin(), roots_.end(),
+                        [wd](const auto& root) { return root.second.wd == wd; });
+  }
+
+  // Whether `wd` is `ancestor` or lies below it.
+  bool Within(int wd, int ancestor) const {
+    for (auto found = directories_.find(wd); found != directories_.end();
+         found = directories_.find(found->second.parent)) {
+      if (found->first == ancestor) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // The depth `wd` is watched to for its parent and for a root at it.
+  uint32_t Allowance(int wd) const {
+    uint32_t allowance = 0;
+    const auto found = directories_.find(wd);
+    if (found != directories_.end()) {
+      const auto parent = directories_.find(found->second.parent);
+      if (parent != directories_.end() && parent->second.remaining > 0) {
+        allowance = parent->second.remaining - 1;
+      }
+    }
+    const auto root = RootAt(wd);
+    if (root != roots_.end()) {
+      allowance = std::max(allowance, root->second.depth);
+    }
+    return allowance;
+  }
+
+  // Cuts the budget of `wd` back to its allowance, unwatching directories
+  // below it that no root reaches any more.
+  void Trim(int wd) {
+    const auto found = directories_.find(wd);
+    if (found == directories_.end()) {
+      return;
+    }
+    const uint32_t allowance = Allowance(wd);
+    if (found->second.remaining <= allowance) {
+      return;
+    }
+    found->second.remaining = allowance;
+    const auto children = found->second.children;
+    for (const int child : children) {
+      if (allowance == 0 && RootAt(child) == roots_.end()) {
+        Unwatch(child);
+      } else {
+        Trim(child);
+      }
+    }
+  }
+
+  // Stops watching `wd` and the directories below it, except roots among
+  // them, which become top-level again and keep their own watches.
+  void Unwatch(int wd) {
+    const auto found = directories_.find(wd);
+    if (found == directories_.end()) {
+      return;
+    }
+    const auto root = RootAt(wd);
+    if (root != roots_.end()) {
+      Detach(wd);
+      found->second.parent = -1;
+      found->second.name = root->first;
+      Trim(wd);
+      return;
+    }
+    const auto children = found->second.children;
+    for (const int child : children) {
+      Unwatch(child);
+    }
+    ::inotify_rm_watch(fd_, wd);
+    Forget(wd);
+  }
+
+  // Removes `wd` from its parent's children.
+  void Detach(int wd) {
+    const auto found = directories_.find(wd);
+    if (found == directories_.end()) {
+      return;
+    }
+    const auto parent = directories_.find(found->second.parent);
+    if (parent == directories_.end()) {
+      return;
+    }
+    auto& siblings = parent->second.children;
+    const auto it = std::find(siblings.begin(), siblings.end(), wd);
+    if (it != siblings.end()) {
+      siblings.erase(it);
+    }
+  }
+
+  void Forget(int wd) {
+    Detach(wd);
+    directories_.erase(wd);
+  }
+
+  int ChildNamed(int wd, const char* name) const {
+    const auto found = directories_.find(wd);
+    if (found == directories_.end()) {
+      return -1;
+    }
+    for (const int child : found->second.children) {
+      const auto entry = directories_.find(child);
+      if (entry != directories_.end() && entry->second.name == name) {
+        return child;
+      }
+    }
+    return -1;
+  }
+
+  void Handle(const inotify_event& event, PendingBatch& pending, FsWatcherStats& stats) {
+    if (event.mask & IN_Q_OVERFLOW) {
+      ++stats.overflows;
+      for (const auto& root : roots_) {
+        pending.RecordOverflow(root.first);
+      }
+      return;
+    }
+
+    const auto found = directories_.find(event.wd);
+    if (found == directories_.end()) {
+      return;
+    }
+    if (event.mask & IN_IGNORED) {
+      Forget(event.wd);
+      return;
+    }
+    if (event.mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+      // Anything below a root is reported by its parent's directory events.
+      const auto root = RootAt(event.wd);
+      if (root != roots_.end()) {
+        pending.Record(WatchAction::kDelete, true, root->first);
+        roots_.erase(root);
+        Unwatch(event.wd);
+      }
+      return;
+    }
+    if (event.len == 0 || event.name[0] == '\0') {
+      return;
+    }
+
+    const bool isDirectory = (event.mask & IN_ISDIR) != 0;
+    const uint32_t remaining = found->second.remaining;
+    const auto path = JoinPath(PathOf(event.wd), event.name);
+
+    if (event.mask & (IN_CREATE | IN_MOVED_TO)) {
+      pending.Record(WatchAction::kAdd, isDirectory, path);
+      if (isDirectory && remaining > 0) {
+        Watch(path, event.wd, event.name, remaining - 1, &pending);
+      }
+    } else if (event.mask & (IN_DELETE | IN_MOVED_FROM)) {
+      pending.Record(WatchAction::kDelete, isDirectory, path);
+      if (isDirectory && (event.mask & IN_MOVED_FROM)) {
+        // The moved directory keeps its watches and would go on reporting
+        // under its old path.
+        const int child = ChildNamed(event.wd, event.name);
+        if (child >= 0) {
+          Unwatch(child);
+        }
+      }
+    } else if (event.mask & IN_CLOSE_WRITE) {
+      pending.Record(WatchAction::kChange, false, path);
+    }
+  }
+
+  int fd_;
+  std::unordered_map<int, Directory> directories_;
+  std::unordered_map<std::string, RootWatch> roots_;
+  std::string lastError_;
+};
+
+class FanotifyBackend final : public WatchBackendImpl {
+ public:
+  // Null unless this process may mark whole filesystems and resolve the
+  // directory handles the events carry. `probeRoot` is the first root to be
+  // watched.
+  static std::unique_ptr<FanotifyBackend> Create(const std::string& probeRoot) {
+    const int fd = ::fanotify_init(FAN_CLASS_NOTIF | FAN_CLOEXEC | FAN_NONBLOCK |
+                                       FAN_REPORT_DFID_NAME,
+                                   O_RDONLY | O_CLOEXEC | O_LARGEFILE);
+    if (fd < 0) {
+      return nullptr;
+    }
+    std::unique_ptr<FanotifyBackend> backend(new FanotifyBackend(fd));
+    std::string error;
+    if (!backend->AddRoot(probeRoot, 0, error) || backend->ResolveDirectory(probeRoot).empty()) {
+      return nullptr;
+    }
+    backend->RemoveRoot(probeRoot);
+    return backend;
+  }
+
+  ~FanotifyBackend() override {
+    for (const auto& filesystem : filesystems_) {
+      ::close(filesystem.mountFd);
+    }
+    ::close(fd_);
+  }
+
+  const char* name() const override {
+    return "fanotify";
+  }
+
+  int fd() const override {
+    return fd_;
+  }
+
+  uint64_t watches() const override {
+    return filesystems_.size();
+  }
+
+  uint64_t roots() const override {
+    return roots_.size();
+  }
+
+  bool AddRoot(const std::string& root, uint32_t depth, std::string& error) override {
+    struct stat info {};
+    if (::stat(root.c_str(), &info) != 0) {
+      error = ErrnoName(errno);
+      return false;
+    }
+
+    if (FilesystemFor(info.st_dev) == nullptr) {
+      const int mountFd = ::open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+      if (mountFd < 0) {
+        error = ErrnoName(errno);
+        return false;
+      }
+      struct statfs fsInfo {};
+      if (::fstatfs(mountFd, &fsInfo) != 0 ||
+          ::fanotify_mark(fd_, FAN_MARK_ADD | FAN_MARK_FILESYSTEM, kFanotifyMask, AT_FDCWD,
+                          root.c_str()) != 0) {
+        error = ErrnoName(errno);
+        ::close(mountFd);
+        return false;
+      }
+      Filesystem filesystem;
+      filesystem.device = info.st_dev;
+      std::memcpy(&filesystem.fsid, &fsInfo.f_fsid, sizeof(filesystem.fsid));
+      filesystem.mountFd = mountFd;
+      filesystems_.push_back(filesystem);
+    }
+
+    for (auto& existing : roots_) {
+      if (existing.path == root) {
+        existing.depth = std::max(existing.depth, depth);
+        return true;
+      }
+    }
+    roots_.push_back(Root{root, depth, info.st_dev});
+    return true;
+  }
+
+  void RemoveRoot(const std::string& root) override {
+    dev_t device = 0;
+    bool found = false;
+    for (auto it = roots_.begin(); it != roots_.end(); ++it) {
+      if (it->path == root) {
+        device = it->device;
+        roots_.erase(it);
+        found = true;
+        break;
+      }
+    }
+    if (!found) {
+      return;
+    }
+    for (const auto& other : roots_) {
+      if (other.device == device) {
+        return;
+      }
+    }
+    for (auto it = filesystems_.begin(); it != filesystems_.end(); ++it) {
+      if (it->device == device) {
+        ::fanotify_mark(fd_, FAN_MARK_REMOVE | FAN_MARK_FILESYSTEM, kFanotifyMask, it->mountFd,
+                        nullptr);
+        ::close(it->mountFd);
+        filesystems_.erase(it);
+        break;
+      }
+    }
+    handleCache_.clear();
+  }
+
+  // Event records are packed back to back with no padding, so each header
+  // is copied out rather than read in place.
+  void Drain(PendingBatch& pending, FsWatcherStats& stats) override {
+    alignas(fanotify_event_metadata) char buffer[kReadBufferBytes];
+    while (true) {
+      const ssize_t length = ::read(fd_, buffer, sizeof(buffer));
+      if (length <= 0) {
+        break;
+      }
+      size_t offset = 0;
+      while (offset + sizeof(fanotify_event_metadata) <= static_cast<size_t>(length)) {
+        fanotify_event_metadata event;
+        std::memcpy(&event, buffer + offset, sizeof(event));
+        if (event.vers != FANOTIFY_METADATA_VERSION || event.event_len < sizeof(event) ||
+            offset + event.event_len > static_cast<size_t>(length)) {
+          return;
+        }
+        ++stats.rawEvents;
+        Handle(event, buffer + offset, pending, stats);
+        offset += event.event_len;
+      }
+    }
+  }
+
+ private:
+  struct Filesystem {
+    dev_t device = 0;
+    int32_t fsid[2] = {0, 0};
+    int mountFd = -1;
+  };
+
+  struct Root {
+    std::string path;
+    uint32_t depth = 0;
+    dev_t device = 0;
+  };
+
+  explicit FanotifyBackend(int fd) : fd_(fd) {}
+
+  const Filesystem* FilesystemFor(dev_t device) const {
+    for (const auto& filesystem : filesystems_) {
+      if (filesystem.device == device) {
+        return &filesystem;
+      }
+    }
+    return nullptr;
+  }
+
+  const Filesystem* FilesystemFor(const int32_t* fsid) const {
+    for (const auto& filesystem : filesystems_) {
+      if (std::memcmp(filesystem.fsid, fsid, sizeof(filesystem.fsid)) == 0) {
+        return &filesystem;
+      }
+    }
+    return nullptr;
+  }
+
+  // Used once at startup to prove handles resolve for this process.
+  std::string ResolveDirectory(const std::string& path) {
+    std::vector<uint8_t> storage(sizeof(file_handle) + MAX_HANDLE_SZ);
+    auto* handle = reinterpret_cast<file_handle*>(storage.data());
+    handle->handle_bytes = MAX_HANDLE_SZ;
+    int mountId = 0;
+    struct stat info {};
+    if (::name_to_handle_at(AT_FDCWD, path.c_str(), handle, &mountId, 0) != 0 ||
+        ::stat(path.c_str(), &info) != 0) {
+      return "";
+    }
+    const auto* filesystem = FilesystemFor(info.st_dev);
+    return filesystem != nullptr ? OpenHandle(*filesystem, handle) : "";
+  }
+
+  static std::string OpenHandle(const Filesystem& filesystem, file_handle* handle) {
+    const int fd = ::open_by_handle_at(filesystem.mountFd, handle, O_PATH | O_CLOEXEC);
+    if (fd < 0) {
+      return "";
+    }
+    char link[64];
+    std::snprintf(link, sizeof(link), "/proc/self/fd/%d", fd);
+    char target[4096];
+    const ssize_t length = ::readlink(link, target, sizeof(target));
+    ::close(fd);
+    if (length <= 0 || static_cast<size_t>(length) >= sizeof(target)) {
+      return "";
+    }
+    std::string path(target, static_cast<size_t>(length));
+    // The directory went away after the event was queued.
+    static constexpr char kDeleted[] = " (deleted)";
+    if (path.size() > sizeof(kDeleted) - 1 &&
+        path.compare(path.size() - (sizeof(kDeleted) - 1), std::string::npos, kDeleted) == 0) {
+      return "";
+    }
+    return path;
+  }
+
+  // One FAN_EVENT_INFO_TYPE_DFID_NAME record: the directory's fsid and file
+  // handle, then the entry name.
+  struct EntryInfo {
+    const char* fsid;
+    uint32_t handleBytes;
+    int32_t handleType;
+    const char* handle;
+    const char* name;
+  };
+
+  std::string DirectoryPath(const EntryInfo& info) {
+    std::string key(info.fsid, sizeof(__kernel_fsid_t));
+    key.append(reinterpret_cast<const char*>(&info.handleType), sizeof(info.handleType));
+    key.append(info.handle, info.handleBytes);
+
+    const auto cached = handleCache_.find(key);
+    if (cached != handleCache_.end()) {
+      return cached->second;
+    }
+    int32_t fsid[2];
+    std::memcpy(fsid, info.fsid, sizeof(fsid));
+    const auto* filesystem = FilesystemFor(fsid);
+    if (filesystem == nullptr) {
+      return "";
+    }
+
+    std::vector<uint8_t> storage(sizeof(file_handle) + info.handleBytes);
+    auto* handle = reinterpret_cast<file_handle*>(storage.data());
+    handle->handle_bytes = info.handleBytes;
+    handle->handle_type = info.handleType;
+    std::memcpy(handle->f_handle, info.handle, info.handleBytes);
+    auto path = OpenHandle(*filesystem, handle);
+    if (!path.empty()) {
+      if (handleCache_.size() >= kHandleCacheLimit) {
+        handleCache_.clear();
+      }
+      handleCache_.emplace(std::move(key), path);
+    }
+    return path;
+  }
+
+  // Depth of `directory` below `root` (0 for the root itself), or -1 when it
+  // is not inside it.
+  static int DepthBelow(const std::string& root, const std::string& directory) {
+    if (directory.compare(0, root.size(), root) != 0) {
+      return -1;
+    }
+    if (directory.size() == root.size()) {
+      return 0;
+    }
+    size_t start = root.size();
+    if (root != "/") {
+      if (directory[start] != '/') {
+        return -1;
+      }
+      ++start;
+    }
+    int depth = 1;
+    for (size_t i = start; i < directory.size(); ++i) {
+      depth += directory[i] == '/' ? 1 : 0;
+    }
+    return depth;
+  }
+
+  void Handle(const fanotify_event_metadata& event, const char* record, PendingBatch& pending,
+              FsWatcherStats& stats) {
+    if (event.mask & FAN_Q_OVERFLOW) {
+      ++stats.overflows;
+      for (const auto& root : roots_) {
+        pending.RecordOverflow(root.path);
+      }
+      return;
+    }
+
+    constexpr size_t kFsidOffset = sizeof(fanotify_event_info_header);
+    constexpr size_t kHandleOffset = kFsidOffset + sizeof(__kernel_fsid_t);
+    constexpr size_t kHandleDataOffset = kHandleOffset + sizeof(file_handle);
+    for (size_t offset = event.metadata_len;
+         offset + sizeof(fanotify_event_info_header) <= event.event_len;) {
+      fanotify_event_info_header header;
+      std::memcpy(&header, record + offset, sizeof(header));
+      if (header.len == 0 || offset + header.len > event.event_len) {
+        break;
+      }
+      if (header.info_type == FAN_EVENT_INFO_TYPE_DFID_NAME && header.len > kHandleDataOffset) {
+        const char* info = record + offset;
+        file_handle handle;
+        std::memcpy(&handle, info + kHandleOffset, sizeof(handle));
+        if (kHandleDataOffset + handle.handle_bytes < header.len) {
+          HandleEntry(event.mask,
+                      EntryInfo{info + kFsidOffset, handle.handle_bytes, handle.handle_type,
+                                info + kHandleDataOffset,
+                                info + kHandleDataOffset + handle.handle_bytes},
+                      pending);
+        }
+      }
+      offset += header.len;
+    }
+  }
+
+  void HandleEntry(uint64_t mask, const EntryInfo& info, PendingBatch& pending) {
+    const char* name = info.name;
+    if (name[0] == '\0' || (name[0] == '.' && name[1] == '\0')) {
+      return;
+    }
+
+    const auto directory = DirectoryPath(info);
+    if (directory.empty()) {
+      return;
+    }
+    // Levels still reported below `directory`, under the root that reaches
+    // deepest; -1 when no root covers it.
+    int remaining = -1;
+    for (const auto& root : roots_) {
+      const int below = DepthBelow(root.path, directory);
+      if (below >= 0 && below <= static_cast<int>(root.depth)) {
+        remaining = std::max(remaining, static_cast<int>(root.depth) - below);
+      }
+    }
+    if (remaining < 0) {
+      return;
+    }
+
+    const bool isDirectory = (mask & FAN_ONDIR) != 0;
+    const auto path = JoinPath(directory, name);
+    if (isDirectory && (mask & (FAN_MOVED_FROM | FAN_MOVED_TO | FAN_DELETE))) {
+      handleCache_.clear();
+    }
+
+    const bool appeared = (mask & (FAN_CREATE | FAN_MOVED_TO)) != 0;
+    const bool vanished = (mask & (FAN_DELETE | FAN_MOVED_FROM)) != 0;
+    if (appeared && vanished) {
+      // Merged in the queue, so the order is lost; what is there now decides
+      // between "created and removed" and "removed and created again".
+      struct stat info {};
+      const bool existsNow = ::lstat(path.c_str(), &info) == 0;
+      pending.Record(existsNow ? WatchAction::kDelete : WatchAction::kAdd, isDirectory, path);
+      pending.Record(existsNow ? WatchAction::kAdd : WatchAction::kDelete, isDirectory, path);
+    } else if (appeared) {
+      pending.Record(WatchAction::kAdd, isDirectory, path);
+      if (isDirectory && remaining > 0) {
+        WalkEntries(path, remaining - 1, [&pending](const std::string& entry, bool dir) {
+          pending.Record(WatchAction::kAdd, dir, entry);
+        });
+      }
+    } else if (vanished) {
+      pending.Record(WatchAction::kDelete, isDirectory, path);
+    } else if (mask & FAN_CLOSE_WRITE) {
+      pending.Record(WatchAction::kChange, false, path);
+    }
+  }
+
+  int fd_;
+  std::vector<Filesystem> filesystems_;
+  std::vector<Root> roots_;
+  std::unordered_map<std::string, std::string> handleCache_;
+};
+
+}  // namespace
+
+FsWatcher::FsWatcher(FsWatcherOptions options, WatchSink sink)
+    : options_(options), sink_(std::move(sink)) {
+  if (options_.maxBatch == 0) {
+    options_.maxBatch = 1;
+  }
+}
+
+FsWatcher::~FsWatcher() {
+  Close();
+}
+
+bool FsWatcher::AddRoot(const std::string& rawRoot, uint32_t depth, std::string& error) {
+  const auto root = NormalizeRoot(rawRoot);
+  struct stat info {};
+  if (::stat(root.c_str(), &info) != 0) {
+    error = ErrnoName(errno);
+    return false;
+  }
+  if (!S_ISDIR(info.st_mode)) {
+    error = "ENOTDIR";
+    return false;
+  }
+  if (::access(root.c_str(), R_OK | X_OK) != 0) {
+    error = ErrnoName(errno);
+    return false;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closed_) {
+      error = "ERR_EVERYTHING_WATCHER_CLOSED";
+      return false;
+    }
+    if (backend_ == nullptr && !StartLocked(root, error)) {
+      return false;
+    }
+    PostLocked(Command{true, root, depth});
+  }
+  return true;
+}
+
+void FsWatcher::RemoveRoot(const std::string& root) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!closed_ && backend_ != nullptr) {
+    PostLocked(Command{false, NormalizeRoot(root), 0});
+  }
+}
+
+bool FsWatcher::StartLocked(const std::string& firstRoot, std::string& error) {
+  if (options_.backend != WatchBackend::kInotify) {
+    backend_ = FanotifyBackend::Create(firstRoot);
+  }
+  if (backend_ == nullptr && options_.backend != WatchBackend::kFanotify) {
+    backend_ = InotifyBackend::Create(error);
+  }
+  if (backend_ == nullptr) {
+    if (error.empty()) {
+      error = "EPERM";
+    }
+    return false;
+  }
+
+  wakeFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (wakeFd_ < 0) {
+    error = ErrnoName(errno);
+    backend_.reset();
+    return false;
+  }
+  stats_.backend = backend_->name();
+  thread_ = std::thread([this] { Run(); });
+  return true;
+}
+
+// Under the lock, so Close cannot shut the eventfd in between.
+void FsWatcher::PostLocked(Command command) {
+  commands_.push_back(std::move(command));
+  const uint64_t one = 1;
+  (void)::write(wakeFd_, &one, sizeof(one));
+}
+
+void FsWatcher::Close() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closed_) {
+      return;
+    }
+    closed_ = true;
+  }
+  stopping_.store(true);
+  if (thread_.joinable()) {
+    const uint64_t one = 1;
+    (void)::write(wakeFd_, &one, sizeof(one));
+    thread_.join();
+  }
+  if (wakeFd_ >= 0) {
+    ::close(wakeFd_);
+    wakeFd_ = -1;
+  }
+  backend_.reset();
+}
+
+FsWatcherStats FsWatcher::Stats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void FsWatcher::Run() {
+  PendingBatch pending;
+  FsWatcherStats local;
+  bool deadlineSet = false;
+  std::chrono::steady_clock::time_point deadline;
+
+  pollfd fds[2] = {{wakeFd_, POLLIN, 0}, {backend_->fd(), POLLIN, 0}};
+  while (!stopping_.load()) {
+    int timeout = -1;
+    if (deadlineSet) {
+      const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+          deadline - std::chrono::steady_clock::now());
+      timeout = static_cast<int>(std::max<int64_t>(left.count(), 0));
+    }
+    if (::poll(fds, 2, timeout) < 0 && errno != EINTR) {
+      break;
+    }
+    if (stopping_.load()) {
+      break;
+    }
+
+    if (fds[0].revents & POLLIN) {
+      uint64_t ignored = 0;
+      (void)::read(wakeFd_, &ignored, sizeof(ignored));
+      std::vector<Command> commands;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        commands.swap(commands_);
+      }
+      for (const auto& command : commands) {
+        std::string error;
+        if (command.add) {
+          if (!backend_->AddRoot(command.root, command.depth, error)) {
+            local.lastError = command.root + ": " + error;
+          }
+        } else {
+          backend_->RemoveRoot(command.root);
+        }
+      }
+    }
+    if (fds[1].revents & POLLIN) {
+      backend_->Drain(pending, local);
+    }
+
+    if (!pending.empty() && !deadlineSet) {
+      deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(options_.latencyMs);
+      deadlineSet = true;
+    }
+
+    const bool due = deadlineSet && std::chrono::steady_clock::now() >= deadline;
+    std::vector<WatchEvent> batch;
+    if (!pending.empty() && (due || pending.size() >= options_.maxBatch)) {
+      batch = pending.Take();
+    }
+    if (due || pending.empty()) {
+      deadlineSet = !pending.empty();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stats_.roots = backend_->roots();
+      stats_.watches = backend_->watches();
+      stats_.rawEvents = local.rawEvents;
+      stats_.overflows = local.overflows;
+      if (!local.lastError.empty()) {
+        stats_.lastError = local.lastError;
+      }
+      if (!batch.empty()) {
+        stats_.deliveredEvents += batch.size();
+        ++stats_.batches;
+      }
+    }
+    if (!batch.empty()) {
+      sink_(std::move(batch));
+    }
+  }
+}
+
+}  // namespace tuff::native::everything
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tuff::native::everything {
+
+enum class WatchAction : uint8_t {
+  kAdd,
+  kChange,
+  kDelete,
+  // The kernel queue overflowed and events under `path` (a root) were lost;
+  // the consumer should rescan it.
+  kOverflow,
+};
+
+struct WatchEvent {
+  WatchAction action = WatchAction::kChange;
+  bool isDirectory = false;
+  std::string path;
+};
+
+enum class WatchBackend : uint8_t {
+  kAuto,
+  kFanotify,
+  kInotify,
+};
+
+struct FsWatcherOptions {
+  WatchBackend backend = WatchBackend::kAuto;
+  // How long events are held and coalesced after the first one of a burst.
+  uint32_t latencyMs = 100;
+  // A batch is delivered early once it holds this many paths.
+  uint32_t maxBatch = 1024;
+};
+
+struct FsWatcherStats {
+  std::string backend;  // "fanotify" | "inotify" | "" before start
+  uint64_t roots = 0;
+  // Kernel watches held: one per directory for inotify, one per filesystem
+  // for fanotify.
+  uint64_t watches = 0;
+  uint64_t rawEvents = 0;
+  uint64_t deliveredEvents = 0;
+  uint64_t batches = 0;
+  uint64_t overflows = 0;
+  std::string lastError;
+};
+
+// Receives coalesced batches on the watcher thread.
+using WatchSink = std::function<void(std::vector<WatchEvent>&& batch)>;
+
+class WatchBackendImpl;
+
+// Native replacement for a set of chokidar instances on Linux. One thread
+// reads the kernel queue, turns raw events into add/change/delete per path,
+// coalesces them for `latencyMs` and hands each batch to the sink.
+//
+// Two kernel interfaces back it:
+// - fanotify with FAN_MARK_FILESYSTEM and FAN_REPORT_DFID_NAME: one mark per
+//   filesystem covers every directory, so nothing is walked up front and the
+//   cost does not grow with the tree. Needs CAP_SYS_ADMIN (for the mark) and
+//   CAP_DAC_READ_SEARCH (to resolve directory handles), so it is what a
+//   privileged helper gets.
+// - inotify otherwise: one watch per directory down to each root's depth,
+//   kept as a parent-linked table of names, so memory is a few dozen bytes
+//   per directory rather than a JS watcher object per path.
+//
+// "change" is reported on close-after-write rather than on every write, which
+// is what chokidar's awaitWriteFinish approximated by polling. A directory
+// that appears (created or moved in) is scanned and its entries reported as
+// added, as chokidar does.
+class FsWatcher {
+ public:
+  FsWatcher(FsWatcherOptions options, WatchSink sink);
+  ~FsWatcher();
+
+  FsWatcher(const FsWatcher&) = delete;
+  FsWatcher& operator=(const FsWatcher&) = delete;
+
+  // Starts the thread on first use. Returns false with `error` set (an errno
+  // name such as ENOENT or EACCES) when `root` cannot be watched.
+  bool AddRoot(const std::string& root, uint32_t depth, std::string& error);
+  void RemoveRoot(const std::string& root);
+
+  // Stops the thread; no batch is delivered after this returns.
+  void Close();
+
+  FsWatcherStats Stats();
+
+ private:
+  struct Command {
+    bool add = true;
+    std::string root;
+    uint32_t depth = 0;
+  };
+
+  bool StartLocked(const std::string& firstRoot, std::string& error);
+  void PostLocked(Command command);
+  void Run();
+
+  FsWatcherOptions options_;
+  WatchSink sink_;
+  std::mutex mutex_;
+  std::vector<Command> commands_;
+  std::unique_ptr<WatchBackendImpl> backend_;
+  std::thread thread_;
+  int wakeFd_ = -1;
+  bool closed_ = false;
+  std::atomic<bool> stopping_{false};
+  FsWatcherStats stats_;
+};
+
+}  // namespace tuff::native::everything
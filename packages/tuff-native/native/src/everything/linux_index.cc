@@ -0,0 +1,1136 @@
+#include "everything/linux_index.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <numeric>
+#include <regex>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+#include "everything/stat_at.h"
+
+namespace tuff::native::everything {
+
+namespace {
+
+constexpr char kSnapshotMagic[8] = {'T', 'U', 'F', 'F', 'I', 'D', 'X', '\0'};
+constexpr uint32_t kSnapshotVersion = 1;
+constexpr uint16_t kEntryFolder = 0x0001;
+constexpr uint16_t kEntryRoot = 0x0002;
+constexpr int kMaxWalkDepth = 256;
+constexpr uint64_t kMaxHeapSize = 0xFFFFFFF0ULL;
+constexpr int64_t kSnapshotStaleMs = 6LL * 60 * 60 * 1000;
+
+// Fixed-size record; the snapshot stores an array of these verbatim, so the
+// layout is part of the file format (bump kSnapshotVersion when it changes).
+struct IndexEntry {
+  uint64_t size;
+  // Index of the parent entry, or of the owning root in the roots table when
+  // kEntryRoot is set.
+  uint32_t parent;
+  uint32_t nameOffset;
+  uint32_t nameRank;
+  uint32_t modifiedSec;
+  uint32_t createdSec;
+  uint16_t nameLength;
+  uint16_t flags;
+  uint16_t extensionOffset;  // == nameLength when the name has no extension
+  uint16_t reserved0;
+  uint32_t reserved1;
+};
+static_assert(sizeof(IndexEntry) == 40, "IndexEntry is part of the snapshot format");
+
+struct SnapshotHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t entrySize;
+  uint64_t entryCount;
+  uint64_t entriesOffset;
+  uint64_t heapOffset;
+  uint64_t heapSize;
+  uint64_t foldedOffset;
+  uint64_t rootsOffset;
+  uint64_t rootsSize;
+  int64_t builtAtMs;
+  uint64_t fileSize;
+};
+
+int64_t NowMillis() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+double ElapsedMs(std::chrono::steady_clock::time_point startedAt) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startedAt)
+      .count();
+}
+
+uint64_t AlignUp(uint64_t value) {
+  return (value + 7U) & ~uint64_t{7};
+}
+
+char FoldAscii(char c) {
+  return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+std::string FoldAscii(std::string_view value) {
+  std::string folded(value);
+  for (auto& c : folded) {
+    c = FoldAscii(c);
+  }
+  return folded;
+}
+
+int CompareFolded(std::string_view left, std::string_view right) {
+  const size_t length = std::min(left.size(), right.size());
+  for (size_t i = 0; i < length; ++i) {
+    const auto a = static_cast<unsigned char>(FoldAscii(left[i]));
+    const auto b = static_cast<unsigned char>(FoldAscii(right[i]));
+    if (a != b) {
+      return a < b ? -1 : 1;
+    }
+  }
+  if (left.size() != right.size()) {
+    return left.size() < right.size() ? -1 : 1;
+  }
+  return left.compare(right);
+}
+
+uint32_t ClampSeconds(time_t seconds) {
+  if (seconds <= 0) {
+    return 0;
+  }
+  return static_cast<uint32_t>(std::min<int64_t>(seconds, 0xFFFFFFFFLL));
+}
+
+// What the index keeps of one stat result.
+struct EntryInfo {
+  bool isFolder = false;
+  uint64_t size = 0;
+  time_t modifiedSec = 0;
+  time_t createdSec = 0;
+};
+
+// The created time is the birth time where the filesystem records one, and
+// the inode change time otherwise, which is what the tree scanner reports.
+bool StatEntry(int dirFd, const char* name, int flags, EntryInfo& result) {
+  struct statx info {};
+  if (!StatAt(dirFd, name, flags, STATX_TYPE | STATX_SIZE | STATX_MTIME | STATX_CTIME | STATX_BTIME, info)) {
+    return false;
+  }
+  result.isFolder = S_ISDIR(info.stx_mode);
+  result.size = result.isFolder ? 0 : info.stx_size;
+  result.modifiedSec = static_cast<time_t>(info.stx_mtime.tv_sec);
+  result.createdSec =
+      static_cast<time_t>((info.stx_mask & STATX_BTIME) ? info.stx_btime.tv_sec : info.stx_ctime.tv_sec);
+  return true;
+}
+
+std::string ReadEnv(const char* key) {
+  const char* value = std::getenv(key);
+  return value != nullptr ? std::string(value) : std::string();
+}
+
+std::vector<std::string> SplitList(const std::string& value) {
+  std::vector<std::string> parts;
+  size_t start = 0;
+  while (start <= value.size()) {
+    const size_t end = value.find(':', start);
+    auto part = value.substr(start, end == std::string::npos ? std::string::npos : end - start);
+    if (!part.empty()) {
+      parts.push_back(std::move(part));
+    }
+    if (end == std::string::npos) {
+      break;
+    }
+    start = end + 1;
+  }
+  return parts;
+}
+
+std::string NormalizeRoot(std::string root) {
+  while (root.size() > 1 && root.back() == '/') {
+    root.pop_back();
+  }
+  return root;
+}
+
+std::string DefaultSnapshotPath() {
+  const auto custom = ReadEnv("TALEX_EVERYTHING_INDEX_PATH");
+  if (!custom.empty()) {
+    return custom;
+  }
+
+  auto cacheHome = ReadEnv("XDG_CACHE_HOME");
+  if (cacheHome.empty()) {
+    const auto home = ReadEnv("HOME");
+    if (home.empty()) {
+      return "";
+    }
+    cacheHome = home + "/.cache";
+  }
+  return cacheHome + "/talex-touch/everything-index.bin";
+}
+
+IndexBuildOptions WithDefaults(IndexBuildOptions options) {
+  if (options.roots.empty()) {
+    options.roots = SplitList(ReadEnv("TALEX_EVERYTHING_INDEX_ROOTS"));
+  }
+  if (options.roots.empty()) {
+    const auto home = ReadEnv("HOME");
+    options.roots.push_back(home.empty() ? "/" : home);
+  }
+  for (auto& root : options.roots) {
+    root = NormalizeRoot(root);
+  }
+
+  // Pseudo filesystems are never worth indexing and /proc alone is unbounded.
+  for (const char* pseudo : {"/proc", "/sys", "/dev", "/run"}) {
+    options.excludes.emplace_back(pseudo);
+  }
+  for (auto& exclude : SplitList(ReadEnv("TALEX_EVERYTHING_INDEX_EXCLUDES"))) {
+    options.excludes.push_back(std::move(exclude));
+  }
+  for (auto& exclude : options.excludes) {
+    exclude = NormalizeRoot(exclude);
+  }
+
+  if (options.snapshotPath.empty()) {
+    options.snapshotPath = DefaultSnapshotPath();
+  }
+  return options;
+}
+
+bool EnsureParentDirectory(const std::string& filePath) {
+  const auto slash = filePath.find_last_of('/');
+  if (slash == std::string::npos || slash == 0) {
+    return true;
+  }
+
+  std::string current;
+  size_t position = 0;
+  const std::string parent = filePath.substr(0, slash);
+  while (position != std::string::npos) {
+    position = parent.find('/', position + 1);
+    current = parent.substr(0, position);
+    if (current.empty()) {
+      continue;
+    }
+    if (::mkdir(current.c_str(), 0700) != 0 && errno != EEXIST) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool IsWordByte(unsigned char c) {
+  return c >= 0x80 || c == '_' || (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') ||
+      (c >= 'A' && c <= 'Z');
+}
+
+bool ContainsTerm(std::string_view haystack, std::string_view term, bool wholeWord) {
+  size_t position = haystack.find(term);
+  while (position != std::string_view::npos) {
+    if (!wholeWord) {
+      return true;
+    }
+    const size_t end = position + term.size();
+    const bool startsWord =
+        position == 0 || !IsWordByte(static_cast<unsigned char>(haystack[position - 1]));
+    const bool endsWord =
+        end >= haystack.size() || !IsWordByte(static_cast<unsigned char>(haystack[end]));
+    if (startsWord && endsWord) {
+      return true;
+    }
+    position = haystack.find(term, position + 1);
+  }
+  return false;
+}
+
+// Everything-style wildcards: `*` and `?` match against the whole string.
+bool GlobMatch(std::string_view text, std::string_view pattern) {
+  size_t t = 0;
+  size_t p = 0;
+  size_t starPattern = std::string_view::npos;
+  size_t starText = 0;
+  while (t < text.size()) {
+    if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t])) {
+      ++t;
+      ++p;
+    } else if (p < pattern.size() && pattern[p] == '*') {
+      starPattern = p++;
+      starText = t;
+    } else if (starPattern != std::string_view::npos) {
+      p = starPattern + 1;
+      t = ++starText;
+    } else {
+      return false;
+    }
+  }
+  while (p < pattern.size() && pattern[p] == '*') {
+    ++p;
+  }
+  return p == pattern.size();
+}
+
+struct QueryTerm {
+  std::string text;
+  bool wildcard = false;
+  bool hasSeparator = false;
+};
+
+// Whitespace separates AND-ed terms; double quotes keep a phrase together.
+std::vector<QueryTerm> ParseTerms(const std::string& query, bool fold) {
+  std::vector<QueryTerm> terms;
+  std::string current;
+  bool quoted = false;
+  auto flush = [&]() {
+    if (current.empty()) {
+      return;
+    }
+    QueryTerm term;
+    term.text = fold ? FoldAscii(current) : current;
+    term.wildcard = term.text.find_first_of("*?") != std::string::npos;
+    term.hasSeparator = term.text.find('/') != std::string::npos;
+    terms.push_back(std::move(term));
+    current.clear();
+  };
+
+  for (const char c : query) {
+    if (c == '"') {
+      quoted = !quoted;
+      continue;
+    }
+    if (!quoted && (c == ' ' || c == '\t')) {
+      flush();
+      continue;
+    }
+    current.push_back(c);
+  }
+  flush();
+  return terms;
+}
+
+class IndexBuilder {
+ public:
+  IndexBuilder(const IndexBuildOptions& options, std::atomic<uint64_t>& scanned)
+      : excludes_(options.excludes), scanned_(scanned) {}
+
+  void AddRoot(const std::string& root) {
+    if (root.empty() || root.front() != '/' || IsExcluded(root)) {
+      return;
+    }
+
+    const int fd = ::open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+      return;
+    }
+
+    EntryInfo info;
+    if (!StatEntry(fd, "", AT_EMPTY_PATH, info)) {
+      ::close(fd);
+      return;
+    }
+
+    const auto rootIndex = static_cast<uint32_t>(roots_.size());
+    roots_.push_back(root);
+    const auto slash = root.find_last_of('/');
+    const std::string_view name =
+        root == "/" ? std::string_view(root) : std::string_view(root).substr(slash + 1);
+    const uint32_t entry = Append(name, info, rootIndex, kEntryRoot | kEntryFolder);
+    if (entry == UINT32_MAX) {
+      ::close(fd);
+      return;
+    }
+
+    std::string path = root;
+    WalkDirectory(fd, entry, path, 0);
+  }
+
+  std::vector<char> Finish(int64_t builtAtMs) {
+    const uint64_t count = entries_.size();
+
+    std::vector<uint32_t> order(count);
+    std::iota(order.begin(), order.end(), 0U);
+    std::sort(order.begin(), order.end(), [this](uint32_t left, uint32_t right) {
+      const int compared = CompareFolded(NameOf(left), NameOf(right));
+      return compared != 0 ? compared < 0 : left < right;
+    });
+    for (uint32_t rank = 0; rank < count; ++rank) {
+      entries_[order[rank]].nameRank = rank;
+    }
+
+    std::string rootsBlob;
+    for (const auto& root : roots_) {
+      rootsBlob.append(root);
+      rootsBlob.push_back('\0');
+    }
+
+    SnapshotHeader header{};
+    std::memcpy(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic));
+    header.version = kSnapshotVersion;
+    header.entrySize = sizeof(IndexEntry);
+    header.entryCount = count;
+    header.entriesOffset = AlignUp(sizeof(SnapshotHeader));
+    header.heapOffset = AlignUp(header.entriesOffset + count * sizeof(IndexEntry));
+    header.heapSize = heap_.size();
+    header.foldedOffset = AlignUp(header.heapOffset + heap_.size());
+    header.rootsOffset = AlignUp(header.foldedOffset + heap_.size());
+    header.rootsSize = rootsBlob.size();
+    header.builtAtMs = builtAtMs;
+    header.fileSize = header.rootsOffset + rootsBlob.size();
+
+    std::vector<char> image(header.fileSize, '\0');
+    std::memcpy(image.data(), &header, sizeof(header));
+    if (count > 0) {
+      std::memcpy(image.data() + header.entriesOffset, entries_.data(), count * sizeof(IndexEntry));
+    }
+    std::memcpy(image.data() + header.heapOffset, heap_.data(), heap_.size());
+    char* folded = image.data() + header.foldedOffset;
+    for (size_t i = 0; i < heap_.size(); ++i) {
+      folded[i] = FoldAscii(heap_[i]);
+    }
+    std::memcpy(image.data() + header.rootsOffset, rootsBlob.data(), rootsBlob.size());
+
+    entries_.clear();
+    entries_.shrink_to_fit();
+    heap_.clear();
+    heap_.shrink_to_fit();
+    return image;
+  }
+
+ private:
+  std::string_view NameOf(uint32_t index) const {
+    const auto& entry = entries_[index];
+    return std::string_view(heap_.data() + entry.nameOffset, entry.nameLength);
+  }
+
+  bool IsExcluded(const std::string& path) const {
+    for (const auto& exclude : excludes_) {
+      if (path == exclude) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  uint32_t Append(std::string_view name, const EntryInfo& info, uint32_t parent, uint16_t flags) {
+    if (entries_.size() >= UINT32_MAX - 1 || heap_.size() + name.size() + 1 > kMaxHeapSize ||
+        name.size() > UINT16_MAX) {
+      return UINT32_MAX;
+    }
+
+    IndexEntry entry{};
+    entry.size = info.size;
+    entry.parent = parent;
+    entry.nameOffset = static_cast<uint32_t>(heap_.size());
+    entry.modifiedSec = ClampSeconds(info.modifiedSec);
+    entry.createdSec = ClampSeconds(info.createdSec);
+    entry.nameLength = static_cast<uint16_t>(name.size());
+    entry.flags = flags;
+
+    const auto dot = name.find_last_of('.');
+    entry.extensionOffset = (dot != std::string_view::npos && dot + 1 < name.size())
+        ? static_cast<uint16_t>(dot + 1)
+        : entry.nameLength;
+
+    heap_.append(name.data(), name.size());
+    heap_.push_back('\0');
+    entries_.push_back(entry);
+    scanned_.fetch_add(1, std::memory_order_relaxed);
+    return static_cast<uint32_t>(entries_.size() - 1);
+  }
+
+  // Takes ownership of dirFd. Children are appended in folded-name order and
+  // each directory's subtree directly follows it, which is what makes entry
+  // order equal to path order.
+  void WalkDirectory(int dirFd, uint32_t parent, std::string& path, int depth) {
+    DIR* dir = ::fdopendir(dirFd);
+    if (dir == nullptr) {
+      ::close(dirFd);
+      return;
+    }
+
+    std::vector<std::string> children;
+    while (const dirent* item = ::readdir(dir)) {
+      const char* name = item->d_name;
+      if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+        continue;
+      }
+      children.emplace_back(name);
+    }
+    std::sort(children.begin(), children.end(), [](const std::string& left, const std::string& right) {
+      return CompareFolded(left, right) < 0;
+    });
+
+    const int fd = ::dirfd(dir);
+    for (const auto& child : children) {
+      EntryInfo info;
+      if (!StatEntry(fd, child.c_str(), AT_SYMLINK_NOFOLLOW, info)) {
+        continue;
+      }
+
+      const bool isFolder = info.isFolder;
+      const uint32_t entry = Append(child, info, parent, isFolder ? kEntryFolder : 0);
+      if (entry == UINT32_MAX) {
+        break;
+      }
+      if (!isFolder || depth + 1 >= kMaxWalkDepth) {
+        continue;
+      }
+
+      const size_t previousLength = path.size();
+      if (path.back() != '/') {
+        path.push_back('/');
+      }
+      path.append(child);
+      if (!IsExcluded(path)) {
+        const int childFd =
+            ::openat(fd, child.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if (childFd >= 0) {
+          WalkDirectory(childFd, entry, path, depth + 1);
+        }
+      }
+      path.resize(previousLength);
+    }
+
+    ::closedir(dir);
+  }
+
+  std::vector<IndexEntry> entries_;
+  std::string heap_;
+  std::vector<std::string> roots_;
+  std::vector<std::string> excludes_;
+  std::atomic<uint64_t>& scanned_;
+};
+
+}  // namespace
+
+class FileNameIndex {
+ public:
+  static std::shared_ptr<const FileNameIndex> Open(const std::string& filePath, std::string& error) {
+    const int fd = ::open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      error = "Index snapshot not found";
+      return nullptr;
+    }
+
+    struct stat info {};
+    if (::fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(SnapshotHeader))) {
+      ::close(fd);
+      error = "Index snapshot is truncated";
+      return nullptr;
+    }
+
+    const auto size = static_cast<size_t>(info.st_size);
+    void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+      error = "Unable to map index snapshot (errno=" + std::to_string(errno) + ")";
+      return nullptr;
+    }
+
+    std::shared_ptr<FileNameIndex> index(new FileNameIndex());
+    index->mapping_ = mapping;
+    index->mappingSize_ = size;
+    if (!index->Attach(static_cast<const char*>(mapping), size, error)) {
+      return nullptr;
+    }
+    return index;
+  }
+
+  // Used when the snapshot could not be written: the image stays on the heap.
+  static std::shared_ptr<const FileNameIndex> FromImage(std::vector<char> image, std::string& error) {
+    std::shared_ptr<FileNameIndex> index(new FileNameIndex());
+    index->image_ = std::move(image);
+    if (!index->Attach(index->image_.data(), index->image_.size(), error)) {
+      return nullptr;
+    }
+    return index;
+  }
+
+  FileNameIndex(const FileNameIndex&) = delete;
+  FileNameIndex& operator=(const FileNameIndex&) = delete;
+
+  ~FileNameIndex() {
+    if (mapping_ != nullptr) {
+      ::munmap(mapping_, mappingSize_);
+    }
+  }
+
+  uint64_t size() const { return count_; }
+  int64_t builtAtMs() const { return builtAtMs_; }
+  const std::vector<std::string>& roots() const { return roots_; }
+
+  bool Search(const std::string& query, const SearchOptions& options,
+              std::vector<SearchRow>& rows, SearchError& error) const {
+    rows.clear();
+
+    std::regex pattern;
+    const auto terms = ParseTerms(query, !options.matchCase);
+    if (options.regex) {
+      try {
+        auto flags = std::regex::ECMAScript | std::regex::optimize;
+        if (!options.matchCase) {
+          flags |= std::regex::icase;
+        }
+        pattern = std::regex(query, flags);
+      } catch (const std::regex_error& ex) {
+        error.code = "ERR_EVERYTHING_QUERY_FAILED";
+        error.message = std::string("Invalid regular expression: ") + ex.what();
+        return false;
+      }
+    } else if (terms.empty()) {
+      return true;
+    }
+
+    const uint64_t wanted = static_cast<uint64_t>(options.offset) + options.maxResults;
+    const bool indexOrder = options.sort == kSortPathAscending;
+    const uint64_t stopAt = indexOrder ? wanted : UINT64_MAX;
+
+    std::vector<uint32_t> matches;
+    std::vector<std::vector<int8_t>> ancestorMemo(options.matchPath ? terms.size() : 0);
+    auto accept = [&](uint32_t index) {
+      const bool matched = options.regex ? MatchesRegex(index, pattern, options)
+                                         : MatchesTerms(index, terms, options, ancestorMemo);
+      if (matched) {
+        matches.push_back(index);
+      }
+      return matches.size() < stopAt;
+    };
+
+    const QueryTerm* anchor = nullptr;
+    if (!options.regex && !options.matchPath) {
+      for (const auto& term : terms) {
+        if (!term.wildcard && (anchor == nullptr || term.text.size() > anchor->text.size())) {
+          anchor = &term;
+        }
+      }
+    }
+
+    if (anchor != nullptr) {
+      ScanHeap(anchor->text, options.matchCase ? names_ : folded_, accept);
+    } else {
+      for (uint64_t i = 0; i < count_; ++i) {
+        if (!accept(static_cast<uint32_t>(i))) {
+          break;
+        }
+      }
+    }
+
+    Order(matches, options.sort, wanted);
+
+    const uint64_t end = std::min<uint64_t>(matches.size(), wanted);
+    rows.reserve(end > options.offset ? end - options.offset : 0);
+    for (uint64_t i = options.offset; i < end; ++i) {
+      rows.push_back(ToRow(matches[i], options.fields));
+    }
+    return true;
+  }
+
+ private:
+  FileNameIndex() = default;
+
+  // Everything after this trusts the snapshot's offsets, so a file that was
+  // truncated, damaged or written by a different build has to fail here; the
+  // caller then rebuilds. Sums are compared as `offset <= size - length`
+  // so that no crafted value can wrap.
+  bool Attach(const char* base, size_t size, std::string& error) {
+    if (size < sizeof(SnapshotHeader)) {
+      error = "Index snapshot is truncated";
+      return false;
+    }
+
+    SnapshotHeader header{};
+    std::memcpy(&header, base, sizeof(header));
+    auto fits = [size](uint64_t offset, uint64_t length) {
+      return offset <= size && length <= size - offset;
+    };
+    const bool valid = std::memcmp(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic)) == 0 &&
+        header.version == kSnapshotVersion && header.entrySize == sizeof(IndexEntry) &&
+        header.fileSize == size && header.entriesOffset % alignof(IndexEntry) == 0 &&
+        header.entryCount < UINT32_MAX && header.entriesOffset <= size &&
+        header.entryCount <= (size - header.entriesOffset) / sizeof(IndexEntry) &&
+        fits(header.heapOffset, header.heapSize) && fits(header.foldedOffset, header.heapSize) &&
+        fits(header.rootsOffset, header.rootsSize);
+    if (!valid) {
+      error = "Index snapshot has an unsupported layout";
+      return false;
+    }
+
+    entries_ = reinterpret_cast<const IndexEntry*>(base + header.entriesOffset);
+    count_ = header.entryCount;
+    names_ = base + header.heapOffset;
+    folded_ = base + header.foldedOffset;
+    heapSize_ = header.heapSize;
+    builtAtMs_ = header.builtAtMs;
+
+    const char* roots = base + header.rootsOffset;
+    size_t start = 0;
+    for (size_t i = 0; i < header.rootsSize; ++i) {
+      if (roots[i] == '\0') {
+        roots_.emplace_back(roots + start, i - start);
+        start = i + 1;
+      }
+    }
+
+    // Names are laid out in entry order, each followed by a NUL: ScanHeap
+    // maps heap offsets back to entries by binary search, and Name() and the
+    // extension sort slice them without further checks. Parents come before
+    // their children, so chains cannot loop; they must also stay within
+    // kMaxWalkDepth, which FullPath() and AncestorContains() rely on.
+    std::vector<uint16_t> depths(count_);
+    uint64_t heapCursor = 0;
+    for (uint64_t i = 0; i < count_; ++i) {
+      const auto& entry = entries_[i];
+      const bool isRoot = (entry.flags & kEntryRoot) != 0;
+      const bool rootValid = isRoot ? entry.parent < roots_.size() : entry.parent < i;
+      if (rootValid && !isRoot) {
+        depths[i] = static_cast<uint16_t>(depths[entry.parent] + 1);
+      }
+      const uint64_t nameEnd = uint64_t{entry.nameOffset} + entry.nameLength;
+      if (!rootValid || depths[i] > kMaxWalkDepth || entry.nameOffset < heapCursor ||
+          nameEnd >= heapSize_ || names_[nameEnd] != '\0' ||
+          entry.extensionOffset > entry.nameLength) {
+        error = "Index snapshot is corrupt";
+        return false;
+      }
+      heapCursor = nameEnd + 1;
+    }
+    return true;
+  }
+
+  std::string_view Name(uint32_t index, bool folded = false) const {
+    const auto& entry = entries_[index];
+    return std::string_view((folded ? folded_ : names_) + entry.nameOffset, entry.nameLength);
+  }
+
+  std::string FullPath(uint32_t index) const {
+    uint32_t chain[kMaxWalkDepth + 1];
+    size_t depth = 0;
+    uint32_t current = index;
+    while (!(entries_[current].flags & kEntryRoot) && depth < kMaxWalkDepth) {
+      chain[depth++] = current;
+      current = entries_[current].parent;
+    }
+
+    std::string path = roots_[entries_[current].parent];
+    while (depth > 0) {
+      if (path.empty() || path.back() != '/') {
+        path.push_back('/');
+      }
+      path.append(Name(chain[--depth]));
+    }
+    return path;
+  }
+
+  template <typename Accept>
+  void ScanHeap(const std::string& needle, const char* heap, Accept&& accept) const {
+    const char* cursor = heap;
+    const char* end = heap + heapSize_;
+    uint64_t entryCursor = 0;
+    while (cursor < end) {
+      const auto* hit = static_cast<const char*>(
+          ::memmem(cursor, static_cast<size_t>(end - cursor), needle.data(), needle.size()));
+      if (hit == nullptr) {
+        return;
+      }
+
+      // Hits arrive in heap order, and heap order is entry order: gallop
+      // forward from the previous hit instead of binary searching from zero.
+      const auto offset = static_cast<uint64_t>(hit - heap);
+      uint64_t step = 1;
+      while (entryCursor + step < count_ && entries_[entryCursor + step].nameOffset <= offset) {
+        step *= 2;
+      }
+      const auto* first = entries_ + entryCursor + step / 2;
+      const auto* last = entries_ + std::min(count_, entryCursor + step);
+      const auto* found = std::upper_bound(first, last, offset,
+          [](uint64_t value, const IndexEntry& entry) { return value < entry.nameOffset; }) - 1;
+      const auto index = static_cast<uint32_t>(found - entries_);
+
+      if (!accept(index)) {
+        return;
+      }
+      entryCursor = index + 1U;
+      cursor = heap + found->nameOffset + found->nameLength + 1;
+    }
+  }
+
+  bool AncestorContains(uint32_t index, const QueryTerm& term, bool folded, bool wholeWord,
+                        std::vector<int8_t>& memo) const {
+    if (memo.empty()) {
+      memo.assign(count_, -1);
+    }
+    if (memo[index] >= 0) {
+      return memo[index] == 1;
+    }
+
+    bool contains = ContainsTerm(Name(index, folded), term.text, wholeWord);
+    if (!contains && (entries_[index].flags & kEntryRoot)) {
+      const auto& root = roots_[entries_[index].parent];
+      contains = ContainsTerm(folded ? FoldAscii(root) : root, term.text, wholeWord);
+    } else if (!contains) {
+      contains = AncestorContains(entries_[index].parent, term, folded, wholeWord, memo);
+    }
+    memo[index] = contains ? 1 : 0;
+    return contains;
+  }
+
+  bool MatchesTerms(uint32_t index, const std::vector<QueryTerm>& terms,
+                    const SearchOptions& options,
+                    std::vector<std::vector<int8_t>>& ancestorMemo) const {
+    const bool folded = !options.matchCase;
+    const auto name = Name(index, folded);
+    std::string fullPath;
+
+    for (size_t i = 0; i < terms.size(); ++i) {
+      const auto& term = terms[i];
+      if (!options.matchPath) {
+        const bool matched = term.wildcard ? GlobMatch(name, term.text)
+                                           : ContainsTerm(name, term.text, options.matchWholeWord);
+        if (!matched) {
+          return false;
+        }
+        continue;
+      }
+
+      if (term.wildcard || term.hasSeparator) {
+        if (fullPath.empty()) {
+          fullPath = folded ? FoldAscii(FullPath(index)) : FullPath(index);
+        }
+        const bool matched = term.wildcard
+            ? GlobMatch(fullPath, term.text)
+            : ContainsTerm(fullPath, term.text, options.matchWholeWord);
+        if (!matched) {
+          return false;
+        }
+        continue;
+      }
+
+      if (!AncestorContains(index, term, folded, options.matchWholeWord, ancestorMemo[i])) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool MatchesRegex(uint32_t index, const std::regex& pattern, const SearchOptions& options) const {
+    if (options.matchPath) {
+      const auto fullPath = FullPath(index);
+      return std::regex_search(fullPath, pattern);
+    }
+    const auto name = Name(index);
+    return std::regex_search(name.begin(), name.end(), pattern);
+  }
+
+  void Order(std::vector<uint32_t>& matches, uint32_t sort, uint64_t wanted) const {
+    if (sort == kSortPathAscending || matches.size() < 2) {
+      return;
+    }
+    if (sort == kSortPathDescending) {
+      std::reverse(matches.begin(), matches.end());
+      return;
+    }
+
+    auto byRank = [this](uint32_t left, uint32_t right) {
+      return entries_[left].nameRank < entries_[right].nameRank;
+    };
+    auto extension = [this](uint32_t index) {
+      const auto& entry = entries_[index];
+      return std::string_view(folded_ + entry.nameOffset + entry.extensionOffset,
+                              entry.nameLength - entry.extensionOffset);
+    };
+
+    std::function<bool(uint32_t, uint32_t)> less;
+    bool descending = false;
+    switch (sort) {
+      case kSortNameDescending:
+        descending = true;
+        [[fallthrough]];
+      case kSortNameAscending:
+        less = byRank;
+        break;
+      case kSortSizeDescending:
+        descending = true;
+        [[fallthrough]];
+      case kSortSizeAscending:
+        less = [this](uint32_t left, uint32_t right) {
+          return entries_[left].size != entries_[right].size
+              ? entries_[left].size < entries_[right].size
+              : left < right;
+        };
+        break;
+      case kSortExtensionDescending:
+      case kSortTypeNameDescending:
+        descending = true;
+        [[fallthrough]];
+      case kSortExtensionAscending:
+      case kSortTypeNameAscending:
+        less = [&](uint32_t left, uint32_t right) {
+          const int compared = extension(left).compare(extension(right));
+          return compared != 0 ? compared < 0 : byRank(left, right);
+        };
+        break;
+      case kSortDateCreatedDescending:
+        descending = true;
+        [[fallthrough]];
+      case kSortDateCreatedAscending:
+        less = [this](uint32_t left, uint32_t right) {
+          return entries_[left].createdSec != entries_[right].createdSec
+              ? entries_[left].createdSec < entries_[right].createdSec
+              : left < right;
+        };
+        break;
+      case kSortDateModifiedDescending:
+        descending = true;
+        [[fallthrough]];
+      case kSortDateModifiedAscending:
+        less = [this](uint32_t left, uint32_t right) {
+          return entries_[left].modifiedSec != entries_[right].modifiedSec
+              ? entries_[left].modifiedSec < entries_[right].modifiedSec
+              : left < right;
+        };
+        break;
+      default:
+        return;
+    }
+
+    auto compare = [&](uint32_t left, uint32_t right) {
+      return descending ? less(right, left) : less(left, right);
+    };
+    const auto middle = matches.begin() + static_cast<std::ptrdiff_t>(
+        std::min<uint64_t>(wanted, matches.size()));
+    std::partial_sort(matches.begin(), middle, matches.end(), compare);
+  }
+
+  SearchRow ToRow(uint32_t index, uint32_t fields) const {
+    const auto& entry = entries_[index];
+    const auto name = Name(index);
+    SearchRow row;
+    if (fields & (kFieldFullPath | kFieldPath)) {
+      std::string fullPath = FullPath(index);
+      if (fields & kFieldPath) {
+        if (entry.flags & kEntryRoot) {
+          const auto slash = fullPath.find_last_of('/');
+          if (fullPath != "/" && slash != std::string::npos) {
+            row.path = slash == 0 ? std::string("/") : fullPath.substr(0, slash);
+          }
+        } else {
+          row.path = fullPath.substr(0, fullPath.size() - name.size() - 1);
+          if (row.path.empty()) {
+            row.path = "/";
+          }
+        }
+      }
+      if (fields & kFieldFullPath) {
+        row.fullPath = std::move(fullPath);
+      }
+    }
+    if (fields & kFieldName) {
+      row.name.assign(name.data(), name.size());
+    }
+    if ((fields & kFieldExtension) && entry.extensionOffset < entry.nameLength) {
+      row.extension.assign(name.substr(entry.extensionOffset));
+    }
+
+    const bool isFolder = (entry.flags & kEntryFolder) != 0;
+    if (fields & kFieldIsFolder) {
+      row.isFolder = isFolder;
+      row.hasIsFolder = true;
+    }
+    if ((fields & kFieldSize) && !isFolder) {
+      row.size = static_cast<double>(entry.size);
+      row.hasSize = true;
+    }
+    if (fields & kFieldDateModified) {
+      row.dateModified = static_cast<double>(entry.modifiedSec) * 1000.0;
+      row.hasDateModified = entry.modifiedSec != 0;
+    }
+    if (fields & kFieldDateCreated) {
+      row.dateCreated = static_cast<double>(entry.createdSec) * 1000.0;
+      row.hasDateCreated = entry.createdSec != 0;
+    }
+    return row;
+  }
+
+  void* mapping_ = nullptr;
+  size_t mappingSize_ = 0;
+  std::vector<char> image_;
+  const IndexEntry* entries_ = nullptr;
+  uint64_t count_ = 0;
+  const char* names_ = nullptr;
+  const char* folded_ = nullptr;
+  uint64_t heapSize_ = 0;
+  int64_t builtAtMs_ = 0;
+  std::vector<std::string> roots_;
+};
+
+LinuxFileIndex& LinuxFileIndex::Instance() {
+  // Never destroyed: a detached build thread may still hold `this` while the
+  // process runs its static destructors.
+  static auto* index = new LinuxFileIndex();
+  return *index;
+}
+
+LinuxFileIndex::LinuxFileIndex() = default;
+
+void LinuxFileIndex::EnsureStarted() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (started_) {
+    return;
+  }
+  started_ = true;
+  options_ = WithDefaults(IndexBuildOptions{});
+
+  const auto startedAt = std::chrono::steady_clock::now();
+  std::string error;
+  auto snapshot = options_.snapshotPath.empty() ? nullptr
+                                                : FileNameIndex::Open(options_.snapshotPath, error);
+  if (snapshot == nullptr) {
+    StartBuildLocked();
+    return;
+  }
+
+  current_ = snapshot;
+  generation_.fetch_add(1, std::memory_order_release);
+  fromSnapshot_ = true;
+  loadMs_ = ElapsedMs(startedAt);
+  if (snapshot->roots() != options_.roots || NowMillis() - snapshot->builtAtMs() > kSnapshotStaleMs) {
+    StartBuildLocked();
+  }
+}
+
+bool LinuxFileIndex::Search(const std::string& query, const SearchOptions& options,
+                            std::vector<SearchRow>& rows, SearchError& error) {
+  EnsureStarted();
+
+  std::shared_ptr<const FileNameIndex> index;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    index = current_;
+  }
+  if (index == nullptr) {
+    rows.clear();
+    return true;
+  }
+  return index->Search(query, options, rows, error);
+}
+
+void LinuxFileIndex::Rebuild(IndexBuildOptions options) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  started_ = true;
+  options_ = WithDefaults(std::move(options));
+  if (building_) {
+    rebuildQueued_ = true;
+    return;
+  }
+  StartBuildLocked();
+}
+
+IndexStatus LinuxFileIndex::Status() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  IndexStatus status;
+  if (!started_) {
+    status.state = "idle";
+  } else if (current_ == nullptr) {
+    status.state = "building";
+  } else {
+    status.state = building_ ? "refreshing" : "ready";
+  }
+  status.scannedEntries = scanned_.load(std::memory_order_relaxed);
+  status.loadMs = loadMs_;
+  status.buildMs = buildMs_;
+  status.fromSnapshot = fromSnapshot_;
+  status.snapshotPath = options_.snapshotPath;
+  status.lastError = lastError_;
+  if (current_ != nullptr) {
+    status.entryCount = current_->size();
+    status.builtAtMs = current_->builtAtMs();
+    status.roots = current_->roots();
+  } else {
+    status.roots = options_.roots;
+  }
+  return status;
+}
+
+void LinuxFileIndex::StartBuildLocked() {
+  building_ = true;
+  scanned_.store(0, std::memory_order_relaxed);
+  std::thread([this, options = options_]() { RunBuild(options); }).detach();
+}
+
+void LinuxFileIndex::RunBuild(IndexBuildOptions options) {
+  const auto startedAt = std::chrono::steady_clock::now();
+
+  IndexBuilder builder(options, scanned_);
+  for (const auto& root : options.roots) {
+    builder.AddRoot(root);
+  }
+  auto image = builder.Finish(NowMillis());
+
+  std::string error;
+  std::shared_ptr<const FileNameIndex> built;
+  if (!options.snapshotPath.empty() && EnsureParentDirectory(options.snapshotPath)) {
+    const auto temporaryPath = options.snapshotPath + ".tmp-" + std::to_string(::getpid());
+    const int fd = ::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd >= 0) {
+      size_t written = 0;
+      while (written < image.size()) {
+        const ssize_t result = ::write(fd, image.data() + written, image.size() - written);
+        if (result <= 0) {
+          if (result < 0 && errno == EINTR) {
+            continue;
+          }
+          break;
+        }
+        written += static_cast<size_t>(result);
+      }
+      ::close(fd);
+      if (written == image.size() && ::rename(temporaryPath.c_str(), options.snapshotPath.c_str()) == 0) {
+        built = FileNameIndex::Open(options.snapshotPath, error);
+      } else {
+        ::unlink(temporaryPath.c_str());
+        error = "Unable to write index snapshot";
+      }
+    } else {
+      error = "Unable to create index snapshot (errno=" + std::to_string(errno) + ")";
+    }
+  }
+  if (built == nullptr) {
+    std::string imageError;
+    built = FileNameIndex::FromImage(std::move(image), imageError);
+    if (error.empty()) {
+      error = imageError;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (built != nullptr) {
+    current_ = std::move(built);
+    generation_.fetch_add(1, std::memory_order_release);
+    fromSnapshot_ = false;
+  }
+  buildMs_ = ElapsedMs(startedAt);
+  lastError_ = error;
+  building_ = false;
+  if (rebuildQueued_) {
+    rebuildQueued_ = false;
+    StartBuildLocked();
+  }
+}
+
+}  // namespace tuff::native::everything
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "everything/search_types.h"
+
+namespace tuff::native::everything {
+
+// In-process file-name index backing `search`/`query` on Linux, where there is
+// no Everything service to ask.
+//
+// The index is a pre-order walk of the configured roots with every directory's
+// children sorted case-insensitively, so entry order *is* path order: the
+// default sort (path ascending) needs no sort at all and a query stops scanning
+// as soon as it has offset + maxResults hits. Names live in one contiguous heap
+// (plus an ASCII-folded twin of the same length) and are scanned with memmem,
+// which is what keeps a query over a few million entries in single-digit
+// milliseconds.
+//
+// Every build is written to a snapshot file whose layout is the in-memory
+// layout, and the live index is an mmap of that file. A cold start is an
+// open + mmap + header check instead of a rescan, and the pages are shared
+// with the page cache rather than copied onto the heap.
+
+struct IndexBuildOptions {
+  std::vector<std::string> roots;
+  std::vector<std::string> excludes;
+  std::string snapshotPath;
+};
+
+struct IndexStatus {
+  std::string state;  // "idle" | "building" | "ready" | "refreshing"
+  uint64_t entryCount = 0;
+  uint64_t scannedEntries = 0;
+  int64_t builtAtMs = 0;
+  double loadMs = 0;
+  double buildMs = 0;
+  bool fromSnapshot = false;
+  std::string snapshotPath;
+  std::vector<std::string> roots;
+  std::string lastError;
+};
+
+class FileNameIndex;
+
+class LinuxFileIndex {
+ public:
+  static LinuxFileIndex& Instance();
+
+  // Loads the snapshot on first use and schedules a background build when
+  // there is none, or when it is stale. Never blocks on a filesystem walk.
+  void EnsureStarted();
+
+  // An index that is still building answers with an empty result; false is
+  // reserved for queries the index rejects (an invalid regex).
+  bool Search(const std::string& query, const SearchOptions& options,
+              std::vector<SearchRow>& rows, SearchError& error);
+
+  // Rebuilds with new options. Empty fields keep their defaults. A build that
+  // is already running finishes first; the new one is queued behind it.
+  void Rebuild(IndexBuildOptions options);
+
+  IndexStatus Status();
+
+  // Moves on whenever a different index starts answering queries, so results
+  // cached against the previous one can be told apart.
+  uint64_t Generation() const { return generation_.load(std::memory_order_acquire); }
+
+ private:
+  LinuxFileIndex();
+
+  void StartBuildLocked();
+  void RunBuild(IndexBuildOptions options);
+
+  std::mutex mutex_;
+  std::shared_ptr<const FileNameIndex> current_;
+  IndexBuildOptions options_;
+  bool started_ = false;
+  bool building_ = false;
+  bool rebuildQueued_ = false;
+  bool fromSnapshot_ = false;
+  double loadMs_ = 0;
+  double buildMs_ = 0;
+  std::string lastError_;
+  std::atomic<uint64_t> scanned_{0};
+  std::atomic<uint64_t> generation_{0};
+};
+
+}  // namespace tuff::native::everything
@@ -0,0 +1,877 @@
+#include "everything/locate_db.h"
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+namespace tuff::native::everything {
+
+namespace {
+
+constexpr char kPlocateMagic[8] = {'\0', 'p', 'l', 'o', 'c', 'a', 't', 'e'};
+constexpr char kMlocateMagic[8] = {'\0', 'm', 'l', 'o', 'c', 'a', 't', 'e'};
+constexpr const char* kDefaultDatabases[] = {
+    "/var/lib/plocate/plocate.db",
+    "/var/lib/mlocate/mlocate.db",
+};
+constexpr auto kChangeCheckInterval = std::chrono::seconds(1);
+
+constexpr uint16_t kEntryTypeKnown = 0x0001;
+constexpr uint16_t kEntryFolder = 0x0002;
+
+constexpr const char* kUnsupportedCode = "ERR_LOCATE_UNSUPPORTED_QUERY";
+
+double ElapsedMs(std::chrono::steady_clock::time_point startedAt) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startedAt)
+      .count();
+}
+
+char FoldAscii(char c) {
+  return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+uint32_t LoadBigEndian32(const uint8_t* data) {
+  return (uint32_t{data[0]} << 24) | (uint32_t{data[1]} << 16) | (uint32_t{data[2]} << 8) |
+      uint32_t{data[3]};
+}
+
+template <typename T>
+T LoadNative(const uint8_t* data) {
+  T value;
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+// NUL-terminated string at `position`, or an empty view with `position` left
+// at `size` when the terminator is missing.
+std::string_view ReadCString(const uint8_t* data, size_t size, size_t& position) {
+  if (position >= size) {
+    return {};
+  }
+  const auto* start = data + position;
+  const auto* end = static_cast<const uint8_t*>(std::memchr(start, '\0', size - position));
+  if (end == nullptr) {
+    position = size;
+    return {};
+  }
+  position = static_cast<size_t>(end - data) + 1;
+  return std::string_view(reinterpret_cast<const char*>(start), static_cast<size_t>(end - start));
+}
+
+// libzstd is what plocate itself links against, so it is present wherever a
+// plocate database is. Loaded on demand rather than linked so the addon does
+// not grow a build dependency for one optional reader.
+struct ZstdApi {
+  using CreateDCtxFn = void* (*)();
+  using FreeDCtxFn = size_t (*)(void*);
+  using CreateDDictFn = void* (*)(const void*, size_t);
+  using FreeDDictFn = size_t (*)(void*);
+  using DecompressDCtxFn = size_t (*)(void*, void*, size_t, const void*, size_t);
+  using DecompressDDictFn = size_t (*)(void*, void*, size_t, const void*, size_t, const void*);
+  using FrameContentSizeFn = unsigned long long (*)(const void*, size_t);
+  using IsErrorFn = unsigned (*)(size_t);
+
+  CreateDCtxFn createDCtx = nullptr;
+  FreeDCtxFn freeDCtx = nullptr;
+  CreateDDictFn createDDict = nullptr;
+  FreeDDictFn freeDDict = nullptr;
+  DecompressDCtxFn decompressDCtx = nullptr;
+  DecompressDDictFn decompressUsingDDict = nullptr;
+  FrameContentSizeFn getFrameContentSize = nullptr;
+  IsErrorFn isError = nullptr;
+
+  static const ZstdApi* Load() {
+    static const ZstdApi* api = []() -> const ZstdApi* {
+      void* module = ::dlopen("libzstd.so.1", RTLD_NOW | RTLD_LOCAL);
+      if (module == nullptr) {
+        module = ::dlopen("libzstd.so", RTLD_NOW | RTLD_LOCAL);
+      }
+      if (module == nullptr) {
+        return nullptr;
+      }
+      auto* loaded = new ZstdApi();
+      loaded->createDCtx = reinterpret_cast<CreateDCtxFn>(::dlsym(module, "ZSTD_createDCtx"));
+      loaded->freeDCtx = reinterpret_cast<FreeDCtxFn>(::dlsym(module, "ZSTD_freeDCtx"));
+      loaded->createDDict = reinterpret_cast<CreateDDictFn>(::dlsym(module, "ZSTD_createDDict"));
+      loaded->freeDDict = reinterpret_cast<FreeDDictFn>(::dlsym(module, "ZSTD_freeDDict"));
+      loaded->decompressDCtx =
+          reinterpret_cast<DecompressDCtxFn>(::dlsym(module, "ZSTD_decompressDCtx"));
+      loaded->decompressUsingDDict =
+          reinterpret_cast<DecompressDDictFn>(::dlsym(module, "ZSTD_decompress_usingDDict"));
+      loaded->getFrameContentSize =
+          reinterpret_cast<FrameContentSizeFn>(::dlsym(module, "ZSTD_getFrameContentSize"));
+      loaded->isError = reinterpret_cast<IsErrorFn>(::dlsym(module, "ZSTD_isError"));
+      if (loaded->createDCtx == nullptr || loaded->freeDCtx == nullptr ||
+          loaded->createDDict == nullptr || loaded->freeDDict == nullptr ||
+          loaded->decompressDCtx == nullptr || loaded->decompressUsingDDict == nullptr ||
+          loaded->getFrameContentSize == nullptr || loaded->isError == nullptr) {
+        delete loaded;
+        return nullptr;
+      }
+      return loaded;
+    }();
+    return api;
+  }
+};
+
+class Mapping {
+ public:
+  Mapping() = default;
+  Mapping(const Mapping&) = delete;
+  Mapping& operator=(const Mapping&) = delete;
+
+  ~Mapping() {
+    if (data_ != nullptr) {
+      ::munmap(const_cast<uint8_t*>(data_), size_);
+    }
+  }
+
+  bool Open(const std::string& path, std::string& error, std::string& code) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      const int openErrno = errno;
+      code = openErrno == EACCES ? "ERR_LOCATE_DB_UNREADABLE" : "ERR_LOCATE_DB_NOT_FOUND";
+      error = "Unable to open " + path + " (" + std::strerror(openErrno) + ")";
+      return false;
+    }
+
+    struct stat info {};
+    if (::fstat(fd, &info) != 0 || info.st_size <= 0) {
+      ::close(fd);
+      code = "ERR_LOCATE_DB_FORMAT";
+      error = "Locate database is empty";
+      return false;
+    }
+
+    size_ = static_cast<size_t>(info.st_size);
+    void* mapped = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+      code = "ERR_LOCATE_DB_UNREADABLE";
+      error = "Unable to map locate database (errno=" + std::to_string(errno) + ")";
+      return false;
+    }
+    data_ = static_cast<const uint8_t*>(mapped);
+    // Both formats are read front to back exactly once.
+    ::madvise(mapped, size_, MADV_SEQUENTIAL);
+    return true;
+  }
+
+  const uint8_t* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+struct QueryTerm {
+  std::string text;
+  bool hasSeparator = false;
+};
+
+std::vector<QueryTerm> ParseTerms(const std::string& query, bool fold) {
+  std::vector<QueryTerm> terms;
+  size_t start = 0;
+  while (start < query.size()) {
+    while (start < query.size() && (query[start] == ' ' || query[start] == '\t')) {
+      ++start;
+    }
+    size_t end = start;
+    while (end < query.size() && query[end] != ' ' && query[end] != '\t') {
+      ++end;
+    }
+    if (end > start) {
+      QueryTerm term;
+      term.text = query.substr(start, end - start);
+      if (fold) {
+        for (auto& c : term.text) {
+          c = FoldAscii(c);
+        }
+      }
+      term.hasSeparator = term.text.find('/') != std::string::npos;
+      terms.push_back(std::move(term));
+    }
+    start = end;
+  }
+  return terms;
+}
+
+}  // namespace
+
+class LocateIndex {
+ public:
+  static std::shared_ptr<const LocateIndex> Load(const std::string& path, std::string& error,
+                                                 std::string& code) {
+    Mapping mapping;
+    if (!mapping.Open(path, error, code)) {
+      return nullptr;
+    }
+
+    std::shared_ptr<LocateIndex> index(new LocateIndex());
+    const bool parsed = mapping.size() >= sizeof(kPlocateMagic) &&
+            std::memcmp(mapping.data(), kPlocateMagic, sizeof(kPlocateMagic)) == 0
+        ? index->ParsePlocate(mapping.data(), mapping.size(), error, code)
+        : index->ParseMlocate(mapping.data(), mapping.size(), error, code);
+    if (!parsed) {
+      return nullptr;
+    }
+    index->Finish();
+    return index;
+  }
+
+  LocateIndex(const LocateIndex&) = delete;
+  LocateIndex& operator=(const LocateIndex&) = delete;
+
+  const char* format() const { return format_; }
+  uint64_t entryCount() const { return entries_.size(); }
+  uint64_t directoryCount() const { return directories_.size(); }
+  bool checkVisibility() const { return checkVisibility_; }
+
+  bool Search(const LocateQuery& query, size_t batchSize, const LocateSink& sink,
+              SearchError& error) const {
+    const auto& options = query.options;
+    if (options.regex || options.matchWholeWord ||
+        query.text.find_first_of("*?") != std::string::npos) {
+      error.code = kUnsupportedCode;
+      error.message = "The locate reader matches plain terms only";
+      return false;
+    }
+
+    const bool fold = !options.matchCase;
+    const auto terms = ParseTerms(query.text, fold);
+    if (terms.empty() || options.maxResults == 0) {
+      return true;
+    }
+
+    const uint32_t metadataFields = kFieldSize | kFieldDateModified | kFieldDateCreated;
+    const bool wantsMetadata = (options.fields & metadataFields) != 0;
+    std::unordered_map<uint32_t, bool> visible;
+    std::vector<SearchRow> batch;
+    uint64_t skipped = 0;
+    uint64_t produced = 0;
+    bool stopped = false;
+
+    auto accept = [&](uint32_t index) {
+      const auto& entry = entries_[index];
+      if (checkVisibility_ && !IsVisible(entry.directory, visible)) {
+        return true;
+      }
+
+      SearchRow row = ToRow(index, options.fields);
+      const bool needsStat =
+          wantsMetadata || ((options.fields & kFieldIsFolder) && !(entry.flags & kEntryTypeKnown));
+      if (needsStat && !FillMetadata(index, row, options.fields)) {
+        return true;
+      }
+      if (skipped < options.offset) {
+        ++skipped;
+        return true;
+      }
+
+      batch.push_back(std::move(row));
+      ++produced;
+      if (batch.size() >= batchSize) {
+        if (!sink(batch)) {
+          stopped = true;
+          return false;
+        }
+        batch.clear();
+      }
+      return produced < options.maxResults;
+    };
+
+    if (options.matchPath) {
+      ScanPaths(terms, query.prefix, fold, accept);
+    } else {
+      ScanNames(terms, query.prefix, fold, accept);
+    }
+
+    if (!stopped && !batch.empty()) {
+      sink(batch);
+    }
+    return true;
+  }
+
+ private:
+  struct Entry {
+    uint32_t nameOffset;
+    uint32_t directory;
+    uint16_t nameLength;
+    uint16_t flags;
+  };
+
+  struct Directory {
+    uint32_t offset;
+    uint32_t length;
+  };
+
+  // Loader state, dropped by Finish.
+  struct Builder {
+    std::unordered_map<std::string, uint32_t> directoryIds;
+    std::string lastDirectory;
+    uint32_t lastDirectoryId = UINT32_MAX;
+  };
+
+  LocateIndex() {
+    // Every name is preceded by a NUL, so a prefix query is a memmem for
+    // "\0term".
+    names_.push_back('\0');
+  }
+
+  uint32_t AddDirectory(std::string_view path) {
+    if (builder_.lastDirectoryId != UINT32_MAX && path == builder_.lastDirectory) {
+      return builder_.lastDirectoryId;
+    }
+    const auto [it, inserted] = builder_.directoryIds.try_emplace(
+        std::string(path), static_cast<uint32_t>(directories_.size()));
+    if (inserted) {
+      directories_.push_back(
+          Directory{static_cast<uint32_t>(directoryHeap_.size()), static_cast<uint32_t>(path.size())});
+      directoryHeap_.append(path.data(), path.size());
+      directoryHeap_.push_back('\0');
+    }
+    builder_.lastDirectory.assign(path.data(), path.size());
+    builder_.lastDirectoryId = it->second;
+    return it->second;
+  }
+
+  bool AddEntry(uint32_t directory, std::string_view name, uint16_t flags) {
+    if (name.empty() || name.size() > UINT16_MAX || entries_.size() >= UINT32_MAX ||
+        names_.size() + name.size() + 1 > UINT32_MAX) {
+      return false;
+    }
+    entries_.push_back(Entry{static_cast<uint32_t>(names_.size()), directory,
+                             static_cast<uint16_t>(name.size()), flags});
+    names_.append(name.data(), name.size());
+    names_.push_back('\0');
+    return true;
+  }
+
+  void AddPath(std::string_view path) {
+    const auto slash = path.find_last_of('/');
+    if (slash == std::string_view::npos || slash + 1 >= path.size()) {
+      return;
+    }
+    const auto directory = AddDirectory(slash == 0 ? std::string_view("/") : path.substr(0, slash));
+    AddEntry(directory, path.substr(slash + 1), 0);
+  }
+
+  void Finish() {
+    builder_ = Builder();
+    foldedNames_ = names_;
+    for (auto& c : foldedNames_) {
+      c = FoldAscii(c);
+    }
+    foldedDirectoryHeap_ = directoryHeap_;
+    for (auto& c : foldedDirectoryHeap_) {
+      c = FoldAscii(c);
+    }
+    names_.shrink_to_fit();
+    directoryHeap_.shrink_to_fit();
+    entries_.shrink_to_fit();
+    directories_.shrink_to_fit();
+  }
+
+  // mlocate.db, all integers big-endian:
+  //   "\0mlocate", u32 confSize, u8 version (0), u8 checkVisibility, u8[2]
+  //   root path NUL, configuration block of confSize bytes
+  //   per directory: u64 sec, u32 nsec, u8[4], path NUL, then entries of
+  //   u8 type (0 file, 1 directory, 2 end) + name NUL until type 2
+  bool ParseMlocate(const uint8_t* data, size_t size, std::string& error, std::string& code) {
+    constexpr size_t kHeaderSize = 16;
+    constexpr size_t kDirectoryHeaderSize = 16;
+    if (size < kHeaderSize || std::memcmp(data, kMlocateMagic, sizeof(kMlocateMagic)) != 0) {
+      code = "ERR_LOCATE_DB_FORMAT";
+      error = "Not a plocate or mlocate database";
+      return false;
+    }
+    if (data[12] != 0) {
+      code = "ERR_LOCATE_DB_FORMAT";
+      error = "Unsupported mlocate database version " + std::to_string(data[12]);
+      return false;
+    }
+
+    format_ = "mlocate";
+    checkVisibility_ = data[13] != 0;
+    size_t position = kHeaderSize;
+    ReadCString(data, size, position);
+    position += LoadBigEndian32(data + 8);
+
+    while (position + kDirectoryHeaderSize < size) {
+      position += kDirectoryHeaderSize;
+      const auto directoryPath = ReadCString(data, size, position);
+      if (position >= size) {
+        break;
+      }
+      const uint32_t directory = AddDirectory(directoryPath);
+      while (position < size) {
+        const uint8_t type = data[position++];
+        if (type > 1) {
+          break;
+        }
+        const auto name = ReadCString(data, size, position);
+        AddEntry(directory, name, kEntryTypeKnown | (type == 1 ? kEntryFolder : 0));
+      }
+    }
+    return true;
+  }
+
+  // plocate.db, native-endian (always little-endian in practice):
+  //   "\0plocate", u32 version, u32 hashtableSize, u32 extraHtSlots,
+  //   u32 numDocids, u64 hashTableOffset, u64 filenameIndexOffset,
+  //   then from version 1: u32 maxVersion, u32 dictionaryLength,
+  //   u64 dictionaryOffset, then from maxVersion 2 six u64 updatedb fields
+  //   (directory data, next dictionary and config block, each a length and
+  //   an offset) and at byte 104 u8 checkVisibility
+  // The filename index is numDocids + 1 u64 offsets; docid i is one zstd
+  // frame of NUL-terminated paths between offsets i and i + 1.
+  bool ParsePlocate(const uint8_t* data, size_t size, std::string& error, std::string& code) {
+    constexpr size_t kVersion0HeaderSize = 40;
+    constexpr size_t kVersion1HeaderSize = 56;
+    constexpr size_t kCheckVisibilityOffset = 104;
+    code = "ERR_LOCATE_DB_FORMAT";
+    if (size < kVersion0HeaderSize) {
+      error = "plocate database is truncated";
+      return false;
+    }
+
+    const auto version = LoadNative<uint32_t>(data + 8);
+    if (version > 1) {
+      error = "Unsupported plocate database version " + std::to_string(version);
+      return false;
+    }
+    const uint64_t docids = LoadNative<uint32_t>(data + 20);
+    const auto indexOffset = LoadNative<uint64_t>(data + 32);
+    uint64_t dictionaryLength = 0;
+    uint64_t dictionaryOffset = 0;
+    if (version >= 1) {
+      if (size < kVersion1HeaderSize) {
+        error = "plocate database is truncated";
+        return false;
+      }
+      const auto maxVersion = LoadNative<uint32_t>(data + 40);
+      dictionaryLength = LoadNative<uint32_t>(data + 44);
+      dictionaryOffset = LoadNative<uint64_t>(data + 48);
+      checkVisibility_ = maxVersion >= 2 && size > kCheckVisibilityOffset &&
+          data[kCheckVisibilityOffset] != 0;
+    }
+    if (indexOffset > size || (size - indexOffset) / sizeof(uint64_t) < docids + 1 ||
+        dictionaryOffset > size || dictionaryLength > size - dictionaryOffset) {
+      error = "plocate database is truncated";
+      return false;
+    }
+
+    const ZstdApi* zstd = ZstdApi::Load();
+    if (zstd == nullptr) {
+      code = "ERR_LOCATE_ZSTD_UNAVAILABLE";
+      error = "libzstd is required to read plocate databases";
+      return false;
+    }
+
+    format_ = "plocate";
+    void* context = zstd->createDCtx();
+    void* dictionary =
+        dictionaryLength > 0 ? zstd->createDDict(data + dictionaryOffset, dictionaryLength) : nullptr;
+    std::vector<char> block;
+    bool ok = context != nullptr && (dictionaryLength == 0 || dictionary != nullptr);
+
+    for (uint64_t docid = 0; ok && docid < docids; ++docid) {
+      const auto start = LoadNative<uint64_t>(data + indexOffset + docid * sizeof(uint64_t));
+      const auto end = LoadNative<uint64_t>(data + indexOffset + (docid + 1) * sizeof(uint64_t));
+      if (start > end || end > size) {
+        ok = false;
+        break;
+      }
+
+      const auto contentSize = zstd->getFrameContentSize(data + start, end - start);
+      // ZSTD_CONTENTSIZE_UNKNOWN and _ERROR are the two largest values.
+      if (contentSize >= static_cast<unsigned long long>(-2) || contentSize > (64U << 20)) {
+        ok = false;
+        break;
+      }
+      block.resize(static_cast<size_t>(contentSize));
+      const size_t written = dictionary != nullptr
+          ? zstd->decompressUsingDDict(context, block.data(), block.size(), data + start,
+                                       end - start, dictionary)
+          : zstd->decompressDCtx(context, block.data(), block.size(), data + start, end - start);
+      if (zstd->isError(written)) {
+        ok = false;
+        break;
+      }
+
+      size_t position = 0;
+      while (position < written) {
+        const auto* terminator =
+            static_cast<const char*>(std::memchr(block.data() + position, '\0', written - position));
+        const size_t length =
+            terminator != nullptr ? static_cast<size_t>(terminator - block.data()) - position
+                                  : written - position;
+        AddPath(std::string_view(block.data() + position, length));
+        position += length + 1;
+      }
+    }
+
+    if (dictionary != nullptr) {
+      zstd->freeDDict(dictionary);
+    }
+    if (context != nullptr) {
+      zstd->freeDCtx(context);
+    }
+    if (!ok) {
+      error = "plocate database has a corrupt filename block";
+      return false;
+    }
+    code.clear();
+    return true;
+  }
+
+  std::string_view Name(uint32_t index, bool folded) const {
+    const auto& entry = entries_[index];
+    return std::string_view((folded ? foldedNames_ : names_).data() + entry.nameOffset,
+                            entry.nameLength);
+  }
+
+  std::string_view DirectoryPath(uint32_t directory, bool folded) const {
+    const auto& ref = directories_[directory];
+    return std::string_view((folded ? foldedDirectoryHeap_ : directoryHeap_).data() + ref.offset,
+                            ref.length);
+  }
+
+  std::string FullPath(uint32_t index, bool folded) const {
+    std::string path(DirectoryPath(entries_[index].directory, folded));
+    if (path.empty() || path.back() != '/') {
+      path.push_back('/');
+    }
+    path.append(Name(index, folded));
+    return path;
+  }
+
+  bool IsVisible(uint32_t directory, std::unordered_map<uint32_t, bool>& memo) const {
+    const auto found = memo.find(directory);
+    if (found != memo.end()) {
+      return found->second;
+    }
+    // What locate checks for databases built with visibility checking on:
+    // the caller must be able to list the directory, which also requires
+    // search permission on every ancestor.
+    const std::string path(DirectoryPath(directory, false));
+    const bool visible = ::access(path.c_str(), R_OK | X_OK) == 0;
+    memo.emplace(directory, visible);
+    return visible;
+  }
+
+  SearchRow ToRow(uint32_t index, uint32_t fields) const {
+    SearchRow row;
+    const auto& entry = entries_[index];
+    const auto name = Name(index, false);
+    if (fields & kFieldFullPath) {
+      row.fullPath = FullPath(index, false);
+    }
+    if (fields & kFieldPath) {
+      row.path.assign(DirectoryPath(entry.directory, false));
+    }
+    if (fields & kFieldName) {
+      row.name.assign(name.data(), name.size());
+    }
+    if (fields & kFieldExtension) {
+      const auto dot = name.find_last_of('.');
+      if (dot != std::string_view::npos && dot + 1 < name.size()) {
+        row.extension.assign(name.substr(dot + 1));
+      }
+    }
+    if ((fields & kFieldIsFolder) && (entry.flags & kEntryTypeKnown)) {
+      row.isFolder = (entry.flags & kEntryFolder) != 0;
+      row.hasIsFolder = true;
+    }
+    return row;
+  }
+
+  // False when the path is gone: the database is only as fresh as the last
+  // updatedb run.
+  bool FillMetadata(uint32_t index, SearchRow& row, uint32_t fields) const {
+    struct stat info {};
+    const auto fullPath = row.fullPath.empty() ? FullPath(index, false) : row.fullPath;
+    if (::stat(fullPath.c_str(), &info) != 0) {
+      return false;
+    }
+    const bool isFolder = S_ISDIR(info.st_mode);
+    if ((fields & kFieldSize) && !isFolder) {
+      row.size = static_cast<double>(info.st_size);
+      row.hasSize = true;
+    }
+    if (fields & kFieldDateModified) {
+      row.dateModified = static_cast<double>(info.st_mtim.tv_sec) * 1000.0 +
+          static_cast<double>(info.st_mtim.tv_nsec / 1000000);
+      row.hasDateModified = true;
+    }
+    if (fields & kFieldDateCreated) {
+      row.dateCreated = static_cast<double>(info.st_ctim.tv_sec) * 1000.0 +
+          static_cast<double>(info.st_ctim.tv_nsec / 1000000);
+      row.hasDateCreated = true;
+    }
+    if (fields & kFieldIsFolder) {
+      row.isFolder = isFolder;
+      row.hasIsFolder = true;
+    }
+    return true;
+  }
+
+  bool MatchesName(uint32_t index, const std::vector<QueryTerm>& terms, bool prefix,
+                   bool folded) const {
+    const auto name = Name(index, folded);
+    for (const auto& term : terms) {
+      const bool matched = prefix ? name.compare(0, term.text.size(), term.text) == 0
+                                  : name.find(term.text) != std::string_view::npos;
+      if (!matched) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Hits in the name heap arrive in entry order, so each one is located by a
+  // binary search over the remaining entries.
+  template <typename Accept>
+  void ScanNames(const std::vector<QueryTerm>& terms, bool prefix, bool folded,
+                 Accept&& accept) const {
+    const QueryTerm* anchor = &terms.front();
+    for (const auto& term : terms) {
+      if (term.text.size() > anchor->text.size()) {
+        anchor = &term;
+      }
+    }
+    std::string needle;
+    if (prefix) {
+      needle.push_back('\0');
+    }
+    needle.append(anchor->text);
+
+    const auto& heap = folded ? foldedNames_ : names_;
+    const char* cursor = heap.data();
+    const char* end = heap.data() + heap.size();
+    auto first = entries_.begin();
+    while (cursor < end) {
+      const auto* hit = static_cast<const char*>(
+          ::memmem(cursor, static_cast<size_t>(end - cursor), needle.data(), needle.size()));
+      if (hit == nullptr) {
+        return;
+      }
+      const auto offset = static_cast<uint32_t>(hit - heap.data()) + (prefix ? 1U : 0U);
+      const auto found = std::upper_bound(first, entries_.end(), offset,
+                                          [](uint32_t value, const Entry& entry) {
+                                            return value < entry.nameOffset;
+                                          }) -
+          1;
+      const auto index = static_cast<uint32_t>(found - entries_.begin());
+      if (MatchesName(index, terms, prefix, folded) && !accept(index)) {
+        return;
+      }
+      first = found + 1;
+      cursor = heap.data() + found->nameOffset + found->nameLength;
+    }
+  }
+
+  template <typename Accept>
+  void ScanPaths(const std::vector<QueryTerm>& terms, bool prefix, bool folded,
+                 Accept&& accept) const {
+    // Per term and directory: -1 unknown, 0 no, 1 the directory path alone
+    // satisfies the term.
+    std::vector<std::vector<int8_t>> directoryMemo(terms.size());
+    for (uint32_t index = 0; index < entries_.size(); ++index) {
+      const auto& entry = entries_[index];
+      bool matched = true;
+      std::string fullPath;
+      for (size_t i = 0; i < terms.size() && matched; ++i) {
+        const auto& term = terms[i];
+        if (prefix || term.hasSeparator) {
+          if (fullPath.empty()) {
+            fullPath = FullPath(index, folded);
+          }
+          matched = prefix ? fullPath.compare(0, term.text.size(), term.text) == 0
+                           : fullPath.find(term.text) != std::string::npos;
+          continue;
+        }
+
+        auto& memo = directoryMemo[i];
+        if (memo.empty()) {
+          memo.assign(directories_.size(), -1);
+        }
+        auto& inDirectory = memo[entry.directory];
+        if (inDirectory < 0) {
+          inDirectory = DirectoryPath(entry.directory, folded).find(term.text) != std::string_view::npos
+              ? 1
+              : 0;
+        }
+        matched = inDirectory == 1 || Name(index, folded).find(term.text) != std::string_view::npos;
+      }
+      if (matched && !accept(index)) {
+        return;
+      }
+    }
+  }
+
+  const char* format_ = "";
+  bool checkVisibility_ = false;
+  std::vector<Entry> entries_;
+  std::vector<Directory> directories_;
+  std::string names_;
+  std::string foldedNames_;
+  std::string directoryHeap_;
+  std::string foldedDirectoryHeap_;
+  Builder builder_;
+};
+
+LocateDatabase& LocateDatabase::Instance() {
+  // Never destroyed: a detached load thread may still hold `this` at exit.
+  static auto* database = new LocateDatabase();
+  return *database;
+}
+
+void LocateDatabase::EnsureStarted() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (started_) {
+    return;
+  }
+  started_ = true;
+  CheckForChangeLocked();
+}
+
+bool LocateDatabase::Search(const LocateQuery& query, size_t batchSize, const LocateSink& sink,
+                            SearchError& error) {
+  EnsureStarted();
+
+  std::shared_ptr<const LocateIndex> index;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    CheckForChangeLocked();
+    index = current_;
+  }
+  if (index == nullptr) {
+    return true;
+  }
+  return index->Search(query, std::max<size_t>(batchSize, 1), sink, error);
+}
+
+LocateStatus LocateDatabase::Status() {
+  EnsureStarted();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  CheckForChangeLocked();
+  LocateStatus status;
+  if (databasePath_.empty()) {
+    status.state = "unavailable";
+  } else if (current_ != nullptr) {
+    status.state = "ready";
+  } else if (loading_) {
+    status.state = "loading";
+  } else {
+    status.state = "error";
+  }
+  status.databasePath = databasePath_;
+  status.databaseModifiedMs = identity_.modifiedNs / 1000000;
+  status.loadMs = loadMs_;
+  status.lastError = lastError_;
+  status.errorCode = errorCode_;
+  if (current_ != nullptr) {
+    status.format = current_->format();
+    status.entryCount = current_->entryCount();
+    status.directoryCount = current_->directoryCount();
+    status.checkVisibility = current_->checkVisibility();
+  }
+  return status;
+}
+
+void LocateDatabase::CheckForChangeLocked() {
+  const auto now = std::chrono::steady_clock::now();
+  if (lastCheck_ != std::chrono::steady_clock::time_point() &&
+      now - lastCheck_ < kChangeCheckInterval) {
+    return;
+  }
+  lastCheck_ = now;
+
+  std::vector<std::string> candidates;
+  if (const char* locatePath = std::getenv("LOCATE_PATH")) {
+    std::string_view remaining(locatePath);
+    while (!remaining.empty()) {
+      const auto colon = remaining.find(':');
+      if (colon != 0) {
+        candidates.emplace_back(remaining.substr(0, colon));
+      }
+      remaining = colon == std::string_view::npos ? std::string_view() : remaining.substr(colon + 1);
+    }
+  }
+  for (const char* path : kDefaultDatabases) {
+    candidates.emplace_back(path);
+  }
+
+  for (const auto& candidate : candidates) {
+    struct stat info {};
+    if (::stat(candidate.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) {
+      continue;
+    }
+    Identity identity;
+    identity.device = info.st_dev;
+    identity.inode = info.st_ino;
+    identity.size = info.st_size;
+    identity.modifiedNs = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000LL +
+        info.st_mtim.tv_nsec;
+
+    if (candidate != databasePath_) {
+      databasePath_ = candidate;
+      current_ = nullptr;
+    } else if (identity == identity_ || loading_) {
+      return;
+    }
+    StartLoadLocked(identity);
+    return;
+  }
+
+  databasePath_.clear();
+  current_ = nullptr;
+  identity_ = Identity();
+}
+
+void LocateDatabase::StartLoadLocked(const Identity& identity) {
+  if (loading_) {
+    return;
+  }
+  loading_ = true;
+  identity_ = identity;
+  std::thread([this, path = databasePath_]() { RunLoad(path); }).detach();
+}
+
+void LocateDatabase::RunLoad(std::string path) {
+  const auto startedAt = std::chrono::steady_clock::now();
+  std::string error;
+  std::string code;
+  auto loaded = LocateIndex::Load(path, error, code);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  loading_ = false;
+  // Changes seen while loading were not acted on; the next query re-checks
+  // instead of waiting out the interval.
+  lastCheck_ = std::chrono::steady_clock::time_point();
+  if (path != databasePath_) {
+    return;
+  }
+  if (loaded != nullptr) {
+    current_ = std::move(loaded);
+  }
+  loadMs_ = ElapsedMs(startedAt);
+  lastError_ = error;
+  errorCode_ = code;
+}
+
+}  // namespace tuff::native::everything
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "everything/search_types.h"
+
+namespace tuff::native::everything {
+
+// In-process reader for the system's locate database (plocate or mlocate),
+// so file search on Linux can answer from it without spawning `locate`,
+// parsing its output and stat-ing every hit from JS.
+//
+// The database is mmapped and parsed once into a name heap (plus an
+// ASCII-folded twin) and a directory table. plocate stores full paths
+// zstd-compressed in blocks of 32; mlocate stores names grouped under their
+// directory. Both end up as one entry per path pointing at its name and its
+// directory, and queries memmem the name heap as the tuff index does.
+// plocate's trigram posting lists are not used: after the one-time
+// decompression a scan of the names is already well under a millisecond for
+// typical limits, and it gives substring and prefix matching on the same
+// path.
+//
+// The file is re-stat'ed at most once a second from the query path. updatedb
+// replaces it with a rename, so a changed inode, size or mtime starts a
+// background reload while the previous copy keeps answering.
+
+struct LocateQuery {
+  std::string text;
+  SearchOptions options;
+  // Every term must start the name (or the full path with matchPath) rather
+  // than appear anywhere in it.
+  bool prefix = false;
+};
+
+struct LocateStatus {
+  std::string state;  // "unavailable" | "loading" | "ready" | "error"
+  std::string databasePath;
+  std::string format;  // "plocate" | "mlocate"
+  uint64_t entryCount = 0;
+  uint64_t directoryCount = 0;
+  // Built with updatedb --require-visibility: rows under directories this
+  // process cannot read are left out.
+  bool checkVisibility = false;
+  int64_t databaseModifiedMs = 0;
+  double loadMs = 0;
+  std::string lastError;
+  std::string errorCode;
+};
+
+// Receives rows in batches; returning false stops the query.
+using LocateSink = std::function<bool(std::vector<SearchRow>& batch)>;
+
+class LocateIndex;
+
+class LocateDatabase {
+ public:
+  static LocateDatabase& Instance();
+
+  // Picks the database ($LOCATE_PATH first, then the plocate and mlocate
+  // defaults) and starts loading it in the background. Never blocks on the
+  // load.
+  void EnsureStarted();
+
+  // Rows arrive in database order, `batchSize` at a time. Rows whose
+  // size or dates are asked for are stat'ed, and paths that no longer exist
+  // are skipped, as with `locate -e`. False is reserved for options the
+  // reader cannot honour (regex, whole-word, wildcards); a database that is
+  // missing or still loading answers with no rows.
+  bool Search(const LocateQuery& query, size_t batchSize, const LocateSink& sink,
+              SearchError& error);
+
+  LocateStatus Status();
+
+ private:
+  struct Identity {
+    dev_t device = 0;
+    ino_t inode = 0;
+    off_t size = 0;
+    int64_t modifiedNs = 0;
+
+    bool operator==(const Identity& other) const {
+      return device == other.device && inode == other.inode && size == other.size &&
+          modifiedNs == other.modifiedNs;
+    }
+  };
+
+  LocateDatabase() = default;
+
+  void CheckForChangeLocked();
+  void StartLoadLocked(const Identity& identity);
+  void RunLoad(std::string path);
+
+  std::mutex mutex_;
+  std::shared_ptr<const LocateIndex> current_;
+  std::string databasePath_;
+  bool started_ = false;
+  bool loading_ = false;
+  std::chrono::steady_clock::time_point lastCheck_;
+  // What the current (or loading) copy was read from; a failed load counts
+  // too, so an unreadable database is not retried until it changes.
+  Identity identity_;
+  double loadMs_ = 0;
+  std::string lastError_;
+  std::string errorCode_;
+};
+
+}  // namespace tuff::native::everything
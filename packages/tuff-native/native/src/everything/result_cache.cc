@@ -0,0 +1,157 @@
+#include "everything/result_cache.h"
+
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+namespace tuff::native::everything {
+
+namespace {
+
+// List node, map node and bucket slot per entry, roughly; close enough that
+// thousands of tiny results cannot hide outside the budget.
+constexpr size_t kEntryOverheadBytes = 128;
+
+void AppendU32(std::string& key, uint32_t value) {
+  char bytes[sizeof(value)];
+  std::memcpy(bytes, &value, sizeof(value));
+  key.append(bytes, sizeof(bytes));
+}
+
+}  // namespace
+
+ResultCache& ResultCache::Instance() {
+  // Leaked like the executor, whose thread reads it until process exit.
+  static auto* cache = new ResultCache();
+  return *cache;
+}
+
+std::string ResultCache::MakeKey(const std::string& query, const SearchOptions& options) {
+  std::string key;
+  key.reserve(query.size() + 6 * sizeof(uint32_t));
+  AppendU32(key, options.maxResults);
+  AppendU32(key, options.offset);
+  AppendU32(key, options.sort);
+  AppendU32(key, options.fields);
+  AppendU32(key, (options.regex ? 1U : 0U) | (options.matchCase ? 2U : 0U) |
+                     (options.matchPath ? 4U : 0U) | (options.matchWholeWord ? 8U : 0U));
+  key.append(query);
+  return key;
+}
+
+ResultCache::Encoded ResultCache::Lookup(const std::string& key, uint64_t sourceGeneration) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!EnabledLocked()) {
+    return nullptr;
+  }
+
+  const auto found = index_.find(key);
+  if (found == index_.end()) {
+    ++counters_.misses;
+    return nullptr;
+  }
+
+  const auto it = found->second;
+  if (it->sourceGeneration != sourceGeneration) {
+    ++counters_.invalidations;
+    ++counters_.misses;
+    EraseLocked(it);
+    return nullptr;
+  }
+  if (std::chrono::steady_clock::now() - it->storedAt > std::chrono::milliseconds(config_.ttlMs)) {
+    ++counters_.expirations;
+    ++counters_.misses;
+    EraseLocked(it);
+    return nullptr;
+  }
+
+  entries_.splice(entries_.begin(), entries_, it);
+  ++counters_.hits;
+  return it->encoded;
+}
+
+void ResultCache::Insert(const std::string& key, uint64_t generation, uint64_t sourceGeneration,
+                         Encoded encoded) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!EnabledLocked() || encoded == nullptr || generation != generation_) {
+    return;
+  }
+
+  const size_t bytes = encoded->size() + key.size() + kEntryOverheadBytes;
+  // One huge result must not flush everything else out.
+  if (bytes > config_.maxBytes / 4) {
+    return;
+  }
+
+  const auto found = index_.find(key);
+  if (found != index_.end()) {
+    EraseLocked(found->second);
+  }
+  TrimLocked(config_.maxBytes - bytes);
+
+  entries_.push_front(
+      Entry{key, sourceGeneration, std::chrono::steady_clock::now(), std::move(encoded), bytes});
+  index_.emplace(key, entries_.begin());
+  bytes_ += bytes;
+  ++counters_.insertions;
+}
+
+void ResultCache::Invalidate() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++generation_;
+  counters_.invalidations += entries_.size();
+  entries_.clear();
+  index_.clear();
+  bytes_ = 0;
+}
+
+void ResultCache::Configure(const ResultCacheConfig& config) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  config_ = config;
+  if (!EnabledLocked()) {
+    entries_.clear();
+    index_.clear();
+    bytes_ = 0;
+    return;
+  }
+  TrimLocked(config_.maxBytes);
+}
+
+uint64_t ResultCache::generation() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return generation_;
+}
+
+bool ResultCache::enabled() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return EnabledLocked();
+}
+
+ResultCacheStats ResultCache::Stats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ResultCacheStats stats = counters_;
+  stats.entries = entries_.size();
+  stats.bytes = bytes_;
+  stats.generation = generation_;
+  stats.config = config_;
+  return stats;
+}
+
+bool ResultCache::EnabledLocked() const {
+  return config_.maxBytes > 0 && config_.ttlMs > 0;
+}
+
+void ResultCache::EraseLocked(EntryList::iterator it) {
+  bytes_ -= it->bytes;
+  index_.erase(it->key);
+  entries_.erase(it);
+}
+
+void ResultCache::TrimLocked(size_t maxBytes) {
+  while (bytes_ > maxBytes && !entries_.empty()) {
+    EraseLocked(std::prev(entries_.end()));
+    ++counters_.evictions;
+  }
+}
+
+}  // namespace tuff::native::everything
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "everything/search_types.h"
+
+namespace tuff::native::everything {
+
+struct ResultCacheConfig {
+  // Budget for keys plus encoded results. 0 disables the cache.
+  size_t maxBytes = 16 * 1024 * 1024;
+  // How long an entry may answer without the backend being asked again. This
+  // is the only bound on staleness where the backend reports no changes (the
+  // Everything SDK has no change notification), so it is kept to about one
+  // typing burst; callers that see files change call Invalidate. 0 disables
+  // the cache.
+  uint32_t ttlMs = 1000;
+};
+
+struct ResultCacheStats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t insertions = 0;
+  // Dropped to stay under maxBytes, least recently used first.
+  uint64_t evictions = 0;
+  // Dropped on lookup because they outlived ttlMs.
+  uint64_t expirations = 0;
+  // Dropped because the database changed under them.
+  uint64_t invalidations = 0;
+  size_t entries = 0;
+  size_t bytes = 0;
+  uint64_t generation = 0;
+  ResultCacheConfig config;
+};
+
+// Process-wide LRU of recent result sets, keyed by query and SearchOptions,
+// so reopening the box or backspacing to an earlier query does not ask the
+// backend again. Entries hold the columnar encoding of the rows: one
+// allocation per result whose size is exactly what the budget counts, and a
+// columnar hit is a single memcpy into the JS buffer.
+//
+// Every entry records the backend's change counter (the source generation,
+// see BackendGeneration) it was computed under and is dropped on lookup once
+// that counter has moved on. Invalidate covers backends that count nothing:
+// it empties the cache and bumps the cache's own generation, which keeps
+// results of queries that were already running from being stored.
+class ResultCache {
+ public:
+  using Encoded = std::shared_ptr<const std::vector<uint8_t>>;
+
+  static ResultCache& Instance();
+
+  static std::string MakeKey(const std::string& query, const SearchOptions& options);
+
+  // Null on a miss. Counts the hit or miss.
+  Encoded Lookup(const std::string& key, uint64_t sourceGeneration);
+
+  // `generation` is generation() as read before the query ran; the insert is
+  // skipped if Invalidate happened since.
+  void Insert(const std::string& key, uint64_t generation, uint64_t sourceGeneration,
+              Encoded encoded);
+
+  // Drops every entry and moves the generation on, so results computed
+  // before this call are never stored either.
+  void Invalidate();
+
+  // Applies the new budget immediately, evicting as needed.
+  void Configure(const ResultCacheConfig& config);
+
+  uint64_t generation() const;
+
+  bool enabled() const;
+
+  ResultCacheStats Stats();
+
+ private:
+  struct Entry {
+    std::string key;
+    uint64_t sourceGeneration = 0;
+    std::chrono::steady_clock::time_point storedAt;
+    Encoded encoded;
+    size_t bytes = 0;
+  };
+  using EntryList = std::list<Entry>;
+
+  ResultCache() = default;
+
+  bool EnabledLocked() const;
+  void EraseLocked(EntryList::iterator it);
+  void TrimLocked(size_t maxBytes);
+
+  mutable std::mutex mutex_;
+  ResultCacheConfig config_;
+  // Most recently used first.
+  EntryList entries_;
+  std::unordered_map<std::string, EntryList::iterator> index_;
+  size_t bytes_ = 0;
+  uint64_t generation_ = 0;
+  ResultCacheStats counters_;
+};
+
+}  // namespace tuff::native::everything
@@ -0,0 +1,106 @@
+#include "everything/search_backend.h"
+
+#include <memory>
+#include <utility>
+
+#include "everything/everything_sdk.h"
+#include "everything/result_cache.h"
+#include "everything/search_metrics.h"
+
+#if defined(__linux__)
+#include "everything/linux_index.h"
+#endif
+
+namespace tuff::native::everything {
+
+bool RunSearch(const std::string& query, const SearchOptions& options,
+               std::vector<SearchRow>& rows, SearchError& error) {
+  rows.clear();
+  if (query.empty()) {
+    return true;
+  }
+
+#if defined(_WIN32)
+  return QueryEverything(query, options, rows, error);
+#else
+  if (EverythingApi::IsConfigured()) {
+    return QueryEverything(query, options, rows, error);
+  }
+#if defined(__linux__)
+  ScopedStage timed(SearchMetrics(), kSearchStageQuery);
+  return LinuxFileIndex::Instance().Search(query, options, rows, error);
+#else
+  (void)options;
+  (void)error;
+  return true;
+#endif
+#endif
+}
+
+bool RunCachedSearch(const std::string& query, const SearchOptions& options, ResultFormat format,
+                     std::vector<SearchRow>& rows, std::vector<uint8_t>& columnar,
+                     SearchError& error) {
+  rows.clear();
+  columnar.clear();
+  NativeMetrics& metrics = SearchMetrics();
+  ScopedStage timed(metrics, kSearchStageSearch);
+  metrics.Add(kSearchCounterSearches);
+  auto& cache = ResultCache::Instance();
+  if (query.empty() || !cache.enabled()) {
+    if (!RunSearch(query, options, rows, error)) {
+      metrics.Add(kSearchCounterFailed);
+      return false;
+    }
+    if (format == ResultFormat::kColumnar) {
+      ScopedStage encoding(metrics, kSearchStageEncodeColumnar);
+      columnar.resize(ColumnarByteLength(rows));
+      EncodeColumnar(rows, options.fields, columnar.data());
+      rows = std::vector<SearchRow>();
+    }
+    return true;
+  }
+
+  const auto key = ResultCache::MakeKey(query, options);
+  const auto generation = cache.generation();
+  const auto sourceGeneration = BackendGeneration();
+  {
+    ScopedStage lookup(metrics, kSearchStageCacheLookup);
+    if (const auto cached = cache.Lookup(key, sourceGeneration)) {
+      if (format == ResultFormat::kColumnar) {
+        columnar = *cached;
+        return true;
+      }
+      if (DecodeColumnar(cached->data(), cached->size(), rows)) {
+        return true;
+      }
+    }
+  }
+
+  if (!RunSearch(query, options, rows, error)) {
+    metrics.Add(kSearchCounterFailed);
+    return false;
+  }
+
+  auto encoded = std::make_shared<std::vector<uint8_t>>(ColumnarByteLength(rows));
+  {
+    ScopedStage encoding(metrics, kSearchStageEncodeColumnar);
+    EncodeColumnar(rows, options.fields, encoded->data());
+  }
+  if (format == ResultFormat::kColumnar) {
+    columnar = *encoded;
+    rows = std::vector<SearchRow>();
+  }
+  cache.Insert(key, generation, sourceGeneration, std::move(encoded));
+  return true;
+}
+
+uint64_t BackendGeneration() {
+#if defined(__linux__)
+  if (!EverythingApi::IsConfigured()) {
+    return LinuxFileIndex::Instance().Generation();
+  }
+#endif
+  return 0;
+}
+
+}  // namespace tuff::native::everything
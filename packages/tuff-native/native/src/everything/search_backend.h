@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "everything/columnar_encoding.h"
+#include "everything/search_types.h"
+
+namespace tuff::native::everything {
+
+// Runs one query against whichever backend answers `search` on this platform:
+// the Everything SDK on Windows (or wherever TALEX_EVERYTHING_DLL_PATH names a
+// library), the in-process index on Linux, nothing elsewhere. Blocking; safe to
+// call from any thread.
+bool RunSearch(const std::string& query, const SearchOptions& options,
+               std::vector<SearchRow>& rows, SearchError& error);
+
+// RunSearch behind the process-wide ResultCache. Fills `columnar` for
+// ResultFormat::kColumnar and `rows` otherwise.
+bool RunCachedSearch(const std::string& query, const SearchOptions& options, ResultFormat format,
+                     std::vector<SearchRow>& rows, std::vector<uint8_t>& columnar,
+                     SearchError& error);
+
+// Change counter of the backend that answers RunSearch: moves on whenever the
+// data behind it may have changed. Always 0 for the Everything SDK, which
+// reports no changes; the cache's TTL and invalidateCache() cover it.
+uint64_t BackendGeneration();
+
+}  // namespace tuff::native::everything
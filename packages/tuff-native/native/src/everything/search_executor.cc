@@ -0,0 +1,164 @@
+#include "everything/search_executor.h"
+
+#include <cstring>
+#include <thread>
+#include <utility>
+
+#include "everything/search_backend.h"
+#include "everything/search_metrics.h"
+
+namespace tuff::native::everything {
+
+namespace {
+
+constexpr const char* kSupersededCode = "ERR_EVERYTHING_SUPERSEDED";
+constexpr const char* kCancelledCode = "ERR_EVERYTHING_SEARCH_ABORTED";
+
+void CompleteWithError(SearchJob& job, const char* code, const char* message) {
+  SearchJobResult result;
+  result.requestId = job.requestId;
+  result.error.code = code;
+  result.error.message = message;
+  SearchMetrics().Add(std::strcmp(code, kSupersededCode) == 0 ? kSearchCounterSuperseded
+                                                              : kSearchCounterCancelled);
+  job.complete(std::move(result));
+}
+
+}  // namespace
+
+SearchExecutor& SearchExecutor::Instance() {
+  // Leaked: the worker may still be inside the backend at process exit.
+  static auto* executor = new SearchExecutor();
+  return *executor;
+}
+
+void SearchExecutor::EnsureThreadLocked() {
+  if (started_) {
+    return;
+  }
+  std::thread([this] { Run(); }).detach();
+  started_ = true;
+}
+
+void SearchExecutor::TakeSupersededLocked(const std::string& channel,
+                                          std::vector<SearchJob>& superseded) {
+  for (auto it = queue_.begin(); it != queue_.end();) {
+    if (it->channel == channel) {
+      superseded.push_back(std::move(*it));
+      it = queue_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  if (runningId_ != 0 && runningChannel_ == channel && runningDrop_.code.empty()) {
+    runningDrop_.code = kSupersededCode;
+    runningDrop_.message = "Search was superseded by a newer query";
+  }
+}
+
+void SearchExecutor::SupersedeChannel(const std::string& channel) {
+  std::vector<SearchJob> superseded;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    TakeSupersededLocked(channel, superseded);
+  }
+
+  for (auto& stale : superseded) {
+    CompleteWithError(stale, kSupersededCode, "Search was superseded by a newer query");
+  }
+}
+
+void SearchExecutor::Submit(SearchJob job) {
+  job.submittedAt = SearchMetrics().enabled() ? NativeMetrics::Now() : 0;
+  std::vector<SearchJob> superseded;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    TakeSupersededLocked(job.channel, superseded);
+    queue_.push_back(std::move(job));
+    EnsureThreadLocked();
+  }
+  wake_.notify_one();
+
+  for (auto& stale : superseded) {
+    CompleteWithError(stale, kSupersededCode, "Search was superseded by a newer query");
+  }
+}
+
+SearchExecutorStats SearchExecutor::Stats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  SearchExecutorStats stats;
+  stats.queued = static_cast<uint32_t>(queue_.size());
+  stats.running = running_;
+  return stats;
+}
+
+bool SearchExecutor::Cancel(uint64_t requestId) {
+  SearchJob cancelled;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (runningId_ == requestId) {
+      if (!runningDrop_.code.empty()) {
+        return false;
+      }
+      runningDrop_.code = kCancelledCode;
+      runningDrop_.message = "Search was aborted";
+      return true;
+    }
+
+    auto it = queue_.begin();
+    while (it != queue_.end() && it->requestId != requestId) {
+      ++it;
+    }
+    if (it == queue_.end()) {
+      return false;
+    }
+    cancelled = std::move(*it);
+    queue_.erase(it);
+  }
+
+  CompleteWithError(cancelled, kCancelledCode, "Search was aborted");
+  return true;
+}
+
+void SearchExecutor::Run() {
+  while (true) {
+    SearchJob job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [this] { return !queue_.empty(); });
+      job = std::move(queue_.front());
+      queue_.pop_front();
+      running_ = true;
+      runningId_ = job.requestId;
+      runningChannel_ = job.channel;
+      runningDrop_ = SearchError();
+    }
+    if (job.submittedAt != 0) {
+      SearchMetrics().Record(kSearchStageQueueWait, job.submittedAt, NativeMetrics::Now());
+    }
+
+    SearchJobResult result;
+    result.requestId = job.requestId;
+    result.ok = RunCachedSearch(job.query, job.options, job.format, result.rows, result.columnar,
+                                result.error);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!runningDrop_.code.empty()) {
+        result.ok = false;
+        result.rows.clear();
+        result.columnar.clear();
+        result.error = runningDrop_;
+        SearchMetrics().Add(runningDrop_.code == kSupersededCode ? kSearchCounterSuperseded
+                                                                 : kSearchCounterCancelled);
+      }
+      running_ = false;
+      runningId_ = 0;
+      runningChannel_.clear();
+    }
+
+    job.complete(std::move(result));
+  }
+}
+
+}  // namespace tuff::native::everything
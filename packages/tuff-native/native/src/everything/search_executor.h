@@ -0,0 +1,90 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "everything/columnar_encoding.h"
+#include "everything/search_types.h"
+
+namespace tuff::native::everything {
+
+struct SearchJobResult {
+  uint64_t requestId = 0;
+  bool ok = false;
+  std::vector<SearchRow> rows;
+  // Filled instead of `rows` for ResultFormat::kColumnar, so the encoding
+  // happens here rather than on the JS thread.
+  std::vector<uint8_t> columnar;
+  SearchError error;
+};
+
+struct SearchJob {
+  uint64_t requestId = 0;
+  // Jobs on the same channel are latest-wins: submitting one supersedes every
+  // older job on that channel that has not delivered yet.
+  std::string channel;
+  std::string query;
+  SearchOptions options;
+  ResultFormat format = ResultFormat::kObjects;
+  // Called exactly once, from the executor thread or from the thread that
+  // cancelled or superseded the job. Must not call back into the executor.
+  std::function<void(SearchJobResult&&)> complete;
+  // NativeMetrics::Now() at Submit, or 0 while metrics are off.
+  uint64_t submittedAt = 0;
+};
+
+struct SearchExecutorStats {
+  // Jobs waiting, and whether one is with the backend, right now.
+  uint32_t queued = 0;
+  bool running = false;
+};
+
+// One dedicated thread that owns every asynchronous query, so the SDK's
+// process-global query state is only ever touched from here and from the
+// synchronous `search` (which takes the same SDK lock).
+//
+// A query already handed to the backend cannot be interrupted, so cancelling
+// or superseding the running job only drops its result. Queued jobs are
+// removed without ever reaching the backend, which is what keeps a burst of
+// keystrokes down to at most two backend queries: the one running and the
+// newest one.
+class SearchExecutor {
+ public:
+  static SearchExecutor& Instance();
+
+  void Submit(SearchJob job);
+
+  // Returns false when the request is unknown or has already delivered.
+  bool Cancel(uint64_t requestId);
+
+  // Supersedes every job on `channel` without queuing a new one, for callers
+  // that answered a newer query some other way (a search session's cache).
+  void SupersedeChannel(const std::string& channel);
+
+  SearchExecutorStats Stats();
+
+ private:
+  SearchExecutor() = default;
+
+  void EnsureThreadLocked();
+  void TakeSupersededLocked(const std::string& channel, std::vector<SearchJob>& superseded);
+  void Run();
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::deque<SearchJob> queue_;
+  bool started_ = false;
+  bool running_ = false;
+  uint64_t runningId_ = 0;
+  std::string runningChannel_;
+  // Set instead of completing the running job directly; the worker reports
+  // the job with this error once the backend returns.
+  SearchError runningDrop_;
+};
+
+}  // namespace tuff::native::everything
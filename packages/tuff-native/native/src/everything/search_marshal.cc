@@ -0,0 +1,124 @@
+#include "everything/search_marshal.h"
+
+#include <algorithm>
+
+namespace tuff::native::everything {
+
+namespace {
+
+// `fields: ['name', 'fullPath']` narrows what every backend fetches. An empty
+// or unrecognised list means all fields, the same as leaving it out.
+uint32_t ParseFields(const Napi::Array& rawFields) {
+  static constexpr struct {
+    const char* name;
+    uint32_t bit;
+  } kFieldNames[] = {
+      {"fullPath", kFieldFullPath},
+      {"path", kFieldPath},
+      {"name", kFieldName},
+      {"filename", kFieldName},
+      {"extension", kFieldExtension},
+      {"size", kFieldSize},
+      {"dateModified", kFieldDateModified},
+      {"dateCreated", kFieldDateCreated},
+      {"isFolder", kFieldIsFolder},
+  };
+
+  uint32_t fields = 0;
+  for (uint32_t i = 0; i < rawFields.Length(); ++i) {
+    const auto value = rawFields.Get(i);
+    if (!value.IsString()) {
+      continue;
+    }
+    const auto name = value.As<Napi::String>().Utf8Value();
+    for (const auto& field : kFieldNames) {
+      if (name == field.name) {
+        fields |= field.bit;
+        break;
+      }
+    }
+  }
+  return fields != 0 ? fields : kAllFields;
+}
+
+}  // namespace
+
+Napi::Object ToJsRow(Napi::Env env, const SearchRow& row, uint32_t fields, JsStrings& strings) {
+  auto result = Napi::Object::New(env);
+  if (fields & kFieldFullPath) {
+    result.Set("fullPath", strings.New(row.fullPath));
+  }
+  if (fields & kFieldPath) {
+    result.Set("path", strings.Intern(row.path));
+  }
+  if (fields & kFieldName) {
+    const auto name = strings.New(row.name);
+    result.Set("name", name);
+    result.Set("filename", name);
+  }
+  if (fields & kFieldExtension) {
+    result.Set("extension", strings.Intern(row.extension));
+  }
+  if ((fields & kFieldSize) && row.hasSize) {
+    result.Set("size", Napi::Number::New(env, row.size));
+  }
+  if ((fields & kFieldDateModified) && row.hasDateModified) {
+    result.Set("dateModified", Napi::Number::New(env, row.dateModified));
+  }
+  if ((fields & kFieldDateCreated) && row.hasDateCreated) {
+    result.Set("dateCreated", Napi::Number::New(env, row.dateCreated));
+  }
+  if ((fields & kFieldIsFolder) && row.hasIsFolder) {
+    result.Set("isFolder", Napi::Boolean::New(env, row.isFolder));
+  }
+  return result;
+}
+
+Napi::Array ToJsRows(Napi::Env env, const std::vector<SearchRow>& rows, uint32_t fields) {
+  JsStrings strings(env);
+  auto resultArray = Napi::Array::New(env, rows.size());
+  for (size_t i = 0; i < rows.size(); ++i) {
+    resultArray.Set(static_cast<uint32_t>(i), ToJsRow(env, rows[i], fields, strings));
+  }
+  return resultArray;
+}
+
+void ParseSearchOptions(const Napi::Object& rawOptions, SearchOptions& options) {
+  if (rawOptions.Has("maxResults") && rawOptions.Get("maxResults").IsNumber()) {
+    const int32_t maxResults = rawOptions.Get("maxResults").As<Napi::Number>().Int32Value();
+    options.maxResults = static_cast<uint32_t>(
+        std::clamp(maxResults, 1, static_cast<int32_t>(kMaxResultsLimit)));
+  }
+
+  if (rawOptions.Has("offset") && rawOptions.Get("offset").IsNumber()) {
+    const int32_t offset = rawOptions.Get("offset").As<Napi::Number>().Int32Value();
+    options.offset = static_cast<uint32_t>(std::max(offset, 0));
+  }
+
+  if (rawOptions.Has("sort") && rawOptions.Get("sort").IsNumber()) {
+    const int32_t sort = rawOptions.Get("sort").As<Napi::Number>().Int32Value();
+    options.sort = static_cast<uint32_t>(std::max(sort, 0));
+  }
+
+  if (rawOptions.Has("regex") && rawOptions.Get("regex").IsBoolean()) {
+    options.regex = rawOptions.Get("regex").As<Napi::Boolean>().Value();
+  }
+
+  if (rawOptions.Has("matchCase") && rawOptions.Get("matchCase").IsBoolean()) {
+    options.matchCase = rawOptions.Get("matchCase").As<Napi::Boolean>().Value();
+  }
+
+  if (rawOptions.Has("matchPath") && rawOptions.Get("matchPath").IsBoolean()) {
+    options.matchPath = rawOptions.Get("matchPath").As<Napi::Boolean>().Value();
+  }
+
+  if (rawOptions.Has("matchWholeWord") && rawOptions.Get("matchWholeWord").IsBoolean()) {
+    options.matchWholeWord = rawOptions.Get("matchWholeWord").As<Napi::Boolean>().Value();
+  }
+
+  if (rawOptions.Has("fields") && rawOptions.Get("fields").IsArray()) {
+    options.fields = ParseFields(rawOptions.Get("fields").As<Napi::Array>());
+  }
+}
+
+}  // namespace tuff::native::everything
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <napi.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "common/js_string.h"
+#include "everything/search_types.h"
+
+namespace tuff::native::everything {
+
+// Conversions between the JS shapes of everything.d.ts and the search types,
+// shared by the addon and the native benchmarks.
+
+// One object per row, with only the properties in `fields`. Rows marshalled
+// through the same `strings` share one JS string per parent directory and
+// extension, so the rows must outlive it.
+Napi::Object ToJsRow(Napi::Env env, const SearchRow& row, uint32_t fields, JsStrings& strings);
+Napi::Array ToJsRows(Napi::Env env, const std::vector<SearchRow>& rows, uint32_t fields);
+
+// Reads the options object of a search into `options`; keys it does not
+// mention, or of the wrong type, keep their value.
+void ParseSearchOptions(const Napi::Object& rawOptions, SearchOptions& options);
+
+}  // namespace tuff::native::everything
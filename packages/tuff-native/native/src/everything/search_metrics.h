@@ -0,0 +1,43 @@
+#pragma once
+
+#include "common/native_metrics.h"
+
+namespace tuff::native::everything {
+
+// Stages of a search timed by getNativeMetrics().
+enum SearchStage : uint32_t {
+  // searchAsync to the executor thread picking the job up.
+  kSearchStageQueueWait,
+  kSearchStageCacheLookup,
+  // The backend query: Everything_Query, or the in-process index on Linux,
+  // which builds its rows as it matches.
+  kSearchStageQuery,
+  // Reading the SDK's results into rows.
+  kSearchStageRowBuild,
+  kSearchStageEncodeColumnar,
+  // RunCachedSearch as a whole, answered from the cache or not.
+  kSearchStageSearch,
+  // Building the JS rows or buffer on the JS thread.
+  kSearchStageMarshal,
+  kSearchStageCount,
+};
+
+enum SearchCounter : uint32_t {
+  kSearchCounterSearches,
+  kSearchCounterFailed,
+  kSearchCounterSuperseded,
+  kSearchCounterCancelled,
+  kSearchCounterCount,
+};
+
+// The process-wide metrics of the Everything addon.
+inline NativeMetrics& SearchMetrics() {
+  static const char* const kStages[kSearchStageCount] = {
+      "queueWait", "cacheLookup", "query", "rowBuild", "encodeColumnar", "search", "marshal"};
+  static const char* const kCounters[kSearchCounterCount] = {"searches", "failed", "superseded",
+                                                            "cancelled"};
+  static NativeMetrics metrics(kStages, kSearchStageCount, kCounters, kSearchCounterCount);
+  return metrics;
+}
+
+}  // namespace tuff::native::everything
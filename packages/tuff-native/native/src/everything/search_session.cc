@@ -0,0 +1,179 @@
+#include "everything/search_session.h"
+
+#include <cstring>
+
+namespace tuff::native::everything {
+
+namespace {
+
+// A base result older than this is re-queried even if the query still
+// narrows: a typeahead burst is seconds long, and files come and go.
+constexpr auto kBaseTtl = std::chrono::seconds(10);
+
+// True when `value` has a code point a backend may fold into another when
+// matching: Everything ignores diacritics unless asked to, separately from
+// matchCase ("cafe" finds "café" and "Café" finds "CAFE" either way), and
+// folds non-ASCII case and width. Below U+2E80 (Latin, Greek, Cyrillic,
+// combining marks...) and the U+FF00 half/fullwidth forms count; CJK, kana,
+// Hangul and supplementary planes have neither case nor diacritics. Stray
+// continuation or invalid lead bytes count too.
+bool MayFold(const std::string& value) {
+  for (size_t i = 0; i < value.size(); ++i) {
+    const auto lead = static_cast<unsigned char>(value[i]);
+    if (lead < 0x80) {
+      continue;
+    }
+    if (lead < 0xE0 || lead > 0xF4) {
+      return true;  // two-byte sequence (below U+0800) or not a lead byte
+    }
+    if (i + 1 >= value.size()) {
+      return true;
+    }
+    const auto next = static_cast<unsigned char>(value[i + 1]);
+    // E0-E1 xx: U+0800-U+1FFF; E2 80-B9: U+2000-U+2E7F; EF BC-BF: U+FF00-U+FFFF.
+    if (lead < 0xE2 || (lead == 0xE2 && next < 0xBA) || (lead == 0xEF && next >= 0xBC)) {
+      return true;
+    }
+    i += lead < 0xF0 ? 2 : 3;
+  }
+  return false;
+}
+
+bool IsPlainQuery(const std::string& query) {
+  for (const char ch : query) {
+    if (std::strchr("\"*?|!<>:\\/", ch) != nullptr) {
+      return false;
+    }
+  }
+  return !MayFold(query);
+}
+
+bool SameMatching(const SearchOptions& left, const SearchOptions& right) {
+  return left.sort == right.sort && left.offset == right.offset &&
+      left.regex == right.regex && left.matchCase == right.matchCase &&
+      left.matchPath == right.matchPath && left.matchWholeWord == right.matchWholeWord;
+}
+
+std::vector<std::string> SplitTerms(const std::string& query, bool matchCase) {
+  std::vector<std::string> terms;
+  size_t start = 0;
+  while (start < query.size()) {
+    while (start < query.size() && (query[start] == ' ' || query[start] == '\t')) {
+      ++start;
+    }
+    size_t end = start;
+    while (end < query.size() && query[end] != ' ' && query[end] != '\t') {
+      ++end;
+    }
+    if (end > start) {
+      std::string term = query.substr(start, end - start);
+      if (!matchCase) {
+        for (auto& ch : term) {
+          if (ch >= 'A' && ch <= 'Z') {
+            ch = static_cast<char>(ch - 'A' + 'a');
+          }
+        }
+      }
+      terms.push_back(std::move(term));
+    }
+    start = end;
+  }
+  return terms;
+}
+
+bool ContainsFolded(const std::string& haystack, const std::string& needle, bool matchCase,
+                    std::string& scratch) {
+  if (matchCase) {
+    return haystack.find(needle) != std::string::npos;
+  }
+  scratch.assign(haystack);
+  for (auto& ch : scratch) {
+    if (ch >= 'A' && ch <= 'Z') {
+      ch = static_cast<char>(ch - 'A' + 'a');
+    }
+  }
+  return scratch.find(needle) != std::string::npos;
+}
+
+}  // namespace
+
+bool SearchSessionCache::TryNarrow(const std::string& query, const SearchOptions& options,
+                                   std::vector<SearchRow>& rows) {
+  if (!valid_ || query.empty() || query.compare(0, query_.size(), query_) != 0) {
+    return false;
+  }
+  if (std::chrono::steady_clock::now() - storedAt_ > kBaseTtl) {
+    return false;
+  }
+  if (!SameMatching(options, options_) || options.regex || options.matchWholeWord ||
+      options.offset != 0 || (options.fields & ~options_.fields) != 0) {
+    return false;
+  }
+  if (rows_.size() >= options_.maxResults) {
+    return false;
+  }
+  if (!IsPlainQuery(query)) {
+    return false;
+  }
+
+  const auto terms = SplitTerms(query, options.matchCase);
+  std::string scratch;
+  rows.clear();
+  for (const auto& row : rows_) {
+    const auto& haystack = options.matchPath ? row.fullPath : row.name;
+    bool matched = true;
+    for (const auto& term : terms) {
+      if (!ContainsFolded(haystack, term, options.matchCase, scratch)) {
+        matched = false;
+        break;
+      }
+    }
+    if (!matched && MayFold(haystack)) {
+      // The backend may match this row through a folded code point, with or
+      // without matchCase; a byte filter cannot tell.
+      rows.clear();
+      return false;
+    }
+    if (matched) {
+      rows.push_back(row);
+      if (rows.size() >= options.maxResults) {
+        break;
+      }
+    }
+  }
+
+  ++stats_.narrowedQueries;
+  return true;
+}
+
+void SearchSessionCache::Store(const std::string& query, const SearchOptions& options,
+                               const std::vector<SearchRow>& rows) {
+  ++stats_.backendQueries;
+  // Only plain queries can ever be narrowed, so only those are worth keeping.
+  if (query.empty() || options.regex || options.matchWholeWord || options.offset != 0 ||
+      !IsPlainQuery(query)) {
+    Clear();
+    return;
+  }
+
+  valid_ = true;
+  query_ = query;
+  options_ = options;
+  rows_ = rows;
+  storedAt_ = std::chrono::steady_clock::now();
+}
+
+void SearchSessionCache::Clear() {
+  valid_ = false;
+  query_.clear();
+  rows_.clear();
+  rows_.shrink_to_fit();
+}
+
+SearchSessionCache::Stats SearchSessionCache::GetStats() const {
+  Stats stats = stats_;
+  stats.cachedRows = valid_ ? rows_.size() : 0;
+  return stats;
+}
+
+}  // namespace tuff::native::everything
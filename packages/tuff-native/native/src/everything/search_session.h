@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "everything/search_types.h"
+
+namespace tuff::native::everything {
+
+// Result cache behind `createSearchSession()`. Typeahead only ever narrows a
+// query ("repo" -> "repor" -> "report"), and every row matching "report" also
+// matches "repo", so once the backend has answered "repo" with a complete
+// result set the later keystrokes can be answered by filtering that set
+// instead of asking the backend again.
+//
+// The cache keeps the backend's answer as the base and filters from it on
+// every keystroke, so backspacing to anything that still extends the base
+// query is answered locally too. Narrowing is only attempted when it is
+// provably the same answer the backend would give:
+//   - the base result was complete (fewer rows than its maxResults, offset 0)
+//   - the new query starts with the base query and all other options match
+//   - both are plain terms: no regex or whole-word matching, no wildcards,
+//     quotes, operators or path separators, and no text a backend may fold
+//     (accented or non-ASCII cased letters, fullwidth forms), whether or not
+//     matching case: Everything ignores diacritics independently of case, and
+//     a byte filter cannot reproduce either folding. CJK text narrows. A base
+//     row with foldable text that the filter rejects sends the query back to
+//     the backend for the same reason.
+// Anything else is a backend query that becomes the new base.
+//
+// Not thread-safe; the addon only touches a session from the JS thread.
+class SearchSessionCache {
+ public:
+  struct Stats {
+    uint64_t backendQueries = 0;
+    uint64_t narrowedQueries = 0;
+    size_t cachedRows = 0;
+  };
+
+  // Columns the session always fetches on top of the caller's, because the
+  // filter needs them.
+  static constexpr uint32_t kRequiredFields = kFieldName | kFieldFullPath;
+
+  bool TryNarrow(const std::string& query, const SearchOptions& options,
+                 std::vector<SearchRow>& rows);
+
+  void Store(const std::string& query, const SearchOptions& options,
+             const std::vector<SearchRow>& rows);
+
+  void Clear();
+
+  Stats GetStats() const;
+
+ private:
+  bool valid_ = false;
+  std::string query_;
+  SearchOptions options_;
+  std::vector<SearchRow> rows_;
+  std::chrono::steady_clock::time_point storedAt_;
+  Stats stats_;
+};
+
+}  // namespace tuff::native::everything
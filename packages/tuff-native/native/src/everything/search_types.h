@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tuff::native::everything {
+
+constexpr uint32_t kDefaultMaxResults = 50;
+constexpr uint32_t kMaxResultsLimit = 5000;
+
+// Everything SDK sort constants (EVERYTHING_SORT_*). The Linux index honours the
+// same values so `options.sort` means one thing on every platform.
+constexpr uint32_t kSortNameAscending = 1;
+constexpr uint32_t kSortNameDescending = 2;
+constexpr uint32_t kSortPathAscending = 3;
+constexpr uint32_t kSortPathDescending = 4;
+constexpr uint32_t kSortSizeAscending = 5;
+constexpr uint32_t kSortSizeDescending = 6;
+constexpr uint32_t kSortExtensionAscending = 7;
+constexpr uint32_t kSortExtensionDescending = 8;
+constexpr uint32_t kSortTypeNameAscending = 9;
+constexpr uint32_t kSortTypeNameDescending = 10;
+constexpr uint32_t kSortDateCreatedAscending = 11;
+constexpr uint32_t kSortDateCreatedDescending = 12;
+constexpr uint32_t kSortDateModifiedAscending = 13;
+constexpr uint32_t kSortDateModifiedDescending = 14;
+
+// Result columns, selectable with `options.fields`. A backend skips the work
+// (and for the SDK, the IPC) behind every column that is not asked for, and
+// the addon leaves the matching JS properties unset.
+constexpr uint32_t kFieldFullPath = 1U << 0;
+constexpr uint32_t kFieldPath = 1U << 1;
+constexpr uint32_t kFieldName = 1U << 2;
+constexpr uint32_t kFieldExtension = 1U << 3;
+constexpr uint32_t kFieldSize = 1U << 4;
+constexpr uint32_t kFieldDateModified = 1U << 5;
+constexpr uint32_t kFieldDateCreated = 1U << 6;
+constexpr uint32_t kFieldIsFolder = 1U << 7;
+constexpr uint32_t kAllFields = 0xFF;
+
+struct SearchOptions {
+  uint32_t maxResults = kDefaultMaxResults;
+  uint32_t offset = 0;
+  uint32_t sort = kSortPathAscending;
+  bool regex = false;
+  bool matchCase = false;
+  bool matchPath = false;
+  bool matchWholeWord = false;
+  uint32_t fields = kAllFields;
+};
+
+// One result row, independent of the backend that produced it. Optional
+// columns carry a has* flag so a backend that cannot supply them (an SDK build
+// without the optional getters) leaves the JS property unset, as before.
+// String columns outside `options.fields` are left empty.
+struct SearchRow {
+  std::string fullPath;
+  std::string path;
+  std::string name;
+  std::string extension;
+  double size = 0;
+  double dateModified = 0;
+  double dateCreated = 0;
+  bool isFolder = false;
+  bool hasSize = false;
+  bool hasDateModified = false;
+  bool hasDateCreated = false;
+  bool hasIsFolder = false;
+};
+
+struct SearchError {
+  std::string code;
+  std::string message;
+};
+
+}  // namespace tuff::native::everything
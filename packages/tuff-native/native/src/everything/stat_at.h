@@ -0,0 +1,68 @@
+#pragma once
+
+#if defined(__linux__)
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+
+namespace tuff::native::everything {
+
+// Set by the first statx(2) that fails with ENOSYS, as on kernels before
+// 4.11; from then on the whole process stats with fstatat(2).
+inline std::atomic<bool>& StatxMissing() {
+  static std::atomic<bool> missing{false};
+  return missing;
+}
+
+// statx(2) of `name` relative to `dirFd` (AT_FDCWD for a path), falling back
+// to fstatat(2) where the kernel has no statx. The fallback fills the basic
+// fields and leaves STATX_BTIME out of stx_mask, so callers check the mask
+// as they would for a filesystem without birth times. False with errno set
+// when the entry cannot be stat'ed.
+inline bool StatAt(int dirFd, const char* name, int flags, unsigned mask, struct statx& info) {
+  std::atomic<bool>& missing = StatxMissing();
+  if (!missing.load(std::memory_order_relaxed)) {
+    info = {};
+    if (::statx(dirFd, name, flags, mask, &info) == 0) {
+      return true;
+    }
+    if (errno != ENOSYS) {
+      return false;
+    }
+    missing.store(true, std::memory_order_relaxed);
+  }
+
+  struct stat fallback {};
+  if (::fstatat(dirFd, name, &fallback, flags) != 0) {
+    return false;
+  }
+  const auto timestamp = [](const struct timespec& value) {
+    struct statx_timestamp result {};
+    result.tv_sec = value.tv_sec;
+    result.tv_nsec = static_cast<uint32_t>(value.tv_nsec);
+    return result;
+  };
+  info = {};
+  info.stx_mask = STATX_BASIC_STATS;
+  info.stx_mode = static_cast<uint16_t>(fallback.st_mode);
+  info.stx_nlink = static_cast<uint32_t>(fallback.st_nlink);
+  info.stx_uid = fallback.st_uid;
+  info.stx_gid = fallback.st_gid;
+  info.stx_ino = fallback.st_ino;
+  info.stx_size = static_cast<uint64_t>(std::max<off_t>(fallback.st_size, 0));
+  info.stx_blocks = static_cast<uint64_t>(fallback.st_blocks);
+  info.stx_blksize = static_cast<uint32_t>(fallback.st_blksize);
+  info.stx_atime = timestamp(fallback.st_atim);
+  info.stx_mtime = timestamp(fallback.st_mtim);
+  info.stx_ctime = timestamp(fallback.st_ctim);
+  return true;
+}
+
+}  // namespace tuff::native::everything
+
+#endif
@@ -0,0 +1,497 @@
+#include "everything/stat_batch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <utility>
+
+#if defined(_WIN32)
+#include "common/utf_transcode.h"
+#include "everything/everything_sdk.h"
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+#if defined(__linux__)
+#include "everything/stat_at.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+#endif
+
+// IORING_OP_STATX and the opcode probe both arrived in Linux 5.6, as did
+// IORING_FEAT_CUR_PERSONALITY, which is the only one of the three the headers
+// expose as a macro.
+#if defined(__linux__) && defined(__NR_io_uring_setup) && defined(IORING_FEAT_CUR_PERSONALITY)
+#define TUFF_STAT_IO_URING 1
+#else
+#define TUFF_STAT_IO_URING 0
+#endif
+
+namespace tuff::native::everything {
+
+namespace {
+
+// Views over the columns of one packed result.
+class Columns {
+ public:
+  Columns(StatBatchResult& result, size_t count) : count_(count) {
+    result.count = count;
+    result.packed.assign(StatBatchLayout::ByteLength(count), 0);
+    base_ = result.packed.data();
+  }
+
+  void SetTimes(size_t index, double size, double mtimeMs, double ctimeMs, double birthtimeMs) {
+    Store(StatBatchLayout::SizeOffset(count_) + index * 8, size);
+    Store(StatBatchLayout::MtimeOffset(count_) + index * 8, mtimeMs);
+    Store(StatBatchLayout::CtimeOffset(count_) + index * 8, ctimeMs);
+    Store(StatBatchLayout::BirthtimeOffset(count_) + index * 8, birthtimeMs);
+  }
+
+  void SetError(size_t index, int32_t error) {
+    std::memcpy(base_ + StatBatchLayout::ErrnoOffset(count_) + index * 4, &error, sizeof(error));
+  }
+
+  void SetFlags(size_t index, uint8_t flags) {
+    base_[StatBatchLayout::FlagsOffset(count_) + index] = flags;
+  }
+
+ private:
+  void Store(size_t offset, double value) {
+    std::memcpy(base_ + offset, &value, sizeof(value));
+  }
+
+  size_t count_;
+  uint8_t* base_;
+};
+
+#if defined(_WIN32)
+
+constexpr uint64_t kWindowsEpochOffset100Ns = 116444736000000000ULL;
+
+double FileTimeToMillis(const FILETIME& fileTime) {
+  const uint64_t value =
+      (static_cast<uint64_t>(fileTime.dwHighDateTime) << 32) | fileTime.dwLowDateTime;
+  if (value <= kWindowsEpochOffset100Ns) {
+    return 0;
+  }
+  return static_cast<double>(value - kWindowsEpochOffset100Ns) / 10000.0;
+}
+
+int32_t ErrnoFromWin32(DWORD code) {
+  switch (code) {
+    case ERROR_FILE_NOT_FOUND:
+    case ERROR_PATH_NOT_FOUND:
+    case ERROR_INVALID_NAME:
+      return ENOENT;
+    case ERROR_ACCESS_DENIED:
+      return EACCES;
+    default:
+      return EIO;
+  }
+}
+
+// GetFileAttributesExW reads the directory entry without opening the file.
+// It reports a reparse point itself rather than its target, so `noFollow`
+// is what it always does; Windows keeps no status-change time, so ctimeMs is
+// the last write.
+void ResolveOne(const std::string& path, bool, Columns& columns, size_t index) {
+  WIN32_FILE_ATTRIBUTE_DATA data{};
+  if (!::GetFileAttributesExW(Utf8ToWide(path).c_str(), GetFileExInfoStandard, &data)) {
+    columns.SetError(index, ErrnoFromWin32(::GetLastError()));
+    return;
+  }
+
+  const bool isDirectory = (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+  uint8_t flags = kStatExists | (isDirectory ? kStatDirectory : kStatFile);
+  if (data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) {
+    flags |= kStatSymlink;
+  }
+  const uint64_t size =
+      (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+  const double modified = FileTimeToMillis(data.ftLastWriteTime);
+  columns.SetTimes(index, static_cast<double>(size), modified, modified,
+                   FileTimeToMillis(data.ftCreationTime));
+  columns.SetFlags(index, flags);
+}
+
+constexpr const char* kSyncEngine = "win32";
+
+#else
+
+uint8_t FlagsForMode(mode_t mode) {
+  uint8_t flags = kStatExists;
+  if (S_ISDIR(mode)) {
+    flags |= kStatDirectory;
+  } else if (S_ISREG(mode)) {
+    flags |= kStatFile;
+  } else if (S_ISLNK(mode)) {
+    flags |= kStatSymlink;
+  }
+  return flags;
+}
+
+#if defined(__linux__)
+
+constexpr unsigned kStatxMask = STATX_TYPE | STATX_MODE | STATX_SIZE | STATX_MTIME |
+    STATX_CTIME | STATX_BTIME;
+
+double ToMillis(const struct statx_timestamp& value) {
+  return static_cast<double>(value.tv_sec) * 1000.0 + static_cast<double>(value.tv_nsec) / 1e6;
+}
+
+void StoreStatx(const struct statx& info, Columns& columns, size_t index) {
+  columns.SetTimes(index, static_cast<double>(info.stx_size), ToMillis(info.stx_mtime),
+                   ToMillis(info.stx_ctime),
+                   (info.stx_mask & STATX_BTIME) ? ToMillis(info.stx_btime) : 0);
+  columns.SetFlags(index, FlagsForMode(info.stx_mode));
+}
+
+void ResolveOne(const std::string& path, bool noFollow, Columns& columns, size_t index) {
+  struct statx info {};
+  if (!StatAt(AT_FDCWD, path.c_str(), noFollow ? AT_SYMLINK_NOFOLLOW : 0, kStatxMask, info)) {
+    columns.SetError(index, errno);
+    return;
+  }
+  StoreStatx(info, columns, index);
+}
+
+constexpr const char* kSyncEngine = "statx";
+
+#else
+
+double ToMillis(const struct timespec& value) {
+  return static_cast<double>(value.tv_sec) * 1000.0 + static_cast<double>(value.tv_nsec) / 1e6;
+}
+
+void ResolveOne(const std::string& path, bool noFollow, Columns& columns, size_t index) {
+  struct stat info {};
+  const int status = noFollow ? ::lstat(path.c_str(), &info) : ::stat(path.c_str(), &info);
+  if (status != 0) {
+    columns.SetError(index, errno);
+    return;
+  }
+
+#if defined(__APPLE__)
+  columns.SetTimes(index, static_cast<double>(info.st_size), ToMillis(info.st_mtimespec),
+                   ToMillis(info.st_ctimespec), ToMillis(info.st_birthtimespec));
+#else
+  columns.SetTimes(index, static_cast<double>(info.st_size), ToMillis(info.st_mtim),
+                   ToMillis(info.st_ctim), 0);
+#endif
+  columns.SetFlags(index, FlagsForMode(info.st_mode));
+}
+
+constexpr const char* kSyncEngine = "stat";
+
+#endif
+#endif
+
+#if TUFF_STAT_IO_URING
+
+// The kernel always hands STATX to its io-wq workers, which costs more than
+// a warm statx (about a microsecond from the dentry cache). So the first
+// paths of a batch are stat'ed inline and timed, and only a batch whose
+// probe looks cold (uncached, slow disk or network filesystem) sends the rest
+// to the ring, where they run in parallel.
+constexpr size_t kRingProbePaths = 8;
+constexpr auto kColdStatThreshold = std::chrono::microseconds(20);
+constexpr unsigned kRingEntries = 64;
+
+bool RingDisabledByEnv() {
+  const char* value = std::getenv("TALEX_EVERYTHING_STAT_IO_URING");
+  return value != nullptr && std::strcmp(value, "0") == 0;
+}
+
+// A minimal io_uring driven through the raw syscalls (liburing is not a
+// dependency): one submission and one completion ring, and a fixed set of
+// statx buffers so no more than kRingEntries requests are in flight. Owned
+// by one thread.
+class StatxRing {
+ public:
+  // Null when the kernel or a seccomp filter refuses io_uring or the kernel
+  // cannot do STATX through it.
+  static StatxRing* ForThisThread() {
+    thread_local bool attempted = false;
+    thread_local StatxRing* ring = nullptr;
+    if (!attempted) {
+      attempted = true;
+      if (!RingDisabledByEnv()) {
+        auto candidate = std::unique_ptr<StatxRing>(new StatxRing());
+        if (candidate->Setup()) {
+          // Thread lifetime; the stat thread never exits.
+          ring = candidate.release();
+        }
+      }
+    }
+    return ring != nullptr && !ring->broken_ ? ring : nullptr;
+  }
+
+  ~StatxRing() {
+    if (sqes_ != nullptr) {
+      ::munmap(sqes_, sqesBytes_);
+    }
+    if (cqRing_ != nullptr && cqRing_ != sqRing_) {
+      ::munmap(cqRing_, cqRingBytes_);
+    }
+    if (sqRing_ != nullptr) {
+      ::munmap(sqRing_, sqRingBytes_);
+    }
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+  }
+
+  // Resolves every path it can and marks it in `resolved`. Returns false if
+  // the ring failed part way; the caller resolves the rest synchronously.
+  bool Resolve(const std::vector<std::string>& paths, size_t begin, bool noFollow,
+               Columns& columns, std::vector<uint8_t>& resolved) {
+    size_t next = begin;
+    unsigned unsubmitted = 0;
+    unsigned inFlight = 0;
+
+    while (next < paths.size() || inFlight > 0) {
+      unsigned tail = *sqTail_;
+      while (next < paths.size() && !freeSlots_.empty()) {
+        const unsigned slot = freeSlots_.back();
+        freeSlots_.pop_back();
+        slotIndex_[slot] = next;
+
+        const unsigned position = tail & *sqMask_;
+        auto& sqe = sqes_[position];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_STATX;
+        sqe.fd = AT_FDCWD;
+        sqe.addr = reinterpret_cast<uint64_t>(paths[next].c_str());
+        sqe.len = kStatxMask;
+        sqe.off = reinterpret_cast<uint64_t>(&buffers_[slot]);
+        sqe.statx_flags = noFollow ? AT_SYMLINK_NOFOLLOW : 0;
+        sqe.user_data = slot;
+        sqArray_[position] = position;
+
+        ++tail;
+        ++next;
+        ++unsubmitted;
+        ++inFlight;
+      }
+      __atomic_store_n(sqTail_, tail, __ATOMIC_RELEASE);
+
+      const int submitted = Enter(unsubmitted, 1, IORING_ENTER_GETEVENTS);
+      if (submitted < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+        return Abandon(columns, resolved, inFlight - unsubmitted);
+      }
+      if (submitted > 0) {
+        unsubmitted -= static_cast<unsigned>(submitted);
+      }
+
+      inFlight -= Reap(columns, resolved);
+    }
+    return true;
+  }
+
+ private:
+  StatxRing() = default;
+
+  int Enter(unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return static_cast<int>(
+        ::syscall(__NR_io_uring_enter, fd_, toSubmit, minComplete, flags, nullptr, 0));
+  }
+
+  unsigned Reap(Columns& columns, std::vector<uint8_t>& resolved) {
+    unsigned head = *cqHead_;
+    const unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+    unsigned reaped = 0;
+    while (head != tail) {
+      const auto& cqe = cqes_[head & *cqMask_];
+      const auto slot = static_cast<unsigned>(cqe.user_data);
+      const size_t index = slotIndex_[slot];
+      if (cqe.res == 0) {
+        StoreStatx(buffers_[slot], columns, index);
+      } else {
+        columns.SetError(index, -cqe.res);
+      }
+      resolved[index] = 1;
+      freeSlots_.push_back(slot);
+      ++head;
+      ++reaped;
+    }
+    __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+    return reaped;
+  }
+
+  // The kernel still owns the buffers of requests it accepted; wait them out
+  // so their results land, or leave the ring mapped for good if even that
+  // fails. Either way the ring is not used again.
+  bool Abandon(Columns& columns, std::vector<uint8_t>& resolved, unsigned submittedInFlight) {
+    broken_ = true;
+    while (submittedInFlight > 0) {
+      if (Enter(0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+        break;
+      }
+      const unsigned reaped = Reap(columns, resolved);
+      submittedInFlight -= std::min(reaped, submittedInFlight);
+    }
+    return false;
+  }
+
+  bool Setup() {
+    io_uring_params params{};
+    fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, kRingEntries, &params));
+    if (fd_ < 0) {
+      return false;
+    }
+
+    const size_t probeBytes = sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op);
+    std::vector<uint8_t> probeStorage(probeBytes, 0);
+    auto* probe = reinterpret_cast<io_uring_probe*>(probeStorage.data());
+    if (::syscall(__NR_io_uring_register, fd_, IORING_REGISTER_PROBE, probe, 256) < 0 ||
+        probe->last_op < IORING_OP_STATX ||
+        !(probe->ops[IORING_OP_STATX].flags & IO_URING_OP_SUPPORTED)) {
+      return false;
+    }
+
+    sqRingBytes_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingBytes_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMmap) {
+      sqRingBytes_ = cqRingBytes_ = std::max(sqRingBytes_, cqRingBytes_);
+    }
+
+    sqRing_ = MapRing(sqRingBytes_, IORING_OFF_SQ_RING);
+    if (sqRing_ == nullptr) {
+      return false;
+    }
+    cqRing_ = singleMmap ? sqRing_ : MapRing(cqRingBytes_, IORING_OFF_CQ_RING);
+    sqesBytes_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = static_cast<io_uring_sqe*>(MapRing(sqesBytes_, IORING_OFF_SQES));
+    if (cqRing_ == nullptr || sqes_ == nullptr) {
+      return false;
+    }
+
+    auto* sq = static_cast<uint8_t*>(sqRing_);
+    sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sqMask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    auto* cq = static_cast<uint8_t*>(cqRing_);
+    cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqMask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    buffers_.resize(params.sq_entries);
+    slotIndex_.resize(params.sq_entries);
+    for (unsigned slot = params.sq_entries; slot > 0; --slot) {
+      freeSlots_.push_back(slot - 1);
+    }
+    return true;
+  }
+
+  void* MapRing(size_t bytes, off_t offset) {
+    void* mapped = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                          offset);
+    return mapped == MAP_FAILED ? nullptr : mapped;
+  }
+
+  int fd_ = -1;
+  bool broken_ = false;
+  void* sqRing_ = nullptr;
+  void* cqRing_ = nullptr;
+  size_t sqRingBytes_ = 0;
+  size_t cqRingBytes_ = 0;
+  io_uring_sqe* sqes_ = nullptr;
+  size_t sqesBytes_ = 0;
+  unsigned* sqTail_ = nullptr;
+  unsigned* sqMask_ = nullptr;
+  unsigned* sqArray_ = nullptr;
+  unsigned* cqHead_ = nullptr;
+  unsigned* cqTail_ = nullptr;
+  unsigned* cqMask_ = nullptr;
+  io_uring_cqe* cqes_ = nullptr;
+  std::vector<struct statx> buffers_;
+  std::vector<size_t> slotIndex_;
+  std::vector<unsigned> freeSlots_;
+};
+
+#endif
+
+}  // namespace
+
+StatBatchExecutor& StatBatchExecutor::Instance() {
+  // Leaked like the search executor; its thread lives until process exit.
+  static auto* executor = new StatBatchExecutor();
+  return *executor;
+}
+
+StatBatchResult StatBatchExecutor::Resolve(const std::vector<std::string>& paths, bool noFollow) {
+  StatBatchResult result;
+  Columns columns(result, paths.size());
+  result.engine = kSyncEngine;
+
+  size_t begin = 0;
+  std::vector<uint8_t> resolved;
+#if TUFF_STAT_IO_URING
+  if (paths.size() > kRingProbePaths * 2) {
+    const auto probeStart = std::chrono::steady_clock::now();
+    for (; begin < kRingProbePaths; ++begin) {
+      ResolveOne(paths[begin], noFollow, columns, begin);
+    }
+    const auto probeTime = std::chrono::steady_clock::now() - probeStart;
+
+    StatxRing* ring = nullptr;
+    if (probeTime > kColdStatThreshold * kRingProbePaths &&
+        !StatxMissing().load(std::memory_order_relaxed) &&
+        (ring = StatxRing::ForThisThread()) != nullptr) {
+      resolved.assign(paths.size(), 0);
+      if (ring->Resolve(paths, begin, noFollow, columns, resolved)) {
+        result.engine = "io_uring";
+        return result;
+      }
+    }
+  }
+#endif
+
+  for (size_t index = begin; index < paths.size(); ++index) {
+    if (resolved.empty() || resolved[index] == 0) {
+      ResolveOne(paths[index], noFollow, columns, index);
+    }
+  }
+  return result;
+}
+
+void StatBatchExecutor::Submit(StatBatchJob job) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.push_back(std::move(job));
+    if (!started_) {
+      std::thread([this] { Run(); }).detach();
+      started_ = true;
+    }
+  }
+  wake_.notify_one();
+}
+
+void StatBatchExecutor::Run() {
+  while (true) {
+    StatBatchJob job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [this] { return !queue_.empty(); });
+      job = std::move(queue_.front());
+      queue_.pop_front();
+    }
+
+    job.complete(Resolve(job.paths, job.noFollow));
+  }
+}
+
+}  // namespace tuff::native::everything
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace tuff::native::everything {
+
+// Per-path flags in the packed result. A path that could not be stat'ed has
+// none of them and its errno column says why.
+constexpr uint8_t kStatExists = 1U << 0;
+constexpr uint8_t kStatDirectory = 1U << 1;
+constexpr uint8_t kStatFile = 1U << 2;
+constexpr uint8_t kStatSymlink = 1U << 3;
+
+// Metadata of `count` paths as one block, in input order, so JS can wrap each
+// column in a typed array without any per-path object:
+//
+//   f64 size[count]
+//   f64 mtimeMs[count]
+//   f64 ctimeMs[count]       status change time, as fs.Stats#ctimeMs
+//   f64 birthtimeMs[count]   0 where the filesystem does not record it
+//   i32 errno[count]         0 on success
+//   u8  flags[count]         kStat*
+//
+// Every column starts at a multiple of its element size.
+struct StatBatchResult {
+  size_t count = 0;
+  std::vector<uint8_t> packed;
+  // How the batch was resolved: "io_uring", "statx", "stat" or "win32".
+  const char* engine = "";
+};
+
+struct StatBatchLayout {
+  static size_t SizeOffset(size_t) { return 0; }
+  static size_t MtimeOffset(size_t count) { return count * 8; }
+  static size_t CtimeOffset(size_t count) { return count * 16; }
+  static size_t BirthtimeOffset(size_t count) { return count * 24; }
+  static size_t ErrnoOffset(size_t count) { return count * 32; }
+  static size_t FlagsOffset(size_t count) { return count * 36; }
+  static size_t ByteLength(size_t count) { return count * 37; }
+};
+
+struct StatBatchJob {
+  std::vector<std::string> paths;
+  // Follow the last symlink (fs.stat) unless set (fs.lstat).
+  bool noFollow = false;
+  // Called once from the stat thread.
+  std::function<void(StatBatchResult&&)> complete;
+};
+
+// Resolves path metadata on one dedicated thread, so enriching a page of
+// search results is a single hop instead of one libuv threadpool round trip
+// per path, and file search no longer competes with fs, crypto and zlib work
+// for the four pool threads.
+//
+// On Linux the paths are stat'ed with statx(2). When the first few of a batch
+// show the metadata is cold (not in the dentry cache, a slow disk or a network
+// filesystem), the rest go to the kernel as IORING_OP_STATX requests on a
+// private io_uring and resolve in parallel, so the batch takes roughly as
+// long as its slowest path. Kernels without io_uring or its STATX opcode and
+// sandboxes that forbid io_uring_setup stay on the statx loop. Other
+// platforms use stat(2) or GetFileAttributesExW.
+class StatBatchExecutor {
+ public:
+  static StatBatchExecutor& Instance();
+
+  void Submit(StatBatchJob job);
+
+  // Resolves a batch on the calling thread; what the stat thread runs for
+  // each job.
+  static StatBatchResult Resolve(const std::vector<std::string>& paths, bool noFollow);
+
+ private:
+  StatBatchExecutor() = default;
+
+  void Run();
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::deque<StatBatchJob> queue_;
+  bool started_ = false;
+};
+
+}  // namespace tuff::native::everything
@@ -0,0 +1,595 @@
+#include "everything/tree_scanner.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <cwchar>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+#if defined(_WIN32)
+#include "common/utf_transcode.h"
+#include "everything/everything_sdk.h"
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include "everything/stat_at.h"
+
+#include <sys/syscall.h>
+#endif
+
+namespace tuff::native::everything {
+
+namespace {
+
+// getdents64 fills this per call; big enough that most directories take one
+// syscall plus the one that returns 0.
+constexpr size_t kDirentBufferSize = 64 * 1024;
+
+// Upper bound on how long an idle thread sleeps before looking for work to
+// steal again; pushes wake it sooner.
+constexpr auto kIdleWait = std::chrono::milliseconds(2);
+
+#if defined(_WIN32)
+constexpr char kSeparator = '\\';
+constexpr const char* kSeparators = "\\/";
+#else
+constexpr char kSeparator = '/';
+constexpr const char* kSeparators = "/";
+#endif
+
+int64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+std::string Fold(std::string_view value) {
+  std::string folded(value);
+  for (auto& c : folded) {
+    if (c >= 'A' && c <= 'Z') {
+      c = static_cast<char>(c - 'A' + 'a');
+    }
+  }
+  return folded;
+}
+
+bool EndsWith(std::string_view value, std::string_view suffix) {
+  return value.size() >= suffix.size() &&
+      value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// "/" on POSIX, "C:\" (or "C:/") on Windows.
+bool IsFilesystemRoot(std::string_view path) {
+  if (path == "/") {
+    return true;
+  }
+  return path.size() == 3 && path[1] == ':' && (path[2] == '\\' || path[2] == '/');
+}
+
+// "/a/b" -> ("/a", "b"), "/a" -> ("/", "a"), "C:\\a" -> ("C:\\", "a"),
+// "/" -> ("/", "").
+void SplitPath(const std::string& path, std::string_view& parent, std::string_view& name) {
+  const std::string_view view(path);
+  if (IsFilesystemRoot(view)) {
+    parent = view;
+    name = std::string_view();
+    return;
+  }
+  const auto slash = path.find_last_of(kSeparators);
+  if (slash == std::string::npos) {
+    parent = std::string_view();
+    name = view;
+    return;
+  }
+  const bool keepSeparator = slash == 0 || (slash == 2 && path[1] == ':');
+  parent = view.substr(0, keepSeparator ? slash + 1 : slash);
+  name = view.substr(slash + 1);
+}
+
+std::string JoinPath(const std::string& directory, std::string_view name) {
+  std::string path;
+  path.reserve(directory.size() + 1 + name.size());
+  path.append(directory);
+  if (path.empty() || (path.back() != '/' && path.back() != kSeparator)) {
+    path.push_back(kSeparator);
+  }
+  path.append(name);
+  return path;
+}
+
+bool IsExcludedDirectory(const TreeScanFilter& filter, std::string_view parent,
+                         std::string_view name, const std::string& path) {
+  if (filter.excludePaths.count(path) != 0) {
+    return true;
+  }
+  if (name.empty()) {
+    return false;
+  }
+  if (filter.skipHidden && name.front() == '.') {
+    return true;
+  }
+  if (!filter.excludeNames.empty() && filter.excludeNames.count(std::string(name)) != 0) {
+    return true;
+  }
+
+  const auto folded = Fold(name);
+  if (filter.excludeFoldedNames.count(folded) != 0) {
+    return true;
+  }
+  for (const auto& suffix : filter.excludeFoldedSuffixes) {
+    if (EndsWith(folded, suffix)) {
+      return true;
+    }
+  }
+  return !filter.rootExcludeFoldedNames.empty() && IsFilesystemRoot(parent) &&
+      filter.rootExcludeFoldedNames.count(folded) != 0;
+}
+
+bool IsExcludedFile(const TreeScanFilter& filter, std::string_view name) {
+  if (name.empty()) {
+    return true;
+  }
+  if (filter.excludeFilePrefixes.find(name.front()) != std::string::npos) {
+    return true;
+  }
+
+  // Same rule as path.extname: a leading dot does not start an extension.
+  const auto dot = name.rfind('.');
+  if (dot == std::string_view::npos || dot == 0) {
+    return filter.requireExtension;
+  }
+  return !filter.excludeExtensions.empty() &&
+      filter.excludeExtensions.count(Fold(name.substr(dot))) != 0;
+}
+
+bool IsDotEntry(const char* name) {
+  return name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+}
+
+#if defined(_WIN32)
+
+constexpr uint64_t kWindowsEpochOffset100Ns = 116444736000000000ULL;
+
+double FileTimeToMillis(const FILETIME& fileTime) {
+  const uint64_t value =
+      (static_cast<uint64_t>(fileTime.dwHighDateTime) << 32) | fileTime.dwLowDateTime;
+  if (value < kWindowsEpochOffset100Ns) {
+    return 0;
+  }
+  return static_cast<double>(value - kWindowsEpochOffset100Ns) / 10000.0;
+}
+
+#else
+
+struct EntryStat {
+  bool ok = false;
+  bool isDirectory = false;
+  bool isFile = false;
+  double size = 0;
+  double mtimeMs = 0;
+  double ctimeMs = 0;
+};
+
+#if defined(__linux__)
+
+double ToMillis(const struct statx_timestamp& value) {
+  return static_cast<double>(value.tv_sec) * 1000.0 + static_cast<double>(value.tv_nsec) / 1e6;
+}
+
+EntryStat StatEntry(int dirFd, const char* name) {
+  EntryStat result;
+  struct statx info {};
+  if (!StatAt(dirFd, name, AT_SYMLINK_NOFOLLOW,
+              STATX_TYPE | STATX_SIZE | STATX_MTIME | STATX_CTIME | STATX_BTIME, info)) {
+    return result;
+  }
+  result.ok = true;
+  result.isDirectory = S_ISDIR(info.stx_mode);
+  result.isFile = S_ISREG(info.stx_mode);
+  result.size = static_cast<double>(info.stx_size);
+  result.mtimeMs = ToMillis(info.stx_mtime);
+  result.ctimeMs = ToMillis((info.stx_mask & STATX_BTIME) ? info.stx_btime : info.stx_ctime);
+  return result;
+}
+
+// The record getdents64(2) fills the buffer with; glibc only declares it
+// since 2.30.
+struct LinuxDirent64 {
+  uint64_t d_ino;
+  int64_t d_off;
+  unsigned short d_reclen;
+  unsigned char d_type;
+  char d_name[1];
+};
+
+#else
+
+double ToMillis(const struct timespec& value) {
+  return static_cast<double>(value.tv_sec) * 1000.0 + static_cast<double>(value.tv_nsec) / 1e6;
+}
+
+EntryStat StatEntry(int dirFd, const char* name) {
+  EntryStat result;
+  struct stat info {};
+  if (::fstatat(dirFd, name, &info, AT_SYMLINK_NOFOLLOW) != 0) {
+    return result;
+  }
+  result.ok = true;
+  result.isDirectory = S_ISDIR(info.st_mode);
+  result.isFile = S_ISREG(info.st_mode);
+  result.size = static_cast<double>(info.st_size);
+#if defined(__APPLE__)
+  result.mtimeMs = ToMillis(info.st_mtimespec);
+  result.ctimeMs = ToMillis(info.st_birthtimespec);
+#else
+  result.mtimeMs = ToMillis(info.st_mtim);
+  result.ctimeMs = ToMillis(info.st_ctim);
+#endif
+  return result;
+}
+
+#endif
+
+#endif
+
+}  // namespace
+
+struct TreeScan::Worker {
+  std::mutex mutex;
+  std::deque<Task> tasks;
+
+  // The batch being filled, column by column.
+  std::vector<std::string> paths;
+  std::vector<double> sizes;
+  std::vector<double> mtimes;
+  std::vector<double> ctimes;
+  std::vector<uint8_t> types;
+
+#if defined(__linux__)
+  std::unique_ptr<char[]> dirents{new char[kDirentBufferSize]};
+#endif
+};
+
+TreeScan::TreeScan(TreeScanOptions options, BatchSink onBatch, DoneSink onDone)
+    : options_(std::move(options)), onBatch_(std::move(onBatch)), onDone_(std::move(onDone)) {
+  options_.batchSize = std::max<uint32_t>(options_.batchSize, 1);
+  credits_ = std::max<uint32_t>(options_.maxPendingBatches, 1);
+
+  auto& filter = options_.filter;
+  auto foldSet = [](std::unordered_set<std::string>& values) {
+    std::unordered_set<std::string> folded;
+    for (const auto& value : values) {
+      folded.insert(Fold(value));
+    }
+    values.swap(folded);
+  };
+  foldSet(filter.excludeFoldedNames);
+  foldSet(filter.rootExcludeFoldedNames);
+  foldSet(filter.excludeExtensions);
+  for (auto& suffix : filter.excludeFoldedSuffixes) {
+    suffix = Fold(suffix);
+  }
+}
+
+TreeScan::~TreeScan() = default;
+
+std::shared_ptr<TreeScan> TreeScan::Start(TreeScanOptions options, BatchSink onBatch,
+                                          DoneSink onDone) {
+  std::shared_ptr<TreeScan> scan(new TreeScan(std::move(options), std::move(onBatch),
+                                              std::move(onDone)));
+  auto threads = scan->options_.threads;
+  if (threads == 0) {
+    threads = std::max(1U, std::thread::hardware_concurrency());
+  }
+  threads = std::clamp<uint32_t>(threads, 1, kMaxScanThreads);
+
+  for (uint32_t i = 0; i < threads; ++i) {
+    scan->workers_.push_back(std::make_unique<Worker>());
+  }
+
+  // Roots are dealt out round-robin; stealing evens out the rest.
+  size_t next = 0;
+  for (auto root : scan->options_.roots) {
+    while (root.size() > 1 && (root.back() == '/' || root.back() == kSeparator) &&
+           !IsFilesystemRoot(root)) {
+      root.pop_back();
+    }
+    std::string_view parent;
+    std::string_view name;
+    SplitPath(root, parent, name);
+    if (root.empty() || IsExcludedDirectory(scan->options_.filter, parent, name, root)) {
+      continue;
+    }
+    scan->outstanding_.fetch_add(1);
+    scan->workers_[next % threads]->tasks.push_back(Task{root, 0});
+    ++next;
+  }
+
+  scan->startedAtNs_ = NowNs();
+  scan->running_.store(threads);
+  for (uint32_t i = 0; i < threads; ++i) {
+    std::thread([scan, i]() { scan->Run(i); }).detach();
+  }
+  return scan;
+}
+
+void TreeScan::Acknowledge() {
+  {
+    std::lock_guard<std::mutex> lock(creditMutex_);
+    ++credits_;
+  }
+  creditAvailable_.notify_one();
+}
+
+void TreeScan::Cancel() {
+  cancelled_.store(true);
+  {
+    std::lock_guard<std::mutex> lock(creditMutex_);
+  }
+  creditAvailable_.notify_all();
+  {
+    std::lock_guard<std::mutex> lock(idleMutex_);
+  }
+  idle_.notify_all();
+}
+
+void TreeScan::Run(size_t index) {
+  auto& worker = *workers_[index];
+  Task task;
+  while (NextTask(index, task)) {
+    if (!cancelled_.load(std::memory_order_relaxed)) {
+      ReadDirectory(index, task);
+    }
+    if (outstanding_.fetch_sub(1) == 1) {
+      std::lock_guard<std::mutex> lock(idleMutex_);
+      idle_.notify_all();
+    }
+  }
+
+  if (!worker.paths.empty()) {
+    Emit(worker);
+  }
+  if (running_.fetch_sub(1) == 1) {
+    Finish();
+  }
+}
+
+bool TreeScan::NextTask(size_t index, Task& task) {
+  const size_t count = workers_.size();
+  for (;;) {
+    {
+      auto& own = *workers_[index];
+      std::lock_guard<std::mutex> lock(own.mutex);
+      if (!own.tasks.empty()) {
+        task = std::move(own.tasks.back());
+        own.tasks.pop_back();
+        return true;
+      }
+    }
+    for (size_t offset = 1; offset < count; ++offset) {
+      auto& victim = *workers_[(index + offset) % count];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if (!victim.tasks.empty()) {
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        return true;
+      }
+    }
+
+    std::unique_lock<std::mutex> lock(idleMutex_);
+    if (outstanding_.load() == 0) {
+      return false;
+    }
+    ++sleepers_;
+    idle_.wait_for(lock, kIdleWait);
+    --sleepers_;
+  }
+}
+
+void TreeScan::Push(size_t index, Task task) {
+  outstanding_.fetch_add(1);
+  {
+    auto& own = *workers_[index];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    own.tasks.push_back(std::move(task));
+  }
+  std::lock_guard<std::mutex> lock(idleMutex_);
+  if (sleepers_ > 0) {
+    idle_.notify_one();
+  }
+}
+
+void TreeScan::ReadDirectory(size_t index, const Task& task) {
+  auto& worker = *workers_[index];
+  const auto& filter = options_.filter;
+  const bool descend = task.depth < filter.maxDepth;
+
+  auto addEntry = [&](std::string path, double size, double mtimeMs, double ctimeMs,
+                      uint8_t type) {
+    worker.paths.push_back(std::move(path));
+    worker.sizes.push_back(size);
+    worker.mtimes.push_back(mtimeMs);
+    worker.ctimes.push_back(ctimeMs);
+    worker.types.push_back(type);
+    entryCount_.fetch_add(1, std::memory_order_relaxed);
+    if (worker.paths.size() >= options_.batchSize) {
+      Emit(worker);
+    }
+  };
+
+  // Queues the subdirectory `childPath` (and reports it when asked to)
+  // unless the filter prunes it.
+  auto visitDirectory = [&](std::string_view name, std::string childPath, double mtimeMs,
+                            double ctimeMs) {
+    if (IsExcludedDirectory(filter, task.path, name, childPath)) {
+      return;
+    }
+    if (options_.includeDirectories) {
+      addEntry(childPath, 0, mtimeMs, ctimeMs, kScanDirectory);
+    }
+    if (descend) {
+      Push(index, Task{std::move(childPath), task.depth + 1});
+    }
+  };
+
+#if defined(_WIN32)
+  WIN32_FIND_DATAW data{};
+  const auto pattern = Utf8ToWide(JoinPath(task.path, "*"));
+  HANDLE find = ::FindFirstFileExW(pattern.c_str(), FindExInfoBasic, &data, FindExSearchNameMatch,
+                                   nullptr, FIND_FIRST_EX_LARGE_FETCH);
+  if (find == INVALID_HANDLE_VALUE) {
+    errorCount_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  directoryCount_.fetch_add(1, std::memory_order_relaxed);
+
+  do {
+    if (cancelled_.load(std::memory_order_relaxed)) {
+      break;
+    }
+    const wchar_t* wide = data.cFileName;
+    if (wide[0] == L'.' && (wide[1] == L'\0' || (wide[1] == L'.' && wide[2] == L'\0'))) {
+      continue;
+    }
+    // Symlinks and junctions; neither followed nor reported.
+    if (data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) {
+      continue;
+    }
+
+    const auto name = WideToUtf8(wide, std::wcslen(wide));
+    const double mtimeMs = FileTimeToMillis(data.ftLastWriteTime);
+    const double ctimeMs = FileTimeToMillis(data.ftCreationTime);
+    if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+      visitDirectory(name, JoinPath(task.path, name), mtimeMs, ctimeMs);
+      continue;
+    }
+    if (IsExcludedFile(filter, name)) {
+      continue;
+    }
+    const uint64_t size = (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+    addEntry(JoinPath(task.path, name), static_cast<double>(size), mtimeMs, ctimeMs, kScanFile);
+  } while (::FindNextFileW(find, &data));
+  ::FindClose(find);
+#else
+  const int fd = ::open(task.path.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+  if (fd < 0) {
+    errorCount_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  directoryCount_.fetch_add(1, std::memory_order_relaxed);
+
+  // d_type is DT_UNKNOWN on filesystems that do not store it; the stat that
+  // follows settles those.
+  auto visitEntry = [&](const char* name, unsigned char type) {
+    if (type != DT_UNKNOWN && type != DT_DIR && type != DT_REG) {
+      return;
+    }
+    const std::string_view view(name);
+    if (type == DT_REG && IsExcludedFile(filter, view)) {
+      return;
+    }
+    if (type == DT_DIR && !options_.includeDirectories) {
+      visitDirectory(view, JoinPath(task.path, view), 0, 0);
+      return;
+    }
+
+    const auto info = StatEntry(fd, name);
+    if (!info.ok) {
+      errorCount_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    if (info.isDirectory) {
+      visitDirectory(view, JoinPath(task.path, view), info.mtimeMs, info.ctimeMs);
+    } else if (info.isFile && (type == DT_REG || !IsExcludedFile(filter, view))) {
+      addEntry(JoinPath(task.path, view), info.size, info.mtimeMs, info.ctimeMs, kScanFile);
+    }
+  };
+
+#if defined(__linux__)
+  char* buffer = worker.dirents.get();
+  for (;;) {
+    const long read = ::syscall(SYS_getdents64, fd, buffer, kDirentBufferSize);
+    if (read < 0) {
+      errorCount_.fetch_add(1, std::memory_order_relaxed);
+      break;
+    }
+    if (read == 0 || cancelled_.load(std::memory_order_relaxed)) {
+      break;
+    }
+    for (long offset = 0; offset < read;) {
+      const auto* entry = reinterpret_cast<const LinuxDirent64*>(buffer + offset);
+      offset += entry->d_reclen;
+      if (!IsDotEntry(entry->d_name)) {
+        visitEntry(entry->d_name, entry->d_type);
+      }
+    }
+  }
+  ::close(fd);
+#else
+  DIR* dir = ::fdopendir(fd);
+  if (dir == nullptr) {
+    errorCount_.fetch_add(1, std::memory_order_relaxed);
+    ::close(fd);
+    return;
+  }
+  while (const dirent* item = ::readdir(dir)) {
+    if (cancelled_.load(std::memory_order_relaxed)) {
+      break;
+    }
+    if (!IsDotEntry(item->d_name)) {
+      visitEntry(item->d_name, item->d_type);
+    }
+  }
+  ::closedir(dir);
+#endif
+#endif
+}
+
+void TreeScan::Emit(Worker& worker) {
+  const size_t count = worker.paths.size();
+  TreeScanBatch batch;
+  batch.paths = std::move(worker.paths);
+  batch.packed.resize(TreeScanLayout::ByteLength(count));
+  auto* base = batch.packed.data();
+  std::memcpy(base + TreeScanLayout::SizeOffset(count), worker.sizes.data(), count * 8);
+  std::memcpy(base + TreeScanLayout::MtimeOffset(count), worker.mtimes.data(), count * 8);
+  std::memcpy(base + TreeScanLayout::CtimeOffset(count), worker.ctimes.data(), count * 8);
+  std::memcpy(base + TreeScanLayout::TypeOffset(count), worker.types.data(), count);
+
+  worker.paths.clear();
+  worker.sizes.clear();
+  worker.mtimes.clear();
+  worker.ctimes.clear();
+  worker.types.clear();
+
+  {
+    std::unique_lock<std::mutex> lock(creditMutex_);
+    creditAvailable_.wait(lock, [this]() { return credits_ > 0 || cancelled_.load(); });
+    if (cancelled_.load()) {
+      return;
+    }
+    --credits_;
+  }
+  onBatch_(std::move(batch));
+}
+
+void TreeScan::Finish() {
+  TreeScanSummary summary;
+  summary.entryCount = entryCount_.load();
+  summary.directoryCount = directoryCount_.load();
+  summary.errorCount = errorCount_.load();
+  summary.threads = static_cast<uint32_t>(workers_.size());
+  summary.cancelled = cancelled_.load();
+  summary.durationMs = static_cast<double>(NowNs() - startedAtNs_) / 1e6;
+  onDone_(summary);
+}
+
+}  // namespace tuff::native::everything
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace tuff::native::everything {
+
+// Entry kinds in a TreeScanBatch.
+constexpr uint8_t kScanFile = 1;
+constexpr uint8_t kScanDirectory = 2;
+
+// Exclusions applied while walking, so pruned subtrees are never read. They
+// are plain data (names, suffixes, paths) handed over by the caller; anything
+// richer, such as path patterns, stays with the caller, which filters the
+// batches it receives.
+struct TreeScanFilter {
+  // Absolute paths skipped along with everything below them.
+  std::unordered_set<std::string> excludePaths;
+  // Directory names, compared as is.
+  std::unordered_set<std::string> excludeNames;
+  // Directory names and name suffixes, compared after ASCII lower-casing
+  // (both sides; the scan folds these when it starts).
+  std::unordered_set<std::string> excludeFoldedNames;
+  std::vector<std::string> excludeFoldedSuffixes;
+  // Like excludeFoldedNames, but only for directories directly below a
+  // filesystem root ("/usr", "C:\Windows").
+  std::unordered_set<std::string> rootExcludeFoldedNames;
+  // Skip directories whose name starts with '.'.
+  bool skipHidden = true;
+  // Directories deeper than this below their root are not read.
+  uint32_t maxDepth = 24;
+
+  // Files without an extension ("Makefile", ".bashrc") are not reported.
+  bool requireExtension = false;
+  // Extensions, with the dot, of files not reported; compared like
+  // excludeFoldedNames.
+  std::unordered_set<std::string> excludeExtensions;
+  // First characters of file names not reported ("~lock.docx").
+  std::string excludeFilePrefixes;
+};
+
+struct TreeScanOptions {
+  std::vector<std::string> roots;
+  TreeScanFilter filter;
+  // Report directories as entries too, not only walk them.
+  bool includeDirectories = false;
+  uint32_t batchSize = 500;
+  // 0 picks one thread per core, up to kMaxScanThreads.
+  uint32_t threads = 0;
+  // Batches handed to the sink and not yet acknowledged; the walkers wait
+  // once this many are outstanding, which bounds memory when the consumer is
+  // slower than the disk.
+  uint32_t maxPendingBatches = 4;
+};
+
+// Entries of one batch; `packed` holds the numeric columns, laid out like
+// StatBatchResult:
+//
+//   f64 size[count]
+//   f64 mtimeMs[count]
+//   f64 ctimeMs[count]   birth time where the filesystem records it, the
+//                        status change time otherwise
+//   u8  type[count]      kScanFile | kScanDirectory
+struct TreeScanBatch {
+  std::vector<std::string> paths;
+  std::vector<uint8_t> packed;
+};
+
+struct TreeScanLayout {
+  static size_t SizeOffset(size_t) { return 0; }
+  static size_t MtimeOffset(size_t count) { return count * 8; }
+  static size_t CtimeOffset(size_t count) { return count * 16; }
+  static size_t TypeOffset(size_t count) { return count * 24; }
+  static size_t ByteLength(size_t count) { return count * 25; }
+};
+
+struct TreeScanSummary {
+  uint64_t entryCount = 0;
+  uint64_t directoryCount = 0;
+  // Directories that could not be read plus entries that could not be
+  // stat'ed. Non-zero means the scan did not see everything, which callers
+  // must not mistake for files having been deleted.
+  uint64_t errorCount = 0;
+  uint32_t threads = 0;
+  bool cancelled = false;
+  double durationMs = 0;
+};
+
+// Walks directory trees on a small pool of threads and streams what it finds
+// in batches.
+//
+// Each thread owns a deque of directories still to read: it pushes the
+// subdirectories it finds to the back and pops from the back, so it walks
+// depth-first with a warm dentry cache, and an idle thread steals from the
+// front of another's deque, which is where the largest unexplored subtrees
+// sit. One wide or deep subtree therefore cannot leave the other threads
+// idle. Directories are read with getdents64(2) into a large buffer on Linux
+// (readdir elsewhere) and entries are stat'ed relative to the directory's
+// descriptor; on Windows, FindFirstFileExW returns the metadata with the
+// names, so there is no per-entry call at all.
+//
+// Symlinks and junctions are neither followed nor reported, matching
+// Dirent#isFile()/isDirectory().
+class TreeScan : public std::enable_shared_from_this<TreeScan> {
+ public:
+  static constexpr uint32_t kMaxScanThreads = 8;
+
+  // Both are called on scan threads. `onBatch` may be called from several
+  // threads at once; `onDone` is called exactly once, after the last batch.
+  using BatchSink = std::function<void(TreeScanBatch&& batch)>;
+  using DoneSink = std::function<void(const TreeScanSummary& summary)>;
+
+  static std::shared_ptr<TreeScan> Start(TreeScanOptions options, BatchSink onBatch,
+                                         DoneSink onDone);
+
+  // Returns one delivery credit; see TreeScanOptions::maxPendingBatches.
+  void Acknowledge();
+
+  // Stops the walk at the next entry. Batches already handed over stay
+  // handed over; onDone still runs, with `cancelled` set.
+  void Cancel();
+
+  ~TreeScan();
+
+ private:
+  struct Task {
+    std::string path;
+    uint32_t depth = 0;
+  };
+  struct Worker;
+
+  TreeScan(TreeScanOptions options, BatchSink onBatch, DoneSink onDone);
+
+  void Run(size_t index);
+  bool NextTask(size_t index, Task& task);
+  void Push(size_t index, Task task);
+  void ReadDirectory(size_t index, const Task& task);
+  void Emit(Worker& worker);
+  void Finish();
+
+  TreeScanOptions options_;
+  BatchSink onBatch_;
+  DoneSink onDone_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  // Directories queued or being read; the scan is over when it drops to 0.
+  std::atomic<int64_t> outstanding_{0};
+  std::atomic<bool> cancelled_{false};
+  std::atomic<uint64_t> entryCount_{0};
+  std::atomic<uint64_t> directoryCount_{0};
+  std::atomic<uint64_t> errorCount_{0};
+  std::atomic<size_t> running_{0};
+
+  std::mutex idleMutex_;
+  std::condition_variable idle_;
+  size_t sleepers_ = 0;
+
+  std::mutex creditMutex_;
+  std::condition_variable creditAvailable_;
+  uint32_t credits_ = 0;
+
+  int64_t startedAtNs_ = 0;
+};
+
+}  // namespace tuff::native::everything
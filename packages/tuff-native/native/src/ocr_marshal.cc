@@ -0,0 +1,523 @@
+#include "ocr_marshal.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "common/js_string.h"
+#include "common/ocr_input.h"
+#include "common/ocr_layout.h"
+
+namespace tuff::native {
+
+namespace {
+
+Napi::Array ToJsBox(Napi::Env env, const std::array<double, 4> &box) {
+  auto output = Napi::Array::New(env, 4);
+  output.Set(uint32_t{0}, Napi::Number::New(env, box[0]));
+  output.Set(uint32_t{1}, Napi::Number::New(env, box[1]));
+  output.Set(uint32_t{2}, Napi::Number::New(env, box[2]));
+  output.Set(uint32_t{3}, Napi::Number::New(env, box[3]));
+  return output;
+}
+
+// The blocks as typed arrays over one ArrayBuffer (see OcrCompactLayout),
+// which a worker can hand on by transfer rather than by copy.
+Napi::Object ToJsCompactLayout(Napi::Env env,
+                               const std::vector<OcrBlock> &blocks) {
+  const OcrCompactLayout layout = PlanOcrCompactLayout(blocks);
+  auto buffer = Napi::ArrayBuffer::New(env, layout.byteLength);
+  WriteOcrCompactLayout(blocks, layout,
+                        static_cast<uint8_t *>(buffer.Data()));
+
+  const size_t lines = layout.lines;
+  const size_t words = layout.words;
+  auto output = Napi::Object::New(env);
+  output.Set("buffer", buffer);
+  output.Set("lines", Napi::Number::New(env, layout.lines));
+  output.Set("words", Napi::Number::New(env, layout.words));
+  output.Set("text", Napi::Uint8Array::New(env, layout.textBytes, buffer,
+                                           layout.text));
+  output.Set("lineText",
+             Napi::Uint32Array::New(env, lines * 2, buffer, layout.lineText));
+  output.Set("lineBoxes", Napi::Float32Array::New(env, lines * 4, buffer,
+                                                  layout.lineBoxes));
+  output.Set("lineConfidences",
+             Napi::Float32Array::New(env, lines, buffer,
+                                     layout.lineConfidences));
+  output.Set("lineWords",
+             Napi::Uint32Array::New(env, lines * 2, buffer, layout.lineWords));
+  output.Set("wordText",
+             Napi::Uint32Array::New(env, words * 2, buffer, layout.wordText));
+  output.Set("wordBoxes", Napi::Float32Array::New(env, words * 4, buffer,
+                                                  layout.wordBoxes));
+  output.Set("wordConfidences",
+             Napi::Float32Array::New(env, words, buffer,
+                                     layout.wordConfidences));
+  return output;
+}
+
+// Sources that are read on a pool thread rather than while parsing.
+struct DeferredImageSource {
+  std::string path;
+  std::string dataUrl;
+
+  bool empty() const { return path.empty() && dataUrl.empty(); }
+};
+
+// `keepAlive` receives the JS object whose memory `options.image` borrows,
+// so it can be held until the task is done. `subject` names the object in
+// error messages.
+bool ParseImageSource(Napi::Env env, const Napi::Object &input,
+                      const std::string &subject, OcrOptions &options,
+                      DeferredImageSource &source,
+                      Napi::ObjectReference &keepAlive, Napi::Error &error) {
+  if (input.Has("image") && !input.Get("image").IsUndefined()) {
+    if (!input.Get("image").IsBuffer()) {
+      error = Napi::TypeError::New(env, subject + ".image must be a Buffer");
+      return false;
+    }
+    const auto imageBuffer = input.Get("image").As<Napi::Buffer<uint8_t>>();
+    if (imageBuffer.Length() == 0) {
+      error = Napi::TypeError::New(env, subject + ".image cannot be empty");
+      return false;
+    }
+    options.image.data = imageBuffer.Data();
+    options.image.size = imageBuffer.Length();
+    keepAlive = Napi::Persistent(imageBuffer.As<Napi::Object>());
+  } else if (input.Has("pixels") && !input.Get("pixels").IsUndefined()) {
+    if (!ParsePixels(env, input, subject, options.image, error)) {
+      return false;
+    }
+    keepAlive = Napi::Persistent(input.Get("pixels").As<Napi::Object>());
+  } else if (input.Has("imagePath") && input.Get("imagePath").IsString()) {
+    source.path = input.Get("imagePath").As<Napi::String>().Utf8Value();
+    if (source.path.empty() || source.path.find('\0') != std::string::npos) {
+      error =
+          Napi::TypeError::New(env, subject + ".imagePath must be a file path");
+      return false;
+    }
+  } else if (input.Has("dataUrl") && input.Get("dataUrl").IsString()) {
+    source.dataUrl = input.Get("dataUrl").As<Napi::String>().Utf8Value();
+    if (source.dataUrl.empty()) {
+      error = Napi::TypeError::New(env, subject + ".dataUrl cannot be empty");
+      return false;
+    }
+  } else {
+    error = Napi::TypeError::New(
+        env, subject + " must have .image, .imagePath, .dataUrl or .pixels");
+    return false;
+  }
+  return true;
+}
+
+// Reads `input.tiling` into `tiling`; fields it does not mention are left as
+// they are.
+bool ParseTilingOptions(Napi::Env env, const Napi::Object &input,
+                        const std::string &subject, OcrTilingOptions &tiling,
+                        Napi::Error &error) {
+  if (!input.Has("tiling") || input.Get("tiling").IsUndefined()) {
+    return true;
+  }
+  if (!input.Get("tiling").IsObject()) {
+    error = Napi::TypeError::New(env, subject + ".tiling must be an object");
+    return false;
+  }
+  const auto fields = input.Get("tiling").As<Napi::Object>();
+  const auto read = [&](const char *key, double min, uint32_t &value) {
+    if (!fields.Has(key) || fields.Get(key).IsUndefined()) {
+      return true;
+    }
+    const double number = fields.Get(key).IsNumber()
+                              ? fields.Get(key).As<Napi::Number>().DoubleValue()
+                              : -1;
+    if (!std::isfinite(number) || std::floor(number) != number ||
+        (number != 0 && number < min) || number < 0 || number > 32768) {
+      error = Napi::TypeError::New(
+          env, subject + ".tiling." + key + " must be " +
+                   (min > 0 ? "0 or " : "") + "an integer between " +
+                   std::to_string(static_cast<int>(min)) + " and 32768");
+      return false;
+    }
+    value = static_cast<uint32_t>(number);
+    return true;
+  };
+  return read("tileSize", 256, tiling.tileSize) &&
+         read("overlap", 0, tiling.overlap);
+}
+
+// Reads `input.textDetection`: true or false, or { threshold?, force? },
+// which enables the check unless `enabled` is false. Fields it does not
+// mention are left as they are.
+bool ParseTextDetectionOptions(Napi::Env env, const Napi::Object &input,
+                               const std::string &subject,
+                               OcrTextDetectionOptions &textDetection,
+                               Napi::Error &error) {
+  if (!input.Has("textDetection") ||
+      input.Get("textDetection").IsUndefined()) {
+    return true;
+  }
+  const auto value = input.Get("textDetection");
+  if (value.IsBoolean()) {
+    textDetection.enabled = value.As<Napi::Boolean>().Value();
+    return true;
+  }
+  if (!value.IsObject()) {
+    error = Napi::TypeError::New(
+        env, subject + ".textDetection must be a boolean or an object");
+    return false;
+  }
+  const auto fields = value.As<Napi::Object>();
+  textDetection.enabled = true;
+  if (fields.Has("enabled") && fields.Get("enabled").IsBoolean()) {
+    textDetection.enabled = fields.Get("enabled").As<Napi::Boolean>().Value();
+  }
+  if (fields.Has("force") && fields.Get("force").IsBoolean()) {
+    textDetection.force = fields.Get("force").As<Napi::Boolean>().Value();
+  }
+  if (fields.Has("threshold") && !fields.Get("threshold").IsUndefined()) {
+    const double threshold =
+        fields.Get("threshold").IsNumber()
+            ? fields.Get("threshold").As<Napi::Number>().DoubleValue()
+            : -1;
+    if (!std::isfinite(threshold) || threshold < 0 || threshold > 1) {
+      error = Napi::TypeError::New(
+          env, subject + ".textDetection.threshold must be between 0 and 1");
+      return false;
+    }
+    textDetection.threshold = threshold;
+  }
+  return true;
+}
+
+} // namespace
+
+Napi::Object ToJsPreprocessReport(Napi::Env env,
+                                  const OcrPreprocessReport &report) {
+  auto durations = Napi::Object::New(env);
+  durations.Set("decode", Napi::Number::New(env, report.decodeMs));
+  durations.Set("crop", Napi::Number::New(env, report.cropMs));
+  durations.Set("grayscale", Napi::Number::New(env, report.grayscaleMs));
+  durations.Set("scale", Napi::Number::New(env, report.scaleMs));
+  durations.Set("binarize", Napi::Number::New(env, report.binarizeMs));
+  durations.Set("deskew", Napi::Number::New(env, report.deskewMs));
+  durations.Set("total", Napi::Number::New(env, report.totalMs));
+
+  auto output = Napi::Object::New(env);
+  output.Set("durationsMs", durations);
+  output.Set("scale", Napi::Number::New(env, report.scale));
+  output.Set("skewAngle", Napi::Number::New(env, report.skewDegrees));
+  output.Set("width", Napi::Number::New(env, report.width));
+  output.Set("height", Napi::Number::New(env, report.height));
+  return output;
+}
+
+Napi::Object ToJsTextDetectionReport(Napi::Env env,
+                                     const OcrTextDetectionReport &report) {
+  auto output = Napi::Object::New(env);
+  output.Set("score", Napi::Number::New(env, report.score));
+  output.Set("glyphs", Napi::Number::New(env, report.glyphs));
+  output.Set("lines", Napi::Number::New(env, report.lines));
+  output.Set("durationMs", Napi::Number::New(env, report.ms));
+  return output;
+}
+
+Napi::Object ToJsResult(Napi::Env env, const OcrResult &result,
+                        bool compactLayout) {
+  // One UTF-16 scratch buffer for the text, block and word strings.
+  JsStrings strings(env);
+  auto output = Napi::Object::New(env);
+  output.Set("text", strings.New(result.text));
+
+  if (result.hasConfidence) {
+    output.Set("confidence", Napi::Number::New(env, result.confidence));
+  }
+
+  if (!result.language.empty()) {
+    output.Set("language", Napi::String::New(env, result.language));
+  }
+
+  if (!result.blocks.empty() && compactLayout) {
+    output.Set("layout", ToJsCompactLayout(env, result.blocks));
+  } else if (!result.blocks.empty()) {
+    auto blocks = Napi::Array::New(env, result.blocks.size());
+    for (size_t i = 0; i < result.blocks.size(); ++i) {
+      const auto &block = result.blocks[i];
+      auto jsBlock = Napi::Object::New(env);
+      jsBlock.Set("text", strings.New(block.text));
+      if (block.hasConfidence) {
+        jsBlock.Set("confidence", Napi::Number::New(env, block.confidence));
+      }
+      if (block.hasBoundingBox) {
+        jsBlock.Set("boundingBox", ToJsBox(env, block.boundingBox));
+      }
+      if (!block.words.empty()) {
+        auto words = Napi::Array::New(env, block.words.size());
+        for (size_t j = 0; j < block.words.size(); ++j) {
+          const auto &word = block.words[j];
+          auto jsWord = Napi::Object::New(env);
+          jsWord.Set("text", strings.New(word.text));
+          if (word.hasConfidence) {
+            jsWord.Set("confidence", Napi::Number::New(env, word.confidence));
+          }
+          jsWord.Set("boundingBox", ToJsBox(env, word.boundingBox));
+          words.Set(static_cast<uint32_t>(j), jsWord);
+        }
+        jsBlock.Set("words", words);
+      }
+      blocks.Set(static_cast<uint32_t>(i), jsBlock);
+    }
+    output.Set("blocks", blocks);
+  }
+
+  output.Set("engine", Napi::String::New(env, result.engine));
+  output.Set("durationMs",
+             Napi::Number::New(env, static_cast<double>(result.durationMs)));
+  if (result.preprocess.applied) {
+    output.Set("preprocess", ToJsPreprocessReport(env, result.preprocess));
+  }
+  if (result.cached) {
+    output.Set("cached", Napi::Boolean::New(env, true));
+  }
+  if (result.incremental.applied) {
+    const auto &report = result.incremental;
+    auto incremental = Napi::Object::New(env);
+    incremental.Set("full", Napi::Boolean::New(env, report.full));
+    incremental.Set("regions", Napi::Number::New(env, report.regions));
+    incremental.Set("changedFraction",
+                    Napi::Number::New(env, report.changedFraction));
+    incremental.Set("reusedBlocks", Napi::Number::New(env, report.reusedBlocks));
+    output.Set("incremental", incremental);
+  }
+  if (result.textDetection.applied) {
+    output.Set("textDetection",
+               ToJsTextDetectionReport(env, result.textDetection));
+  }
+
+  return output;
+}
+
+bool ParsePixels(Napi::Env env, const Napi::Object &input,
+                 const std::string &subject, OcrImage &image,
+                 Napi::Error &error) {
+  const auto pixelsValue = input.Get("pixels");
+  if (!pixelsValue.IsTypedArray() ||
+      pixelsValue.As<Napi::TypedArray>().TypedArrayType() !=
+          napi_uint8_array) {
+    error = Napi::TypeError::New(
+        env, subject + ".pixels must be a Buffer or Uint8Array");
+    return false;
+  }
+  const auto pixels = pixelsValue.As<Napi::Uint8Array>();
+
+  std::string format = "bgra";
+  if (input.Has("pixelFormat") && input.Get("pixelFormat").IsString()) {
+    format = input.Get("pixelFormat").As<Napi::String>().Utf8Value();
+  }
+  if (format != "bgra" && format != "gray") {
+    error = Napi::TypeError::New(
+        env, subject + ".pixelFormat must be 'bgra' or 'gray'");
+    return false;
+  }
+  const uint32_t bytesPerPixel = format == "bgra" ? 4 : 1;
+
+  const auto readDimension = [&input](const char *key, double &value) {
+    if (!input.Has(key) || !input.Get(key).IsNumber()) {
+      return false;
+    }
+    value = input.Get(key).As<Napi::Number>().DoubleValue();
+    return std::isfinite(value) && std::floor(value) == value && value >= 1 &&
+           value <= 32768;
+  };
+  double width = 0;
+  double height = 0;
+  if (!readDimension("width", width) || !readDimension("height", height)) {
+    error = Napi::TypeError::New(
+        env, subject + ".width and .height must be integers between 1 and "
+                       "32768");
+    return false;
+  }
+
+  const double rowBytes = width * bytesPerPixel;
+  double stride = rowBytes;
+  if (input.Has("stride") && input.Get("stride").IsNumber()) {
+    stride = input.Get("stride").As<Napi::Number>().DoubleValue();
+  }
+  if (!std::isfinite(stride) || std::floor(stride) != stride ||
+      stride < rowBytes ||
+      stride * (height - 1) + rowBytes >
+          static_cast<double>(pixels.ByteLength())) {
+    error = Napi::TypeError::New(
+        env, subject + ".stride does not fit " + subject + ".pixels");
+    return false;
+  }
+
+  image.data = pixels.Data();
+  image.size = pixels.ByteLength();
+  image.format =
+      bytesPerPixel == 4 ? OcrPixelFormat::kBgra8 : OcrPixelFormat::kGray8;
+  image.width = static_cast<uint32_t>(width);
+  image.height = static_cast<uint32_t>(height);
+  image.stride = static_cast<uint32_t>(stride);
+  return true;
+}
+
+bool ParsePreprocessOptions(Napi::Env env, const Napi::Object &input,
+                            const std::string &subject,
+                            OcrPreprocessOptions &preprocess,
+                            Napi::Error &error) {
+  if (!input.Has("preprocess") || input.Get("preprocess").IsUndefined()) {
+    return true;
+  }
+  if (!input.Get("preprocess").IsObject()) {
+    error = Napi::TypeError::New(env, subject + ".preprocess must be an object");
+    return false;
+  }
+  const auto steps = input.Get("preprocess").As<Napi::Object>();
+  const std::string name = subject + ".preprocess";
+
+  const auto readFlag = [&steps](const char *key, bool &value) {
+    if (steps.Has(key) && steps.Get(key).IsBoolean()) {
+      value = steps.Get(key).As<Napi::Boolean>().Value();
+    }
+  };
+  const auto readCount = [&](const Napi::Object &from, const char *key,
+                             uint32_t &value) {
+    if (!from.Has(key) || from.Get(key).IsUndefined()) {
+      return true;
+    }
+    const double number = from.Get(key).IsNumber()
+                              ? from.Get(key).As<Napi::Number>().DoubleValue()
+                              : -1;
+    if (!std::isfinite(number) || std::floor(number) != number ||
+        number < 0 || number > 32768) {
+      error = Napi::TypeError::New(
+          env, name + "." + key + " must be an integer between 0 and 32768");
+      return false;
+    }
+    value = static_cast<uint32_t>(number);
+    return true;
+  };
+
+  if (steps.Has("crop") && !steps.Get("crop").IsUndefined()) {
+    if (!steps.Get("crop").IsObject()) {
+      error = Napi::TypeError::New(
+          env, name + ".crop must be { x, y, width, height }");
+      return false;
+    }
+    const auto crop = steps.Get("crop").As<Napi::Object>();
+    if (!readCount(crop, "x", preprocess.cropX) ||
+        !readCount(crop, "y", preprocess.cropY) ||
+        !readCount(crop, "width", preprocess.cropWidth) ||
+        !readCount(crop, "height", preprocess.cropHeight)) {
+      return false;
+    }
+  }
+
+  readFlag("grayscale", preprocess.grayscale);
+  readFlag("binarize", preprocess.binarize);
+  readFlag("deskew", preprocess.deskew);
+  if (!readCount(steps, "targetTextHeight", preprocess.targetTextHeight) ||
+      !readCount(steps, "textHeightHint", preprocess.textHeightHint) ||
+      !readCount(steps, "binarizeWindow", preprocess.binarizeWindow)) {
+    return false;
+  }
+  if (steps.Has("binarizeThreshold") &&
+      steps.Get("binarizeThreshold").IsNumber()) {
+    preprocess.binarizeThreshold =
+        steps.Get("binarizeThreshold").As<Napi::Number>().DoubleValue();
+  }
+  if (steps.Has("maxSkewDegrees") && steps.Get("maxSkewDegrees").IsNumber()) {
+    preprocess.maxSkewDegrees =
+        steps.Get("maxSkewDegrees").As<Napi::Number>().DoubleValue();
+  }
+  return true;
+}
+
+bool ParseTaskOptions(Napi::Env env, const Napi::Object &input,
+                      const std::string &subject, OcrTask &task,
+                      Napi::Error &error) {
+  auto &options = task.options;
+  if (input.Has("languageHint") && input.Get("languageHint").IsString()) {
+    options.languageHint =
+        input.Get("languageHint").As<Napi::String>().Utf8Value();
+  }
+
+  if (input.Has("includeLayout") && input.Get("includeLayout").IsBoolean()) {
+    options.includeLayout =
+        input.Get("includeLayout").As<Napi::Boolean>().Value();
+  }
+
+  if (input.Has("includeWords") && input.Get("includeWords").IsBoolean()) {
+    options.includeWords =
+        input.Get("includeWords").As<Napi::Boolean>().Value();
+  }
+
+  if (input.Has("compactLayout") && input.Get("compactLayout").IsBoolean()) {
+    options.compactLayout =
+        input.Get("compactLayout").As<Napi::Boolean>().Value();
+  }
+
+  if (options.includeWords || options.compactLayout) {
+    options.includeLayout = true;
+  }
+
+  if (input.Has("maxBlocks") && input.Get("maxBlocks").IsNumber()) {
+    const auto maxBlocks =
+        input.Get("maxBlocks").As<Napi::Number>().Int32Value();
+    options.maxBlocks = std::max(0, maxBlocks);
+  }
+
+  if (input.Has("priority") && !input.Get("priority").IsUndefined()) {
+    const auto priority = input.Get("priority").IsString()
+                              ? input.Get("priority").As<Napi::String>().Utf8Value()
+                              : std::string();
+    if (priority != "interactive" && priority != "background") {
+      error = Napi::TypeError::New(
+          env, subject + ".priority must be 'interactive' or 'background'");
+      return false;
+    }
+    task.priority = priority == "background" ? OcrPriority::kBackground
+                                             : OcrPriority::kInteractive;
+  }
+
+  if (input.Has("deadlineMs") && !input.Get("deadlineMs").IsUndefined()) {
+    const double deadlineMs = input.Get("deadlineMs").IsNumber()
+                                  ? input.Get("deadlineMs").As<Napi::Number>().DoubleValue()
+                                  : -1;
+    if (!std::isfinite(deadlineMs) || deadlineMs <= 0) {
+      error = Napi::TypeError::New(
+          env, subject + ".deadlineMs must be a positive number");
+      return false;
+    }
+    task.deadline = std::chrono::steady_clock::now() +
+                    std::chrono::milliseconds(static_cast<int64_t>(deadlineMs));
+  }
+
+  return ParsePreprocessOptions(env, input, subject, options.preprocess,
+                                error) &&
+         ParseTilingOptions(env, input, subject, options.tiling, error) &&
+         ParseTextDetectionOptions(env, input, subject, options.textDetection,
+                                   error);
+}
+
+bool ParseTask(Napi::Env env, const Napi::Object &input,
+               const std::string &subject, OcrTask &task,
+               Napi::ObjectReference &keepAlive, Napi::Error &error) {
+  DeferredImageSource source;
+  if (!ParseImageSource(env, input, subject, task.options, source, keepAlive,
+                        error) ||
+      !ParseTaskOptions(env, input, subject, task, error)) {
+    return false;
+  }
+  if (!source.empty()) {
+    task.prepare = [source = std::move(source)](OcrOptions &options,
+                                               OcrError &loadError) {
+      return !source.path.empty()
+                 ? MapImageFile(source.path, options.image, loadError)
+                 : DecodeImageDataUrl(source.dataUrl, options.image, loadError);
+    };
+  }
+  return true;
+}
+
+} // namespace tuff::native
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <napi.h>
+
+#include <string>
+
+#include "common/ocr_types.h"
+
+namespace tuff::native {
+
+// Conversions between the JS shapes of index.d.ts and the OCR types, shared
+// by the addon and the native benchmarks.
+
+Napi::Object ToJsPreprocessReport(Napi::Env env,
+                                  const OcrPreprocessReport &report);
+Napi::Object ToJsTextDetectionReport(Napi::Env env,
+                                     const OcrTextDetectionReport &report);
+// With `compactLayout`, blocks go out as the typed-array `layout` instead.
+Napi::Object ToJsResult(Napi::Env env, const OcrResult &result,
+                        bool compactLayout = false);
+
+// Reads `input.pixels`, `width`, `height` and `pixelFormat` into `image`.
+bool ParsePixels(Napi::Env env, const Napi::Object &input,
+                 const std::string &subject, OcrImage &image,
+                 Napi::Error &error);
+
+// Reads `input.preprocess` into `preprocess`; steps it does not mention are
+// left as they are.
+bool ParsePreprocessOptions(Napi::Env env, const Napi::Object &input,
+                            const std::string &subject,
+                            OcrPreprocessOptions &preprocess,
+                            Napi::Error &error);
+
+// Reads the recognition settings present on `input` into `task`, leaving the
+// rest as they are, so a batch item can override the batch options.
+bool ParseTaskOptions(Napi::Env env, const Napi::Object &input,
+                      const std::string &subject, OcrTask &task,
+                      Napi::Error &error);
+
+// Parses one image and its settings into `task`; images read from a path or
+// data URL are loaded by the task itself, on the pool thread.
+bool ParseTask(Napi::Env env, const Napi::Object &input,
+               const std::string &subject, OcrTask &task,
+               Napi::ObjectReference &keepAlive, Napi::Error &error);
+
+} // namespace tuff::native
@@ -0,0 +1,485 @@
+#include <dlfcn.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common/image_preprocess.h"
+#include "common/ocr_types.h"
+
+namespace tuff::native {
+
+namespace {
+
+// Tesseract and Leptonica are loaded at run time rather than linked: the addon
+// then builds and loads on machines without them, and OCR is reported as
+// unsupported there instead of the whole module failing to load. Only the
+// stable C API (tesseract/capi.h, leptonica/allheaders.h) is used, so any
+// Tesseract from 4.0 on works.
+struct TessBaseAPI;
+struct TessResultIterator;
+struct TessPageIterator;
+struct Pix;
+
+constexpr int kPsmAuto = 3;
+constexpr int kRilTextline = 2;
+constexpr int kRilWord = 3;
+
+struct TesseractApi {
+  using CreateFn = TessBaseAPI* (*)();
+  using DeleteFn = void (*)(TessBaseAPI*);
+  using Init3Fn = int (*)(TessBaseAPI*, const char*, const char*);
+  using SetPageSegModeFn = void (*)(TessBaseAPI*, int);
+  using SetVariableFn = int (*)(TessBaseAPI*, const char*, const char*);
+  using SetImageFn = void (*)(TessBaseAPI*, const unsigned char*, int, int, int, int);
+  using SetImage2Fn = void (*)(TessBaseAPI*, Pix*);
+  using RecognizeFn = int (*)(TessBaseAPI*, void*);
+  using MeanTextConfFn = int (*)(TessBaseAPI*);
+  using ClearFn = void (*)(TessBaseAPI*);
+  using GetIteratorFn = TessResultIterator* (*)(TessBaseAPI*);
+  using IteratorDeleteFn = void (*)(TessResultIterator*);
+  using IteratorNextFn = int (*)(TessResultIterator*, int);
+  using IteratorTextFn = char* (*)(const TessResultIterator*, int);
+  using IteratorConfidenceFn = float (*)(const TessResultIterator*, int);
+  using IteratorPageFn = const TessPageIterator* (*)(const TessResultIterator*);
+  using PageBoundingBoxFn = int (*)(const TessPageIterator*, int, int*, int*, int*, int*);
+  using PageIsAtBeginningOfFn = int (*)(const TessPageIterator*, int);
+  using DeleteTextFn = void (*)(const char*);
+  using PixReadMemFn = Pix* (*)(const uint8_t*, size_t);
+  using PixDestroyFn = void (*)(Pix**);
+  using PixConvertTo32Fn = Pix* (*)(Pix*);
+  using PixGetDataFn = uint32_t* (*)(Pix*);
+  using PixGetIntFn = int (*)(Pix*);
+
+  CreateFn create = nullptr;
+  DeleteFn destroy = nullptr;
+  Init3Fn init3 = nullptr;
+  SetPageSegModeFn setPageSegMode = nullptr;
+  SetVariableFn setVariable = nullptr;
+  SetImageFn setImage = nullptr;
+  SetImage2Fn setImage2 = nullptr;
+  RecognizeFn recognize = nullptr;
+  MeanTextConfFn meanTextConf = nullptr;
+  ClearFn clear = nullptr;
+  GetIteratorFn getIterator = nullptr;
+  IteratorDeleteFn iteratorDelete = nullptr;
+  IteratorNextFn iteratorNext = nullptr;
+  IteratorTextFn iteratorText = nullptr;
+  IteratorConfidenceFn iteratorConfidence = nullptr;
+  IteratorPageFn iteratorPage = nullptr;
+  PageBoundingBoxFn pageBoundingBox = nullptr;
+  PageIsAtBeginningOfFn pageIsAtBeginningOf = nullptr;
+  DeleteTextFn deleteText = nullptr;
+  PixReadMemFn pixReadMem = nullptr;
+  PixDestroyFn pixDestroy = nullptr;
+  PixConvertTo32Fn pixConvertTo32 = nullptr;
+  PixGetDataFn pixGetData = nullptr;
+  PixGetIntFn pixGetWpl = nullptr;
+  PixGetIntFn pixGetWidth = nullptr;
+  PixGetIntFn pixGetHeight = nullptr;
+
+  // Empty when the libraries are usable.
+  std::string unavailableReason;
+
+  static const TesseractApi& Get() {
+    static const TesseractApi* api = Load();
+    return *api;
+  }
+
+ private:
+  static void* OpenFirst(std::initializer_list<const char*> names) {
+    for (const char* name : names) {
+      void* module = ::dlopen(name, RTLD_NOW | RTLD_LOCAL);
+      if (module != nullptr) {
+        return module;
+      }
+    }
+    return nullptr;
+  }
+
+  template <typename Fn>
+  static bool Bind(void* module, const char* symbol, Fn& out) {
+    out = reinterpret_cast<Fn>(::dlsym(module, symbol));
+    return out != nullptr;
+  }
+
+  static const TesseractApi* Load() {
+    auto* api = new TesseractApi();
+    void* tesseract = OpenFirst({"libtesseract.so.5", "libtesseract.so.4", "libtesseract.so"});
+    if (tesseract == nullptr) {
+      api->unavailableReason = "tesseract-not-installed";
+      return api;
+    }
+    // Already mapped as a dependency of libtesseract; this only finds it.
+    void* leptonica = OpenFirst({"libleptonica.so.6", "liblept.so.5", "libleptonica.so", "liblept.so"});
+    if (leptonica == nullptr) {
+      api->unavailableReason = "leptonica-not-installed";
+      return api;
+    }
+
+    const bool bound = Bind(tesseract, "TessBaseAPICreate", api->create) &&
+                       Bind(tesseract, "TessBaseAPIDelete", api->destroy) &&
+                       Bind(tesseract, "TessBaseAPIInit3", api->init3) &&
+                       Bind(tesseract, "TessBaseAPISetPageSegMode", api->setPageSegMode) &&
+                       Bind(tesseract, "TessBaseAPISetVariable", api->setVariable) &&
+                       Bind(tesseract, "TessBaseAPISetImage", api->setImage) &&
+                       Bind(tesseract, "TessBaseAPISetImage2", api->setImage2) &&
+                       Bind(tesseract, "TessBaseAPIRecognize", api->recognize) &&
+                       Bind(tesseract, "TessBaseAPIMeanTextConf", api->meanTextConf) &&
+                       Bind(tesseract, "TessBaseAPIClear", api->clear) &&
+                       Bind(tesseract, "TessBaseAPIGetIterator", api->getIterator) &&
+                       Bind(tesseract, "TessResultIteratorDelete", api->iteratorDelete) &&
+                       Bind(tesseract, "TessResultIteratorNext", api->iteratorNext) &&
+                       Bind(tesseract, "TessResultIteratorGetUTF8Text", api->iteratorText) &&
+                       Bind(tesseract, "TessResultIteratorConfidence", api->iteratorConfidence) &&
+                       Bind(tesseract, "TessResultIteratorGetPageIteratorConst", api->iteratorPage) &&
+                       Bind(tesseract, "TessPageIteratorBoundingBox", api->pageBoundingBox) &&
+                       Bind(tesseract, "TessPageIteratorIsAtBeginningOf", api->pageIsAtBeginningOf) &&
+                       Bind(tesseract, "TessDeleteText", api->deleteText) &&
+                       Bind(leptonica, "pixReadMem", api->pixReadMem) &&
+                       Bind(leptonica, "pixDestroy", api->pixDestroy) &&
+                       Bind(leptonica, "pixConvertTo32", api->pixConvertTo32) &&
+                       Bind(leptonica, "pixGetData", api->pixGetData) &&
+                       Bind(leptonica, "pixGetWpl", api->pixGetWpl) &&
+                       Bind(leptonica, "pixGetWidth", api->pixGetWidth) &&
+                       Bind(leptonica, "pixGetHeight", api->pixGetHeight);
+    if (!bound) {
+      api->unavailableReason = "tesseract-api-incomplete";
+    }
+    return api;
+  }
+};
+
+// Maps the BCP 47 tags the other backends take ("en-US", "zh-Hans") to
+// Tesseract language codes. Hints that are already Tesseract codes ("eng",
+// "chi_sim", "eng+deu") pass through.
+std::string ToTesseractLanguage(const std::string& hint) {
+  if (hint.empty()) {
+    return "eng";
+  }
+  if (hint.find('_') != std::string::npos || hint.find('+') != std::string::npos ||
+      (hint.size() == 3 && hint.find('-') == std::string::npos)) {
+    return hint;
+  }
+
+  std::string tag;
+  tag.reserve(hint.size());
+  for (char c : hint) {
+    tag.push_back(c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c);
+  }
+  if (tag.rfind("zh", 0) == 0) {
+    const bool traditional = tag.find("hant") != std::string::npos || tag.find("-tw") != std::string::npos ||
+                             tag.find("-hk") != std::string::npos || tag.find("-mo") != std::string::npos;
+    return traditional ? "chi_tra" : "chi_sim";
+  }
+
+  static const std::unordered_map<std::string, std::string> kPrimaryLanguages = {
+      {"en", "eng"}, {"de", "deu"}, {"fr", "fra"}, {"es", "spa"}, {"it", "ita"},
+      {"pt", "por"}, {"nl", "nld"}, {"ru", "rus"}, {"uk", "ukr"}, {"pl", "pol"},
+      {"ja", "jpn"}, {"ko", "kor"}, {"ar", "ara"}, {"tr", "tur"}, {"vi", "vie"},
+  };
+  const auto found = kPrimaryLanguages.find(tag.substr(0, tag.find('-')));
+  return found == kPrimaryLanguages.end() ? "eng" : found->second;
+}
+
+std::string TrimLine(const char* text) {
+  if (text == nullptr) {
+    return std::string();
+  }
+  std::string line(text);
+  const auto isSpace = [](char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\f'; };
+  size_t end = line.size();
+  while (end > 0 && isSpace(line[end - 1])) {
+    --end;
+  }
+  size_t begin = 0;
+  while (begin < end && isSpace(line[begin])) {
+    ++begin;
+  }
+  return line.substr(begin, end - begin);
+}
+
+// One initialised TessBaseAPI. Init loads the language's traineddata, which
+// dominates a cold call (tens to hundreds of milliseconds), so the pool keeps
+// these between calls.
+class TesseractEngine : public OcrEngine {
+ public:
+  TesseractEngine(TessBaseAPI* handle, std::string language)
+      : handle_(handle), language_(std::move(language)) {}
+
+  ~TesseractEngine() override { TesseractApi::Get().destroy(handle_); }
+
+  bool Recognize(const OcrOptions& options, OcrResult& result, OcrError& error) override;
+
+ private:
+  TessBaseAPI* handle_;
+  // What was loaded, which is "eng" when the requested language was not
+  // installed.
+  std::string language_;
+};
+
+class TesseractEngineFactory : public OcrEngineFactory {
+ public:
+  std::string ResolveLanguage(const std::string& hint) const override {
+    return ToTesseractLanguage(hint);
+  }
+
+  std::unique_ptr<OcrEngine> Create(const std::string& language, OcrError& error) override {
+    const auto& api = TesseractApi::Get();
+    if (!api.unavailableReason.empty()) {
+      error.code = "ERR_OCR_ENGINE_UNAVAILABLE";
+      error.message = "Tesseract OCR is unavailable: " + api.unavailableReason;
+      return nullptr;
+    }
+
+    // Falls back to English when the language's traineddata is not
+    // installed, as the Windows backend falls back to en-US.
+    for (const std::string& candidate : {language, std::string("eng")}) {
+      TessBaseAPI* handle = api.create();
+      if (handle == nullptr) {
+        break;
+      }
+      // A null datapath lets Tesseract use TESSDATA_PREFIX or its built-in
+      // path.
+      if (api.init3(handle, nullptr, candidate.c_str()) != 0) {
+        api.destroy(handle);
+        continue;
+      }
+      api.setPageSegMode(handle, kPsmAuto);
+      // Resolution estimates and similar notes would otherwise go to stderr
+      // on every call.
+      api.setVariable(handle, "debug_file", "/dev/null");
+      return std::make_unique<TesseractEngine>(handle, candidate);
+    }
+
+    error.code = "ERR_OCR_ENGINE_UNAVAILABLE";
+    error.message = "Tesseract OCR could not load traineddata for " + language;
+    return nullptr;
+  }
+};
+
+OcrEnginePool& EnginePool() {
+  static auto* pool = new OcrEnginePool(std::make_unique<TesseractEngineFactory>());
+  return *pool;
+}
+
+bool TesseractEngine::Recognize(const OcrOptions& options, OcrResult& result, OcrError& error) {
+  const auto& api = TesseractApi::Get();
+  if (options.image.empty()) {
+    error.code = "ERR_OCR_DECODE_FAILED";
+    error.message = "Image payload is empty";
+    return false;
+  }
+
+  const OcrImage& input = options.image;
+  if (input.format == OcrPixelFormat::kEncoded) {
+    Pix* image = api.pixReadMem(input.data, input.size);
+    if (image == nullptr) {
+      error.code = "ERR_OCR_DECODE_FAILED";
+      error.message = "Failed to decode image bytes";
+      return false;
+    }
+    api.setImage2(handle_, image);
+    api.pixDestroy(&image);
+  } else if (input.format == OcrPixelFormat::kGray8) {
+    api.setImage(handle_, input.data, static_cast<int>(input.width), static_cast<int>(input.height), 1,
+                 static_cast<int>(input.stride));
+  } else {
+    // Tesseract reads four-byte pixels as RGBA and recognizes on luminance
+    // anyway, so BGRA is reduced to gray here rather than reordered.
+    std::vector<uint8_t> gray(static_cast<size_t>(input.width) * input.height);
+    for (uint32_t y = 0; y < input.height; ++y) {
+      ConvertBgraRowToGray(input.data + static_cast<size_t>(y) * input.stride,
+                           gray.data() + static_cast<size_t>(y) * input.width, input.width);
+    }
+    api.setImage(handle_, gray.data(), static_cast<int>(input.width), static_cast<int>(input.height), 1,
+                 static_cast<int>(input.width));
+  }
+
+  // SetImage copies the pixels and SetImage2 takes its own reference, so the
+  // input is no longer needed here.
+  const bool recognized = api.recognize(handle_, nullptr) == 0;
+  if (!recognized) {
+    api.clear(handle_);
+    error.code = "ERR_OCR_RECOGNIZE_FAILED";
+    error.message = "Tesseract OCR recognition failed";
+    return false;
+  }
+
+  std::vector<std::string> lines;
+  TessResultIterator* iterator = api.getIterator(handle_);
+  if (iterator != nullptr) {
+    const TessPageIterator* page = api.iteratorPage(iterator);
+    const int maxBlocks = options.maxBlocks;
+    const auto box = [&api, page](int level, std::array<double, 4>& out) {
+      int left = 0;
+      int top = 0;
+      int right = 0;
+      int bottom = 0;
+      if (api.pageBoundingBox(page, level, &left, &top, &right, &bottom) == 0) {
+        return false;
+      }
+      out = {static_cast<double>(left), static_cast<double>(top), static_cast<double>(std::max(0, right - left)),
+             static_cast<double>(std::max(0, bottom - top))};
+      return true;
+    };
+    // With words the iterator steps word by word, and each line is read at
+    // its first word. `line` is the block its words go to, if any.
+    const int level = options.includeWords ? kRilWord : kRilTextline;
+    OcrBlock* line = nullptr;
+    do {
+      if (level == kRilTextline || api.pageIsAtBeginningOf(page, kRilTextline) != 0) {
+        line = nullptr;
+        char* raw = api.iteratorText(iterator, kRilTextline);
+        std::string text = TrimLine(raw);
+        api.deleteText(raw);
+        if (text.empty()) {
+          continue;
+        }
+
+        if (options.includeLayout && (maxBlocks <= 0 || static_cast<int>(result.blocks.size()) < maxBlocks)) {
+          OcrBlock block;
+          block.text = text;
+          block.hasConfidence = true;
+          block.confidence = std::clamp(api.iteratorConfidence(iterator, kRilTextline) / 100.0, 0.0, 1.0);
+          block.hasBoundingBox = box(kRilTextline, block.boundingBox);
+          result.blocks.push_back(std::move(block));
+          line = &result.blocks.back();
+        }
+        lines.push_back(std::move(text));
+      }
+
+      if (level == kRilWord && line != nullptr) {
+        char* raw = api.iteratorText(iterator, kRilWord);
+        OcrWord word;
+        word.text = TrimLine(raw);
+        api.deleteText(raw);
+        if (!word.text.empty() && box(kRilWord, word.boundingBox)) {
+          word.hasConfidence = true;
+          word.confidence = std::clamp(api.iteratorConfidence(iterator, kRilWord) / 100.0, 0.0, 1.0);
+          line->words.push_back(std::move(word));
+        }
+      }
+    } while (api.iteratorNext(iterator, level) != 0);
+    api.iteratorDelete(iterator);
+  }
+
+  const int meanConfidence = api.meanTextConf(handle_);
+  // Drops the page and its results; the loaded language stays.
+  api.clear(handle_);
+
+  if (lines.empty()) {
+    // See the note in winrt_ocr.cpp (#1517).
+    error.code = "ERR_OCR_RECOGNIZE_FAILED";
+    error.message = "Tesseract recognized no text in the image";
+    return false;
+  }
+
+  result.text.clear();
+  for (size_t i = 0; i < lines.size(); ++i) {
+    if (i > 0) {
+      result.text += "\n";
+    }
+    result.text += lines[i];
+  }
+
+  if (meanConfidence >= 0) {
+    result.hasConfidence = true;
+    result.confidence = std::min(100, meanConfidence) / 100.0;
+  }
+
+  result.engine = "tesseract";
+  result.language = language_;
+  return true;
+}
+
+} // namespace
+
+bool DecodePlatformImage(const OcrImage& encoded, OcrImage& decoded, OcrError& error) {
+  const auto& api = TesseractApi::Get();
+  if (!api.unavailableReason.empty()) {
+    error.code = "ERR_OCR_ENGINE_UNAVAILABLE";
+    error.message = "Leptonica is needed to decode images: " + api.unavailableReason;
+    return false;
+  }
+
+  Pix* source = api.pixReadMem(encoded.data, encoded.size);
+  Pix* image = source != nullptr ? api.pixConvertTo32(source) : nullptr;
+  if (source != nullptr) {
+    api.pixDestroy(&source);
+  }
+  if (image == nullptr) {
+    error.code = "ERR_OCR_DECODE_FAILED";
+    error.message = "Failed to decode image bytes";
+    return false;
+  }
+
+  // Leptonica keeps 32-bit pixels as native words laid out 0xRRGGBBAA.
+  const uint32_t width = static_cast<uint32_t>(api.pixGetWidth(image));
+  const uint32_t height = static_cast<uint32_t>(api.pixGetHeight(image));
+  const size_t wordsPerLine = static_cast<size_t>(api.pixGetWpl(image));
+  const uint32_t* words = api.pixGetData(image);
+  auto pixels = std::make_shared<std::vector<uint8_t>>(static_cast<size_t>(width) * height * 4);
+  for (uint32_t y = 0; y < height; ++y) {
+    const uint32_t* row = words + wordsPerLine * y;
+    uint8_t* out = pixels->data() + static_cast<size_t>(y) * width * 4;
+    for (uint32_t x = 0; x < width; ++x) {
+      out[x * 4] = static_cast<uint8_t>(row[x] >> 8);
+      out[x * 4 + 1] = static_cast<uint8_t>(row[x] >> 16);
+      out[x * 4 + 2] = static_cast<uint8_t>(row[x] >> 24);
+      out[x * 4 + 3] = 0xff;
+    }
+  }
+  api.pixDestroy(&image);
+
+  decoded.data = pixels->data();
+  decoded.size = pixels->size();
+  decoded.format = OcrPixelFormat::kBgra8;
+  decoded.width = width;
+  decoded.height = height;
+  decoded.stride = width * 4;
+  decoded.owner = std::move(pixels);
+  return true;
+}
+
+std::string ProbePlatformOcrEngine() {
+  return TesseractApi::Get().unavailableReason;
+}
+
+bool PerformPlatformOcr(const OcrOptions& options, OcrResult& result, OcrError& error) {
+  const auto& api = TesseractApi::Get();
+  if (!api.unavailableReason.empty()) {
+    error.code = "ERR_OCR_ENGINE_UNAVAILABLE";
+    error.message = "Tesseract OCR is unavailable: " + api.unavailableReason;
+    return false;
+  }
+  return EnginePool().Recognize(options, result, error);
+}
+
+void SubmitPlatformOcr(OcrTask task) {
+  const auto& api = TesseractApi::Get();
+  if (!api.unavailableReason.empty()) {
+    OcrResult result;
+    OcrError error{"ERR_OCR_ENGINE_UNAVAILABLE", "Tesseract OCR is unavailable: " + api.unavailableReason};
+    task.done(false, result, error);
+    return;
+  }
+  EnginePool().Submit(std::move(task));
+}
+
+void ConfigurePlatformOcr(uint32_t threads, uint32_t backgroundThreads) {
+  EnginePool().Configure(threads, backgroundThreads);
+}
+
+OcrEnginePoolStats PlatformOcrStats() {
+  return EnginePool().Stats();
+}
+
+} // namespace tuff::native
@@ -3,8 +3,7 @@
 #import <ImageIO/ImageIO.h>
 #import <Vision/Vision.h>
 
-#include <algorithm>
-#include <chrono>
+#include <memory>
 #include <numeric>
 #include <string>
 #include <vector>
@@ -21,14 +20,44 @@ std::string ToStdString(NSString* text) {
   return cstr ? std::string(cstr) : std::string();
 }
 
-CGImageRef CreateImageFromBytes(const std::vector<uint8_t>& bytes, OcrError& error) {
+// Wraps raw pixels without copying; the image must not outlive `image`.
+CGImageRef CreateImageFromPixels(const OcrImage& image, OcrError& error) {
+  const bool gray = image.format == OcrPixelFormat::kGray8;
+  CGDataProviderRef provider = CGDataProviderCreateWithData(nullptr, image.data, image.size, nullptr);
+  CGColorSpaceRef colorSpace = gray ? CGColorSpaceCreateDeviceGray() : CGColorSpaceCreateDeviceRGB();
+  const CGBitmapInfo bitmapInfo =
+      gray ? static_cast<CGBitmapInfo>(kCGImageAlphaNone)
+           : static_cast<CGBitmapInfo>(kCGBitmapByteOrder32Little | kCGImageAlphaNoneSkipFirst);
+  CGImageRef cgImage = nullptr;
+  if (provider != nullptr && colorSpace != nullptr) {
+    cgImage = CGImageCreate(image.width, image.height, 8, gray ? 8 : 32, image.stride, colorSpace, bitmapInfo,
+                            provider, nullptr, false, kCGRenderingIntentDefault);
+  }
+  if (colorSpace != nullptr) CGColorSpaceRelease(colorSpace);
+  if (provider != nullptr) CGDataProviderRelease(provider);
+
+  if (cgImage == nullptr) {
+    error.code = "ERR_OCR_DECODE_FAILED";
+    error.message = "Failed to create CGImage from pixels";
+  }
+  return cgImage;
+}
+
+CGImageRef CreateImageFromBytes(const OcrImage& bytes, OcrError& error) {
   if (bytes.empty()) {
     error.code = "ERR_OCR_DECODE_FAILED";
     error.message = "Image payload is empty";
     return nil;
   }
 
-  NSData* data = [NSData dataWithBytes:bytes.data() length:bytes.size()];
+  if (bytes.format != OcrPixelFormat::kEncoded) {
+    return CreateImageFromPixels(bytes, error);
+  }
+
+  // No copy: the caller keeps the bytes alive until the image is released.
+  NSData* data = [NSData dataWithBytesNoCopy:const_cast<uint8_t*>(bytes.data)
+                                      length:bytes.size
+                                freeWhenDone:NO];
   if (data == nil || [data length] == 0) {
     error.code = "ERR_OCR_DECODE_FAILED";
     error.message = "Failed to create NSData from image bytes";
@@ -64,12 +93,28 @@ std::array<double, 4> ToBoundingBox(CGRect normalizedRect, size_t imageWidth, si
   return {x, y, width, height};
 }
 
-} // namespace
+// Vision reads whole lines; a word's box is that of its range of the line.
+// Words the recognizer cannot place are left out.
+void AppendWords(VNRecognizedText* candidate, size_t imageWidth, size_t imageHeight, std::vector<OcrWord>& words) {
+  NSString* line = candidate.string;
+  std::vector<OcrWord>* out = &words;
+  [line enumerateSubstringsInRange:NSMakeRange(0, [line length])
+                           options:NSStringEnumerationByWords
+                        usingBlock:^(NSString* substring, NSRange range, NSRange, BOOL*) {
+                          NSError* rangeError = nil;
+                          VNRectangleObservation* box = [candidate boundingBoxForRange:range error:&rangeError];
+                          if (box == nil || rangeError != nil) {
+                            return;
+                          }
+                          OcrWord word;
+                          word.text = ToStdString(substring);
+                          word.boundingBox = ToBoundingBox(box.boundingBox, imageWidth, imageHeight);
+                          out->push_back(std::move(word));
+                        }];
+}
 
-bool PerformPlatformOcr(const OcrOptions& options, OcrResult& result, OcrError& error) {
+bool RecognizeWithVision(const OcrOptions& options, OcrResult& result, OcrError& error) {
   @autoreleasepool {
-    const auto startedAt = std::chrono::steady_clock::now();
-
     CGImageRef image = CreateImageFromBytes(options.image, error);
     if (image == nullptr) {
       return false;
@@ -128,6 +173,9 @@ bool PerformPlatformOcr(const OcrOptions& options, OcrResult& result, OcrError&
         block.confidence = candidate.confidence;
         block.hasBoundingBox = true;
         block.boundingBox = ToBoundingBox(observation.boundingBox, imageWidth, imageHeight);
+        if (options.includeWords) {
+          AppendWords(candidate, imageWidth, imageHeight, block.words);
+        }
         result.blocks.push_back(std::move(block));
 
         if (maxBlocks > 0 && static_cast<int>(result.blocks.size()) >= maxBlocks) {
@@ -163,12 +211,85 @@ bool PerformPlatformOcr(const OcrOptions& options, OcrResult& result, OcrError&
     result.engine = "apple-vision";
     result.language = options.languageHint;
 
-    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::steady_clock::now() - startedAt);
-    result.durationMs = static_cast<uint64_t>(std::max<int64_t>(0, elapsed.count()));
+    return true;
+  }
+}
+
+// Vision keeps its models loaded process-wide, so an engine holds nothing;
+// going through OcrEnginePool still gives macOS the same threads, priority
+// lanes and cancellation as the other platforms.
+class VisionEngine final : public OcrEngine {
+ public:
+  bool Recognize(const OcrOptions& options, OcrResult& result, OcrError& error) override {
+    return RecognizeWithVision(options, result, error);
+  }
+};
+
+class VisionEngineFactory final : public OcrEngineFactory {
+ public:
+  std::unique_ptr<OcrEngine> Create(const std::string&, OcrError&) override {
+    return std::make_unique<VisionEngine>();
+  }
+};
+
+OcrEnginePool& EnginePool() {
+  static auto* pool = new OcrEnginePool(std::make_unique<VisionEngineFactory>());
+  return *pool;
+}
 
+} // namespace
+
+bool DecodePlatformImage(const OcrImage& encoded, OcrImage& decoded, OcrError& error) {
+  @autoreleasepool {
+    CGImageRef image = CreateImageFromBytes(encoded, error);
+    if (image == nullptr) {
+      return false;
+    }
+
+    // Drawn into little-endian, alpha-skipped memory, which is BGRA bytes.
+    const uint32_t width = static_cast<uint32_t>(CGImageGetWidth(image));
+    const uint32_t height = static_cast<uint32_t>(CGImageGetHeight(image));
+    auto pixels = std::make_shared<std::vector<uint8_t>>(static_cast<size_t>(width) * height * 4);
+    CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+    CGContextRef context = CGBitmapContextCreate(
+        pixels->data(), width, height, 8, static_cast<size_t>(width) * 4, colorSpace,
+        static_cast<CGBitmapInfo>(kCGBitmapByteOrder32Little | kCGImageAlphaNoneSkipFirst));
+    CGColorSpaceRelease(colorSpace);
+    if (context == nullptr) {
+      CGImageRelease(image);
+      error.code = "ERR_OCR_DECODE_FAILED";
+      error.message = "Failed to create bitmap context for decoding";
+      return false;
+    }
+    CGContextDrawImage(context, CGRectMake(0, 0, width, height), image);
+    CGContextRelease(context);
+    CGImageRelease(image);
+
+    decoded.data = pixels->data();
+    decoded.size = pixels->size();
+    decoded.format = OcrPixelFormat::kBgra8;
+    decoded.width = width;
+    decoded.height = height;
+    decoded.stride = width * 4;
+    decoded.owner = std::move(pixels);
     return true;
   }
 }
 
+bool PerformPlatformOcr(const OcrOptions& options, OcrResult& result, OcrError& error) {
+  return EnginePool().Recognize(options, result, error);
+}
+
+void SubmitPlatformOcr(OcrTask task) {
+  EnginePool().Submit(std::move(task));
+}
+
+void ConfigurePlatformOcr(uint32_t threads, uint32_t backgroundThreads) {
+  EnginePool().Configure(threads, backgroundThreads);
+}
+
+OcrEnginePoolStats PlatformOcrStats() {
+  return EnginePool().Stats();
+}
+
 } // namespace tuff::native
@@ -8,4 +8,23 @@ bool PerformPlatformOcr(const OcrOptions&, OcrResult&, OcrError& error) {
   return false;
 }
 
+bool DecodePlatformImage(const OcrImage&, OcrImage&, OcrError& error) {
+  error.code = "ERR_OCR_UNSUPPORTED_PLATFORM";
+  error.message = "Image decoding is not supported on this platform";
+  return false;
+}
+
+void SubmitPlatformOcr(OcrTask task) {
+  OcrResult result;
+  OcrError error;
+  PerformPlatformOcr(task.options, result, error);
+  task.done(false, result, error);
+}
+
+void ConfigurePlatformOcr(uint32_t, uint32_t) {}
+
+OcrEnginePoolStats PlatformOcrStats() {
+  return {};
+}
+
 } // namespace tuff::native
@@ -1,8 +1,10 @@
 #include <algorithm>
 #include <windows.h>
-#include <chrono>
 #include <cstdint>
+#include <cstring>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <winrt/Windows.Foundation.h>
@@ -13,46 +15,23 @@
 #include <winrt/Windows.Storage.Streams.h>
 
 #include "common/ocr_types.h"
+#include "common/utf_transcode.h"
 
 namespace tuff::native {
 
 namespace {
 
-std::wstring ToWide(const std::string& value) {
-  if (value.empty()) {
-    return std::wstring();
-  }
-  const int length = MultiByteToWideChar(CP_UTF8, 0, value.data(), static_cast<int>(value.size()), nullptr, 0);
-  if (length <= 0) {
-    return std::wstring();
-  }
-  std::wstring output(static_cast<size_t>(length), L'\0');
-  MultiByteToWideChar(CP_UTF8, 0, value.data(), static_cast<int>(value.size()), output.data(), length);
-  return output;
-}
-
 std::string ToUtf8(const winrt::hstring& value) {
-  if (value.empty()) {
-    return std::string();
-  }
-  const auto wide = std::wstring(value.c_str());
-  const int length = WideCharToMultiByte(CP_UTF8, 0, wide.data(), static_cast<int>(wide.size()), nullptr, 0, nullptr, nullptr);
-  if (length <= 0) {
-    return std::string();
-  }
-  std::string output(static_cast<size_t>(length), '\0');
-  WideCharToMultiByte(CP_UTF8, 0, wide.data(), static_cast<int>(wide.size()), output.data(), length, nullptr, nullptr);
-  return output;
+  return WideToUtf8(value.data(), value.size());
 }
 
 winrt::Windows::Media::Ocr::OcrEngine CreateEngine(const std::string& languageHint) {
   using namespace winrt::Windows::Globalization;
-  using namespace winrt::Windows::Media::Ocr;
 
   if (!languageHint.empty()) {
     try {
-      auto language = Language(winrt::hstring(ToWide(languageHint)));
-      auto fromLanguage = OcrEngine::TryCreateFromLanguage(language);
+      auto language = Language(winrt::hstring(Utf8ToWide(languageHint)));
+      auto fromLanguage = winrt::Windows::Media::Ocr::OcrEngine::TryCreateFromLanguage(language);
       if (fromLanguage) {
         return fromLanguage;
       }
@@ -61,18 +40,40 @@ winrt::Windows::Media::Ocr::OcrEngine CreateEngine(const std::string& languageHi
     }
   }
 
-  auto fromProfile = OcrEngine::TryCreateFromUserProfileLanguages();
+  auto fromProfile = winrt::Windows::Media::Ocr::OcrEngine::TryCreateFromUserProfileLanguages();
   if (fromProfile) {
     return fromProfile;
   }
 
   auto fallbackLanguage = Language(L"en-US");
-  auto fallback = OcrEngine::TryCreateFromLanguage(fallbackLanguage);
+  auto fallback = winrt::Windows::Media::Ocr::OcrEngine::TryCreateFromLanguage(fallbackLanguage);
   return fallback;
 }
 
+// Raw pixels go straight into a SoftwareBitmap, one row copy and no codec.
+winrt::Windows::Graphics::Imaging::SoftwareBitmap BuildBitmapFromPixels(const OcrImage& image) {
+  using namespace winrt::Windows::Graphics::Imaging;
+  using namespace winrt::Windows::Storage::Streams;
+
+  const bool gray = image.format == OcrPixelFormat::kGray8;
+  const uint32_t rowBytes = image.width * (gray ? 1 : 4);
+  Buffer pixels(rowBytes * image.height);
+  pixels.Length(rowBytes * image.height);
+  uint8_t* out = pixels.data();
+  for (uint32_t y = 0; y < image.height; ++y) {
+    std::memcpy(out + static_cast<size_t>(y) * rowBytes, image.data + static_cast<size_t>(y) * image.stride,
+                rowBytes);
+  }
+
+  auto bitmap = SoftwareBitmap::CreateCopyFromBuffer(
+      pixels, gray ? BitmapPixelFormat::Gray8 : BitmapPixelFormat::Bgra8, static_cast<int32_t>(image.width),
+      static_cast<int32_t>(image.height), BitmapAlphaMode::Ignore);
+  // The decoder path hands the engine Bgra8 too.
+  return gray ? SoftwareBitmap::Convert(bitmap, BitmapPixelFormat::Bgra8, BitmapAlphaMode::Ignore) : bitmap;
+}
+
 bool BuildBitmapFromBytes(
-    const std::vector<uint8_t>& image,
+    const OcrImage& image,
     winrt::Windows::Graphics::Imaging::SoftwareBitmap& outBitmap,
     OcrError& error) {
   using namespace winrt::Windows::Graphics::Imaging;
@@ -85,9 +86,14 @@ bool BuildBitmapFromBytes(
   }
 
   try {
+    if (image.format != OcrPixelFormat::kEncoded) {
+      outBitmap = BuildBitmapFromPixels(image);
+      return true;
+    }
+
     InMemoryRandomAccessStream stream;
     DataWriter writer(stream);
-    writer.WriteBytes(winrt::array_view<const uint8_t>(image.data(), image.size()));
+    writer.WriteBytes(winrt::array_view<const uint8_t>(image.data, static_cast<uint32_t>(image.size)));
     writer.StoreAsync().get();
     writer.FlushAsync().get();
     writer.DetachStream();
@@ -147,9 +153,9 @@ std::array<double, 4> MergeWordBoundingBox(const winrt::Windows::Media::Ocr::Ocr
 }
 
 /**
- * Owns the COM apartment for one OCR call, and only when this call created it.
+ * Owns the COM apartment of one OCR pool thread, and only when it created it.
  *
- * `init_apartment` ran per call with nothing paired to it. Every N-API worker thread is reused,
+ * `init_apartment` used to run per call with nothing paired to it. Every N-API worker thread is reused,
  * so each call left another reference behind; and a caller that had already initialised the
  * thread single-threaded made the call throw RPC_E_CHANGED_MODE with no handling at all (#344).
  *
@@ -158,6 +164,9 @@ std::array<double, 4> MergeWordBoundingBox(const winrt::Windows::Media::Ocr::Ocr
  * mode -- that is a success and still takes a reference, so it must be released. RPC_E_CHANGED_MODE
  * takes no reference, so releasing on that path would tear down an apartment owned by someone
  * else, on a thread this addon does not own.
+ *
+ * Pool threads belong to the addon, so nothing should have initialised them first; the
+ * RPC_E_CHANGED_MODE branch stays as the guard should that ever change.
  */
 class ApartmentScope {
  public:
@@ -187,30 +196,51 @@ class ApartmentScope {
   bool owned_ = false;
 };
 
-} // namespace
-
-bool PerformPlatformOcr(const OcrOptions& options, OcrResult& result, OcrError& error) {
-  using namespace winrt::Windows::Media::Ocr;
+class WindowsOcrEngine : public OcrEngine {
+ public:
+  explicit WindowsOcrEngine(winrt::Windows::Media::Ocr::OcrEngine engine) : engine_(std::move(engine)) {}
 
-  const auto startedAt = std::chrono::steady_clock::now();
+  bool Recognize(const OcrOptions& options, OcrResult& result, OcrError& error) override;
 
-  try {
-    // Destroyed on every exit from this try block, including the throwing ones below.
-    const ApartmentScope apartment;
+ private:
+  winrt::Windows::Media::Ocr::OcrEngine engine_;
+};
 
-    winrt::Windows::Graphics::Imaging::SoftwareBitmap bitmap{nullptr};
-    if (!BuildBitmapFromBytes(options.image, bitmap, error)) {
-      return false;
-    }
+// Engines are keyed by the hint as given; CreateEngine's fallbacks run once
+// per hint and pool thread rather than on every call.
+class WindowsOcrEngineFactory : public OcrEngineFactory {
+ public:
+  std::shared_ptr<void> AttachThread() override { return std::make_shared<ApartmentScope>(); }
 
-    auto engine = CreateEngine(options.languageHint);
+  std::unique_ptr<OcrEngine> Create(const std::string& language, OcrError& error) override {
+    auto engine = CreateEngine(language);
     if (!engine) {
       error.code = "ERR_OCR_ENGINE_UNAVAILABLE";
       error.message = "Windows OCR engine is unavailable";
+      return nullptr;
+    }
+    return std::make_unique<WindowsOcrEngine>(std::move(engine));
+  }
+
+  // RecognizeAsync rejects anything larger, so the pool tiles it instead.
+  uint32_t MaxImageDimension() const override {
+    return winrt::Windows::Media::Ocr::OcrEngine::MaxImageDimension();
+  }
+};
+
+OcrEnginePool& EnginePool() {
+  static auto* pool = new OcrEnginePool(std::make_unique<WindowsOcrEngineFactory>());
+  return *pool;
+}
+
+bool WindowsOcrEngine::Recognize(const OcrOptions& options, OcrResult& result, OcrError& error) {
+  try {
+    winrt::Windows::Graphics::Imaging::SoftwareBitmap bitmap{nullptr};
+    if (!BuildBitmapFromBytes(options.image, bitmap, error)) {
       return false;
     }
 
-    auto ocrResult = engine.RecognizeAsync(bitmap).get();
+    auto ocrResult = engine_.RecognizeAsync(bitmap).get();
     result.text = ToUtf8(ocrResult.Text());
 
     if (result.text.empty()) {
@@ -233,6 +263,16 @@ bool PerformPlatformOcr(const OcrOptions& options, OcrResult& result, OcrError&
         }
         block.hasBoundingBox = true;
         block.boundingBox = MergeWordBoundingBox(line);
+        if (options.includeWords) {
+          for (const auto& word : line.Words()) {
+            const auto rect = word.BoundingRect();
+            OcrWord entry;
+            entry.text = ToUtf8(word.Text());
+            entry.boundingBox = {static_cast<double>(rect.X), static_cast<double>(rect.Y),
+                                 static_cast<double>(rect.Width), static_cast<double>(rect.Height)};
+            block.words.push_back(std::move(entry));
+          }
+        }
         result.blocks.push_back(std::move(block));
 
         if (maxBlocks > 0 && static_cast<int>(result.blocks.size()) >= maxBlocks) {
@@ -242,14 +282,10 @@ bool PerformPlatformOcr(const OcrOptions& options, OcrResult& result, OcrError&
     }
 
     result.engine = "windows-ocr";
-    if (engine.RecognizerLanguage()) {
-      result.language = ToUtf8(engine.RecognizerLanguage().LanguageTag());
+    if (engine_.RecognizerLanguage()) {
+      result.language = ToUtf8(engine_.RecognizerLanguage().LanguageTag());
     }
 
-    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::steady_clock::now() - startedAt);
-    result.durationMs = static_cast<uint64_t>(std::max<int64_t>(0, elapsed.count()));
-
     return true;
   } catch (const winrt::hresult_error& ex) {
     error.code = "ERR_OCR_RECOGNIZE_FAILED";
@@ -258,15 +294,51 @@ bool PerformPlatformOcr(const OcrOptions& options, OcrResult& result, OcrError&
       error.message = "Windows OCR recognition failed";
     }
     return false;
-  } catch (const std::exception& ex) {
-    error.code = "ERR_OCR_RECOGNIZE_FAILED";
-    error.message = ex.what();
-    return false;
-  } catch (...) {
-    error.code = "ERR_OCR_RECOGNIZE_FAILED";
-    error.message = "Windows OCR recognition failed";
+  }
+}
+
+} // namespace
+
+bool DecodePlatformImage(const OcrImage& encoded, OcrImage& decoded, OcrError& error) {
+  using namespace winrt::Windows::Graphics::Imaging;
+
+  // Runs on a pool thread, which already holds an apartment (ApartmentScope).
+  SoftwareBitmap bitmap{nullptr};
+  if (!BuildBitmapFromBytes(encoded, bitmap, error)) {
     return false;
   }
+
+  const uint32_t width = static_cast<uint32_t>(bitmap.PixelWidth());
+  const uint32_t height = static_cast<uint32_t>(bitmap.PixelHeight());
+  auto pixels = std::make_shared<std::vector<uint8_t>>(static_cast<size_t>(width) * height * 4);
+  winrt::Windows::Storage::Streams::Buffer buffer(static_cast<uint32_t>(pixels->size()));
+  bitmap.CopyToBuffer(buffer);
+  std::memcpy(pixels->data(), buffer.data(), pixels->size());
+
+  decoded.data = pixels->data();
+  decoded.size = pixels->size();
+  decoded.format = OcrPixelFormat::kBgra8;
+  decoded.width = width;
+  decoded.height = height;
+  decoded.stride = width * 4;
+  decoded.owner = std::move(pixels);
+  return true;
+}
+
+bool PerformPlatformOcr(const OcrOptions& options, OcrResult& result, OcrError& error) {
+  return EnginePool().Recognize(options, result, error);
+}
+
+void SubmitPlatformOcr(OcrTask task) {
+  EnginePool().Submit(std::move(task));
+}
+
+void ConfigurePlatformOcr(uint32_t threads, uint32_t backgroundThreads) {
+  EnginePool().Configure(threads, backgroundThreads);
+}
+
+OcrEnginePoolStats PlatformOcrStats() {
+  return EnginePool().Stats();
 }
 
 } // namespace tuff::native
@@ -0,0 +1,602 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/ocr_session.h"
+#include "common/ocr_tiling.h"
+#include "common/ocr_types.h"
+
+// Behavioural checks of tiling, tile merging and incremental sessions on
+// synthetic pages, built by scripts/build-native-tests.js and run by
+// ocr-pipeline.test.js. Text is painted as solid glyph cells whose grey level
+// names the letter, and a stub engine reads them back, so every scenario
+// knows exactly what each tile can see. Run with a scenario name; prints
+// what failed and exits non-zero when anything did.
+
+namespace tuff::native {
+
+// Only preprocessing decodes, and these pages are raw pixels already.
+bool DecodePlatformImage(const OcrImage&, OcrImage&, OcrError& error) {
+  error.code = "ERR_OCR_DECODE_FAILED";
+  error.message = "No image decoder in the test build";
+  return false;
+}
+
+namespace {
+
+// Cells are 6x12 with a pixel between letters and four more for a space,
+// about the proportions of a sans-serif UI font.
+constexpr uint32_t kGlyphWidth = 6;
+constexpr uint32_t kGlyphHeight = 12;
+constexpr uint32_t kLetterGap = 1;
+constexpr uint32_t kSpaceWidth = 4;
+constexpr uint8_t kPaper = 255;
+
+uint8_t InkOf(char letter) {
+  return static_cast<uint8_t>(4 * (letter - 'a'));
+}
+
+char LetterOf(uint8_t ink) {
+  return static_cast<char>('a' + ink / 4);
+}
+
+// A grey page with `text` painted on it, one cell per character.
+struct Page {
+  uint32_t width;
+  uint32_t height;
+  std::vector<uint8_t> pixels;
+
+  Page(uint32_t w, uint32_t h) : width(w), height(h), pixels(static_cast<size_t>(w) * h, kPaper) {}
+
+  void Paint(uint32_t x, uint32_t y, const std::string& text) {
+    for (char c : text) {
+      if (c == ' ') {
+        x += kSpaceWidth;
+        continue;
+      }
+      for (uint32_t row = y; row < y + kGlyphHeight; ++row) {
+        std::fill_n(pixels.data() + static_cast<size_t>(row) * width + x, kGlyphWidth, InkOf(c));
+      }
+      x += kGlyphWidth + kLetterGap;
+    }
+  }
+
+  void Erase(uint32_t x, uint32_t y, uint32_t w, uint32_t h) {
+    for (uint32_t row = y; row < y + h; ++row) {
+      std::fill_n(pixels.data() + static_cast<size_t>(row) * width + x, w, kPaper);
+    }
+  }
+
+  OcrImage image() const {
+    OcrImage image;
+    image.data = pixels.data();
+    image.size = pixels.size();
+    image.format = OcrPixelFormat::kGray8;
+    image.width = width;
+    image.height = height;
+    image.stride = width;
+    return image;
+  }
+};
+
+// Reads pages painted by Page: a band of inked rows is a line, each whole
+// cell in it a letter, and a gap wider than between letters a space. Cells
+// and lines cut by the image edge are not read, as a real engine drops the
+// characters it only sees part of.
+class GlyphEngine : public OcrEngine {
+ public:
+  explicit GlyphEngine(std::atomic<uint64_t>& pixels) : pixels_(pixels) {}
+
+  bool Recognize(const OcrOptions& options, OcrResult& result, OcrError& error) override {
+    const OcrImage& image = options.image;
+    if (image.format != OcrPixelFormat::kGray8) {
+      error.code = "ERR_OCR_RECOGNIZE_FAILED";
+      error.message = "GlyphEngine reads grey pages only";
+      return false;
+    }
+    pixels_ += static_cast<uint64_t>(image.width) * image.height;
+    const auto ink = [&image](uint32_t x, uint32_t y) { return image.data[static_cast<size_t>(y) * image.stride + x]; };
+    const auto inked = [&](uint32_t x, uint32_t top, uint32_t bottom) {
+      for (uint32_t y = top; y < bottom; ++y) {
+        if (ink(x, y) != kPaper) {
+          return true;
+        }
+      }
+      return false;
+    };
+
+    result = OcrResult();
+    result.engine = "glyph";
+    for (uint32_t y = 0; y < image.height;) {
+      uint32_t top = y;
+      while (top < image.height && !std::any_of(image.data + static_cast<size_t>(top) * image.stride,
+                                                 image.data + static_cast<size_t>(top) * image.stride + image.width,
+                                                 [](uint8_t value) { return value != kPaper; })) {
+        ++top;
+      }
+      uint32_t bottom = top;
+      while (bottom < image.height && std::any_of(image.data + static_cast<size_t>(bottom) * image.stride,
+                                                  image.data + static_cast<size_t>(bottom) * image.stride + image.width,
+                                                  [](uint8_t value) { return value != kPaper; })) {
+        ++bottom;
+      }
+      y = bottom + 1;
+      if (top == bottom || bottom - top != kGlyphHeight) {
+        continue;
+      }
+
+      OcrBlock block;
+      uint32_t right = 0;
+      for (uint32_t x = 0; x < image.width;) {
+        if (!inked(x, top, bottom)) {
+          ++x;
+          continue;
+        }
+        uint32_t end = x;
+        while (end < image.width && inked(end, top, bottom)) {
+          ++end;
+        }
+        if (end - x == kGlyphWidth) {
+          const bool newWord = block.words.empty() || x - right > kLetterGap;
+          if (newWord) {
+            OcrWord word;
+            word.boundingBox = {static_cast<double>(x), static_cast<double>(top), 0.0, kGlyphHeight};
+            block.words.push_back(word);
+            if (!block.text.empty()) {
+              block.text += ' ';
+            }
+          }
+          OcrWord& word = block.words.back();
+          word.text += LetterOf(ink(x, top));
+          word.boundingBox[2] = end - word.boundingBox[0];
+          block.text += LetterOf(ink(x, top));
+          right = end;
+        }
+        x = end;
+      }
+      if (block.words.empty()) {
+        continue;
+      }
+      block.boundingBox = {block.words.front().boundingBox[0], static_cast<double>(top),
+                           right - block.words.front().boundingBox[0], kGlyphHeight};
+      block.hasBoundingBox = true;
+      block.confidence = 0.9;
+      block.hasConfidence = true;
+      if (!result.text.empty()) {
+        result.text += '\n';
+      }
+      result.text += block.text;
+      result.blocks.push_back(std::move(block));
+    }
+    result.confidence = 0.9;
+    result.hasConfidence = !result.text.empty();
+    if (result.text.empty()) {
+      error.code = "ERR_OCR_RECOGNIZE_FAILED";
+      error.message = "OCR recognized no text in the image";
+      return false;
+    }
+    return true;
+  }
+
+ private:
+  std::atomic<uint64_t>& pixels_;
+};
+
+class GlyphEngineFactory : public OcrEngineFactory {
+ public:
+  explicit GlyphEngineFactory(std::atomic<uint64_t>& pixels) : pixels_(pixels) {}
+
+  std::unique_ptr<OcrEngine> Create(const std::string&, OcrError&) override {
+    return std::make_unique<GlyphEngine>(pixels_);
+  }
+
+ private:
+  std::atomic<uint64_t>& pixels_;
+};
+
+// A pool of four interactive lanes reading with GlyphEngine; `pixels` counts
+// what the engines were given to read.
+struct Pipeline {
+  std::atomic<uint64_t> pixels{0};
+  OcrEnginePool pool;
+
+  Pipeline() : pool(std::make_unique<GlyphEngineFactory>(pixels), PoolOptions()) {}
+
+  static OcrEnginePoolOptions PoolOptions() {
+    OcrEnginePoolOptions options;
+    options.threads = 4;
+    options.backgroundThreads = 0;
+    return options;
+  }
+
+  bool Recognize(const Page& page, uint32_t tileSize, uint32_t overlap, std::shared_ptr<OcrSession> session,
+                 OcrResult& result, OcrError& error) {
+    OcrTask task;
+    task.options.image = page.image();
+    task.options.includeLayout = true;
+    task.options.includeWords = true;
+    task.options.tiling.tileSize = tileSize;
+    task.options.tiling.overlap = overlap;
+    task.session = std::move(session);
+    std::promise<bool> finished;
+    task.done = [&](bool ok, OcrResult& taskResult, OcrError& taskError) {
+      result = std::move(taskResult);
+      error = std::move(taskError);
+      finished.set_value(ok);
+    };
+    pool.Submit(std::move(task));
+    return finished.get_future().get();
+  }
+};
+
+class Check {
+ public:
+  void Expect(bool condition, const std::string& what) {
+    if (!condition) {
+      failures_.push_back(what);
+    }
+  }
+
+  template <typename T>
+  void Equal(const T& actual, const T& expected, const std::string& what) {
+    if (!(actual == expected)) {
+      std::ostringstream message;
+      message << what << ": got " << actual << ", expected " << expected;
+      failures_.push_back(message.str());
+    }
+  }
+
+  void Box(const std::array<double, 4>& box, double x, double y, double w, double h, const std::string& what) {
+    if (std::fabs(box[0] - x) > 0.5 || std::fabs(box[1] - y) > 0.5 || std::fabs(box[2] - w) > 0.5 ||
+        std::fabs(box[3] - h) > 0.5) {
+      std::ostringstream message;
+      message << what << ": got [" << box[0] << ", " << box[1] << ", " << box[2] << ", " << box[3] << "], expected ["
+              << x << ", " << y << ", " << w << ", " << h << "]";
+      failures_.push_back(message.str());
+    }
+  }
+
+  int Report(const char* scenario) const {
+    for (const std::string& failure : failures_) {
+      std::printf("%s: %s\n", scenario, failure.c_str());
+    }
+    return failures_.empty() ? 0 : 1;
+  }
+
+ private:
+  std::vector<std::string> failures_;
+};
+
+// Where Paint puts the character after `text`, from where `text` starts.
+uint32_t Advance(const std::string& text) {
+  uint32_t x = 0;
+  for (char c : text) {
+    x += c == ' ' ? kSpaceWidth : kGlyphWidth + kLetterGap;
+  }
+  return x;
+}
+
+// Width of the ink of `text`, which neither starts nor ends with a space.
+double Width(const std::string& text) {
+  return static_cast<double>(Advance(text) - kLetterGap);
+}
+
+// Tiles cover the image edge to edge, no larger than asked, evenly spaced,
+// and neighbours share at least the overlap.
+void PlanTiles(Check& check) {
+  const std::vector<OcrTile> single = PlanOcrTiles(800, 600, 1024, 64);
+  check.Equal<size_t>(single.size(), 1, "tiles for an image that fits");
+  check.Expect(single.size() == 1 && single[0].width == 800 && single[0].height == 600, "the one tile is the image");
+
+  const std::vector<OcrTile> tiles = PlanOcrTiles(2000, 1300, 1024, 64);
+  check.Equal<size_t>(tiles.size(), 6, "tiles for 2000x1300 at 1024");
+  std::vector<uint32_t> xs;
+  std::vector<uint32_t> ys;
+  for (const OcrTile& tile : tiles) {
+    check.Expect(tile.width <= 1024 && tile.height <= 1024, "tile within tileSize");
+    check.Expect(tile.x + tile.width <= 2000 && tile.y + tile.height <= 1300, "tile within the image");
+    check.Equal(tile.width, tiles[0].width, "every column as wide");
+    check.Equal(tile.height, tiles[0].height, "every row as tall");
+    if (std::find(xs.begin(), xs.end(), tile.x) == xs.end()) {
+      xs.push_back(tile.x);
+    }
+    if (std::find(ys.begin(), ys.end(), tile.y) == ys.end()) {
+      ys.push_back(tile.y);
+    }
+  }
+  check.Equal<size_t>(xs.size(), 3, "columns");
+  check.Equal<size_t>(ys.size(), 2, "rows");
+  if (xs.size() == 3 && ys.size() == 2) {
+    check.Equal(xs.front(), 0u, "first column at the left edge");
+    check.Equal(xs.back() + tiles[0].width, 2000u, "last column at the right edge");
+    check.Equal(ys.back() + tiles[0].height, 1300u, "last row at the bottom edge");
+    check.Expect(std::max(xs[1] - xs[0], xs[2] - xs[1]) - std::min(xs[1] - xs[0], xs[2] - xs[1]) <= 1,
+                 "columns evenly spaced");
+    check.Expect(xs[0] + tiles[0].width >= xs[1] + 64 && xs[1] + tiles[0].width >= xs[2] + 64,
+                 "columns share the overlap");
+    check.Expect(ys[0] + tiles[0].height >= ys[1] + 64, "rows share the overlap");
+  }
+
+  // An overlap of half a tile or more would never advance.
+  const std::vector<OcrTile> clamped = PlanOcrTiles(1000, 100, 400, 400);
+  check.Expect(!clamped.empty() && clamped.back().x + clamped.back().width == 1000, "clamped overlap still covers");
+  for (size_t i = 1; i < clamped.size(); ++i) {
+    check.Expect(clamped[i].x > clamped[i - 1].x, "clamped overlap advances");
+  }
+}
+
+// Two tiles each read part of a line that crosses the seam between them,
+// dropping the characters their edge cuts; it comes back once, whole, with
+// its words and boxes in image coordinates. The line is moved a pixel at a
+// time so the seam falls in every part of a letter, a space and a word.
+void LineCutAtSeam(Check& check) {
+  const std::string line = "the quick brown fox jumps over a lazy dog";
+  const std::vector<OcrTile> tiles = PlanOcrTiles(480, 40, 256, 32);
+  check.Equal<size_t>(tiles.size(), 2, "tiles");
+
+  Pipeline pipeline;
+  for (uint32_t x = 40; x < 80; ++x) {
+    Page page(480, 40);
+    page.Paint(x, 15, line);
+    const std::string at = " at x=" + std::to_string(x);
+    OcrResult result;
+    OcrError error;
+    check.Expect(pipeline.Recognize(page, 256, 32, nullptr, result, error), "recognized" + at + ": " + error.message);
+    check.Equal(result.text, line, "text" + at);
+    if (result.blocks.size() != 1) {
+      check.Equal<size_t>(result.blocks.size(), 1, "blocks" + at);
+      continue;
+    }
+    const OcrBlock& block = result.blocks[0];
+    check.Box(block.boundingBox, x, 15, Width(line), kGlyphHeight, "line box" + at);
+    size_t start = 0;
+    size_t index = 0;
+    while (start < line.size()) {
+      const size_t end = std::min(line.find(' ', start), line.size());
+      const std::string word = line.substr(start, end - start);
+      if (index < block.words.size()) {
+        check.Equal(block.words[index].text, word, "word" + at);
+        check.Box(block.words[index].boundingBox, x + Advance(line.substr(0, start)), 15, Width(word), kGlyphHeight,
+                  "box of " + word + at);
+      }
+      ++index;
+      start = end + 1;
+    }
+    check.Equal(block.words.size(), index, "words" + at);
+  }
+}
+
+// A line that lies wholly in the overlap is read by both tiles and kept
+// once; a line in the second tile alone keeps its place in the image.
+void LineSeenTwice(Check& check) {
+  Page page(480, 60);
+  page.Paint(228, 10, "ok");
+  page.Paint(300, 40, "second tile");
+  const std::vector<OcrTile> tiles = PlanOcrTiles(page.width, page.height, 256, 32);
+  check.Expect(tiles.size() == 2 && tiles[1].x <= 228 && tiles[0].x + tiles[0].width >= 228 + Width("ok"),
+               "the short line lies in the overlap");
+
+  Pipeline pipeline;
+  OcrResult result;
+  OcrError error;
+  check.Expect(pipeline.Recognize(page, 256, 32, nullptr, result, error), "recognized: " + error.message);
+  check.Equal(result.text, std::string("ok\nsecond tile"), "text");
+  check.Equal<size_t>(result.blocks.size(), 2, "blocks");
+  if (result.blocks.size() == 2) {
+    check.Box(result.blocks[0].boundingBox, 228, 10, Width("ok"), kGlyphHeight, "overlap line box");
+    check.Box(result.blocks[1].boundingBox, 300, 40, Width("second tile"), kGlyphHeight, "second tile line box");
+  }
+
+  // On a grid, a line across the column seam within the row overlap is read
+  // by all four tiles, two of them cut.
+  const std::string line = "four tiles read this";
+  for (uint32_t y = 226; y < 244; y += 3) {
+    Page grid(480, 480);
+    grid.Paint(180, y, line);
+    check.Expect(pipeline.Recognize(grid, 256, 32, nullptr, result, error), "grid recognized: " + error.message);
+    check.Equal(result.text, line, "grid text at y=" + std::to_string(y));
+    if (result.blocks.size() == 1) {
+      check.Box(result.blocks[0].boundingBox, 180, y, Width(line), kGlyphHeight, "grid line box");
+    }
+  }
+}
+
+// The same merge without the pool: tile-relative boxes move by their tile,
+// and a tile that failed counts as empty.
+void MergeMapsBoxes(Check& check) {
+  const std::vector<OcrTile> tiles = {{0, 0, 100, 100}, {80, 0, 100, 100}, {0, 80, 100, 100}};
+  std::vector<OcrResult> results(3);
+  OcrBlock block;
+  block.text = "mapped";
+  block.boundingBox = {30, 40, 48, 10};
+  block.hasBoundingBox = true;
+  results[1].blocks.push_back(block);
+  results[1].text = "mapped";
+  block.text = "below";
+  block.boundingBox = {5, 60, 40, 10};
+  results[2].blocks.push_back(block);
+  results[2].text = "below";
+  std::vector<OcrError> errors(3);
+  errors[0].code = "ERR_OCR_RECOGNIZE_FAILED";
+  const std::vector<char> succeeded = {0, 1, 1};
+
+  OcrResult merged;
+  OcrError error;
+  check.Expect(MergeOcrTiles(tiles, results, errors, succeeded, merged, error), "merged: " + error.message);
+  check.Equal(merged.text, std::string("mapped\nbelow"), "text");
+  if (merged.blocks.size() == 2) {
+    check.Box(merged.blocks[0].boundingBox, 110, 40, 48, 10, "first tile offset");
+    check.Box(merged.blocks[1].boundingBox, 5, 140, 40, 10, "second tile offset");
+  } else {
+    check.Equal<size_t>(merged.blocks.size(), 2, "blocks");
+  }
+}
+
+// One line of three changes between frames: the session plans a region
+// spanning that whole line and nothing else, the engine reads only that
+// region, and the other two lines are carried over as they were.
+void FrameWithOneChangedLine(Check& check) {
+  Page page(400, 120);
+  page.Paint(20, 20, "first line stays");
+  page.Paint(20, 55, "middle line is old");
+  page.Paint(20, 90, "last line stays");
+
+  Pipeline pipeline;
+  auto session = std::make_shared<OcrSession>();
+  OcrResult first;
+  OcrError error;
+  check.Expect(pipeline.Recognize(page, 0, 0, session, first, error), "first frame: " + error.message);
+  check.Equal(first.text, std::string("first line stays\nmiddle line is old\nlast line stays"), "first frame text");
+  check.Expect(first.incremental.full, "first frame recognized whole");
+  const uint64_t fullPixels = pipeline.pixels.exchange(0);
+
+  // Only the last word changes, yet the whole line is read again.
+  const Page before = page;
+  const uint32_t word = 20 + Advance("middle line is ");
+  page.Erase(word, 55, Advance("old"), kGlyphHeight);
+  page.Paint(word, 55, "new");
+  OcrSession probe;
+  probe.Commit(before.image(), "", first);
+  OcrSessionPlan plan;
+  probe.Plan(page.image(), "", plan);
+  check.Expect(!plan.full, "second frame planned incrementally");
+  check.Equal<size_t>(plan.regions.size(), 1, "regions");
+  if (plan.regions.size() == 1) {
+    const OcrTile& region = plan.regions[0];
+    check.Expect(region.x <= 20 && region.x + region.width >= 20 + Width("middle line is new"),
+                 "region spans the whole changed line");
+    check.Expect(region.y > 20 + kGlyphHeight && region.y + region.height < 90, "region stays off the other lines");
+  }
+
+  // A mark where there was no text is planned on its own, padded by half a
+  // diff square.
+  Page marked = before;
+  marked.Paint(350, 100, "x");
+  OcrSessionPlan markPlan;
+  probe.Plan(marked.image(), "", markPlan);
+  check.Equal<size_t>(markPlan.regions.size(), 1, "regions for a new mark");
+  if (markPlan.regions.size() == 1) {
+    const OcrTile& region = markPlan.regions[0];
+    check.Expect(region.x <= 350 && region.x + region.width >= 350 + kGlyphWidth && region.y <= 100 &&
+                     region.y + region.height >= 100 + kGlyphHeight,
+                 "region covers the mark");
+    check.Expect(region.width <= 48 && region.height <= 32, "region stays near the mark");
+  }
+
+  OcrResult second;
+  check.Expect(pipeline.Recognize(page, 0, 0, session, second, error), "second frame: " + error.message);
+  check.Equal(second.text, std::string("first line stays\nmiddle line is new\nlast line stays"), "second frame text");
+  check.Expect(!second.incremental.full, "second frame recognized by region");
+  check.Equal(second.incremental.regions, 1u, "second frame regions");
+  check.Equal(second.incremental.reusedBlocks, 2u, "lines carried over");
+  const uint64_t incrementalPixels = pipeline.pixels.exchange(0);
+  check.Expect(incrementalPixels > 0 && incrementalPixels * 2 < fullPixels, "region costs a fraction of the frame");
+  if (second.blocks.size() == 3) {
+    check.Box(second.blocks[0].boundingBox, 20, 20, Width("first line stays"), kGlyphHeight, "kept line box");
+    check.Box(second.blocks[1].boundingBox, 20, 55, Width("middle line is new"), kGlyphHeight, "spliced line box");
+    check.Equal(second.blocks[2].text, first.blocks[2].text, "kept line text");
+  } else {
+    check.Equal<size_t>(second.blocks.size(), 3, "second frame blocks");
+  }
+
+  OcrResult third;
+  check.Expect(pipeline.Recognize(page, 0, 0, session, third, error), "third frame: " + error.message);
+  check.Equal(third.text, second.text, "unchanged frame text");
+  check.Equal(third.incremental.regions, 0u, "unchanged frame regions");
+  check.Equal<uint64_t>(pipeline.pixels.load(), 0, "pixels read for an unchanged frame");
+}
+
+// Splice keeps the lines no region touches exactly as they were, drops the
+// ones a region covers, and adds what the regions read in frame
+// coordinates.
+void SpliceReusesUntouchedLines(Check& check) {
+  Page page(300, 100);
+  page.Paint(10, 10, "keep me");
+  page.Paint(10, 50, "replace me");
+  OcrResult previous;
+  OcrError error;
+  std::atomic<uint64_t> pixels{0};
+  GlyphEngine engine(pixels);
+  OcrOptions options;
+  options.image = page.image();
+  check.Expect(engine.Recognize(options, previous, error), "previous frame: " + error.message);
+  if (previous.blocks.size() != 2) {
+    check.Equal<size_t>(previous.blocks.size(), 2, "previous frame blocks");
+    return;
+  }
+  previous.blocks[0].confidence = 0.5;
+
+  OcrSession session;
+  session.Commit(page.image(), "", previous);
+  OcrSessionPlan plan;
+  plan.full = false;
+  plan.regions.push_back({0, 40, 300, 30});
+  std::vector<OcrResult> results(1);
+  OcrBlock block;
+  block.text = "replaced";
+  block.boundingBox = {10, 10, Width("replaced"), kGlyphHeight};
+  block.hasBoundingBox = true;
+  results[0].blocks.push_back(block);
+  results[0].text = block.text;
+  const std::vector<OcrError> errors(1);
+  const std::vector<char> succeeded = {1};
+
+  OcrResult spliced;
+  check.Expect(session.Splice(plan, results, errors, succeeded, spliced, error), "spliced: " + error.message);
+  check.Equal(spliced.text, std::string("keep me\nreplaced"), "text");
+  check.Equal(spliced.incremental.reusedBlocks, 1u, "reused blocks");
+  if (spliced.blocks.size() == 2) {
+    check.Equal(spliced.blocks[0].confidence, 0.5, "kept line untouched");
+    check.Box(spliced.blocks[1].boundingBox, 10, 50, Width("replaced"), kGlyphHeight, "region line in frame");
+  } else {
+    check.Equal<size_t>(spliced.blocks.size(), 2, "blocks");
+  }
+}
+
+struct Scenario {
+  const char* name;
+  void (*run)(Check&);
+};
+
+constexpr Scenario kScenarios[] = {
+    {"plan-tiles", PlanTiles},
+    {"line-cut-at-seam", LineCutAtSeam},
+    {"line-seen-twice", LineSeenTwice},
+    {"merge-maps-boxes", MergeMapsBoxes},
+    {"frame-with-one-changed-line", FrameWithOneChangedLine},
+    {"splice-reuses-untouched-lines", SpliceReusesUntouchedLines},
+};
+
+} // namespace
+
+} // namespace tuff::native
+
+int main(int argc, char** argv) {
+  using tuff::native::kScenarios;
+  int failed = 0;
+  size_t ran = 0;
+  for (const auto& scenario : kScenarios) {
+    if (argc > 1 && std::strcmp(argv[1], scenario.name) != 0) {
+      continue;
+    }
+    tuff::native::Check check;
+    scenario.run(check);
+    failed |= check.Report(scenario.name);
+    ++ran;
+  }
+  if (ran == 0) {
+    std::printf("no scenario named %s\n", argv[1]);
+    return 2;
+  }
+  return failed;
+}
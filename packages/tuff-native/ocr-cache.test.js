@@ -0,0 +1,59 @@
+'use strict'
+
+const assert = require('node:assert/strict')
+const { Buffer } = require('node:buffer')
+const fs = require('node:fs')
+const os = require('node:os')
+const path = require('node:path')
+const test = require('node:test')
+
+const { clearOcrCache, configureOcrCache, getOcrCacheStats } = require('./index.js')
+
+const skip = getOcrCacheStats() === null
+
+test('perceptual matching is off until asked for', { skip }, () => {
+  assert.equal(getOcrCacheStats().perceptual, false)
+})
+
+test('configureOcrCache keeps omitted settings and reports the result', { skip }, () => {
+  const before = getOcrCacheStats()
+  try {
+    const stats = configureOcrCache({ maxBytes: 1024 * 1024, perceptualMaxDistance: 8 })
+    assert.equal(stats.maxBytes, 1024 * 1024)
+    assert.equal(stats.perceptualMaxDistance, 8)
+    assert.equal(stats.perceptual, before.perceptual)
+    assert.equal(stats.maxDiskBytes, before.maxDiskBytes)
+    assert.equal(stats.directory, undefined)
+    for (const key of ['hits', 'misses', 'perceptualHits', 'diskHits', 'entries', 'bytes']) {
+      assert.equal(typeof stats[key], 'number', key)
+    }
+  }
+  finally {
+    configureOcrCache(before)
+  }
+})
+
+test('a cache directory is created, measured and emptied by clearOcrCache', { skip }, () => {
+  const before = getOcrCacheStats()
+  const directory = path.join(fs.mkdtempSync(path.join(os.tmpdir(), 'tuff-ocr-cache-')), 'results')
+  try {
+    let stats = configureOcrCache({ directory })
+    assert.equal(stats.directory, directory)
+    assert.ok(fs.statSync(directory).isDirectory())
+    assert.equal(stats.diskBytes, 0)
+
+    fs.writeFileSync(path.join(directory, '0123456789abcdef.ocr'), Buffer.alloc(100))
+    fs.writeFileSync(path.join(directory, 'notes.txt'), 'not ours')
+    stats = configureOcrCache({ directory })
+    assert.equal(stats.diskBytes, 100)
+
+    clearOcrCache()
+    assert.deepEqual(fs.readdirSync(directory), ['notes.txt'])
+    assert.equal(getOcrCacheStats().entries, 0)
+    assert.equal(getOcrCacheStats().diskBytes, 0)
+  }
+  finally {
+    configureOcrCache({ ...before, directory: null })
+    fs.rmSync(path.dirname(directory), { recursive: true, force: true })
+  }
+})
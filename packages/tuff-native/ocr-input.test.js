@@ -0,0 +1,37 @@
+'use strict'
+
+const assert = require('node:assert/strict')
+const test = require('node:test')
+const { Worker } = require('node:worker_threads')
+
+const { getOcrCacheStats, recognizeImageText } = require('./index.js')
+
+const skip = getOcrCacheStats() === null
+
+test('a worker terminated while its Buffers are being read tears down cleanly', { skip }, async () => {
+  // Pixel arrays and Buffers are read in place on the OCR threads; the
+  // worker's environment must not go away under a recognition still reading.
+  const worker = new Worker(
+    `const { parentPort, workerData } = require('node:worker_threads')
+const { recognizeImageText } = require(workerData.modulePath)
+const size = 1024
+for (let i = 0; i < 8; i += 1) {
+  const pixels = new Uint8Array(size * size).fill(i * 16)
+  recognizeImageText({ pixels, pixelFormat: 'gray', width: size, height: size })
+    .catch(() => {})
+}
+parentPort.postMessage('submitted')
+`,
+    { eval: true, workerData: { modulePath: require.resolve('./index.js') } },
+  )
+  await new Promise((resolve, reject) => {
+    worker.once('message', resolve)
+    worker.once('error', reject)
+  })
+  await worker.terminate()
+
+  // The OCR threads are shared with this thread and still serve it.
+  const page = { pixels: new Uint8Array(64 * 64), pixelFormat: 'gray', width: 64, height: 64 }
+  const settled = await recognizeImageText(page).then(() => true, () => true)
+  assert.equal(settled, true)
+})
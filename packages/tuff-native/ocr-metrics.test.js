@@ -0,0 +1,74 @@
+'use strict'
+
+const assert = require('node:assert/strict')
+const test = require('node:test')
+
+const {
+  configureNativeMetrics,
+  drainNativeTraceSpans,
+  getNativeMetrics,
+  getNativeOcrSupport,
+  recognizeImageText,
+} = require('./index.js')
+
+const skip = getNativeMetrics() === null
+
+test('configureNativeMetrics keeps omitted settings and tracing implies timing', { skip }, () => {
+  const before = getNativeMetrics()
+  try {
+    let metrics = configureNativeMetrics({ enabled: false, traceCapacity: 0 })
+    assert.equal(metrics.enabled, false)
+    assert.equal(metrics.tracing, false)
+
+    metrics = configureNativeMetrics({ traceCapacity: 64 })
+    assert.equal(metrics.enabled, true)
+    assert.equal(metrics.tracing, true)
+    assert.equal(metrics.traceCapacity, 64)
+
+    metrics = configureNativeMetrics({ reset: true })
+    assert.equal(metrics.traceCapacity, 64)
+    assert.equal(metrics.stages.recognize.count, 0)
+    for (const key of ['count', 'totalMs', 'maxMs', 'p50Ms', 'p95Ms', 'p99Ms']) {
+      assert.equal(typeof metrics.stages.total[key], 'number', key)
+    }
+    for (const key of ['interactive', 'background', 'busyThreads', 'threads']) {
+      assert.equal(typeof metrics.queues[key], 'number', key)
+    }
+  }
+  finally {
+    configureNativeMetrics({ enabled: before.enabled, traceCapacity: before.traceCapacity })
+  }
+})
+
+test('a pool job is timed per stage and traced', { skip: skip || !getNativeOcrSupport().supported }, async () => {
+  const before = getNativeMetrics()
+  try {
+    configureNativeMetrics({ traceCapacity: 256, reset: true })
+    drainNativeTraceSpans()
+
+    // A blank page stops at text detection, so this needs no engine.
+    const page = { pixels: new Uint8Array(256 * 256), pixelFormat: 'gray', width: 256, height: 256 }
+    await assert.rejects(recognizeImageText({ ...page, textDetection: true }), { code: 'ERR_OCR_NO_TEXT' })
+
+    const metrics = getNativeMetrics()
+    for (const stage of ['queueWait', 'preprocess', 'textDetection', 'marshal', 'total']) {
+      assert.equal(metrics.stages[stage].count, 1, stage)
+    }
+    assert.equal(metrics.stages.recognize.count, 0)
+    assert.equal(metrics.counters.failed, 1)
+    assert.ok(metrics.stages.total.p99Ms >= metrics.stages.textDetection.p50Ms)
+
+    const { spans, dropped } = drainNativeTraceSpans()
+    assert.equal(dropped, 0)
+    // cacheLookup as well while the result cache is on.
+    assert.deepEqual(
+      spans.map(span => span.stage).filter(stage => stage !== 'cacheLookup'),
+      ['queueWait', 'preprocess', 'textDetection', 'total', 'marshal'],
+    )
+    assert.ok(Math.abs(spans[0].startedAt - Date.now()) < 60_000)
+    assert.deepEqual(drainNativeTraceSpans().spans, [])
+  }
+  finally {
+    configureNativeMetrics({ enabled: before.enabled, traceCapacity: before.traceCapacity })
+  }
+})
@@ -0,0 +1,33 @@
+'use strict'
+
+const assert = require('node:assert/strict')
+const { spawnSync } = require('node:child_process')
+const path = require('node:path')
+const process = require('node:process')
+const test = require('node:test')
+
+// Runs the scenarios of native/test/ocr_pipeline_test.cc: tiling, tile
+// merging and incremental sessions through the engine pool, on synthetic
+// pages read by a stub engine. Needs a C++ compiler, not an OCR engine.
+const build = spawnSync(process.execPath, [path.join(__dirname, 'scripts', 'build-native-tests.js')], {
+  encoding: 'utf8',
+})
+const binary = build.status === 0 ? build.stdout.trim().split('\n').pop() : null
+
+test('builds the native OCR pipeline checks', () => {
+  assert.equal(build.status, 0, build.stderr || build.error?.message)
+})
+
+for (const scenario of [
+  'plan-tiles',
+  'line-cut-at-seam',
+  'line-seen-twice',
+  'merge-maps-boxes',
+  'frame-with-one-changed-line',
+  'splice-reuses-untouched-lines',
+]) {
+  test(scenario, { skip: binary === null }, () => {
+    const run = spawnSync(binary, [scenario], { encoding: 'utf8' })
+    assert.equal(run.status, 0, run.stdout || run.stderr || run.error?.message)
+  })
+}
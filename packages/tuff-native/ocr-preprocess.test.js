@@ -0,0 +1,96 @@
+'use strict'
+
+const assert = require('node:assert/strict')
+const { Buffer } = require('node:buffer')
+const test = require('node:test')
+
+const { preprocessOcrImage } = require('./index.js')
+
+function preprocessAvailable() {
+  try {
+    preprocessOcrImage({ pixels: new Uint8Array(1), pixelFormat: 'gray', width: 1, height: 1, preprocess: {} })
+    return true
+  }
+  catch {
+    return false
+  }
+}
+
+const skip = !preprocessAvailable()
+
+// White BGRA page with 20 px tall rows of dark dashes, rising by `degrees`.
+function textPage(width, height, degrees = 0) {
+  const pixels = Buffer.alloc(width * height * 4, 255)
+  const slope = Math.tan((degrees * Math.PI) / 180)
+  for (let y = 0; y < height; y += 1) {
+    for (let x = 0; x < width; x += 1) {
+      const base = y - (x - width / 2) * slope
+      const line = Math.floor(base / 50)
+      const inLine = base - line * 50
+      if (line >= 1 && line <= 6 && inLine < 20 && x > 40 && x < width - 40 && Math.floor(x / 7) % 3 !== 0) {
+        pixels.fill(20, (y * width + x) * 4, (y * width + x) * 4 + 3)
+      }
+    }
+  }
+  return { pixels, pixelFormat: 'bgra', width, height }
+}
+
+test('crop and grayscale return a gray view of the region', { skip }, () => {
+  const page = textPage(200, 120)
+  const out = preprocessOcrImage({
+    ...page,
+    preprocess: { crop: { x: 10, y: 20, width: 50, height: 400 }, grayscale: true },
+  })
+  assert.equal(out.pixelFormat, 'gray')
+  assert.equal(out.width, 50)
+  assert.equal(out.height, 100)
+  assert.equal(out.stride, 50)
+  assert.equal(out.pixels[0], 255)
+  assert.equal(out.report.width, 50)
+  assert.equal(out.report.scale, 1)
+})
+
+test('downscales to the target text height and never upscales', { skip }, () => {
+  const page = textPage(400, 360)
+  const down = preprocessOcrImage({ ...page, preprocess: { targetTextHeight: 10 } })
+  assert.equal(down.pixelFormat, 'bgra')
+  assert.ok(down.report.scale > 0.4 && down.report.scale < 0.6, `scale ${down.report.scale}`)
+  assert.equal(down.width, Math.round(400 * down.report.scale))
+
+  const hinted = preprocessOcrImage({ ...page, preprocess: { targetTextHeight: 10, textHeightHint: 40 } })
+  assert.equal(hinted.width, 100)
+  assert.equal(hinted.height, 90)
+
+  const same = preprocessOcrImage({ ...page, preprocess: { targetTextHeight: 40 } })
+  assert.equal(same.width, 400)
+  assert.equal(same.report.scale, 1)
+})
+
+test('binarize leaves only ink and paper, dark text on light', { skip }, () => {
+  const page = textPage(300, 200)
+  // Light text on a dark background comes out the same way round.
+  for (let i = 0; i < page.pixels.length; i += 1) {
+    page.pixels[i] = 255 - page.pixels[i]
+  }
+  const out = preprocessOcrImage({ ...page, preprocess: { binarize: true } })
+  assert.equal(out.pixelFormat, 'gray')
+  assert.ok(out.pixels.every(value => value === 0 || value === 255))
+  assert.equal(out.pixels[0], 255)
+  assert.equal(out.pixels[60 * 300 + 50], 0)
+})
+
+test('deskew finds and corrects the skew of the text lines', { skip }, () => {
+  const out = preprocessOcrImage({ ...textPage(500, 400, 3), preprocess: { binarize: true, deskew: true } })
+  assert.ok(Math.abs(Math.abs(out.report.skewAngle) - 3) <= 0.3, `skew ${out.report.skewAngle}`)
+  assert.ok(out.report.durationsMs.deskew >= 0)
+
+  const level = preprocessOcrImage({ ...textPage(500, 400), preprocess: { deskew: true } })
+  assert.equal(level.report.skewAngle, 0)
+})
+
+test('rejects a crop outside the image', { skip }, () => {
+  assert.throws(
+    () => preprocessOcrImage({ ...textPage(40, 40), preprocess: { crop: { x: 50, y: 0, width: 5, height: 5 } } }),
+    { code: 'ERR_OCR_INVALID_CROP' },
+  )
+})
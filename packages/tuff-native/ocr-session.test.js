@@ -0,0 +1,35 @@
+'use strict'
+
+const assert = require('node:assert/strict')
+const test = require('node:test')
+
+const { createOcrSession, getOcrCacheStats } = require('./index.js')
+
+// Covers what runs without an engine: option checks, stats and close.
+const skip = getOcrCacheStats() === null
+
+const frame = { pixels: new Uint8Array(64 * 64), pixelFormat: 'gray', width: 64, height: 64 }
+
+test('rejects diff options out of range', { skip }, () => {
+  assert.throws(() => createOcrSession({}, { blockSize: 2 }), { name: 'TypeError', message: /blockSize/ })
+  assert.throws(() => createOcrSession({}, { tolerance: 300 }), { name: 'TypeError', message: /tolerance/ })
+  assert.throws(() => createOcrSession({}, { maxChangedFraction: 'half' }), { name: 'TypeError' })
+})
+
+test('a new session has seen no frames', { skip }, () => {
+  const session = createOcrSession({ languageHint: 'en' }, { blockSize: 32 })
+  const stats = session.getStats()
+  for (const key of ['frames', 'fullFrames', 'unchangedFrames', 'incrementalFrames', 'regions', 'reusedBlocks']) {
+    assert.equal(stats[key], 0, key)
+  }
+  assert.equal(stats.closed, false)
+  session.reset()
+  session.close()
+})
+
+test('a closed session rejects frames', { skip }, async () => {
+  const session = createOcrSession()
+  session.close()
+  await assert.rejects(session.recognize(frame), { code: 'ERR_OCR_SESSION_CLOSED' })
+  assert.equal(session.getStats().closed, true)
+})
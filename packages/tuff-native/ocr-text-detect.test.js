@@ -0,0 +1,102 @@
+'use strict'
+
+const assert = require('node:assert/strict')
+const { Buffer } = require('node:buffer')
+const test = require('node:test')
+
+const { detectImageText, getNativeOcrSupport, getOcrCacheStats, recognizeImageText } = require('./index.js')
+
+const skip = getOcrCacheStats() === null
+
+// White gray page with lines of 14 px glyphs: rings, bars and arches, in words.
+function glyphPage(width, height) {
+  const pixels = Buffer.alloc(width * height, 255)
+  const ink = (x, y) => {
+    if (x >= 0 && y >= 0 && x < width && y < height) {
+      pixels[y * width + x] = 30
+    }
+  }
+  const glyphs = [
+    (x, y) => {
+      for (let t = 0; t < 360; t += 2) {
+        const a = (t * Math.PI) / 180
+        for (let r = 5; r < 7; r += 0.5) {
+          ink(x + 6 + Math.round(r * Math.cos(a)), y + 7 + Math.round(r * 1.1 * Math.sin(a)))
+        }
+      }
+    },
+    (x, y) => {
+      for (let j = 0; j < 16; j += 1) {
+        ink(x, y + j - 2)
+        ink(x + 1, y + j - 2)
+      }
+    },
+    (x, y) => {
+      for (let j = 0; j < 14; j += 1) {
+        ink(x, y + j)
+        ink(x + 1, y + j)
+        ink(x + 9, y + j)
+        ink(x + 10, y + j)
+      }
+      for (let i = 0; i < 11; i += 1) {
+        ink(x + i, y)
+        ink(x + i, y + 1)
+      }
+    },
+  ]
+  for (let line = 0; line * 30 + 40 < height; line += 1) {
+    let x = 20
+    for (let k = 0; x + 14 < width - 20; k += 1) {
+      glyphs[(k * 7 + line) % 3](x, line * 30 + 20)
+      x += k % 5 === 4 ? 20 : 15
+    }
+  }
+  return { pixels, pixelFormat: 'gray', width, height }
+}
+
+// A gradient with a few bright discs: edges, but nothing shaped or lined up like text.
+function shapesPage(width, height) {
+  const pixels = Buffer.alloc(width * height)
+  for (let y = 0; y < height; y += 1) {
+    for (let x = 0; x < width; x += 1) {
+      let value = 60 + ((x + y) * 120) / (width + height)
+      for (const [cx, cy, r] of [[80, 60, 40], [220, 150, 60], [320, 50, 25]]) {
+        if ((x - cx) ** 2 + (y - cy) ** 2 < r * r) {
+          value = 220
+        }
+      }
+      pixels[y * width + x] = value
+    }
+  }
+  return { pixels, pixelFormat: 'gray', width, height }
+}
+
+test('scores lines of glyphs high and shapes without text zero', { skip }, () => {
+  const text = detectImageText(glyphPage(400, 200))
+  assert.ok(text.score > 0.9, `score ${text.score}`)
+  assert.ok(text.lines >= 6, `lines ${text.lines}`)
+
+  const shapes = detectImageText(shapesPage(400, 200))
+  assert.equal(shapes.score, 0)
+  assert.equal(shapes.glyphs, 0)
+
+  const blank = detectImageText({ pixels: new Uint8Array(64 * 64), pixelFormat: 'gray', width: 64, height: 64 })
+  assert.equal(blank.score, 0)
+})
+
+test('rejects thresholds outside 0..1', { skip }, async () => {
+  const page = shapesPage(64, 64)
+  await assert.rejects(
+    recognizeImageText({ ...page, textDetection: { threshold: 2 } }),
+    { name: 'TypeError', message: /textDetection\.threshold must be between 0 and 1/ },
+  )
+  await assert.rejects(recognizeImageText({ ...page, textDetection: 'yes' }), { name: 'TypeError' })
+})
+
+test('fails images without text as ERR_OCR_NO_TEXT unless forced', { skip: skip || !getNativeOcrSupport().supported }, async () => {
+  const page = shapesPage(400, 200)
+  await assert.rejects(recognizeImageText({ ...page, textDetection: true }), { code: 'ERR_OCR_NO_TEXT' })
+  // The engine gets to decide; whatever it finds, the check did not stop it.
+  const forced = await recognizeImageText({ ...page, textDetection: { force: true } }).then(() => null, error => error)
+  assert.notEqual(forced?.code, 'ERR_OCR_NO_TEXT')
+})
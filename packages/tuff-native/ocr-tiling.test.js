@@ -0,0 +1,24 @@
+'use strict'
+
+const assert = require('node:assert/strict')
+const test = require('node:test')
+
+const { getOcrCacheStats, recognizeImageText } = require('./index.js')
+
+// Options are checked before anything is queued, so this runs wherever the
+// binding is built, engine or not.
+const skip = getOcrCacheStats() === null
+
+const page = { pixels: new Uint8Array(64 * 64), pixelFormat: 'gray', width: 64, height: 64 }
+
+test('rejects tile sizes too small to hold a line of text', { skip }, async () => {
+  await assert.rejects(
+    recognizeImageText({ ...page, tiling: { tileSize: 100 } }),
+    { name: 'TypeError', message: /tiling\.tileSize must be 0 or an integer between 256 and 32768/ },
+  )
+  await assert.rejects(
+    recognizeImageText({ ...page, tiling: { overlap: 1.5 } }),
+    { name: 'TypeError', message: /tiling\.overlap must be an integer between 0 and 32768/ },
+  )
+  await assert.rejects(recognizeImageText({ ...page, tiling: 512 }), { name: 'TypeError' })
+})
@@ -0,0 +1,208 @@
+'use strict'
+
+const { spawnSync } = require('node:child_process')
+const fs = require('node:fs')
+const os = require('node:os')
+const path = require('node:path')
+const process = require('node:process')
+
+const { loadNativeBinding } = require('../native-loader')
+
+const packageRoot = path.resolve(__dirname, '..')
+const DEFAULT_MIN_TIME_MS = 200
+const DEFAULT_TOLERANCE = 0.15
+// Rows the SDK stand-in returns per query; Everything's own cap.
+const STUB_RESULT_COUNT = 5000
+
+function parseArgs(argv) {
+  const args = {
+    filter: '',
+    minTimeMs: DEFAULT_MIN_TIME_MS,
+    outputPath: null,
+    baselinePath: null,
+    tolerance: DEFAULT_TOLERANCE,
+  }
+
+  for (let i = 0; i < argv.length; i += 1) {
+    const token = argv[i]
+    if (token === '--')
+      continue
+
+    if (token === '--filter' && argv[i + 1] !== undefined) {
+      args.filter = argv[i + 1]
+      i += 1
+      continue
+    }
+    if (token === '--min-time' && argv[i + 1] !== undefined) {
+      const parsed = Number.parseFloat(argv[i + 1])
+      if (Number.isFinite(parsed) && parsed > 0)
+        args.minTimeMs = parsed
+      i += 1
+      continue
+    }
+    if (token === '--tolerance' && argv[i + 1] !== undefined) {
+      const parsed = Number.parseFloat(argv[i + 1])
+      if (Number.isFinite(parsed) && parsed >= 0)
+        args.tolerance = parsed
+      i += 1
+      continue
+    }
+    if (token === '--baseline' && argv[i + 1]) {
+      args.baselinePath = path.resolve(argv[i + 1])
+      i += 1
+      continue
+    }
+    if (token === '--output' && argv[i + 1]) {
+      args.outputPath = path.resolve(argv[i + 1])
+      i += 1
+    }
+  }
+
+  return args
+}
+
+/**
+ * Results slower per item than the baseline's result of the same name by
+ * more than `tolerance` (0.15 = 15%). Benchmarks missing from either side,
+ * or skipped, are not compared.
+ */
+function compareToBaseline(results, baselineResults, tolerance) {
+  const baseline = new Map()
+  for (const result of baselineResults || []) {
+    if (result && typeof result.nsPerItem === 'number' && result.nsPerItem > 0)
+      baseline.set(result.name, result.nsPerItem)
+  }
+
+  let compared = 0
+  const regressions = []
+  for (const result of results) {
+    const baselineNsPerItem = baseline.get(result.name)
+    if (typeof result.nsPerItem !== 'number' || baselineNsPerItem === undefined)
+      continue
+    compared += 1
+    const ratio = result.nsPerItem / baselineNsPerItem
+    if (ratio > 1 + tolerance) {
+      regressions.push({
+        name: result.name,
+        nsPerItem: result.nsPerItem,
+        baselineNsPerItem,
+        ratio,
+      })
+    }
+  }
+  return { compared, regressions }
+}
+
+function writeSummary(summary, outputPath) {
+  const serialized = `${JSON.stringify(summary, null, 2)}\n`
+  process.stdout.write(serialized)
+  if (!outputPath)
+    return
+  fs.mkdirSync(path.dirname(outputPath), { recursive: true })
+  fs.writeFileSync(outputPath, serialized, 'utf8')
+}
+
+// Builds fixtures/everything-sdk-stub when it is missing; its compiler
+// output goes to stderr so stdout stays JSON.
+function ensureEverythingStub() {
+  const libraryName
+    = process.platform === 'win32'
+      ? 'everything_sdk_stub.dll'
+      : process.platform === 'darwin'
+        ? 'libeverything_sdk_stub.dylib'
+        : 'libeverything_sdk_stub.so'
+  const libraryPath = path.join(packageRoot, 'build', 'fixtures', libraryName)
+  if (!fs.existsSync(libraryPath)) {
+    spawnSync(process.execPath, [path.join(__dirname, 'build-everything-stub.js')], {
+      cwd: packageRoot,
+      stdio: ['ignore', 2, 'inherit'],
+      env: process.env,
+    })
+  }
+  return fs.existsSync(libraryPath) ? libraryPath : null
+}
+
+function describeHost() {
+  const cpus = os.cpus()
+  return {
+    platform: process.platform,
+    arch: process.arch,
+    node: process.versions.node,
+    cpu: cpus.length > 0 ? cpus[0].model : null,
+    cpuCount: cpus.length,
+  }
+}
+
+function main() {
+  const options = parseArgs(process.argv.slice(2))
+
+  // Read by the SDK loader and the stand-in when the benchmarks first query.
+  // An SDK named explicitly is benchmarked as it is.
+  if (!process.env.TALEX_EVERYTHING_DLL_PATH) {
+    const stubPath = ensureEverythingStub()
+    if (stubPath) {
+      process.env.TALEX_EVERYTHING_DLL_PATH = stubPath
+      process.env.TALEX_EVERYTHING_STUB_RESULTS = String(STUB_RESULT_COUNT)
+    }
+  }
+
+  const { nativeBinding, loadError } = loadNativeBinding({
+    baseDir: packageRoot,
+    moduleName: 'tuff_native_bench',
+    expectedExports: ['run'],
+  })
+  if (!nativeBinding) {
+    writeSummary(
+      {
+        schema: 'tuff-native-bench/v1',
+        ok: false,
+        ...describeHost(),
+        error: loadError instanceof Error ? loadError.message : String(loadError),
+        hint: 'Build it with `pnpm -C packages/tuff-native build:bench`.',
+      },
+      options.outputPath,
+    )
+    process.exitCode = 1
+    return
+  }
+
+  const { minTimeMs, results } = nativeBinding.run({
+    filter: options.filter,
+    minTimeMs: options.minTimeMs,
+  })
+
+  let baseline = null
+  if (options.baselinePath) {
+    const previous = JSON.parse(fs.readFileSync(options.baselinePath, 'utf8'))
+    baseline = {
+      path: options.baselinePath,
+      tolerance: options.tolerance,
+      ...compareToBaseline(results, previous.results, options.tolerance),
+    }
+  }
+
+  writeSummary(
+    {
+      schema: 'tuff-native-bench/v1',
+      ok: !baseline || baseline.regressions.length === 0,
+      ...describeHost(),
+      minTimeMs,
+      results,
+      baseline,
+    },
+    options.outputPath,
+  )
+  if (baseline && baseline.regressions.length > 0)
+    process.exitCode = 1
+}
+
+module.exports = {
+  DEFAULT_TOLERANCE,
+  compareToBaseline,
+  parseArgs,
+  writeSummary,
+}
+
+if (require.main === module) {
+  main()
+}
@@ -0,0 +1,123 @@
+const assert = require('node:assert/strict')
+const { spawnSync } = require('node:child_process')
+const fs = require('node:fs')
+const os = require('node:os')
+const path = require('node:path')
+const test = require('node:test')
+
+const {
+  DEFAULT_TOLERANCE,
+  compareToBaseline,
+  parseArgs,
+} = require('./bench-native.js')
+
+const packageRoot = path.resolve(__dirname, '..')
+
+test('parses filter, timing and baseline options and ignores bad numbers', () => {
+  const options = parseArgs([
+    '--filter',
+    'everything.',
+    '--min-time',
+    '50',
+    '--baseline',
+    'bench/baseline.json',
+    '--tolerance',
+    'fast',
+  ])
+
+  assert.equal(options.filter, 'everything.')
+  assert.equal(options.minTimeMs, 50)
+  assert.equal(options.baselinePath, path.resolve('bench/baseline.json'))
+  assert.equal(options.tolerance, DEFAULT_TOLERANCE)
+  assert.equal(options.outputPath, null)
+})
+
+test('flags only results slower per item than the baseline beyond tolerance', () => {
+  const { compared, regressions } = compareToBaseline(
+    [
+      { name: 'ocr.toJsResult.objects', nsPerItem: 130 },
+      { name: 'everything.toJsRows.all', nsPerItem: 410 },
+      { name: 'everything.query', skipped: 'TALEX_EVERYTHING_DLL_PATH is not set' },
+      { name: 'ocr.tileMerge', nsPerItem: 90 },
+    ],
+    [
+      { name: 'ocr.toJsResult.objects', nsPerItem: 100 },
+      { name: 'everything.toJsRows.all', nsPerItem: 400 },
+      { name: 'everything.query', nsPerItem: 1200 },
+    ],
+    0.1,
+  )
+
+  assert.equal(compared, 2)
+  assert.deepEqual(regressions.map(regression => regression.name), ['ocr.toJsResult.objects'])
+  assert.ok(Math.abs(regressions[0].ratio - 1.3) < 1e-9)
+})
+
+test('writes the run as JSON and fails against a faster baseline', () => {
+  const directory = fs.mkdtempSync(path.join(os.tmpdir(), 'bench-native-test-'))
+  const preloadPath = path.join(directory, 'fake-bench.js')
+  const baselinePath = path.join(directory, 'baseline.json')
+  const outputPath = path.join(directory, 'nested', 'run.json')
+  const addonPath = path.join(packageRoot, 'build/Release', 'tuff_native_bench.node')
+
+  fs.writeFileSync(
+    preloadPath,
+    `const Module = require('node:module')
+const originalLoad = Module._load
+const addonPath = ${JSON.stringify(addonPath)}
+Module._load = function (request, parent, isMain) {
+  if (request === addonPath) {
+    return {
+      run: options => ({
+        minTimeMs: options.minTimeMs,
+        results: [{ name: 'everything.encodeColumnar', unit: 'row', items: 5000, iterations: 64, nsPerOp: 500000, minNsPerOp: 480000, nsPerItem: 100 }]
+      })
+    }
+  }
+  return originalLoad.apply(this, arguments)
+}
+`,
+    'utf8',
+  )
+  fs.writeFileSync(
+    baselinePath,
+    JSON.stringify({ results: [{ name: 'everything.encodeColumnar', nsPerItem: 50 }] }),
+    'utf8',
+  )
+
+  try {
+    const result = spawnSync(
+      process.execPath,
+      [
+        '--require',
+        preloadPath,
+        'scripts/bench-native.js',
+        '--min-time',
+        '5',
+        '--baseline',
+        baselinePath,
+        '--output',
+        outputPath,
+      ],
+      {
+        cwd: packageRoot,
+        encoding: 'utf8',
+        env: { ...process.env, TALEX_EVERYTHING_DLL_PATH: path.join(directory, 'none.so') },
+      },
+    )
+    const summary = JSON.parse(fs.readFileSync(outputPath, 'utf8'))
+
+    assert.equal(result.status, 1)
+    assert.deepEqual(JSON.parse(result.stdout), summary)
+    assert.equal(summary.schema, 'tuff-native-bench/v1')
+    assert.equal(summary.ok, false)
+    assert.equal(summary.minTimeMs, 5)
+    assert.equal(summary.platform, process.platform)
+    assert.equal(summary.results[0].nsPerItem, 100)
+    assert.equal(summary.baseline.compared, 1)
+    assert.equal(summary.baseline.regressions[0].ratio, 2)
+  }
+  finally {
+    fs.rmSync(directory, { recursive: true, force: true })
+  }
+})
@@ -0,0 +1,52 @@
+'use strict'
+
+const { spawnSync } = require('node:child_process')
+const fs = require('node:fs')
+const path = require('node:path')
+const process = require('node:process')
+
+const workspaceDir = path.resolve(__dirname, '..')
+const sourcePath = path.join(
+  workspaceDir,
+  'fixtures',
+  'everything-sdk-stub',
+  'everything_sdk_stub.cc',
+)
+const outDir = path.join(workspaceDir, 'build', 'fixtures')
+const platformLibraryName
+  = process.platform === 'win32'
+    ? 'everything_sdk_stub.dll'
+    : process.platform === 'darwin'
+      ? 'libeverything_sdk_stub.dylib'
+      : 'libeverything_sdk_stub.so'
+const outputPath = path.join(outDir, platformLibraryName)
+
+fs.mkdirSync(outDir, { recursive: true })
+
+const [command, args]
+  = process.platform === 'win32'
+    ? ['cl', ['/nologo', '/LD', '/O2', '/EHsc', '/std:c++17', sourcePath, `/Fe:${outputPath}`, `/Fo:${outDir}\\`]]
+    : [
+        process.env.CXX || 'c++',
+        [
+          '-std=c++17',
+          '-O2',
+          '-fPIC',
+          '-shared',
+          ...(process.platform === 'darwin' ? ['-dynamiclib'] : ['-pthread']),
+          sourcePath,
+          '-o',
+          outputPath,
+        ],
+      ]
+
+const result = spawnSync(command, args, {
+  cwd: workspaceDir,
+  stdio: 'inherit',
+  env: process.env,
+})
+
+if (result.status !== 0)
+  process.exit(result.status ?? 1)
+
+process.stdout.write(`${outputPath}\n`)
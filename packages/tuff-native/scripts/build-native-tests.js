@@ -0,0 +1,50 @@
+'use strict'
+
+const { spawnSync } = require('node:child_process')
+const fs = require('node:fs')
+const path = require('node:path')
+const process = require('node:process')
+
+// Builds native/test/ocr_pipeline_test.cc, a plain executable linking the
+// OCR sources that need no platform engine, and prints its path.
+const workspaceDir = path.resolve(__dirname, '..')
+const sourceDir = path.join(workspaceDir, 'native', 'src')
+const sources = [
+  path.join(workspaceDir, 'native', 'test', 'ocr_pipeline_test.cc'),
+  ...[
+    'common/image_preprocess.cc',
+    'common/native_metrics.cc',
+    'common/ocr_engine_pool.cc',
+    'common/ocr_layout.cc',
+    'common/ocr_result_cache.cc',
+    'common/ocr_session.cc',
+    'common/ocr_tiling.cc',
+    'common/text_detect.cc',
+  ].map(source => path.join(sourceDir, source)),
+]
+const outDir = path.join(workspaceDir, 'build', 'native-tests')
+const outputPath = path.join(
+  outDir,
+  process.platform === 'win32' ? 'ocr_pipeline_test.exe' : 'ocr_pipeline_test',
+)
+
+fs.mkdirSync(outDir, { recursive: true })
+
+const [command, args]
+  = process.platform === 'win32'
+    ? ['cl', ['/nologo', '/O2', '/EHsc', '/std:c++17', `/I${sourceDir}`, ...sources, `/Fe:${outputPath}`, `/Fo:${outDir}\\`]]
+    : [
+        process.env.CXX || 'c++',
+        ['-std=c++17', '-O1', '-pthread', `-I${sourceDir}`, ...sources, '-o', outputPath],
+      ]
+
+const result = spawnSync(command, args, {
+  cwd: workspaceDir,
+  stdio: ['ignore', 'inherit', 'inherit'],
+  env: process.env,
+})
+
+if (result.status !== 0)
+  process.exit(result.status ?? 1)
+
+process.stdout.write(`${outputPath}\n`)
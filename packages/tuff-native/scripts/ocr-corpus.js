@@ -0,0 +1,401 @@
+'use strict'
+
+const { spawnSync } = require('node:child_process')
+const fs = require('node:fs')
+const path = require('node:path')
+const process = require('node:process')
+
+const packageRoot = path.resolve(__dirname, '..')
+const corpusRoot = path.join(packageRoot, 'fixtures', 'ocr-corpus-v1')
+const DEFAULT_ITERATIONS = 10
+const MAX_ITERATIONS = 200
+const DEFAULT_TOLERANCES = {
+  latency: 0.25,
+  rss: 0.2,
+  accuracy: 0.02,
+}
+// Absolute slack on top of the latency tolerance, so sub-millisecond fixtures
+// do not fail on timer noise.
+const LATENCY_SLACK_MS = 1
+
+function parseTolerance(value, fallback) {
+  const parsed = Number.parseFloat(value)
+  return Number.isFinite(parsed) && parsed >= 0 ? parsed : fallback
+}
+
+// CI services set CI=true (or 1).
+function isCi(env = process.env) {
+  const value = String(env.CI || '').toLowerCase()
+  return value !== '' && value !== '0' && value !== 'false'
+}
+
+/**
+ * Whether fixtures without a baseline fail the run. `requested` is the
+ * --[no-]require-baselines flag, or null. Otherwise CI requires them once
+ * the baselines file records any fixture; until then a CI run only reports
+ * what it measured.
+ */
+function baselinesRequired(requested, baselineFixtures, env = process.env) {
+  if (requested !== null)
+    return requested
+  return isCi(env) && Object.keys(baselineFixtures || {}).length > 0
+}
+
+function parseArgs(argv) {
+  const args = {
+    iterations: DEFAULT_ITERATIONS,
+    filter: '',
+    outputPath: null,
+    baselinesPath: path.join(corpusRoot, 'baselines', `${process.platform}.json`),
+    updateBaselines: false,
+    requireBaselines: null,
+    tolerances: { ...DEFAULT_TOLERANCES },
+    worker: null,
+  }
+
+  for (let i = 0; i < argv.length; i += 1) {
+    const token = argv[i]
+    if (token === '--')
+      continue
+
+    if (token === '--iterations' && argv[i + 1] !== undefined) {
+      const parsed = Number.parseInt(argv[i + 1], 10)
+      if (Number.isFinite(parsed) && parsed > 0)
+        args.iterations = Math.min(parsed, MAX_ITERATIONS)
+      i += 1
+      continue
+    }
+    if (token === '--filter' && argv[i + 1] !== undefined) {
+      args.filter = argv[i + 1]
+      i += 1
+      continue
+    }
+    if (token === '--output' && argv[i + 1]) {
+      args.outputPath = path.resolve(argv[i + 1])
+      i += 1
+      continue
+    }
+    if (token === '--baselines' && argv[i + 1]) {
+      args.baselinesPath = path.resolve(argv[i + 1])
+      i += 1
+      continue
+    }
+    if (token === '--update-baselines') {
+      args.updateBaselines = true
+      continue
+    }
+    if (token === '--require-baselines') {
+      args.requireBaselines = true
+      continue
+    }
+    if (token === '--no-require-baselines') {
+      args.requireBaselines = false
+      continue
+    }
+    if (token === '--latency-tolerance' && argv[i + 1] !== undefined) {
+      args.tolerances.latency = parseTolerance(argv[i + 1], args.tolerances.latency)
+      i += 1
+      continue
+    }
+    if (token === '--rss-tolerance' && argv[i + 1] !== undefined) {
+      args.tolerances.rss = parseTolerance(argv[i + 1], args.tolerances.rss)
+      i += 1
+      continue
+    }
+    if (token === '--accuracy-tolerance' && argv[i + 1] !== undefined) {
+      args.tolerances.accuracy = parseTolerance(argv[i + 1], args.tolerances.accuracy)
+      i += 1
+      continue
+    }
+    if (token === '--worker' && argv[i + 1]) {
+      args.worker = argv[i + 1]
+      i += 1
+    }
+  }
+
+  return args
+}
+
+function loadManifest(root = corpusRoot) {
+  const manifest = JSON.parse(fs.readFileSync(path.join(root, 'manifest.json'), 'utf8'))
+  return manifest.fixtures.map(fixture => ({
+    ...fixture,
+    imagePath: path.join(root, fixture.image),
+    truthPath: path.join(root, fixture.truth),
+  }))
+}
+
+const UNSPACED_SCRIPT = '\\p{Script=Han}\\p{Script=Hiragana}\\p{Script=Katakana}\\p{Script=Hangul}'
+const SPACE_BEFORE_UNSPACED = new RegExp(`\\s+(?=[${UNSPACED_SCRIPT}])`, 'gu')
+const SPACE_AFTER_UNSPACED = new RegExp(`(?<=[${UNSPACED_SCRIPT}])\\s+`, 'gu')
+
+/**
+ * Folds the differences engines disagree on but readers do not: Unicode
+ * compatibility forms, runs of whitespace and line breaks, and the spaces
+ * some engines put between CJK characters.
+ */
+function normalizeText(text) {
+  return String(text || '')
+    .normalize('NFKC')
+    .replace(/\s+/gu, ' ')
+    .replace(SPACE_BEFORE_UNSPACED, '')
+    .replace(SPACE_AFTER_UNSPACED, '')
+    .trim()
+}
+
+// Edit distance over code points, two rows at a time.
+function levenshtein(left, right) {
+  const a = Array.from(left)
+  const b = Array.from(right)
+  if (a.length === 0)
+    return b.length
+  if (b.length === 0)
+    return a.length
+
+  let previous = Array.from({ length: b.length + 1 }, (_, index) => index)
+  let current = Array.from({ length: b.length + 1 }, () => 0)
+  for (let i = 1; i <= a.length; i += 1) {
+    current[0] = i
+    for (let j = 1; j <= b.length; j += 1) {
+      const substitution = previous[j - 1] + (a[i - 1] === b[j - 1] ? 0 : 1)
+      current[j] = Math.min(previous[j] + 1, current[j - 1] + 1, substitution)
+    }
+    ;[previous, current] = [current, previous]
+  }
+  return previous[b.length]
+}
+
+/**
+ * 1 - CER: one minus the edit distance between the normalized texts over the
+ * expected length, floored at 0.
+ */
+function characterAccuracy(expected, actual) {
+  const normalizedExpected = normalizeText(expected)
+  const normalizedActual = normalizeText(actual)
+  const expectedLength = Array.from(normalizedExpected).length
+  if (expectedLength === 0)
+    return normalizedActual.length === 0 ? 1 : 0
+  const distance = levenshtein(normalizedExpected, normalizedActual)
+  return Math.max(0, 1 - distance / expectedLength)
+}
+
+function percentile(sortedValues, percentileValue) {
+  if (sortedValues.length === 0)
+    return null
+  const index = Math.max(
+    0,
+    Math.ceil(percentileValue * sortedValues.length) - 1,
+  )
+  return sortedValues[Math.min(index, sortedValues.length - 1)]
+}
+
+/**
+ * Fixture results worse than their baseline: p50 or p95 slower by more than
+ * the latency tolerance (plus a millisecond), peak RSS above the RSS
+ * tolerance, or accuracy down by more than the accuracy tolerance (absolute).
+ * Skipped or failed fixtures are not compared; measured ones the baselines do
+ * not cover are listed in `missing`.
+ */
+function compareToBaseline(results, baselineFixtures, tolerances = DEFAULT_TOLERANCES) {
+  let compared = 0
+  const regressions = []
+  const missing = []
+  for (const result of results) {
+    if (result.skipped || result.error)
+      continue
+    const baseline = baselineFixtures ? baselineFixtures[result.id] : undefined
+    if (!baseline) {
+      missing.push(result.id)
+      continue
+    }
+    compared += 1
+
+    const check = (metric, value, limit, baselineValue) => {
+      if (typeof value === 'number' && typeof baselineValue === 'number' && value > limit)
+        regressions.push({ id: result.id, metric, value, baseline: baselineValue })
+    }
+    for (const metric of ['p50Ms', 'p95Ms']) {
+      const baselineValue = baseline[metric]
+      check(metric, result[metric], baselineValue * (1 + tolerances.latency) + LATENCY_SLACK_MS, baselineValue)
+    }
+    check('peakRssMb', result.peakRssMb, baseline.peakRssMb * (1 + tolerances.rss), baseline.peakRssMb)
+    if (typeof result.accuracy === 'number' && typeof baseline.accuracy === 'number'
+      && result.accuracy < baseline.accuracy - tolerances.accuracy) {
+      regressions.push({ id: result.id, metric: 'accuracy', value: result.accuracy, baseline: baseline.accuracy })
+    }
+  }
+  return { compared, regressions, missing }
+}
+
+function writeSummary(summary, outputPath) {
+  const serialized = `${JSON.stringify(summary, null, 2)}\n`
+  process.stdout.write(serialized)
+  if (!outputPath)
+    return
+  fs.mkdirSync(path.dirname(outputPath), { recursive: true })
+  fs.writeFileSync(outputPath, serialized, 'utf8')
+}
+
+// Runs one fixture in this process and prints its result as a JSON line. The
+// parent gives every fixture its own worker so peak RSS is per fixture.
+async function runWorker(fixtureId, iterations) {
+  const fixture = loadManifest().find(candidate => candidate.id === fixtureId)
+  if (!fixture)
+    throw new Error(`Unknown OCR corpus fixture: ${fixtureId}`)
+
+  const native = require(path.join(packageRoot, 'index.js'))
+  const support = native.getNativeOcrSupport()
+  if (!support || !support.supported) {
+    return { id: fixture.id, skipped: (support && support.reason) || 'unsupported' }
+  }
+
+  // Every iteration must reach the engine.
+  if (typeof native.configureOcrCache === 'function')
+    native.configureOcrCache({ maxBytes: 0 })
+
+  const options = { ...fixture.options, imagePath: fixture.imagePath }
+  const coldStartedAt = process.hrtime.bigint()
+  const first = await native.recognizeImageText(options)
+  const coldMs = Number(process.hrtime.bigint() - coldStartedAt) / 1e6
+
+  const durations = []
+  for (let i = 0; i < iterations; i += 1) {
+    const startedAt = process.hrtime.bigint()
+    await native.recognizeImageText(options)
+    durations.push(Number(process.hrtime.bigint() - startedAt) / 1e6)
+  }
+  durations.sort((left, right) => left - right)
+
+  const truth = fs.readFileSync(fixture.truthPath, 'utf8')
+  return {
+    id: fixture.id,
+    category: fixture.category,
+    engine: support.engine || null,
+    iterations,
+    coldMs,
+    p50Ms: percentile(durations, 0.5),
+    p95Ms: percentile(durations, 0.95),
+    // maxRSS is in kilobytes.
+    peakRssMb: process.resourceUsage().maxRSS / 1024,
+    accuracy: characterAccuracy(truth, first && first.text),
+  }
+}
+
+function runFixture(fixture, options) {
+  const child = spawnSync(
+    process.execPath,
+    [...process.execArgv, __filename, '--worker', fixture.id, '--iterations', String(options.iterations)],
+    { cwd: packageRoot, encoding: 'utf8', env: process.env, maxBuffer: 16 * 1024 * 1024 },
+  )
+  const lines = String(child.stdout || '').trim().split('\n')
+  try {
+    return JSON.parse(lines[lines.length - 1])
+  }
+  catch {
+    const stderr = String(child.stderr || '').trim()
+    return {
+      id: fixture.id,
+      category: fixture.category,
+      error: stderr || (child.error ? child.error.message : `worker exited with ${child.status}`),
+    }
+  }
+}
+
+function readBaselines(baselinesPath) {
+  if (!fs.existsSync(baselinesPath))
+    return null
+  return JSON.parse(fs.readFileSync(baselinesPath, 'utf8'))
+}
+
+function main() {
+  const options = parseArgs(process.argv.slice(2))
+  if (options.worker) {
+    runWorker(options.worker, options.iterations)
+      .then(result => process.stdout.write(`${JSON.stringify(result)}\n`))
+      .catch((error) => {
+        process.stdout.write(`${JSON.stringify({ id: options.worker, error: error instanceof Error ? error.message : String(error) })}\n`)
+      })
+    return
+  }
+
+  const fixtures = loadManifest().filter(fixture => fixture.id.includes(options.filter))
+  const results = fixtures.map(fixture => runFixture(fixture, options))
+  const failed = results.filter(result => result.error)
+  // A corpus run that measured nothing is not a pass.
+  const measured = results.filter(result => !result.error && !result.skipped)
+
+  const previous = readBaselines(options.baselinesPath)
+  const required = baselinesRequired(options.requireBaselines, previous && previous.fixtures)
+  const baseline = {
+    path: options.baselinesPath,
+    required,
+    tolerances: options.tolerances,
+    ...compareToBaseline(results, previous && previous.fixtures, options.tolerances),
+  }
+
+  if (options.updateBaselines && failed.length === 0) {
+    const fixturesById = { ...(previous && previous.fixtures) }
+    for (const result of results) {
+      if (result.skipped)
+        continue
+      fixturesById[result.id] = {
+        p50Ms: result.p50Ms,
+        p95Ms: result.p95Ms,
+        peakRssMb: result.peakRssMb,
+        accuracy: result.accuracy,
+      }
+    }
+    fs.mkdirSync(path.dirname(options.baselinesPath), { recursive: true })
+    fs.writeFileSync(
+      options.baselinesPath,
+      `${JSON.stringify({ version: 1, platform: process.platform, fixtures: fixturesById }, null, 2)}\n`,
+      'utf8',
+    )
+  }
+
+  // Unless required, a fixture without a baseline is only reported, so a new
+  // one can be measured before its baseline is checked in.
+  const ok = failed.length === 0
+    && measured.length > 0
+    && (options.updateBaselines || baseline.regressions.length === 0)
+    && (options.updateBaselines || !required || baseline.missing.length === 0)
+  writeSummary(
+    {
+      schema: 'tuff-ocr-corpus/v1',
+      ok,
+      platform: process.platform,
+      arch: process.arch,
+      node: process.versions.node,
+      iterations: options.iterations,
+      results,
+      baseline,
+      updatedBaselines: options.updateBaselines && failed.length === 0,
+      hint: measured.length === 0
+        ? 'No fixture ran; build the OCR addon with `pnpm -C packages/tuff-native build` on a host with an OCR engine.'
+        : baseline.missing.length > 0 && !options.updateBaselines
+          ? `No baseline for ${baseline.missing.join(', ')}; record one with --update-baselines on the CI host.`
+          : undefined,
+    },
+    options.outputPath,
+  )
+  if (!ok)
+    process.exitCode = 1
+}
+
+module.exports = {
+  DEFAULT_TOLERANCES,
+  characterAccuracy,
+  baselinesRequired,
+  compareToBaseline,
+  isCi,
+  levenshtein,
+  loadManifest,
+  normalizeText,
+  parseArgs,
+  percentile,
+  writeSummary,
+}
+
+if (require.main === module) {
+  main()
+}
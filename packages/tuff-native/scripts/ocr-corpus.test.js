@@ -0,0 +1,244 @@
+const assert = require('node:assert/strict')
+const { spawnSync } = require('node:child_process')
+const fs = require('node:fs')
+const os = require('node:os')
+const path = require('node:path')
+const test = require('node:test')
+
+const {
+  DEFAULT_TOLERANCES,
+  characterAccuracy,
+  baselinesRequired,
+  compareToBaseline,
+  isCi,
+  levenshtein,
+  loadManifest,
+  normalizeText,
+  parseArgs,
+} = require('./ocr-corpus.js')
+
+const packageRoot = path.resolve(__dirname, '..')
+
+test('parses iterations, tolerances and baselines and ignores bad numbers', () => {
+  const options = parseArgs([
+    '--iterations',
+    '5000',
+    '--filter',
+    'screenshot',
+    '--baselines',
+    'corpus/linux.json',
+    '--rss-tolerance',
+    'lots',
+    '--accuracy-tolerance',
+    '0.05',
+    '--update-baselines',
+  ])
+
+  assert.equal(options.iterations, 200)
+  assert.equal(options.filter, 'screenshot')
+  assert.equal(options.baselinesPath, path.resolve('corpus/linux.json'))
+  assert.equal(options.updateBaselines, true)
+  assert.equal(options.requireBaselines, null)
+  assert.equal(options.tolerances.rss, DEFAULT_TOLERANCES.rss)
+  assert.equal(options.tolerances.accuracy, 0.05)
+  assert.equal(options.worker, null)
+})
+
+test('requires baselines on CI once any is recorded unless told otherwise', () => {
+  assert.equal(isCi({ CI: 'true' }), true)
+  assert.equal(isCi({ CI: '1' }), true)
+  assert.equal(isCi({ CI: 'false' }), false)
+  assert.equal(isCi({}), false)
+
+  const recorded = { 'screenshot-settings': { p50Ms: 40, p95Ms: 80, peakRssMb: 100, accuracy: 0.97 } }
+  assert.equal(parseArgs([]).requireBaselines, null)
+  assert.equal(baselinesRequired(null, recorded, { CI: 'true' }), true)
+  assert.equal(baselinesRequired(null, {}, { CI: 'true' }), false)
+  assert.equal(baselinesRequired(null, undefined, { CI: 'true' }), false)
+  assert.equal(baselinesRequired(null, recorded, {}), false)
+
+  const noRequire = parseArgs(['--no-require-baselines']).requireBaselines
+  assert.equal(baselinesRequired(noRequire, recorded, { CI: 'true' }), false)
+  const requireFlag = parseArgs(['--require-baselines']).requireBaselines
+  assert.equal(baselinesRequired(requireFlag, {}, {}), true)
+})
+
+test('scores character accuracy on normalized text', () => {
+  assert.equal(normalizeText('  Build\n\n  passed\t(3 tests) '), 'Build passed (3 tests)')
+  assert.equal(normalizeText('上 下 中\n日 目'), '上下中日目')
+  assert.equal(normalizeText('ＡＢＣ１２'), 'ABC12')
+  assert.equal(levenshtein('kitten', 'sitting'), 3)
+  assert.equal(levenshtein('王工土', '王土'), 1)
+
+  assert.equal(characterAccuracy('Save changes', 'Save\nchanges'), 1)
+  assert.equal(characterAccuracy('上下中日', '上 下 中 目'), 0.75)
+  assert.equal(characterAccuracy('abcd', 'wxyz-long-garbage'), 0)
+  assert.equal(characterAccuracy('', ''), 1)
+})
+
+test('flags latency, memory and accuracy regressions beyond tolerance', () => {
+  const { compared, regressions, missing } = compareToBaseline(
+    [
+      { id: 'screenshot-settings', p50Ms: 40, p95Ms: 80, peakRssMb: 100, accuracy: 0.97 },
+      { id: 'code-dense', p50Ms: 30, p95Ms: 35, peakRssMb: 130, accuracy: 0.9 },
+      { id: 'cjk-ui-strokes', skipped: 'unsupported' },
+      { id: 'clipboard-photo', error: 'worker exited with 1' },
+      { id: 'screenshot-terminal', p50Ms: 1, p95Ms: 1, peakRssMb: 10, accuracy: 1 },
+    ],
+    {
+      'screenshot-settings': { p50Ms: 35, p95Ms: 50, peakRssMb: 95, accuracy: 0.98 },
+      'code-dense': { p50Ms: 30, p95Ms: 35, peakRssMb: 100, accuracy: 0.95 },
+      'cjk-ui-strokes': { p50Ms: 30, p95Ms: 35, peakRssMb: 100, accuracy: 0.95 },
+      'clipboard-photo': { p50Ms: 30, p95Ms: 35, peakRssMb: 100, accuracy: 0.95 },
+    },
+  )
+
+  assert.equal(compared, 2)
+  assert.deepEqual(missing, ['screenshot-terminal'])
+  assert.deepEqual(
+    regressions.map(regression => `${regression.id}:${regression.metric}`),
+    ['screenshot-settings:p95Ms', 'code-dense:peakRssMb', 'code-dense:accuracy'],
+  )
+})
+
+test('ships every fixture the manifest names, across all categories', () => {
+  const fixtures = loadManifest()
+  const ids = fixtures.map(fixture => fixture.id)
+
+  assert.equal(new Set(ids).size, ids.length)
+  assert.deepEqual(
+    [...new Set(fixtures.map(fixture => fixture.category))].sort(),
+    ['cjk', 'code', 'photo', 'screenshot'],
+  )
+  for (const fixture of fixtures) {
+    assert.ok(fs.readFileSync(fixture.imagePath).subarray(1, 4).equals(Buffer.from('PNG')), fixture.id)
+    assert.ok(normalizeText(fs.readFileSync(fixture.truthPath, 'utf8')).length > 0, fixture.id)
+  }
+})
+
+// Stands in for index.js so the script runs without the addon: every fixture
+// reads back its truth text, except code-dense which loses half of it.
+function writeFakeNative(directory) {
+  const preloadPath = path.join(directory, 'fake-native.js')
+  const indexPath = path.join(packageRoot, 'index.js')
+  const truthRoot = path.join(packageRoot, 'fixtures', 'ocr-corpus-v1', 'truth')
+
+  fs.writeFileSync(
+    preloadPath,
+    `const fs = require('node:fs')
+const path = require('node:path')
+const Module = require('node:module')
+const originalLoad = Module._load
+const indexPath = ${JSON.stringify(indexPath)}
+const truthRoot = ${JSON.stringify(truthRoot)}
+Module._load = function (request, parent, isMain) {
+  if (request === indexPath) {
+    return {
+      getNativeOcrSupport: () => ({ supported: true, platform: process.platform, engine: 'fake' }),
+      configureOcrCache: () => ({}),
+      recognizeImageText: async ({ imagePath }) => {
+        const id = path.basename(imagePath, '.png')
+        const truth = fs.readFileSync(path.join(truthRoot, id + '.txt'), 'utf8')
+        return { text: id === 'code-dense' ? truth.slice(0, truth.length / 2) : truth }
+      },
+    }
+  }
+  return originalLoad.apply(this, arguments)
+}
+`,
+    'utf8',
+  )
+
+  return preloadPath
+}
+
+function runCorpus(preloadPath, args, env = process.env) {
+  return spawnSync(
+    process.execPath,
+    ['--require', preloadPath, 'scripts/ocr-corpus.js', '--iterations', '3', ...args],
+    { cwd: packageRoot, encoding: 'utf8', env },
+  )
+}
+
+test('runs each fixture through the addon and records new baselines', () => {
+  const directory = fs.mkdtempSync(path.join(os.tmpdir(), 'ocr-corpus-test-'))
+  const preloadPath = writeFakeNative(directory)
+  const baselinesPath = path.join(directory, 'baselines', 'linux.json')
+  const outputPath = path.join(directory, 'run.json')
+  const run = extraArgs => runCorpus(
+    preloadPath,
+    ['--baselines', baselinesPath, '--output', outputPath, ...extraArgs],
+  )
+
+  try {
+    const update = run(['--update-baselines'])
+    const summary = JSON.parse(fs.readFileSync(outputPath, 'utf8'))
+    const baselines = JSON.parse(fs.readFileSync(baselinesPath, 'utf8'))
+    const byId = Object.fromEntries(summary.results.map(result => [result.id, result]))
+
+    assert.equal(update.status, 0, update.stderr)
+    assert.deepEqual(JSON.parse(update.stdout), summary)
+    assert.equal(summary.schema, 'tuff-ocr-corpus/v1')
+    assert.equal(summary.ok, true)
+    assert.equal(summary.updatedBaselines, true)
+    assert.equal(summary.results.length, loadManifest().length)
+    assert.equal(byId['screenshot-settings'].engine, 'fake')
+    assert.equal(byId['screenshot-settings'].iterations, 3)
+    assert.equal(byId['screenshot-settings'].accuracy, 1)
+    assert.ok(byId['code-dense'].accuracy < 0.6)
+    assert.ok(byId['clipboard-photo'].peakRssMb > 0)
+    assert.ok(byId['clipboard-photo'].p95Ms >= byId['clipboard-photo'].p50Ms)
+    assert.deepEqual(Object.keys(baselines.fixtures).sort(), Object.keys(byId).sort())
+
+    baselines.fixtures['cjk-ui-strokes'].accuracy = 1.5
+    fs.writeFileSync(baselinesPath, JSON.stringify(baselines), 'utf8')
+    const check = run([])
+    const checked = JSON.parse(check.stdout)
+
+    assert.equal(check.status, 1)
+    assert.equal(checked.ok, false)
+    assert.deepEqual(checked.baseline.regressions.map(regression => regression.id), ['cjk-ui-strokes'])
+  }
+  finally {
+    fs.rmSync(directory, { recursive: true, force: true })
+  }
+})
+
+test('fails on fixtures without a baseline when baselines are required', () => {
+  const directory = fs.mkdtempSync(path.join(os.tmpdir(), 'ocr-corpus-test-'))
+  const preloadPath = writeFakeNative(directory)
+  const baselinesPath = path.join(directory, 'linux.json')
+  const writeBaselines = fixtures =>
+    fs.writeFileSync(baselinesPath, JSON.stringify({ version: 1, platform: 'linux', fixtures }), 'utf8')
+  const env = { ...process.env, CI: '' }
+  const others = loadManifest().map(fixture => fixture.id).filter(id => id !== 'screenshot-settings').sort()
+
+  try {
+    writeBaselines({})
+    const local = runCorpus(preloadPath, ['--baselines', baselinesPath], env)
+    assert.equal(local.status, 0, local.stderr)
+    assert.equal(JSON.parse(local.stdout).baseline.missing.length, loadManifest().length)
+
+    // Nothing recorded yet: CI reports the gap but is not gated on it.
+    const unrecorded = runCorpus(preloadPath, ['--baselines', baselinesPath], { ...env, CI: 'true' })
+    const reported = JSON.parse(unrecorded.stdout)
+    assert.equal(unrecorded.status, 0, unrecorded.stderr)
+    assert.equal(reported.baseline.required, false)
+    assert.match(reported.hint, /--update-baselines/)
+
+    writeBaselines({ 'screenshot-settings': { p50Ms: 1e6, p95Ms: 1e6, peakRssMb: 1e6, accuracy: 0 } })
+    const ci = runCorpus(preloadPath, ['--baselines', baselinesPath], { ...env, CI: 'true' })
+    const summary = JSON.parse(ci.stdout)
+
+    assert.equal(ci.status, 1)
+    assert.equal(summary.ok, false)
+    assert.equal(summary.baseline.required, true)
+    assert.equal(summary.baseline.compared, 1)
+    assert.deepEqual(summary.baseline.regressions, [])
+    assert.deepEqual(summary.baseline.missing.sort(), others)
+    assert.match(summary.hint, /--update-baselines/)
+  }
+  finally {
+    fs.rmSync(directory, { recursive: true, force: true })
+  }
+})
@@ -316,7 +316,7 @@ export interface IntelligenceVisionOcrResult {
   /** Structured text blocks. */
   blocks?: IntelligenceVisionOcrBlock[];
   /** OCR engine identifier. */
-  engine?: "apple-vision" | "windows-ocr" | "cloud";
+  engine?: "apple-vision" | "windows-ocr" | "tesseract" | "cloud";
   /** OCR execution latency in milliseconds. */
   durationMs?: number;
   /** Raw provider response. */